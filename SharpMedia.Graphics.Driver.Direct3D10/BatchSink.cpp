@@ -0,0 +1,410 @@
+#include "BatchSink.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Layout of pipeline state words.
+	enum
+	{
+		PipelineLayout,
+		PipelineTopology,
+		PipelineVertexShader,
+		PipelineGeometryShader,
+		PipelinePixelShader,
+		PipelineBlend,
+		PipelineBlendFactor,
+		PipelineSampleMask = PipelineBlendFactor + 4,
+		PipelineDepthStencil,
+		PipelineStencilRef,
+		PipelineRasterizer,
+		PipelineWords
+	};
+
+	// Material state is, for vertex, geometry and pixel stage, count and interfaces of samplers,
+	// textures and constant buffers. Buffers state is index buffer, format and offset, then count
+	// and (buffer, stride, offset) of vertex buffers.
+	static const unsigned int StageCount = 3;
+	static const unsigned int SlotCounts[3] =
+	{
+		D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT,
+		D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT,
+		D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT
+	};
+
+	static void Release(UINT_PTR word)
+	{
+		if(word) ((IUnknown*)word)->Release();
+	}
+
+	static void ReleaseState(D3D10BatchSink::StateGroup group, const D3D10BatchSink::State& state)
+	{
+		switch(group)
+		{
+		case D3D10BatchSink::PipelineGroup:
+			Release(state[PipelineLayout]);
+			Release(state[PipelineVertexShader]);
+			Release(state[PipelineGeometryShader]);
+			Release(state[PipelinePixelShader]);
+			Release(state[PipelineBlend]);
+			Release(state[PipelineDepthStencil]);
+			Release(state[PipelineRasterizer]);
+			break;
+		case D3D10BatchSink::MaterialGroup:
+			for(size_t i = 0; i < state.size();)
+			{
+				size_t count = state[i++];
+				for(size_t j = 0; j < count; j++) Release(state[i++]);
+			}
+			break;
+		case D3D10BatchSink::BuffersGroup:
+			Release(state[0]);
+			for(size_t i = 4; i < state.size(); i += 3) Release(state[i]);
+			break;
+		}
+	}
+
+	// Adds textures and buffers a state reads; views are not held, their resources outlive them.
+	static void AddResources(D3D10BatchSink::StateGroup group, const D3D10BatchSink::State& state,
+		DeferredResources& resources)
+	{
+		switch(group)
+		{
+		case D3D10BatchSink::MaterialGroup:
+			for(size_t i = 0, kind = 0; i < state.size(); kind = (kind + 1) % 3)
+			{
+				size_t count = state[i++];
+				for(size_t j = 0; j < count; j++, i++)
+				{
+					if(!state[i] || kind == 0) continue;
+					if(kind == 2)
+					{
+						resources.Add((ID3D10Resource*)(ID3D10Buffer*)state[i]);
+						continue;
+					}
+
+					ID3D10Resource* resource;
+					((ID3D10ShaderResourceView*)state[i])->GetResource(&resource);
+					resources.Add(resource);
+					resource->Release();
+				}
+			}
+			break;
+		case D3D10BatchSink::BuffersGroup:
+			resources.Add((ID3D10Resource*)(ID3D10Buffer*)state[0]);
+			for(size_t i = 4; i < state.size(); i += 3) resources.Add((ID3D10Resource*)(ID3D10Buffer*)state[i]);
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Appends count and interfaces up to last bound one; references of unbound tail are none.
+	template<typename T>
+	static void AppendSlots(D3D10BatchSink::State& state, T** slots, unsigned int count)
+	{
+		while(count > 0 && !slots[count - 1]) count--;
+		state.push_back(count);
+		for(unsigned int i = 0; i < count; i++) state.push_back((UINT_PTR)slots[i]);
+	}
+
+	D3D10BatchSink::D3D10BatchSink(ID3D10Device* device)
+	{
+		this->device = device;
+		this->instanceBuffer = 0;
+		this->capacity = 0;
+		this->slot = 0;
+		this->stride = 0;
+		this->instancesBound = false;
+		for(unsigned int i = 0; i < StageCount * 3; i++) boundSlots[i] = SlotCounts[i % 3];
+		device->AddRef();
+	}
+
+	D3D10BatchSink::~D3D10BatchSink()
+	{
+		Reset();
+		if(instanceBuffer) instanceBuffer->Release();
+		device->Release();
+	}
+
+	unsigned int D3D10BatchSink::Intern(StateGroup group, State& state)
+	{
+		std::map<State, unsigned int>::iterator i = ids[group].find(state);
+		if(i != ids[group].end())
+		{
+			ReleaseState(group, state);
+			return i->second;
+		}
+
+		unsigned int id = (unsigned int)states[group].size();
+		AddResources(group, state, resources);
+		states[group].push_back(state);
+		ids[group][state] = id;
+		return id;
+	}
+
+	unsigned int D3D10BatchSink::CapturePipeline()
+	{
+		State state(PipelineWords);
+
+		ID3D10InputLayout* layout;
+		D3D10_PRIMITIVE_TOPOLOGY topology;
+		device->IAGetInputLayout(&layout);
+		device->IAGetPrimitiveTopology(&topology);
+		state[PipelineLayout] = (UINT_PTR)layout;
+		state[PipelineTopology] = topology;
+
+		ID3D10VertexShader* vs;
+		ID3D10GeometryShader* gs;
+		ID3D10PixelShader* ps;
+		device->VSGetShader(&vs);
+		device->GSGetShader(&gs);
+		device->PSGetShader(&ps);
+		state[PipelineVertexShader] = (UINT_PTR)vs;
+		state[PipelineGeometryShader] = (UINT_PTR)gs;
+		state[PipelinePixelShader] = (UINT_PTR)ps;
+
+		ID3D10BlendState* blend;
+		FLOAT factor[4];
+		UINT mask;
+		device->OMGetBlendState(&blend, factor, &mask);
+		state[PipelineBlend] = (UINT_PTR)blend;
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			UINT bits;
+			memcpy(&bits, &factor[i], sizeof(bits));
+			state[PipelineBlendFactor + i] = bits;
+		}
+		state[PipelineSampleMask] = mask;
+
+		ID3D10DepthStencilState* depthStencil;
+		UINT stencilRef;
+		device->OMGetDepthStencilState(&depthStencil, &stencilRef);
+		state[PipelineDepthStencil] = (UINT_PTR)depthStencil;
+		state[PipelineStencilRef] = stencilRef;
+
+		ID3D10RasterizerState* rasterizer;
+		device->RSGetState(&rasterizer);
+		state[PipelineRasterizer] = (UINT_PTR)rasterizer;
+
+		return Intern(PipelineGroup, state);
+	}
+
+	unsigned int D3D10BatchSink::CaptureMaterial()
+	{
+		State state;
+		ID3D10SamplerState* samplers[D3D10_COMMONSHADER_SAMPLER_SLOT_COUNT];
+		ID3D10ShaderResourceView* textures[D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+		ID3D10Buffer* constants[D3D10_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT];
+
+		device->VSGetSamplers(0, SlotCounts[0], samplers);
+		device->VSGetShaderResources(0, SlotCounts[1], textures);
+		device->VSGetConstantBuffers(0, SlotCounts[2], constants);
+		AppendSlots(state, samplers, SlotCounts[0]);
+		AppendSlots(state, textures, SlotCounts[1]);
+		AppendSlots(state, constants, SlotCounts[2]);
+
+		device->GSGetSamplers(0, SlotCounts[0], samplers);
+		device->GSGetShaderResources(0, SlotCounts[1], textures);
+		device->GSGetConstantBuffers(0, SlotCounts[2], constants);
+		AppendSlots(state, samplers, SlotCounts[0]);
+		AppendSlots(state, textures, SlotCounts[1]);
+		AppendSlots(state, constants, SlotCounts[2]);
+
+		device->PSGetSamplers(0, SlotCounts[0], samplers);
+		device->PSGetShaderResources(0, SlotCounts[1], textures);
+		device->PSGetConstantBuffers(0, SlotCounts[2], constants);
+		AppendSlots(state, samplers, SlotCounts[0]);
+		AppendSlots(state, textures, SlotCounts[1]);
+		AppendSlots(state, constants, SlotCounts[2]);
+
+		// Captured state is what device has bound.
+		for(size_t i = 0, w = 0; i < StageCount * 3; i++)
+		{
+			boundSlots[i] = (unsigned int)state[w];
+			w += state[w] + 1;
+		}
+
+		return Intern(MaterialGroup, state);
+	}
+
+	unsigned int D3D10BatchSink::CaptureBuffers()
+	{
+		State state;
+
+		ID3D10Buffer* indices;
+		DXGI_FORMAT format;
+		UINT offset;
+		device->IAGetIndexBuffer(&indices, &format, &offset);
+		state.push_back((UINT_PTR)indices);
+		state.push_back(format);
+		state.push_back(offset);
+
+		ID3D10Buffer* vertices[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		UINT strides[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		UINT offsets[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		device->IAGetVertexBuffers(0, D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, vertices, strides, offsets);
+
+		unsigned int count = D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT;
+		while(count > 0 && !vertices[count - 1]) count--;
+		state.push_back(count);
+		for(unsigned int i = 0; i < count; i++)
+		{
+			state.push_back((UINT_PTR)vertices[i]);
+			state.push_back(vertices[i] ? strides[i] : 0);
+			state.push_back(vertices[i] ? offsets[i] : 0);
+		}
+
+		return Intern(BuffersGroup, state);
+	}
+
+	void D3D10BatchSink::Reset()
+	{
+		for(unsigned int group = 0; group < GroupCount; group++)
+		{
+			for(size_t i = 0; i < states[group].size(); i++)
+			{
+				ReleaseState((StateGroup)group, states[group][i]);
+			}
+			states[group].clear();
+			ids[group].clear();
+		}
+		resources.Clear();
+		instancesBound = false;
+	}
+
+	void D3D10BatchSink::SetPipeline(unsigned int pipeline)
+	{
+		const State& state = states[PipelineGroup][pipeline];
+
+		FLOAT factor[4];
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			UINT bits = (UINT)state[PipelineBlendFactor + i];
+			memcpy(&factor[i], &bits, sizeof(bits));
+		}
+
+		device->IASetInputLayout((ID3D10InputLayout*)state[PipelineLayout]);
+		device->IASetPrimitiveTopology((D3D10_PRIMITIVE_TOPOLOGY)state[PipelineTopology]);
+		device->VSSetShader((ID3D10VertexShader*)state[PipelineVertexShader]);
+		device->GSSetShader((ID3D10GeometryShader*)state[PipelineGeometryShader]);
+		device->PSSetShader((ID3D10PixelShader*)state[PipelinePixelShader]);
+		device->OMSetBlendState((ID3D10BlendState*)state[PipelineBlend], factor, (UINT)state[PipelineSampleMask]);
+		device->OMSetDepthStencilState((ID3D10DepthStencilState*)state[PipelineDepthStencil], (UINT)state[PipelineStencilRef]);
+		device->RSSetState((ID3D10RasterizerState*)state[PipelineRasterizer]);
+	}
+
+	void D3D10BatchSink::SetMaterial(unsigned int material)
+	{
+		const State& state = states[MaterialGroup][material];
+
+		// Only captured slots and those left bound by another material are set.
+		void* slots[D3D10_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+		size_t w = 0;
+		for(unsigned int group = 0; group < StageCount * 3; group++)
+		{
+			unsigned int count = (unsigned int)state[w++];
+			unsigned int range = count > boundSlots[group] ? count : boundSlots[group];
+			for(unsigned int i = 0; i < range; i++)
+			{
+				slots[i] = i < count ? (void*)state[w + i] : 0;
+			}
+			w += count;
+			boundSlots[group] = count;
+			if(range == 0) continue;
+
+			switch(group)
+			{
+			case 0: device->VSSetSamplers(0, range, (ID3D10SamplerState**)slots); break;
+			case 1: device->VSSetShaderResources(0, range, (ID3D10ShaderResourceView**)slots); break;
+			case 2: device->VSSetConstantBuffers(0, range, (ID3D10Buffer**)slots); break;
+			case 3: device->GSSetSamplers(0, range, (ID3D10SamplerState**)slots); break;
+			case 4: device->GSSetShaderResources(0, range, (ID3D10ShaderResourceView**)slots); break;
+			case 5: device->GSSetConstantBuffers(0, range, (ID3D10Buffer**)slots); break;
+			case 6: device->PSSetSamplers(0, range, (ID3D10SamplerState**)slots); break;
+			case 7: device->PSSetShaderResources(0, range, (ID3D10ShaderResourceView**)slots); break;
+			case 8: device->PSSetConstantBuffers(0, range, (ID3D10Buffer**)slots); break;
+			}
+		}
+	}
+
+	void D3D10BatchSink::SetBuffers(unsigned int buffers)
+	{
+		const State& state = states[BuffersGroup][buffers];
+
+		device->IASetIndexBuffer((ID3D10Buffer*)state[0], (DXGI_FORMAT)state[1], (UINT)state[2]);
+
+		ID3D10Buffer* vertices[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		UINT strides[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		UINT offsets[D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+		size_t count = state[3];
+		for(unsigned int i = 0; i < D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; i++)
+		{
+			vertices[i] = i < count ? (ID3D10Buffer*)state[4 + i * 3] : 0;
+			strides[i] = i < count ? (UINT)state[5 + i * 3] : 0;
+			offsets[i] = i < count ? (UINT)state[6 + i * 3] : 0;
+		}
+		if(instancesBound && slot < D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT)
+		{
+			vertices[slot] = instanceBuffer;
+			strides[slot] = stride;
+			offsets[slot] = 0;
+		}
+		device->IASetVertexBuffers(0, D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT, vertices, strides, offsets);
+	}
+
+	bool D3D10BatchSink::UploadInstances(const void* data, unsigned int count, unsigned int stride)
+	{
+		this->stride = stride;
+		instancesBound = false;
+
+		unsigned int size = count * stride;
+		if(size == 0) return true;
+
+		// Buffer grows to the largest frame, so it is rarely recreated.
+		if(size > capacity)
+		{
+			if(instanceBuffer) instanceBuffer->Release();
+			instanceBuffer = 0;
+			capacity = 0;
+
+			unsigned int newCapacity = 4096;
+			while(newCapacity < size) newCapacity *= 2;
+
+			D3D10_BUFFER_DESC desc;
+			desc.ByteWidth = newCapacity;
+			desc.Usage = D3D10_USAGE_DYNAMIC;
+			desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
+			desc.CPUAccessFlags = D3D10_CPU_ACCESS_WRITE;
+			desc.MiscFlags = 0;
+			if(FAILED(device->CreateBuffer(&desc, 0, &instanceBuffer)))
+			{
+				instanceBuffer = 0;
+				return false;
+			}
+			capacity = newCapacity;
+		}
+
+		void* mapped = 0;
+		if(FAILED(instanceBuffer->Map(D3D10_MAP_WRITE_DISCARD, 0, &mapped))) return false;
+		memcpy(mapped, data, size);
+		instanceBuffer->Unmap();
+
+		UINT offset = 0;
+		device->IASetVertexBuffers(slot, 1, &instanceBuffer, &this->stride, &offset);
+		instancesBound = true;
+		return true;
+	}
+
+	void D3D10BatchSink::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+		unsigned int startIndex, int baseVertex, unsigned int startInstance)
+	{
+		device->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	}
+
+}
+}
+}
+}
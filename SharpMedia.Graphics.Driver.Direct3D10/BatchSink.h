@@ -0,0 +1,76 @@
+#pragma once
+#include <windows.h>
+#include <D3D10.h>
+#include <map>
+#include <vector>
+#include "DrawBatcher.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// A draw sink that submits batches to D3D10. Pipeline, material and buffer ids refer to device
+	// states captured by Capture*; per-instance data is written to a dynamic vertex buffer bound
+	// at the instance slot.
+	class D3D10BatchSink : public DrawSink
+	{
+	public:
+		// Captured state is a list of words; interfaces in it hold a reference.
+		typedef std::vector<UINT_PTR> State;
+
+		enum StateGroup
+		{
+			PipelineGroup,		//< Input layout, topology, shaders, blend, depth stencil and rasterizer.
+			MaterialGroup,		//< Samplers, textures and constant buffers of all stages.
+			BuffersGroup,		//< Index and vertex buffers.
+			GroupCount
+		};
+	private:
+		ID3D10Device* device;
+		ID3D10Buffer* instanceBuffer;
+		unsigned int capacity;		//< Instance buffer size in bytes.
+		unsigned int slot;
+		unsigned int stride;
+		bool instancesBound;		//< Instance buffer is bound at slot, buffer restores rebind it.
+		unsigned int boundSlots[9];	//< Material slots bound on device per stage and kind.
+
+		std::vector<State> states[GroupCount];
+		std::map<State, unsigned int> ids[GroupCount];
+		DeferredResources resources;	//< Resources of captured states.
+
+		unsigned int Intern(StateGroup group, State& state);
+		void Apply(StateGroup group, unsigned int id);
+	public:
+		D3D10BatchSink(ID3D10Device* device);
+		virtual ~D3D10BatchSink();
+
+		// Returns id of current device state of group; equal states share an id.
+		unsigned int CapturePipeline();
+		unsigned int CaptureMaterial();
+		unsigned int CaptureBuffers();
+
+		// Slot instance data is bound to.
+		void SetInstanceSlot(unsigned int slot) { this->slot = slot; }
+
+		// Unbinds instance data from buffer restores, further SetBuffers restore captured buffers exactly.
+		void EndInstances() { instancesBound = false; }
+
+		// Releases captured states, ids are no longer valid.
+		void Reset();
+
+		// Whether a captured state reads resource.
+		bool References(ID3D10Resource* resource) { return resources.Contains(resource); }
+
+		virtual void SetPipeline(unsigned int pipeline);
+		virtual void SetMaterial(unsigned int material);
+		virtual void SetBuffers(unsigned int buffers);
+		virtual bool UploadInstances(const void* data, unsigned int count, unsigned int stride);
+		virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+			unsigned int startIndex, int baseVertex, unsigned int startInstance);
+	};
+
+}
+}
+}
+}
@@ -1,5 +1,7 @@
 #include "Buffer.h"
+#include "DeviceView.h"
 #include "Helper.h"
+#include "Trace.h"
 
 namespace SharpMedia {
 namespace Graphics {
@@ -39,8 +41,13 @@ namespace Direct3D10 {
 
 	void D3D10Buffer::Update(array<Byte>^ data, UInt64 offset, UInt64 count)
 	{
+		D3D10_TRACE_SCOPE("D3D10Buffer::Update");
+		D3D10_TRACE_COUNT("D3D10Buffer::Update calls");
 		Byte* ptr;
 
+		// Deferred draws read contents from before the update.
+		if(view) view->FlushReferencing(buffer);
+
 		// We update the buffer.
 		DXFAILED(buffer->Map(D3D10_MAP_WRITE_DISCARD, 0, (void**)&ptr))
 
@@ -72,6 +79,11 @@ namespace Direct3D10 {
 		device->IASetVertexBuffers(index, 1, &buf, &str, &off);
 	}
 
+	ID3D10Buffer* D3D10VBuffer::GetBuffer()
+	{
+		return buffer->buffer;
+	}
+
 	D3D10VBuffer::D3D10VBuffer(D3D10Buffer^ buffer, unsigned int stride, UInt64 offset)
 	{
 		this->buffer = buffer;
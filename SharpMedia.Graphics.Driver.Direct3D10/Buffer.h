@@ -11,10 +11,13 @@ namespace Driver {
 namespace Direct3D10 {
 
 
+	ref class D3D10DeviceView;
+
 	public ref class D3D10Buffer : public IBuffer
 	{
 	public:
 		ID3D10Buffer* buffer;
+		D3D10DeviceView^ view;		//< Device whose deferred draws are flushed before mapping, may be null.
 	
 		
 		// View creations:
@@ -40,6 +43,8 @@ namespace Direct3D10 {
 		UInt64 offset;
 	public:
 		void Apply(ID3D10Device* device, unsigned int index);
+		ID3D10Buffer* GetBuffer();
+		unsigned int GetOffset() { return (unsigned int)offset; }
 		D3D10VBuffer(D3D10Buffer^ buffer, unsigned int stride, UInt64 offset);
 		virtual ~D3D10VBuffer();
 	};
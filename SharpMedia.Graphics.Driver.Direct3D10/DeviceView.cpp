@@ -12,6 +12,11 @@
 #include "Buffer.h"
 #include "GraphicsService.h"
 #include "Texture2d.h"
+#include "Trace.h"
+#include "DrawQueue.h"
+#include "QueryBackend.h"
+#include "OcclusionDevice.h"
+#include <sstream>
 
 using namespace System::Collections::Generic;
 
@@ -32,6 +37,42 @@ namespace Direct3D10 {
 			multithread = mt;
 
 			this->sharedTextures = gcnew Collections::Generic::SortedDictionary<Guid, SharedTextureInfo^>();
+			this->shaderCache = new D3D10ShaderCache();
+			this->drawQueue = new D3D10DrawQueue(device);
+			this->streamOutput = false;
+			this->queryBackend = 0;
+			this->profiler = 0;
+			this->nextProfileFrame = 0;
+			this->occlusionDevice = 0;
+			this->occlusion = 0;
+
+#ifdef _DEBUG
+			this->validateBindings = true;
+			this->shaderProfile = Shaders::ShaderCompileProfile::Debug;
+#else
+			this->validateBindings = false;
+			this->shaderProfile = Shaders::ShaderCompileProfile::Shipping;
+#endif
+		}
+
+		bool D3D10DeviceView::ValidateBindings::get()
+		{
+			return validateBindings;
+		}
+
+		void D3D10DeviceView::ValidateBindings::set(bool value)
+		{
+			validateBindings = value;
+		}
+
+		Shaders::ShaderCompileProfile D3D10DeviceView::ShaderProfile::get()
+		{
+			return shaderProfile;
+		}
+
+		void D3D10DeviceView::ShaderProfile::set(Shaders::ShaderCompileProfile value)
+		{
+			shaderProfile = value;
 		}
 
 		SharedTextureInfo^ D3D10DeviceView::GetShared(Guid guid)
@@ -113,6 +154,7 @@ namespace Direct3D10 {
 
 		IBlendState^ D3D10DeviceView::CreateState(States::BlendState^ desc)
 		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::CreateState(Blend)");
 			D3D10_BLEND_DESC d;
 			d.AlphaToCoverageEnable = desc->AlphaToCoverage;
 			for(int i = 0; i < 8; i++)
@@ -137,6 +179,7 @@ namespace Direct3D10 {
 
 		IRasterizationState^ D3D10DeviceView::CreateState(States::RasterizationState^ desc)
 		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::CreateState(Rasterization)");
 			D3D10_RASTERIZER_DESC d;
 			d.FillMode = ToDXMode(desc->FillMode);
 			d.CullMode = ToDXMode(desc->CullMode);
@@ -157,6 +200,7 @@ namespace Direct3D10 {
 
 		IDepthStencilState^ D3D10DeviceView::CreateState(States::DepthStencilState^ desc)
 		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::CreateState(DepthStencil)");
 			D3D10_DEPTH_STENCIL_DESC d;
 			d.FrontFace.StencilDepthFailOp = ToDXOperation(desc->FrontDepthFail);
 			d.FrontFace.StencilFailOp = ToDXOperation(desc->FrontStencilFail);
@@ -183,6 +227,7 @@ namespace Direct3D10 {
 		
 		ISamplerState^ D3D10DeviceView::CreateState(States::SamplerState^ desc)
 		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::CreateState(Sampler)");
 			D3D10_SAMPLER_DESC d;
 			d.AddressU = ToDXAddress(desc->AddressU);
 			d.AddressV = ToDXAddress(desc->AddressV);
@@ -204,7 +249,8 @@ namespace Direct3D10 {
 			return gcnew D3D10SamplerState(state);
 		}
 
-        IVerticesBindingLayout^ D3D10DeviceView::CreateVertexBinding(array<VertexBindingElement>^ desc)
+        IVerticesBindingLayout^ D3D10DeviceView::CreateInputLayout(ID3D10Device* device, 
+			array<VertexBindingElement>^ desc, ID3D10Blob* signature)
 		{
 			// TODO: Add support for matrices.
 
@@ -218,9 +264,6 @@ namespace Direct3D10 {
 
 			D3D10_INPUT_ELEMENT_DESC* layout = 0;
 			try {
-				SortedList<PinComponent, VertexFormat::Element^>^ sortedElements
-					= gcnew SortedList<PinComponent, VertexFormat::Element^>(length);
-
 				layout = new D3D10_INPUT_ELEMENT_DESC[length];
 				int i = 0;
 				for(int j = 0; j < desc->Length; j++)
@@ -241,55 +284,183 @@ namespace Direct3D10 {
 						d3ddesc.InputSlotClass = desc[j].UpdateFrequency == UpdateFrequency::PerVertex ?
 								D3D10_INPUT_PER_VERTEX_DATA : D3D10_INPUT_PER_INSTANCE_DATA;
 						d3ddesc.InstanceDataStepRate = desc[j].UpdateFrequency == UpdateFrequency::PerVertex ? 0 : desc[j].UpdateFrequencyCount;
-
-						// Add to map.
-						sortedElements->Add(element->Component, element);
 					}
 				
 				}
 
-				// We have the layout, we can create shader (actually a dummy shader) with it. We always
-				// sort parameters by component value (shader generator garantie).
-				D3D10ShaderCompiler^ compiler = (D3D10ShaderCompiler^)CreateShaderCompiler();
-				compiler->Begin(BindingStage::VertexShader);
+				// We can now create layout.
+				ID3D10InputLayout* verticesLayout = NULL;
+				DXFAILED(device->CreateInputLayout(layout, length, signature->GetBufferPointer(),
+					signature->GetBufferSize(), &verticesLayout));
+
+				return gcnew D3D10VerticesBindingLayout(verticesLayout);
+			} finally {
+				delete [] layout;
+			}
+		}
+
+        IVerticesBindingLayout^ D3D10DeviceView::CreateVertexBinding(array<VertexBindingElement>^ desc)
+		{
+			SortedList<PinComponent, VertexFormat::Element^>^ sortedElements
+				= gcnew SortedList<PinComponent, VertexFormat::Element^>();
 
-				for(int d = 0;d < sortedElements->Count; d++)
+			for(int j = 0; j < desc->Length; j++)
+			{
+				VertexFormat^ format = desc[j].Format;
+				for(unsigned int k = 0; k < format->ElementCount; k++)
 				{
-					VertexFormat::Element^ input = sortedElements->Values[d];
-					compiler->RegisterInput(d, input->Format, input->Component);
+					VertexFormat::Element^ element = format[k];
+					sortedElements->Add(element->Component, element);
 				}
+			}
+
+			// We have the layout, we can create shader (actually a dummy shader) with it. We always
+			// sort parameters by component value (shader generator garantie).
+			D3D10ShaderCompiler^ compiler = (D3D10ShaderCompiler^)CreateShaderCompiler();
+			compiler->Begin(BindingStage::VertexShader);
+
+			for(int d = 0;d < sortedElements->Count; d++)
+			{
+				VertexFormat::Element^ input = sortedElements->Values[d];
+				compiler->RegisterInput(d, input->Format, input->Component);
+			}
+
+			// We end shader compiled to bytecodes.
+			ID3D10Blob* blob = 0;
+			
+			try {
+				D3D10ShaderManifest manifest;
+				blob = compiler->EndBytecode(manifest);
 
-				// We end shader compiled to bytecodes.
-				ID3D10Blob* blob = 0;
+				return CreateInputLayout(device, desc, blob);
+			} finally
+			{
+				if(blob) blob->Release();
 				
-				try {
-					blob = compiler->EndBytecode();
+				// We dispose compiler.
+				delete compiler;
+			}
+		}
+
+        IVerticesOutBindingLayout^ D3D10DeviceView::CreateVertexOutBinding(array<VertexBindingElement>^ desc)
+		{
+			if(desc->Length > D3D10_SO_BUFFER_SLOT_COUNT)
+			{
+				throw gcnew ArgumentException("Too many stream output buffers.");
+			}
+
+			// Count number of elements.
+			unsigned int length = 0;
+			for(int j = 0; j < desc->Length; j++)
+			{
+				VertexFormat^ format = desc[j].Format;
+
+				// With more buffers, each output slot holds exactly one element.
+				if(desc->Length > 1 && format->ElementCount != 1)
+				{
+					throw gcnew ArgumentException("Each stream output buffer must hold one element "
+						"when more than one buffer is bound.");
+				}
+
+				for(unsigned int k = 0; k < format->ElementCount; k++)
+				{
+					if(!IsStreamOutputFormat(format[k]->Format))
+					{
+						throw gcnew ArgumentException("Stream output elements must have 32-bit components, "
+							+ format[k]->Format.ToString() + " is not supported.");
+					}
+				}
 
-					// We can now create layout.
-					ID3D10InputLayout* verticesLayout = NULL;
-					DXFAILED(device->CreateInputLayout(layout, length, blob->GetBufferPointer(),
-						blob->GetBufferSize(), &verticesLayout));
+				length += format->ElementCount;
+			}
 
-					return gcnew D3D10VerticesBindingLayout(verticesLayout);
-				} finally
+			D3D10_SO_DECLARATION_ENTRY* entries = new D3D10_SO_DECLARATION_ENTRY[length];
+			unsigned int stride = 0;
+			try {
+				unsigned int i = 0;
+				for(int j = 0; j < desc->Length; j++)
 				{
-					if(blob) blob->Release();
-					
-					// We dispose compiler.
-					delete compiler;
+					VertexFormat^ format = desc[j].Format;
+
+					// Stream output writes packed in declaration order, so elements go by offset.
+					SortedList<UInt32, VertexFormat::Element^>^ sorted = gcnew SortedList<UInt32, VertexFormat::Element^>();
+					for(unsigned int k = 0; k < format->ElementCount; k++)
+					{
+						sorted->Add(format[k]->Offset, format[k]);
+					}
+
+					unsigned int offset = 0;
+					for(int k = 0; k < sorted->Count; k++, i++)
+					{
+						VertexFormat::Element^ element = sorted->Values[k];
+						if(element->Offset != offset)
+						{
+							throw gcnew ArgumentException("Stream output elements must be tightly packed.");
+						}
+
+						D3D10_SO_DECLARATION_ENTRY& entry = entries[i];
+						entry.SemanticName = ToDXComponent(element->Component, entry.SemanticIndex);
+						entry.StartComponent = 0;
+						entry.ComponentCount = (BYTE)(ToFormatSize(ToDXFormat(element->Format)) / 4);
+						entry.OutputSlot = (BYTE)j;
+
+						offset += entry.ComponentCount * 4;
+					}
+
+					// Single buffer has stride of its vertex, with more buffers each holds one element.
+					if(j == 0) stride = offset;
 				}
+
+				D3D10VerticesOutBindingLayout^ layout = gcnew D3D10VerticesOutBindingLayout(entries, length, 
+					desc->Length == 1 ? stride : 0);
+				entries = 0;
+				return layout;
 			} finally {
-				delete [] layout;
+				delete [] entries;
 			}
 		}
 
 		void D3D10DeviceView::ClearStates()
 		{
+			FlushQueued();
 			device->ClearState();
+			drawQueue->InvalidatePipeline();
+			drawQueue->InvalidateMaterial();
+			drawQueue->InvalidateBuffers();
+			streamOutput = false;
+		}
+
+		static void ToDXTexture2DDesc(D3D10_TEXTURE2D_DESC& desc, Usage usage, CommonPixelFormatLayout fmt, CPUAccess access,
+			unsigned int width, unsigned int height, unsigned int arraySize, unsigned int mipmapLevels, 
+			TextureUsage textureUsage, unsigned int sampleCount, unsigned int sampleQuality)
+		{
+			desc.ArraySize = arraySize;
+			desc.BindFlags = 0;
+			desc.Usage = ToDXUsage(usage);
+			desc.MiscFlags = 0;
+			desc.CPUAccessFlags = ToDXCPUAccess(access);
+			desc.Format = ToDXFormat(fmt);
+			desc.Width = width;
+			desc.Height = height;
+			desc.MipLevels = mipmapLevels;
+			desc.SampleDesc.Count = sampleCount;
+			desc.SampleDesc.Quality = sampleQuality;
+
+			if((UInt32)textureUsage & (UInt32)TextureUsage::Texture) desc.BindFlags |= D3D10_BIND_SHADER_RESOURCE;
+			if((UInt32)textureUsage & (UInt32)TextureUsage::RenderTarget) desc.BindFlags |= D3D10_BIND_RENDER_TARGET;
+			if((UInt32)textureUsage & (UInt32)TextureUsage::DepthStencilTarget) desc.BindFlags |= D3D10_BIND_DEPTH_STENCIL;
+			if((UInt32)textureUsage & (UInt32)TextureUsage::CubeMap) desc.MiscFlags |= D3D10_RESOURCE_MISC_TEXTURECUBE;
+
+			// We allow mipmap generation if texture & render target.
+			if((desc.BindFlags & (D3D10_BIND_SHADER_RESOURCE|D3D10_BIND_RENDER_TARGET)) == (D3D10_BIND_SHADER_RESOURCE|D3D10_BIND_RENDER_TARGET))
+			{
+				desc.MiscFlags |= D3D10_RESOURCE_MISC_GENERATE_MIPS;
+			}
 		}
 
         IBuffer^ D3D10DeviceView::CreateBuffer(BufferUsage bufferUsage, Usage usage, CPUAccess access, UInt64 length, array<Byte>^ initialData)
 		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::CreateBuffer");
 			// Buffer description.
 			D3D10_BUFFER_DESC desc;
 			desc.ByteWidth = (unsigned int) length;
@@ -321,7 +492,9 @@ namespace Direct3D10 {
 				// Create buffer
 				ID3D10Buffer* buffer = 0;
 				DXFAILED(device->CreateBuffer(&desc, initialData != nullptr ? &data : 0, &buffer));
-				return gcnew D3D10Buffer(buffer);
+				D3D10Buffer^ result = gcnew D3D10Buffer(buffer);
+				result->view = this;
+				return result;
 
 			} finally {
 				delete [] data.pSysMem;
@@ -339,30 +512,28 @@ namespace Direct3D10 {
                                          unsigned int mipmapLevels, TextureUsage textureUsage,
                                          unsigned int sampleCount, unsigned int sampleQuality, array<array<Byte>^>^ initialData)
 		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::CreateTexture2D");
 
-			// Fill descriptor.
+			// Fill descriptor; cube maps are arrays of 6 faces.
 			D3D10_TEXTURE2D_DESC desc;
-			desc.ArraySize = 1;
-			desc.BindFlags = 0;
-			desc.Usage = ToDXUsage(usage);
-			desc.MiscFlags = 0;
-			desc.CPUAccessFlags = ToDXCPUAccess(access);
-			desc.Format = ToDXFormat(fmt);
-			desc.Width = width;
-			desc.Height = height;
-			desc.MipLevels = mipmapLevels;
-			desc.SampleDesc.Count = sampleCount;
-			desc.SampleDesc.Quality = sampleQuality;
+			ToDXTexture2DDesc(desc, usage, fmt, access, width, height, 
+				(UInt32)textureUsage & (UInt32)TextureUsage::CubeMap ? 6 : 1, mipmapLevels, textureUsage, 
+				sampleCount, sampleQuality);
 
-			if((UInt32)textureUsage & (UInt32)TextureUsage::Texture) desc.BindFlags |= D3D10_BIND_SHADER_RESOURCE;
-			if((UInt32)textureUsage & (UInt32)TextureUsage::RenderTarget) desc.BindFlags |= D3D10_BIND_RENDER_TARGET;
-			if((UInt32)textureUsage & (UInt32)TextureUsage::DepthStencilTarget) desc.BindFlags |= D3D10_BIND_DEPTH_STENCIL;
-			if((UInt32)textureUsage & (UInt32)TextureUsage::CubeMap) desc.MiscFlags |= D3D10_RESOURCE_MISC_TEXTURECUBE;
+			// Zero mipmaps means full chain; resolved so subresources can be indexed.
+			if(desc.MipLevels == 0)
+			{
+				UInt32 size = width > height ? width : height;
+				desc.MipLevels = 1;
+				while(size > 1) { size >>= 1; desc.MipLevels++; }
+			}
 
-			// We allow mipmap generation if texture & render target.
-			if((desc.BindFlags & (D3D10_BIND_SHADER_RESOURCE|D3D10_BIND_RENDER_TARGET)) == (D3D10_BIND_SHADER_RESOURCE|D3D10_BIND_RENDER_TARGET))
+			// Initial data is every mipmap of every slice, slice by slice.
+			if(initialData != nullptr && (UInt32)initialData->Length != desc.ArraySize * desc.MipLevels)
 			{
-				desc.MiscFlags = D3D10_RESOURCE_MISC_GENERATE_MIPS;
+				throw gcnew ArgumentException(String::Format("Initial data must have {0} subresources ({1} slices "
+					"of {2} mipmaps), {3} given.", desc.ArraySize * desc.MipLevels, desc.ArraySize, desc.MipLevels,
+					initialData->Length));
 			}
 
 			// Fill data.
@@ -381,18 +552,26 @@ namespace Direct3D10 {
 					{
 						array<Byte>^ src = initialData[i];
 
-						// Compute dimensions.
-						UInt32 w = width >> i;
-						UInt32 h = height >> i;
+						// Compute dimensions (subresources are mipmaps of each slice).
+						UInt32 mip = i % desc.MipLevels;
+						UInt32 w = width >> mip;
+						UInt32 h = height >> mip;
 						w = w > 0 ? w : 1;
 						h = h > 0 ? h : 1;
 
-						Byte* b = new Byte[h * w * ToFormatSize(desc.Format)];
+						UInt32 size = h * w * ToFormatSize(desc.Format);
+						if(src == nullptr || (UInt32)src->Length > size)
+						{
+							throw gcnew ArgumentException(String::Format("Initial data of subresource {0} "
+								"does not fit mipmap {1}.", i, mip));
+						}
+
+						Byte* b = new Byte[size];
 						data[i].pSysMem = b;
 						data[i].SysMemPitch = w * ToFormatSize(desc.Format);
-						for(Int32 i = 0; i < src->Length; i++)
+						for(Int32 j = 0; j < src->Length; j++)
 						{
-							b[i] = src[i];
+							b[j] = src[j];
 						}
 					}
 				} 
@@ -403,7 +582,9 @@ namespace Direct3D10 {
 					throw gcnew Exception("Could not create texture 2D.");
 				}
 
-				return gcnew D3D10Texture2d(texture2d);
+				D3D10Texture2d^ result = gcnew D3D10Texture2d(texture2d);
+				result->view = this;
+				return result;
 
 
 			} finally {
@@ -420,6 +601,36 @@ namespace Direct3D10 {
 			}
 		}
 
+        ITexture2D^ D3D10DeviceView::CreateTexture2DArray(Usage usage, CommonPixelFormatLayout fmt, CPUAccess access, unsigned int width, unsigned int height,
+                                         unsigned int arraySize, unsigned int mipmapLevels, TextureUsage textureUsage,
+                                         unsigned int sampleCount, unsigned int sampleQuality)
+		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::CreateTexture2DArray");
+
+			if(arraySize == 0 || arraySize > D3D10_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION)
+			{
+				throw gcnew ArgumentException("Invalid texture array size.");
+			}
+			if(((UInt32)textureUsage & (UInt32)TextureUsage::CubeMap) && arraySize != 6)
+			{
+				throw gcnew ArgumentException("Cube map must have 6 slices.");
+			}
+
+			D3D10_TEXTURE2D_DESC desc;
+			ToDXTexture2DDesc(desc, usage, fmt, access, width, height, arraySize, mipmapLevels, textureUsage, 
+				sampleCount, sampleQuality);
+
+			ID3D10Texture2D* texture2d;
+			if(FAILED(device->CreateTexture2D(&desc, 0, &texture2d)))
+			{
+				throw gcnew Exception("Could not create texture 2D array.");
+			}
+
+			D3D10Texture2d^ result = gcnew D3D10Texture2d(texture2d);
+			result->view = this;
+			return result;
+		}
+
         ITexture3D^ D3D10DeviceView::CreateTexture3D(Usage usage, CommonPixelFormatLayout fmt, CPUAccess access, unsigned int width, unsigned int height, 
 											unsigned int depth, unsigned int mipmapLevels, TextureUsage textureUsage, array<array<Byte>^>^ data)
 		{
@@ -429,21 +640,198 @@ namespace Direct3D10 {
 
         IShaderCompiler^ D3D10DeviceView::CreateShaderCompiler()
 		{
-			return gcnew D3D10ShaderCompiler(device);
+			return gcnew D3D10ShaderCompiler(device, shaderCache, shaderProfile);
 		}
 
         void D3D10DeviceView::Enter()
 		{
 			multithread->Enter();
+			if(profiler) profiler->BeginFrame();
+			if(occlusion) occlusion->BeginFrame();
 		}
 
         void D3D10DeviceView::Exit()
 		{
+			// Deferred draws belong to this frame and to the thread holding the device.
+			FlushQueued();
+			if(occlusion) occlusion->EndFrame();
+			if(profiler) profiler->EndFrame();
 			multithread->Leave();
 		}
 
+		bool D3D10DeviceView::Profiling::get()
+		{
+			return profiler != 0;
+		}
+
+		void D3D10DeviceView::Profiling::set(bool value)
+		{
+			if(value && !profiler)
+			{
+				queryBackend = new D3D10QueryBackend(device);
+				profiler = new GpuProfiler(queryBackend);
+			} else if(!value && profiler) {
+				delete profiler;
+				delete queryBackend;
+				profiler = 0;
+				queryBackend = 0;
+			}
+		}
+
+		void D3D10DeviceView::BeginProfileScope(String^ name, bool statistics)
+		{
+			if(!profiler) return;
+
+			array<Byte>^ bytes = Text::Encoding::UTF8->GetBytes(name);
+			std::string scope(bytes->Length, ' ');
+			for(int i = 0; i < bytes->Length; i++) scope[i] = (char)bytes[i];
+
+			// Draws deferred before the scope are not measured by it.
+			FlushQueued();
+			profiler->BeginScope(scope.c_str(), statistics ? GpuScopeStatistics : GpuScopeTiming);
+		}
+
+		void D3D10DeviceView::EndProfileScope()
+		{
+			if(!profiler) return;
+
+			// Draws deferred in the scope are measured by it.
+			FlushQueued();
+			profiler->EndScope();
+		}
+
+		array<GPUFrameTiming^>^ D3D10DeviceView::ReadProfileFrames()
+		{
+			if(!profiler) return gcnew array<GPUFrameTiming^>(0);
+			profiler->Update();
+
+			// History is oldest first, only frames not read before are returned.
+			const std::deque<GpuFrameResult>& history = profiler->GetHistory();
+			List<GPUFrameTiming^>^ frames = gcnew List<GPUFrameTiming^>();
+			for(size_t f = 0; f < history.size(); f++)
+			{
+				const GpuFrameResult& result = history[f];
+				if(result.frame < nextProfileFrame) continue;
+				nextProfileFrame = result.frame + 1;
+
+				GPUFrameTiming^ frame = gcnew GPUFrameTiming();
+				frame->Frame = result.frame;
+				frame->Duration = result.duration;
+				frame->Scopes = gcnew array<GPUScopeTiming^>((int)result.scopes.size());
+				for(size_t i = 0; i < result.scopes.size(); i++)
+				{
+					const GpuScopeResult& r = result.scopes[i];
+					GPUScopeTiming^ scope = gcnew GPUScopeTiming();
+					scope->Name = gcnew String((char*)r.name.c_str(), 0, (int)r.name.size(), Text::Encoding::UTF8);
+					scope->Depth = r.depth;
+					scope->Parent = r.parent;
+					scope->Begin = r.begin;
+					scope->End = r.end;
+					scope->HasStatistics = r.hasStatistics;
+					scope->Primitives = r.statistics.iaPrimitives;
+					scope->VertexShaderInvocations = r.statistics.vsInvocations;
+					scope->PixelShaderInvocations = r.statistics.psInvocations;
+					frame->Scopes[(int)i] = scope;
+				}
+				frames->Add(frame);
+			}
+			return frames->ToArray();
+		}
+
+		String^ D3D10DeviceView::GetProfileTrace()
+		{
+			if(!profiler) return nullptr;
+
+			std::ostringstream stream;
+			profiler->WriteChromeTrace(stream);
+			std::string trace = stream.str();
+			return gcnew String((char*)trace.c_str(), 0, (int)trace.size(), Text::Encoding::UTF8);
+		}
+
+		String^ D3D10DeviceView::ExportDriverTrace(bool clear)
+		{
+#ifdef SHARPMEDIA_D3D10_TRACE
+			std::ostringstream stream;
+			TraceWriteChrome(stream);
+			if(clear) TraceClear();
+			std::string trace = stream.str();
+			return gcnew String((char*)trace.c_str(), 0, (int)trace.size(), Text::Encoding::UTF8);
+#else
+			return nullptr;
+#endif
+		}
+
+		unsigned int D3D10DeviceView::CreateOcclusionObject()
+		{
+			if(!occlusion)
+			{
+				occlusionDevice = new D3D10OcclusionDevice(device);
+				occlusion = new OcclusionCuller(occlusionDevice);
+			}
+			return occlusion->Add();
+		}
+
+		void D3D10DeviceView::DestroyOcclusionObject(unsigned int id)
+		{
+			if(!occlusion || !occlusion->IsObject(id)) return;
+
+			// Id is reused by next object, which must not inherit proxy.
+			occlusion->Remove(id);
+			occlusionDevice->SetProxy(id, 0, 0, 0);
+		}
+
+		void D3D10DeviceView::SetOcclusionProxy(unsigned int id, UInt64 offset, UInt64 count, Int64 baseIndex)
+		{
+			if(!occlusion || !occlusion->IsObject(id))
+			{
+				throw gcnew ArgumentException("Not an occlusion object.");
+			}
+			occlusionDevice->SetProxy(id, (UINT)count, (UINT)offset, (INT)baseIndex);
+		}
+
+		void D3D10DeviceView::IssueOcclusionTests()
+		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::IssueOcclusionTests");
+			if(!occlusion) return;
+
+			// Occluders must be drawn before proxies are tested against them.
+			FlushQueued();
+			occlusion->IssueTests();
+		}
+
+		void D3D10DeviceView::BeginOcclusionDraw(unsigned int id)
+		{
+			if(!occlusion || !occlusion->IsObject(id))
+			{
+				throw gcnew ArgumentException("Not an occlusion object.");
+			}
+
+			// Predication is not captured by deferred draws, draws before it are not predicated.
+			if(!occlusion->IsVisible(id)) FlushQueued();
+			occlusion->BeginDraw(id);
+		}
+
+		void D3D10DeviceView::EndOcclusionDraw()
+		{
+			if(!occlusion) return;
+
+			// Deferred draws of object are submitted while predication is still set.
+			if(occlusion->IsPredicating()) FlushQueued();
+			occlusion->EndDraw();
+		}
+
+		bool D3D10DeviceView::IsOcclusionVisible(unsigned int id)
+		{
+			if(!occlusion || !occlusion->IsObject(id))
+			{
+				throw gcnew ArgumentException("Not an occlusion object.");
+			}
+			return occlusion->IsVisible(id);
+		}
+
         void D3D10DeviceView::Clear(IRenderTargetView^ view, Colour colour)
 		{
+			FlushQueued();
 			if(view->GetType() == D3D10RenderTargetView::typeid)
 			{
 				D3D10RenderTargetView^ v = (D3D10RenderTargetView^)view;
@@ -457,245 +845,465 @@ namespace Direct3D10 {
         void D3D10DeviceView::Clear(IDepthStencilTargetView^ view,
 			ClearOptions options, float depth, unsigned int stencil)
 		{
+			FlushQueued();
 			D3D10DepthStencilTargetView^ v = (D3D10DepthStencilTargetView^)view;
 			v->Clear(device, options, depth, stencil);
 		}
 
+		void D3D10DeviceView::FlushQueued()
+		{
+			if(!drawQueue || drawQueue->IsEmpty()) return;
+
+			D3D10_TRACE_SCOPE("D3D10DeviceView::FlushQueued");
+			if(!drawQueue->Flush())
+			{
+				throw gcnew Exception("Per-object data of batched draws could not be uploaded, draws were skipped.");
+			}
+		}
+
+		void D3D10DeviceView::ReleaseTargets()
+		{
+			if(!device) return;
+
+			FlushQueued();
+			drawQueue->SetTargets(0, 0, 0);
+			device->OMSetRenderTargets(0, 0, 0);
+		}
+
+		void D3D10DeviceView::FlushReferencing(ID3D10Resource* resource)
+		{
+			if(drawQueue && drawQueue->References(resource)) FlushQueued();
+		}
+
 		void D3D10DeviceView::DrawAuto()
 		{
+			FlushQueued();
 			device->DrawAuto();
 		}
 
 		void D3D10DeviceView::Draw(UInt64 off, UInt64 length)
 		{
+			FlushQueued();
 			device->Draw((unsigned int)length, (unsigned int)off);
 		}
 
         void D3D10DeviceView::DrawIndexed(UInt64 offset, UInt64 count, Int64 baseIndex,
 			unsigned int instanceOffset, unsigned int instanceCount)
 		{
+			FlushQueued();
 			device->DrawIndexedInstanced((unsigned int)count, instanceCount, 
 				(unsigned int)offset, (int)baseIndex, instanceOffset);
 		}
 
 		void D3D10DeviceView::DrawIndexed(UInt64 off, UInt64 length, Int64 baseIndex)
 		{
+			FlushQueued();
 			device->DrawIndexed((unsigned int)length, (unsigned int)off, (int)baseIndex);
 		}
 
         void D3D10DeviceView::Draw(UInt64 offset, UInt64 count, 
 			unsigned int instanceOffset, unsigned int instanceCount)
 		{
+			FlushQueued();
 			device->DrawInstanced((unsigned int)count, instanceCount, 
 				(unsigned int)offset, instanceOffset);
 		}
 
-        void D3D10DeviceView::BindGStage(IGShader^ gshader, array<ISamplerState^>^ samplers, array<ITextureView^>^ textures,
-                        array<ICBufferView^>^ constants, IVerticesOutBindingLayout^ layout, array<IVBufferView^>^ vbuffers)
+        void D3D10DeviceView::DrawIndexedBatched(UInt64 offset, UInt64 count, Int64 baseIndex, float depth,
+			unsigned int instanceSlot, array<Byte>^ instanceData)
 		{
-			
-		
+			D3D10_TRACE_COUNT("D3D10DeviceView::DrawIndexedBatched calls");
+			if(streamOutput)
+			{
+				throw gcnew InvalidOperationException("Draws writing to stream output can not be batched.");
+			}
+			if(instanceSlot >= D3D10_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT)
+			{
+				throw gcnew ArgumentOutOfRangeException("instanceSlot");
+			}
+
+			unsigned int stride = instanceData ? (unsigned int)instanceData->Length : 0;
+			pin_ptr<Byte> data = nullptr;
+			if(stride) data = &instanceData[0];
+			if(!drawQueue->AddBatched((unsigned int)count, (unsigned int)offset, (int)baseIndex, depth,
+				instanceSlot, data, stride))
+			{
+				throw gcnew Exception("Per-object data of batched draws could not be uploaded, draws were skipped.");
+			}
 		}
 
-        void D3D10DeviceView::BindVStage(Topology topology, IVerticesBindingLayout^ layout, array<IVBufferView^>^ vbuffers, IIBufferView^ ibuffer,
-			IVShader^ vshader, array<ISamplerState^>^ samplers, array<ITextureView^>^ textures, 
-			array<ICBufferView^>^ constants)
+        void D3D10DeviceView::DrawIndexedQueued(UInt64 offset, UInt64 count, Int64 baseIndex,
+			unsigned int layer, bool translucent, float depth)
 		{
-			// Local data.
-			int i;
-			ID3D10SamplerState** samplerStates = 0;
-			ID3D10ShaderResourceView** textureStates = 0;
-			ID3D10Buffer** constantBuffers = 0;
+			D3D10_TRACE_COUNT("D3D10DeviceView::DrawIndexedQueued calls");
+			if(streamOutput)
+			{
+				throw gcnew InvalidOperationException("Draws writing to stream output can not be queued.");
+			}
+			if(layer > 15)
+			{
+				throw gcnew ArgumentOutOfRangeException("layer");
+			}
 
-			try {
+			drawQueue->AddQueued((unsigned int)count, (unsigned int)offset, (int)baseIndex, layer, translucent, depth);
+		}
+
+        void D3D10DeviceView::FlushDraws()
+		{
+			FlushQueued();
+		}
+
+		static const char* StageName(BindingStage stage)
+		{
+			switch(stage)
+			{
+			case BindingStage::VertexShader:
+				return "Vertex shader";
+			case BindingStage::GeometryShader:
+				return "Geometry shader";
+			default:
+				return "Pixel shader";
+			}
+		}
+
+		// Reports slots that are read but not bound, or bound but never read (once per shader and slot).
+		static void ValidateResources(BindingStage stage, const D3D10ShaderManifest* manifest,
+			array<ISamplerState^>^ samplers, array<ITextureView^>^ textures, array<ICBufferView^>^ constants)
+		{
+			// Shader that could not be reflected binds everything, there is nothing to check.
+			if(!manifest->reflected) return;
+
+			String^ name = gcnew String(StageName(stage));
+			unsigned int i;
 
-				// Layout
-				if(layout)
+			for(i = 0; i < MaxSamplerSlots; i++)
+			{
+				bool bound = i < (unsigned int)samplers->Length && samplers[i] != nullptr;
+				if(manifest->IsSamplerUsed(i) && !bound && manifest->ReportSampler(i))
+				{
+					Common::Error(D3D10DeviceView::typeid, String::Format("{0} reads sampler slot {1} that is not bound.", name, i));
+				} else if(!manifest->IsSamplerUsed(i) && bound && manifest->ReportSampler(i))
 				{
-					D3D10VerticesBindingLayout^ d3dLayout = (D3D10VerticesBindingLayout^)layout;
-					d3dLayout->Apply(device);
+					Common::Warning(D3D10DeviceView::typeid, String::Format("{0} does not read bound sampler slot {1}.", name, i));
 				}
+			}
 
-				// Index buffer.
-				if(ibuffer)
+			for(i = 0; i < MaxTextureSlots; i++)
+			{
+				bool bound = i < (unsigned int)textures->Length && textures[i] != nullptr;
+				if(manifest->IsTextureUsed(i) && !bound && manifest->ReportTexture(i))
+				{
+					Common::Error(D3D10DeviceView::typeid, String::Format("{0} reads texture slot {1} that is not bound.", name, i));
+				} else if(!manifest->IsTextureUsed(i) && bound && manifest->ReportTexture(i))
 				{
-					D3D10IBuffer^ view = (D3D10IBuffer^)ibuffer;
-					view->Apply(device);
+					Common::Warning(D3D10DeviceView::typeid, String::Format("{0} does not read bound texture slot {1}.", name, i));
 				}
+			}
 
-				// Vertex buffers.
-				for(i = 0; i < vbuffers->Length; i++)
+			for(i = 0; i < MaxConstantBufferSlots; i++)
+			{
+				bool bound = i < (unsigned int)constants->Length && constants[i] != nullptr;
+				if(manifest->IsConstantBufferUsed(i) && !bound && manifest->ReportConstantBuffer(i))
 				{
-					D3D10VBuffer^ view = (D3D10VBuffer^)vbuffers[i];
-					view->Apply(device, (unsigned int)i);
-					
+					Common::Error(D3D10DeviceView::typeid, String::Format("{0} reads constant buffer slot {1} that is not bound.", name, i));
+				} else if(!manifest->IsConstantBufferUsed(i) && bound && manifest->ReportConstantBuffer(i))
+				{
+					Common::Warning(D3D10DeviceView::typeid, String::Format("{0} does not read bound constant buffer slot {1}.", name, i));
 				}
+			}
+		}
+
+		// Binds samplers, textures and constant buffers of a stage. If the manifest of the shader
+		// is known, only slots the shader reads are bound.
+		static void BindResources(ID3D10Device* device, BindingStage stage, const D3D10ShaderManifest* manifest,
+			array<ISamplerState^>^ samplers, array<ITextureView^>^ textures, array<ICBufferView^>^ constants)
+		{
+			ID3D10SamplerState* samplerStates[MaxSamplerSlots];
+			ID3D10ShaderResourceView* textureStates[MaxTextureSlots];
+			ID3D10Buffer* constantBuffers[MaxConstantBufferSlots];
+			unsigned int i, first, count;
+
+			// Samplers.
+			if(manifest)
+			{
+				manifest->SamplerRange(samplers->Length, first, count);
+			} else {
+				first = 0;
+				count = __min((unsigned int)samplers->Length, MaxSamplerSlots);
+			}
+
+			for(i = 0; i < count; i++)
+			{
+				D3D10SamplerState^ state = (D3D10SamplerState^)samplers[first + i];
+				samplerStates[i] = state ? state->state : 0;
+			}
 
-				// We set topology.
-				switch(topology)
+			if(count > 0)
+			{
+				switch(stage)
 				{
-				case Topology::Line:
-					device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_LINELIST);
+				case BindingStage::VertexShader:
+					device->VSSetSamplers(first, count, samplerStates);
 					break;
-				case Topology::LineStrip:
-					device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_LINESTRIP);
+				case BindingStage::GeometryShader:
+					device->GSSetSamplers(first, count, samplerStates);
 					break;
-				case Topology::Point:
-					device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_POINTLIST);
+				case BindingStage::PixelShader:
+					device->PSSetSamplers(first, count, samplerStates);
 					break;
-				case Topology::Triangle:
-					device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-					break;
-				case Topology::TriangleStrip:
-					device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-					break;
-				default:
-					NOT_SUPPORTED();
-
-				}
-				// Vertex shader.
-				if(vshader)
-				{
-					D3D10VShader^ shader = (D3D10VShader^)vshader;
-					shader->Apply(device);
 				}
+			}
 
-				// Samplers.
-				samplerStates = new ID3D10SamplerState*[samplers->Length];
-				for(i = 0; i < samplers->Length; i++)
-				{
-					D3D10SamplerState^ state = (D3D10SamplerState^)samplers[i];
-					samplerStates[i] = state ? state->state : 0;
-				}
+			// Textures.
+			if(manifest)
+			{
+				manifest->TextureRange(textures->Length, first, count);
+			} else {
+				first = 0;
+				count = __min((unsigned int)textures->Length, MaxTextureSlots);
+			}
 
-				if(samplers->Length > 0)
-				{
-					device->VSSetSamplers(0, samplers->Length, samplerStates);
-				}
+			for(i = 0; i < count; i++)
+			{
+				D3D10TextureView^ view = (D3D10TextureView^)textures[first + i];
+				textureStates[i] = view ? view->view : 0;
+			}
 
-				// Texture
-				textureStates = new ID3D10ShaderResourceView*[textures->Length];
-				for(i = 0; i < textures->Length; i++)
+			if(count > 0)
+			{
+				switch(stage)
 				{
-					textureStates[i] = ((D3D10TextureView^)textures[i])->view;
+				case BindingStage::VertexShader:
+					device->VSSetShaderResources(first, count, textureStates);
+					break;
+				case BindingStage::GeometryShader:
+					device->GSSetShaderResources(first, count, textureStates);
+					break;
+				case BindingStage::PixelShader:
+					device->PSSetShaderResources(first, count, textureStates);
+					break;
 				}
+			}
 
-				if(textures->Length > 0)
-				{
-					device->VSSetShaderResources(0, textures->Length, textureStates);
-				}
+			// Constant buffers.
+			if(manifest)
+			{
+				manifest->ConstantBufferRange(constants->Length, first, count);
+			} else {
+				first = 0;
+				count = __min((unsigned int)constants->Length, MaxConstantBufferSlots);
+			}
 
-				// Constant buffers.
-				constantBuffers = new ID3D10Buffer*[constants->Length];
-				for(i = 0; i < constants->Length; i++)
-				{
-					D3D10CBuffer^ buffer = (D3D10CBuffer^)constants[i];
-					constantBuffers[i] = buffer ? buffer->GetBuffer() : 0;
-				}
+			for(i = 0; i < count; i++)
+			{
+				D3D10CBuffer^ buffer = (D3D10CBuffer^)constants[first + i];
+				constantBuffers[i] = buffer ? buffer->GetBuffer() : 0;
+			}
 
-				if(constants->Length > 0)
+			if(count > 0)
+			{
+				switch(stage)
 				{
-					device->VSSetConstantBuffers(0, constants->Length, constantBuffers);
+				case BindingStage::VertexShader:
+					device->VSSetConstantBuffers(first, count, constantBuffers);
+					break;
+				case BindingStage::GeometryShader:
+					device->GSSetConstantBuffers(first, count, constantBuffers);
+					break;
+				case BindingStage::PixelShader:
+					device->PSSetConstantBuffers(first, count, constantBuffers);
+					break;
 				}
-
-			} finally {
-				delete [] samplerStates;
-				delete [] textureStates;
-				delete [] constantBuffers;
 			}
-		
 		}
 
-		void D3D10DeviceView::BindPStage(IPShader^ pshader, array<ISamplerState^>^ samplers, array<ITextureView^>^ textures,
-                        array<ICBufferView^>^ constants, array<IRenderTargetView^>^ renderTargets, 
-						IDepthStencilTargetView^ depthTarget)
+        void D3D10DeviceView::BindGStage(IGShader^ gshader, array<ISamplerState^>^ samplers, array<ITextureView^>^ textures,
+                        array<ICBufferView^>^ constants, IVerticesOutBindingLayout^ layout, array<IVBufferView^>^ vbuffers)
 		{
-			// Local data.
-			int i;
-			ID3D10SamplerState** samplerStates = 0;
-			ID3D10ShaderResourceView** textureStates = 0;
-			ID3D10Buffer** constantBuffers = 0;
-			ID3D10RenderTargetView** renderTargetViews = 0;
+			D3D10_TRACE_SCOPE("D3D10DeviceView::BindGStage");
+			D3D10_TRACE_COUNT("D3D10DeviceView::BindGStage calls");
 
-			try {
+			D3D10VerticesOutBindingLayout^ outLayout = (D3D10VerticesOutBindingLayout^)layout;
 
-				// Vertex shader.
-				if(pshader)
-				{
-					D3D10PShader^ shader = (D3D10PShader^)pshader;
-					shader->Apply(device);
-				}
+			// Queued draws must not write to new stream output targets.
+			if(outLayout || streamOutput) FlushQueued();
+			drawQueue->InvalidatePipeline();
+			drawQueue->InvalidateMaterial();
 
-				// Samplers.
-				samplerStates = new ID3D10SamplerState*[samplers->Length];
-				for(i = 0; i < samplers->Length; i++)
-				{
-					D3D10SamplerState^ state = (D3D10SamplerState^)samplers[i];
-					samplerStates[i] = state ? state->state : 0;
-				}
+			// Geometry shader, with stream output variant when writing to buffers.
+			const D3D10ShaderManifest* manifest = 0;
+			if(gshader)
+			{
+				D3D10GShader^ shader = (D3D10GShader^)gshader;
+				shader->Apply(device, outLayout);
+				manifest = shader->GetManifest();
 
-				if(samplers->Length > 0)
+				if(validateBindings)
 				{
-					device->PSSetSamplers(0, samplers->Length, samplerStates);
+					ValidateResources(BindingStage::GeometryShader, manifest, samplers, textures, constants);
 				}
-
-				// Texture
-				textureStates = new ID3D10ShaderResourceView*[textures->Length];
-				for(i = 0; i < textures->Length; i++)
+			} else {
+				if(outLayout)
 				{
-					textureStates[i] = ((D3D10TextureView^)textures[i])->view;
+					throw gcnew InvalidOperationException("Stream output requires a geometry shader.");
 				}
+				device->GSSetShader(0);
+			}
 
-				if(textures->Length > 0)
-				{
-					device->PSSetShaderResources(0, textures->Length, textureStates);
-				}
+			// Samplers, textures and constant buffers.
+			BindResources(device, BindingStage::GeometryShader, manifest, samplers, textures, constants);
 
-				// Constant buffers.
-				constantBuffers = new ID3D10Buffer*[constants->Length];
-				for(i = 0; i < constants->Length; i++)
+			// Stream output targets; unbound when there is no output so buffers can be used as input.
+			ID3D10Buffer* targets[D3D10_SO_BUFFER_SLOT_COUNT];
+			UINT offsets[D3D10_SO_BUFFER_SLOT_COUNT];
+			unsigned int targetCount = outLayout ? __min((unsigned int)vbuffers->Length, D3D10_SO_BUFFER_SLOT_COUNT) : 0;
+			for(unsigned int i = 0; i < D3D10_SO_BUFFER_SLOT_COUNT; i++)
+			{
+				if(i < targetCount)
 				{
-					D3D10CBuffer^ buffer = (D3D10CBuffer^)constants[i];
-					constantBuffers[i] = buffer ? buffer->GetBuffer() : 0;
+					D3D10VBuffer^ view = (D3D10VBuffer^)vbuffers[i];
+					targets[i] = view->GetBuffer();
+					offsets[i] = view->GetOffset();
+				} else {
+					targets[i] = 0;
+					offsets[i] = 0;
 				}
+			}
+			device->SOSetTargets(D3D10_SO_BUFFER_SLOT_COUNT, targets, offsets);
+			streamOutput = targetCount > 0;
+		}
 
-				if(constants->Length > 0)
+        void D3D10DeviceView::BindVStage(Topology topology, IVerticesBindingLayout^ layout, array<IVBufferView^>^ vbuffers, IIBufferView^ ibuffer,
+			IVShader^ vshader, array<ISamplerState^>^ samplers, array<ITextureView^>^ textures, 
+			array<ICBufferView^>^ constants)
+		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::BindVStage");
+			D3D10_TRACE_COUNT("D3D10DeviceView::BindVStage calls");
+			drawQueue->InvalidatePipeline();
+			drawQueue->InvalidateMaterial();
+			drawQueue->InvalidateBuffers();
+
+			// Layout
+			if(layout)
+			{
+				D3D10VerticesBindingLayout^ d3dLayout = (D3D10VerticesBindingLayout^)layout;
+				d3dLayout->Apply(device);
+			}
+
+			// Index buffer.
+			if(ibuffer)
+			{
+				D3D10IBuffer^ view = (D3D10IBuffer^)ibuffer;
+				view->Apply(device);
+			}
+
+			// Vertex buffers.
+			for(int i = 0; i < vbuffers->Length; i++)
+			{
+				D3D10VBuffer^ view = (D3D10VBuffer^)vbuffers[i];
+				view->Apply(device, (unsigned int)i);
+				
+			}
+
+			// We set topology.
+			switch(topology)
+			{
+			case Topology::Line:
+				device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_LINELIST);
+				break;
+			case Topology::LineStrip:
+				device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_LINESTRIP);
+				break;
+			case Topology::Point:
+				device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_POINTLIST);
+				break;
+			case Topology::Triangle:
+				device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+				break;
+			case Topology::TriangleStrip:
+				device->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+				break;
+			default:
+				NOT_SUPPORTED();
+
+			}
+
+			// Vertex shader.
+			const D3D10ShaderManifest* manifest = 0;
+			if(vshader)
+			{
+				D3D10VShader^ shader = (D3D10VShader^)vshader;
+				shader->Apply(device);
+				manifest = shader->GetManifest();
+
+				if(validateBindings)
 				{
-					device->PSSetConstantBuffers(0, constants->Length, constantBuffers);
+					ValidateResources(BindingStage::VertexShader, manifest, samplers, textures, constants);
 				}
-				
+			}
+
+			// Samplers, textures and constant buffers.
+			BindResources(device, BindingStage::VertexShader, manifest, samplers, textures, constants);
+		
+		}
 
-				// Render targets and depth stencil.
-				renderTargetViews = new ID3D10RenderTargetView*[renderTargets->Length];
-				for(int i = 0; i < renderTargets->Length; i++)
+		void D3D10DeviceView::BindPStage(IPShader^ pshader, array<ISamplerState^>^ samplers, array<ITextureView^>^ textures,
+                        array<ICBufferView^>^ constants, array<IRenderTargetView^>^ renderTargets, 
+						IDepthStencilTargetView^ depthTarget)
+		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::BindPStage");
+			D3D10_TRACE_COUNT("D3D10DeviceView::BindPStage calls");
+			ID3D10RenderTargetView* renderTargetViews[D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT];
+			drawQueue->InvalidatePipeline();
+			drawQueue->InvalidateMaterial();
+
+			// Pixel shader.
+			const D3D10ShaderManifest* manifest = 0;
+			if(pshader)
+			{
+				D3D10PShader^ shader = (D3D10PShader^)pshader;
+				shader->Apply(device);
+				manifest = shader->GetManifest();
+
+				if(validateBindings)
 				{
-					if(renderTargets[i]->GetType() == D3D10RenderTargetView::typeid)
-					{
-						D3D10RenderTargetView^ view = (D3D10RenderTargetView^)renderTargets[i];
-						renderTargetViews[i] = view->view;
-					} else {
-						D3D10SwapChain^ view = (D3D10SwapChain^)renderTargets[i];
-						renderTargetViews[i] = view->backBuffer;
-					}
+					ValidateResources(BindingStage::PixelShader, manifest, samplers, textures, constants);
 				}
+			}
 
-				D3D10DepthStencilTargetView^ dsView = (D3D10DepthStencilTargetView^)depthTarget;
+			// Samplers, textures and constant buffers.
+			BindResources(device, BindingStage::PixelShader, manifest, samplers, textures, constants);
 
-				device->OMSetRenderTargets(renderTargets->Length, renderTargetViews,
-					dsView ? dsView->view : 0);
+			// Render targets and depth stencil.
+			unsigned int targetCount = __min((unsigned int)renderTargets->Length, D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT);
+			for(unsigned int i = 0; i < targetCount; i++)
+			{
+				if(renderTargets[i]->GetType() == D3D10RenderTargetView::typeid)
+				{
+					D3D10RenderTargetView^ view = (D3D10RenderTargetView^)renderTargets[i];
+					renderTargetViews[i] = view->view;
+				} else {
+					D3D10SwapChain^ view = (D3D10SwapChain^)renderTargets[i];
+					renderTargetViews[i] = view->backBuffer;
+				}
+			}
 
+			D3D10DepthStencilTargetView^ dsView = (D3D10DepthStencilTargetView^)depthTarget;
 
-			} finally {
-				delete [] samplerStates;
-				delete [] textureStates;
-				delete [] constantBuffers;
-				delete [] renderTargetViews;
+			// Render targets are not part of captured state, queued draws go to current ones.
+			if(drawQueue->SetTargets(targetCount, renderTargetViews, dsView ? dsView->view : 0))
+			{
+				FlushQueued();
 			}
+
+			device->OMSetRenderTargets(targetCount, renderTargetViews,
+				dsView ? dsView->view : 0);
 		}
 
 
 		void D3D10DeviceView::SetViewports(array<Region2i>^ rects)
 		{
+			FlushQueued();
 			D3D10_VIEWPORT* viewports = new D3D10_VIEWPORT[rects->Length];
 			for(int i = 0; i < rects->Length; i++)
 			{
@@ -716,6 +1324,7 @@ namespace Direct3D10 {
 
 		void D3D10DeviceView::SetScissorRects(array<Region2i>^ rects)
 		{
+			FlushQueued();
 			D3D10_RECT* viewports = 0;
 			try {
 				viewports = new D3D10_RECT[rects->Length];
@@ -736,17 +1345,26 @@ namespace Direct3D10 {
 
 		void D3D10DeviceView::SetBlendState(IBlendState^ state, Colour colour, unsigned int mask)
 		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::SetBlendState");
+			D3D10_TRACE_COUNT("D3D10DeviceView::SetBlendState calls");
+			drawQueue->InvalidatePipeline();
 			D3D10BlendState^ s = (D3D10BlendState^)state;
 			s->Apply(device, colour, mask);
 		}
 		void D3D10DeviceView::SetDepthStencilState(IDepthStencilState^ state, unsigned int stencilRef)
 		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::SetDepthStencilState");
+			D3D10_TRACE_COUNT("D3D10DeviceView::SetDepthStencilState calls");
+			drawQueue->InvalidatePipeline();
 			D3D10DepthStencilState^ s = (D3D10DepthStencilState^)state;
 			s->Apply(device, stencilRef);
 		}
 
 		void D3D10DeviceView::SetRasterizationState(IRasterizationState^ state)
 		{
+			D3D10_TRACE_SCOPE("D3D10DeviceView::SetRasterizationState");
+			D3D10_TRACE_COUNT("D3D10DeviceView::SetRasterizationState calls");
+			drawQueue->InvalidatePipeline();
 			D3D10RasterizationState^ s = (D3D10RasterizationState^)state;
 			s->Apply(device);
 		}
@@ -766,6 +1384,16 @@ namespace Direct3D10 {
 			D3D10Buffer^ b = (D3D10Buffer^)buffer;
 			return b->CreateIView(device, wide, offset);
 		}
+		// Number of slices from first; 0 means all remaining slices.
+		static UINT SliceCount(ID3D10Texture2D* texture, UInt64 first, UInt64 count)
+		{
+			if(count != 0) return (UINT)count;
+
+			D3D10_TEXTURE2D_DESC desc;
+			texture->GetDesc(&desc);
+			return desc.ArraySize > first ? desc.ArraySize - (UINT)first : 0;
+		}
+
         IRenderTargetView^ D3D10DeviceView::CreateRenderTargetView(Object^ resource, UsageDimensionType usageType, 
 			CommonPixelFormatLayout layout, UInt64 param1, UInt64 param2, UInt64 param3)
 		{
@@ -783,6 +1411,18 @@ namespace Direct3D10 {
 				} else if(usageType == UsageDimensionType::Texture2DMS)
 				{
 					desc.ViewDimension = D3D10_RTV_DIMENSION_TEXTURE2DMS;
+				} else if(usageType == UsageDimensionType::Texture2DArray || usageType == UsageDimensionType::TextureCube)
+				{
+					// Cube faces are rendered as array slices.
+					desc.ViewDimension = D3D10_RTV_DIMENSION_TEXTURE2DARRAY;
+					desc.Texture2DArray.MipSlice = (UINT)param1;
+					desc.Texture2DArray.FirstArraySlice = (UINT)param2;
+					desc.Texture2DArray.ArraySize = SliceCount(((D3D10Texture2d^)resource)->texture2D, param2, param3);
+				} else if(usageType == UsageDimensionType::Texture2DMSArray)
+				{
+					desc.ViewDimension = D3D10_RTV_DIMENSION_TEXTURE2DMSARRAY;
+					desc.Texture2DMSArray.FirstArraySlice = (UINT)param2;
+					desc.Texture2DMSArray.ArraySize = SliceCount(((D3D10Texture2d^)resource)->texture2D, param2, param3);
 				} else {
 					throw gcnew NotSupportedException();
 				}
@@ -819,6 +1459,17 @@ namespace Direct3D10 {
 				} else if(usageType == UsageDimensionType::Texture2DMS)
 				{
 					desc.ViewDimension = D3D10_DSV_DIMENSION_TEXTURE2DMS;
+				} else if(usageType == UsageDimensionType::Texture2DArray || usageType == UsageDimensionType::TextureCube)
+				{
+					desc.ViewDimension = D3D10_DSV_DIMENSION_TEXTURE2DARRAY;
+					desc.Texture2DArray.MipSlice = (UINT)param1;
+					desc.Texture2DArray.FirstArraySlice = (UINT)param2;
+					desc.Texture2DArray.ArraySize = SliceCount(((D3D10Texture2d^)resource)->texture2D, param2, param3);
+				} else if(usageType == UsageDimensionType::Texture2DMSArray)
+				{
+					desc.ViewDimension = D3D10_DSV_DIMENSION_TEXTURE2DMSARRAY;
+					desc.Texture2DMSArray.FirstArraySlice = (UINT)param2;
+					desc.Texture2DMSArray.ArraySize = SliceCount(((D3D10Texture2d^)resource)->texture2D, param2, param3);
 				} else {
 					throw gcnew NotSupportedException();
 				}
@@ -869,6 +1520,37 @@ namespace Direct3D10 {
 					throw gcnew Exception("Could not create texture view.");
 				}
 
+				return gcnew D3D10TextureView(view);
+			} else if(usageType == UsageDimensionType::TextureCube || usageType == UsageDimensionType::Texture2DArray)
+			{
+				if(resource->GetType() != D3D10Texture2d::typeid)
+				{
+					throw gcnew NotImplementedException();
+				}
+				ID3D10Texture2D* res = ((D3D10Texture2d^)resource)->texture2D;
+
+				// Mipmaps as for 2D textures, array views take all slices.
+				D3D10_SHADER_RESOURCE_VIEW_DESC desc;
+				desc.Format = ToDXFormat(layout);
+				if(usageType == UsageDimensionType::TextureCube)
+				{
+					desc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURECUBE;
+					desc.TextureCube.MostDetailedMip = (UINT)param1;
+					desc.TextureCube.MipLevels = (UINT)param2;
+				} else {
+					desc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURE2DARRAY;
+					desc.Texture2DArray.MostDetailedMip = (UINT)param1;
+					desc.Texture2DArray.MipLevels = (UINT)param2;
+					desc.Texture2DArray.FirstArraySlice = 0;
+					desc.Texture2DArray.ArraySize = SliceCount(res, 0, param3);
+				}
+
+				ID3D10ShaderResourceView* view;
+				if(FAILED(device->CreateShaderResourceView(res, &desc, &view)))
+				{
+					throw gcnew Exception("Could not create texture view.");
+				}
+
 				return gcnew D3D10TextureView(view);
 			} else if(usageType == UsageDimensionType::Buffer)
 			{
@@ -905,6 +1587,22 @@ namespace Direct3D10 {
 
 		D3D10DeviceView::~D3D10DeviceView()
 		{
+			// Queued draws are dropped, they hold references to captured states.
+			delete drawQueue;
+			drawQueue = 0;
+
+			Profiling = false;
+
+			// Predicates are released before device.
+			delete occlusion;
+			delete occlusionDevice;
+			occlusion = 0;
+			occlusionDevice = 0;
+
+			// Compilers created by device may still hold the cache.
+			shaderCache->Release();
+			shaderCache = 0;
+
 			device->Release();
 			device = 0;
 
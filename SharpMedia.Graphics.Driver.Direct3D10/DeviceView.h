@@ -2,6 +2,7 @@
 #include <windows.h>
 #include <D3D10.h>
 #include "GraphicsService.h"
+#include "ShaderCache.h"
 
 using namespace System;
 using namespace SharpMedia::Math;
@@ -11,14 +12,40 @@ namespace Graphics {
 namespace Driver {
 namespace Direct3D10 {
 
+	class D3D10DrawQueue;
+	class D3D10QueryBackend;
+	class GpuProfiler;
+	class D3D10OcclusionDevice;
+	class OcclusionCuller;
+
 	public ref class D3D10DeviceView : public IDevice
 	{
 		ID3D10Device* device;
 		ID3D10Multithread* multithread;
 		IDeviceListener^ listener;
 		D3D10GraphicsService^ service;
+		D3D10ShaderCache* shaderCache;
+		bool validateBindings;
+		Shaders::ShaderCompileProfile shaderProfile;
+		D3D10DrawQueue* drawQueue;
+		bool streamOutput;		//< Stream output targets are bound, draws are not deferred.
+		D3D10QueryBackend* queryBackend;
+		GpuProfiler* profiler;	//< Null unless profiling; frames are Enter to Exit.
+		unsigned long long nextProfileFrame;
+		D3D10OcclusionDevice* occlusionDevice;
+		OcclusionCuller* occlusion;	//< Null until first occlusion object; frames are Enter to Exit.
 
 		Collections::Generic::SortedDictionary<Guid, SharedTextureInfo^>^ sharedTextures;
+
+	internal:
+		// Submits deferred draws before state they do not capture changes.
+		void FlushQueued();
+
+		// Submits deferred draws and unbinds render targets (swap chain buffers are resized).
+		void ReleaseTargets();
+
+		// Submits deferred draws if they use resource, before it is mapped.
+		void FlushReferencing(ID3D10Resource* resource);
 	public:
 		D3D10DeviceView(ID3D10Device* device, D3D10GraphicsService^ service);
 
@@ -32,6 +59,46 @@ namespace Direct3D10 {
 			UInt64 get();
 		}
 
+		// Reports mismatches between bound resources and resources shaders read (default in debug builds).
+		property bool ValidateBindings
+		{
+			bool get();
+			void set(bool value);
+		}
+
+		// Profile of created shader compilers (debug in debug builds, shipping otherwise).
+		property Shaders::ShaderCompileProfile ShaderProfile
+		{
+			Shaders::ShaderCompileProfile get();
+			void set(Shaders::ShaderCompileProfile value);
+		}
+
+		// GPU profiling of frames (device lock sections) and scopes.
+		virtual property bool Profiling
+		{
+			bool get();
+			void set(bool value);
+		}
+
+		virtual void BeginProfileScope(String^ name, bool statistics);
+		virtual void EndProfileScope();
+		virtual array<GPUFrameTiming^>^ ReadProfileFrames();
+		virtual String^ GetProfileTrace();
+		virtual String^ ExportDriverTrace(bool clear);
+
+		// Occlusion culling by proxy draws, see OcclusionCuller.
+		virtual unsigned int CreateOcclusionObject();
+		virtual void DestroyOcclusionObject(unsigned int id);
+		virtual void SetOcclusionProxy(unsigned int id, UInt64 offset, UInt64 count, Int64 baseIndex);
+		virtual void IssueOcclusionTests();
+		virtual void BeginOcclusionDraw(unsigned int id);
+		virtual void EndOcclusionDraw();
+		virtual bool IsOcclusionVisible(unsigned int id);
+
+		// Creates input layout of vertex binding, matched against signature of vertex shader bytecode.
+		static IVerticesBindingLayout^ CreateInputLayout(ID3D10Device* device, 
+			array<VertexBindingElement>^ desc, ID3D10Blob* signature);
+
 		virtual SharedTextureInfo^ GetShared(Guid guid);
         virtual void RegisterShared(Guid guid, SharedTextureInfo^ info);
         virtual void UnregisterShared(Guid guid);
@@ -45,12 +112,16 @@ namespace Direct3D10 {
 		virtual IDepthStencilState^ CreateState(States::DepthStencilState^ desc);
 		virtual ISamplerState^ CreateState(States::SamplerState^ desc);
         virtual IVerticesBindingLayout^ CreateVertexBinding(array<VertexBindingElement>^ desc);
+        virtual IVerticesOutBindingLayout^ CreateVertexOutBinding(array<VertexBindingElement>^ desc);
         virtual IBuffer^ CreateBuffer(BufferUsage bufferUsage, Usage usage, CPUAccess access, UInt64 length, array<Byte>^ initialData);
         virtual ITexture1D^ CreateTexture1D(Usage usage, CommonPixelFormatLayout fmt, CPUAccess access, unsigned int width,
                                          unsigned int mipmapLevels, TextureUsage textureUsage, array<array<Byte>^>^ data);
         virtual ITexture2D^ CreateTexture2D(Usage usage, CommonPixelFormatLayout fmt, CPUAccess access, unsigned int width, unsigned int height,
                                          unsigned int mipmapLevels, TextureUsage textureUsage,
                                          unsigned int sampleCount, unsigned int sampleQuality, array<array<Byte>^>^ data);
+        virtual ITexture2D^ CreateTexture2DArray(Usage usage, CommonPixelFormatLayout fmt, CPUAccess access, unsigned int width, unsigned int height,
+                                         unsigned int arraySize, unsigned int mipmapLevels, TextureUsage textureUsage,
+                                         unsigned int sampleCount, unsigned int sampleQuality);
 
         virtual ITexture3D^ CreateTexture3D(Usage usage, CommonPixelFormatLayout fmt, CPUAccess access, unsigned int width, unsigned int height, 
 											unsigned int depth, unsigned int mipmapLevels, TextureUsage textureUsage, array<array<Byte>^>^ data);
@@ -67,6 +138,11 @@ namespace Direct3D10 {
         virtual void DrawIndexed(UInt64 off, UInt64 lenght, Int64 baseVertex);
         virtual void DrawIndexed(UInt64 offset, UInt64 count, Int64 baseVertex,
                   unsigned int instanceOffset, unsigned int instanceCount);
+        virtual void DrawIndexedBatched(UInt64 offset, UInt64 count, Int64 baseVertex, float depth,
+                  unsigned int instanceSlot, array<Byte>^ instanceData);
+        virtual void DrawIndexedQueued(UInt64 offset, UInt64 count, Int64 baseVertex,
+                  unsigned int layer, bool translucent, float depth);
+        virtual void FlushDraws();
 
         virtual void BindVStage(Topology topology, IVerticesBindingLayout^ layout, array<IVBufferView^>^ vbuffers, IIBufferView^ ibuffer,
 			IVShader^ vshader, array<ISamplerState^>^ samplers, array<ITextureView^>^ textures, 
@@ -0,0 +1,204 @@
+#include "DrawBatcher.h"
+#include <algorithm>
+#include <cstring>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	static bool SameState(const DrawBatcher::Draw& a, const DrawBatcher::Draw& b)
+	{
+		return a.pipeline == b.pipeline && a.material == b.material && a.buffers == b.buffers;
+	}
+
+	static bool SameBatch(const DrawBatcher::Draw& a, const DrawBatcher::Draw& b)
+	{
+		return SameState(a, b) && a.indexCount == b.indexCount &&
+			a.startIndex == b.startIndex && a.baseVertex == b.baseVertex;
+	}
+
+	// Draws are ordered by state, then by mesh (so instances of a mesh are adjacent), then by depth
+	// and by submission. Fields are listed least significant first.
+	static const unsigned int SortFields = 7;
+
+	static void GetSortFields(const DrawBatcher::Draw& draw, unsigned int* fields)
+	{
+		fields[0] = draw.depth;
+		fields[1] = (unsigned int)draw.baseVertex ^ 0x80000000u;
+		fields[2] = draw.indexCount;
+		fields[3] = draw.startIndex;
+		fields[4] = draw.buffers;
+		fields[5] = draw.material;
+		fields[6] = draw.pipeline;
+	}
+
+	void DeferredResources::Add(const void* resource)
+	{
+		if(resource) resources.push_back(resource);
+	}
+
+	bool DeferredResources::Contains(const void* resource)
+	{
+		// Resources added since last lookup are merged in, so repeated lookups are binary searches.
+		if(sortedCount != (unsigned int)resources.size())
+		{
+			std::sort(resources.begin(), resources.end());
+			resources.erase(std::unique(resources.begin(), resources.end()), resources.end());
+			sortedCount = (unsigned int)resources.size();
+		}
+		return std::binary_search(resources.begin(), resources.end(), resource);
+	}
+
+	void DeferredResources::Clear()
+	{
+		resources.clear();
+		sortedCount = 0;
+	}
+
+	unsigned int DrawBatcher::QuantizeDepth(float depth)
+	{
+		if(!(depth > 0.0f)) depth = 0.0f;
+		if(depth > 1.0f) depth = 1.0f;
+		return (unsigned int)(depth * 65535.0f);
+	}
+
+	DrawBatcher::DrawBatcher(unsigned int stride, unsigned int maxInstances)
+		: stride(stride), maxInstances(maxInstances ? maxInstances : 1)
+	{
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	void DrawBatcher::Add(unsigned int pipeline, unsigned int material, unsigned int buffers, float depth,
+		unsigned int indexCount, unsigned int startIndex, int baseVertex, const void* instanceData)
+	{
+		Draw draw;
+		draw.pipeline = pipeline;
+		draw.material = material;
+		draw.buffers = buffers;
+		draw.depth = QuantizeDepth(depth);
+		draw.indexCount = indexCount;
+		draw.startIndex = startIndex;
+		draw.baseVertex = baseVertex;
+		draw.instance = (unsigned int)draws.size();
+		draws.push_back(draw);
+
+		if(stride)
+		{
+			const unsigned char* bytes = (const unsigned char*)instanceData;
+			instances.insert(instances.end(), bytes, bytes + stride);
+		}
+	}
+
+	// LSD radix sort of draw indices, a byte of a field per pass. Sorting is stable and draws start
+	// in submission order, so it breaks ties; bytes all draws share are skipped.
+	void DrawBatcher::Sort()
+	{
+		unsigned int count = (unsigned int)draws.size();
+		order.resize(count);
+		temp.resize(count);
+		fields.resize(count * SortFields);
+
+		const unsigned int Digits = SortFields * 4;
+		unsigned int histograms[Digits][256];
+		memset(histograms, 0, sizeof(histograms));
+		for(unsigned int i = 0; i < count; i++)
+		{
+			unsigned int* f = &fields[i * SortFields];
+			GetSortFields(draws[i], f);
+			for(unsigned int d = 0; d < Digits; d++) histograms[d][(f[d / 4] >> ((d % 4) * 8)) & 0xFF]++;
+			order[i] = i;
+		}
+
+		unsigned int* src = &order[0];
+		unsigned int* dst = &temp[0];
+		for(unsigned int d = 0; d < Digits; d++)
+		{
+			unsigned int field = d / 4, shift = (d % 4) * 8;
+			if(histograms[d][(fields[field] >> shift) & 0xFF] == count) continue;
+
+			unsigned int offsets[256], base = 0;
+			for(unsigned int b = 0; b < 256; b++)
+			{
+				offsets[b] = base;
+				base += histograms[d][b];
+			}
+			for(unsigned int i = 0; i < count; i++)
+			{
+				unsigned int draw = src[i];
+				dst[offsets[(fields[draw * SortFields + field] >> shift) & 0xFF]++] = draw;
+			}
+
+			unsigned int* swap = src; src = dst; dst = swap;
+		}
+		if(src != &order[0]) memcpy(&order[0], src, count * sizeof(unsigned int));
+	}
+
+	bool DrawBatcher::Flush(DrawSink& sink)
+	{
+		memset(&stats, 0, sizeof(stats));
+
+		unsigned int count = (unsigned int)draws.size();
+		stats.draws = count;
+		if(count == 0) return true;
+
+		Sort();
+
+		// Per-object data in submission order, so every batch reads a contiguous range.
+		sortedInstances.resize(count * stride);
+		for(unsigned int i = 0; i < count && stride; i++)
+		{
+			memcpy(&sortedInstances[i * stride], &instances[draws[order[i]].instance * stride], stride);
+		}
+		if(!sink.UploadInstances(stride ? &sortedInstances[0] : 0, count, stride))
+		{
+			// Instances would read stale data, so the flush is dropped.
+			draws.clear();
+			instances.clear();
+			return false;
+		}
+
+		bool first = true;
+		unsigned int pipeline = 0, material = 0, buffers = 0;
+		for(unsigned int i = 0; i < count;)
+		{
+			const Draw& draw = draws[order[i]];
+
+			// Following draws of the same state and mesh are merged.
+			unsigned int j = i + 1;
+			while(j < count && j - i < maxInstances && SameBatch(draw, draws[order[j]])) j++;
+
+			if(first || draw.pipeline != pipeline)
+			{
+				pipeline = draw.pipeline;
+				sink.SetPipeline(pipeline);
+				stats.pipelineChanges++;
+			}
+			if(first || draw.material != material)
+			{
+				material = draw.material;
+				sink.SetMaterial(material);
+				stats.materialChanges++;
+			}
+			if(first || draw.buffers != buffers)
+			{
+				buffers = draw.buffers;
+				sink.SetBuffers(buffers);
+				stats.bufferChanges++;
+			}
+			first = false;
+
+			sink.DrawIndexedInstanced(draw.indexCount, j - i, draw.startIndex, draw.baseVertex, i);
+			stats.batches++;
+			i = j;
+		}
+
+		draws.clear();
+		instances.clear();
+		return true;
+	}
+
+}
+}
+}
+}
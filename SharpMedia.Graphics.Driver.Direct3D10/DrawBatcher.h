@@ -0,0 +1,106 @@
+#pragma once
+#include <vector>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Receives sorted and merged draws from DrawBatcher. State setters are only called
+	// when the state differs from the previous draw.
+	class DrawSink
+	{
+	public:
+		virtual ~DrawSink() {}
+
+		virtual void SetPipeline(unsigned int pipeline) = 0;
+		virtual void SetMaterial(unsigned int material) = 0;
+		virtual void SetBuffers(unsigned int buffers) = 0;
+
+		// Per-instance data of all draws of a flush, in submission order (count * stride bytes).
+		// Returns false if data could not be uploaded; the flush is then not drawn.
+		virtual bool UploadInstances(const void* data, unsigned int count, unsigned int stride) = 0;
+
+		virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+			unsigned int startIndex, int baseVertex, unsigned int startInstance) = 0;
+	};
+
+	// Resources deferred draws read or write. Captured state holds resources and not their
+	// contents, so a resource mapped or updated while deferred draws use it needs them submitted
+	// first.
+	class DeferredResources
+	{
+		std::vector<const void*> resources;
+		unsigned int sortedCount;	//< Leading resources that are sorted and unique.
+	public:
+		DeferredResources() : sortedCount(0) {}
+
+		// Null resources are ignored.
+		void Add(const void* resource);
+		bool Contains(const void* resource);
+		void Clear();
+	};
+
+	struct DrawBatchStats
+	{
+		unsigned int draws;				//< Draws added.
+		unsigned int batches;			//< Draw calls submitted.
+		unsigned int pipelineChanges;
+		unsigned int materialChanges;
+		unsigned int bufferChanges;
+	};
+
+	// Collects indexed draws that differ only in per-object data, sorts them by state and
+	// merges draws of the same mesh and state into instanced draws.
+	class DrawBatcher
+	{
+	public:
+		// Draws sort by pipeline, material, buffers, mesh and depth; ids are compared whole.
+		struct Draw
+		{
+			unsigned int pipeline;
+			unsigned int material;
+			unsigned int buffers;
+			unsigned int depth;			//< Quantized to 16 bits.
+			unsigned int indexCount;
+			unsigned int startIndex;
+			int baseVertex;
+			unsigned int instance;		//< Index of per-object data.
+		};
+
+		static unsigned int QuantizeDepth(float depth);
+
+	private:
+		std::vector<Draw> draws;
+		std::vector<unsigned char> instances;
+		std::vector<unsigned char> sortedInstances;
+		std::vector<unsigned int> order;
+		std::vector<unsigned int> temp;
+		std::vector<unsigned int> fields;	//< Sort fields of draws.
+		unsigned int stride;
+		unsigned int maxInstances;
+		DrawBatchStats stats;
+
+		void Sort();
+	public:
+		// Stride is size of per-object data; maxInstances limits instances per draw call.
+		DrawBatcher(unsigned int stride, unsigned int maxInstances = 0xFFFFFFFF);
+
+		// Adds a draw, per-object data (stride bytes) is copied.
+		void Add(unsigned int pipeline, unsigned int material, unsigned int buffers, float depth,
+			unsigned int indexCount, unsigned int startIndex, int baseVertex, const void* instanceData);
+
+		// Submits all draws in state order and clears them. Returns false (and draws nothing)
+		// if sink failed to upload per-object data.
+		bool Flush(DrawSink& sink);
+
+		// Statistics of last flush.
+		const DrawBatchStats& GetStats() const { return stats; }
+
+		unsigned int GetDrawCount() const { return (unsigned int)draws.size(); }
+	};
+
+}
+}
+}
+}
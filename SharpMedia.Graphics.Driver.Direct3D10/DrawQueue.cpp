@@ -0,0 +1,134 @@
+#include "DrawQueue.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	D3D10DrawQueue::D3D10DrawQueue(ID3D10Device* device)
+		: sink(device)
+	{
+		batcher = 0;
+		batchStride = 0;
+		batchSlot = 0;
+		pipeline = material = buffers = 0;
+		pipelineDirty = materialDirty = buffersDirty = true;
+		memset(targets, 0, sizeof(targets));
+		depthTarget = 0;
+		targetCount = 0;
+	}
+
+	D3D10DrawQueue::~D3D10DrawQueue()
+	{
+		delete batcher;
+	}
+
+	void D3D10DrawQueue::Capture()
+	{
+		if(pipelineDirty) pipeline = sink.CapturePipeline();
+		if(materialDirty) material = sink.CaptureMaterial();
+		if(buffersDirty) buffers = sink.CaptureBuffers();
+		pipelineDirty = materialDirty = buffersDirty = false;
+	}
+
+	bool D3D10DrawQueue::IsEmpty() const
+	{
+		return (!batcher || batcher->GetDrawCount() == 0) && queue.GetCount() == 0;
+	}
+
+	bool D3D10DrawQueue::References(ID3D10Resource* resource)
+	{
+		if(IsEmpty()) return false;
+		if(sink.References(resource)) return true;
+
+		for(unsigned int i = 0; i <= targetCount; i++)
+		{
+			ID3D10View* view = i < targetCount ? (ID3D10View*)targets[i] : (ID3D10View*)depthTarget;
+			if(!view) continue;
+
+			ID3D10Resource* target;
+			view->GetResource(&target);
+			target->Release();
+			if(target == resource) return true;
+		}
+		return false;
+	}
+
+	bool D3D10DrawQueue::SetTargets(unsigned int count, ID3D10RenderTargetView* const* views, ID3D10DepthStencilView* depth)
+	{
+		bool changed = count != targetCount || depth != depthTarget ||
+			memcmp(targets, views, count * sizeof(ID3D10RenderTargetView*)) != 0;
+
+		memcpy(targets, views, count * sizeof(ID3D10RenderTargetView*));
+		depthTarget = depth;
+		targetCount = count;
+		return changed;
+	}
+
+	bool D3D10DrawQueue::AddBatched(unsigned int indexCount, unsigned int startIndex, int baseVertex, float depth,
+		unsigned int instanceSlot, const void* instanceData, unsigned int stride)
+	{
+		bool succeeded = true;
+		if(!batcher || batchStride != stride || batchSlot != instanceSlot)
+		{
+			succeeded = Flush();
+			delete batcher;
+			batcher = new DrawBatcher(stride);
+			batchStride = stride;
+			batchSlot = instanceSlot;
+		}
+
+		Capture();
+		batcher->Add(pipeline, material, buffers, depth, indexCount, startIndex, baseVertex, instanceData);
+		return succeeded;
+	}
+
+	void D3D10DrawQueue::AddQueued(unsigned int indexCount, unsigned int startIndex, int baseVertex,
+		unsigned int layer, bool translucent, float depth)
+	{
+		Capture();
+
+		RenderCommand command;
+		command.pipeline = pipeline;
+		command.material = material;
+		command.buffers = buffers;
+		command.indexCount = indexCount;
+		command.startIndex = startIndex;
+		command.baseVertex = baseVertex;
+		queue.Add(layer, translucent, depth, command);
+	}
+
+	bool D3D10DrawQueue::Flush()
+	{
+		if(IsEmpty()) return true;
+
+		// State owner has bound is restored after the queued draws.
+		Capture();
+		unsigned int current[3] = { pipeline, material, buffers };
+
+		bool succeeded = true;
+		if(batcher)
+		{
+			sink.SetInstanceSlot(batchSlot);
+			succeeded = batcher->Flush(sink);
+			sink.EndInstances();
+		}
+
+		queue.Submit(sink);
+		queue.Clear();
+
+		sink.SetPipeline(current[0]);
+		sink.SetMaterial(current[1]);
+		sink.SetBuffers(current[2]);
+
+		// Ids are per flush, so captured states are not held longer than needed.
+		sink.Reset();
+		pipelineDirty = materialDirty = buffersDirty = true;
+		return succeeded;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <windows.h>
+#include <D3D10.h>
+#include "BatchSink.h"
+#include "DrawBatcher.h"
+#include "RenderQueue.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Draws the device view defers so they can be sorted by state and merged. State a draw depends
+	// on is captured when it is queued, only after the owner invalidated it; render targets,
+	// viewports and stream output are not captured, so the owner flushes before changing them.
+	// Resources read by queued draws must not change until flush, see References.
+	class D3D10DrawQueue
+	{
+		D3D10BatchSink sink;
+		RenderQueue queue;
+		DrawBatcher* batcher;
+		unsigned int batchStride;
+		unsigned int batchSlot;
+
+		// Targets draws were queued for; only compared, so no references are held.
+		ID3D10RenderTargetView* targets[D3D10_SIMULTANEOUS_RENDER_TARGET_COUNT];
+		ID3D10DepthStencilView* depthTarget;
+		unsigned int targetCount;
+
+		// Ids of current device state, valid if not dirty.
+		unsigned int pipeline, material, buffers;
+		bool pipelineDirty, materialDirty, buffersDirty;
+
+		void Capture();
+	public:
+		D3D10DrawQueue(ID3D10Device* device);
+		~D3D10DrawQueue();
+
+		// Device state of a group was changed by owner.
+		void InvalidatePipeline() { pipelineDirty = true; }
+		void InvalidateMaterial() { materialDirty = true; }
+		void InvalidateBuffers() { buffersDirty = true; }
+
+		bool IsEmpty() const;
+
+		// Whether queued draws read or render to resource; owner flushes before it is mapped.
+		bool References(ID3D10Resource* resource);
+
+		// Records targets owner binds; returns true if they differ from previous ones, the owner
+		// must then flush before binding them.
+		bool SetTargets(unsigned int count, ID3D10RenderTargetView* const* views, ID3D10DepthStencilView* depth);
+
+		// Queues a draw with per-object data (stride bytes) read at instance slot. Draws of another
+		// stride or slot flush first; returns false if that flush failed.
+		bool AddBatched(unsigned int indexCount, unsigned int startIndex, int baseVertex, float depth,
+			unsigned int instanceSlot, const void* instanceData, unsigned int stride);
+
+		// Queues a draw sorted by layer, translucency, state and depth.
+		void AddQueued(unsigned int indexCount, unsigned int startIndex, int baseVertex,
+			unsigned int layer, bool translucent, float depth);
+
+		// Submits batched draws, then queued ones, and restores current state. Returns false if per-object data could
+		// not be uploaded, queued draws are then dropped.
+		bool Flush();
+	};
+
+}
+}
+}
+}
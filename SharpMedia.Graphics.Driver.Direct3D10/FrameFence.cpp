@@ -0,0 +1,96 @@
+#include "FrameFence.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	D3D10PacingClock::D3D10PacingClock()
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		period = 1.0 / (double)frequency.QuadPart;
+	}
+
+	double D3D10PacingClock::Now()
+	{
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return (double)counter.QuadPart * period;
+	}
+
+	void D3D10PacingClock::Sleep(double seconds)
+	{
+		DWORD ms = (DWORD)(seconds * 1000.0);
+		if(ms == 0) SwitchToThread();
+		else ::Sleep(ms);
+	}
+
+	D3D10FrameFence::D3D10FrameFence(ID3D10Device* device)
+	{
+		this->device = device;
+		device->AddRef();
+		finish = 0;
+	}
+
+	D3D10FrameFence::~D3D10FrameFence()
+	{
+		for(size_t i = 0; i < queries.size(); i++)
+		{
+			if(queries[i]) queries[i]->Release();
+		}
+		if(finish) finish->Release();
+		device->Release();
+	}
+
+	ID3D10Query* D3D10FrameFence::CreateEventQuery()
+	{
+		D3D10_QUERY_DESC desc;
+		desc.Query = D3D10_QUERY_EVENT;
+		desc.MiscFlags = 0;
+
+		ID3D10Query* query = 0;
+		if(FAILED(device->CreateQuery(&desc, &query))) return 0;
+		return query;
+	}
+
+	void D3D10FrameFence::Issue(unsigned int slot)
+	{
+		if(slot >= queries.size()) queries.resize(slot + 1, 0);
+		if(!queries[slot]) queries[slot] = CreateEventQuery();
+		if(queries[slot]) queries[slot]->End();
+	}
+
+	bool D3D10FrameFence::IsDone(unsigned int slot)
+	{
+		// A query that could not be created never blocks.
+		if(slot >= queries.size() || !queries[slot]) return true;
+
+		// Flushing is needed, event may still be in the command buffer when waited on.
+		// Errors (device removed) count as done so waiting cannot hang.
+		BOOL done = FALSE;
+		return queries[slot]->GetData(&done, sizeof(done), 0) != S_FALSE;
+	}
+
+	void D3D10FrameFence::Finish()
+	{
+		if(!finish) finish = CreateEventQuery();
+		if(!finish)
+		{
+			device->Flush();
+			return;
+		}
+
+		finish->End();
+
+		BOOL done = FALSE;
+		while(finish->GetData(&done, sizeof(done), 0) == S_FALSE)
+		{
+			SwitchToThread();
+		}
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <windows.h>
+#include <D3D10.h>
+#include <vector>
+#include "FramePacer.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Performance counter clock; sleeping has scheduler granularity, pacer spins the rest.
+	class D3D10PacingClock : public PacingClock
+	{
+		double period;
+	public:
+		D3D10PacingClock();
+
+		virtual double Now();
+		virtual void Sleep(double seconds);
+	};
+
+	// Event queries issued at end of frames.
+	class D3D10FrameFence : public PacingFence
+	{
+		ID3D10Device* device;
+		std::vector<ID3D10Query*> queries;
+		ID3D10Query* finish;
+
+		ID3D10Query* CreateEventQuery();
+	public:
+		D3D10FrameFence(ID3D10Device* device);
+		virtual ~D3D10FrameFence();
+
+		virtual void Issue(unsigned int slot);
+		virtual bool IsDone(unsigned int slot);
+
+		// Blocks until all submitted commands are executed.
+		void Finish();
+	};
+
+}
+}
+}
+}
@@ -0,0 +1,155 @@
+#include "FramePacer.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Sleeps shorter than this are spun, clocks rarely wake up in time for them.
+	static const double PacingMinSleep = 0.001;
+
+	// Waiting on GPU yields for this long before it starts sleeping.
+	static const double PacingSpinTime = 0.0005;
+	static const double PacingWaitSleep = 0.001;
+
+	FramePacer::FramePacer(PacingClock* clock, PacingFence* fence, const FramePacerSettings& settings)
+	{
+		this->clock = clock;
+		this->fence = fence;
+		this->frame = 0;
+		this->inFrame = false;
+		memset(&stats, 0, sizeof(stats));
+
+		this->frameBegin = this->workBegin = this->lastEnd = clock->Now();
+		this->lastCompletion = -1.0;
+
+		SetSettings(settings);
+	}
+
+	void FramePacer::SetSettings(const FramePacerSettings& s)
+	{
+		unsigned int count = s.maxFramesInFlight < 1 ? 1 : s.maxFramesInFlight;
+		if(count != slots.size())
+		{
+			// Slots map to frames by modulo, so all outstanding frames must finish first.
+			for(size_t i = 0; i < slots.size(); i++) WaitForSlot(slots[i]);
+
+			Slot empty;
+			empty.issued = false;
+			empty.done = true;
+			slots.assign(count, empty);
+		}
+
+		settings = s;
+		settings.maxFramesInFlight = count;
+		if(settings.syncInterval > 4) settings.syncInterval = 4;
+		if(!(settings.targetFrameTime > 0.0)) settings.targetFrameTime = 0.0;
+	}
+
+	void FramePacer::Poll()
+	{
+		unsigned int completed = 0;
+		for(size_t i = 0; i < slots.size(); i++)
+		{
+			Slot& slot = slots[i];
+			if(!slot.issued || slot.done) continue;
+			if(!fence->IsDone((unsigned int)i)) continue;
+
+			slot.done = true;
+			completed++;
+		}
+		if(completed == 0) return;
+
+		// Several frames seen at once share the interval.
+		double now = clock->Now();
+		if(lastCompletion >= 0.0) stats.gpuTime = (now - lastCompletion) / (double)completed;
+		lastCompletion = now;
+	}
+
+	void FramePacer::WaitForSlot(Slot& slot)
+	{
+		if(!slot.issued || slot.done) return;
+
+		unsigned int index = (unsigned int)(&slot - &slots[0]);
+		double begin = clock->Now();
+		while(!fence->IsDone(index))
+		{
+			clock->Sleep(clock->Now() - begin < PacingSpinTime ? 0.0 : PacingWaitSleep);
+		}
+		Poll();
+	}
+
+	void FramePacer::BeginFrame()
+	{
+		if(inFrame) EndFrame();
+
+		Poll();
+
+		// Slot of this frame was last used maxFramesInFlight frames ago.
+		double waitBegin = clock->Now();
+		WaitForSlot(slots[frame % slots.size()]);
+		double now = clock->Now();
+		stats.waitTime = now - waitBegin;
+
+		stats.sleepTime = 0.0;
+		double target = settings.targetFrameTime;
+		double deadline = frameBegin + target;
+		if(target > 0.0 && now < deadline)
+		{
+			double sleepBegin = now;
+			double request = deadline - now - stats.sleepOvershoot;
+			if(request >= PacingMinSleep)
+			{
+				clock->Sleep(request);
+				now = clock->Now();
+
+				// Estimate rises quickly after late wake ups and falls slowly.
+				double overshoot = (now - sleepBegin) - request;
+				if(overshoot < 0.0) overshoot = 0.0;
+				double rate = overshoot > stats.sleepOvershoot ? 0.5 : 0.05;
+				stats.sleepOvershoot += (overshoot - stats.sleepOvershoot) * rate;
+			}
+
+			// Rest is spun for precision.
+			while(now < deadline)
+			{
+				clock->Sleep(0.0);
+				now = clock->Now();
+			}
+			stats.sleepTime = now - sleepBegin;
+		}
+
+		// Frames stay on the target grid; a frame late by more than a whole frame does not
+		// make following frames run faster to catch up.
+		frameBegin = (target > 0.0 && now - deadline < target) ? deadline : now;
+		workBegin = now;
+		inFrame = true;
+	}
+
+	void FramePacer::EndFrame()
+	{
+		double now = clock->Now();
+		if(inFrame) stats.cpuTime = now - workBegin;
+
+		stats.frameTime = now - lastEnd;
+		stats.averageFrameTime = stats.frames == 0 ? stats.frameTime :
+			stats.averageFrameTime + (stats.frameTime - stats.averageFrameTime) * 0.1;
+		lastEnd = now;
+
+		Slot& slot = slots[frame % slots.size()];
+		fence->Issue((unsigned int)(frame % slots.size()));
+		slot.issued = true;
+		slot.done = false;
+
+		frame++;
+		stats.frames = frame;
+		inFrame = false;
+
+		Poll();
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <vector>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Time source of pacer; simulated clock is used to test pacing without a device.
+	class PacingClock
+	{
+	public:
+		virtual ~PacingClock() {}
+
+		// Seconds from arbitrary origin.
+		virtual double Now() = 0;
+
+		// Sleeps at least given seconds (may oversleep), zero only yields.
+		virtual void Sleep(double seconds) = 0;
+	};
+
+	// Marks end of GPU work of a frame.
+	class PacingFence
+	{
+	public:
+		virtual ~PacingFence() {}
+
+		// Issued after frame is submitted, slot is reused when frame is done.
+		virtual void Issue(unsigned int slot) = 0;
+
+		// Must not block.
+		virtual bool IsDone(unsigned int slot) = 0;
+	};
+
+	struct FramePacerSettings
+	{
+		unsigned int syncInterval;		//< Vertical blanks per present, 0 disables vsync.
+		unsigned int maxFramesInFlight;	//< Frames queued or being built at once, 1 does not overlap CPU and GPU.
+		double targetFrameTime;			//< Seconds, 0 does not limit frame rate.
+	};
+
+	struct FramePacerStats
+	{
+		unsigned long long frames;
+		double cpuTime;					//< Seconds of work between begin and end of frame.
+		double gpuTime;					//< Interval between observed GPU frame completions.
+		double frameTime;				//< Interval between ends of frames.
+		double waitTime;				//< Time blocked on frames in flight.
+		double sleepTime;				//< Time slept to reach target frame time.
+		double averageFrameTime;		//< Smoothed frame time.
+		double sleepOvershoot;			//< Estimated oversleep of clock.
+	};
+
+	// Paces frames of a swap chain. Begin of frame blocks until the GPU is at most
+	// maxFramesInFlight frames behind, then sleeps until target frame time is reached.
+	// Sleeping before the frame rather than after present keeps input latency low.
+	class FramePacer
+	{
+		struct Slot
+		{
+			bool issued;
+			bool done;
+		};
+
+		PacingClock* clock;
+		PacingFence* fence;
+		FramePacerSettings settings;
+		FramePacerStats stats;
+		std::vector<Slot> slots;
+		unsigned long long frame;
+		double frameBegin;				//< Scheduled begin of current frame.
+		double workBegin;				//< Actual begin, after waiting.
+		double lastEnd;
+		double lastCompletion;
+		bool inFrame;
+
+		void Poll();
+		void WaitForSlot(Slot& slot);
+	public:
+		FramePacer(PacingClock* clock, PacingFence* fence, const FramePacerSettings& settings);
+
+		// Number of frames in flight may grow, fence must accept slots up to new maximum.
+		void SetSettings(const FramePacerSettings& settings);
+		const FramePacerSettings& GetSettings() const { return settings; }
+
+		void BeginFrame();
+
+		// Called after present.
+		void EndFrame();
+
+		const FramePacerStats& GetStats() const { return stats; }
+	};
+
+}
+}
+}
+}
@@ -0,0 +1,284 @@
+#include "GpuProfiler.h"
+#include <cstring>
+#include <cstdio>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	GpuProfiler::GpuProfiler(GpuQueryBackend* backend, unsigned int latency, unsigned int maxHistory)
+	{
+		this->backend = backend;
+		this->maxHistory = maxHistory;
+		this->frame = 0;
+		this->oldest = 0;
+		this->dropped = 0;
+		this->inFrame = false;
+
+		slots.resize(latency < 2 ? 2 : latency);
+		for(size_t i = 0; i < slots.size(); i++)
+		{
+			Slot& slot = slots[i];
+			slot.pending = false;
+			slot.frame = 0;
+			slot.disjoint = backend->Create(GpuQueryDisjoint);
+			slot.usedTimestamps = slot.usedStatistics = slot.usedOcclusions = 0;
+			slot.frameBegin = slot.frameEnd = 0;
+		}
+	}
+
+	GpuProfiler::~GpuProfiler()
+	{
+		for(size_t i = 0; i < slots.size(); i++)
+		{
+			Slot& slot = slots[i];
+			backend->Destroy(slot.disjoint);
+			for(size_t j = 0; j < slot.timestamps.size(); j++) backend->Destroy(slot.timestamps[j]);
+			for(size_t j = 0; j < slot.statistics.size(); j++) backend->Destroy(slot.statistics[j]);
+			for(size_t j = 0; j < slot.occlusions.size(); j++) backend->Destroy(slot.occlusions[j]);
+		}
+	}
+
+	unsigned int GpuProfiler::Acquire(Slot& slot, GpuQueryType type)
+	{
+		std::vector<unsigned int>* pool;
+		unsigned int* used;
+		switch(type)
+		{
+		case GpuQueryTimestamp:
+			pool = &slot.timestamps; used = &slot.usedTimestamps; break;
+		case GpuQueryPipelineStatistics:
+			pool = &slot.statistics; used = &slot.usedStatistics; break;
+		default:
+			pool = &slot.occlusions; used = &slot.usedOcclusions; break;
+		}
+
+		if(*used == pool->size()) pool->push_back(backend->Create(type));
+		return (*pool)[(*used)++];
+	}
+
+	void GpuProfiler::BeginFrame()
+	{
+		if(inFrame) EndFrame();
+
+		Update();
+
+		Slot& slot = slots[frame % slots.size()];
+		if(slot.pending)
+		{
+			// Results did not arrive in time, slot is needed again.
+			slot.pending = false;
+			dropped++;
+			oldest = slot.frame + 1;
+		}
+
+		slot.frame = frame;
+		slot.scopes.clear();
+		slot.usedTimestamps = slot.usedStatistics = slot.usedOcclusions = 0;
+
+		backend->Begin(slot.disjoint);
+		slot.frameBegin = Acquire(slot, GpuQueryTimestamp);
+		backend->End(slot.frameBegin);
+
+		stack.clear();
+		inFrame = true;
+	}
+
+	void GpuProfiler::EndFrame()
+	{
+		if(!inFrame) return;
+
+		while(!stack.empty()) EndScope();
+
+		Slot& slot = slots[frame % slots.size()];
+		slot.frameEnd = Acquire(slot, GpuQueryTimestamp);
+		backend->End(slot.frameEnd);
+		backend->End(slot.disjoint);
+		slot.pending = true;
+
+		inFrame = false;
+		frame++;
+	}
+
+	void GpuProfiler::BeginScope(const char* name, unsigned int flags)
+	{
+		if(!inFrame) return;
+
+		Slot& slot = slots[frame % slots.size()];
+
+		Scope scope;
+		scope.name = name;
+		scope.depth = (unsigned int)stack.size();
+		scope.parent = stack.empty() ? -1 : stack.back();
+		scope.flags = flags;
+		scope.begin = Acquire(slot, GpuQueryTimestamp);
+		scope.end = 0;
+		scope.statistics = (flags & GpuScopeStatistics) ? Acquire(slot, GpuQueryPipelineStatistics) : 0;
+		scope.occlusion = (flags & GpuScopeOcclusion) ? Acquire(slot, GpuQueryOcclusion) : 0;
+
+		backend->End(scope.begin);
+		if(flags & GpuScopeStatistics) backend->Begin(scope.statistics);
+		if(flags & GpuScopeOcclusion) backend->Begin(scope.occlusion);
+
+		stack.push_back((int)slot.scopes.size());
+		slot.scopes.push_back(scope);
+	}
+
+	void GpuProfiler::EndScope()
+	{
+		if(!inFrame || stack.empty()) return;
+
+		Slot& slot = slots[frame % slots.size()];
+		Scope& scope = slot.scopes[stack.back()];
+		stack.pop_back();
+
+		if(scope.flags & GpuScopeOcclusion) backend->End(scope.occlusion);
+		if(scope.flags & GpuScopeStatistics) backend->End(scope.statistics);
+		scope.end = Acquire(slot, GpuQueryTimestamp);
+		backend->End(scope.end);
+	}
+
+	bool GpuProfiler::Resolve(Slot& slot)
+	{
+		GpuDisjointData disjoint;
+		if(!backend->GetData(slot.disjoint, &disjoint, sizeof(disjoint))) return false;
+
+		// Disjoint query is last to finish, but other results still must be checked.
+		GpuFrameResult result;
+		result.frame = slot.frame;
+		result.frequency = disjoint.frequency;
+
+		unsigned long long end;
+		if(!backend->GetData(slot.frameBegin, &result.start, sizeof(result.start)) ||
+		   !backend->GetData(slot.frameEnd, &end, sizeof(end))) return false;
+
+		if(disjoint.disjoint || disjoint.frequency == 0)
+		{
+			// Timestamps are not reliable.
+			slot.pending = false;
+			dropped++;
+			return true;
+		}
+
+		double scale = 1000.0 / (double)disjoint.frequency;
+		result.duration = (double)(end - result.start) * scale;
+
+		result.scopes.resize(slot.scopes.size());
+		for(size_t i = 0; i < slot.scopes.size(); i++)
+		{
+			const Scope& scope = slot.scopes[i];
+			GpuScopeResult& r = result.scopes[i];
+
+			unsigned long long begin = 0, finish = 0;
+			if(!backend->GetData(scope.begin, &begin, sizeof(begin)) ||
+			   !backend->GetData(scope.end, &finish, sizeof(finish))) return false;
+
+			r.name = scope.name;
+			r.depth = scope.depth;
+			r.parent = scope.parent;
+			r.begin = (double)(begin - result.start) * scale;
+			r.end = (double)(finish - result.start) * scale;
+
+			r.hasStatistics = (scope.flags & GpuScopeStatistics) != 0;
+			memset(&r.statistics, 0, sizeof(r.statistics));
+			if(r.hasStatistics &&
+			   !backend->GetData(scope.statistics, &r.statistics, sizeof(r.statistics))) return false;
+
+			r.hasOcclusion = (scope.flags & GpuScopeOcclusion) != 0;
+			r.samples = 0;
+			if(r.hasOcclusion &&
+			   !backend->GetData(scope.occlusion, &r.samples, sizeof(r.samples))) return false;
+		}
+
+		slot.pending = false;
+		history.push_back(result);
+		while(history.size() > maxHistory) history.pop_front();
+		return true;
+	}
+
+	void GpuProfiler::Update()
+	{
+		// Frames are resolved in order, a frame that is not ready blocks newer ones.
+		for(; oldest < frame; oldest++)
+		{
+			Slot& slot = slots[oldest % slots.size()];
+			if(!slot.pending || slot.frame != oldest) continue;
+			if(!Resolve(slot)) break;
+		}
+	}
+
+	static void WriteEscaped(std::ostream& stream, const std::string& text)
+	{
+		for(size_t i = 0; i < text.size(); i++)
+		{
+			char c = text[i];
+			if(c == '"' || c == '\\')
+			{
+				stream << '\\' << c;
+			} else if((unsigned char)c < 0x20) {
+				char buffer[8];
+				sprintf(buffer, "\\u%04x", (unsigned int)(unsigned char)c);
+				stream << buffer;
+			} else {
+				stream << c;
+			}
+		}
+	}
+
+	void GpuProfiler::WriteChromeTrace(std::ostream& stream) const
+	{
+		stream << "{\"traceEvents\":[";
+
+		bool first = true;
+		unsigned long long origin = history.empty() ? 0 : history.front().start;
+		for(size_t f = 0; f < history.size(); f++)
+		{
+			const GpuFrameResult& frame = history[f];
+			double start = (double)(frame.start - origin) * 1000000.0 / (double)frame.frequency;
+
+			// Whole frame is the top event, times are in microseconds.
+			char buffer[128];
+			sprintf(buffer, "\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f", start,
+				frame.duration * 1000.0);
+			stream << (first ? "" : ",") << "\n{\"name\":\"Frame " << frame.frame << "\"," << buffer << "}";
+			first = false;
+
+			for(size_t i = 0; i < frame.scopes.size(); i++)
+			{
+				const GpuScopeResult& scope = frame.scopes[i];
+				sprintf(buffer, "\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f",
+					start + scope.begin * 1000.0, (scope.end - scope.begin) * 1000.0);
+
+				stream << ",\n{\"name\":\"";
+				WriteEscaped(stream, scope.name);
+				stream << "\"," << buffer;
+
+				if(scope.hasStatistics || scope.hasOcclusion)
+				{
+					stream << ",\"args\":{";
+					if(scope.hasStatistics)
+					{
+						const GpuPipelineStatistics& s = scope.statistics;
+						stream << "\"IAVertices\":" << s.iaVertices << ",\"IAPrimitives\":" << s.iaPrimitives
+							<< ",\"VSInvocations\":" << s.vsInvocations << ",\"GSInvocations\":" << s.gsInvocations
+							<< ",\"GSPrimitives\":" << s.gsPrimitives << ",\"CInvocations\":" << s.clipInvocations
+							<< ",\"CPrimitives\":" << s.clipPrimitives << ",\"PSInvocations\":" << s.psInvocations;
+					}
+					if(scope.hasOcclusion)
+					{
+						stream << (scope.hasStatistics ? "," : "") << "\"Samples\":" << scope.samples;
+					}
+					stream << "}";
+				}
+				stream << "}";
+			}
+		}
+
+		stream << "\n]}\n";
+	}
+
+}
+}
+}
+}
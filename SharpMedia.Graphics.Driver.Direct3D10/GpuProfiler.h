@@ -0,0 +1,163 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <ostream>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	enum GpuQueryType
+	{
+		GpuQueryDisjoint,			//< Result is GpuDisjointData.
+		GpuQueryTimestamp,			//< Result is unsigned long long ticks, only End is used.
+		GpuQueryPipelineStatistics,	//< Result is GpuPipelineStatistics.
+		GpuQueryOcclusion			//< Result is unsigned long long samples.
+	};
+
+	struct GpuDisjointData
+	{
+		unsigned long long frequency;
+		int disjoint;
+	};
+
+	struct GpuPipelineStatistics
+	{
+		unsigned long long iaVertices;
+		unsigned long long iaPrimitives;
+		unsigned long long vsInvocations;
+		unsigned long long gsInvocations;
+		unsigned long long gsPrimitives;
+		unsigned long long clipInvocations;
+		unsigned long long clipPrimitives;
+		unsigned long long psInvocations;
+	};
+
+	// Queries of a device. GetData must not block; it returns false until the result is ready.
+	class GpuQueryBackend
+	{
+	public:
+		virtual ~GpuQueryBackend() {}
+
+		virtual unsigned int Create(GpuQueryType type) = 0;
+		virtual void Destroy(unsigned int query) = 0;
+		virtual void Begin(unsigned int query) = 0;
+		virtual void End(unsigned int query) = 0;
+		virtual bool GetData(unsigned int query, void* data, unsigned int size) = 0;
+	};
+
+	enum GpuScopeFlags
+	{
+		GpuScopeTiming = 0,
+		GpuScopeStatistics = 1,
+		GpuScopeOcclusion = 2
+	};
+
+	struct GpuScopeResult
+	{
+		std::string name;
+		unsigned int depth;
+		int parent;					//< Index of parent scope in frame, -1 for top level.
+		double begin;				//< Milliseconds from start of frame.
+		double end;
+		bool hasStatistics;
+		GpuPipelineStatistics statistics;
+		bool hasOcclusion;
+		unsigned long long samples;
+	};
+
+	struct GpuFrameResult
+	{
+		unsigned long long frame;
+		unsigned long long frequency;
+		unsigned long long start;	//< Ticks of frame start.
+		double duration;			//< Milliseconds.
+		std::vector<GpuScopeResult> scopes;
+	};
+
+	// Times nested named scopes of frames on the GPU. Queries of a frame are kept in a ring
+	// slot and read back a few frames later, so reading results never waits for the GPU.
+	class GpuProfiler
+	{
+		struct Scope
+		{
+			std::string name;
+			unsigned int depth;
+			int parent;
+			unsigned int flags;
+			unsigned int begin, end;	//< Timestamp queries.
+			unsigned int statistics;
+			unsigned int occlusion;
+		};
+
+		struct Slot
+		{
+			bool pending;
+			unsigned long long frame;
+			unsigned int disjoint;
+			unsigned int frameBegin, frameEnd;
+			std::vector<Scope> scopes;
+
+			// Query pools, reused every time slot is used.
+			std::vector<unsigned int> timestamps, statistics, occlusions;
+			unsigned int usedTimestamps, usedStatistics, usedOcclusions;
+		};
+
+		GpuQueryBackend* backend;
+		std::vector<Slot> slots;
+		std::vector<int> stack;
+		std::deque<GpuFrameResult> history;
+		unsigned int maxHistory;
+		unsigned long long frame;
+		unsigned long long oldest;	//< Oldest frame not yet resolved.
+		unsigned int dropped;
+		bool inFrame;
+
+		unsigned int Acquire(Slot& slot, GpuQueryType type);
+		bool Resolve(Slot& slot);
+	public:
+		// Latency is number of frames in flight before results are read.
+		GpuProfiler(GpuQueryBackend* backend, unsigned int latency = 3, unsigned int maxHistory = 120);
+		~GpuProfiler();
+
+		void BeginFrame();
+		void EndFrame();
+
+		// Scopes nest; flags are GpuScopeFlags.
+		void BeginScope(const char* name, unsigned int flags = GpuScopeTiming);
+		void EndScope();
+
+		// Reads back all finished frames, never waits.
+		void Update();
+
+		// Frames whose results were lost (disjoint or slot reused before ready).
+		unsigned int GetDroppedFrames() const { return dropped; }
+
+		// Resolved frames, oldest first.
+		const std::deque<GpuFrameResult>& GetHistory() const { return history; }
+		const GpuFrameResult* GetLastFrame() const { return history.empty() ? 0 : &history.back(); }
+
+		// Writes history in Chrome trace event format (chrome://tracing).
+		void WriteChromeTrace(std::ostream& stream) const;
+	};
+
+	// Scope that ends when leaving block.
+	class GpuProfileScope
+	{
+		GpuProfiler& profiler;
+	public:
+		GpuProfileScope(GpuProfiler& profiler, const char* name, unsigned int flags = GpuScopeTiming)
+			: profiler(profiler)
+		{
+			profiler.BeginScope(name, flags);
+		}
+
+		~GpuProfileScope() { profiler.EndScope(); }
+	};
+
+}
+}
+}
+}
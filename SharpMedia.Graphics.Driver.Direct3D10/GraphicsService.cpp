@@ -50,22 +50,13 @@ namespace Direct3D10 {
 			//throw gcnew Exception("Window registration failed.");
 		}
 
-		// Create window.
-		
-		RECT rc = { 0, 0, params->BackBufferWidth, params->BackBufferHeight };
-		AdjustWindowRect( &rc, WS_OVERLAPPEDWINDOW, FALSE );
-		HWND hWnd = CreateWindow( L"D3D10WindowClass", L"D3D10 Window", WS_OVERLAPPEDWINDOW,
-							   CW_USEDEFAULT, CW_USEDEFAULT, rc.right - rc.left, rc.bottom - rc.top, NULL, NULL,
-							   instance, NULL);
-
-		if(!hWnd)
+		// Create window, its messages are processed on its own thread.
+		WindowThread* windowThread = StartWindowThread(params->BackBufferWidth, params->BackBufferHeight);
+		if(!windowThread)
 		{
 			throw gcnew Exception("Window creation failed");
 		}
-
-		ShowWindow( hWnd, SW_SHOW );
-
-		ShowCursor(FALSE);
+		HWND hWnd = windowThread->hWnd;
 
 		// Create device & swap chain.
 
@@ -94,6 +85,7 @@ namespace Direct3D10 {
 		// We craete device.
 		if(FAILED(CreateDXGIFactory(__uuidof(IDXGIFactory), (void**)&pDXGIFactory)))
 		{
+			StopWindowThread(windowThread);
 			throw gcnew Exception("DX10 factory creation failed.");
 		}
 
@@ -128,12 +120,13 @@ namespace Direct3D10 {
 			debug ? D3D10_CREATE_DEVICE_DEBUG : 0, D3D10_SDK_VERSION,
 									&swapChainDesc, &swapChain, &pDevice)))
 		{	
+			StopWindowThread(windowThread);
 			throw gcnew Exception("Device creation failed.");
 		}
 
 		device = pDevice;
 		
-		window = gcnew D3D10WindowBackend(hWnd);
+		window = gcnew D3D10WindowBackend(windowThread);
 		chain = gcnew D3D10SwapChain(swapChain, device);
 
 		return device;
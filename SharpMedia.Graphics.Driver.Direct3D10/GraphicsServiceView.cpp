@@ -2,6 +2,7 @@
 #include "GraphicsService.h"
 #include "GraphicsServiceView.h"
 #include "DeviceView.h"
+#include "SwapChain.h"
 
 
 namespace SharpMedia {
@@ -26,7 +27,12 @@ namespace Direct3D10 {
 		bool tmp = owner;
 		try {
 			owner = true;
-			return gcnew D3D10DeviceView(service->CreateDevice(shared, parameters, window, chain, debug), service);
+			D3D10DeviceView^ view = gcnew D3D10DeviceView(service->CreateDevice(shared, parameters, window, chain, debug), service);
+
+			// Swap chain submits draws deferred by view before it presents or resizes.
+			D3D10SwapChain^ swapChain = dynamic_cast<D3D10SwapChain^>(chain);
+			if(swapChain) swapChain->view = view;
+			return view;
 		} catch(Exception^ ex)
 		{
 			owner = tmp;
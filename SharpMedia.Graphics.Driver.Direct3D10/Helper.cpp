@@ -155,6 +155,12 @@ namespace Direct3D10 {
 	  } else if(component == PinComponent::RenderTarget7)
 	  {
 		return "SV_Target7";
+	  } else if(component == PinComponent::RenderTargetArrayIndex)
+	  {
+		return "SV_RenderTargetArrayIndex";
+	  } else if(component == PinComponent::ViewportArrayIndex)
+	  {
+		return "SV_ViewportArrayIndex";
 	  } else if(component == PinComponent::User0)
 	  {
 		return "NSV_User0_";
@@ -195,8 +201,46 @@ namespace Direct3D10 {
 
    std::string ToDXValue(PinFormat format, Object^ data)
    {
+		// Arrays are initializer lists.
+		Array^ elements = dynamic_cast<Array^>(data);
+		if(elements != nullptr)
+		{
+			std::string s = "{";
+			for(int i = 0; i < elements->Length; i++)
+			{
+				if(i > 0) s += ",";
+				s += ToDXValue(format, elements->GetValue(i));
+			}
+			s += "}";
+			return s;
+		}
+
 		switch(format)
 		{
+		case PinFormat::Bool:
+			return *((Boolean^)data) ? "true" : "false";
+		case PinFormat::Float2x2:
+		case PinFormat::Float3x3:
+		case PinFormat::Float4x4:
+			{
+				unsigned int n = format == PinFormat::Float2x2 ? 2 : (format == PinFormat::Float3x3 ? 3 : 4);
+				std::string s = "float" + ConvToString((int)n) + "x" + ConvToString((int)n) + "(";
+				for(unsigned int row = 0; row < n; row++)
+				{
+					for(unsigned int col = 0; col < n; col++)
+					{
+						if(row + col > 0) s += ",";
+						switch(n)
+						{
+						case 2: s += ConvToString(((Matrix::Matrix2x2f^)data)->default[row, col]); break;
+						case 3: s += ConvToString(((Matrix::Matrix3x3f^)data)->default[row, col]); break;
+						default: s += ConvToString(((Matrix::Matrix4x4f^)data)->default[row, col]); break;
+						}
+					}
+				}
+				s += ")";
+				return s;
+			}
 		case PinFormat::Floatx4:
 			{
 				Vector4f v = *((Vector4f^)data);
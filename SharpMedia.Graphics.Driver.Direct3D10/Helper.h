@@ -348,6 +348,29 @@ namespace Direct3D10 {
 		}
    }
 
+   // Stream output writes 32-bit components only.
+   inline static bool IsStreamOutputFormat(PinFormat fmt)
+   {
+		switch(fmt)
+		{
+		case PinFormat::Float:
+		case PinFormat::Floatx2:
+		case PinFormat::Floatx3:
+		case PinFormat::Floatx4:
+		case PinFormat::Integer:
+		case PinFormat::Integerx2:
+		case PinFormat::Integerx3:
+		case PinFormat::Integerx4:
+		case PinFormat::UInteger:
+		case PinFormat::UIntegerx2:
+		case PinFormat::UIntegerx3:
+		case PinFormat::UIntegerx4:
+			return true;
+		default:
+			return false;
+		}
+   }
+
    inline static unsigned int ToDXBindFlags(BufferUsage usage)
    {
 		unsigned int flags = 0;
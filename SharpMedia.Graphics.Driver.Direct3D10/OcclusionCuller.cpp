@@ -0,0 +1,151 @@
+#include "OcclusionCuller.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	OcclusionCuller::OcclusionCuller(OcclusionDevice* device, unsigned int interval)
+	{
+		this->device = device;
+		this->interval = interval ? interval : 1;
+		this->frame = 0;
+		this->predicating = false;
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	OcclusionCuller::~OcclusionCuller()
+	{
+		for(size_t i = 0; i < objects.size(); i++)
+		{
+			if(objects[i].used) device->DestroyPredicate(objects[i].predicate);
+		}
+	}
+
+	unsigned int OcclusionCuller::Add()
+	{
+		Object object;
+		object.used = true;
+		object.visible = true;
+		object.pending = false;
+		object.predicate = device->CreatePredicate();
+
+		if(!freeObjects.empty())
+		{
+			unsigned int id = freeObjects.back();
+			freeObjects.pop_back();
+			objects[id] = object;
+			return id;
+		}
+
+		objects.push_back(object);
+		return (unsigned int)objects.size() - 1;
+	}
+
+	void OcclusionCuller::Remove(unsigned int id)
+	{
+		if(!objects[id].used) return;
+
+		device->DestroyPredicate(objects[id].predicate);
+		objects[id].used = false;
+		freeObjects.push_back(id);
+	}
+
+	bool OcclusionCuller::Due(unsigned int id, const Object& object) const
+	{
+		if(object.pending) return false;
+		if(!object.visible) return true;
+
+		// Staggered so retests of visible objects are spread over frames.
+		return (frame + id) % interval == 0;
+	}
+
+	void OcclusionCuller::BeginFrame()
+	{
+		memset(&stats, 0, sizeof(stats));
+
+		for(size_t i = 0; i < objects.size(); i++)
+		{
+			Object& object = objects[i];
+			if(!object.used) continue;
+			stats.objects++;
+
+			if(!object.pending) continue;
+
+			// Until result arrives last visibility is kept.
+			int result = device->GetResult(object.predicate);
+			if(result < 0) continue;
+
+			object.visible = result != 0;
+			object.pending = false;
+		}
+	}
+
+	void OcclusionCuller::IssueTests()
+	{
+		for(size_t i = 0; i < objects.size(); i++)
+		{
+			Object& object = objects[i];
+			if(!object.used || !Due((unsigned int)i, object)) continue;
+
+			// Nothing to test, an empty query would hide the object.
+			if(!device->HasProxy((unsigned int)i))
+			{
+				object.visible = true;
+				continue;
+			}
+
+			device->Begin(object.predicate);
+			device->DrawProxy((unsigned int)i);
+			device->End(object.predicate);
+
+			object.pending = true;
+			stats.tested++;
+		}
+	}
+
+	bool OcclusionCuller::BeginDraw(unsigned int id)
+	{
+		if(!IsObject(id)) return false;
+
+		const Object& object = objects[id];
+		if(object.visible)
+		{
+			stats.visible++;
+			return true;
+		}
+
+		// Hidden object with a test in flight, whether issued this frame or still pending from an
+		// earlier one; GPU skips the draw unless its proxy passed.
+		if(object.pending)
+		{
+			device->SetPredication(object.predicate);
+			predicating = true;
+			stats.predicated++;
+			return true;
+		}
+
+		// No test to predicate on (tests were not issued), so it may have become visible.
+		stats.conservative++;
+		return true;
+	}
+
+	void OcclusionCuller::EndDraw()
+	{
+		if(!predicating) return;
+
+		device->SetPredication(0);
+		predicating = false;
+	}
+
+	void OcclusionCuller::EndFrame()
+	{
+		EndDraw();
+		frame++;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <vector>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Occlusion predicates and proxy drawing of a device.
+	class OcclusionDevice
+	{
+	public:
+		virtual ~OcclusionDevice() {}
+
+		virtual unsigned int CreatePredicate() = 0;
+		virtual void DestroyPredicate(unsigned int predicate) = 0;
+		virtual void Begin(unsigned int predicate) = 0;
+		virtual void End(unsigned int predicate) = 0;
+
+		// Must not block; returns -1 when not ready, 0 when no samples passed, 1 otherwise.
+		virtual int GetResult(unsigned int predicate) = 0;
+
+		// Whether object has a bounding box to draw; objects without one are not tested.
+		virtual bool HasProxy(unsigned int object) const = 0;
+
+		// Draws bounding box of object, without colour and depth writes.
+		virtual void DrawProxy(unsigned int object) = 0;
+
+		// Following draws are skipped when predicate shows no samples passed; 0 disables predication.
+		virtual void SetPredication(unsigned int predicate) = 0;
+	};
+
+	struct OcclusionStats
+	{
+		unsigned int objects;
+		unsigned int tested;		//< Proxies drawn this frame.
+		unsigned int visible;		//< Drawn unconditionally.
+		unsigned int predicated;	//< Hidden last time, drawn with predication on test in flight.
+		unsigned int conservative;	//< Hidden with no test in flight, drawn unconditionally.
+	};
+
+	// Culls objects by occlusion queries of their bounding boxes. Results are read a frame
+	// later and never waited for; objects without a box are always visible. Visible objects are retested only every few frames (staggered),
+	// hidden ones as soon as their last test resolved. Hidden objects are never culled on the CPU:
+	// they are drawn with predication on their test in flight, so the GPU skips them only when
+	// that test shows them hidden and objects that become visible do not pop in late.
+	class OcclusionCuller
+	{
+		struct Object
+		{
+			bool used;
+			bool visible;
+			bool pending;			//< Result of predicate not read yet.
+			unsigned int predicate;
+		};
+
+		OcclusionDevice* device;
+		std::vector<Object> objects;
+		std::vector<unsigned int> freeObjects;
+		unsigned long long frame;
+		unsigned int interval;
+		OcclusionStats stats;
+		bool predicating;
+
+		bool Due(unsigned int id, const Object& object) const;
+	public:
+		// Visible objects are retested every interval frames.
+		OcclusionCuller(OcclusionDevice* device, unsigned int interval = 4);
+		~OcclusionCuller();
+
+		// Objects start visible.
+		unsigned int Add();
+		void Remove(unsigned int id);
+
+		// Reads finished results.
+		void BeginFrame();
+
+		// Draws proxies of objects that are due for a test; call after occluders are drawn.
+		void IssueTests();
+
+		// Returns false when id is not an object; otherwise draw between BeginDraw and EndDraw.
+		bool BeginDraw(unsigned int id);
+		void EndDraw();
+
+		void EndFrame();
+
+		bool IsObject(unsigned int id) const { return id < objects.size() && objects[id].used; }
+		bool IsVisible(unsigned int id) const { return objects[id].visible; }
+
+		// Whether draws between BeginDraw and EndDraw are predicated.
+		bool IsPredicating() const { return predicating; }
+		const OcclusionStats& GetStats() const { return stats; }
+	};
+
+}
+}
+}
+}
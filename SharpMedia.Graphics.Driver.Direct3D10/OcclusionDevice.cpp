@@ -0,0 +1,113 @@
+#include "OcclusionDevice.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	D3D10OcclusionDevice::D3D10OcclusionDevice(ID3D10Device* device)
+	{
+		this->device = device;
+		device->AddRef();
+
+		// Index 0 means no predicate.
+		predicates.push_back(0);
+	}
+
+	D3D10OcclusionDevice::~D3D10OcclusionDevice()
+	{
+		device->SetPredication(0, FALSE);
+		for(size_t i = 0; i < predicates.size(); i++)
+		{
+			if(predicates[i]) predicates[i]->Release();
+		}
+		device->Release();
+	}
+
+	unsigned int D3D10OcclusionDevice::CreatePredicate()
+	{
+		D3D10_QUERY_DESC desc;
+		desc.Query = D3D10_QUERY_OCCLUSION_PREDICATE;
+		desc.MiscFlags = 0;
+
+		ID3D10Predicate* predicate = 0;
+		if(FAILED(device->CreatePredicate(&desc, &predicate))) return 0;
+
+		if(!freePredicates.empty())
+		{
+			unsigned int index = freePredicates.back();
+			freePredicates.pop_back();
+			predicates[index] = predicate;
+			return index;
+		}
+
+		predicates.push_back(predicate);
+		return (unsigned int)predicates.size() - 1;
+	}
+
+	void D3D10OcclusionDevice::DestroyPredicate(unsigned int predicate)
+	{
+		if(!predicates[predicate]) return;
+
+		predicates[predicate]->Release();
+		predicates[predicate] = 0;
+		freePredicates.push_back(predicate);
+	}
+
+	void D3D10OcclusionDevice::Begin(unsigned int predicate)
+	{
+		if(predicates[predicate]) predicates[predicate]->Begin();
+	}
+
+	void D3D10OcclusionDevice::End(unsigned int predicate)
+	{
+		if(predicates[predicate]) predicates[predicate]->End();
+	}
+
+	int D3D10OcclusionDevice::GetResult(unsigned int predicate)
+	{
+		// Failed predicate creation counts as visible.
+		if(!predicates[predicate]) return 1;
+
+		BOOL passed;
+		if(predicates[predicate]->GetData(&passed, sizeof(passed), D3D10_ASYNC_GETDATA_DONOTFLUSH) != S_OK) return -1;
+		return passed ? 1 : 0;
+	}
+
+	void D3D10OcclusionDevice::SetProxy(unsigned int object, UINT indexCount, UINT startIndex, INT baseVertex)
+	{
+		if(object >= proxies.size())
+		{
+			Proxy none = { 0, 0, 0 };
+			proxies.resize(object + 1, none);
+		}
+
+		Proxy& proxy = proxies[object];
+		proxy.indexCount = indexCount;
+		proxy.startIndex = startIndex;
+		proxy.baseVertex = baseVertex;
+	}
+
+	bool D3D10OcclusionDevice::HasProxy(unsigned int object) const
+	{
+		return object < proxies.size() && proxies[object].indexCount != 0;
+	}
+
+	void D3D10OcclusionDevice::DrawProxy(unsigned int object)
+	{
+		if(!HasProxy(object)) return;
+
+		const Proxy& proxy = proxies[object];
+		device->DrawIndexed(proxy.indexCount, proxy.startIndex, proxy.baseVertex);
+	}
+
+	void D3D10OcclusionDevice::SetPredication(unsigned int predicate)
+	{
+		// Draws are skipped when predicate result equals FALSE, i.e. no samples passed.
+		device->SetPredication(predicate ? predicates[predicate] : 0, FALSE);
+	}
+
+}
+}
+}
+}
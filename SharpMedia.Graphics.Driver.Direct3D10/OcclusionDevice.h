@@ -0,0 +1,50 @@
+#pragma once
+#include <windows.h>
+#include <D3D10.h>
+#include <vector>
+#include "OcclusionCuller.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Occlusion predicates on ID3D10Predicate. Proxies are indexed draws of bounding volumes set
+	// per object; the proxy pipeline (shaders, buffers, no colour or depth writes) must be bound
+	// before OcclusionCuller::IssueTests.
+	class D3D10OcclusionDevice : public OcclusionDevice
+	{
+		struct Proxy
+		{
+			UINT indexCount;
+			UINT startIndex;
+			INT baseVertex;
+		};
+
+		std::vector<ID3D10Predicate*> predicates;
+		std::vector<unsigned int> freePredicates;
+		std::vector<Proxy> proxies;
+	protected:
+		ID3D10Device* device;
+	public:
+		D3D10OcclusionDevice(ID3D10Device* device);
+		virtual ~D3D10OcclusionDevice();
+
+		virtual unsigned int CreatePredicate();
+		virtual void DestroyPredicate(unsigned int predicate);
+		virtual void Begin(unsigned int predicate);
+		virtual void End(unsigned int predicate);
+		virtual int GetResult(unsigned int predicate);
+		virtual bool HasProxy(unsigned int object) const;
+		virtual void DrawProxy(unsigned int object);
+		virtual void SetPredication(unsigned int predicate);
+
+		// Sets indexed draw of object's bounding volume in bound proxy buffers; index count of 0
+		// removes it. Objects without one are not tested and stay visible.
+		void SetProxy(unsigned int object, UINT indexCount, UINT startIndex, INT baseVertex);
+	};
+
+}
+}
+}
+}
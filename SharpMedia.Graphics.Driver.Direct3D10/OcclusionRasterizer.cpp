@@ -0,0 +1,755 @@
+#include "OcclusionRasterizer.h"
+#include <emmintrin.h>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// AVX2 is compiled in where the compiler has its intrinsics without global switches and used
+// only if the processor supports it.
+#if defined(_MSC_VER) && _MSC_VER >= 1700 && (defined(_M_IX86) || defined(_M_X64))
+#include <immintrin.h>
+#include <intrin.h>
+#define OCCLUSION_AVX2 1
+#define OCCLUSION_AVX2_TARGET
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#define OCCLUSION_AVX2 1
+#define OCCLUSION_AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define OCCLUSION_AVX2 0
+#endif
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	static void Transform(const float* v, const float* m, float* clip)
+	{
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			clip[i] = v[0] * m[i] + v[1] * m[4 + i] + v[2] * m[8 + i] + m[12 + i];
+		}
+	}
+
+	static inline float Min3(float a, float b, float c) { return a < b ? (a < c ? a : c) : (b < c ? b : c); }
+	static inline float Max3(float a, float b, float c) { return a > b ? (a > c ? a : c) : (b > c ? b : c); }
+
+	// Pixel of coordinate clamped to [lo, hi] first, so huge or NaN coordinates never convert.
+	static inline int FloorClamped(float v, int lo, int hi)
+	{
+		if(!(v >= (float)lo)) return lo;
+		if(v >= (float)hi) return hi;
+		return (int)floor(v);
+	}
+
+	static inline int CeilClamped(float v, int lo, int hi)
+	{
+		if(!(v >= (float)lo)) return lo;
+		if(v >= (float)hi) return hi;
+		return (int)ceil(v);
+	}
+
+	static bool CpuHasAvx2()
+	{
+#if !OCCLUSION_AVX2
+		return false;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if(info[0] < 7) return false;
+
+		// AVX, and YMM registers saved by the system.
+		const int Avx = (1 << 27) | (1 << 28);
+		__cpuid(info, 1);
+		if((info[2] & Avx) != Avx || (_xgetbv(0) & 6) != 6) return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+
+	static const unsigned int RasterizeMaxThreads = 16;
+
+#ifdef _WIN32
+	typedef volatile LONG RasterizeCounter;
+
+	static long Increment(RasterizeCounter* counter) { return InterlockedIncrement(counter); }
+	static void Pause(unsigned int spin) { if(spin < 1024) YieldProcessor(); else SwitchToThread(); }
+#else
+	typedef volatile long RasterizeCounter;
+
+	static long Increment(RasterizeCounter* counter) { return __sync_add_and_fetch(counter, 1); }
+	static void Pause(unsigned int spin) { if(spin >= 1024) sched_yield(); }
+#endif
+
+	// Auto reset event a worker waits on for frames.
+	struct RasterizeSignal
+	{
+#ifdef _WIN32
+		HANDLE event;
+#else
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		bool signaled;
+#endif
+	};
+
+	static bool CreateSignal(RasterizeSignal& s)
+	{
+#ifdef _WIN32
+		s.event = CreateEvent(0, FALSE, FALSE, 0);
+		return s.event != 0;
+#else
+		s.signaled = false;
+		if(pthread_mutex_init(&s.mutex, 0) != 0) return false;
+		if(pthread_cond_init(&s.cond, 0) != 0)
+		{
+			pthread_mutex_destroy(&s.mutex);
+			return false;
+		}
+		return true;
+#endif
+	}
+
+	static void DestroySignal(RasterizeSignal& s)
+	{
+#ifdef _WIN32
+		CloseHandle(s.event);
+#else
+		pthread_cond_destroy(&s.cond);
+		pthread_mutex_destroy(&s.mutex);
+#endif
+	}
+
+	static void Signal(RasterizeSignal& s)
+	{
+#ifdef _WIN32
+		SetEvent(s.event);
+#else
+		pthread_mutex_lock(&s.mutex);
+		s.signaled = true;
+		pthread_cond_signal(&s.cond);
+		pthread_mutex_unlock(&s.mutex);
+#endif
+	}
+
+	static void WaitSignal(RasterizeSignal& s)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(s.event, INFINITE);
+#else
+		pthread_mutex_lock(&s.mutex);
+		while(!s.signaled) pthread_cond_wait(&s.cond, &s.mutex);
+		s.signaled = false;
+		pthread_mutex_unlock(&s.mutex);
+#endif
+	}
+
+	struct RasterizeWorkers
+	{
+		unsigned int count;			//< Participants, including calling thread.
+#ifdef _WIN32
+		HANDLE threads[RasterizeMaxThreads];
+#else
+		pthread_t threads[RasterizeMaxThreads];
+#endif
+		RasterizeSignal start[RasterizeMaxThreads];
+		volatile long quit;
+
+		// Current frame.
+		OcclusionRasterizer* rasterizer;
+		RasterizeCounter next;		//< Tiles taken.
+		RasterizeCounter finished;	//< Workers out of tiles.
+	};
+
+	struct RasterizeWorkerParam
+	{
+		RasterizeWorkers* workers;
+		unsigned int index;
+	};
+
+	// Tiles are taken from a shared counter until none are left.
+	static void RunTiles(RasterizeWorkers& w)
+	{
+		unsigned int count = w.rasterizer->GetTileCount();
+		for(;;)
+		{
+			unsigned int tile = (unsigned int)Increment(&w.next) - 1;
+			if(tile >= count) return;
+			w.rasterizer->RasterizeTile(tile);
+		}
+	}
+
+	static void RasterizeLoop(void* param)
+	{
+		RasterizeWorkerParam p = *(RasterizeWorkerParam*)param;
+		delete (RasterizeWorkerParam*)param;
+
+		for(;;)
+		{
+			WaitSignal(p.workers->start[p.index]);
+			if(p.workers->quit) return;
+			RunTiles(*p.workers);
+			Increment(&p.workers->finished);
+		}
+	}
+
+#ifdef _WIN32
+	static DWORD WINAPI RasterizeThread(LPVOID param)
+	{
+		RasterizeLoop(param);
+		return 0;
+	}
+#else
+	static void* RasterizeThread(void* param)
+	{
+		RasterizeLoop(param);
+		return 0;
+	}
+#endif
+
+	static RasterizeWorkers* CreateWorkers(unsigned int count)
+	{
+		RasterizeWorkers* w = new RasterizeWorkers();
+		memset(w, 0, sizeof(RasterizeWorkers));
+		w->count = 1;
+
+		for(unsigned int i = 1; i < count && i < RasterizeMaxThreads; i++)
+		{
+			RasterizeWorkerParam* param = new RasterizeWorkerParam();
+			param->workers = w;
+			param->index = i;
+
+			if(!CreateSignal(w->start[i]))
+			{
+				delete param;
+				break;
+			}
+#ifdef _WIN32
+			w->threads[i] = CreateThread(0, 0, RasterizeThread, param, 0, 0);
+			bool started = w->threads[i] != 0;
+#else
+			bool started = pthread_create(&w->threads[i], 0, RasterizeThread, param) == 0;
+#endif
+			if(!started)
+			{
+				DestroySignal(w->start[i]);
+				delete param;
+				break;
+			}
+			w->count++;
+		}
+		return w;
+	}
+
+	static void DestroyWorkers(RasterizeWorkers* w)
+	{
+		w->quit = 1;
+		for(unsigned int i = 1; i < w->count; i++) Signal(w->start[i]);
+		for(unsigned int i = 1; i < w->count; i++)
+		{
+#ifdef _WIN32
+			WaitForSingleObject(w->threads[i], INFINITE);
+			CloseHandle(w->threads[i]);
+#else
+			pthread_join(w->threads[i], 0);
+#endif
+			DestroySignal(w->start[i]);
+		}
+		delete w;
+	}
+
+	OcclusionRasterizer::OcclusionRasterizer(unsigned int width, unsigned int height, unsigned int threadCount)
+	{
+		this->tilesX = (width + TileSize - 1) / TileSize;
+		this->tilesY = (height + TileSize - 1) / TileSize;
+		if(tilesX == 0) tilesX = 1;
+		if(tilesY == 0) tilesY = 1;
+
+		this->width = tilesX * TileSize;
+		this->height = tilesY * TileSize;
+		this->blocksX = this->width / BlockSize;
+		this->blocksY = this->height / BlockSize;
+
+		depth.resize(this->width * this->height);
+		blockDepth.resize(blocksX * blocksY);
+		bins.resize(tilesX * tilesY);
+		Clear();
+
+		workers = CreateWorkers(threadCount);
+		avx2 = CpuHasAvx2();
+	}
+
+	OcclusionRasterizer::~OcclusionRasterizer()
+	{
+		DestroyWorkers(workers);
+	}
+
+	bool OcclusionRasterizer::SetAvx2(bool enable)
+	{
+		avx2 = enable && CpuHasAvx2();
+		return avx2;
+	}
+
+	unsigned int OcclusionRasterizer::GetThreadCount() const
+	{
+		return workers->count;
+	}
+
+	void OcclusionRasterizer::Clear()
+	{
+		std::fill(depth.begin(), depth.end(), 1.0f);
+		std::fill(blockDepth.begin(), blockDepth.end(), 1.0f);
+		triangles.clear();
+		for(size_t i = 0; i < bins.size(); i++) bins[i].clear();
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	void OcclusionRasterizer::Bin(const float* a, const float* b, const float* c)
+	{
+		const float* v[3] = { a, b, c };
+
+		Triangle t;
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			float w = 1.0f / v[i][3];
+			t.x[i] = (v[i][0] * w * 0.5f + 0.5f) * (float)width;
+			t.y[i] = (0.5f - v[i][1] * w * 0.5f) * (float)height;
+			t.z[i] = v[i][2] * w;
+
+			// Vertices on the eye plane project to infinity; such triangles are dropped.
+			if(!(fabs(t.x[i]) <= FLT_MAX && fabs(t.y[i]) <= FLT_MAX && fabs(t.z[i]) <= FLT_MAX)) return;
+		}
+
+		// Both windings are occluders; degenerate ones cover nothing.
+		float area = (t.x[1] - t.x[0]) * (t.y[2] - t.y[0]) - (t.y[1] - t.y[0]) * (t.x[2] - t.x[0]);
+		if(!(fabs(area) > 1e-6f)) return;
+
+		float minX = Min3(t.x[0], t.x[1], t.x[2]), maxX = Max3(t.x[0], t.x[1], t.x[2]);
+		float minY = Min3(t.y[0], t.y[1], t.y[2]), maxY = Max3(t.y[0], t.y[1], t.y[2]);
+		if(maxX < 0.0f || maxY < 0.0f || minX >= (float)width || minY >= (float)height) return;
+		if(Min3(t.z[0], t.z[1], t.z[2]) > 1.0f) return;
+
+		int tx0 = FloorClamped(minX, 0, (int)width - 1) / (int)TileSize;
+		int ty0 = FloorClamped(minY, 0, (int)height - 1) / (int)TileSize;
+		int tx1 = FloorClamped(maxX, 0, (int)width - 1) / (int)TileSize;
+		int ty1 = FloorClamped(maxY, 0, (int)height - 1) / (int)TileSize;
+
+		unsigned int index = (unsigned int)triangles.size();
+		triangles.push_back(t);
+		stats.binnedTriangles++;
+
+		for(int ty = ty0; ty <= ty1; ty++)
+		{
+			for(int tx = tx0; tx <= tx1; tx++) bins[ty * tilesX + tx].push_back(index);
+		}
+	}
+
+	// Clip planes: near (z >= 0 in D3D clip space) and a guard band of GuardBand screens around
+	// the viewport, so edge functions of clipped triangles stay in float precision.
+	static const float GuardBand = 4.0f;
+	static const unsigned int ClipPlaneCount = 5;
+
+	static inline float ClipDistance(const float* v, unsigned int plane)
+	{
+		switch(plane)
+		{
+		case 0: return v[2];
+		case 1: return GuardBand * v[3] - v[0];
+		case 2: return GuardBand * v[3] + v[0];
+		case 3: return GuardBand * v[3] - v[1];
+		default: return GuardBand * v[3] + v[1];
+		}
+	}
+
+	// Bit per clip plane the vertex is outside of.
+	static inline unsigned int Outcode(const float* v)
+	{
+		unsigned int code = 0;
+		for(unsigned int i = 0; i < ClipPlaneCount; i++) if(ClipDistance(v, i) < 0.0f) code |= 1 << i;
+		return code;
+	}
+
+	void OcclusionRasterizer::AddClipped(const float* a, const float* b, const float* c)
+	{
+		// Each plane adds at most one vertex to the polygon, which is binned as a fan.
+		float buffers[2][3 + ClipPlaneCount][4];
+		memcpy(buffers[0][0], a, sizeof(float) * 4);
+		memcpy(buffers[0][1], b, sizeof(float) * 4);
+		memcpy(buffers[0][2], c, sizeof(float) * 4);
+		unsigned int count = 3, current = 0;
+
+		for(unsigned int plane = 0; plane < ClipPlaneCount && count >= 3; plane++)
+		{
+			float (*in)[4] = buffers[current];
+			float (*out)[4] = buffers[current ^ 1];
+			unsigned int outCount = 0;
+
+			for(unsigned int i = 0; i < count; i++)
+			{
+				const float* p = in[i];
+				const float* q = in[(i + 1) % count];
+				float dp = ClipDistance(p, plane), dq = ClipDistance(q, plane);
+				bool pInside = dp >= 0.0f, qInside = dq >= 0.0f;
+
+				if(pInside) memcpy(out[outCount++], p, sizeof(float) * 4);
+				if(pInside != qInside)
+				{
+					// Interpolated from inside vertex, so triangles sharing the edge get the same point.
+					const float* from = pInside ? p : q;
+					const float* to = pInside ? q : p;
+					float s = pInside ? dp / (dp - dq) : dq / (dq - dp);
+					float* v = out[outCount++];
+					for(unsigned int j = 0; j < 4; j++) v[j] = from[j] + (to[j] - from[j]) * s;
+
+					// Exactly on guard plane, interpolation of large coordinates cancels.
+					if(plane > 0) v[(plane - 1) / 2] = (plane % 2 ? GuardBand : -GuardBand) * v[3];
+				}
+			}
+
+			count = outCount;
+			current ^= 1;
+		}
+
+		for(unsigned int i = 1; i + 1 < count; i++)
+		{
+			Bin(buffers[current][0], buffers[current][i], buffers[current][i + 1]);
+		}
+	}
+
+	void OcclusionRasterizer::AddOccluder(const float* vertices, unsigned int vertexCount,
+		const unsigned int* indices, unsigned int indexCount, const float* matrix)
+	{
+		std::vector<float> clip(vertexCount * 4);
+		std::vector<unsigned int> outcodes(vertexCount);
+		for(unsigned int i = 0; i < vertexCount; i++)
+		{
+			Transform(&vertices[i * 3], matrix, &clip[i * 4]);
+			outcodes[i] = Outcode(&clip[i * 4]);
+		}
+
+		for(unsigned int i = 0; i + 2 < indexCount; i += 3)
+		{
+			unsigned int ia = indices[i], ib = indices[i + 1], ic = indices[i + 2];
+			stats.occluderTriangles++;
+
+			// Outside one plane entirely.
+			if(outcodes[ia] & outcodes[ib] & outcodes[ic]) continue;
+
+			if(outcodes[ia] | outcodes[ib] | outcodes[ic])
+			{
+				AddClipped(&clip[ia * 4], &clip[ib * 4], &clip[ic * 4]);
+			} else {
+				Bin(&clip[ia * 4], &clip[ib * 4], &clip[ic * 4]);
+			}
+		}
+	}
+
+	// Triangle set up for scanning the part of its bounds within a tile.
+	struct ScanSetup
+	{
+		float a[3], b[3], c[3];		//< Edge i is opposite to vertex i, e(x, y) = a * x + b * y + c.
+		bool owns[3];				//< Centres exactly on edge are covered.
+		float za, zb, zc;			//< Depth plane, z(x, y) = za * x + zb * y + zc.
+		int x0, y0, x1, y1;			//< Pixel bounds, inclusive.
+	};
+
+	static void Setup(const OcclusionRasterizer::Triangle& t, int tileX, int tileY, ScanSetup& s)
+	{
+		// Edges are positive inside.
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			unsigned int j = (i + 1) % 3, k = (i + 2) % 3;
+			s.a[i] = t.y[j] - t.y[k];
+			s.b[i] = t.x[k] - t.x[j];
+			s.c[i] = t.x[j] * t.y[k] - t.x[k] * t.y[j];
+		}
+		float area = s.a[0] * t.x[0] + s.b[0] * t.y[0] + s.c[0];
+		if(area < 0.0f)
+		{
+			for(unsigned int i = 0; i < 3; i++) { s.a[i] = -s.a[i]; s.b[i] = -s.b[i]; s.c[i] = -s.c[i]; }
+			area = -area;
+		}
+
+		// Top-left fill rule: centres exactly on an edge belong to the triangle only when
+		// the edge is left (inside to the right) or top (inside below), so triangles sharing
+		// an edge cover its pixels once. Edge values are not stepped incrementally, so both
+		// triangles compute exactly negated values on the shared edge.
+		for(unsigned int i = 0; i < 3; i++) s.owns[i] = s.a[i] > 0.0f || (s.a[i] == 0.0f && s.b[i] > 0.0f);
+
+		// Depth plane from barycentrics.
+		float inv = 1.0f / area;
+		s.za = (s.a[0] * t.z[0] + s.a[1] * t.z[1] + s.a[2] * t.z[2]) * inv;
+		s.zb = (s.b[0] * t.z[0] + s.b[1] * t.z[1] + s.b[2] * t.z[2]) * inv;
+		s.zc = (s.c[0] * t.z[0] + s.c[1] * t.z[1] + s.c[2] * t.z[2]) * inv;
+
+		int lastX = tileX + (int)OcclusionRasterizer::TileSize - 1;
+		int lastY = tileY + (int)OcclusionRasterizer::TileSize - 1;
+		s.x0 = FloorClamped(Min3(t.x[0], t.x[1], t.x[2]), tileX, lastX);
+		s.y0 = FloorClamped(Min3(t.y[0], t.y[1], t.y[2]), tileY, lastY);
+		s.x1 = CeilClamped(Max3(t.x[0], t.x[1], t.x[2]), tileX, lastX);
+		s.y1 = CeilClamped(Max3(t.y[0], t.y[1], t.y[2]), tileY, lastY);
+	}
+
+	// Scans four pixels at a time. Depth is evaluated from the plane at each pixel rather than
+	// stepped, so both scans write the same values.
+	static void ScanSse(const ScanSetup& s, float* depth, unsigned int width)
+	{
+		const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 all = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		const __m128 four = _mm_set1_ps(4.0f);
+		const __m128 za = _mm_set1_ps(s.za);
+
+		__m128 ea[3], topLeft[3];
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			ea[i] = _mm_set1_ps(s.a[i]);
+			topLeft[i] = s.owns[i] ? all : zero;
+		}
+
+		int x0 = s.x0 & ~3;
+		for(int y = s.y0; y <= s.y1; y++)
+		{
+			float py = (float)y + 0.5f;
+			__m128 px = _mm_add_ps(_mm_set1_ps((float)x0), offsets);
+
+			__m128 ec[3];
+			for(unsigned int i = 0; i < 3; i++) ec[i] = _mm_set1_ps(s.b[i] * py + s.c[i]);
+			__m128 zy = _mm_set1_ps(s.zb * py + s.zc);
+
+			float* row = &depth[y * width];
+			for(int x = x0; x <= s.x1; x += 4, px = _mm_add_ps(px, four))
+			{
+				// Pixel centres inside or on an owned edge, occluders must not grow.
+				__m128 inside = all;
+				for(unsigned int i = 0; i < 3; i++)
+				{
+					__m128 e = _mm_add_ps(_mm_mul_ps(ea[i], px), ec[i]);
+					__m128 edge = _mm_or_ps(_mm_cmpgt_ps(e, zero), _mm_and_ps(_mm_cmpeq_ps(e, zero), topLeft[i]));
+					inside = _mm_and_ps(inside, edge);
+				}
+				if(_mm_movemask_ps(inside))
+				{
+					__m128 z = _mm_add_ps(_mm_mul_ps(za, px), zy);
+					__m128 old = _mm_loadu_ps(&row[x]);
+					__m128 nearer = _mm_min_ps(old, z);
+					_mm_storeu_ps(&row[x], _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+				}
+			}
+		}
+	}
+
+#if OCCLUSION_AVX2
+	// Same as ScanSse, eight pixels at a time.
+	OCCLUSION_AVX2_TARGET static void ScanAvx2(const ScanSetup& s, float* depth, unsigned int width)
+	{
+		const __m256 offsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		const __m256 eight = _mm256_set1_ps(8.0f);
+		const __m256 za = _mm256_set1_ps(s.za);
+
+		__m256 ea[3], topLeft[3];
+		for(unsigned int i = 0; i < 3; i++)
+		{
+			ea[i] = _mm256_set1_ps(s.a[i]);
+			topLeft[i] = s.owns[i] ? all : zero;
+		}
+
+		int x0 = s.x0 & ~7;
+		for(int y = s.y0; y <= s.y1; y++)
+		{
+			float py = (float)y + 0.5f;
+			__m256 px = _mm256_add_ps(_mm256_set1_ps((float)x0), offsets);
+
+			__m256 ec[3];
+			for(unsigned int i = 0; i < 3; i++) ec[i] = _mm256_set1_ps(s.b[i] * py + s.c[i]);
+			__m256 zy = _mm256_set1_ps(s.zb * py + s.zc);
+
+			float* row = &depth[y * width];
+			for(int x = x0; x <= s.x1; x += 8, px = _mm256_add_ps(px, eight))
+			{
+				__m256 inside = all;
+				for(unsigned int i = 0; i < 3; i++)
+				{
+					__m256 e = _mm256_add_ps(_mm256_mul_ps(ea[i], px), ec[i]);
+					__m256 edge = _mm256_or_ps(_mm256_cmp_ps(e, zero, _CMP_GT_OQ),
+						_mm256_and_ps(_mm256_cmp_ps(e, zero, _CMP_EQ_OQ), topLeft[i]));
+					inside = _mm256_and_ps(inside, edge);
+				}
+				if(_mm256_movemask_ps(inside))
+				{
+					__m256 z = _mm256_add_ps(_mm256_mul_ps(za, px), zy);
+					__m256 old = _mm256_loadu_ps(&row[x]);
+					_mm256_storeu_ps(&row[x], _mm256_blendv_ps(old, _mm256_min_ps(old, z), inside));
+				}
+			}
+		}
+	}
+#endif
+
+	void OcclusionRasterizer::RasterizeTile(unsigned int tile)
+	{
+		int tileX = (int)(tile % tilesX) * (int)TileSize;
+		int tileY = (int)(tile / tilesX) * (int)TileSize;
+		const std::vector<unsigned int>& bin = bins[tile];
+
+		for(size_t n = 0; n < bin.size(); n++)
+		{
+			ScanSetup s;
+			Setup(triangles[bin[n]], tileX, tileY, s);
+#if OCCLUSION_AVX2
+			if(avx2)
+			{
+				ScanAvx2(s, &depth[0], width);
+				continue;
+			}
+#endif
+			ScanSse(s, &depth[0], width);
+		}
+
+		// Farthest depth of each block of tile.
+		for(int by = tileY; by < tileY + (int)TileSize; by += BlockSize)
+		{
+			for(int bx = tileX; bx < tileX + (int)TileSize; bx += BlockSize)
+			{
+				__m128 farthest = _mm_setzero_ps();
+				for(int y = by; y < by + (int)BlockSize; y++)
+				{
+					const float* row = &depth[y * width + bx];
+					farthest = _mm_max_ps(farthest, _mm_max_ps(_mm_loadu_ps(row), _mm_loadu_ps(row + 4)));
+				}
+
+				float values[4];
+				_mm_storeu_ps(values, farthest);
+				float f = values[0];
+				for(unsigned int i = 1; i < 4; i++) if(values[i] > f) f = values[i];
+				blockDepth[(by / BlockSize) * blocksX + bx / BlockSize] = f;
+			}
+		}
+	}
+
+	void OcclusionRasterizer::Rasterize()
+	{
+		for(size_t i = 0; i < bins.size(); i++) stats.tileTriangles += (unsigned int)bins[i].size();
+
+		unsigned int threads = workers->count;
+		if(threads > GetTileCount()) threads = GetTileCount();
+
+		if(threads > 1 && triangles.size() > 0)
+		{
+			// Workers are woken for the frame, the calling thread also takes tiles and then waits
+			// for the others to finish theirs.
+			RasterizeWorkers& w = *workers;
+			w.rasterizer = this;
+			w.next = 0;
+			w.finished = 0;
+
+			for(unsigned int i = 1; i < threads; i++) Signal(w.start[i]);
+			RunTiles(w);
+			for(unsigned int spin = 0; (unsigned int)w.finished != threads - 1; spin++) Pause(spin);
+			return;
+		}
+
+		for(unsigned int i = 0; i < GetTileCount(); i++) RasterizeTile(i);
+	}
+
+	bool OcclusionRasterizer::TestBlock(unsigned int bx, unsigned int by, int minX, int minY,
+		int maxX, int maxY, float z) const
+	{
+		int x0 = (int)(bx * BlockSize), y0 = (int)(by * BlockSize);
+		int x1 = x0 + (int)BlockSize - 1, y1 = y0 + (int)BlockSize - 1;
+		if(x0 < minX) x0 = minX;
+		if(y0 < minY) y0 = minY;
+		if(x1 > maxX) x1 = maxX;
+		if(y1 > maxY) y1 = maxY;
+
+		for(int y = y0; y <= y1; y++)
+		{
+			const float* row = &depth[y * width];
+			for(int x = x0; x <= x1; x++)
+			{
+				if(z <= row[x]) return true;
+			}
+		}
+		return false;
+	}
+
+	bool OcclusionRasterizer::TestRect(int minX, int minY, int maxX, int maxY, float nearestDepth)
+	{
+		stats.tests++;
+
+		if(minX < 0) minX = 0;
+		if(minY < 0) minY = 0;
+		if(maxX > (int)width - 1) maxX = (int)width - 1;
+		if(maxY > (int)height - 1) maxY = (int)height - 1;
+
+		// Off screen objects are not our concern, the frustum culler handles them.
+		if(minX > maxX || minY > maxY) return true;
+
+		unsigned int bx0 = minX / BlockSize, bx1 = maxX / BlockSize;
+		unsigned int by0 = minY / BlockSize, by1 = maxY / BlockSize;
+		for(unsigned int by = by0; by <= by1; by++)
+		{
+			for(unsigned int bx = bx0; bx <= bx1; bx++)
+			{
+				// Whole block is nearer than object, nothing to check.
+				if(nearestDepth > blockDepth[by * blocksX + bx]) continue;
+
+				if(TestBlock(bx, by, minX, minY, maxX, maxY, nearestDepth)) return true;
+			}
+		}
+
+		stats.occluded++;
+		return false;
+	}
+
+	bool OcclusionRasterizer::TestBox(const float* min, const float* max, const float* matrix)
+	{
+		float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f, nearest = 1.0f;
+		for(unsigned int i = 0; i < 8; i++)
+		{
+			float corner[3] = { (i & 1) ? max[0] : min[0], (i & 2) ? max[1] : min[1], (i & 4) ? max[2] : min[2] };
+			float clip[4];
+			Transform(corner, matrix, clip);
+
+			// Crossing near plane, treat as visible.
+			if(clip[2] < 0.0f || clip[3] <= 0.0f)
+			{
+				stats.tests++;
+				return true;
+			}
+
+			float w = 1.0f / clip[3];
+			float x = (clip[0] * w * 0.5f + 0.5f) * (float)width;
+			float y = (0.5f - clip[1] * w * 0.5f) * (float)height;
+			float z = clip[2] * w;
+
+			if(x < minX) minX = x;
+			if(x > maxX) maxX = x;
+			if(y < minY) minY = y;
+			if(y > maxY) maxY = y;
+			if(z < nearest) nearest = z;
+		}
+
+		// Clamped one pixel outside screen, so off screen boxes stay off screen.
+		return TestRect(FloorClamped(minX, -1, (int)width), FloorClamped(minY, -1, (int)height),
+			CeilClamped(maxX, -1, (int)width), CeilClamped(maxY, -1, (int)height), nearest);
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <vector>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	struct OcclusionRasterizerStats
+	{
+		unsigned int occluderTriangles;		//< Triangles added.
+		unsigned int binnedTriangles;		//< Triangles after clipping and culling, counted once.
+		unsigned int tileTriangles;			//< Triangle and tile pairs rasterized.
+		unsigned int tests;
+		unsigned int occluded;
+	};
+
+	struct RasterizeWorkers;
+
+	// Low resolution CPU depth buffer for culling draws before submission. Occluders are
+	// binned into screen tiles and tiles are rasterized in parallel, four pixels at a time
+	// with SSE or eight with AVX2 where the processor has it. Each 8x8 block keeps its farthest
+	// depth, so most box tests do not touch pixels.
+	//
+	// Matrices transform row vectors to D3D clip space (v * M, row major), depth is in [0,1].
+	class OcclusionRasterizer
+	{
+	public:
+		static const unsigned int TileSize = 32;
+		static const unsigned int BlockSize = 8;
+
+		struct Triangle
+		{
+			float x[3], y[3], z[3];		//< Screen space, pixel centres are at .5.
+		};
+
+	private:
+		unsigned int width, height;
+		unsigned int tilesX, tilesY;
+		unsigned int blocksX, blocksY;
+		RasterizeWorkers* workers;
+		bool avx2;
+		std::vector<float> depth;
+		std::vector<float> blockDepth;		//< Farthest depth of each block.
+		std::vector<Triangle> triangles;
+		std::vector<std::vector<unsigned int> > bins;
+		OcclusionRasterizerStats stats;
+
+		void Bin(const float* a, const float* b, const float* c);
+		void AddClipped(const float* a, const float* b, const float* c);
+		bool TestBlock(unsigned int bx, unsigned int by, int minX, int minY, int maxX, int maxY, float z) const;
+
+		OcclusionRasterizer(const OcclusionRasterizer&);
+		OcclusionRasterizer& operator=(const OcclusionRasterizer&);
+	public:
+		// Size is rounded up to whole tiles. Worker threads (threadCount - 1 of them, the
+		// calling thread also rasterizes) are started here and kept until destruction.
+		OcclusionRasterizer(unsigned int width, unsigned int height, unsigned int threadCount = 1);
+		~OcclusionRasterizer();
+
+		// Enables AVX2 rasterization (on by default); returns whether it is used, which it is
+		// not if the processor or compiler lacks it.
+		bool SetAvx2(bool enable);
+
+		// Removes occluders and resets depth to far plane.
+		void Clear();
+
+		// Vertices are 3 floats each, every 3 indices form a triangle.
+		void AddOccluder(const float* vertices, unsigned int vertexCount, const unsigned int* indices,
+			unsigned int indexCount, const float* matrix);
+
+		// Rasterizes all occluders added since Clear.
+		void Rasterize();
+
+		// Rasterizes one tile; tiles are independent so they can run on any thread.
+		void RasterizeTile(unsigned int tile);
+
+		// Returns false when box is fully behind occluders.
+		bool TestBox(const float* min, const float* max, const float* matrix);
+
+		// Pixel rectangle (inclusive) with nearest depth of tested object.
+		bool TestRect(int minX, int minY, int maxX, int maxY, float nearestDepth);
+
+		unsigned int GetWidth() const { return width; }
+		unsigned int GetHeight() const { return height; }
+		unsigned int GetTileCount() const { return tilesX * tilesY; }
+		unsigned int GetThreadCount() const;
+		const float* GetDepth() const { return &depth[0]; }
+		const OcclusionRasterizerStats& GetStats() const { return stats; }
+	};
+
+}
+}
+}
+}
@@ -0,0 +1,90 @@
+#include "QueryBackend.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	static D3D10_QUERY ToDXQuery(GpuQueryType type)
+	{
+		switch(type)
+		{
+		case GpuQueryDisjoint:
+			return D3D10_QUERY_TIMESTAMP_DISJOINT;
+		case GpuQueryTimestamp:
+			return D3D10_QUERY_TIMESTAMP;
+		case GpuQueryPipelineStatistics:
+			return D3D10_QUERY_PIPELINE_STATISTICS;
+		default:
+			return D3D10_QUERY_OCCLUSION;
+		}
+	}
+
+	D3D10QueryBackend::D3D10QueryBackend(ID3D10Device* device)
+	{
+		this->device = device;
+		device->AddRef();
+
+		// Index 0 is never used, so it can mean no query.
+		queries.push_back(0);
+	}
+
+	D3D10QueryBackend::~D3D10QueryBackend()
+	{
+		for(size_t i = 0; i < queries.size(); i++)
+		{
+			if(queries[i]) queries[i]->Release();
+		}
+		device->Release();
+	}
+
+	unsigned int D3D10QueryBackend::Create(GpuQueryType type)
+	{
+		D3D10_QUERY_DESC desc;
+		desc.Query = ToDXQuery(type);
+		desc.MiscFlags = 0;
+
+		ID3D10Query* query = 0;
+		if(FAILED(device->CreateQuery(&desc, &query))) return 0;
+
+		if(!freeQueries.empty())
+		{
+			unsigned int index = freeQueries.back();
+			freeQueries.pop_back();
+			queries[index] = query;
+			return index;
+		}
+
+		queries.push_back(query);
+		return (unsigned int)queries.size() - 1;
+	}
+
+	void D3D10QueryBackend::Destroy(unsigned int query)
+	{
+		if(!queries[query]) return;
+
+		queries[query]->Release();
+		queries[query] = 0;
+		freeQueries.push_back(query);
+	}
+
+	void D3D10QueryBackend::Begin(unsigned int query)
+	{
+		if(queries[query]) queries[query]->Begin();
+	}
+
+	void D3D10QueryBackend::End(unsigned int query)
+	{
+		if(queries[query]) queries[query]->End();
+	}
+
+	bool D3D10QueryBackend::GetData(unsigned int query, void* data, unsigned int size)
+	{
+		if(!queries[query]) return false;
+		return queries[query]->GetData(data, size, D3D10_ASYNC_GETDATA_DONOTFLUSH) == S_OK;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <windows.h>
+#include <D3D10.h>
+#include <vector>
+#include "GpuProfiler.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Profiler queries on ID3D10Query; results are read with DONOTFLUSH so they never stall.
+	class D3D10QueryBackend : public GpuQueryBackend
+	{
+		ID3D10Device* device;
+		std::vector<ID3D10Query*> queries;
+		std::vector<unsigned int> freeQueries;
+	public:
+		D3D10QueryBackend(ID3D10Device* device);
+		virtual ~D3D10QueryBackend();
+
+		virtual unsigned int Create(GpuQueryType type);
+		virtual void Destroy(unsigned int query);
+		virtual void Begin(unsigned int query);
+		virtual void End(unsigned int query);
+		virtual bool GetData(unsigned int query, void* data, unsigned int size);
+	};
+
+}
+}
+}
+}
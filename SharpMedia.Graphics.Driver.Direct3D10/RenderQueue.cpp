@@ -0,0 +1,498 @@
+#include "RenderQueue.h"
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Below this many items per thread sorting is not split.
+	static const unsigned int RadixItemsPerThread = 16384;
+	static const unsigned int RadixMaxThreads = 16;
+
+	// Bytes of a 128-bit key.
+	static const unsigned int RadixDigits = 16;
+
+	// Byte p of a 128-bit key is in word and at shift.
+	struct RadixDigit
+	{
+		unsigned long long RenderItem::*word;
+		unsigned int shift;
+
+		RadixDigit(unsigned int p) : word(p < 8 ? &RenderItem::subkey : &RenderItem::key), shift((p & 7) * 8) {}
+		unsigned int operator()(const RenderItem& item) const { return (unsigned int)(item.*word >> shift) & 0xFF; }
+	};
+
+#ifdef _WIN32
+	typedef volatile LONG RadixCounter;
+
+	static long Increment(RadixCounter* counter) { return InterlockedIncrement(counter); }
+	static void Pause(unsigned int spin) { if(spin < 1024) YieldProcessor(); else SwitchToThread(); }
+#else
+	typedef volatile long RadixCounter;
+
+	static long Increment(RadixCounter* counter) { return __sync_add_and_fetch(counter, 1); }
+	static void Pause(unsigned int spin) { if(spin >= 1024) sched_yield(); }
+#endif
+
+	// Auto reset event a worker waits on for jobs.
+	struct RadixSignal
+	{
+#ifdef _WIN32
+		HANDLE event;
+#else
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		bool signaled;
+#endif
+	};
+
+	static bool CreateSignal(RadixSignal& s)
+	{
+#ifdef _WIN32
+		s.event = CreateEvent(0, FALSE, FALSE, 0);
+		return s.event != 0;
+#else
+		s.signaled = false;
+		if(pthread_mutex_init(&s.mutex, 0) != 0) return false;
+		if(pthread_cond_init(&s.cond, 0) != 0)
+		{
+			pthread_mutex_destroy(&s.mutex);
+			return false;
+		}
+		return true;
+#endif
+	}
+
+	static void DestroySignal(RadixSignal& s)
+	{
+#ifdef _WIN32
+		CloseHandle(s.event);
+#else
+		pthread_cond_destroy(&s.cond);
+		pthread_mutex_destroy(&s.mutex);
+#endif
+	}
+
+	static void Signal(RadixSignal& s)
+	{
+#ifdef _WIN32
+		SetEvent(s.event);
+#else
+		pthread_mutex_lock(&s.mutex);
+		s.signaled = true;
+		pthread_cond_signal(&s.cond);
+		pthread_mutex_unlock(&s.mutex);
+#endif
+	}
+
+	static void WaitSignal(RadixSignal& s)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(s.event, INFINITE);
+#else
+		pthread_mutex_lock(&s.mutex);
+		while(!s.signaled) pthread_cond_wait(&s.cond, &s.mutex);
+		s.signaled = false;
+		pthread_mutex_unlock(&s.mutex);
+#endif
+	}
+
+	struct RadixBarrier
+	{
+		RadixCounter arrived;
+		RadixCounter generation;
+	};
+
+	struct RadixWorkers
+	{
+		unsigned int count;			//< Participants, including calling thread.
+#ifdef _WIN32
+		HANDLE threads[RadixMaxThreads];
+#else
+		pthread_t threads[RadixMaxThreads];
+#endif
+		RadixSignal start[RadixMaxThreads];
+		volatile long quit;
+
+		// Current job.
+		RenderItem* items;
+		RenderItem* temp;
+		RenderItem* result;
+		unsigned int size;
+		unsigned int active;		//< Participants of current job.
+		RadixBarrier barrier;
+		unsigned long long differ[RadixMaxThreads][2];	//< Bits of key and subkey that differ from first item.
+		unsigned int histograms[RadixMaxThreads][256];
+	};
+
+	struct RadixWorkerParam
+	{
+		RadixWorkers* workers;
+		unsigned int index;
+	};
+
+	static void Wait(RadixBarrier& barrier, unsigned int count)
+	{
+		if(count == 1) return;
+
+		long generation = barrier.generation;
+		if((unsigned int)Increment(&barrier.arrived) == count)
+		{
+			barrier.arrived = 0;
+			Increment(&barrier.generation);
+			return;
+		}
+
+		for(unsigned int spin = 0; barrier.generation == generation; spin++) Pause(spin);
+	}
+
+	// Sorts chunk t of the job together with other participants.
+	static void RadixRun(RadixWorkers& w, unsigned int t)
+	{
+		unsigned int threads = w.active;
+		unsigned int begin = (unsigned int)((unsigned long long)w.size * t / threads);
+		unsigned int end = (unsigned int)((unsigned long long)w.size * (t + 1) / threads);
+
+		// Bits that differ anywhere in chunk, found in one cheap read.
+		const RenderItem* items = w.items;
+		unsigned long long firstKey = items[0].key, firstSubkey = items[0].subkey;
+		unsigned long long differKey = 0, differSubkey = 0;
+		for(unsigned int i = begin; i < end; i++)
+		{
+			differKey |= items[i].key ^ firstKey;
+			differSubkey |= items[i].subkey ^ firstSubkey;
+		}
+		w.differ[t][0] = differKey;
+		w.differ[t][1] = differSubkey;
+		Wait(w.barrier, threads);
+
+		// A pass is needed when keys differ in its byte.
+		for(unsigned int u = 0; u < threads; u++)
+		{
+			differKey |= w.differ[u][0];
+			differSubkey |= w.differ[u][1];
+		}
+		unsigned int passes[RadixDigits], passCount = 0;
+		for(unsigned int p = 0; p < RadixDigits; p++)
+		{
+			unsigned long long differ = p < 8 ? differSubkey : differKey;
+			if((differ >> ((p & 7) * 8)) & 0xFF) passes[passCount++] = p;
+		}
+
+		// Others may still read differences of this chunk, job is left together.
+		if(passCount == 0)
+		{
+			Wait(w.barrier, threads);
+			if(t == 0) w.result = w.items;
+			return;
+		}
+
+		unsigned int* own = w.histograms[t];
+		RenderItem* src = w.items;
+		RenderItem* dst = w.temp;
+		for(unsigned int n = 0; n < passCount; n++)
+		{
+			RadixDigit digit(passes[n]);
+
+			memset(own, 0, sizeof(w.histograms[t]));
+			for(unsigned int i = begin; i < end; i++) own[digit(src[i])]++;
+			Wait(w.barrier, threads);
+
+			// Chunk writes after all smaller buckets and after same bucket of previous chunks.
+			unsigned int offsets[256], base = 0;
+			for(unsigned int b = 0; b < 256; b++)
+			{
+				unsigned int offset = base;
+				for(unsigned int u = 0; u < threads; u++)
+				{
+					if(u == t) offsets[b] = offset;
+					offset += w.histograms[u][b];
+				}
+				base = offset;
+			}
+
+			for(unsigned int i = begin; i < end; i++)
+			{
+				dst[offsets[digit(src[i])]++] = src[i];
+			}
+
+			// Histograms are reused by next pass and results are read by others.
+			Wait(w.barrier, threads);
+
+			RenderItem* swap = src; src = dst; dst = swap;
+		}
+
+		if(t == 0) w.result = src;
+	}
+
+	static void RadixLoop(void* param)
+	{
+		RadixWorkerParam p = *(RadixWorkerParam*)param;
+		delete (RadixWorkerParam*)param;
+
+		for(;;)
+		{
+			WaitSignal(p.workers->start[p.index]);
+			if(p.workers->quit) return;
+			RadixRun(*p.workers, p.index);
+		}
+	}
+
+#ifdef _WIN32
+	static DWORD WINAPI RadixThread(LPVOID param)
+	{
+		RadixLoop(param);
+		return 0;
+	}
+#else
+	static void* RadixThread(void* param)
+	{
+		RadixLoop(param);
+		return 0;
+	}
+#endif
+
+	static RadixWorkers* CreateWorkers(unsigned int count)
+	{
+		RadixWorkers* w = new RadixWorkers();
+		memset(w, 0, sizeof(RadixWorkers));
+		w->count = 1;
+
+		for(unsigned int i = 1; i < count && i < RadixMaxThreads; i++)
+		{
+			RadixWorkerParam* param = new RadixWorkerParam();
+			param->workers = w;
+			param->index = i;
+
+			if(!CreateSignal(w->start[i]))
+			{
+				delete param;
+				break;
+			}
+#ifdef _WIN32
+			w->threads[i] = CreateThread(0, 0, RadixThread, param, 0, 0);
+			bool started = w->threads[i] != 0;
+#else
+			bool started = pthread_create(&w->threads[i], 0, RadixThread, param) == 0;
+#endif
+			if(!started)
+			{
+				DestroySignal(w->start[i]);
+				delete param;
+				break;
+			}
+			w->count++;
+		}
+		return w;
+	}
+
+	static void DestroyWorkers(RadixWorkers* w)
+	{
+		w->quit = 1;
+		for(unsigned int i = 1; i < w->count; i++) Signal(w->start[i]);
+		for(unsigned int i = 1; i < w->count; i++)
+		{
+#ifdef _WIN32
+			WaitForSingleObject(w->threads[i], INFINITE);
+			CloseHandle(w->threads[i]);
+#else
+			pthread_join(w->threads[i], 0);
+#endif
+			DestroySignal(w->start[i]);
+		}
+		delete w;
+	}
+
+	RenderItem* RadixSort(RenderItem* items, RenderItem* temp, unsigned int count, RadixWorkers* workers)
+	{
+		if(count < 2) return items;
+
+		RadixWorkers* local = 0;
+		if(!workers)
+		{
+			local = new RadixWorkers();
+			local->count = 1;
+		}
+		RadixWorkers& w = workers ? *workers : *local;
+
+		unsigned int threads = count / RadixItemsPerThread;
+		if(threads < 1) threads = 1;
+		if(threads > w.count) threads = w.count;
+
+		w.items = items;
+		w.temp = temp;
+		w.size = count;
+		w.active = threads;
+		w.barrier.arrived = 0;
+
+		for(unsigned int i = 1; i < threads; i++) Signal(w.start[i]);
+		RadixRun(w, 0);
+
+		RenderItem* result = w.result;
+		delete local;
+		return result;
+	}
+
+	void RenderQueue::MakeKey(unsigned int layer, bool translucent, float depth,
+		unsigned int pipeline, unsigned int material, RenderItem& item)
+	{
+		if(!(depth > 0.0f)) depth = 0.0f;
+		if(depth > 1.0f) depth = 1.0f;
+		unsigned long long z = (unsigned long long)(depth * 16777215.0f);
+
+		item.key = ((unsigned long long)(layer & 0xF) << 60) | pipeline;
+		item.subkey = (unsigned long long)material << 24;
+		if(translucent)
+		{
+			item.key |= (1ull << 59) | ((0xFFFFFFull - z) << 32);
+		} else {
+			item.subkey |= z;
+		}
+	}
+
+	RenderQueue::RenderQueue(unsigned int threadCount)
+	{
+		if(threadCount == 0)
+		{
+#ifdef _WIN32
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			threadCount = info.dwNumberOfProcessors;
+#else
+			long processors = sysconf(_SC_NPROCESSORS_ONLN);
+			threadCount = processors > 0 ? (unsigned int)processors : 1;
+#endif
+		}
+
+		sorted = 0;
+		maxPipeline = 0;
+		maxMaterial = 0;
+		workers = CreateWorkers(threadCount);
+	}
+
+	RenderQueue::~RenderQueue()
+	{
+		DestroyWorkers(workers);
+	}
+
+	unsigned int RenderQueue::GetThreadCount() const
+	{
+		return workers->count;
+	}
+
+	void RenderQueue::Add(unsigned int layer, bool translucent, float depth, const RenderCommand& command)
+	{
+		RenderItem item;
+		MakeKey(layer, translucent, depth, command.pipeline, command.material, item);
+		item.command = (unsigned int)commands.size();
+		items.push_back(item);
+		commands.push_back(command);
+		sorted = 0;
+
+		if(command.pipeline > maxPipeline) maxPipeline = command.pipeline;
+		if(command.material > maxMaterial) maxMaterial = command.material;
+	}
+
+	static unsigned int BitCount(unsigned int value)
+	{
+		unsigned int bits = 0;
+		for(; value; value >>= 1) bits++;
+		return bits;
+	}
+
+	// Copies items to be sorted with fields moved into first word of key, ids using only as many
+	// bits as largest id of queue. Order is unchanged, but fewer bytes differ, so the sort makes
+	// fewer passes.
+	void RenderQueue::PackKeys(unsigned int pipelineBits, unsigned int materialBits)
+	{
+		const unsigned long long Top = 0x1Full << 59;
+		for(size_t i = 0; i < items.size(); i++)
+		{
+			const RenderItem& item = items[i];
+			unsigned long long pipeline = item.key & 0xFFFFFFFFull;
+			unsigned long long material = item.subkey >> 24;
+			unsigned long long key = item.key & Top;
+			if(item.key & (1ull << 59))
+			{
+				unsigned long long z = (item.key >> 32) & 0xFFFFFF;
+				key |= (z << (pipelineBits + materialBits)) | (pipeline << materialBits) | material;
+			} else {
+				unsigned long long z = item.subkey & 0xFFFFFF;
+				key |= (pipeline << (materialBits + 24)) | (material << 24) | z;
+			}
+			keys[i].key = key;
+			keys[i].subkey = 0;
+			keys[i].command = item.command;
+		}
+	}
+
+	void RenderQueue::Sort()
+	{
+		if(items.empty()) return;
+
+		keys.resize(items.size());
+		unsigned int pipelineBits = BitCount(maxPipeline), materialBits = BitCount(maxMaterial);
+		if(pipelineBits + materialBits + 24 <= 59)
+		{
+			PackKeys(pipelineBits, materialBits);
+		} else {
+			keys = items;
+		}
+
+		temp.resize(items.size());
+		sorted = RadixSort(&keys[0], &temp[0], (unsigned int)items.size(), workers);
+	}
+
+	void RenderQueue::Submit(DrawSink& sink)
+	{
+		if(items.empty()) return;
+		if(!sorted) Sort();
+
+		bool first = true;
+		unsigned int pipeline = 0, material = 0, buffers = 0;
+		for(size_t i = 0; i < items.size(); i++)
+		{
+			const RenderCommand& command = commands[sorted[i].command];
+
+			if(first || command.pipeline != pipeline)
+			{
+				pipeline = command.pipeline;
+				sink.SetPipeline(pipeline);
+			}
+			if(first || command.material != material)
+			{
+				material = command.material;
+				sink.SetMaterial(material);
+			}
+			if(first || command.buffers != buffers)
+			{
+				buffers = command.buffers;
+				sink.SetBuffers(buffers);
+			}
+			first = false;
+
+			sink.DrawIndexedInstanced(command.indexCount, 1, command.startIndex, command.baseVertex, 0);
+		}
+	}
+
+	void RenderQueue::Clear()
+	{
+		items.clear();
+		commands.clear();
+		sorted = 0;
+		maxPipeline = 0;
+		maxMaterial = 0;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include "DrawBatcher.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Items sort by key, then by subkey, as one 128-bit key.
+	struct RenderItem
+	{
+		unsigned long long key;
+		unsigned long long subkey;
+		unsigned int command;		//< Index of command in queue.
+	};
+
+	struct RenderCommand
+	{
+		unsigned int pipeline;
+		unsigned int material;
+		unsigned int buffers;
+		unsigned int indexCount;
+		unsigned int startIndex;
+		int baseVertex;
+	};
+
+	struct RadixWorkers;
+
+	// Sorts items by key and subkey with a LSD radix sort (8 bits per pass). Passes where all
+	// items share the byte are skipped, so unused high bits of ids cost nothing. Large inputs are
+	// split among workers (may be null). Temp must hold count items; returns items or temp,
+	// whichever holds the result.
+	RenderItem* RadixSort(RenderItem* items, RenderItem* temp, unsigned int count, RadixWorkers* workers);
+
+	// Collects draws of a frame, sorts them by packed key and submits them in order.
+	class RenderQueue
+	{
+		std::vector<RenderItem> items;
+		std::vector<RenderItem> keys;		//< Items being sorted, with packed keys.
+		std::vector<RenderItem> temp;
+		std::vector<RenderCommand> commands;
+		RenderItem* sorted;
+		RadixWorkers* workers;
+		unsigned int maxPipeline;
+		unsigned int maxMaterial;
+
+		void PackKeys(unsigned int pipelineBits, unsigned int materialBits);
+	public:
+		// Sets key of item: layer (4 bits), translucency (1 bit), then for opaque draws pipeline,
+		// material and depth (24 bits) front to back, and for translucent draws depth back to front,
+		// pipeline and material. Ids use all 32 bits.
+		static void MakeKey(unsigned int layer, bool translucent, float depth,
+			unsigned int pipeline, unsigned int material, RenderItem& item);
+
+		// Thread count of 0 uses all processors, 1 sorts on calling thread only.
+		RenderQueue(unsigned int threadCount = 0);
+		~RenderQueue();
+
+		// Depth is in [0,1].
+		void Add(unsigned int layer, bool translucent, float depth, const RenderCommand& command);
+
+		void Sort();
+
+		// Submits sorted draws, only changed states are set. Sorts first if needed.
+		void Submit(DrawSink& sink);
+
+		void Clear();
+
+		unsigned int GetCount() const { return (unsigned int)items.size(); }
+
+		// Threads sorting takes part in, including calling thread.
+		unsigned int GetThreadCount() const;
+
+		// Sorted items, valid after Sort until Add or Clear. Their keys may be packed, but order as
+		// keys of MakeKey.
+		const RenderItem* GetSorted() const { return sorted; }
+	};
+
+}
+}
+}
+}
@@ -0,0 +1,54 @@
+#include "ResizeCoalescer.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	ResizeCoalescer::ResizeCoalescer(unsigned int width, unsigned int height)
+	{
+		this->width = this->pendingWidth = width;
+		this->height = this->pendingHeight = height;
+		this->pending = false;
+		this->generation = 0;
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	void ResizeCoalescer::Request(unsigned int width, unsigned int height)
+	{
+		stats.requests++;
+		if(width == 0 || height == 0) return;
+
+		// Later request replaces earlier one; returning to current size cancels it.
+		pendingWidth = width;
+		pendingHeight = height;
+		pending = width != this->width || height != this->height;
+	}
+
+	bool ResizeCoalescer::Take(unsigned int& width, unsigned int& height)
+	{
+		if(!pending) return false;
+
+		width = pendingWidth;
+		height = pendingHeight;
+		return true;
+	}
+
+	void ResizeCoalescer::Applied(unsigned int width, unsigned int height, double seconds)
+	{
+		this->width = width;
+		this->height = height;
+		pending = pendingWidth != width || pendingHeight != height;
+		generation++;
+
+		stats.applied++;
+		stats.lastCost = seconds;
+		stats.totalCost += seconds;
+		if(seconds > stats.maxCost) stats.maxCost = seconds;
+	}
+
+}
+}
+}
+}
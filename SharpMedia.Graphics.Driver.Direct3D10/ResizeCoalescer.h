@@ -0,0 +1,56 @@
+#pragma once
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	struct ResizeStats
+	{
+		unsigned int requests;		//< Resize requests received.
+		unsigned int applied;		//< Resizes applied at frame boundaries.
+		double lastCost;			//< Seconds taken by last applied resize.
+		double maxCost;
+		double totalCost;
+	};
+
+	// Collects resize requests of a window (one per WM_SIZE while dragging) so only last size
+	// of a frame is applied, at frame boundary. Not thread safe, owner must lock.
+	class ResizeCoalescer
+	{
+		unsigned int width, height;			//< Size of buffers.
+		unsigned int pendingWidth, pendingHeight;
+		bool pending;
+		unsigned int generation;
+		ResizeStats stats;
+	public:
+		ResizeCoalescer(unsigned int width, unsigned int height);
+
+		// Zero size (minimized window) is ignored, buffers keep last size.
+		void Request(unsigned int width, unsigned int height);
+
+		// Returns true and new size when buffers must be resized at this frame boundary.
+		bool Take(unsigned int& width, unsigned int& height);
+
+		// Reports size taken was applied and how long it took; failed resize is not reported.
+		// Requests received while resizing stay pending, so lock is not held during resize.
+		void Applied(unsigned int width, unsigned int height, double seconds);
+
+		// Drops pending request, so a failed resize is not retried every frame.
+		void Cancel() { pending = false; }
+
+		bool IsPending() const { return pending; }
+		unsigned int GetWidth() const { return width; }
+		unsigned int GetHeight() const { return height; }
+
+		// Changes with every applied resize; targets sized to buffers compare it at use and
+		// are rebuilt only when it differs.
+		unsigned int GetGeneration() const { return generation; }
+
+		const ResizeStats& GetStats() const { return stats; }
+	};
+
+}
+}
+}
+}
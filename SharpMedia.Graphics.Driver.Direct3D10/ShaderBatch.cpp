@@ -0,0 +1,52 @@
+#include "ShaderBatch.h"
+#include <vector>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	static void Compile(D3D10CompileJob& job)
+	{
+		job.bytecode = 0;
+		job.errors = 0;
+		job.result = D3D10CompileShader(job.hlsl.c_str(), job.hlsl.size(), "",
+			0, 0, "main", job.profile, job.flags, &job.bytecode, &job.errors);
+	}
+
+	static DWORD WINAPI CompileThread(LPVOID param)
+	{
+		Compile(*(D3D10CompileJob*)param);
+		return 0;
+	}
+
+	void CompileJobs(D3D10CompileJob* jobs, unsigned int count)
+	{
+		if(count == 0) return;
+
+		// Other jobs get their own threads, the first one runs on calling thread.
+		std::vector<HANDLE> threads;
+		for(unsigned int i = 1; i < count; i++)
+		{
+			HANDLE thread = CreateThread(0, 0, CompileThread, &jobs[i], 0, 0);
+			if(thread)
+			{
+				threads.push_back(thread);
+			} else {
+				Compile(jobs[i]);
+			}
+		}
+
+		Compile(jobs[0]);
+
+		if(!threads.empty())
+		{
+			WaitForMultipleObjects((DWORD)threads.size(), &threads[0], TRUE, INFINITE);
+			for(size_t i = 0; i < threads.size(); i++) CloseHandle(threads[i]);
+		}
+	}
+
+}
+}
+}
+}
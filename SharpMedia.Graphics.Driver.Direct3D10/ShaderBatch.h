@@ -0,0 +1,28 @@
+#pragma once
+#include <windows.h>
+#include <D3D10.h>
+#include <string>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// A HLSL compilation that does not depend on compiler state, so it can run on any thread.
+	struct D3D10CompileJob
+	{
+		std::string hlsl;
+		const char* profile;
+		UINT flags;
+		ID3D10Blob* bytecode;	//< Result, released by caller.
+		ID3D10Blob* errors;		//< Error messages, released by caller.
+		HRESULT result;
+	};
+
+	// Compiles all jobs; when there is more than one, each runs on its own thread.
+	void CompileJobs(D3D10CompileJob* jobs, unsigned int count);
+
+}
+}
+}
+}
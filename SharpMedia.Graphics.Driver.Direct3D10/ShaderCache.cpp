@@ -0,0 +1,152 @@
+#include "ShaderCache.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	bool ReflectManifest(ID3D10Blob* bytecode, D3D10ShaderManifest& manifest)
+	{
+		manifest.Clear();
+
+		ID3D10ShaderReflection* reflection = 0;
+		if(FAILED(D3D10ReflectShader(bytecode->GetBufferPointer(), bytecode->GetBufferSize(), &reflection)))
+		{
+			return false;
+		}
+
+		D3D10_SHADER_DESC desc;
+		reflection->GetDesc(&desc);
+
+		// Bound resources (samplers, textures and constant buffers).
+		for(UINT i = 0; i < desc.BoundResources; i++)
+		{
+			D3D10_SHADER_INPUT_BIND_DESC bind;
+			if(FAILED(reflection->GetResourceBindingDesc(i, &bind))) continue;
+
+			for(UINT j = 0; j < bind.BindCount; j++)
+			{
+				switch(bind.Type)
+				{
+				case D3D10_SIT_SAMPLER:
+					manifest.UseSampler(bind.BindPoint + j);
+					break;
+				case D3D10_SIT_TEXTURE:
+				case D3D10_SIT_TBUFFER:
+					manifest.UseTexture(bind.BindPoint + j);
+					break;
+				case D3D10_SIT_CBUFFER:
+					{
+						// Size is obtained from buffer with the same name.
+						D3D10_SHADER_BUFFER_DESC bufferDesc;
+						ID3D10ShaderReflectionConstantBuffer* buffer =
+							reflection->GetConstantBufferByName(bind.Name);
+						UINT size = 0;
+						if(buffer && SUCCEEDED(buffer->GetDesc(&bufferDesc))) size = bufferDesc.Size;
+						manifest.UseConstantBuffer(bind.BindPoint + j, size);
+					}
+					break;
+				}
+			}
+		}
+
+		// Input/output signatures.
+		for(UINT i = 0; i < desc.InputParameters; i++)
+		{
+			D3D10_SIGNATURE_PARAMETER_DESC param;
+			if(FAILED(reflection->GetInputParameterDesc(i, &param))) continue;
+
+			D3D10SignatureElement element;
+			element.semantic = param.SemanticName;
+			element.semanticIndex = param.SemanticIndex;
+			element.reg = param.Register;
+			element.mask = param.ReadWriteMask;
+			manifest.inputs.push_back(element);
+		}
+
+		for(UINT i = 0; i < desc.OutputParameters; i++)
+		{
+			D3D10_SIGNATURE_PARAMETER_DESC param;
+			if(FAILED(reflection->GetOutputParameterDesc(i, &param))) continue;
+
+			D3D10SignatureElement element;
+			element.semantic = param.SemanticName;
+			element.semanticIndex = param.SemanticIndex;
+			element.reg = param.Register;
+			element.mask = param.Mask;
+			manifest.outputs.push_back(element);
+		}
+
+		reflection->Release();
+		manifest.reflected = true;
+		return true;
+	}
+
+	D3D10ShaderCache::D3D10ShaderCache()
+	{
+		references = 1;
+		InitializeCriticalSection(&lock);
+	}
+
+	void D3D10ShaderCache::AddRef()
+	{
+		InterlockedIncrement(&references);
+	}
+
+	void D3D10ShaderCache::Release()
+	{
+		if(InterlockedDecrement(&references) == 0) delete this;
+	}
+
+	D3D10ShaderCache::~D3D10ShaderCache()
+	{
+		Clear();
+		DeleteCriticalSection(&lock);
+	}
+
+	ID3D10Blob* D3D10ShaderCache::Find(const std::string& key, D3D10ShaderManifest& manifest)
+	{
+		ID3D10Blob* bytecode = 0;
+
+		EnterCriticalSection(&lock);
+		std::map<std::string, Entry>::iterator i = entries.find(key);
+		if(i != entries.end())
+		{
+			bytecode = i->second.bytecode;
+			bytecode->AddRef();
+			manifest = i->second.manifest;
+		}
+		LeaveCriticalSection(&lock);
+
+		return bytecode;
+	}
+
+	void D3D10ShaderCache::Add(const std::string& key, ID3D10Blob* bytecode, const D3D10ShaderManifest& manifest)
+	{
+		EnterCriticalSection(&lock);
+		std::map<std::string, Entry>::iterator i = entries.find(key);
+		if(i == entries.end())
+		{
+			Entry& entry = entries[key];
+			entry.bytecode = bytecode;
+			entry.manifest = manifest;
+			bytecode->AddRef();
+		}
+		LeaveCriticalSection(&lock);
+	}
+
+	void D3D10ShaderCache::Clear()
+	{
+		EnterCriticalSection(&lock);
+		for(std::map<std::string, Entry>::iterator i = entries.begin(); i != entries.end(); ++i)
+		{
+			i->second.bytecode->Release();
+		}
+		entries.clear();
+		LeaveCriticalSection(&lock);
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <windows.h>
+#include <D3D10.h>
+#include <string>
+#include <map>
+#include "ShaderManifest.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Extracts binding manifest from shader bytecode (using reflection). On failure manifest is
+	// empty; callers use UseAll so every slot is bound.
+	bool ReflectManifest(ID3D10Blob* bytecode, D3D10ShaderManifest& manifest);
+
+	// A per-device cache of compiled bytecode, keyed by generated source (and compile options).
+	// Manifest is stored with bytecode so reflection is performed only once. Cache is shared by
+	// device and its compilers, so it is reference counted.
+	class D3D10ShaderCache
+	{
+		struct Entry
+		{
+			ID3D10Blob* bytecode;
+			D3D10ShaderManifest manifest;
+		};
+
+		std::map<std::string, Entry> entries;
+		CRITICAL_SECTION lock;
+		volatile LONG references;
+
+		~D3D10ShaderCache();
+	public:
+		// Created with one reference.
+		D3D10ShaderCache();
+
+		void AddRef();
+		void Release();
+
+		// Finds bytecode, the returned blob is AddRef-ed. Returns 0 if not cached.
+		ID3D10Blob* Find(const std::string& key, D3D10ShaderManifest& manifest);
+
+		// Adds bytecode and its manifest, cache takes its own reference.
+		void Add(const std::string& key, ID3D10Blob* bytecode, const D3D10ShaderManifest& manifest);
+
+		void Clear();
+	};
+
+}
+}
+}
+}
@@ -1,6 +1,8 @@
 #include "ShaderCompiler.h"
 #include "Helper.h"
 #include "Shaders.h"
+#include "DeviceView.h"
+#include "Trace.h"
 #include <d3dx10.h>
 
 using namespace System::Text;
@@ -10,10 +12,179 @@ namespace Graphics {
 namespace Driver {
 namespace Direct3D10 {
 
-	D3D10ShaderCompiler::D3D10ShaderCompiler(ID3D10Device* device)
+	// IR type of pin format (textures and samplers are scalar placeholders).
+	static ShaderType ToIRType(PinFormat fmt, unsigned int arraySize)
+	{
+		ShaderType type;
+		type.scalar = ShaderScalarFloat;
+		type.rows = 1;
+		type.columns = 1;
+		type.arraySize = arraySize == UInt32::MaxValue ? 0 : arraySize;
+
+		switch(fmt)
+		{
+		case PinFormat::Integerx4: type.columns++;
+		case PinFormat::Integerx3: type.columns++;
+		case PinFormat::Integerx2: type.columns++;
+		case PinFormat::Integer:
+			type.scalar = ShaderScalarInt;
+			break;
+		case PinFormat::UIntegerx4: type.columns++;
+		case PinFormat::UIntegerx3: type.columns++;
+		case PinFormat::UIntegerx2: type.columns++;
+		case PinFormat::UInteger:
+			type.scalar = ShaderScalarUInt;
+			break;
+		case PinFormat::Boolx4: type.columns++;
+		case PinFormat::Boolx3: type.columns++;
+		case PinFormat::Boolx2: type.columns++;
+		case PinFormat::Bool:
+			type.scalar = ShaderScalarBool;
+			break;
+		case PinFormat::Floatx4: type.columns++;
+		case PinFormat::Floatx3: type.columns++;
+		case PinFormat::Floatx2: type.columns++;
+		case PinFormat::Float:
+			break;
+		case PinFormat::Float2x2:
+			type.rows = type.columns = 2;
+			break;
+		case PinFormat::Float3x3:
+			type.rows = type.columns = 3;
+			break;
+		case PinFormat::Float4x4:
+			type.rows = type.columns = 4;
+			break;
+		default:
+			break;
+		}
+
+		return type;
+	}
+
+	// Fixed values as floats, formats match ToDXValue.
+	static void ToIRValue(PinFormat fmt, Object^ data, std::vector<float>& values)
+	{
+		// Arrays are element after element.
+		Array^ elements = dynamic_cast<Array^>(data);
+		if(elements != nullptr)
+		{
+			for(int i = 0; i < elements->Length; i++) ToIRValue(fmt, elements->GetValue(i), values);
+			return;
+		}
+
+		switch(fmt)
+		{
+		case PinFormat::Bool:
+			values.push_back(*((Boolean^)data) ? 1.0f : 0.0f);
+			break;
+		case PinFormat::Float2x2:
+		case PinFormat::Float3x3:
+		case PinFormat::Float4x4:
+			{
+				// Row-major, as HLSL matrix constructors.
+				unsigned int n = fmt == PinFormat::Float2x2 ? 2 : (fmt == PinFormat::Float3x3 ? 3 : 4);
+				for(unsigned int row = 0; row < n; row++)
+				{
+					for(unsigned int col = 0; col < n; col++)
+					{
+						switch(n)
+						{
+						case 2: values.push_back(((SharpMedia::Math::Matrix::Matrix2x2f^)data)->default[row, col]); break;
+						case 3: values.push_back(((SharpMedia::Math::Matrix::Matrix3x3f^)data)->default[row, col]); break;
+						default: values.push_back(((SharpMedia::Math::Matrix::Matrix4x4f^)data)->default[row, col]); break;
+						}
+					}
+				}
+			}
+			break;
+		case PinFormat::Float:
+			values.push_back(*((Single^)data));
+			break;
+		case PinFormat::Floatx2:
+			{
+				Vector2f v = *((Vector2f^)data);
+				values.push_back(v.X); values.push_back(v.Y);
+			}
+			break;
+		case PinFormat::Floatx3:
+			{
+				Vector3f v = *((Vector3f^)data);
+				values.push_back(v.X); values.push_back(v.Y); values.push_back(v.Z);
+			}
+			break;
+		case PinFormat::Floatx4:
+			{
+				Vector4f v = *((Vector4f^)data);
+				values.push_back(v.X); values.push_back(v.Y); values.push_back(v.Z); values.push_back(v.W);
+			}
+			break;
+		case PinFormat::Integer:
+			values.push_back((float)*((Int32^)data));
+			break;
+		case PinFormat::UInteger:
+			values.push_back((float)*((UInt32^)data));
+			break;
+		case PinFormat::Integerx2:
+			{
+				Vector2i v = *((Vector2i^)data);
+				values.push_back((float)v.X); values.push_back((float)v.Y);
+			}
+			break;
+		case PinFormat::Integerx3:
+			{
+				Vector3i v = *((Vector3i^)data);
+				values.push_back((float)v.X); values.push_back((float)v.Y); values.push_back((float)v.Z);
+			}
+			break;
+		case PinFormat::Integerx4:
+			{
+				Vector4i v = *((Vector4i^)data);
+				values.push_back((float)v.X); values.push_back((float)v.Y);
+				values.push_back((float)v.Z); values.push_back((float)v.W);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Compile flags of profile (without matrix packing).
+	static UINT ToDXCompileFlags(Shaders::ShaderCompileProfile profile)
+	{
+		switch(profile)
+		{
+		case Shaders::ShaderCompileProfile::Debug:
+			return D3D10_SHADER_DEBUG | D3D10_SHADER_SKIP_OPTIMIZATION | 
+				D3D10_SHADER_IEEE_STRICTNESS | D3D10_SHADER_PREFER_FLOW_CONTROL;
+		case Shaders::ShaderCompileProfile::Development:
+			return D3D10_SHADER_DEBUG | D3D10_SHADER_OPTIMIZATION_LEVEL1;
+		case Shaders::ShaderCompileProfile::Shipping:
+			return D3D10_SHADER_OPTIMIZATION_LEVEL3 | D3D10_SHADER_SKIP_VALIDATION;
+		default:
+			NOT_SUPPORTED();
+		}
+	}
+
+	// Shader that cannot be reflected gets all slots bound, as without manifests.
+	static void ReflectOrBindAll(ID3D10Blob* bytecode, D3D10ShaderManifest& manifest)
+	{
+		if(ReflectManifest(bytecode, manifest)) return;
+
+		Common::Warning(D3D10ShaderCompiler::typeid, "Shader bindings could not be reflected, all slots are bound.");
+		manifest.UseAll();
+	}
+
+	D3D10ShaderCompiler::D3D10ShaderCompiler(ID3D10Device* device, D3D10ShaderCache* cache, 
+		Shaders::ShaderCompileProfile profile)
 	{
 		this->device = device;
+		this->cache = cache;
+		this->profile = profile;
+		if(cache) cache->AddRef();
 		this->data = new D3D10CompilationData;
+		this->stages = new D3D10CompilationData*[3];
+		this->stages[0] = this->stages[1] = this->stages[2] = 0;
 		device->AddRef();
 	}
 
@@ -21,11 +192,25 @@ namespace Direct3D10 {
 	{
 		// Make sure we release reference.
 		device->Release();
+		if(cache) cache->Release();
 		delete this->data;
+		for(int i = 0; i < 3; i++) delete this->stages[i];
+		delete [] this->stages;
+	}
+
+	Shaders::ShaderCompileProfile D3D10ShaderCompiler::Profile::get()
+	{
+		return profile;
+	}
+
+	void D3D10ShaderCompiler::Profile::set(Shaders::ShaderCompileProfile value)
+	{
+		profile = value;
 	}
 
 	IShaderBase^ D3D10ShaderCompiler::Compile(BindingStage t, String^ filename)
 	{
+		D3D10_TRACE_SCOPE("D3D10ShaderCompiler::Compile");
 		// Choose a profile.
 		const char* profile = 0;
 		switch(t)
@@ -61,7 +246,7 @@ namespace Direct3D10 {
 
 			// We have complete shader, we compile it now.
 			if(FAILED(D3DX10CompileFromFile(buffer, 
-				0, 0, "main", profile, 0, D3D10_SHADER_DEBUG, 0, &bytecode, &errors, 0)))
+				0, 0, "main", profile, ToDXCompileFlags(this->profile), 0, 0, &bytecode, &errors, 0)))
 			{
 				String^ errorString = gcnew String((char*)errors->GetBufferPointer());
 				throw gcnew Exception(errorString);
@@ -74,44 +259,49 @@ namespace Direct3D10 {
 
 		// We construct shader.
 		try {
+			D3D10ShaderManifest manifest;
+			ReflectOrBindAll(bytecode, manifest);
 
-			// We have valid shader, all we need is to compile it.
-			switch(t)
-			{
-			case BindingStage::PixelShader:
-				{
-					ID3D10PixelShader* shader;
-					DXFAILED(device->CreatePixelShader(bytecode->GetBufferPointer(), 
-						bytecode->GetBufferSize(), &shader));
+			return CreateShader(t, bytecode, manifest);
+		} finally
+		{
+			if(bytecode != 0) bytecode->Release();
+		}
+	}
 
-					// We have a valid shader, return it.
-					return gcnew D3D10PShader(shader);
-				}
-			case BindingStage::VertexShader:
-				{
-					ID3D10VertexShader* shader;
-					DXFAILED(device->CreateVertexShader(bytecode->GetBufferPointer(), 
-						bytecode->GetBufferSize(), &shader));
+	IShaderBase^ D3D10ShaderCompiler::CreateShader(BindingStage t, ID3D10Blob* bytecode, const D3D10ShaderManifest& manifest)
+	{
+		switch(t)
+		{
+		case BindingStage::PixelShader:
+			{
+				ID3D10PixelShader* shader;
+				DXFAILED(device->CreatePixelShader(bytecode->GetBufferPointer(), 
+					bytecode->GetBufferSize(), &shader));
 
-					// We have a valid shader, return it.
-					return gcnew D3D10VShader(shader);
-				}
-			case BindingStage::GeometryShader:
-				{
-					ID3D10GeometryShader* shader;
-					DXFAILED(device->CreateGeometryShader(bytecode->GetBufferPointer(), 
-						bytecode->GetBufferSize(), &shader));
+				// We have a valid shader, return it.
+				return gcnew D3D10PShader(shader, manifest);
+			}
+		case BindingStage::VertexShader:
+			{
+				ID3D10VertexShader* shader;
+				DXFAILED(device->CreateVertexShader(bytecode->GetBufferPointer(), 
+					bytecode->GetBufferSize(), &shader));
 
-					// We have a valid shader, return it.
-					return gcnew D3D10GShader(shader);
-				}
-			default:
-				NOT_SUPPORTED();
+				// We have a valid shader, return it.
+				return gcnew D3D10VShader(shader, manifest);
 			}
+		case BindingStage::GeometryShader:
+			{
+				ID3D10GeometryShader* shader;
+				DXFAILED(device->CreateGeometryShader(bytecode->GetBufferPointer(), 
+					bytecode->GetBufferSize(), &shader));
 
-		} finally
-		{
-			if(bytecode != 0) bytecode->Release();
+				// We have a valid shader, return it.
+				return gcnew D3D10GShader(shader, bytecode, manifest);
+			}
+		default:
+			NOT_SUPPORTED();
 		}
 	}
 
@@ -122,18 +312,26 @@ namespace Direct3D10 {
 		// We clear all text.
 		data->code.clear();
 		data->inputs.clear();
-		data->outputs.clear();
 		data->texturesAndSamplers.clear();
 		for(unsigned int i = 0; i < Shaders::ConstantBufferLayout::MaxConstantBufferBindingSlots; i++)
 		{
 			data->uniforms[i].clear();
 		}
 
+		data->outputs.clear();
+		data->outputLocals.clear();
+		data->outputOrder.clear();
+		data->outputsLinked = false;
+
 		// We try to guess capacity.
 		data->code.reserve(2048);
 		data->inputs.reserve(256);
-		data->outputs.reserve(256);	
 		data->outCounter = 0;
+		data->program.Clear();
+		data->flowOffsets.clear();
+		data->flowInstructions.clear();
+		data->nextHint = ShaderFlowAuto;
+		data->nextUnroll = 0;
 	}
 
 	void D3D10ShaderCompiler::Sample(int sampler, int texture, int pos, int off, int result)
@@ -154,6 +352,7 @@ namespace Direct3D10 {
 		c.append(");");
 
 		data->code.append(c);
+		data->program.Emit(ShaderOpSample, result, sampler, texture, pos, off);
 	}
 
 	void D3D10ShaderCompiler::Load(int texture, int pos, int offset, int result)
@@ -172,6 +371,7 @@ namespace Direct3D10 {
 		c.append(");");
 
 		data->code.append(c);
+		data->program.Emit(ShaderOpLoad, result, texture, pos, offset);
 	}
 
 	void D3D10ShaderCompiler::Min(int n1, int n2, int dst)
@@ -185,6 +385,7 @@ namespace Direct3D10 {
 		c.append(");");
 
 		data->code.append(c);
+		data->program.Emit(ShaderOpMin, dst, n1, n2);
 	}
 
 	void D3D10ShaderCompiler::Max(int n1, int n2, int dst)
@@ -198,6 +399,7 @@ namespace Direct3D10 {
 		c.append(");");
 
 		data->code.append(c);
+		data->program.Emit(ShaderOpMax, dst, n1, n2);
 	}
 
 	void D3D10ShaderCompiler::RegisterSampler(int n, unsigned int reg)
@@ -209,33 +411,44 @@ namespace Direct3D10 {
 		c.append(");");
 		
 		data->texturesAndSamplers.append(c);
+
+		int r = data->program.Declare(n, ShaderRegisterSampler, ToIRType(PinFormat::Sampler, UInt32::MaxValue));
+		data->program.registers[r].slot = reg;
 	}
 
 	void D3D10ShaderCompiler::RegisterTexture(int n, PinFormat fmt, PinFormat textureFmt, UInt32 reg)
 	{
 		std::string type;
+		ShaderTextureDimension dimension;
 		switch(fmt)
 		{
 		case PinFormat::Texture1D:
 			type = "Texture1D";
+			dimension = ShaderDimension1D;
 			break;
 		case PinFormat::Texture1DArray:
 			type = "Texture1DArray";
+			dimension = ShaderDimension1DArray;
 			break;
 		case PinFormat::Texture2D:
 			type = "Texture2D";
+			dimension = ShaderDimension2D;
 			break;
 		case PinFormat::Texture2DArray:
 			type = "Texture2DArray";
+			dimension = ShaderDimension2DArray;
 			break;
 		case PinFormat::TextureCube:
 			type = "TextureCube";
+			dimension = ShaderDimensionCube;
 			break;
 		case PinFormat::Texture3D:
 			type = "Texture3D";
+			dimension = ShaderDimension3D;
 			break;
 		case PinFormat::BufferTexture:
 			type = "Buffer";
+			dimension = ShaderDimensionBuffer;
 			break;
 		default:
 			NOT_SUPPORTED();
@@ -256,28 +469,33 @@ namespace Direct3D10 {
 
 
 		data->texturesAndSamplers.append(c);
+
+		// Texture register has the type of fetched values.
+		int r = data->program.Declare(n, ShaderRegisterTexture, ToIRType(textureFmt, UInt32::MaxValue));
+		data->program.registers[r].slot = reg;
+		data->program.registers[r].dimension = dimension;
 	}
 
-	ID3D10Blob* D3D10ShaderCompiler::EndBytecode()
+	const char* D3D10ShaderCompiler::StageProfile(BindingStage t)
 	{
-		// Choose a profile.
-		const char* profile = 0;
-		switch(shaderType)
+		switch(t)
 		{
 		case BindingStage::GeometryShader:
-			profile = D3D10GetGeometryShaderProfile(device);
-			break;
+			return D3D10GetGeometryShaderProfile(device);
 		case BindingStage::PixelShader:
-			profile = D3D10GetPixelShaderProfile(device);
-			break;
+			return D3D10GetPixelShaderProfile(device);
 		case BindingStage::VertexShader:
-			profile = D3D10GetVertexShaderProfile(device);
-			break;
+			return D3D10GetVertexShaderProfile(device);
+		default:
+			NOT_SUPPORTED();
 		}
+	}
 
+	static std::string BuildHLSL(D3D10CompilationData* data)
+	{
 		// We create a code buffer and make sure we reserve buffer big enough.
 		std::string hlsl;
-		hlsl.reserve(data->code.size()+data->inputs.size()+data->outputs.size()+512);
+		hlsl.reserve(data->code.size()+data->inputs.size()+data->outputs.size()*32+512);
 
 		// We start writing a shader.
 		
@@ -304,35 +522,131 @@ namespace Direct3D10 {
 
 		hlsl.append("void main(");
 		hlsl.append(data->inputs);
-		hlsl.append(data->outputs);
+
+		// Linked outputs are written in consumer's order, the rest become locals.
+		std::string locals;
+		if(!data->outputsLinked)
+		{
+			for(size_t i = 0; i < data->outputs.size(); i++) hlsl.append(data->outputs[i]);
+		} else {
+			std::vector<unsigned char> live(data->outputs.size(), 0);
+			for(size_t i = 0; i < data->outputOrder.size(); i++)
+			{
+				hlsl.append(data->outputs[data->outputOrder[i]]);
+				live[data->outputOrder[i]] = 1;
+			}
+			for(size_t i = 0; i < data->outputs.size(); i++)
+			{
+				if(!live[i]) locals.append(data->outputLocals[i]);
+			}
+		}
 
 		// Make sure we overwrite last ',' with ')'.
-		hlsl.replace(hlsl.size()-1, 1, ")");
+		if(hlsl[hlsl.size()-1] == ',')
+		{
+			hlsl.replace(hlsl.size()-1, 1, ")");
+		} else {
+			hlsl.append(")");
+		}
 		hlsl.append("{\n");
-		hlsl.append(data->code);
+		hlsl.append(locals);
+
+		// Instruction stream is resolved, flow control attributes are chosen from it.
+		if(!data->program.Link())
+		{
+			Common::Warning(D3D10ShaderCompiler::typeid, "Shader instruction stream is malformed and cannot be interpreted.");
+			hlsl.append(data->code);
+		} else {
+			// Attributes are inserted where blocks were opened.
+			hlsl.append(data->program.InsertFlowAttributes(data->code, data->flowOffsets, data->flowInstructions));
+		}
 		hlsl.append("}\n");
 
+		return hlsl;
+	}
 
-		ID3D10Blob* bytecode = 0, *errors = 0;
-		try {
+	void D3D10ShaderCompiler::CompileStages(D3D10CompilationData** list, const char** profiles, 
+		unsigned int count, ID3D10Blob** bytecodes, D3D10ShaderManifest* manifests)
+	{
+		D3D10_TRACE_SCOPE("D3D10ShaderCompiler::CompileStages");
+		UINT flags = ToDXCompileFlags(this->profile) | D3D10_SHADER_PACK_MATRIX_ROW_MAJOR;
 
-		// We have complete shader, we compile it now.
-		if(FAILED(D3D10CompileShader(hlsl.c_str(), hlsl.size(), "", 
-			0, 0, "main", profile, D3D10_SHADER_PACK_MATRIX_ROW_MAJOR, &bytecode, &errors)))
+		std::vector<std::string> keys(count);
+		std::vector<D3D10CompileJob> jobs;
+		std::vector<unsigned int> jobStages;
+		jobs.reserve(count);
+
+		for(unsigned int i = 0; i < count; i++)
 		{
-			Console::WriteLine(gcnew String(hlsl.c_str()));
-			Common::Error(D3D10ShaderCompiler::typeid, gcnew String(hlsl.c_str()));
+			bytecodes[i] = 0;
+			std::string hlsl = BuildHLSL(list[i]);
+
+			// The same source was already compiled on this device (with the same flags).
+			keys[i] = profiles[i];
+			keys[i].append("\n");
+			keys[i].append(ConvToString(flags));
+			keys[i].append("\n");
+			keys[i].append(hlsl);
+			if(cache)
+			{
+				bytecodes[i] = cache->Find(keys[i], manifests[i]);
+				if(bytecodes[i]) continue;
+			}
 
-			String^ errorString = gcnew String((char*)errors->GetBufferPointer());
-			throw gcnew Exception(errorString);
-		} else {
-			Console::WriteLine(gcnew String(hlsl.c_str()));
-			Common::Error(D3D10ShaderCompiler::typeid, gcnew String(hlsl.c_str()));
+			D3D10CompileJob job;
+			job.hlsl.swap(hlsl);
+			job.profile = profiles[i];
+			job.flags = flags;
+			jobs.push_back(job);
+			jobStages.push_back(i);
 		}
 
-		} finally {
-			if(errors != 0) errors->Release();
+		// We have complete shaders, we compile them now (independent ones in parallel).
+		if(!jobs.empty()) CompileJobs(&jobs[0], (unsigned int)jobs.size());
+
+		String^ errorString = nullptr;
+		for(size_t j = 0; j < jobs.size(); j++)
+		{
+			D3D10CompileJob& job = jobs[j];
+			if(FAILED(job.result))
+			{
+				// Source of failed shader is logged with its errors.
+				Console::WriteLine(gcnew String(job.hlsl.c_str()));
+				Common::Error(D3D10ShaderCompiler::typeid, gcnew String(job.hlsl.c_str()));
+				if(errorString == nullptr)
+				{
+					errorString = job.errors ? gcnew String((char*)job.errors->GetBufferPointer())
+						: "Shader compilation failed.";
+				}
+			} else {
+				// Manifest is extracted once and stored with the bytecode.
+				unsigned int i = jobStages[j];
+				bytecodes[i] = job.bytecode;
+				ReflectOrBindAll(job.bytecode, manifests[i]);
+				if(cache) cache->Add(keys[i], job.bytecode, manifests[i]);
+			}
+
+			if(job.errors) job.errors->Release();
+		}
+
+		if(errorString != nullptr)
+		{
+			for(unsigned int i = 0; i < count; i++)
+			{
+				if(bytecodes[i]) bytecodes[i]->Release();
+				bytecodes[i] = 0;
+			}
+			throw gcnew Exception(errorString);
 		}
+	}
+
+	ID3D10Blob* D3D10ShaderCompiler::EndBytecode(D3D10ShaderManifest& manifest)
+	{
+		D3D10CompilationData* stage = data;
+		const char* profile = StageProfile(shaderType);
+
+		ID3D10Blob* bytecode = 0;
+		CompileStages(&stage, &profile, 1, &bytecode, &manifest);
 		return bytecode;
 	}
 
@@ -342,47 +656,147 @@ namespace Direct3D10 {
 		ID3D10Blob* bytecode = 0;
 		try {
 			// Obtain bytecode first.
-			bytecode = EndBytecode();
+			D3D10ShaderManifest manifest;
+			bytecode = EndBytecode(manifest);
 
 			// We have valid shader, all we need is to compile it.
-			switch(shaderType)
+			return CreateShader(shaderType, bytecode, manifest);
+
+		} finally
+		{
+			if(bytecode != 0) bytecode->Release();
+		}
+
+	}
+
+	static int StageIndex(BindingStage t)
+	{
+		switch(t)
+		{
+		case BindingStage::VertexShader:
+			return 0;
+		case BindingStage::GeometryShader:
+			return 1;
+		case BindingStage::PixelShader:
+			return 2;
+		default:
+			NOT_SUPPORTED();
+		}
+	}
+
+	void D3D10ShaderCompiler::EndStage()
+	{
+		// Recorded stage is kept as is, new data is used for next stage.
+		int index = StageIndex(shaderType);
+		delete stages[index];
+		stages[index] = data;
+		data = new D3D10CompilationData;
+	}
+
+	// Producer writes exactly what consumer reads, in consumer's order. Values generated by
+	// hardware are not read from producer and values used by the rasterizer are always kept.
+	static void LinkStages(D3D10CompilationData* producer, D3D10CompilationData* consumer)
+	{
+		std::vector<unsigned long long> generated, kept;
+		generated.push_back((unsigned long long)PinComponent::VertexID);
+		generated.push_back((unsigned long long)PinComponent::PrimitiveID);
+		generated.push_back((unsigned long long)PinComponent::InstanceID);
+		kept.push_back((unsigned long long)PinComponent::Position);
+		kept.push_back((unsigned long long)PinComponent::RenderTargetArrayIndex);
+		kept.push_back((unsigned long long)PinComponent::ViewportArrayIndex);
+
+		unsigned long long missing;
+		if(!producer->program.LinkOutputs(consumer->program, generated, kept, producer->outputOrder, missing))
+		{
+			throw gcnew Exception(String::Format("Shader stage reads {0} that previous stage does not write.",
+				((PinComponent)(Int64)missing).ToString()));
+		}
+
+		producer->outputsLinked = true;
+	}
+
+	IShaderPipeline^ D3D10ShaderCompiler::CompilePipeline(array<VertexBindingElement>^ layout)
+	{
+		D3D10CompilationData* vs = stages[0];
+		D3D10CompilationData* gs = stages[1];
+		D3D10CompilationData* ps = stages[2];
+
+		try {
+			if(!vs || !ps)
 			{
-			case BindingStage::PixelShader:
-				{
-					ID3D10PixelShader* shader;
-					DXFAILED(device->CreatePixelShader(bytecode->GetBufferPointer(), 
-						bytecode->GetBufferSize(), &shader));
+				throw gcnew Exception("Pipeline requires vertex and pixel shader stages.");
+			}
 
-					// We have a valid shader, return it.
-					return gcnew D3D10PShader(shader);
-				}
-			case BindingStage::VertexShader:
-				{
-					ID3D10VertexShader* shader;
-					DXFAILED(device->CreateVertexShader(bytecode->GetBufferPointer(), 
-						bytecode->GetBufferSize(), &shader));
+			// Signatures are linked first, unused interpolants are removed (instruction streams
+			// are linked when HLSL is built).
+			ps->outputsLinked = false;
+			if(gs)
+			{
+				LinkStages(vs, gs);
+				LinkStages(gs, ps);
+			} else {
+				LinkStages(vs, ps);
+			}
 
-					// We have a valid shader, return it.
-					return gcnew D3D10VShader(shader);
+			D3D10CompilationData* list[3];
+			const char* profiles[3];
+			unsigned int count = 0;
+			list[count] = vs;
+			profiles[count++] = StageProfile(BindingStage::VertexShader);
+			if(gs)
+			{
+				list[count] = gs;
+				profiles[count++] = StageProfile(BindingStage::GeometryShader);
+			}
+			list[count] = ps;
+			profiles[count++] = StageProfile(BindingStage::PixelShader);
+
+			ID3D10Blob* bytecodes[3] = { 0, 0, 0 };
+			D3D10ShaderManifest manifests[3];
+			IVShader^ vshader = nullptr;
+			IGShader^ gshader = nullptr;
+			IPShader^ pshader = nullptr;
+			IVerticesBindingLayout^ binding = nullptr;
+			try {
+				CompileStages(list, profiles, count, bytecodes, manifests);
+
+				vshader = (IVShader^)CreateShader(BindingStage::VertexShader, bytecodes[0], manifests[0]);
+				if(gs)
+				{
+					gshader = (IGShader^)CreateShader(BindingStage::GeometryShader, bytecodes[1], manifests[1]);
 				}
-			case BindingStage::GeometryShader:
+				pshader = (IPShader^)CreateShader(BindingStage::PixelShader, 
+					bytecodes[count-1], manifests[count-1]);
+
+				// Input layout uses vertex shader's own signature, no dummy shader is needed.
+				if(layout != nullptr)
 				{
-					ID3D10GeometryShader* shader;
-					DXFAILED(device->CreateGeometryShader(bytecode->GetBufferPointer(), 
-						bytecode->GetBufferSize(), &shader));
+					binding = D3D10DeviceView::CreateInputLayout(device, layout, bytecodes[0]);
+				}
 
-					// We have a valid shader, return it.
-					return gcnew D3D10GShader(shader);
+				return gcnew D3D10ShaderPipeline(vshader, gshader, pshader, binding);
+			} catch(Exception^)
+			{
+				// Objects created before the failure are released.
+				delete vshader;
+				delete gshader;
+				delete pshader;
+				delete binding;
+				throw;
+			} finally {
+				for(unsigned int i = 0; i < count; i++)
+				{
+					if(bytecodes[i]) bytecodes[i]->Release();
 				}
-			default:
-				NOT_SUPPORTED();
 			}
-
-		} finally
-		{
-			if(bytecode != 0) bytecode->Release();
+		} finally {
+			// Stages are consumed.
+			for(int i = 0; i < 3; i++)
+			{
+				delete stages[i];
+				stages[i] = 0;
+			}
 		}
-
 	}
 
 
@@ -422,6 +836,19 @@ namespace Direct3D10 {
 		c.append(");");
 
 		data->code.append(c);
+
+		ShaderFunctionCode code;
+		switch(function)
+		{
+		case Shaders::ShaderFunction::Floor: code = ShaderFunctionFloor; break;
+		case Shaders::ShaderFunction::Abs: code = ShaderFunctionAbs; break;
+		case Shaders::ShaderFunction::Length: code = ShaderFunctionLength; break;
+		case Shaders::ShaderFunction::All: code = ShaderFunctionAll; break;
+		case Shaders::ShaderFunction::Any: code = ShaderFunctionAny; break;
+		case Shaders::ShaderFunction::Ceil: code = ShaderFunctionCeil; break;
+		default: code = ShaderFunctionNone; break;
+		}
+		data->program.Emit(ShaderOpCall, n2, n1, -1, -1, -1, code);
 	}
 
 	void D3D10ShaderCompiler::Convert(int n, PinFormat outFormat, int result)
@@ -435,6 +862,7 @@ namespace Direct3D10 {
 		c.append(";");
 
 		data->code.append(c);
+		data->program.Emit(ShaderOpConvert, result, n);
 	}
 
 
@@ -473,6 +901,17 @@ namespace Direct3D10 {
 
 		data->code.append(c);
 
+		ShaderCompareCode code;
+		switch(function)
+		{
+		case States::CompareFunction::LessEqual: code = ShaderCompareLessEqual; break;
+		case States::CompareFunction::Less: code = ShaderCompareLess; break;
+		case States::CompareFunction::Greater: code = ShaderCompareGreater; break;
+		case States::CompareFunction::GreaterEqual: code = ShaderCompareGreaterEqual; break;
+		case States::CompareFunction::Equal: code = ShaderCompareEqual; break;
+		default: code = ShaderCompareNotEqual; break;
+		}
+		data->program.Emit(ShaderOpCompare, r, n1, n2, -1, -1, code);
 	}
 
 	void D3D10ShaderCompiler::RegisterInput(int n, PinFormat fmt, PinComponent component)
@@ -487,6 +926,11 @@ namespace Direct3D10 {
 
 		// Add to inputs.
 		data->inputs.append(input);
+
+		int r = data->program.Declare(n, ShaderRegisterInput, ToIRType(fmt, UInt32::MaxValue));
+		data->program.registers[r].slot = (unsigned int)data->program.inputs.size();
+		data->program.inputs.push_back(r);
+		data->program.inputComponents.push_back((unsigned long long)component);
 	}
 
 	void D3D10ShaderCompiler::RegisterConstant(int n, PinFormat fmt, unsigned int arraySize,
@@ -516,6 +960,10 @@ namespace Direct3D10 {
 
 		// Add to correct uniforms.
 		data->uniforms[buffer].append(uniform);
+
+		int r = data->program.Declare(n, ShaderRegisterConstant, ToIRType(fmt, arraySize));
+		data->program.registers[r].slot = buffer;
+		data->program.registers[r].offset = position;
 	}
 
 	void D3D10ShaderCompiler::RegisterFixed(int n, PinFormat fmt, unsigned int arraySize, Object^ _data)
@@ -536,6 +984,9 @@ namespace Direct3D10 {
 
 		// Add to code (inline).
 		data->code.append(c);
+
+		int r = data->program.Declare(n, ShaderRegisterFixed, ToIRType(fmt, arraySize));
+		ToIRValue(fmt, _data, data->program.registers[r].data);
 	}
 
 	void D3D10ShaderCompiler::RegisterTemp(int n, PinFormat fmt, unsigned int arraySize)
@@ -553,6 +1004,8 @@ namespace Direct3D10 {
 
 		// Add temporary to code.
 		data->code.append(c);
+
+		data->program.Declare(n, ShaderRegisterTemp, ToIRType(fmt, arraySize));
 	}
 
 	void D3D10ShaderCompiler::BinaryOp(int n1, int n2, int dst, std::string op)
@@ -573,21 +1026,25 @@ namespace Direct3D10 {
 	void D3D10ShaderCompiler::Add(int n1, int n2, int name)
 	{
 		BinaryOp(n1, n2, name, "+");
+		data->program.Emit(ShaderOpAdd, name, n1, n2);
 	}
 
 	void D3D10ShaderCompiler::Sub(int n1, int n2, int name)
 	{
 		BinaryOp(n1, n2, name, "-");
+		data->program.Emit(ShaderOpSub, name, n1, n2);
 	}
 
 	void D3D10ShaderCompiler::Div(int n1, int n2, int name)
 	{
 		BinaryOp(n1, n2, name, "/");
+		data->program.Emit(ShaderOpDiv, name, n1, n2);
 	}
 
 	void D3D10ShaderCompiler::Mul(int n1, int n2, int name)
 	{
 		BinaryOp(n1, n2, name, "*");
+		data->program.Emit(ShaderOpMul, name, n1, n2);
 	}
 
 	void D3D10ShaderCompiler::MulEx(int n1, int n2, int name)
@@ -602,6 +1059,7 @@ namespace Direct3D10 {
 
 		// Add instruction to code.
 		data->code.append(c);
+		data->program.Emit(ShaderOpMulEx, name, n1, n2);
 	}
 
 	void D3D10ShaderCompiler::Dot(int n1, int n2, int name)
@@ -616,6 +1074,7 @@ namespace Direct3D10 {
 
 		// Add instruction to code.
 		data->code.append(c);
+		data->program.Emit(ShaderOpDot, name, n1, n2);
 	}
 
 	void D3D10ShaderCompiler::Swizzle(int n, SwizzleMask^ mask, int name)
@@ -630,10 +1089,61 @@ namespace Direct3D10 {
 
 		// Add to code.
 		data->code.append(c);
+
+		// Mask was validated by ToDXSwizzle (vectors only).
+		ShaderInstruction& instr = data->program.Emit(ShaderOpSwizzle, name, n);
+		instr.param = mask->ColumnCount;
+		for(UInt32 i = 0; i < mask->ColumnCount && i < 4; i++)
+		{
+			instr.swizzle[i] = (unsigned char)mask[i];
+		}
+	}
+
+	void D3D10ShaderCompiler::SetFlowHint(Shaders::FlowControlHint hint, UInt32 unrollCount)
+	{
+		switch(hint)
+		{
+		case Shaders::FlowControlHint::Branch:
+			data->nextHint = ShaderFlowBranch;
+			break;
+		case Shaders::FlowControlHint::Flatten:
+			data->nextHint = ShaderFlowFlatten;
+			break;
+		case Shaders::FlowControlHint::Loop:
+			data->nextHint = ShaderFlowLoop;
+			break;
+		case Shaders::FlowControlHint::Unroll:
+			data->nextHint = ShaderFlowUnroll;
+			break;
+		case Shaders::FlowControlHint::ForceCase:
+			data->nextHint = ShaderFlowForceCase;
+			break;
+		default:
+			data->nextHint = ShaderFlowAuto;
+			break;
+		}
+		data->nextUnroll = unrollCount;
+	}
+
+	void D3D10ShaderCompiler::BeginFlow(ShaderOpcode op, int n)
+	{
+		// Attribute is inserted at this position at End, when whole program is known.
+		data->flowOffsets.push_back(data->code.size());
+		data->flowInstructions.push_back((int)data->program.instructions.size());
+
+		ShaderInstruction& instr = data->program.Emit(op, -1, n);
+		instr.hint = data->nextHint;
+		instr.param = data->nextUnroll;
+
+		// Hint applies to one block only.
+		data->nextHint = ShaderFlowAuto;
+		data->nextUnroll = 0;
 	}
 
 	void D3D10ShaderCompiler::BeginIf(int n)
 	{
+		BeginFlow(ShaderOpIf, n);
+
 		std::string c("if(_");
 		c.append(ConvToString(n));
 		c.append(") {");
@@ -646,15 +1156,19 @@ namespace Direct3D10 {
 	{
 		// Add to code.
 		data->code.append(" } else { ");
+		data->program.Emit(ShaderOpElse, -1);
 	}
 
     void D3D10ShaderCompiler::EndIf()
 	{
 		data->code.append("}");
+		data->program.Emit(ShaderOpEndIf, -1);
 	}
 
     void D3D10ShaderCompiler::BeginWhile()
 	{
+		BeginFlow(ShaderOpWhile, -1);
+
 		std::string c("while(1) {");
 
 		data->code.append(c);
@@ -667,15 +1181,19 @@ namespace Direct3D10 {
 		c.append(") break;");
 
 		data->code.append(c);
+		data->program.Emit(ShaderOpBreak, -1, n);
 	}
 
     void D3D10ShaderCompiler::EndWhile()
 	{
 		data->code.append("}");
+		data->program.Emit(ShaderOpEndWhile, -1);
 	}
 
     void D3D10ShaderCompiler::BeginSwitch(int n)
 	{
+		BeginFlow(ShaderOpSwitch, n);
+
 		std::string c("switch(_");
 		c.append(ConvToString(n));
 		c.append(") {");
@@ -692,11 +1210,13 @@ namespace Direct3D10 {
 
 
 		data->code.append(c);
+		data->program.Emit(ShaderOpCase, -1, n);
 	}
 
     void D3D10ShaderCompiler::BeginDefault()
 	{
 		data->code.append("default: {");
+		data->program.Emit(ShaderOpDefault, -1);
 	}
 
     void D3D10ShaderCompiler::EndCase()
@@ -705,11 +1225,13 @@ namespace Direct3D10 {
 
 
 		data->code.append(c);
+		data->program.Emit(ShaderOpEndCase, -1);
 	}
 
     void D3D10ShaderCompiler::EndSwitch()
 	{
 		data->code.append("}");
+		data->program.Emit(ShaderOpEndSwitch, -1);
 	}
 
     void D3D10ShaderCompiler::IndexInArray(int arr, int index, int outName)
@@ -723,6 +1245,7 @@ namespace Direct3D10 {
 		c.append("];");
 
 		data->code.append(c);
+		data->program.Emit(ShaderOpIndex, outName, arr, index);
 	}
 
 	std::string ExpandTypeForPos(int pos, Shaders::ExpandType type)
@@ -771,6 +1294,11 @@ namespace Direct3D10 {
 
 		data->code.append(c);
 
+		ShaderExpandCode code = ShaderExpandZeros;
+		if(type == Shaders::ExpandType::AddOnes) code = ShaderExpandOnes;
+		if(type == Shaders::ExpandType::AddOnesAtW) code = ShaderExpandOnesAtW;
+		data->program.Emit(ShaderOpExpand, n2, n1, -1, -1, -1, code);
+
 	}
 
 
@@ -784,6 +1312,7 @@ namespace Direct3D10 {
 
 		// Add to code.
 		data->code.append(c);
+		data->program.Emit(ShaderOpMov, o, n);
 	}
 
 	void D3D10ShaderCompiler::Output(PinComponent component, PinFormat fmt, int n)
@@ -804,8 +1333,22 @@ namespace Direct3D10 {
 		output.append(ToDXString(component));
 		output.append(",");
 
+		// Local declaration in case the output is not linked.
+		std::string local(ToDXString(fmt));
+		local.append(" __");
+		local.append(ConvToString(data->outCounter));
+		local.append(";");
+
 		// Add to inputs.
-		data->outputs.append(output);
+		data->outputs.push_back(output);
+		data->outputLocals.push_back(local);
+
+		ShaderOutput irOutput;
+		irOutput.component = (unsigned long long)component;
+		irOutput.type = ToIRType(fmt, UInt32::MaxValue);
+		irOutput.reg = data->program.Find(n);
+		data->program.outputs.push_back(irOutput);
+		data->program.Emit(ShaderOpOutput, -1, n, -1, -1, -1, data->outCounter);
 
 		++data->outCounter;
 
@@ -3,6 +3,9 @@
 #include <D3D10.h>
 #include <string>
 #include <map>
+#include "ShaderCache.h"
+#include "ShaderProgram.h"
+#include "ShaderBatch.h"
 
 using namespace System;
 using namespace SharpMedia::Math;
@@ -16,10 +19,18 @@ namespace Direct3D10 {
 	{
 		std::string code;
 		std::string inputs;
-		std::string outputs;
+		std::vector<std::string> outputs; //< Output parameters.
+		std::vector<std::string> outputLocals; //< The same outputs declared as locals.
+		std::vector<int> outputOrder; //< Linked outputs in consumer's order (others are removed).
+		bool outputsLinked;
 		std::string uniforms[Shaders::ConstantBufferLayout::MaxConstantBufferBindingSlots];
 		std::string texturesAndSamplers;
 		int outCounter;
+		ShaderProgram program; //< Instruction stream, for CPU interpretation.
+		std::vector<size_t> flowOffsets; //< Code offsets of if, while and switch (for attributes).
+		std::vector<int> flowInstructions; //< Their instructions in program.
+		ShaderFlowAttribute nextHint; //< Author's hint of next if, while or switch.
+		unsigned int nextUnroll;
 	};
 
 
@@ -28,19 +39,41 @@ namespace Direct3D10 {
 	{
 		BindingStage shaderType;
 		ID3D10Device* device;
+		D3D10ShaderCache* cache; //< Reference to device's bytecode cache, may be null.
+		Shaders::ShaderCompileProfile profile;
 		D3D10CompilationData* data; //< A special "struct" that holds unmanaged data.
+		D3D10CompilationData** stages; //< Stages ended for pipeline (vertex, geometry, pixel).
 
 		void BinaryOp(int n1, int n2, int dst, std::string op);
+		const char* StageProfile(BindingStage t);
+		void CompileStages(D3D10CompilationData** list, const char** profiles, unsigned int count,
+			ID3D10Blob** bytecodes, D3D10ShaderManifest* manifests);
+		void BeginFlow(ShaderOpcode op, int n);
+		IShaderBase^ CreateShader(BindingStage t, ID3D10Blob* bytecode, const D3D10ShaderManifest& manifest);
 	public:
-		// Ends the shader compilation, resulting in a blob that contains bytecode.
-		ID3D10Blob* EndBytecode();
+		// Ends the shader compilation, resulting in a blob that contains bytecode. The binding 
+		// manifest of bytecode is also returned.
+		ID3D10Blob* EndBytecode(D3D10ShaderManifest& manifest);
 
+		// The instruction stream of the last shader, recorded alongside HLSL. It is linked
+		// at End and can be run by ShaderInterpreter.
+		const ShaderProgram& GetProgram() { return data->program; }
 
-		D3D10ShaderCompiler(ID3D10Device* device);
+
+		D3D10ShaderCompiler(ID3D10Device* device, D3D10ShaderCache* cache, Shaders::ShaderCompileProfile profile);
 		virtual ~D3D10ShaderCompiler();
+
+		virtual property Shaders::ShaderCompileProfile Profile
+		{
+			Shaders::ShaderCompileProfile get();
+			void set(Shaders::ShaderCompileProfile value);
+		}
+
 		virtual IShaderBase^ Compile(BindingStage t, String^ code);
         virtual void Begin(BindingStage t);
         virtual IShaderBase^ End();
+		virtual void EndStage();
+		virtual IShaderPipeline^ CompilePipeline(array<VertexBindingElement>^ layout);
 		virtual void Convert(int n, PinFormat outFormat, int result);
         virtual void RegisterInput(int n, PinFormat fmt, PinComponent component);
         virtual void RegisterConstant(int n, PinFormat fmt, 
@@ -55,6 +88,7 @@ namespace Direct3D10 {
         virtual void Dot(int n1, int n2, int name);
 		virtual void Swizzle(int n, SwizzleMask^ mask, int name);
         virtual void Mov(int n, int o);
+		virtual void SetFlowHint(Shaders::FlowControlHint hint, UInt32 unrollCount);
         virtual void BeginIf(int n);
         virtual void Else();
         virtual void EndIf();
@@ -0,0 +1,1266 @@
+#include "ShaderInterpreter.h"
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	ShaderSampler::ShaderSampler()
+	{
+		linear = true;
+		address[0] = address[1] = address[2] = ShaderAddressWrap;
+		border[0] = border[1] = border[2] = border[3] = 0.0f;
+	}
+
+// ---------------------------------------------------------------------------------------
+// CPU textures
+// ---------------------------------------------------------------------------------------
+
+	static bool Address(ShaderAddress mode, int size, int& c)
+	{
+		switch(mode)
+		{
+		case ShaderAddressWrap:
+			c %= size;
+			if(c < 0) c += size;
+			return true;
+		case ShaderAddressMirror:
+			{
+				int period = 2 * size;
+				c %= period;
+				if(c < 0) c += period;
+				if(c >= size) c = period - 1 - c;
+				return true;
+			}
+		case ShaderAddressClamp:
+			c = c < 0 ? 0 : (c >= size ? size - 1 : c);
+			return true;
+		default:
+			return c >= 0 && c < size;
+		}
+	}
+
+	// Array layer of coordinate is rounded and clamped.
+	static unsigned int Layer(float c, unsigned int layers)
+	{
+		float l = floorf(c + 0.5f);
+		if(l < 0.0f) return 0;
+		if(l >= (float)layers) return layers - 1;
+		return (unsigned int)l;
+	}
+
+	// Mipmaps blended for level of detail; point samplers take the nearest one.
+	static void SelectMip(const ShaderSampler& sampler, float lod, size_t levels,
+		unsigned int& first, unsigned int& second, float& weight)
+	{
+		first = second = 0;
+		weight = 0.0f;
+		if(!(lod > 0.0f) || levels < 2) return;
+
+		float last = (float)(levels - 1);
+		if(lod > last) lod = last;
+
+		if(!sampler.linear)
+		{
+			first = second = (unsigned int)floorf(lod + 0.5f);
+			return;
+		}
+
+		first = (unsigned int)floorf(lod);
+		second = first + 1 < levels ? first + 1 : first;
+		weight = lod - (float)first;
+	}
+
+	static void Lerp(const float* a, const float* b, float t, float* result)
+	{
+		for(int c = 0; c < 4; c++) result[c] = a[c] + (b[c] - a[c]) * t;
+	}
+
+	void ShaderTexture2D::AddLevel(unsigned int width, unsigned int height, const float* texels)
+	{
+		AddLevel(width, height, 1, texels);
+	}
+
+	void ShaderTexture2D::AddLevel(unsigned int width, unsigned int height, unsigned int layers, const float* texels)
+	{
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.layers = layers;
+		level.texels.assign(texels, texels + width * height * layers * 4);
+		levels.push_back(level);
+	}
+
+	bool ShaderTexture2D::Supports(ShaderTextureDimension dimension) const
+	{
+		return dimension == ShaderDimension1D || dimension == ShaderDimension1DArray ||
+			dimension == ShaderDimension2D || dimension == ShaderDimension2DArray;
+	}
+
+	void ShaderTexture2D::GetSize(unsigned int* size) const
+	{
+		size[0] = levels.empty() ? 0 : levels[0].width;
+		size[1] = levels.empty() ? 0 : levels[0].height;
+		size[2] = 1;
+	}
+
+	void ShaderTexture2D::Fetch(const ShaderSampler& sampler, unsigned int mip, int x, int y, unsigned int layer,
+		float* result) const
+	{
+		const Level& level = levels[mip];
+		if(!Address(sampler.address[0], (int)level.width, x) ||
+		   !Address(sampler.address[1], (int)level.height, y))
+		{
+			memcpy(result, sampler.border, sizeof(float) * 4);
+			return;
+		}
+
+		memcpy(result, &level.texels[((layer * level.height + y) * level.width + x) * 4], sizeof(float) * 4);
+	}
+
+	void ShaderTexture2D::SampleLevel(const ShaderSampler& sampler, unsigned int mip, float u, float v,
+		unsigned int layer, int ox, int oy, float* result) const
+	{
+		const Level& level = levels[mip];
+		if(layer >= level.layers) layer = level.layers - 1;
+		u *= level.width;
+		v *= level.height;
+
+		if(!sampler.linear)
+		{
+			Fetch(sampler, mip, (int)floorf(u) + ox, (int)floorf(v) + oy, layer, result);
+			return;
+		}
+
+		// Bilinear filtering, texel centres are at half coordinates.
+		u -= 0.5f;
+		v -= 0.5f;
+		int x = (int)floorf(u);
+		int y = (int)floorf(v);
+		float fx = u - x;
+		float fy = v - y;
+
+		float t00[4], t10[4], t01[4], t11[4], top[4], bottom[4];
+		Fetch(sampler, mip, x + ox, y + oy, layer, t00);
+		Fetch(sampler, mip, x + ox + 1, y + oy, layer, t10);
+		Fetch(sampler, mip, x + ox, y + oy + 1, layer, t01);
+		Fetch(sampler, mip, x + ox + 1, y + oy + 1, layer, t11);
+
+		Lerp(t00, t10, fx, top);
+		Lerp(t01, t11, fx, bottom);
+		Lerp(top, bottom, fy, result);
+	}
+
+	void ShaderTexture2D::Sample(const ShaderSampler& sampler, ShaderTextureDimension dimension, const float* coord,
+		const int* offset, float lod, float* result) const
+	{
+		if(levels.empty())
+		{
+			memset(result, 0, sizeof(float) * 4);
+			return;
+		}
+
+		// 1D textures read the centre of their only row.
+		float u = coord[0], v = 0.5f;
+		unsigned int layer = 0;
+		int ox = offset ? offset[0] : 0, oy = 0;
+		switch(dimension)
+		{
+		case ShaderDimension1DArray:
+			layer = Layer(coord[1], levels[0].layers);
+			break;
+		case ShaderDimension2D:
+			v = coord[1];
+			oy = offset ? offset[1] : 0;
+			break;
+		case ShaderDimension2DArray:
+			v = coord[1];
+			oy = offset ? offset[1] : 0;
+			layer = Layer(coord[2], levels[0].layers);
+			break;
+		default:
+			break;
+		}
+
+		unsigned int first, second;
+		float weight;
+		SelectMip(sampler, lod, levels.size(), first, second, weight);
+
+		SampleLevel(sampler, first, u, v, layer, ox, oy, result);
+		if(weight > 0.0f)
+		{
+			float next[4];
+			SampleLevel(sampler, second, u, v, layer, ox, oy, next);
+			Lerp(result, next, weight, result);
+		}
+	}
+
+	void ShaderTexture2D::Load(ShaderTextureDimension dimension, const int* coord, const int* offset, float* result) const
+	{
+		memset(result, 0, sizeof(float) * 4);
+
+		int x = coord[0] + (offset ? offset[0] : 0), y = 0, layer = 0, mip;
+		switch(dimension)
+		{
+		case ShaderDimension1D:
+			mip = coord[1];
+			break;
+		case ShaderDimension1DArray:
+			layer = coord[1];
+			mip = coord[2];
+			break;
+		case ShaderDimension2D:
+			y = coord[1] + (offset ? offset[1] : 0);
+			mip = coord[2];
+			break;
+		default:
+			y = coord[1] + (offset ? offset[1] : 0);
+			layer = coord[2];
+			mip = coord[3];
+			break;
+		}
+
+		// Out of range loads return zero.
+		if(mip < 0 || mip >= (int)levels.size()) return;
+
+		const Level& level = levels[mip];
+		if(x < 0 || y < 0 || layer < 0 || x >= (int)level.width || y >= (int)level.height ||
+		   layer >= (int)level.layers) return;
+
+		memcpy(result, &level.texels[((layer * level.height + y) * level.width + x) * 4], sizeof(float) * 4);
+	}
+
+	void ShaderTexture3D::AddLevel(unsigned int width, unsigned int height, unsigned int depth, const float* texels)
+	{
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.depth = depth;
+		level.texels.assign(texels, texels + width * height * depth * 4);
+		levels.push_back(level);
+	}
+
+	bool ShaderTexture3D::Supports(ShaderTextureDimension dimension) const
+	{
+		return dimension == ShaderDimension3D;
+	}
+
+	void ShaderTexture3D::GetSize(unsigned int* size) const
+	{
+		size[0] = levels.empty() ? 0 : levels[0].width;
+		size[1] = levels.empty() ? 0 : levels[0].height;
+		size[2] = levels.empty() ? 0 : levels[0].depth;
+	}
+
+	void ShaderTexture3D::Fetch(const ShaderSampler& sampler, unsigned int mip, int x, int y, int z, float* result) const
+	{
+		const Level& level = levels[mip];
+		if(!Address(sampler.address[0], (int)level.width, x) ||
+		   !Address(sampler.address[1], (int)level.height, y) ||
+		   !Address(sampler.address[2], (int)level.depth, z))
+		{
+			memcpy(result, sampler.border, sizeof(float) * 4);
+			return;
+		}
+
+		memcpy(result, &level.texels[((z * level.height + y) * level.width + x) * 4], sizeof(float) * 4);
+	}
+
+	void ShaderTexture3D::SampleLevel(const ShaderSampler& sampler, unsigned int mip, const float* coord,
+		const int* offset, float* result) const
+	{
+		const Level& level = levels[mip];
+		float u = coord[0] * level.width;
+		float v = coord[1] * level.height;
+		float w = coord[2] * level.depth;
+		int ox = offset ? offset[0] : 0;
+		int oy = offset ? offset[1] : 0;
+		int oz = offset ? offset[2] : 0;
+
+		if(!sampler.linear)
+		{
+			Fetch(sampler, mip, (int)floorf(u) + ox, (int)floorf(v) + oy, (int)floorf(w) + oz, result);
+			return;
+		}
+
+		// Trilinear filtering of the eight nearest texels.
+		u -= 0.5f;
+		v -= 0.5f;
+		w -= 0.5f;
+		int x = (int)floorf(u) + ox;
+		int y = (int)floorf(v) + oy;
+		int z = (int)floorf(w) + oz;
+		float fx = u - floorf(u);
+		float fy = v - floorf(v);
+		float fz = w - floorf(w);
+
+		float slice[2][4];
+		for(int s = 0; s < 2; s++)
+		{
+			float t00[4], t10[4], t01[4], t11[4], top[4], bottom[4];
+			Fetch(sampler, mip, x, y, z + s, t00);
+			Fetch(sampler, mip, x + 1, y, z + s, t10);
+			Fetch(sampler, mip, x, y + 1, z + s, t01);
+			Fetch(sampler, mip, x + 1, y + 1, z + s, t11);
+			Lerp(t00, t10, fx, top);
+			Lerp(t01, t11, fx, bottom);
+			Lerp(top, bottom, fy, slice[s]);
+		}
+		Lerp(slice[0], slice[1], fz, result);
+	}
+
+	void ShaderTexture3D::Sample(const ShaderSampler& sampler, ShaderTextureDimension, const float* coord,
+		const int* offset, float lod, float* result) const
+	{
+		if(levels.empty())
+		{
+			memset(result, 0, sizeof(float) * 4);
+			return;
+		}
+
+		unsigned int first, second;
+		float weight;
+		SelectMip(sampler, lod, levels.size(), first, second, weight);
+
+		SampleLevel(sampler, first, coord, offset, result);
+		if(weight > 0.0f)
+		{
+			float next[4];
+			SampleLevel(sampler, second, coord, offset, next);
+			Lerp(result, next, weight, result);
+		}
+	}
+
+	void ShaderTexture3D::Load(ShaderTextureDimension, const int* coord, const int* offset, float* result) const
+	{
+		memset(result, 0, sizeof(float) * 4);
+
+		int mip = coord[3];
+		if(mip < 0 || mip >= (int)levels.size()) return;
+
+		const Level& level = levels[mip];
+		int x = coord[0] + (offset ? offset[0] : 0);
+		int y = coord[1] + (offset ? offset[1] : 0);
+		int z = coord[2] + (offset ? offset[2] : 0);
+		if(x < 0 || y < 0 || z < 0 || x >= (int)level.width || y >= (int)level.height || z >= (int)level.depth) return;
+
+		memcpy(result, &level.texels[((z * level.height + y) * level.width + x) * 4], sizeof(float) * 4);
+	}
+
+	void ShaderTextureCube::AddLevel(unsigned int size, const float* texels)
+	{
+		faces.AddLevel(size, size, 6, texels);
+	}
+
+	bool ShaderTextureCube::Supports(ShaderTextureDimension dimension) const
+	{
+		return dimension == ShaderDimensionCube;
+	}
+
+	void ShaderTextureCube::GetSize(unsigned int* size) const
+	{
+		faces.GetSize(size);
+	}
+
+	void ShaderTextureCube::Sample(const ShaderSampler& sampler, ShaderTextureDimension, const float* coord,
+		const int*, float lod, float* result) const
+	{
+		float x = coord[0], y = coord[1], z = coord[2];
+		float ax = fabsf(x), ay = fabsf(y), az = fabsf(z);
+
+		// Face of the major axis, with face coordinates as D3D defines them.
+		float face, s, t, major;
+		if(ax >= ay && ax >= az)
+		{
+			face = x >= 0.0f ? 0.0f : 1.0f;
+			s = x >= 0.0f ? -z : z;
+			t = -y;
+			major = ax;
+		} else if(ay >= az)
+		{
+			face = y >= 0.0f ? 2.0f : 3.0f;
+			s = x;
+			t = y >= 0.0f ? z : -z;
+			major = ay;
+		} else {
+			face = z >= 0.0f ? 4.0f : 5.0f;
+			s = z >= 0.0f ? x : -x;
+			t = -y;
+			major = az;
+		}
+
+		if(major == 0.0f)
+		{
+			memset(result, 0, sizeof(float) * 4);
+			return;
+		}
+
+		ShaderSampler clamped = sampler;
+		clamped.address[0] = clamped.address[1] = ShaderAddressClamp;
+
+		float faceCoord[3] = { (s / major + 1.0f) * 0.5f, (t / major + 1.0f) * 0.5f, face };
+		faces.Sample(clamped, ShaderDimension2DArray, faceCoord, 0, lod, result);
+	}
+
+	void ShaderTextureCube::Load(ShaderTextureDimension, const int*, const int*, float* result) const
+	{
+		memset(result, 0, sizeof(float) * 4);
+	}
+
+// ---------------------------------------------------------------------------------------
+// Interpreter
+// ---------------------------------------------------------------------------------------
+
+	// An open flow control block.
+	struct ShaderInterpreter::Frame
+	{
+		ShaderOpcode op;
+		int pc;
+		unsigned int iterations;
+		unsigned char saved[ShaderLanes];	//< Mask when block was entered.
+		unsigned char cond[ShaderLanes];	//< If condition, or alive lanes of loop/case.
+	};
+
+	static bool Any(const unsigned char* mask)
+	{
+		unsigned char r = 0;
+		for(unsigned int l = 0; l < ShaderLanes; l++) r |= mask[l];
+		return r != 0;
+	}
+
+	// Lanes that broke out of innermost loop (or case) must stay inactive.
+	template<typename Frames>
+	static void Restrict(const Frames& frames, size_t count, unsigned char* mask)
+	{
+		for(size_t t = count; t > 0; t--)
+		{
+			ShaderOpcode op = frames[t - 1].op;
+			if(op == ShaderOpWhile || op == ShaderOpCase || op == ShaderOpDefault)
+			{
+				for(unsigned int l = 0; l < ShaderLanes; l++) mask[l] &= frames[t - 1].cond[l];
+				return;
+			}
+		}
+	}
+
+	ShaderInterpreter::ShaderInterpreter(const ShaderProgram& program)
+		: program(program), maxIterations(65536), quads(false), failed(false)
+	{
+		unsigned int size = 0;
+		offsets.resize(program.registers.size());
+		for(size_t r = 0; r < program.registers.size(); r++)
+		{
+			const ShaderType& type = program.registers[r].type;
+			offsets[r] = size;
+			size += type.Elements() * type.Components() * ShaderLanes;
+		}
+		storage.assign(size, 0.0f);
+
+		// Fixed values are broadcast to all lanes once.
+		for(size_t r = 0; r < program.registers.size(); r++)
+		{
+			const ShaderRegister& reg = program.registers[r];
+			if(reg.kind != ShaderRegisterFixed) continue;
+
+			size_t n = reg.type.Elements() * reg.type.Components();
+			for(size_t i = 0; i < n && i < reg.data.size(); i++)
+			{
+				for(unsigned int l = 0; l < ShaderLanes; l++) storage[offsets[r] + i * ShaderLanes + l] = reg.data[i];
+			}
+		}
+
+		size = 0;
+		for(size_t o = 0; o < program.outputs.size(); o++)
+		{
+			outputOffsets.push_back(size);
+			size += program.outputs[o].type.Components() * ShaderLanes;
+		}
+		outputStorage.assign(size, 0.0f);
+	}
+
+	void ShaderInterpreter::BindConstantBuffer(unsigned int slot, const void* data, unsigned int size)
+	{
+		if(slot >= constantBuffers.size())
+		{
+			constantBuffers.resize(slot + 1, 0);
+			constantSizes.resize(slot + 1, 0);
+		}
+		constantBuffers[slot] = data;
+		constantSizes[slot] = size;
+	}
+
+	void ShaderInterpreter::BindTexture(unsigned int slot, const ShaderTexture* texture)
+	{
+		if(slot >= textures.size()) textures.resize(slot + 1, 0);
+		textures[slot] = texture;
+	}
+
+	void ShaderInterpreter::BindSampler(unsigned int slot, const ShaderSampler& sampler)
+	{
+		if(slot >= samplers.size()) samplers.resize(slot + 1);
+		samplers[slot] = sampler;
+	}
+
+	void ShaderInterpreter::SetMaxIterations(unsigned int iterations)
+	{
+		maxIterations = iterations;
+	}
+
+	void ShaderInterpreter::SetQuads(bool quads)
+	{
+		this->quads = quads;
+	}
+
+	// Level of detail from the larger of horizontal and vertical coordinate differences (in
+	// texels) of lane's quad. Cube directions are taken as having unit major axis.
+	float ShaderInterpreter::QuadLod(int posReg, ShaderTextureDimension dimension, const unsigned int* size, unsigned int lane)
+	{
+		unsigned int axes = 2;
+		float scale = 1.0f;
+		switch(dimension)
+		{
+		case ShaderDimension1D:
+		case ShaderDimension1DArray:
+			axes = 1;
+			break;
+		case ShaderDimensionCube:
+			axes = 3;
+			scale = 0.5f;
+			break;
+		case ShaderDimension3D:
+			axes = 3;
+			break;
+		default:
+			break;
+		}
+
+		unsigned int q = lane & ~3u;
+		float dx = 0.0f, dy = 0.0f;
+		for(unsigned int c = 0; c < axes; c++)
+		{
+			const float* x = Operand(posReg, c);
+			float texels = (float)(dimension == ShaderDimensionCube ? size[0] : size[c]) * scale;
+			float h = (x[q + 1] - x[q]) * texels;
+			float v = (x[q + 2] - x[q]) * texels;
+			dx += h * h;
+			dy += v * v;
+		}
+
+		float rho = dx > dy ? dx : dy;
+		return rho > 0.0f ? 0.5f * log2f(rho) : 0.0f;
+	}
+
+	float* ShaderInterpreter::Value(int reg, unsigned int element, unsigned int component)
+	{
+		unsigned int components = program.registers[reg].type.Components();
+		return &storage[offsets[reg] + (element * components + component) * ShaderLanes];
+	}
+
+	const float* ShaderInterpreter::Operand(int reg, unsigned int component, unsigned int element)
+	{
+		// Scalars are broadcast, shorter vectors repeat their last component.
+		unsigned int components = program.registers[reg].type.Components();
+		if(component >= components) component = components - 1;
+		return Value(reg, element, component);
+	}
+
+	void ShaderInterpreter::Write(int reg, unsigned int element, unsigned int component,
+		const float* value, const unsigned char* mask)
+	{
+		float* d = Value(reg, element, component);
+		for(unsigned int l = 0; l < ShaderLanes; l++)
+		{
+			d[l] = mask[l] ? value[l] : d[l];
+		}
+	}
+
+	void ShaderInterpreter::SetInput(unsigned int input, unsigned int lane, const float* values)
+	{
+		int reg = program.inputs[input];
+		const ShaderType& type = program.registers[reg].type;
+		unsigned int n = type.Elements() * type.Components();
+		for(unsigned int i = 0; i < n; i++)
+		{
+			storage[offsets[reg] + i * ShaderLanes + lane] = values[i];
+		}
+	}
+
+	void ShaderInterpreter::GetOutput(unsigned int output, unsigned int lane, float* values) const
+	{
+		unsigned int n = program.outputs[output].type.Components();
+		for(unsigned int c = 0; c < n; c++)
+		{
+			values[c] = outputStorage[outputOffsets[output] + c * ShaderLanes + lane];
+		}
+	}
+
+	unsigned int ShaderInterpreter::InputStride() const
+	{
+		unsigned int stride = 0;
+		for(size_t i = 0; i < program.inputs.size(); i++)
+		{
+			const ShaderType& type = program.registers[program.inputs[i]].type;
+			stride += type.Elements() * type.Components();
+		}
+		return stride;
+	}
+
+	unsigned int ShaderInterpreter::OutputStride() const
+	{
+		unsigned int stride = 0;
+		for(size_t o = 0; o < program.outputs.size(); o++)
+		{
+			stride += program.outputs[o].type.Components();
+		}
+		return stride;
+	}
+
+	void ShaderInterpreter::LoadConstants()
+	{
+		for(size_t r = 0; r < program.registers.size(); r++)
+		{
+			const ShaderRegister& reg = program.registers[r];
+			if(reg.kind != ShaderRegisterConstant) continue;
+
+			// Unbound buffers and reads past the end give zero.
+			bool bound = reg.slot < constantBuffers.size() && constantBuffers[reg.slot] != 0;
+			const unsigned char* data = bound ? (const unsigned char*)constantBuffers[reg.slot] : 0;
+			unsigned int size = bound ? constantSizes[reg.slot] : 0;
+
+			// Array elements and matrix rows start at register (16 byte) boundaries.
+			for(unsigned int e = 0; e < reg.type.Elements(); e++)
+			{
+				for(unsigned int row = 0; row < reg.type.rows; row++)
+				{
+					for(unsigned int col = 0; col < reg.type.columns; col++)
+					{
+						unsigned int offset = reg.offset + e * reg.type.rows * 16 + row * 16 + col * 4;
+						unsigned int bits = 0;
+						if(offset + 4 <= size) memcpy(&bits, data + offset, 4);
+
+						float value;
+						switch(reg.type.scalar)
+						{
+						case ShaderScalarFloat:
+							memcpy(&value, &bits, 4);
+							break;
+						case ShaderScalarInt:
+							value = (float)(int)bits;
+							break;
+						case ShaderScalarBool:
+							value = bits != 0 ? 1.0f : 0.0f;
+							break;
+						default:
+							value = (float)bits;
+							break;
+						}
+
+						float* d = Value((int)r, e, row * reg.type.columns + col);
+						for(unsigned int l = 0; l < ShaderLanes; l++) d[l] = value;
+					}
+				}
+			}
+		}
+	}
+
+	void ShaderInterpreter::Compute(const ShaderInstruction& instr, const unsigned char* mask)
+	{
+		unsigned int l, c;
+
+		// Output has no destination register.
+		if(instr.op == ShaderOpOutput)
+		{
+			unsigned int n = program.outputs[instr.param].type.Components();
+			for(c = 0; c < n; c++)
+			{
+				const float* x = Operand(instr.a, c);
+				float* d = &outputStorage[outputOffsets[instr.param] + c * ShaderLanes];
+				for(l = 0; l < ShaderLanes; l++) d[l] = mask[l] ? x[l] : d[l];
+			}
+			return;
+		}
+
+		const ShaderType& type = program.registers[instr.dst].type;
+		unsigned int components = type.Components();
+		bool integer = type.scalar == ShaderScalarInt || type.scalar == ShaderScalarUInt;
+
+		// Results are staged since destination may alias operands.
+		float out[16][ShaderLanes];
+
+		switch(instr.op)
+		{
+		case ShaderOpAdd:
+		case ShaderOpSub:
+		case ShaderOpMul:
+		case ShaderOpDiv:
+		case ShaderOpMin:
+		case ShaderOpMax:
+			for(c = 0; c < components; c++)
+			{
+				const float* x = Operand(instr.a, c);
+				const float* y = Operand(instr.b, c);
+				float* r = out[c];
+				switch(instr.op)
+				{
+				case ShaderOpAdd:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] + y[l];
+					break;
+				case ShaderOpSub:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] - y[l];
+					break;
+				case ShaderOpMul:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] * y[l];
+					break;
+				case ShaderOpDiv:
+					if(integer)
+					{
+						// Integer division truncates, division by zero gives all bits set.
+						float undefined = type.scalar == ShaderScalarUInt ? 4294967295.0f : -1.0f;
+						for(l = 0; l < ShaderLanes; l++)
+						{
+							r[l] = y[l] != 0.0f ? (float)(long long)(x[l] / y[l]) : undefined;
+						}
+					} else {
+						for(l = 0; l < ShaderLanes; l++) r[l] = x[l] / y[l];
+					}
+					break;
+				case ShaderOpMin:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] < y[l] ? x[l] : y[l];
+					break;
+				default:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] > y[l] ? x[l] : y[l];
+					break;
+				}
+			}
+			break;
+		case ShaderOpMulEx:
+			{
+				const ShaderType& ta = program.registers[instr.a].type;
+				const ShaderType& tb = program.registers[instr.b].type;
+				memset(out, 0, sizeof(out));
+
+				if(ta.rows == 1 && tb.rows == 1)
+				{
+					// Vector-vector is a dot product.
+					for(c = 0; c < ta.columns && c < tb.columns; c++)
+					{
+						const float* x = Operand(instr.a, c);
+						const float* y = Operand(instr.b, c);
+						for(l = 0; l < ShaderLanes; l++) out[0][l] += x[l] * y[l];
+					}
+					for(c = 1; c < components; c++) memcpy(out[c], out[0], sizeof(out[0]));
+				} else if(ta.rows == 1)
+				{
+					// Row vector times matrix.
+					for(unsigned int j = 0; j < tb.columns && j < 16; j++)
+					{
+						for(unsigned int i = 0; i < ta.columns && i < tb.rows; i++)
+						{
+							const float* x = Operand(instr.a, i);
+							const float* y = Operand(instr.b, i * tb.columns + j);
+							for(l = 0; l < ShaderLanes; l++) out[j][l] += x[l] * y[l];
+						}
+					}
+				} else if(tb.rows == 1)
+				{
+					// Matrix times column vector.
+					for(unsigned int i = 0; i < ta.rows; i++)
+					{
+						for(unsigned int j = 0; j < ta.columns && j < tb.columns; j++)
+						{
+							const float* x = Operand(instr.a, i * ta.columns + j);
+							const float* y = Operand(instr.b, j);
+							for(l = 0; l < ShaderLanes; l++) out[i][l] += x[l] * y[l];
+						}
+					}
+				} else {
+					// Matrix times matrix.
+					for(unsigned int i = 0; i < ta.rows; i++)
+					{
+						for(unsigned int j = 0; j < tb.columns; j++)
+						{
+							for(unsigned int k = 0; k < ta.columns && k < tb.rows; k++)
+							{
+								const float* x = Operand(instr.a, i * ta.columns + k);
+								const float* y = Operand(instr.b, k * tb.columns + j);
+								for(l = 0; l < ShaderLanes; l++) out[i * tb.columns + j][l] += x[l] * y[l];
+							}
+						}
+					}
+				}
+			}
+			break;
+		case ShaderOpDot:
+			{
+				unsigned int n = program.registers[instr.a].type.Components();
+				memset(out[0], 0, sizeof(out[0]));
+				for(c = 0; c < n; c++)
+				{
+					const float* x = Operand(instr.a, c);
+					const float* y = Operand(instr.b, c);
+					for(l = 0; l < ShaderLanes; l++) out[0][l] += x[l] * y[l];
+				}
+				for(c = 1; c < components; c++) memcpy(out[c], out[0], sizeof(out[0]));
+			}
+			break;
+		case ShaderOpSwizzle:
+			for(c = 0; c < components; c++)
+			{
+				unsigned int selector = c < instr.param ? instr.swizzle[c] : instr.swizzle[instr.param - 1];
+				memcpy(out[c], Operand(instr.a, selector), sizeof(out[c]));
+			}
+			break;
+		case ShaderOpMov:
+			{
+				// Whole arrays can be moved.
+				unsigned int elements = type.Elements();
+				if(program.registers[instr.a].type.Elements() < elements)
+				{
+					elements = program.registers[instr.a].type.Elements();
+				}
+
+				for(unsigned int e = 0; e < elements; e++)
+				{
+					for(c = 0; c < components; c++)
+					{
+						memcpy(out[0], Operand(instr.a, c, e), sizeof(out[0]));
+						Write(instr.dst, e, c, out[0], mask);
+					}
+				}
+			}
+			return;
+		case ShaderOpExpand:
+			{
+				unsigned int n = program.registers[instr.a].type.Components();
+				for(c = 0; c < components; c++)
+				{
+					if(c < n)
+					{
+						memcpy(out[c], Operand(instr.a, c), sizeof(out[c]));
+						continue;
+					}
+
+					float fill = 0.0f;
+					if(instr.param == ShaderExpandOnes) fill = 1.0f;
+					if(instr.param == ShaderExpandOnesAtW && c == 3) fill = 1.0f;
+					for(l = 0; l < ShaderLanes; l++) out[c][l] = fill;
+				}
+			}
+			break;
+		case ShaderOpConvert:
+			for(c = 0; c < components; c++)
+			{
+				const float* x = Operand(instr.a, c);
+				switch(type.scalar)
+				{
+				case ShaderScalarFloat:
+					for(l = 0; l < ShaderLanes; l++) out[c][l] = x[l];
+					break;
+				case ShaderScalarInt:
+					for(l = 0; l < ShaderLanes; l++) out[c][l] = (float)(long long)x[l];
+					break;
+				case ShaderScalarUInt:
+					for(l = 0; l < ShaderLanes; l++) out[c][l] = x[l] < 0.0f ? 0.0f : floorf(x[l]);
+					break;
+				default:
+					for(l = 0; l < ShaderLanes; l++) out[c][l] = x[l] != 0.0f ? 1.0f : 0.0f;
+					break;
+				}
+			}
+			break;
+		case ShaderOpCall:
+			{
+				unsigned int n = program.registers[instr.a].type.Components();
+				switch(instr.param)
+				{
+				case ShaderFunctionAbs:
+				case ShaderFunctionFloor:
+				case ShaderFunctionCeil:
+					for(c = 0; c < components; c++)
+					{
+						const float* x = Operand(instr.a, c);
+						for(l = 0; l < ShaderLanes; l++)
+						{
+							out[c][l] = instr.param == ShaderFunctionAbs ? fabsf(x[l]) :
+								(instr.param == ShaderFunctionFloor ? floorf(x[l]) : ceilf(x[l]));
+						}
+					}
+					break;
+				case ShaderFunctionLength:
+					memset(out[0], 0, sizeof(out[0]));
+					for(c = 0; c < n; c++)
+					{
+						const float* x = Operand(instr.a, c);
+						for(l = 0; l < ShaderLanes; l++) out[0][l] += x[l] * x[l];
+					}
+					for(l = 0; l < ShaderLanes; l++) out[0][l] = sqrtf(out[0][l]);
+					for(c = 1; c < components; c++) memcpy(out[c], out[0], sizeof(out[0]));
+					break;
+				default:
+					{
+						// All, Any and None (defined as !all).
+						unsigned char all[ShaderLanes], any[ShaderLanes];
+						for(l = 0; l < ShaderLanes; l++) { all[l] = 1; any[l] = 0; }
+						for(c = 0; c < n; c++)
+						{
+							const float* x = Operand(instr.a, c);
+							for(l = 0; l < ShaderLanes; l++)
+							{
+								all[l] &= x[l] != 0.0f;
+								any[l] |= x[l] != 0.0f;
+							}
+						}
+						for(l = 0; l < ShaderLanes; l++)
+						{
+							bool r = instr.param == ShaderFunctionAll ? all[l] != 0 :
+								(instr.param == ShaderFunctionAny ? any[l] != 0 : all[l] == 0);
+							out[0][l] = r ? 1.0f : 0.0f;
+						}
+						for(c = 1; c < components; c++) memcpy(out[c], out[0], sizeof(out[0]));
+					}
+					break;
+				}
+			}
+			break;
+		case ShaderOpCompare:
+			for(c = 0; c < components; c++)
+			{
+				const float* x = Operand(instr.a, c);
+				const float* y = Operand(instr.b, c);
+				float* r = out[c];
+				switch(instr.param)
+				{
+				case ShaderCompareLess:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] < y[l] ? 1.0f : 0.0f;
+					break;
+				case ShaderCompareLessEqual:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] <= y[l] ? 1.0f : 0.0f;
+					break;
+				case ShaderCompareGreater:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] > y[l] ? 1.0f : 0.0f;
+					break;
+				case ShaderCompareGreaterEqual:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] >= y[l] ? 1.0f : 0.0f;
+					break;
+				case ShaderCompareEqual:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] == y[l] ? 1.0f : 0.0f;
+					break;
+				default:
+					for(l = 0; l < ShaderLanes; l++) r[l] = x[l] != y[l] ? 1.0f : 0.0f;
+					break;
+				}
+			}
+			break;
+		case ShaderOpSample:
+		case ShaderOpLoad:
+			{
+				// Sample: a = sampler, b = texture, c = position, d = offset.
+				// Load: a = texture, b = position, c = offset.
+				bool sample = instr.op == ShaderOpSample;
+				int textureReg = sample ? instr.b : instr.a;
+				int posReg = sample ? instr.c : instr.b;
+				int offsetReg = sample ? instr.d : instr.c;
+
+				unsigned int textureSlot = program.registers[textureReg].slot;
+				ShaderTextureDimension dimension = program.registers[textureReg].dimension;
+				const ShaderTexture* texture = textureSlot < textures.size() ? textures[textureSlot] : 0;
+				if(texture && (dimension == ShaderDimensionBuffer || !texture->Supports(dimension)))
+				{
+					failed = true;
+					return;
+				}
+
+				unsigned int size[3] = { 0, 0, 0 };
+				if(texture) texture->GetSize(size);
+				ShaderSampler sampler;
+				if(sample && program.registers[instr.a].slot < samplers.size())
+				{
+					sampler = samplers[program.registers[instr.a].slot];
+				}
+
+				unsigned int pn = program.registers[posReg].type.Components();
+				unsigned int on = offsetReg >= 0 ? program.registers[offsetReg].type.Components() : 0;
+
+				for(l = 0; l < ShaderLanes; l++)
+				{
+					float texel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+					if(mask[l] && texture)
+					{
+						float coord[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+						int icoord[4] = { 0, 0, 0, 0 };
+						int offset[4] = { 0, 0, 0, 0 };
+						for(c = 0; c < pn && c < 4; c++)
+						{
+							coord[c] = Operand(posReg, c)[l];
+							icoord[c] = (int)coord[c];
+						}
+						for(c = 0; c < on && c < 4; c++) offset[c] = (int)Operand(offsetReg, c)[l];
+
+						if(sample)
+						{
+							float lod = quads ? QuadLod(posReg, dimension, size, l) : 0.0f;
+							texture->Sample(sampler, dimension, coord, on ? offset : 0, lod, texel);
+						} else {
+							texture->Load(dimension, icoord, on ? offset : 0, texel);
+						}
+					}
+
+					for(c = 0; c < 4; c++) out[c][l] = texel[c];
+				}
+
+				if(components > 4) components = 4;
+			}
+			break;
+		case ShaderOpIndex:
+			{
+				const ShaderType& ta = program.registers[instr.a].type;
+				const float* index = Operand(instr.b, 0);
+				for(c = 0; c < components; c++)
+				{
+					unsigned int component = c < ta.Components() ? c : ta.Components() - 1;
+					for(l = 0; l < ShaderLanes; l++)
+					{
+						int e = (int)index[l];
+						if(e < 0) e = 0;
+						if(e >= (int)ta.Elements()) e = (int)ta.Elements() - 1;
+						out[c][l] = Value(instr.a, e, component)[l];
+					}
+				}
+			}
+			break;
+		default:
+			return;
+		}
+
+		for(c = 0; c < components && c < 16; c++)
+		{
+			Write(instr.dst, 0, c, out[c], mask);
+		}
+	}
+
+	bool ShaderInterpreter::Execute(unsigned int active)
+	{
+		const std::vector<ShaderInstruction>& code = program.instructions;
+		std::vector<Frame> frames;
+		unsigned char mask[ShaderLanes];
+		unsigned int l;
+
+		for(l = 0; l < ShaderLanes; l++) mask[l] = l < active ? 1 : 0;
+
+		// Temporaries start zeroed, constants are reloaded from bound buffers.
+		for(size_t r = 0; r < program.registers.size(); r++)
+		{
+			const ShaderRegister& reg = program.registers[r];
+			if(reg.kind != ShaderRegisterTemp) continue;
+			std::fill(storage.begin() + offsets[r],
+				storage.begin() + offsets[r] + reg.type.Elements() * reg.type.Components() * ShaderLanes, 0.0f);
+		}
+		LoadConstants();
+		failed = false;
+
+		int pc = 0;
+		while(pc < (int)code.size())
+		{
+			const ShaderInstruction& instr = code[pc];
+			switch(instr.op)
+			{
+			case ShaderOpIf:
+				{
+					Frame f;
+					f.op = ShaderOpIf;
+					f.pc = pc;
+					memcpy(f.saved, mask, sizeof(mask));
+
+					const float* cond = Operand(instr.a, 0);
+					for(l = 0; l < ShaderLanes; l++)
+					{
+						f.cond[l] = cond[l] != 0.0f ? 1 : 0;
+						mask[l] &= f.cond[l];
+					}
+					frames.push_back(f);
+
+					// Whole block is skipped (else or end is still executed).
+					if(!Any(mask))
+					{
+						pc = instr.jump;
+						continue;
+					}
+				}
+				break;
+			case ShaderOpElse:
+				{
+					const Frame& f = frames.back();
+					for(l = 0; l < ShaderLanes; l++) mask[l] = f.saved[l] & (f.cond[l] ^ 1);
+					Restrict(frames, frames.size() - 1, mask);
+
+					if(!Any(mask))
+					{
+						pc = instr.jump;
+						continue;
+					}
+				}
+				break;
+			case ShaderOpEndIf:
+			case ShaderOpEndCase:
+			case ShaderOpEndSwitch:
+				memcpy(mask, frames.back().saved, sizeof(mask));
+				frames.pop_back();
+				Restrict(frames, frames.size(), mask);
+				break;
+			case ShaderOpWhile:
+			case ShaderOpSwitch:
+				{
+					Frame f;
+					f.op = instr.op;
+					f.pc = pc;
+					f.iterations = 0;
+					memcpy(f.saved, mask, sizeof(mask));
+					memcpy(f.cond, mask, sizeof(mask));
+					frames.push_back(f);
+
+					if(!Any(mask))
+					{
+						pc = instr.jump;
+						continue;
+					}
+				}
+				break;
+			case ShaderOpBreak:
+				{
+					// Break is taken by lanes where condition is false.
+					int target = (int)frames.size() - 1;
+					while(target >= 0 && frames[target].pc != instr.jump) target--;
+					if(target < 0) return false;
+
+					// Breaking lanes leave loop (or switch) and every case inside it; lanes masked
+					// by an enclosing if stay alive and run further.
+					const float* cond = Operand(instr.a, 0);
+					for(l = 0; l < ShaderLanes; l++)
+					{
+						if(!mask[l] || cond[l] != 0.0f) continue;
+
+						mask[l] = 0;
+						for(size_t t = (size_t)target; t < frames.size(); t++)
+						{
+							ShaderOpcode op = frames[t].op;
+							if(op == ShaderOpWhile || op == ShaderOpSwitch || op == ShaderOpCase ||
+							   op == ShaderOpDefault) frames[t].cond[l] = 0;
+						}
+					}
+
+					// No lane of loop is alive, we go to the end of loop (or switch).
+					if(!Any(frames[target].cond))
+					{
+						frames.resize(target + 1);
+						pc = code[instr.jump].jump;
+						continue;
+					}
+				}
+				break;
+			case ShaderOpEndWhile:
+				{
+					Frame& f = frames.back();
+					memcpy(mask, f.cond, sizeof(mask));
+					if(Any(mask))
+					{
+						if(++f.iterations >= maxIterations) return false;
+						pc = f.pc + 1;
+						continue;
+					}
+
+					memcpy(mask, f.saved, sizeof(mask));
+					frames.pop_back();
+					Restrict(frames, frames.size(), mask);
+				}
+				break;
+			case ShaderOpCase:
+			case ShaderOpDefault:
+				{
+					const ShaderInstruction& sw = code[instr.parent];
+					const float* selector = Operand(sw.a, 0);
+
+					Frame f;
+					f.op = instr.op;
+					f.pc = pc;
+					memcpy(f.saved, mask, sizeof(mask));
+
+					if(instr.op == ShaderOpCase)
+					{
+						const float* value = Operand(instr.a, 0);
+						for(l = 0; l < ShaderLanes; l++) f.cond[l] = mask[l] & (selector[l] == value[l] ? 1 : 0);
+					} else {
+						// Default takes lanes no case of this switch matches.
+						memcpy(f.cond, mask, sizeof(mask));
+						for(int i = instr.parent + 1; i < sw.jump; i++)
+						{
+							if(code[i].op != ShaderOpCase || code[i].parent != instr.parent) continue;
+							const float* value = Operand(code[i].a, 0);
+							for(l = 0; l < ShaderLanes; l++) if(selector[l] == value[l]) f.cond[l] = 0;
+						}
+					}
+
+					memcpy(mask, f.cond, sizeof(mask));
+					frames.push_back(f);
+
+					if(!Any(mask))
+					{
+						pc = instr.jump;
+						continue;
+					}
+				}
+				break;
+			default:
+				Compute(instr, mask);
+				if(failed) return false;
+				break;
+			}
+
+			pc++;
+		}
+
+		return frames.empty();
+	}
+
+	bool ShaderInterpreter::Run(unsigned int count, const float* inputs, float* outputs)
+	{
+		unsigned int inputStride = InputStride();
+		unsigned int outputStride = OutputStride();
+
+		for(unsigned int base = 0; base < count; base += ShaderLanes)
+		{
+			unsigned int active = count - base < ShaderLanes ? count - base : ShaderLanes;
+
+			for(unsigned int lane = 0; lane < active; lane++)
+			{
+				const float* src = inputs + (base + lane) * inputStride;
+				for(unsigned int i = 0; i < program.inputs.size(); i++)
+				{
+					const ShaderType& type = program.registers[program.inputs[i]].type;
+					SetInput(i, lane, src);
+					src += type.Elements() * type.Components();
+				}
+			}
+
+			if(!Execute(active)) return false;
+
+			for(unsigned int lane = 0; lane < active; lane++)
+			{
+				float* dst = outputs + (base + lane) * outputStride;
+				for(unsigned int o = 0; o < program.outputs.size(); o++)
+				{
+					GetOutput(o, lane, dst);
+					dst += program.outputs[o].type.Components();
+				}
+			}
+		}
+
+		return true;
+	}
+
+}
+}
+}
+}
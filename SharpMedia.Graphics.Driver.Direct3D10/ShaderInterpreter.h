@@ -0,0 +1,189 @@
+#pragma once
+#include <vector>
+#include "ShaderProgram.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Number of invocations interpreted at once (one SIMD lane each).
+	const unsigned int ShaderLanes = 8;
+
+	enum ShaderAddress
+	{
+		ShaderAddressWrap,
+		ShaderAddressMirror,
+		ShaderAddressClamp,
+		ShaderAddressBorder
+	};
+
+	// Sampler state used by CPU sampling.
+	struct ShaderSampler
+	{
+		bool linear;
+		ShaderAddress address[3];
+		float border[4];
+
+		ShaderSampler();
+	};
+
+	// A texture that can be read by the interpreter. Coordinates are laid out as in HLSL for the
+	// dimension of the texture register.
+	class ShaderTexture
+	{
+	public:
+		virtual ~ShaderTexture() {}
+
+		// Whether texture can be read as a register of dimension.
+		virtual bool Supports(ShaderTextureDimension dimension) const = 0;
+
+		// Width, height and depth of the most detailed mipmap (in texels).
+		virtual void GetSize(unsigned int* size) const = 0;
+
+		// Filtered sample at normalized coordinates (offset is in texels and may be null) from
+		// mipmap at level of detail 'lod'.
+		virtual void Sample(const ShaderSampler& sampler, ShaderTextureDimension dimension, const float* coord,
+			const int* offset, float lod, float* result) const = 0;
+
+		// Unfiltered fetch at texel coordinates; the last coordinate is the mipmap.
+		virtual void Load(ShaderTextureDimension dimension, const int* coord, const int* offset, float* result) const = 0;
+	};
+
+	// A CPU 1D or 2D texture (or array of them) of four float components per texel, with optional
+	// mipmaps. 1D textures have height of 1.
+	class ShaderTexture2D : public ShaderTexture
+	{
+		struct Level
+		{
+			unsigned int width, height, layers;
+			std::vector<float> texels;
+		};
+
+		std::vector<Level> levels;
+
+		void Fetch(const ShaderSampler& sampler, unsigned int mip, int x, int y, unsigned int layer, float* result) const;
+		void SampleLevel(const ShaderSampler& sampler, unsigned int mip, float u, float v, unsigned int layer,
+			int ox, int oy, float* result) const;
+	public:
+		// Adds a mipmap level (width * height * 4 floats).
+		void AddLevel(unsigned int width, unsigned int height, const float* texels);
+
+		// Adds a mipmap level of all array layers (layer after layer).
+		void AddLevel(unsigned int width, unsigned int height, unsigned int layers, const float* texels);
+
+		virtual bool Supports(ShaderTextureDimension dimension) const;
+		virtual void GetSize(unsigned int* size) const;
+		virtual void Sample(const ShaderSampler& sampler, ShaderTextureDimension dimension, const float* coord,
+			const int* offset, float lod, float* result) const;
+		virtual void Load(ShaderTextureDimension dimension, const int* coord, const int* offset, float* result) const;
+	};
+
+	// A CPU 3D texture of four float components per texel, with optional mipmaps.
+	class ShaderTexture3D : public ShaderTexture
+	{
+		struct Level
+		{
+			unsigned int width, height, depth;
+			std::vector<float> texels;
+		};
+
+		std::vector<Level> levels;
+
+		void Fetch(const ShaderSampler& sampler, unsigned int mip, int x, int y, int z, float* result) const;
+		void SampleLevel(const ShaderSampler& sampler, unsigned int mip, const float* coord, const int* offset,
+			float* result) const;
+	public:
+		// Adds a mipmap level (width * height * depth * 4 floats, slice after slice).
+		void AddLevel(unsigned int width, unsigned int height, unsigned int depth, const float* texels);
+
+		virtual bool Supports(ShaderTextureDimension dimension) const;
+		virtual void GetSize(unsigned int* size) const;
+		virtual void Sample(const ShaderSampler& sampler, ShaderTextureDimension dimension, const float* coord,
+			const int* offset, float lod, float* result) const;
+		virtual void Load(ShaderTextureDimension dimension, const int* coord, const int* offset, float* result) const;
+	};
+
+	// A CPU cube texture, faces are in D3D order (+x, -x, +y, -y, +z, -z). Cubes are only sampled
+	// (edges are clamped to the selected face); loads return zero as HLSL has no cube load.
+	class ShaderTextureCube : public ShaderTexture
+	{
+		ShaderTexture2D faces;
+	public:
+		// Adds a mipmap level of all six faces (size * size * 4 floats each, face after face).
+		void AddLevel(unsigned int size, const float* texels);
+
+		virtual bool Supports(ShaderTextureDimension dimension) const;
+		virtual void GetSize(unsigned int* size) const;
+		virtual void Sample(const ShaderSampler& sampler, ShaderTextureDimension dimension, const float* coord,
+			const int* offset, float lod, float* result) const;
+		virtual void Load(ShaderTextureDimension dimension, const int* coord, const int* offset, float* result) const;
+	};
+
+	// A reference interpreter of the compiler's instruction stream. Values are stored as structure
+	// of arrays (component-major, lane-minor) so each operation processes ShaderLanes invocations
+	// with vectorizable loops. Divergent flow control is handled with execution masks.
+	//
+	// Integer values are held in floats and are exact up to 2^24. Sampling uses the most detailed
+	// mipmap unless lanes are pixel quads, in which case level of detail comes from differences
+	// of coordinates within the quad. Reading a texture that does not support the dimension of its
+	// register (or a buffer) fails execution.
+	class ShaderInterpreter
+	{
+		struct Frame;
+
+		const ShaderProgram& program;
+		std::vector<float> storage;
+		std::vector<unsigned int> offsets;
+		std::vector<float> outputStorage;
+		std::vector<unsigned int> outputOffsets;
+		std::vector<const void*> constantBuffers;
+		std::vector<unsigned int> constantSizes;
+		std::vector<const ShaderTexture*> textures;
+		std::vector<ShaderSampler> samplers;
+		unsigned int maxIterations;
+		bool quads;
+		bool failed;
+
+		float* Value(int reg, unsigned int element, unsigned int component);
+		const float* Operand(int reg, unsigned int component, unsigned int element = 0);
+		void Write(int reg, unsigned int element, unsigned int component, const float* value, const unsigned char* mask);
+		void LoadConstants();
+		float QuadLod(int posReg, ShaderTextureDimension dimension, const unsigned int* size, unsigned int lane);
+		void Compute(const ShaderInstruction& instr, const unsigned char* mask);
+	public:
+		ShaderInterpreter(const ShaderProgram& program);
+
+		void BindConstantBuffer(unsigned int slot, const void* data, unsigned int size);
+		void BindTexture(unsigned int slot, const ShaderTexture* texture);
+		void BindSampler(unsigned int slot, const ShaderSampler& sampler);
+
+		// Upper bound of loop iterations before execution is aborted.
+		void SetMaxIterations(unsigned int iterations);
+
+		// Treats lanes as 2x2 pixel quads (lanes 0-3 and 4-7, ordered top-left, top-right, bottom-left,
+		// bottom-right) so sampling selects mipmaps.
+		void SetQuads(bool quads);
+
+		// Sets input (all elements and components) of a lane.
+		void SetInput(unsigned int input, unsigned int lane, const float* values);
+
+		// Obtains output of a lane.
+		void GetOutput(unsigned int output, unsigned int lane, float* values) const;
+
+		// Executes the first 'active' lanes; returns false if the program is malformed, a loop
+		// does not terminate or a texture cannot be read.
+		bool Execute(unsigned int active);
+
+		// Floats per invocation of packed inputs/outputs (in registration order).
+		unsigned int InputStride() const;
+		unsigned int OutputStride() const;
+
+		// Runs 'count' invocations over packed inputs and outputs, ShaderLanes at once.
+		bool Run(unsigned int count, const float* inputs, float* outputs);
+	};
+
+}
+}
+}
+}
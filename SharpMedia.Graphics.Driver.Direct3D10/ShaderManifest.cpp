@@ -0,0 +1,133 @@
+#include "ShaderManifest.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	D3D10ShaderManifest::D3D10ShaderManifest()
+	{
+		Clear();
+	}
+
+	void D3D10ShaderManifest::Clear()
+	{
+		samplers = 0;
+		constants = 0;
+		memset(textures, 0, sizeof(textures));
+		memset(constantSizes, 0, sizeof(constantSizes));
+		inputs.clear();
+		outputs.clear();
+		reflected = false;
+		reportedSamplers = 0;
+		reportedConstants = 0;
+		memset(reportedTextures, 0, sizeof(reportedTextures));
+	}
+
+	void D3D10ShaderManifest::UseAll()
+	{
+		Clear();
+		samplers = 0xFFFFFFFF >> (32 - MaxSamplerSlots);
+		constants = 0xFFFFFFFF >> (32 - MaxConstantBufferSlots);
+		memset(textures, 0xFF, sizeof(textures));
+	}
+
+	void D3D10ShaderManifest::UseSampler(unsigned int slot)
+	{
+		if(slot < MaxSamplerSlots) samplers |= 1u << slot;
+	}
+
+	void D3D10ShaderManifest::UseTexture(unsigned int slot)
+	{
+		if(slot < MaxTextureSlots) textures[slot / 32] |= 1u << (slot % 32);
+	}
+
+	void D3D10ShaderManifest::UseConstantBuffer(unsigned int slot, unsigned int size)
+	{
+		if(slot >= MaxConstantBufferSlots) return;
+		constants |= 1u << slot;
+		constantSizes[slot] = size;
+	}
+
+	bool D3D10ShaderManifest::IsSamplerUsed(unsigned int slot) const
+	{
+		return slot < MaxSamplerSlots && (samplers & (1u << slot)) != 0;
+	}
+
+	bool D3D10ShaderManifest::IsTextureUsed(unsigned int slot) const
+	{
+		return slot < MaxTextureSlots && (textures[slot / 32] & (1u << (slot % 32))) != 0;
+	}
+
+	bool D3D10ShaderManifest::IsConstantBufferUsed(unsigned int slot) const
+	{
+		return slot < MaxConstantBufferSlots && (constants & (1u << slot)) != 0;
+	}
+
+	bool D3D10ShaderManifest::ReportSampler(unsigned int slot) const
+	{
+		if(slot >= MaxSamplerSlots || (reportedSamplers & (1u << slot)) != 0) return false;
+		reportedSamplers |= 1u << slot;
+		return true;
+	}
+
+	bool D3D10ShaderManifest::ReportTexture(unsigned int slot) const
+	{
+		if(slot >= MaxTextureSlots || (reportedTextures[slot / 32] & (1u << (slot % 32))) != 0) return false;
+		reportedTextures[slot / 32] |= 1u << (slot % 32);
+		return true;
+	}
+
+	bool D3D10ShaderManifest::ReportConstantBuffer(unsigned int slot) const
+	{
+		if(slot >= MaxConstantBufferSlots || (reportedConstants & (1u << slot)) != 0) return false;
+		reportedConstants |= 1u << slot;
+		return true;
+	}
+
+	void D3D10ShaderManifest::SamplerRange(unsigned int supplied, unsigned int& first, unsigned int& count) const
+	{
+		SlotRange(&samplers, 1, supplied, first, count);
+	}
+
+	void D3D10ShaderManifest::TextureRange(unsigned int supplied, unsigned int& first, unsigned int& count) const
+	{
+		SlotRange(textures, MaxTextureSlots / 32, supplied, first, count);
+	}
+
+	void D3D10ShaderManifest::ConstantBufferRange(unsigned int supplied, unsigned int& first, unsigned int& count) const
+	{
+		SlotRange(&constants, 1, supplied, first, count);
+	}
+
+	void SlotRange(const unsigned int* mask, unsigned int words, unsigned int supplied,
+		unsigned int& first, unsigned int& count)
+	{
+		first = 0;
+		count = 0;
+
+		// We only consider slots that caller supplied; unused slots at both ends are skipped
+		// (slots in between are bound in the same call, that is cheaper than splitting).
+		unsigned int limit = supplied < words * 32 ? supplied : words * 32;
+		bool found = false;
+		unsigned int last = 0;
+		for(unsigned int i = 0; i < limit; i++)
+		{
+			if((mask[i / 32] & (1u << (i % 32))) == 0) continue;
+
+			if(!found)
+			{
+				first = i;
+				found = true;
+			}
+			last = i;
+		}
+
+		if(found) count = last - first + 1;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Slot counts of D3D10 common shader stages.
+	const unsigned int MaxSamplerSlots = 16;
+	const unsigned int MaxTextureSlots = 128;
+	const unsigned int MaxConstantBufferSlots = 16;
+
+	// A single input or output signature parameter.
+	struct D3D10SignatureElement
+	{
+		std::string semantic;
+		unsigned int semanticIndex;
+		unsigned int reg;
+		unsigned int mask;
+	};
+
+	// A compact binding manifest of a compiled shader (what it actually reads).
+	struct D3D10ShaderManifest
+	{
+		unsigned int samplers;									//< Bit per used sampler slot.
+		unsigned int textures[MaxTextureSlots / 32];			//< Bit per used texture slot.
+		unsigned int constants;									//< Bit per used constant buffer slot.
+		unsigned int constantSizes[MaxConstantBufferSlots];		//< Size (in bytes) of used constant buffers.
+		std::vector<D3D10SignatureElement> inputs;
+		std::vector<D3D10SignatureElement> outputs;
+		bool reflected;											//< Slots were obtained by reflection.
+
+		// Slots whose binding mismatch (read but not bound, or bound but not read) was already
+		// reported; each is reported once.
+		mutable unsigned int reportedSamplers;
+		mutable unsigned int reportedTextures[MaxTextureSlots / 32];
+		mutable unsigned int reportedConstants;
+
+		D3D10ShaderManifest();
+		void Clear();
+
+		// Marks all slots used, for shaders that could not be reflected (everything is bound).
+		void UseAll();
+
+		void UseSampler(unsigned int slot);
+		void UseTexture(unsigned int slot);
+		void UseConstantBuffer(unsigned int slot, unsigned int size);
+
+		bool IsSamplerUsed(unsigned int slot) const;
+		bool IsTextureUsed(unsigned int slot) const;
+		bool IsConstantBufferUsed(unsigned int slot) const;
+
+		// Return true only the first time mismatch of slot is reported.
+		bool ReportSampler(unsigned int slot) const;
+		bool ReportTexture(unsigned int slot) const;
+		bool ReportConstantBuffer(unsigned int slot) const;
+
+		// Computes range of slots [first, first+count) that must be bound when caller supplies
+		// 'supplied' slots. Count is 0 if nothing needs to be bound.
+		void SamplerRange(unsigned int supplied, unsigned int& first, unsigned int& count) const;
+		void TextureRange(unsigned int supplied, unsigned int& first, unsigned int& count) const;
+		void ConstantBufferRange(unsigned int supplied, unsigned int& first, unsigned int& count) const;
+	};
+
+	// Computes bound range over a slot bit mask of 'words' 32-bit words.
+	void SlotRange(const unsigned int* mask, unsigned int words, unsigned int supplied,
+		unsigned int& first, unsigned int& count);
+
+}
+}
+}
+}
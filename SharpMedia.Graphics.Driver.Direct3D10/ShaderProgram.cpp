@@ -0,0 +1,469 @@
+#include "ShaderProgram.h"
+#include <cstdio>
+#include <algorithm>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	void ShaderProgram::Clear()
+	{
+		names.clear();
+		registers.clear();
+		instructions.clear();
+		inputs.clear();
+		inputComponents.clear();
+		outputs.clear();
+	}
+
+	int ShaderProgram::Declare(int name, ShaderRegisterKind kind, const ShaderType& type)
+	{
+		ShaderRegister r;
+		r.kind = kind;
+		r.type = type;
+		r.slot = 0;
+		r.offset = 0;
+		r.dimension = ShaderDimension2D;
+
+		int index = (int)registers.size();
+		registers.push_back(r);
+		names[name] = index;
+		return index;
+	}
+
+	int ShaderProgram::Find(int name) const
+	{
+		std::map<int, int>::const_iterator i = names.find(name);
+		return i == names.end() ? -1 : i->second;
+	}
+
+	ShaderInstruction& ShaderProgram::Emit(ShaderOpcode op, int dst, int a, int b, int c, int d, unsigned int param)
+	{
+		ShaderInstruction i;
+		i.op = op;
+		i.dst = dst == -1 ? -1 : Find(dst);
+		i.a = a == -1 ? -1 : Find(a);
+		i.b = b == -1 ? -1 : Find(b);
+		i.c = c == -1 ? -1 : Find(c);
+		i.d = d == -1 ? -1 : Find(d);
+		i.param = param;
+		i.swizzle[0] = 0; i.swizzle[1] = 1; i.swizzle[2] = 2; i.swizzle[3] = 3;
+		i.jump = -1;
+		i.parent = -1;
+		i.hint = ShaderFlowAuto;
+
+		instructions.push_back(i);
+		return instructions.back();
+	}
+
+	bool ShaderProgram::Link()
+	{
+		// Stack of open flow control instructions.
+		std::vector<int> open;
+
+		for(int i = 0; i < (int)instructions.size(); i++)
+		{
+			ShaderInstruction& instr = instructions[i];
+			switch(instr.op)
+			{
+			case ShaderOpIf:
+			case ShaderOpWhile:
+			case ShaderOpSwitch:
+				open.push_back(i);
+				break;
+			case ShaderOpCase:
+			case ShaderOpDefault:
+				if(open.empty() || instructions[open.back()].op != ShaderOpSwitch) return false;
+				instr.parent = open.back();
+				open.push_back(i);
+				break;
+			case ShaderOpElse:
+				if(open.empty() || instructions[open.back()].op != ShaderOpIf) return false;
+				instructions[open.back()].jump = i;
+				open.back() = i;
+				break;
+			case ShaderOpEndIf:
+				if(open.empty()) return false;
+				if(instructions[open.back()].op != ShaderOpIf && instructions[open.back()].op != ShaderOpElse) return false;
+				instructions[open.back()].jump = i;
+				open.pop_back();
+				break;
+			case ShaderOpBreak:
+				{
+					// Break belongs to the innermost loop or case (as in HLSL).
+					int target = -1;
+					for(int j = (int)open.size() - 1; j >= 0; j--)
+					{
+						ShaderOpcode op = instructions[open[j]].op;
+						if(op == ShaderOpWhile || op == ShaderOpCase || op == ShaderOpDefault)
+						{
+							target = open[j];
+							break;
+						}
+					}
+					if(target == -1) return false;
+					instr.jump = target;
+				}
+				break;
+			case ShaderOpEndWhile:
+				if(open.empty() || instructions[open.back()].op != ShaderOpWhile) return false;
+				instructions[open.back()].jump = i;
+				instr.jump = open.back();
+				open.pop_back();
+				break;
+			case ShaderOpEndCase:
+				if(open.empty()) return false;
+				if(instructions[open.back()].op != ShaderOpCase && instructions[open.back()].op != ShaderOpDefault) return false;
+				instructions[open.back()].jump = i;
+				instr.jump = open.back();
+				open.pop_back();
+				break;
+			case ShaderOpEndSwitch:
+				if(open.empty() || instructions[open.back()].op != ShaderOpSwitch) return false;
+				instructions[open.back()].jump = i;
+				instr.jump = open.back();
+				open.pop_back();
+				break;
+			default:
+				break;
+			}
+
+			// All non flow control operations must reference declared registers.
+			if(instr.op < ShaderOpIf && instr.op != ShaderOpOutput && instr.dst == -1) return false;
+		}
+
+		return open.empty();
+	}
+
+	void ShaderProgram::Analyze(std::vector<unsigned char>& varying, std::vector<unsigned char>& divergent) const
+	{
+		varying.assign(registers.size(), 0);
+		divergent.assign(instructions.size(), 0);
+		for(size_t r = 0; r < registers.size(); r++)
+		{
+			if(registers[r].kind == ShaderRegisterInput) varying[r] = 1;
+		}
+
+		// Loop carried values and late breaks need iteration to a fixed point.
+		bool changed = true;
+		while(changed)
+		{
+			changed = false;
+
+			// Divergence of open blocks (including enclosing ones).
+			std::vector<unsigned char> open;
+			open.push_back(0);
+
+			for(size_t i = 0; i < instructions.size(); i++)
+			{
+				const ShaderInstruction& instr = instructions[i];
+				switch(instr.op)
+				{
+				case ShaderOpIf:
+				case ShaderOpSwitch:
+					if(varying[instr.a] && !divergent[i])
+					{
+						divergent[i] = 1;
+						changed = true;
+					}
+					open.push_back(open.back() | divergent[i]);
+					break;
+				case ShaderOpWhile:
+					open.push_back(open.back() | divergent[i]);
+					break;
+				case ShaderOpCase:
+				case ShaderOpDefault:
+					open.push_back(open.back());
+					break;
+				case ShaderOpElse:
+					break;
+				case ShaderOpEndIf:
+				case ShaderOpEndWhile:
+				case ShaderOpEndCase:
+				case ShaderOpEndSwitch:
+					open.pop_back();
+					break;
+				case ShaderOpBreak:
+					{
+						// Loop diverges if some invocations leave it earlier.
+						int loop = instructions[instr.jump].op == ShaderOpWhile ? instr.jump : -1;
+						if(loop != -1 && (varying[instr.a] || open.back()) && !divergent[loop])
+						{
+							divergent[loop] = 1;
+							changed = true;
+						}
+					}
+					break;
+				default:
+					{
+						if(instr.dst < 0) break;
+
+						bool v = open.back() != 0;
+						if(instr.a >= 0 && varying[instr.a]) v = true;
+						if(instr.b >= 0 && varying[instr.b]) v = true;
+						if(instr.c >= 0 && varying[instr.c]) v = true;
+						if(instr.d >= 0 && varying[instr.d]) v = true;
+
+						if(v && !varying[instr.dst])
+						{
+							varying[instr.dst] = 1;
+							changed = true;
+						}
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	static bool IsFixedScalar(const ShaderRegister& reg)
+	{
+		return reg.kind == ShaderRegisterFixed && reg.type.Components() == 1 && !reg.data.empty();
+	}
+
+	static bool Holds(unsigned int code, float x, float y)
+	{
+		switch(code)
+		{
+		case ShaderCompareLess: return x < y;
+		case ShaderCompareLessEqual: return x <= y;
+		case ShaderCompareGreater: return x > y;
+		case ShaderCompareGreaterEqual: return x >= y;
+		case ShaderCompareEqual: return x == y;
+		default: return x != y;
+		}
+	}
+
+	unsigned int ShaderProgram::TripCount(int loop) const
+	{
+		int end = instructions[loop].jump;
+
+		// The only break of loop must be at its top level.
+		int exit = -1, depth = 0;
+		for(int j = loop + 1; j < end; j++)
+		{
+			switch(instructions[j].op)
+			{
+			case ShaderOpIf:
+			case ShaderOpWhile:
+			case ShaderOpSwitch:
+				depth++;
+				break;
+			case ShaderOpEndIf:
+			case ShaderOpEndWhile:
+			case ShaderOpEndSwitch:
+				depth--;
+				break;
+			case ShaderOpBreak:
+				if(instructions[j].jump != loop) break;
+				if(exit != -1 || depth != 0) return 0;
+				exit = j;
+				break;
+			default:
+				break;
+			}
+		}
+		if(exit < loop + 2) return 0;
+
+		// Break tests counter against a fixed limit right before it.
+		const ShaderInstruction& compare = instructions[exit - 1];
+		if(compare.op != ShaderOpCompare || compare.dst != instructions[exit].a) return 0;
+		if(registers[compare.a].kind != ShaderRegisterTemp || !IsFixedScalar(registers[compare.b])) return 0;
+		int counter = compare.a;
+		float limit = registers[compare.b].data[0];
+
+		// Counter is stepped once at top level of the loop.
+		int step = -1;
+		float delta = 0.0f;
+		depth = 0;
+		for(int j = loop + 1; j < end; j++)
+		{
+			const ShaderInstruction& instr = instructions[j];
+			if(instr.op == ShaderOpIf || instr.op == ShaderOpWhile || instr.op == ShaderOpSwitch) depth++;
+			if(instr.op == ShaderOpEndIf || instr.op == ShaderOpEndWhile || instr.op == ShaderOpEndSwitch) depth--;
+			if(instr.op >= ShaderOpIf || instr.dst != counter) continue;
+
+			if(step != -1 || depth != 0) return 0;
+			if((instr.op != ShaderOpAdd && instr.op != ShaderOpSub) || instr.a != counter) return 0;
+			if(!IsFixedScalar(registers[instr.b])) return 0;
+			step = j;
+			delta = instr.op == ShaderOpAdd ? registers[instr.b].data[0] : -registers[instr.b].data[0];
+		}
+		if(step == -1) return 0;
+
+		// Counter is set from fixed value with no flow control before the loop.
+		int init = loop - 1;
+		while(init >= 0 && instructions[init].op < ShaderOpIf && instructions[init].dst != counter) init--;
+		if(init < 0 || instructions[init].op != ShaderOpMov || !IsFixedScalar(registers[instructions[init].a])) return 0;
+		float value = registers[instructions[init].a].data[0];
+
+		// Iterations are counted as executed.
+		bool testFirst = exit < step;
+		for(unsigned int n = 0; n <= ShaderUnrollLimit; n++)
+		{
+			if(testFirst)
+			{
+				if(!Holds(compare.param, value, limit)) return n;
+				value += delta;
+			} else {
+				value += delta;
+				if(!Holds(compare.param, value, limit)) return n + 1;
+			}
+		}
+		return 0;
+	}
+
+	void ShaderProgram::ChooseFlowAttributes(std::vector<ShaderFlowAttribute>& attributes,
+		std::vector<unsigned int>& unrollCounts) const
+	{
+		attributes.assign(instructions.size(), ShaderFlowAuto);
+		unrollCounts.assign(instructions.size(), 0);
+
+		std::vector<unsigned char> varying, divergent;
+		Analyze(varying, divergent);
+
+		for(int i = 0; i < (int)instructions.size(); i++)
+		{
+			const ShaderInstruction& instr = instructions[i];
+			if(instr.op != ShaderOpIf && instr.op != ShaderOpWhile && instr.op != ShaderOpSwitch) continue;
+
+			// Author's hint is used if it applies to the instruction.
+			ShaderFlowAttribute hint = instr.hint;
+			switch(instr.op)
+			{
+			case ShaderOpIf:
+				if(hint == ShaderFlowBranch || hint == ShaderFlowFlatten)
+				{
+					attributes[i] = hint;
+					continue;
+				}
+				break;
+			case ShaderOpWhile:
+				if(hint == ShaderFlowLoop || hint == ShaderFlowUnroll)
+				{
+					attributes[i] = hint;
+					unrollCounts[i] = hint == ShaderFlowUnroll ? instr.param : 0;
+					continue;
+				}
+				break;
+			default:
+				if(hint == ShaderFlowBranch || hint == ShaderFlowFlatten || hint == ShaderFlowForceCase)
+				{
+					attributes[i] = hint;
+					continue;
+				}
+				break;
+			}
+
+			// The block ends at end of else part for ifs.
+			int end = instr.jump;
+			if(instructions[end].op == ShaderOpElse) end = instructions[end].jump;
+
+			unsigned int count = 0;
+			bool gradients = false;
+			for(int j = i + 1; j < end; j++)
+			{
+				if(instructions[j].op < ShaderOpIf) count++;
+				if(instructions[j].op == ShaderOpSample) gradients = true;
+			}
+
+			switch(instr.op)
+			{
+			case ShaderOpIf:
+				if(!divergent[i]) attributes[i] = ShaderFlowBranch;
+				else if(gradients || count < ShaderBranchThreshold) attributes[i] = ShaderFlowFlatten;
+				else attributes[i] = ShaderFlowBranch;
+				break;
+			case ShaderOpWhile:
+				// Gradients in a divergent loop need it unrolled, which needs a known trip count.
+				if(!divergent[i] || !gradients) attributes[i] = ShaderFlowLoop;
+				else if((unrollCounts[i] = TripCount(i)) != 0) attributes[i] = ShaderFlowUnroll;
+				break;
+			default:
+				if(!divergent[i]) attributes[i] = ShaderFlowForceCase;
+				else if(gradients || count < ShaderBranchThreshold) attributes[i] = ShaderFlowFlatten;
+				else attributes[i] = ShaderFlowBranch;
+				break;
+			}
+		}
+	}
+
+	bool ShaderProgram::LinkOutputs(const ShaderProgram& consumer, const std::vector<unsigned long long>& generated,
+		const std::vector<unsigned long long>& kept, std::vector<int>& order, unsigned long long& missing) const
+	{
+		std::vector<unsigned char> used(outputs.size(), 0);
+		order.clear();
+
+		for(size_t i = 0; i < consumer.inputComponents.size(); i++)
+		{
+			unsigned long long component = consumer.inputComponents[i];
+
+			size_t o = 0;
+			while(o < outputs.size() && outputs[o].component != component) o++;
+			if(o == outputs.size())
+			{
+				if(std::find(generated.begin(), generated.end(), component) != generated.end()) continue;
+				missing = component;
+				return false;
+			}
+
+			order.push_back((int)o);
+			used[o] = 1;
+		}
+
+		for(size_t o = 0; o < outputs.size(); o++)
+		{
+			if(used[o]) continue;
+			if(std::find(kept.begin(), kept.end(), outputs[o].component) != kept.end()) order.push_back((int)o);
+		}
+		return true;
+	}
+
+	static std::string ToHLSLAttribute(ShaderFlowAttribute attribute, unsigned int unrollCount)
+	{
+		switch(attribute)
+		{
+		case ShaderFlowBranch:
+			return "[branch]";
+		case ShaderFlowFlatten:
+			return "[flatten]";
+		case ShaderFlowLoop:
+			return "[loop]";
+		case ShaderFlowUnroll:
+			{
+				if(unrollCount == 0) return "[unroll]";
+				char text[32];
+				snprintf(text, sizeof(text), "[unroll(%u)]", unrollCount);
+				return text;
+			}
+		case ShaderFlowForceCase:
+			return "[forcecase]";
+		default:
+			return "";
+		}
+	}
+
+	std::string ShaderProgram::InsertFlowAttributes(const std::string& code, const std::vector<size_t>& offsets,
+		const std::vector<int>& flow) const
+	{
+		std::vector<ShaderFlowAttribute> attributes;
+		std::vector<unsigned int> unrollCounts;
+		ChooseFlowAttributes(attributes, unrollCounts);
+
+		std::string result;
+		size_t last = 0;
+		for(size_t i = 0; i < offsets.size(); i++)
+		{
+			result.append(code, last, offsets[i] - last);
+			result.append(ToHLSLAttribute(attributes[flow[i]], unrollCounts[flow[i]]));
+			last = offsets[i];
+		}
+		result.append(code, last, std::string::npos);
+		return result;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,225 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <cstddef>
+#include <string>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Scalar type of shader IR values.
+	enum ShaderScalar
+	{
+		ShaderScalarFloat,
+		ShaderScalarInt,
+		ShaderScalarUInt,
+		ShaderScalarBool
+	};
+
+	// Type of a shader IR register; vectors have one row, arrays have arraySize > 0.
+	struct ShaderType
+	{
+		ShaderScalar scalar;
+		unsigned int rows;
+		unsigned int columns;
+		unsigned int arraySize;
+
+		unsigned int Components() const { return rows * columns; }
+		unsigned int Elements() const { return arraySize ? arraySize : 1; }
+	};
+
+	enum ShaderRegisterKind
+	{
+		ShaderRegisterTemp,
+		ShaderRegisterInput,
+		ShaderRegisterConstant,
+		ShaderRegisterFixed,
+		ShaderRegisterSampler,
+		ShaderRegisterTexture
+	};
+
+	// Texture dimension of texture registers.
+	enum ShaderTextureDimension
+	{
+		ShaderDimensionBuffer,
+		ShaderDimension1D,
+		ShaderDimension1DArray,
+		ShaderDimension2D,
+		ShaderDimension2DArray,
+		ShaderDimensionCube,
+		ShaderDimension3D
+	};
+
+	enum ShaderOpcode
+	{
+		ShaderOpConvert,
+		ShaderOpAdd,
+		ShaderOpSub,
+		ShaderOpMul,
+		ShaderOpDiv,
+		ShaderOpMin,
+		ShaderOpMax,
+		ShaderOpMulEx,
+		ShaderOpDot,
+		ShaderOpSwizzle,
+		ShaderOpMov,
+		ShaderOpExpand,
+		ShaderOpCall,
+		ShaderOpCompare,
+		ShaderOpSample,
+		ShaderOpLoad,
+		ShaderOpIndex,
+		ShaderOpOutput,
+		ShaderOpIf,
+		ShaderOpElse,
+		ShaderOpEndIf,
+		ShaderOpWhile,
+		ShaderOpBreak,
+		ShaderOpEndWhile,
+		ShaderOpSwitch,
+		ShaderOpCase,
+		ShaderOpDefault,
+		ShaderOpEndCase,
+		ShaderOpEndSwitch
+	};
+
+	// Parameters of ShaderOpCall.
+	enum ShaderFunctionCode
+	{
+		ShaderFunctionAbs,
+		ShaderFunctionFloor,
+		ShaderFunctionCeil,
+		ShaderFunctionLength,
+		ShaderFunctionAll,
+		ShaderFunctionAny,
+		ShaderFunctionNone
+	};
+
+	// Parameters of ShaderOpCompare.
+	enum ShaderCompareCode
+	{
+		ShaderCompareLess,
+		ShaderCompareLessEqual,
+		ShaderCompareGreater,
+		ShaderCompareGreaterEqual,
+		ShaderCompareEqual,
+		ShaderCompareNotEqual
+	};
+
+	// Parameters of ShaderOpExpand.
+	enum ShaderExpandCode
+	{
+		ShaderExpandZeros,
+		ShaderExpandOnes,
+		ShaderExpandOnesAtW
+	};
+
+	// HLSL flow control attributes.
+	enum ShaderFlowAttribute
+	{
+		ShaderFlowAuto,						//< No attribute, HLSL compiler decides.
+		ShaderFlowBranch,
+		ShaderFlowFlatten,
+		ShaderFlowLoop,
+		ShaderFlowUnroll,
+		ShaderFlowForceCase
+	};
+
+	// Blocks with fewer instructions are cheaper to flatten than to branch over.
+	const unsigned int ShaderBranchThreshold = 8;
+
+	// Loops with more iterations are not unrolled automatically.
+	const unsigned int ShaderUnrollLimit = 64;
+
+	struct ShaderRegister
+	{
+		ShaderRegisterKind kind;
+		ShaderType type;
+		unsigned int slot;					//< Input index, constant buffer, sampler or texture register.
+		unsigned int offset;				//< Offset in constant buffer (bytes).
+		ShaderTextureDimension dimension;	//< Texture dimension (textures only).
+		std::vector<float> data;			//< Fixed values.
+	};
+
+	struct ShaderInstruction
+	{
+		ShaderOpcode op;
+		int dst;
+		int a, b, c, d;						//< Register operands, -1 if not used.
+		unsigned int param;					//< Function/compare/expand code, output index, swizzle or unroll count.
+		unsigned char swizzle[4];
+		int jump;							//< Matching flow control instruction (set by Link).
+		int parent;							//< Enclosing switch of case/default (set by Link).
+		ShaderFlowAttribute hint;			//< Author's attribute of if, while and switch.
+	};
+
+	struct ShaderOutput
+	{
+		unsigned long long component;
+		ShaderType type;
+		int reg;
+	};
+
+	// A shader instruction stream, recorded by the compiler alongside HLSL generation. Registers
+	// are named by the compiler's pin names and resolved to dense indices.
+	class ShaderProgram
+	{
+		std::map<int, int> names;
+	public:
+		std::vector<ShaderRegister> registers;
+		std::vector<ShaderInstruction> instructions;
+		std::vector<int> inputs;					//< Register of each input, in registration order.
+		std::vector<unsigned long long> inputComponents;
+		std::vector<ShaderOutput> outputs;
+
+		void Clear();
+
+		// Declares a named register, returns its index.
+		int Declare(int name, ShaderRegisterKind kind, const ShaderType& type);
+
+		// Finds register by name, -1 if not declared.
+		int Find(int name) const;
+
+		// Appends instruction with named operands (-1 if not used).
+		ShaderInstruction& Emit(ShaderOpcode op, int dst, int a = -1, int b = -1, int c = -1, int d = -1, unsigned int param = 0);
+
+		// Resolves flow control; returns false if program is malformed.
+		bool Link();
+
+		// Finds registers whose value may differ between invocations (inputs and everything
+		// computed from them or written under divergent flow control), and if, while and switch
+		// instructions whose condition diverges. Program must be linked.
+		void Analyze(std::vector<unsigned char>& varying, std::vector<unsigned char>& divergent) const;
+
+		// Iterations of a counted loop: a counter set from a fixed value right before the loop,
+		// stepped once by a fixed value in its body and compared with a fixed value at the only
+		// break of the loop. Returns 0 if not known or above ShaderUnrollLimit.
+		unsigned int TripCount(int loop) const;
+
+		// Chooses attribute of each if, while and switch (Auto for others) and unroll count of
+		// unrolled loops (0 if not bounded). Valid author's hints are kept; otherwise uniform
+		// conditions branch, divergent ones branch only over large blocks without gradient
+		// operations, and divergent loops with gradients are unrolled if counted. Program must
+		// be linked.
+		void ChooseFlowAttributes(std::vector<ShaderFlowAttribute>& attributes,
+			std::vector<unsigned int>& unrollCounts) const;
+
+		// Orders outputs as consumer reads its inputs (by inputComponents), so signatures match
+		// register by register. Inputs 'generated' by hardware need no output, and outputs in
+		// 'kept' are appended even if not read. Returns false with the 'missing' component if
+		// consumer reads one that is not written.
+		bool LinkOutputs(const ShaderProgram& consumer, const std::vector<unsigned long long>& generated,
+			const std::vector<unsigned long long>& kept, std::vector<int>& order, unsigned long long& missing) const;
+
+		// Inserts HLSL attribute of each flow control instruction (flow[i]) at its offset in code
+		// (offsets[i], ascending). Program must be linked.
+		std::string InsertFlowAttributes(const std::string& code, const std::vector<size_t>& offsets,
+			const std::vector<int>& flow) const;
+	};
+
+}
+}
+}
+}
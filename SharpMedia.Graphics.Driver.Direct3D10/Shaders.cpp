@@ -11,14 +11,21 @@ namespace Direct3D10 {
 		device->PSSetShader(shader);
 	}
 
-	D3D10PShader::D3D10PShader(ID3D10PixelShader* shader)
+	const D3D10ShaderManifest* D3D10PShader::GetManifest()
+	{
+		return manifest;
+	}
+
+	D3D10PShader::D3D10PShader(ID3D10PixelShader* shader, const D3D10ShaderManifest& manifest)
 	{
 		this->shader = shader;
+		this->manifest = new D3D10ShaderManifest(manifest);
 	}
 
 	D3D10PShader::~D3D10PShader()
 	{
 		shader->Release();
+		delete manifest;
 	}
 
 	void D3D10VShader::Apply(ID3D10Device* device)
@@ -26,14 +33,21 @@ namespace Direct3D10 {
 		device->VSSetShader(shader);
 	}
 
-	D3D10VShader::D3D10VShader(ID3D10VertexShader* shader)
+	const D3D10ShaderManifest* D3D10VShader::GetManifest()
+	{
+		return manifest;
+	}
+
+	D3D10VShader::D3D10VShader(ID3D10VertexShader* shader, const D3D10ShaderManifest& manifest)
 	{
 		this->shader = shader;
+		this->manifest = new D3D10ShaderManifest(manifest);
 	}
 
 	D3D10VShader::~D3D10VShader()
 	{
 		shader->Release();
+		delete manifest;
 	}
 
 	void D3D10GShader::Apply(ID3D10Device* device)
@@ -41,17 +55,105 @@ namespace Direct3D10 {
 		device->GSSetShader(shader);
 	}
 
-	D3D10GShader::D3D10GShader(ID3D10GeometryShader* shader)
+	const D3D10ShaderManifest* D3D10GShader::GetManifest()
+	{
+		return manifest;
+	}
+
+	void D3D10GShader::Apply(ID3D10Device* device, D3D10VerticesOutBindingLayout^ layout)
+	{
+		if(!layout)
+		{
+			Apply(device);
+			return;
+		}
+
+		// Stream output is part of shader object, variant is created once per layout.
+		IntPtr cached;
+		if(!outputShaders->TryGetValue(layout, cached))
+		{
+			ID3D10GeometryShader* output = 0;
+			DXFAILED(device->CreateGeometryShaderWithStreamOutput(bytecode->GetBufferPointer(),
+				bytecode->GetBufferSize(), layout->GetEntries(), layout->GetCount(), layout->GetStride(), &output));
+
+			cached = IntPtr(output);
+			outputShaders->Add(layout, cached);
+			layout->AddShader(this);
+		}
+
+		device->GSSetShader((ID3D10GeometryShader*)cached.ToPointer());
+	}
+
+	void D3D10GShader::ReleaseOutput(D3D10VerticesOutBindingLayout^ layout)
+	{
+		IntPtr cached;
+		if(!outputShaders->TryGetValue(layout, cached)) return;
+
+		((ID3D10GeometryShader*)cached.ToPointer())->Release();
+		outputShaders->Remove(layout);
+		layout->RemoveShader(this);
+	}
+
+	D3D10GShader::D3D10GShader(ID3D10GeometryShader* shader, ID3D10Blob* bytecode, const D3D10ShaderManifest& manifest)
 	{
 		this->shader = shader;
+		this->bytecode = bytecode;
+		this->manifest = new D3D10ShaderManifest(manifest);
+		this->outputShaders = gcnew Dictionary<D3D10VerticesOutBindingLayout^, IntPtr>();
+		bytecode->AddRef();
 	}
 
 	D3D10GShader::~D3D10GShader()
 	{
+		for each(KeyValuePair<D3D10VerticesOutBindingLayout^, IntPtr> output in outputShaders)
+		{
+			((ID3D10GeometryShader*)output.Value.ToPointer())->Release();
+			output.Key->RemoveShader(this);
+		}
+		outputShaders->Clear();
+
 		shader->Release();
+		bytecode->Release();
+		delete manifest;
 	}
 
+	D3D10ShaderPipeline::D3D10ShaderPipeline(IVShader^ vs, IGShader^ gs, IPShader^ ps, IVerticesBindingLayout^ binding)
+	{
+		this->vertexShader = vs;
+		this->geometryShader = gs;
+		this->pixelShader = ps;
+		this->vertexBinding = binding;
+	}
+
+	D3D10ShaderPipeline::~D3D10ShaderPipeline()
+	{
+		delete vertexShader;
+		delete geometryShader;
+		delete pixelShader;
+		delete vertexBinding;
+	}
+
+	IVShader^ D3D10ShaderPipeline::VertexShader::get()
+	{
+		return vertexShader;
+	}
+
+	IGShader^ D3D10ShaderPipeline::GeometryShader::get()
+	{
+		return geometryShader;
+	}
+
+	IPShader^ D3D10ShaderPipeline::PixelShader::get()
+	{
+		return pixelShader;
+	}
+
+	IVerticesBindingLayout^ D3D10ShaderPipeline::VertexBinding::get()
+	{
+		return vertexBinding;
+	}
+
+}
 }
 }
 }
-}
\ No newline at end of file
@@ -1,8 +1,11 @@
 #pragma once
 #include <windows.h>
 #include <D3D10.h>
+#include "ShaderManifest.h"
+#include "VerticesBindingLayout.h"
 
 using namespace System;
+using namespace System::Collections::Generic;
 using namespace SharpMedia::Math;
 
 namespace SharpMedia {
@@ -14,29 +17,58 @@ namespace Direct3D10 {
 	public ref class D3D10PShader : public IPShader
 	{
 		ID3D10PixelShader* shader;
+		D3D10ShaderManifest* manifest;
 	public:
 		void Apply(ID3D10Device* device);
-		D3D10PShader(ID3D10PixelShader* shader);
+		const D3D10ShaderManifest* GetManifest();
+		D3D10PShader(ID3D10PixelShader* shader, const D3D10ShaderManifest& manifest);
 		virtual ~D3D10PShader();
 	};
 
 	public ref class D3D10VShader : public IVShader
 	{
 		ID3D10VertexShader* shader;
+		D3D10ShaderManifest* manifest;
 	public:
 		void Apply(ID3D10Device* device);
-		D3D10VShader(ID3D10VertexShader* shader);
+		const D3D10ShaderManifest* GetManifest();
+		D3D10VShader(ID3D10VertexShader* shader, const D3D10ShaderManifest& manifest);
 		virtual ~D3D10VShader();
 	};
 
 	public ref class D3D10GShader : public IGShader
 	{
 		ID3D10GeometryShader* shader;
+		ID3D10Blob* bytecode;
+		D3D10ShaderManifest* manifest;
+		Dictionary<D3D10VerticesOutBindingLayout^, IntPtr>^ outputShaders;	//< Stream output variants.
 	public:
 		void Apply(ID3D10Device* device);
-		D3D10GShader(ID3D10GeometryShader* shader);
+		void Apply(ID3D10Device* device, D3D10VerticesOutBindingLayout^ layout);
+
+		// Releases stream output variant of layout, if created.
+		void ReleaseOutput(D3D10VerticesOutBindingLayout^ layout);
+
+		const D3D10ShaderManifest* GetManifest();
+		D3D10GShader(ID3D10GeometryShader* shader, ID3D10Blob* bytecode, const D3D10ShaderManifest& manifest);
 		virtual ~D3D10GShader();
 	};
+
+	public ref class D3D10ShaderPipeline : public IShaderPipeline
+	{
+		IVShader^ vertexShader;
+		IGShader^ geometryShader;
+		IPShader^ pixelShader;
+		IVerticesBindingLayout^ vertexBinding;
+	public:
+		D3D10ShaderPipeline(IVShader^ vs, IGShader^ gs, IPShader^ ps, IVerticesBindingLayout^ binding);
+		virtual ~D3D10ShaderPipeline();
+
+		virtual property IVShader^ VertexShader { IVShader^ get(); }
+		virtual property IGShader^ GeometryShader { IGShader^ get(); }
+		virtual property IPShader^ PixelShader { IPShader^ get(); }
+		virtual property IVerticesBindingLayout^ VertexBinding { IVerticesBindingLayout^ get(); }
+	};
 	
 }
 }
@@ -1,5 +1,7 @@
 #include "SwapChain.h"
+#include "DeviceView.h"
 #include "Helper.h"
+#include "Trace.h"
 
 
 namespace SharpMedia {
@@ -34,10 +36,56 @@ namespace Direct3D10 {
 		this->device = device;
 	
 		CreateBackRT();
+
+		DXGI_SWAP_CHAIN_DESC desc;
+		chain->GetDesc(&desc);
+		resizer = new ResizeCoalescer(desc.BufferDesc.Width, desc.BufferDesc.Height);
+
+		// No vsync as before pacing, two frames in flight: CPU builds one frame while GPU draws previous.
+		FramePacerSettings settings;
+		settings.syncInterval = 0;
+		settings.maxFramesInFlight = 2;
+		settings.targetFrameTime = 0.0;
+
+		clock = new D3D10PacingClock();
+		fence = new D3D10FrameFence(device);
+		pacer = new FramePacer(clock, fence, settings);
+		pacer->BeginFrame();
 	}
 
 	void D3D10SwapChain::Resize(UInt32 width, UInt32 height)
 	{
+		// Called for every WM_SIZE, possibly from window thread; only last size is applied.
+		System::Threading::Monitor::Enter(this);
+		try
+		{
+			resizer->Request(width, height);
+		}
+		finally
+		{
+			System::Threading::Monitor::Exit(this);
+		}
+	}
+
+	void D3D10SwapChain::ApplyResize()
+	{
+		unsigned int width, height;
+		System::Threading::Monitor::Enter(this);
+		try
+		{
+			if(!resizer->Take(width, height)) return;
+		}
+		finally
+		{
+			System::Threading::Monitor::Exit(this);
+		}
+
+		D3D10_TRACE_SCOPE("D3D10SwapChain::ApplyResize");
+		double begin = clock->Now();
+
+		// Buffers cannot be resized while still bound, draws deferred into them are submitted first.
+		if(view) view->ReleaseTargets();
+		else device->OMSetRenderTargets(0, 0, 0);
 		backBuffer->Release();
 		backBuffer = 0;
 
@@ -47,9 +95,25 @@ namespace Direct3D10 {
 
 		if(FAILED(chain->ResizeBuffers(newMode.BufferCount, width, height, DXGI_FORMAT_UNKNOWN, DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH)))
 		{
+			CreateBackRT();
+
+			System::Threading::Monitor::Enter(this);
+			resizer->Cancel();
+			System::Threading::Monitor::Exit(this);
 			throw gcnew Exception("Resiing buffers failed.");
 		}
 		CreateBackRT();
+
+		double cost = clock->Now() - begin;
+		System::Threading::Monitor::Enter(this);
+		try
+		{
+			resizer->Applied(width, height, cost);
+		}
+		finally
+		{
+			System::Threading::Monitor::Exit(this);
+		}
 	}
 
 	void D3D10SwapChain::Reset(UInt32 width, UInt32 height, CommonPixelFormatLayout layout, bool fs)
@@ -80,11 +144,90 @@ namespace Direct3D10 {
 	
 	void D3D10SwapChain::Present()
 	{
-		chain->Present(0, 0);
+		D3D10_TRACE_SCOPE("D3D10SwapChain::Present");
+		D3D10_TRACE_COUNT("D3D10SwapChain::Present calls");
+		if(view) view->FlushQueued();
+		chain->Present(pacer->GetSettings().syncInterval, 0);
+
+		// Waiting for frames in flight and sleeping happen before next frame, not after
+		// it is built, so input read during next frame is as recent as possible.
+		pacer->EndFrame();
+		try
+		{
+			ApplyResize();
+		}
+		finally
+		{
+			// Failed resize still begins next frame, or pacer would end a frame twice.
+			pacer->BeginFrame();
+		}
 	}
 
 	void D3D10SwapChain::Finish()
 	{
+		D3D10_TRACE_SCOPE("D3D10SwapChain::Finish");
+		fence->Finish();
+	}
+
+	void D3D10SwapChain::SetFramePacing(UInt32 syncInterval, UInt32 maxFramesInFlight, float targetFrameTime)
+	{
+		if(syncInterval > 4)
+		{
+			throw gcnew ArgumentException("Sync interval must be at most 4.");
+		}
+		if(maxFramesInFlight == 0)
+		{
+			throw gcnew ArgumentException("At least one frame must be in flight.");
+		}
+
+		FramePacerSettings settings;
+		settings.syncInterval = syncInterval;
+		settings.maxFramesInFlight = maxFramesInFlight;
+		settings.targetFrameTime = targetFrameTime;
+		pacer->SetSettings(settings);
+	}
+
+	void D3D10SwapChain::GetFrameTimes(float% cpuTime, float% gpuTime, float% frameTime)
+	{
+		const FramePacerStats& stats = pacer->GetStats();
+		cpuTime = (float)stats.cpuTime;
+		gpuTime = (float)stats.gpuTime;
+		frameTime = (float)stats.averageFrameTime;
+	}
+
+	void D3D10SwapChain::GetResizeStatistics(UInt32% requests, UInt32% applied, float% lastCost)
+	{
+		System::Threading::Monitor::Enter(this);
+		try
+		{
+			const ResizeStats& stats = resizer->GetStats();
+			requests = stats.requests;
+			applied = stats.applied;
+			lastCost = (float)stats.lastCost;
+		}
+		finally
+		{
+			System::Threading::Monitor::Exit(this);
+		}
+	}
+
+	void D3D10SwapChain::GetBufferSize(UInt32% width, UInt32% height)
+	{
+		System::Threading::Monitor::Enter(this);
+		try
+		{
+			width = resizer->GetWidth();
+			height = resizer->GetHeight();
+		}
+		finally
+		{
+			System::Threading::Monitor::Exit(this);
+		}
+	}
+
+	UInt32 D3D10SwapChain::ResizeGeneration::get()
+	{
+		return resizer->GetGeneration();
 	}
 
 	void D3D10SwapChain::Clear(ID3D10Device* device, Colour colour)
@@ -95,6 +238,12 @@ namespace Direct3D10 {
 
 	D3D10SwapChain::~D3D10SwapChain()
 	{
+		delete pacer;
+		delete fence;
+		delete clock;
+		delete resizer;
+		pacer = 0;
+
 		backBuffer->Release();
 		chain->Release();
 		chain = 0;
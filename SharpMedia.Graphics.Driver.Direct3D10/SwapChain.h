@@ -1,6 +1,8 @@
 #pragma once
 #include <windows.h>
 #include <D3D10.h>
+#include "FrameFence.h"
+#include "ResizeCoalescer.h"
 
 using namespace System;
 
@@ -9,21 +11,41 @@ namespace Graphics {
 namespace Driver {
 namespace Direct3D10 {
 
+	ref class D3D10DeviceView;
+
 	// A swap chain is directly viewed.
 	public ref class D3D10SwapChain : public ISwapChain
 	{
 		IDXGISwapChain* chain;
 		ID3D10Device* device;
 
+		// Frame pacing, see FramePacer.
+		D3D10PacingClock* clock;
+		D3D10FrameFence* fence;
+		FramePacer* pacer;
+
+		// Resizes are applied at present.
+		ResizeCoalescer* resizer;
+
 		void CreateBackRT();
+		void ApplyResize();
 	internal:
 		ID3D10RenderTargetView* backBuffer;
+		D3D10DeviceView^ view;		//< Device view whose deferred draws go to back buffer, may be null.
 	public:
 		D3D10SwapChain(IDXGISwapChain* chain, ID3D10Device* device);
 		virtual void Present();
 		virtual void Finish();
 		virtual void Resize(UInt32 width, UInt32 height);
 		virtual void Reset(UInt32 width, UInt32 height, CommonPixelFormatLayout layout, bool fs);
+		virtual void SetFramePacing(UInt32 syncInterval, UInt32 maxFramesInFlight, float targetFrameTime);
+		virtual void GetFrameTimes(float% cpuTime, float% gpuTime, float% frameTime);
+		virtual void GetResizeStatistics(UInt32% requests, UInt32% applied, float% lastCost);
+		virtual void GetBufferSize(UInt32% width, UInt32% height);
+		virtual property UInt32 ResizeGeneration
+		{
+			UInt32 get();
+		}
 		virtual ~D3D10SwapChain();
 
 		void Clear(ID3D10Device* device, Colour colour);
@@ -1,5 +1,7 @@
 #include "Texture2d.h"
+#include "DeviceView.h"
 #include "Helper.h"
+#include "Trace.h"
 
 namespace SharpMedia {
 namespace Graphics {
@@ -32,6 +34,9 @@ namespace Direct3D10 {
 
 		array<Byte>^ res = gcnew array<Byte>(width * height * ToFormatSize(desc.Format));
 
+		// Deferred draws may render to texture.
+		if(view) view->FlushReferencing(texture2D);
+
 		D3D10_MAPPED_TEXTURE2D mapped;
 		texture2D->Map(D3D10CalcSubresource(mipmap, face, desc.MipLevels), D3D10_MAP_READ, 0, &mapped);
 
@@ -58,9 +63,14 @@ namespace Direct3D10 {
 
     void D3D10Texture2d::Update(array<Byte>^ data, UInt32 mipmap, UInt32 face)
 	{
+		D3D10_TRACE_SCOPE("D3D10Texture2d::Update");
+		D3D10_TRACE_COUNT("D3D10Texture2d::Update calls");
 		D3D10_TEXTURE2D_DESC desc;
 		texture2D->GetDesc( &desc );
 
+		// Deferred draws read contents from before the update.
+		if(view) view->FlushReferencing(texture2D);
+
 		D3D10_MAPPED_TEXTURE2D mapped;
 		texture2D->Map(D3D10CalcSubresource(mipmap, face, desc.MipLevels), D3D10_MAP_WRITE, 0, &mapped);
 
@@ -11,10 +11,13 @@ namespace Driver {
 namespace Direct3D10 {
 
 
+	ref class D3D10DeviceView;
+
 	public ref class D3D10Texture2d : public ITexture2D
 	{
 	public:
 		ID3D10Texture2D* texture2D;
+		D3D10DeviceView^ view;		//< Device whose deferred draws are flushed before mapping, may be null.
 	public:
         virtual array<Byte>^ Read(UInt32 mipmap, UInt32 face);
         virtual void Update(array<Byte>^ data, UInt32 mipmap, UInt32 face);
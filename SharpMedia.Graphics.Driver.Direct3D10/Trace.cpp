@@ -0,0 +1,232 @@
+#include "Trace.h"
+#include <cstdio>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	static const unsigned int TraceCapacity = 32768;
+
+#ifdef _WIN32
+#define TRACE_THREAD_LOCAL __declspec(thread)
+
+	static unsigned int ThreadId() { return (unsigned int)GetCurrentThreadId(); }
+	static long Increment(volatile long* value) { return InterlockedIncrement(value); }
+	static long Exchange(volatile long* value, long exchange) { return InterlockedExchange(value, exchange); }
+
+	template<typename T>
+	static T* CompareExchange(T* volatile* target, T* exchange, T* comparand)
+	{
+		return (T*)InterlockedCompareExchangePointer((PVOID volatile*)target, exchange, comparand);
+	}
+#else
+#define TRACE_THREAD_LOCAL __thread
+
+	static unsigned int ThreadId() { return (unsigned int)syscall(SYS_gettid); }
+	static long Increment(volatile long* value) { return __sync_add_and_fetch(value, 1); }
+	static long Exchange(volatile long* value, long exchange) { return __sync_lock_test_and_set(value, exchange); }
+
+	template<typename T>
+	static T* CompareExchange(T* volatile* target, T* exchange, T* comparand)
+	{
+		return __sync_val_compare_and_swap(target, comparand, exchange);
+	}
+#endif
+
+	struct TraceEvent
+	{
+		const char* name;
+		unsigned long long start;
+		unsigned long long end;
+	};
+
+	// Written only by its thread; count is published after event is written.
+	struct TraceBuffer
+	{
+		unsigned int thread;
+		volatile long count;
+		volatile long dropped;
+		TraceBuffer* next;
+		TraceEvent events[TraceCapacity];
+	};
+
+	static TRACE_THREAD_LOCAL TraceBuffer* threadBuffer = 0;
+	static TraceBuffer* volatile buffers = 0;
+	static TraceCounter* volatile counters = 0;
+
+	static TraceBuffer* RegisterThread()
+	{
+		TraceBuffer* buffer = new TraceBuffer();
+		buffer->thread = ThreadId();
+		buffer->count = 0;
+		buffer->dropped = 0;
+
+		// Buffers are never freed, threads may be traced again after export.
+		TraceBuffer* head;
+		do
+		{
+			head = buffers;
+			buffer->next = head;
+		} while(CompareExchange(&buffers, buffer, head) != head);
+
+		threadBuffer = buffer;
+		return buffer;
+	}
+
+	unsigned long long TraceNow()
+	{
+#ifdef _WIN32
+		LARGE_INTEGER now;
+		QueryPerformanceCounter(&now);
+		return (unsigned long long)now.QuadPart;
+#else
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+#endif
+	}
+
+	// Ticks of TraceNow per second.
+	static double TraceFrequency()
+	{
+#ifdef _WIN32
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return (double)frequency.QuadPart;
+#else
+		return 1000000000.0;
+#endif
+	}
+
+	void TraceRecord(const char* name, unsigned long long start, unsigned long long end)
+	{
+		TraceBuffer* buffer = threadBuffer;
+		if(!buffer) buffer = RegisterThread();
+
+		long count = buffer->count;
+		if((unsigned long)count >= TraceCapacity)
+		{
+			buffer->dropped++;
+			return;
+		}
+
+		TraceEvent& e = buffer->events[count];
+		e.name = name;
+		e.start = start;
+		e.end = end;
+
+		// Volatile store has release semantics, readers never see a partial event.
+		buffer->count = count + 1;
+	}
+
+	void TraceCount(TraceCounter* counter)
+	{
+		Increment(&counter->count);
+
+		if(!counter->registered && Exchange(&counter->registered, 1) == 0)
+		{
+			TraceCounter* head;
+			do
+			{
+				head = counters;
+				counter->next = head;
+			} while(CompareExchange(&counters, counter, head) != head);
+		}
+	}
+
+	void TraceClear()
+	{
+		for(TraceBuffer* buffer = buffers; buffer; buffer = buffer->next)
+		{
+			buffer->count = 0;
+			buffer->dropped = 0;
+		}
+		for(TraceCounter* counter = counters; counter; counter = counter->next)
+		{
+			counter->count = 0;
+		}
+	}
+
+	static void WriteName(std::ostream& stream, const char* name)
+	{
+		for(; *name; name++)
+		{
+			if(*name == '"' || *name == '\\') stream << '\\';
+			stream << *name;
+		}
+	}
+
+	void TraceWriteChrome(std::ostream& stream)
+	{
+		double scale = 1000000.0 / TraceFrequency();
+
+		// Times are relative to earliest span.
+		unsigned long long origin = ~0ull, last = 0;
+		for(TraceBuffer* buffer = buffers; buffer; buffer = buffer->next)
+		{
+			long count = buffer->count;
+			for(long i = 0; i < count; i++)
+			{
+				if(buffer->events[i].start < origin) origin = buffer->events[i].start;
+				if(buffer->events[i].end > last) last = buffer->events[i].end;
+			}
+		}
+		if(origin > last) origin = last;
+
+		char text[128];
+		bool first = true;
+		stream << "{\"traceEvents\":[";
+
+		for(TraceBuffer* buffer = buffers; buffer; buffer = buffer->next)
+		{
+			long count = buffer->count;
+
+			sprintf(text, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}",
+				(unsigned int)buffer->thread, (unsigned int)buffer->thread);
+			stream << (first ? "\n" : ",\n") << text;
+			first = false;
+
+			for(long i = 0; i < count; i++)
+			{
+				const TraceEvent& e = buffer->events[i];
+				stream << ",\n{\"name\":\"";
+				WriteName(stream, e.name);
+				sprintf(text, "\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					(unsigned int)buffer->thread, (double)(e.start - origin) * scale,
+					(double)(e.end - e.start) * scale);
+				stream << text;
+			}
+
+			if(buffer->dropped)
+			{
+				sprintf(text, ",\n{\"name\":\"Dropped\",\"ph\":\"C\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"args\":{\"events\":%d}}",
+					(unsigned int)buffer->thread, (double)(last - origin) * scale, (int)buffer->dropped);
+				stream << text;
+			}
+		}
+
+		for(TraceCounter* counter = counters; counter; counter = counter->next)
+		{
+			stream << (first ? "\n" : ",\n") << "{\"name\":\"";
+			WriteName(stream, counter->name);
+			sprintf(text, "\",\"ph\":\"C\",\"pid\":0,\"ts\":%.3f,\"args\":{\"calls\":%d}}",
+				(double)(last - origin) * scale, (int)counter->count);
+			stream << text;
+			first = false;
+		}
+
+		stream << "\n]}\n";
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <ostream>
+
+// Scoped CPU instrumentation of the driver. Define SHARPMEDIA_D3D10_TRACE to enable it (Trace
+// configuration of the project does), otherwise the macros expand to nothing. Devices export
+// traces with ExportDriverTrace.
+#ifdef SHARPMEDIA_D3D10_TRACE
+#define D3D10_TRACE_JOIN2(a, b) a##b
+#define D3D10_TRACE_JOIN(a, b) D3D10_TRACE_JOIN2(a, b)
+#define D3D10_TRACE_SCOPE(name) \
+	::SharpMedia::Graphics::Driver::Direct3D10::TraceScope D3D10_TRACE_JOIN(traceScope, __LINE__)(name)
+#define D3D10_TRACE_COUNT(name) \
+	{ static ::SharpMedia::Graphics::Driver::Direct3D10::TraceCounter traceCounter = { name, 0, 0, 0 }; \
+	  ::SharpMedia::Graphics::Driver::Direct3D10::TraceCount(&traceCounter); }
+#else
+#define D3D10_TRACE_SCOPE(name)
+#define D3D10_TRACE_COUNT(name)
+#endif
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Calls counter, registered on first use. Must be static.
+	struct TraceCounter
+	{
+		const char* name;
+		volatile long count;
+		volatile long registered;
+		TraceCounter* next;
+	};
+
+	// Ticks of a steady clock.
+	unsigned long long TraceNow();
+
+	// Records span of calling thread; name must be a literal (only pointer is stored).
+	void TraceRecord(const char* name, unsigned long long start, unsigned long long end);
+
+	void TraceCount(TraceCounter* counter);
+
+	// Discards recorded spans and zeroes counters. Traced threads should not be running.
+	void TraceClear();
+
+	// Writes spans and counters in Chrome trace event format (also read by Perfetto).
+	void TraceWriteChrome(std::ostream& stream);
+
+	class TraceScope
+	{
+		const char* name;
+		unsigned long long start;
+	public:
+		TraceScope(const char* name) : name(name), start(TraceNow()) {}
+		~TraceScope() { TraceRecord(name, start, TraceNow()); }
+	};
+
+}
+}
+}
+}
@@ -1,4 +1,5 @@
 #include "VerticesBindingLayout.h"
+#include "Shaders.h"
 
 
 namespace SharpMedia {
@@ -22,6 +23,38 @@ namespace Direct3D10 {
 		inputLayout->Release();
 	}
 
+	D3D10VerticesOutBindingLayout::D3D10VerticesOutBindingLayout(D3D10_SO_DECLARATION_ENTRY* entries, 
+		unsigned int count, unsigned int stride)
+	{
+		this->entries = entries;
+		this->count = count;
+		this->stride = stride;
+		this->shaders = gcnew List<D3D10GShader^>();
+	}
+
+	void D3D10VerticesOutBindingLayout::AddShader(D3D10GShader^ shader)
+	{
+		if(!shaders->Contains(shader)) shaders->Add(shader);
+	}
+
+	void D3D10VerticesOutBindingLayout::RemoveShader(D3D10GShader^ shader)
+	{
+		shaders->Remove(shader);
+	}
+
+	D3D10VerticesOutBindingLayout::~D3D10VerticesOutBindingLayout()
+	{
+		// Shaders unregister while releasing, so iterate a copy.
+		for each(D3D10GShader^ shader in shaders->ToArray())
+		{
+			shader->ReleaseOutput(this);
+		}
+		shaders->Clear();
+
+		delete [] entries;
+		entries = 0;
+	}
+
 }
 }
 }
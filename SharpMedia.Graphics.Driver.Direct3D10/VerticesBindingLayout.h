@@ -20,6 +20,29 @@ namespace Direct3D10 {
 		virtual ~D3D10VerticesBindingLayout();
 	};
 
+	ref class D3D10GShader;
+
+	// Stream output declaration; geometry shaders are created with it when bound.
+	public ref class D3D10VerticesOutBindingLayout : public IVerticesOutBindingLayout
+	{
+		D3D10_SO_DECLARATION_ENTRY* entries;
+		unsigned int count;
+		unsigned int stride;
+		System::Collections::Generic::List<D3D10GShader^>^ shaders;	//< Shaders with a variant of this layout.
+	public:
+		const D3D10_SO_DECLARATION_ENTRY* GetEntries() { return entries; }
+		unsigned int GetCount() { return count; }
+		unsigned int GetStride() { return stride; }
+
+		// Shader variants are released when layout is disposed.
+		void AddShader(D3D10GShader^ shader);
+		void RemoveShader(D3D10GShader^ shader);
+
+		// Takes ownership of entries.
+		D3D10VerticesOutBindingLayout(D3D10_SO_DECLARATION_ENTRY* entries, unsigned int count, unsigned int stride);
+		virtual ~D3D10VerticesOutBindingLayout();
+	};
+
 
 }
 }
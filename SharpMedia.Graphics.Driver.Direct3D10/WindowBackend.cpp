@@ -1,71 +1,238 @@
 #include "WindowBackend.h"
+#include "WindowDpi.h"
 
+#ifndef WM_DPICHANGED
+#define WM_DPICHANGED 0x02E0
+#endif
 
 namespace SharpMedia {
 namespace Graphics {
 namespace Driver {
 namespace Direct3D10 {
 
-	
+	// Posted to window to destroy it on its thread.
+	static const UINT WindowStopMessage = WM_APP + 1;
+
+	// Microseconds per frame spent delivering events; rest waits for next frame.
+	static const LONGLONG WindowEventBudget = 1000;
+
+	typedef HANDLE (WINAPI* SetThreadDpiAwarenessContextProc)(HANDLE context);
+	typedef BOOL (WINAPI* IsValidDpiAwarenessContextProc)(HANDLE context);
+	typedef HRESULT (WINAPI* SetProcessDpiAwarenessProc)(int awareness);
+	typedef UINT (WINAPI* GetDpiForWindowProc)(HWND hWnd);
+
+	// DPI_AWARENESS_CONTEXT and PROCESS_DPI_AWARENESS values, older headers lack them.
+	static const HANDLE WindowContextPerMonitor = (HANDLE)-3;
+	static const HANDLE WindowContextPerMonitorV2 = (HANDLE)-4;
+	static const int WindowProcessPerMonitor = 2;
+
+	// Asks for per-monitor DPI awareness before window is created, so it gets WM_DPICHANGED.
+	// Functions are looked up, systems before Windows 8.1 have none and stay unaware.
+	static void SetWindowDpiAwareness()
+	{
+		HMODULE user32 = GetModuleHandle(L"user32.dll");
+		SetThreadDpiAwarenessContextProc setThreadContext =
+			(SetThreadDpiAwarenessContextProc)GetProcAddress(user32, "SetThreadDpiAwarenessContext");
+		IsValidDpiAwarenessContextProc isValidContext =
+			(IsValidDpiAwarenessContextProc)GetProcAddress(user32, "IsValidDpiAwarenessContext");
 
-	// Static instance.
-	IntPtr current = IntPtr::Zero;
+		HMODULE shcore = LoadLibrary(L"shcore.dll");
+		SetProcessDpiAwarenessProc setProcess =
+			shcore ? (SetProcessDpiAwarenessProc)GetProcAddress(shcore, "SetProcessDpiAwareness") : 0;
+
+		WindowDpiSupport support;
+		support.threadContext = setThreadContext != 0;
+		support.perMonitorV2 = isValidContext && isValidContext(WindowContextPerMonitorV2);
+		support.processAwareness = setProcess != 0;
+
+		switch(ChooseDpiAwareness(support))
+		{
+		case WindowDpiPerMonitorThreadV2:
+			setThreadContext(WindowContextPerMonitorV2);
+			break;
+		case WindowDpiPerMonitorThread:
+			setThreadContext(WindowContextPerMonitor);
+			break;
+		case WindowDpiPerMonitor:
+			// Fails when application already set awareness of process; it is kept then.
+			setProcess(WindowProcessPerMonitor);
+			break;
+		default:
+			break;
+		}
+
+		if(shcore) FreeLibrary(shcore);
+	}
+
+	static unsigned int GetWindowDpi(HWND hWnd)
+	{
+		GetDpiForWindowProc getDpi = (GetDpiForWindowProc)GetProcAddress(GetModuleHandle(L"user32.dll"), "GetDpiForWindow");
+		if(getDpi) return getDpi(hWnd);
+
+		HDC dc = GetDC(hWnd);
+		unsigned int dpi = dc ? (unsigned int)GetDeviceCaps(dc, LOGPIXELSX) : WindowDefaultDpi;
+		if(dc) ReleaseDC(hWnd, dc);
+		return dpi;
+	}
+
+	static void PostWindowEvent(WindowThread* w, unsigned int type, int a = 0, int b = 0)
+	{
+		EnterCriticalSection(&w->lock);
+		w->queue.Push(type, a, b);
+		LeaveCriticalSection(&w->lock);
+	}
 
 	// A Window procedure.
 	LRESULT WINAPI WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
 	{
-		
+		// Window thread comes with creation and stays with window.
+		if(msg == WM_NCCREATE)
+		{
+			CREATESTRUCT* cs = (CREATESTRUCT*)lParam;
+			SetWindowLongPtr(hwnd, GWLP_USERDATA, (LONG_PTR)cs->lpCreateParams);
+		}
+		WindowThread* w = (WindowThread*)GetWindowLongPtr(hwnd, GWLP_USERDATA);
+		if(!w) return DefWindowProc(hwnd, msg, wParam, lParam);
 
 		switch(msg)
 		{
 		case WM_CLOSE:
-			{
-				GCHandle handle = GCHandle::FromIntPtr(current);
-				D3D10WindowBackend^ c = (D3D10WindowBackend^)handle.Target;
-				c->GetListener()->Closed();	
-			} 
-			break;
+			// Window stays until backend is destroyed, swap chain still presents to it.
+			PostWindowEvent(w, WindowEventClose);
+			return 0;
 		case WM_SIZE:
+			if(wParam == SIZE_MINIMIZED)
 			{
-				if(current != IntPtr::Zero)
+				w->minimized = true;
+				PostWindowEvent(w, WindowEventMinimize, 1);
+			} else {
+				if(w->minimized)
 				{
-					GCHandle handle = GCHandle::FromIntPtr(current);
-					D3D10WindowBackend^ c = (D3D10WindowBackend^)handle.Target;
-					c->GetListener()->Resized(LOWORD(lParam), HIWORD(lParam));
+					w->minimized = false;
+					PostWindowEvent(w, WindowEventMinimize, 0);
 				}
+				PostWindowEvent(w, WindowEventResize, LOWORD(lParam), HIWORD(lParam));
 			}
 			break;
-		case WM_CREATE:
+		case WM_MOVE:
+			PostWindowEvent(w, WindowEventMove, (short)LOWORD(lParam), (short)HIWORD(lParam));
 			break;
-		case WM_DESTROY:
+		case WM_SETFOCUS:
+			PostWindowEvent(w, WindowEventFocus, 1);
+			break;
+		case WM_KILLFOCUS:
+			PostWindowEvent(w, WindowEventFocus, 0);
+			break;
+		case WM_DPICHANGED:
 			{
-				GCHandle handle = GCHandle::FromIntPtr(current);
-				handle.Free();
-				current = IntPtr::Zero; // No more current.
-
+				// Suggested rectangle keeps window same physical size; resize follows.
+				RECT* rc = (RECT*)lParam;
+				PostWindowEvent(w, WindowEventDpi, (int)DpiFromMessage(wParam));
+				SetWindowPos(hwnd, NULL, rc->left, rc->top, rc->right - rc->left, rc->bottom - rc->top,
+					SWP_NOZORDER | SWP_NOACTIVATE);
 			}
+			return 0;
+		case WindowStopMessage:
+			DestroyWindow(hwnd);
+			return 0;
+		case WM_DESTROY:
+			PostQuitMessage(0);
 			break;
 		}
 		return DefWindowProc(hwnd, msg, wParam, lParam);
 	}
 
-	D3D10WindowBackend::D3D10WindowBackend(HWND h)
+	static DWORD WINAPI WindowThreadProc(LPVOID param)
 	{
-		hWnd = h;
+		WindowThread* w = (WindowThread*)param;
+		SetWindowDpiAwareness();
+
+		RECT rc = { 0, 0, w->width, w->height };
+		AdjustWindowRect(&rc, WS_OVERLAPPEDWINDOW, FALSE);
+		w->hWnd = CreateWindow(L"D3D10WindowClass", L"D3D10 Window", WS_OVERLAPPEDWINDOW,
+							   CW_USEDEFAULT, CW_USEDEFAULT, rc.right - rc.left, rc.bottom - rc.top, NULL, NULL,
+							   GetModuleHandle(NULL), w);
+		if(w->hWnd)
+		{
+			// Frame was sized for system DPI; client keeps size asked for on any monitor.
+			RECT client, frame;
+			GetClientRect(w->hWnd, &client);
+			int dx = w->width - client.right, dy = w->height - client.bottom;
+			if((dx || dy) && GetWindowRect(w->hWnd, &frame))
+			{
+				SetWindowPos(w->hWnd, NULL, 0, 0, frame.right - frame.left + dx, frame.bottom - frame.top + dy,
+					SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+			}
+
+			// Listener starts at default DPI.
+			unsigned int dpi = GetWindowDpi(w->hWnd);
+			if(dpi != WindowDefaultDpi) PostWindowEvent(w, WindowEventDpi, (int)dpi);
+
+			ShowWindow(w->hWnd, SW_SHOW);
+
+			// Cursor visibility is per thread, so it is hidden here.
+			ShowCursor(FALSE);
+		}
+		SetEvent(w->ready);
+		if(!w->hWnd) return 1;
+
+		MSG msg;
+		while(GetMessage(&msg, NULL, 0, 0) > 0)
+		{
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+		}
+		return 0;
 	}
-	
-	void D3D10WindowBackend::SetListener(IWindow^ wnd)
+
+	WindowThread* StartWindowThread(int width, int height)
 	{
-		listener = wnd;
+		WindowThread* w = new WindowThread();
+		w->hWnd = 0;
+		w->width = width;
+		w->height = height;
+		w->minimized = false;
+		InitializeCriticalSection(&w->lock);
+
+		w->ready = CreateEvent(NULL, TRUE, FALSE, NULL);
+		w->thread = w->ready ? CreateThread(NULL, 0, WindowThreadProc, w, 0, NULL) : NULL;
+		if(w->thread) WaitForSingleObject(w->ready, INFINITE);
 
-		// We can set it now.
-		if(listener == nullptr)
+		if(!w->hWnd)
 		{
-			current = IntPtr::Zero;
-		} else {
-			GCHandle handle = GCHandle::Alloc(this);
-			current = GCHandle::ToIntPtr(handle);
+			if(w->thread)
+			{
+				WaitForSingleObject(w->thread, INFINITE);
+				CloseHandle(w->thread);
+			}
+			if(w->ready) CloseHandle(w->ready);
+			DeleteCriticalSection(&w->lock);
+			delete w;
+			return 0;
 		}
+		return w;
+	}
+
+	void StopWindowThread(WindowThread* w)
+	{
+		PostMessage(w->hWnd, WindowStopMessage, 0, 0);
+		WaitForSingleObject(w->thread, INFINITE);
+
+		CloseHandle(w->thread);
+		CloseHandle(w->ready);
+		DeleteCriticalSection(&w->lock);
+		delete w;
+	}
+
+	D3D10WindowBackend::D3D10WindowBackend(WindowThread* thread)
+	{
+		this->thread = thread;
+		hWnd = thread->hWnd;
+	}
+	
+	void D3D10WindowBackend::SetListener(IWindow^ wnd)
+	{
+		listener = wnd;
 	}
 
 	IntPtr D3D10WindowBackend::Handle::get()
@@ -78,17 +245,68 @@ namespace Direct3D10 {
 		return listener;
 	}
 
+	void D3D10WindowBackend::Dispatch(const WindowEvent& ev)
+	{
+		switch(ev.type)
+		{
+		case WindowEventResize:
+			listener->Resized((unsigned int)ev.a, (unsigned int)ev.b);
+			break;
+		case WindowEventMove:
+			listener->Moved(ev.a, ev.b);
+			break;
+		case WindowEventClose:
+			listener->Closed();
+			break;
+		case WindowEventFocus:
+			listener->Focused(ev.a != 0);
+			break;
+		case WindowEventMinimize:
+			listener->Minimized(ev.a != 0);
+			break;
+		case WindowEventDpi:
+			listener->DpiChanged((unsigned int)ev.a);
+			break;
+		}
+	}
+
 	void D3D10WindowBackend::DoEvents()
 	{
-		MSG msg;
-		while(PeekMessage(&msg, hWnd, 0, 0, PM_REMOVE))
+		if(!thread) return;
+
+		LARGE_INTEGER frequency, start, now;
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&start);
+		LONGLONG budget = frequency.QuadPart * WindowEventBudget / 1000000;
+
+		// Listener runs without lock, so message thread is never blocked by it; at least one
+		// event is delivered per frame.
+		WindowEvent ev;
+		for(;;)
 		{
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+			EnterCriticalSection(&thread->lock);
+			bool any = thread->queue.Pop(ev);
+			LeaveCriticalSection(&thread->lock);
+			if(!any) break;
+
+			if(listener != nullptr) Dispatch(ev);
+
+			QueryPerformanceCounter(&now);
+			if(now.QuadPart - start.QuadPart >= budget) break;
 		}
 	}
 
+	D3D10WindowBackend::~D3D10WindowBackend()
+	{
+		if(thread)
+		{
+			StopWindowThread(thread);
+			thread = 0;
+			hWnd = 0;
+		}
+	}
+
+}
 }
 }
 }
-}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <windows.h>
 #include <D3D10.h>
+#include "WindowEventQueue.h"
 
 using namespace System;
 using namespace System::Runtime::InteropServices;
@@ -10,21 +11,46 @@ namespace Graphics {
 namespace Driver {
 namespace Direct3D10 {
 
+	// Window with its own message thread. Window procedure only posts events to queue, so
+	// message storms (resize drag, IME) never wait for a frame and frames never pump messages.
+	struct WindowThread
+	{
+		HANDLE thread;
+		HANDLE ready;
+		HWND hWnd;
+		int width, height;				//< Client size at creation.
+		bool minimized;					//< Used by message thread only.
+		CRITICAL_SECTION lock;			//< Guards queue.
+		WindowEventQueue queue;
+	};
+
+	// Creates window of class D3D10WindowClass on a new thread; returns 0 when it fails.
+	WindowThread* StartWindowThread(int width, int height);
+
+	// Destroys window and waits for its thread.
+	void StopWindowThread(WindowThread* window);
+
 	// A Window backend is directly viewed.
 	public ref class D3D10WindowBackend : public IWindowBackend
 	{
 	protected:
 		HWND hWnd;
+		WindowThread* thread;
 		IWindow^ listener;
+
+		void Dispatch(const WindowEvent& ev);
 	public:
-		D3D10WindowBackend(HWND hWnd);
+		D3D10WindowBackend(WindowThread* thread);
 		virtual void SetListener(IWindow^ wnd);
 		virtual IWindow^ GetListener();
 		virtual property IntPtr Handle { IntPtr get(); };
+
+		// Delivers queued events to listener, within budget of a frame.
 		virtual void DoEvents();
+		virtual ~D3D10WindowBackend();
 	};
 
 }
 }
 }
-}
\ No newline at end of file
+}
@@ -0,0 +1,26 @@
+#include "WindowDpi.h"
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	WindowDpiAwareness ChooseDpiAwareness(const WindowDpiSupport& support)
+	{
+		if(support.threadContext)
+		{
+			return support.perMonitorV2 ? WindowDpiPerMonitorThreadV2 : WindowDpiPerMonitorThread;
+		}
+		return support.processAwareness ? WindowDpiPerMonitor : WindowDpiUnaware;
+	}
+
+	unsigned int DpiFromMessage(unsigned long long wParam)
+	{
+		unsigned int dpi = (unsigned int)(wParam & 0xFFFF);
+		return dpi ? dpi : WindowDefaultDpi;
+	}
+
+}
+}
+}
+}
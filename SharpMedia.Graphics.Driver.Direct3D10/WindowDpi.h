@@ -0,0 +1,39 @@
+#pragma once
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	// Dots per inch at 100% scale.
+	static const unsigned int WindowDefaultDpi = 96;
+
+	// DPI awareness window thread asks for. Only per-monitor awareness gets WM_DPICHANGED;
+	// without it system stretches window as bitmap on monitors of other scale.
+	enum WindowDpiAwareness
+	{
+		WindowDpiUnaware = 0,
+		WindowDpiPerMonitor = 1,			//< Whole process (Windows 8.1).
+		WindowDpiPerMonitorThread = 2,		//< Window thread only (Windows 10 1607).
+		WindowDpiPerMonitorThreadV2 = 3		//< Also scales non-client area (Windows 10 1703).
+	};
+
+	// What system offers, found by looking up its functions.
+	struct WindowDpiSupport
+	{
+		bool processAwareness;			//< SetProcessDpiAwareness.
+		bool threadContext;				//< SetThreadDpiAwarenessContext.
+		bool perMonitorV2;				//< Context of per-monitor V2 is valid.
+	};
+
+	// Best awareness system offers. Context of thread is preferred to awareness of process,
+	// so other windows of application keep awareness they have.
+	WindowDpiAwareness ChooseDpiAwareness(const WindowDpiSupport& support);
+
+	// DPI of WM_DPICHANGED, X in low word of wParam; default when message carries none.
+	unsigned int DpiFromMessage(unsigned long long wParam);
+
+}
+}
+}
+}
@@ -0,0 +1,55 @@
+#include "WindowEventQueue.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	WindowEventQueue::WindowEventQueue()
+	{
+		for(unsigned int i = 0; i < WindowEventTypes; i++) slots[i] = -1;
+		head = count = 0;
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	void WindowEventQueue::Push(unsigned int type, int a, int b)
+	{
+		if(type >= WindowEventTypes) return;
+		stats.pushed++;
+
+		// Events are state, so pending one only gets new values.
+		if(slots[type] >= 0)
+		{
+			WindowEvent& pending = events[slots[type]];
+			pending.a = a;
+			pending.b = b;
+			stats.coalesced++;
+			return;
+		}
+
+		// One slot per type, queue cannot overflow.
+		unsigned int index = (head + count) % WindowEventTypes;
+		events[index].type = type;
+		events[index].a = a;
+		events[index].b = b;
+		slots[type] = (int)index;
+		count++;
+	}
+
+	bool WindowEventQueue::Pop(WindowEvent& ev)
+	{
+		if(count == 0) return false;
+
+		ev = events[head];
+		slots[ev.type] = -1;
+		head = (head + 1) % WindowEventTypes;
+		count--;
+		stats.delivered++;
+		return true;
+	}
+
+}
+}
+}
+}
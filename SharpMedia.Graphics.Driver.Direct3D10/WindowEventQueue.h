@@ -0,0 +1,59 @@
+#pragma once
+
+namespace SharpMedia {
+namespace Graphics {
+namespace Driver {
+namespace Direct3D10 {
+
+	enum WindowEventType
+	{
+		WindowEventResize = 0,		//< a, b are client width and height.
+		WindowEventMove = 1,		//< a, b are client position.
+		WindowEventClose = 2,
+		WindowEventFocus = 3,		//< a is 1 when focused.
+		WindowEventMinimize = 4,	//< a is 1 when minimized.
+		WindowEventDpi = 5,			//< a is dots per inch.
+		WindowEventTypes = 6
+	};
+
+	struct WindowEvent
+	{
+		unsigned int type;
+		int a, b;
+	};
+
+	struct WindowEventStats
+	{
+		unsigned int pushed;
+		unsigned int coalesced;		//< Pushes that replaced pending event of same type.
+		unsigned int delivered;
+	};
+
+	// Events of window, posted by message thread and taken by render thread. Every event only
+	// reports latest state (size, focus...), so pending event of same type is replaced by new
+	// one and queue never holds more than one event per type; a resize drag posts hundreds of
+	// sizes but frame sees the last. Events keep order of their first push. Not thread safe,
+	// owner must lock.
+	class WindowEventQueue
+	{
+		WindowEvent events[WindowEventTypes];
+		int slots[WindowEventTypes];		//< Index of pending event of type, -1 when none.
+		unsigned int head, count;
+		WindowEventStats stats;
+	public:
+		WindowEventQueue();
+
+		void Push(unsigned int type, int a = 0, int b = 0);
+
+		// Takes oldest event; false when queue is empty.
+		bool Pop(WindowEvent& ev);
+
+		unsigned int GetCount() const { return count; }
+		bool IsPending(unsigned int type) const { return type < WindowEventTypes && slots[type] >= 0; }
+		const WindowEventStats& GetStats() const { return stats; }
+	};
+
+}
+}
+}
+}
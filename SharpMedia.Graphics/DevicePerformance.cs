@@ -52,6 +52,12 @@ namespace SharpMedia.Graphics
         TimeSpan maxFrameLenght = new TimeSpan(0);
         TimeSpan minFrameLenght = TimeSpan.MaxValue;
 
+        // GPU data, frames arrive a few frames late.
+        Driver.GPUFrameTiming lastGPUFrame = null;
+        ulong gpuFrameCount = 0;
+        double gpuTime = 0.0;
+        double maxGPUFrameTime = 0.0;
+
         #endregion
 
         #region Properties
@@ -332,10 +338,68 @@ namespace SharpMedia.Graphics
         }
 
 
+        /// <summary>
+        /// Gets or sets whether GPU time of frames and work units is measured.
+        /// </summary>
+        public bool GPUProfiling
+        {
+            get
+            {
+                return device.DriverDevice.Profiling;
+            }
+            set
+            {
+                device.DriverDevice.Profiling = value;
+            }
+        }
+
+        /// <summary>
+        /// Gets the latest GPU frame timing with its work units, null if none was measured yet.
+        /// </summary>
+        public Driver.GPUFrameTiming LastGPUFrame
+        {
+            get
+            {
+                return lastGPUFrame;
+            }
+        }
+
+        /// <summary>
+        /// Gets the average GPU frame time, in milliseconds.
+        /// </summary>
+        public double AverageGPUFrameTime
+        {
+            get
+            {
+                return gpuFrameCount > 0 ? gpuTime / gpuFrameCount : 0.0;
+            }
+        }
+
+        /// <summary>
+        /// Gets the maximum GPU frame time, in milliseconds.
+        /// </summary>
+        public double MaximumGPUFrameTime
+        {
+            get
+            {
+                return maxGPUFrameTime;
+            }
+        }
+
         #endregion
 
         #region Public Methods
 
+        /// <summary>
+        /// Exports CPU trace of driver calls in Chrome trace format (chrome://tracing), null if
+        /// driver was not built with tracing.
+        /// </summary>
+        /// <param name="clear">Whether exported spans and counts are discarded.</param>
+        public string ExportDriverTrace(bool clear)
+        {
+            return device.DriverDevice.ExportDriverTrace(clear);
+        }
+
         /// <summary>
         /// Resets this instance.
         /// </summary>
@@ -359,6 +423,11 @@ namespace SharpMedia.Graphics
 
             maxFrameLenght = new TimeSpan(0);
             minFrameLenght = TimeSpan.MaxValue;
+
+            lastGPUFrame = null;
+            gpuFrameCount = 0;
+            gpuTime = 0.0;
+            maxGPUFrameTime = 0.0;
         }
 
         #endregion
@@ -424,6 +493,18 @@ namespace SharpMedia.Graphics
             lastPointsRendered = 0;
             lastLinesRendered = 0;
             lastTrianglesRendered = 0;
+
+            // GPU frames resolved since last frame.
+            if (device.DriverDevice.Profiling)
+            {
+                foreach (Driver.GPUFrameTiming frame in device.DriverDevice.ReadProfileFrames())
+                {
+                    lastGPUFrame = frame;
+                    gpuFrameCount++;
+                    gpuTime += frame.Duration;
+                    if (frame.Duration > maxGPUFrameTime) maxGPUFrameTime = frame.Duration;
+                }
+            }
         }
 
         /// <summary>
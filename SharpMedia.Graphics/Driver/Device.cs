@@ -67,6 +67,34 @@ namespace SharpMedia.Graphics.Driver
         public TextureUsage TextureUsage;
     }
 
+    /// <summary>
+    /// GPU time of a named scope of a frame.
+    /// </summary>
+    [Linkable(LinkMask.Drivers)]
+    public sealed class GPUScopeTiming
+    {
+        public string Name;
+        public uint Depth;
+        public int Parent;                      // Index of parent scope in frame, -1 for top level.
+        public double Begin;                    // Milliseconds from frame start.
+        public double End;
+        public bool HasStatistics;
+        public ulong Primitives;
+        public ulong VertexShaderInvocations;
+        public ulong PixelShaderInvocations;
+    }
+
+    /// <summary>
+    /// GPU time of a frame, a device lock section.
+    /// </summary>
+    [Linkable(LinkMask.Drivers)]
+    public sealed class GPUFrameTiming
+    {
+        public ulong Frame;
+        public double Duration;                 // Milliseconds.
+        public GPUScopeTiming[] Scopes;
+    }
+
     /// <summary>
     /// A vertex binding element.
     /// </summary>
@@ -167,6 +195,14 @@ namespace SharpMedia.Graphics.Driver
         /// <returns>Resulting biding.</returns>    ASFG
         IVerticesBindingLayout CreateVertexBinding(VertexBindingElement[] elements);
 
+        /// <summary>
+        /// Creates stream output binding, vertices are written to buffer of element at
+        /// the same index.
+        /// </summary>
+        /// <param name="elements">The output elements.</param>
+        /// <returns>Resulting binding.</returns>
+        IVerticesOutBindingLayout CreateVertexOutBinding(VertexBindingElement[] elements);
+
 
         /// <summary>
         /// Creates the buffer.
@@ -207,6 +243,15 @@ namespace SharpMedia.Graphics.Driver
                                          uint mipmapLevels, TextureUsage textureUsage,
                                          uint sampleCount, uint sampleQuality, byte[][] data);
 
+        /// <summary>
+        /// Creates array of 2D textures, without initial data. Slices can be rendered in one
+        /// pass by routing primitives with RenderTargetArrayIndex.
+        /// </summary>
+        /// <param name="arraySize">Number of slices, must be 6 for cube maps.</param>
+        ITexture2D CreateTexture2DArray(Usage usage, CommonPixelFormatLayout fmt, CPUAccess access, uint width, uint height,
+                                         uint arraySize, uint mipmapLevels, TextureUsage textureUsage,
+                                         uint sampleCount, uint sampleQuality);
+
 
         /// <summary>
         /// Creates the texture 3D.
@@ -381,6 +426,86 @@ namespace SharpMedia.Graphics.Driver
 
         #endregion
 
+        #region Profiling
+
+        /// <summary>
+        /// Enables GPU profiling. Frames are device lock sections, from Enter to Exit; results
+        /// are read back a few frames later without waiting for the GPU.
+        /// </summary>
+        bool Profiling { get; set; }
+
+        /// <summary>
+        /// Begins nested named scope of current frame; statistics also counts primitives and
+        /// shader invocations.
+        /// </summary>
+        void BeginProfileScope(string name, bool statistics);
+
+        /// <summary>
+        /// Ends innermost scope.
+        /// </summary>
+        void EndProfileScope();
+
+        /// <summary>
+        /// Frames resolved since last call, oldest first.
+        /// </summary>
+        GPUFrameTiming[] ReadProfileFrames();
+
+        /// <summary>
+        /// Recent resolved frames in Chrome trace format (chrome://tracing), null if not profiling.
+        /// </summary>
+        string GetProfileTrace();
+
+        /// <summary>
+        /// CPU spans and call counts of driver in Chrome trace format, null if driver was not built
+        /// with tracing. Clear discards them once written; no other thread may use the driver then.
+        /// </summary>
+        string ExportDriverTrace(bool clear);
+
+        #endregion
+
+        #region Occlusion Culling
+
+        /// <summary>
+        /// Creates an object culled by occlusion queries of its proxy (bounding volume). Objects
+        /// start visible; results are read at Enter, a frame or more after tests, and never waited for.
+        /// </summary>
+        uint CreateOcclusionObject();
+
+        /// <summary>
+        /// Destroys object, its id may be reused.
+        /// </summary>
+        void DestroyOcclusionObject(uint id);
+
+        /// <summary>
+        /// Sets indexed draw of object's proxy in buffers bound when tests are issued; count of 0
+        /// removes it. Objects without proxy are not tested and stay visible.
+        /// </summary>
+        void SetOcclusionProxy(uint id, ulong offset, ulong count, long baseIndex);
+
+        /// <summary>
+        /// Draws proxies of objects due for a test with bound state, which must not write colour
+        /// or depth. Issued after occluders are drawn.
+        /// </summary>
+        void IssueOcclusionTests();
+
+        /// <summary>
+        /// Begins draws of object. Draws of hidden object are predicated on its test in flight, so
+        /// the GPU skips them only if the test shows no samples passed.
+        /// </summary>
+        void BeginOcclusionDraw(uint id);
+
+        /// <summary>
+        /// Ends draws of object, predication is cleared.
+        /// </summary>
+        void EndOcclusionDraw();
+
+        /// <summary>
+        /// Whether latest resolved test of object passed.
+        /// </summary>
+        bool IsOcclusionVisible(uint id);
+
+        #endregion
+
         #region Rendering
 
         /// <summary>
@@ -420,6 +545,27 @@ namespace SharpMedia.Graphics.Driver
         void DrawIndexed(ulong offset, ulong count, long baseIndex,
                   uint instanceOffset, uint instanceCount);
 
+        /// <summary>
+        /// Queues indexed draw with per-object data. Queued draws are sorted by state and draws of
+        /// the same state and mesh are merged into instanced draws, with per-object data of each
+        /// instance read from vertex buffer at instance slot.
+        /// </summary>
+        void DrawIndexedBatched(ulong offset, ulong count, long baseIndex, float depth,
+                  uint instanceSlot, byte[] instanceData);
+
+        /// <summary>
+        /// Queues indexed draw. Queued draws are sorted by layer (0 to 15), then opaque draws by
+        /// state and front to back, translucent draws back to front.
+        /// </summary>
+        void DrawIndexedQueued(ulong offset, ulong count, long baseIndex,
+                  uint layer, bool translucent, float depth);
+
+        /// <summary>
+        /// Submits batched, then queued draws. Done implicitly before immediate draws, clears and render target,
+        /// viewport or stream output changes. Resources queued draws read must not change before.
+        /// </summary>
+        void FlushDraws();
+
         #endregion
 
     }
@@ -131,6 +131,33 @@ namespace SharpMedia.Graphics.Driver
     {
     }
 
+    /// <summary>
+    /// Linked vertex, geometry and pixel shaders with vertex binding, compiled together.
+    /// </summary>
+    [Linkable(LinkMask.Drivers)]
+    public interface IShaderPipeline : IDisposable
+    {
+        /// <summary>
+        /// The vertex shader.
+        /// </summary>
+        IVShader VertexShader { get; }
+
+        /// <summary>
+        /// The geometry shader, null if pipeline has none.
+        /// </summary>
+        IGShader GeometryShader { get; }
+
+        /// <summary>
+        /// The pixel shader.
+        /// </summary>
+        IPShader PixelShader { get; }
+
+        /// <summary>
+        /// Vertex binding matching vertex shader, null if no layout was given.
+        /// </summary>
+        IVerticesBindingLayout VertexBinding { get; }
+    }
+
 
     /// <summary>
     /// The swap chain; chain of buffers where rendering to window occurs.
@@ -140,7 +167,7 @@ namespace SharpMedia.Graphics.Driver
     {
 
         /// <summary>
-        /// Resets the swap chain.
+        /// Requests new size of buffers; requests are coalesced and applied at present.
         /// </summary>
         /// <param name="width">The new width.</param>
         /// <param name="height">The new height.</param>
@@ -160,6 +187,34 @@ namespace SharpMedia.Graphics.Driver
         /// Waits until presented.
         /// </summary>
         void Finish();
+
+        /// <summary>
+        /// Sets frame pacing of present.
+        /// </summary>
+        /// <param name="syncInterval">Vertical blanks per present, 0 disables vsync.</param>
+        /// <param name="maxFramesInFlight">Frames queued or being built at once.</param>
+        /// <param name="targetFrameTime">Frame time in seconds, 0 does not limit frame rate.</param>
+        void SetFramePacing(uint syncInterval, uint maxFramesInFlight, float targetFrameTime);
+
+        /// <summary>
+        /// Measured times in seconds; frame time is smoothed.
+        /// </summary>
+        void GetFrameTimes(out float cpuTime, out float gpuTime, out float frameTime);
+
+        /// <summary>
+        /// Resize requests, resizes applied and seconds taken by last one.
+        /// </summary>
+        void GetResizeStatistics(out uint requests, out uint applied, out float lastCost);
+
+        /// <summary>
+        /// Size of buffers; it lags window size until resize is applied at present.
+        /// </summary>
+        void GetBufferSize(out uint width, out uint height);
+
+        /// <summary>
+        /// Changes every time buffers are resized.
+        /// </summary>
+        uint ResizeGeneration { get; }
     }
 
     /// <summary>
@@ -192,9 +247,11 @@ namespace SharpMedia.Graphics.Driver
     public interface IWindow
     {
         void Resized(uint width, uint height);
+        void Moved(int x, int y);
         void Closed();
         void Minimized(bool minimize);
         void Focused(bool focus);
+        void DpiChanged(uint dpi);
     }
 
 
@@ -25,6 +25,11 @@ namespace SharpMedia.Graphics.Driver
     [Linkable(LinkMask.Drivers)]
     public interface IShaderCompiler : IDisposable
     {
+        /// <summary>
+        /// The compile profile of shaders, applies to shaders compiled afterwards.
+        /// </summary>
+        ShaderCompileProfile Profile { get; set; }
+
         /// <summary>
         /// Begins shader compilation.
         /// </summary>
@@ -45,6 +50,21 @@ namespace SharpMedia.Graphics.Driver
         /// </summary>
         IShaderBase End();
 
+        /// <summary>
+        /// Ends compilation of a stage without compiling it; it is compiled by CompilePipeline
+        /// together with other stages.
+        /// </summary>
+        void EndStage();
+
+        /// <summary>
+        /// Compiles stages ended with EndStage (vertex and pixel, optionally geometry) into a pipeline.
+        /// Stage signatures are linked and outputs the next stage does not read are removed. Stages
+        /// are compiled in parallel.
+        /// </summary>
+        /// <param name="layout">Vertex layout, can be null.</param>
+        /// <returns>The pipeline.</returns>
+        IShaderPipeline CompilePipeline(VertexBindingElement[] layout);
+
         /// <summary>
         /// Registers an input.
         /// </summary>
@@ -211,6 +231,14 @@ namespace SharpMedia.Graphics.Driver
 
         #region Flow Control
 
+        /// <summary>
+        /// Sets hint of the next BeginIf, BeginWhile or BeginSwitch. Hints that do not apply
+        /// to the block are ignored.
+        /// </summary>
+        /// <param name="hint">The hint.</param>
+        /// <param name="unrollCount">Unroll count of Unroll hint, 0 if not specified.</param>
+        void SetFlowHint(FlowControlHint hint, uint unrollCount);
+
         void BeginIf(int n);
         void Else();
         void EndIf();
@@ -15,4 +15,65 @@ using SharpMedia.Threading;
 namespace SharpMedia.Graphics
 {
 
+    /// <summary>
+    /// A named unit of GPU work, timed as a profile scope of current frame. Units nest; dispose
+    /// ends the unit. Results are in DevicePerformance a few frames later.
+    /// </summary>
+    /// <example>
+    /// using (device.BeginWorkUnit("Shadows"))
+    /// {
+    ///     // Draw shadow maps.
+    /// }
+    /// </example>
+    public sealed class GPUWorkUnit : IDisposable
+    {
+        #region Private Members
+        GraphicsDevice device;
+        string name;
+        #endregion
+
+        #region Properties
+
+        /// <summary>
+        /// Gets the name of unit.
+        /// </summary>
+        public string Name
+        {
+            get
+            {
+                return name;
+            }
+        }
+
+        #endregion
+
+        #region Constructors
+
+        /// <summary>
+        /// Begins the unit.
+        /// </summary>
+        internal GPUWorkUnit(GraphicsDevice device, string name, bool statistics)
+        {
+            this.device = device;
+            this.name = name;
+            device.DriverDevice.BeginProfileScope(name, statistics);
+        }
+
+        #endregion
+
+        #region IDisposable Members
+
+        /// <summary>
+        /// Ends the unit.
+        /// </summary>
+        public void Dispose()
+        {
+            if (device == null) return;
+
+            device.DriverDevice.EndProfileScope();
+            device = null;
+        }
+
+        #endregion
+    }
 }
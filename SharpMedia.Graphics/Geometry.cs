@@ -333,7 +333,19 @@ namespace SharpMedia.Graphics
         {
             get
             {
-                return false;
+                lock (syncRoot)
+                {
+                    if (vertexBuffers.Count == 0) return false;
+
+                    for (int i = 0; i < vertexBuffers.Count; i++)
+                    {
+                        if ((vertexBuffers[i].TypelessBuffer.BufferUsage & BufferUsage.GeometryOutput) == 0)
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
             }
         }
 
@@ -488,8 +500,19 @@ namespace SharpMedia.Graphics
             {
                 if (outLayout == null)
                 {
-                    throw new NotImplementedException();
+                    VertexBindingElement[] elements = new VertexBindingElement[vertexBuffers.Count];
+
+                    for (int i = 0; i < vertexBuffers.Count; i++)
+                    {
+                        VertexBindingElement element = new VertexBindingElement();
+                        element.Format = vertexBuffers[i].Format;
+                        element.UpdateFrequency = UpdateFrequency.PerVertex;
+                        element.UpdateFrequencyCount = 0;
+
+                        elements[i] = element;
+                    }
 
+                    outLayout = device.DriverDevice.CreateVertexOutBinding(elements);
                 }
             }
         }
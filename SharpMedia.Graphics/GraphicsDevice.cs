@@ -308,7 +308,8 @@ namespace SharpMedia.Graphics
             for (i = 0; i < pixelCBuffers.Length; i++) pixelCBuffers[i].UsedByDevice();
             for (i = 0; i < geometryCBuffers.Length; i++) geometryCBuffers[i].UsedByDevice();
             
-            // RTs
+            // RTs; depth stencil of swap chain is replaced if buffers were resized while unlocked.
+            if (SwapChain != null) pixelDepthStencilTarget = SwapChain.CurrentDepthStencil(pixelDepthStencilTarget);
             for (i = 0; i < pixelRenderTargets.Length; i++) pixelRenderTargets[i].UsedByDevice();
 
             if (pixelDepthStencilTarget != null) pixelDepthStencilTarget.UsedByDevice();
@@ -365,6 +366,29 @@ namespace SharpMedia.Graphics
         }
         
 
+        /// <summary>
+        /// Called by swap chain after its buffers were resized, which unbinds all targets in
+        /// driver. If device is locked by caller, targets are sent again; otherwise they are
+        /// sent when it is locked.
+        /// </summary>
+        /// <param name="swapChain">The resized swap chain.</param>
+        internal void BuffersResized(SwapChain swapChain)
+        {
+            // Presenting while other thread renders is not supported, its targets are left alone.
+            if (!Monitor.TryEnter(rootSync)) return;
+            try
+            {
+                if (locks == 0) return;
+
+                SetPixelShader(pshader, pixelSamplerStates, pixelTextures, pixelCBuffers, pixelRenderTargets,
+                    swapChain.CurrentDepthStencil(pixelDepthStencilTarget));
+            }
+            finally
+            {
+                Monitor.Exit(rootSync);
+            }
+        }
+
         /// <summary>
         /// Can be only created by AdapterFactory.
         /// </summary>
@@ -1502,6 +1526,7 @@ namespace SharpMedia.Graphics
                     output.UsedByDevice();
 
                     output.BindToDevice(this);
+                    output.BindOutputLayout(this);
                 }
             }
 
@@ -1974,6 +1999,185 @@ namespace SharpMedia.Graphics
             DevicePerformance.RenderData(inputGeometry.Topology, count * instanceCount);
         }
 
+        /// <summary>
+        /// Queues indexed draw with per-object data; draws of same state and mesh are merged into
+        /// instanced draws that read per-object data from vertex buffer at instance slot.
+        /// </summary>
+        /// <remarks>Queued draws are submitted by FlushDraws or before any other draw, clear, or
+        /// render target or viewport change. Resources they read must not change before.</remarks>
+        /// <param name="offset">The offset.</param>
+        /// <param name="count">The count.</param>
+        /// <param name="baseIndex">Index of the base.</param>
+        /// <param name="depth">Depth in [0,1], draws of same state are submitted front to back.</param>
+        /// <param name="instanceSlot">Vertex buffer slot of per-object data.</param>
+        /// <param name="instanceData">Per-object data, same size for all queued draws.</param>
+        public void DrawIndexedBatched(ulong offset, ulong count, long baseIndex, float depth,
+                  uint instanceSlot, [NotNull] byte[] instanceData)
+        {
+            AssertLocked();
+            DrawValidate();
+
+            // We also validate for out of range.
+            if (!inputGeometry.IsInRange(offset, count, baseIndex))
+            {
+                throw new ArgumentException("Trying to render out of range.");
+            }
+
+            // We queue.
+            device.DrawIndexedBatched(offset, count, baseIndex, depth, instanceSlot, instanceData);
+
+            DevicePerformance.RenderData(inputGeometry.Topology, count);
+        }
+
+        /// <summary>
+        /// Queues indexed draw; queued draws are sorted by layer, opaque draws by state and front
+        /// to back, translucent draws back to front.
+        /// </summary>
+        /// <remarks>Queued draws are submitted by FlushDraws or before any other draw, clear, or
+        /// render target or viewport change. Resources they read must not change before.</remarks>
+        /// <param name="offset">The offset.</param>
+        /// <param name="count">The count.</param>
+        /// <param name="baseIndex">Index of the base.</param>
+        /// <param name="layer">Layer, 0 to 15; lower layers are drawn first.</param>
+        /// <param name="translucent">Is draw translucent.</param>
+        /// <param name="depth">Depth in [0,1].</param>
+        public void DrawIndexedQueued(ulong offset, ulong count, long baseIndex,
+                  uint layer, bool translucent, float depth)
+        {
+            AssertLocked();
+            DrawValidate();
+
+            // We also validate for out of range.
+            if (!inputGeometry.IsInRange(offset, count, baseIndex))
+            {
+                throw new ArgumentException("Trying to render out of range.");
+            }
+            if (layer > 15)
+            {
+                throw new ArgumentOutOfRangeException("layer", "Layer must be between 0 and 15.");
+            }
+
+            // We queue.
+            device.DrawIndexedQueued(offset, count, baseIndex, layer, translucent, depth);
+
+            DevicePerformance.RenderData(inputGeometry.Topology, count);
+        }
+
+        /// <summary>
+        /// Begins a GPU work unit, timed when DevicePerformance.GPUProfiling is enabled.
+        /// </summary>
+        /// <param name="name">The name.</param>
+        /// <returns>Unit that ends when disposed.</returns>
+        public GPUWorkUnit BeginWorkUnit([NotNull] string name)
+        {
+            return BeginWorkUnit(name, false);
+        }
+
+        /// <summary>
+        /// Begins a GPU work unit, timed when DevicePerformance.GPUProfiling is enabled.
+        /// </summary>
+        /// <param name="name">The name.</param>
+        /// <param name="statistics">Also count primitives and shader invocations.</param>
+        /// <returns>Unit that ends when disposed.</returns>
+        public GPUWorkUnit BeginWorkUnit([NotNull] string name, bool statistics)
+        {
+            AssertLocked();
+
+            return new GPUWorkUnit(this, name, statistics);
+        }
+
+        /// <summary>
+        /// Submits queued draws.
+        /// </summary>
+        public void FlushDraws()
+        {
+            AssertLocked();
+
+            device.FlushDraws();
+        }
+
+        /// <summary>
+        /// Creates an object culled by occlusion queries of its proxy, a bounding volume drawn
+        /// by IssueOcclusionTests. Objects start visible.
+        /// </summary>
+        /// <returns>Id of object.</returns>
+        public uint CreateOcclusionObject()
+        {
+            AssertLocked();
+
+            return device.CreateOcclusionObject();
+        }
+
+        /// <summary>
+        /// Destroys an occlusion object, its id may be reused.
+        /// </summary>
+        /// <param name="id">The object.</param>
+        public void DestroyOcclusionObject(uint id)
+        {
+            AssertLocked();
+
+            device.DestroyOcclusionObject(id);
+        }
+
+        /// <summary>
+        /// Sets proxy of an occlusion object, an indexed draw in geometry bound when tests are issued.
+        /// Objects without proxy (count of 0) are not tested and stay visible.
+        /// </summary>
+        /// <param name="id">The object.</param>
+        /// <param name="offset">The offset.</param>
+        /// <param name="count">The count.</param>
+        /// <param name="baseIndex">Index of the base.</param>
+        public void SetOcclusionProxy(uint id, ulong offset, ulong count, long baseIndex)
+        {
+            AssertLocked();
+
+            device.SetOcclusionProxy(id, offset, count, baseIndex);
+        }
+
+        /// <summary>
+        /// Draws proxies of objects due for a test with bound geometry and shaders, which must not
+        /// write colour or depth. Issue after occluders are drawn; results are used a frame or more later.
+        /// </summary>
+        public void IssueOcclusionTests()
+        {
+            AssertLocked();
+
+            device.IssueOcclusionTests();
+        }
+
+        /// <summary>
+        /// Begins draws of an occlusion object. Draws of a hidden object are predicated on its test,
+        /// so the GPU skips them unless the object became visible.
+        /// </summary>
+        /// <param name="id">The object.</param>
+        public void BeginOcclusionDraw(uint id)
+        {
+            AssertLocked();
+
+            device.BeginOcclusionDraw(id);
+        }
+
+        /// <summary>
+        /// Ends draws of an occlusion object.
+        /// </summary>
+        public void EndOcclusionDraw()
+        {
+            AssertLocked();
+
+            device.EndOcclusionDraw();
+        }
+
+        /// <summary>
+        /// Whether latest resolved test of an occlusion object passed.
+        /// </summary>
+        /// <param name="id">The object.</param>
+        public bool IsOcclusionVisible(uint id)
+        {
+            AssertLocked();
+
+            return device.IsOcclusionVisible(id);
+        }
+
         #endregion
 
         #region IDisposable Members
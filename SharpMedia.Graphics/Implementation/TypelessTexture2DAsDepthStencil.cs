@@ -22,6 +22,8 @@ namespace SharpMedia.Graphics.Implementation
         TypelessTexture2D texture;
         PixelFormat format;
         uint mipmap = 0;
+        uint firstSlice = 0;
+        uint sliceCount = 0;    // Non-zero for array views.
         bool multisample = false;
         bool disposed = false;
         #endregion
@@ -63,6 +65,18 @@ namespace SharpMedia.Graphics.Implementation
             texture.AddRef();
         }
 
+        internal TypelessTexture2DAsDepthStencil(TypelessTexture2D texture, PixelFormat fmt, uint mipmap,
+                                                 uint firstSlice, uint sliceCount)
+        {
+            this.texture = texture;
+            this.format = fmt;
+            this.mipmap = mipmap;
+            this.firstSlice = firstSlice;
+            this.sliceCount = sliceCount;
+
+            texture.AddRef();
+        }
+
         internal TypelessTexture2DAsDepthStencil(TypelessTexture2D texture, PixelFormat fmt)
         {
             this.texture = texture;
@@ -120,10 +134,13 @@ namespace SharpMedia.Graphics.Implementation
 
                 if (view == null)
                 {
+                    SharpMedia.Graphics.Driver.UsageDimensionType dimension = 
+                        SharpMedia.Graphics.Driver.UsageDimensionType.Texture2D;
+                    if (sliceCount > 0) dimension = SharpMedia.Graphics.Driver.UsageDimensionType.Texture2DArray;
+                    else if (multisample) dimension = SharpMedia.Graphics.Driver.UsageDimensionType.Texture2DMS;
+
                     view = device.DriverDevice.CreateDepthStencilTargetView(texture.DeviceData,
-                        multisample ? SharpMedia.Graphics.Driver.UsageDimensionType.Texture2D :
-                        SharpMedia.Graphics.Driver.UsageDimensionType.Texture2DMS, format.CommonFormatLayout,
-                        mipmap, 0, 0);       
+                        dimension, format.CommonFormatLayout, mipmap, firstSlice, sliceCount);
                 }
             }
         }
@@ -20,6 +20,8 @@ namespace SharpMedia.Graphics.Implementation
         #region Private Members
         bool multisample = false;
         uint mipmapSlice;
+        uint firstSlice = 0;
+        uint sliceCount = 0;    // Non-zero for array views.
         PixelFormat format;
         TypelessTexture2D texture;
         #endregion
@@ -44,6 +46,18 @@ namespace SharpMedia.Graphics.Implementation
             texture.AddRef();
         }
 
+        internal TypelessTexture2DAsRenderTarget(TypelessTexture2D texture, PixelFormat fmt, uint mipmapSlice,
+                                                 uint firstSlice, uint sliceCount)
+        {
+            this.texture = texture;
+            this.mipmapSlice = mipmapSlice;
+            this.firstSlice = firstSlice;
+            this.sliceCount = sliceCount;
+            this.format = fmt;
+
+            texture.AddRef();
+        }
+
         internal override void UnusedByDevice()
         {
             texture.UnusedByDevice();
@@ -127,9 +141,11 @@ namespace SharpMedia.Graphics.Implementation
                 // We now create view.
                 if (view == null)
                 {
+                    UsageDimensionType dimension = multisample ? UsageDimensionType.Texture2DMS : UsageDimensionType.Texture2D;
+                    if (sliceCount > 0) dimension = UsageDimensionType.Texture2DArray;
+
                     view = device.DriverDevice.CreateRenderTargetView(texture.DeviceData,
-                        multisample ? UsageDimensionType.Texture2DMS : UsageDimensionType.Texture2D,
-                        format.CommonFormatLayout, mipmapSlice, 0, 0);
+                        dimension, format.CommonFormatLayout, mipmapSlice, firstSlice, sliceCount);
 
                 }
             }
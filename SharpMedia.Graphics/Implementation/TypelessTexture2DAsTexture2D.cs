@@ -26,6 +26,7 @@ namespace SharpMedia.Graphics.Implementation
         PixelFormat format;
         uint mostDetailedMipmap;
         uint mipmapCount;
+        Driver.UsageDimensionType dimension;
 
         // Access methods
         Mipmap mipmap;
@@ -36,7 +37,14 @@ namespace SharpMedia.Graphics.Implementation
 
         internal TypelessTexture2DAsTexture2D(PixelFormat format,
             uint mostDetailed, uint count, TypelessTexture2D texture2D)
+            : this(format, mostDetailed, count, Driver.UsageDimensionType.Texture2D, texture2D)
         {
+        }
+
+        internal TypelessTexture2DAsTexture2D(PixelFormat format,
+            uint mostDetailed, uint count, Driver.UsageDimensionType dimension, TypelessTexture2D texture2D)
+        {
+            this.dimension = dimension;
             this.format = format;
             this.mostDetailedMipmap = mostDetailed;
             this.mipmapCount = count;
@@ -128,7 +136,12 @@ namespace SharpMedia.Graphics.Implementation
 
         public override PinFormat ViewType
         {
-            get { return PinFormat.Texture2D; }
+            get
+            {
+                if (dimension == Driver.UsageDimensionType.TextureCube) return PinFormat.TextureCube;
+                if (dimension == Driver.UsageDimensionType.Texture2DArray) return PinFormat.Texture2DArray;
+                return PinFormat.Texture2D;
+            }
         }
 
         public override PixelFormat Format
@@ -263,7 +276,7 @@ namespace SharpMedia.Graphics.Implementation
                 {
                     // We bind ourself.
                     view = device.DriverDevice.CreateTextureView(texture2D.DeviceData,
-                        Driver.UsageDimensionType.Texture2D, format.CommonFormatLayout,
+                        dimension, format.CommonFormatLayout,
                         mostDetailedMipmap, mipmapCount, 0);
                 }
                 
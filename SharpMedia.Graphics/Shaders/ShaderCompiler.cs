@@ -100,6 +100,63 @@ namespace SharpMedia.Graphics.Shaders
         None
     }
 
+    /// <summary>
+    /// Flow control hints, they override driver's choice of how a block is executed.
+    /// </summary>
+    public enum FlowControlHint
+    {
+        /// <summary>
+        /// Driver chooses from uniformity of condition and size of block.
+        /// </summary>
+        Auto,
+
+        /// <summary>
+        /// Dynamic branch (if and switch).
+        /// </summary>
+        Branch,
+
+        /// <summary>
+        /// All paths are executed and results selected (if and switch).
+        /// </summary>
+        Flatten,
+
+        /// <summary>
+        /// Dynamic loop (while).
+        /// </summary>
+        Loop,
+
+        /// <summary>
+        /// Unrolled loop (while), unroll count can be specified.
+        /// </summary>
+        Unroll,
+
+        /// <summary>
+        /// Switch executed as jump table (switch).
+        /// </summary>
+        ForceCase
+    }
+
+    /// <summary>
+    /// Shader compile profile, selects optimization and validation of shader bytecode.
+    /// </summary>
+    public enum ShaderCompileProfile
+    {
+        /// <summary>
+        /// No optimizations, debug information, strict IEEE and preferred flow control.
+        /// </summary>
+        Debug,
+
+        /// <summary>
+        /// Moderate optimizations with debug information.
+        /// </summary>
+        Development,
+
+        /// <summary>
+        /// Full optimizations, validation is skipped.
+        /// </summary>
+        Shipping
+    }
+
 
     /// <summary>
     /// Shader compiler is constructed using device and can compile shaders. It is
@@ -1023,6 +1080,26 @@ namespace SharpMedia.Graphics.Shaders
 
         #endregion
 
+        #region Profile
+
+        /// <summary>
+        /// The compile profile of shaders. It is initialized from device and can be
+        /// changed per shader.
+        /// </summary>
+        public ShaderCompileProfile Profile
+        {
+            get
+            {
+                return compiler.Profile;
+            }
+            set
+            {
+                compiler.Profile = value;
+            }
+        }
+
+        #endregion
+
         #region Flow Operations
 
         public void BeginSwitch(Operand operand)
@@ -1030,6 +1107,15 @@ namespace SharpMedia.Graphics.Shaders
             compiler.BeginSwitch(operand.Name);
         }
 
+        /// <summary>
+        /// Begins switch with flow control hint.
+        /// </summary>
+        public void BeginSwitch(Operand operand, FlowControlHint hint)
+        {
+            compiler.SetFlowHint(hint, 0);
+            compiler.BeginSwitch(operand.Name);
+        }
+
         public void BeginCase(Operand operand)
         {
             if (!operand.IsFixed) throw new ArgumentException("The case label must be fixed.");
@@ -1056,6 +1142,16 @@ namespace SharpMedia.Graphics.Shaders
             compiler.BeginWhile();
         }
 
+        /// <summary>
+        /// Begins while with flow control hint.
+        /// </summary>
+        /// <param name="unrollCount">Unroll count for Unroll hint, 0 for full unroll.</param>
+        public void BeginWhile(FlowControlHint hint, uint unrollCount)
+        {
+            compiler.SetFlowHint(hint, unrollCount);
+            compiler.BeginWhile();
+        }
+
         public void EndWhile()
         {
             compiler.EndWhile();
@@ -1071,6 +1167,15 @@ namespace SharpMedia.Graphics.Shaders
             compiler.BeginIf(operand.Name);
         }
 
+        /// <summary>
+        /// Begins if with flow control hint.
+        /// </summary>
+        public void BeginIf(Operand operand, FlowControlHint hint)
+        {
+            compiler.SetFlowHint(hint, 0);
+            compiler.BeginIf(operand.Name);
+        }
+
         public void Else()
         {
             compiler.Else();
@@ -1297,6 +1402,22 @@ namespace SharpMedia.Graphics.Shaders
             }
         }
 
+        /// <summary>
+        /// Ends a stage of pipeline, it is compiled by CompilePipeline.
+        /// </summary>
+        public void EndStage()
+        {
+            compiler.EndStage();
+        }
+
+        /// <summary>
+        /// Compiles and links all stages ended with EndStage, with an optional vertex layout.
+        /// </summary>
+        public Driver.IShaderPipeline CompilePipeline(Driver.VertexBindingElement[] layout)
+        {
+            return compiler.CompilePipeline(layout);
+        }
+
         /// <summary>
         /// Compiles the shader from file
         /// </summary>
@@ -0,0 +1,114 @@
+// This file constitutes a part of the SharpMedia project, (c) 2007 by the SharpMedia team
+// and is licensed for your use under the conditions of the NDA or other legally binding contract
+// that you or a legal entity you represent has signed with the SharpMedia team.
+// In an event that you have received or obtained this file without such legally binding contract
+// in place, you MUST destroy all files and other content to which this lincese applies and
+// contact the SharpMedia team for further instructions at the internet mail address:
+//
+//    legal@sharpmedia.com
+//
+using System;
+using System.Collections.Generic;
+using System.Text;
+using SharpMedia.AspectOriented;
+
+namespace SharpMedia.Graphics
+{
+
+    /// <summary>
+    /// Two stream output geometries used alternately, one is read (drawn with DrawAuto) while
+    /// geometry shader writes the other. Keeps GPU simulations (particles) on the GPU.
+    /// </summary>
+    public sealed class StreamOutputPingPong : IDisposable
+    {
+        #region Private Members
+        Geometry source;
+        Geometry target;
+        bool written = false;
+        #endregion
+
+        #region Constructors
+
+        /// <summary>
+        /// Creates ping-pong pair, both geometries must be output compatible.
+        /// </summary>
+        public StreamOutputPingPong([NotNull] Geometry first, [NotNull] Geometry second)
+        {
+            if (!first.IsOutputCompatible || !second.IsOutputCompatible)
+            {
+                throw new ArgumentException("Both geometries must be output compatible.");
+            }
+
+            this.source = first;
+            this.target = second;
+        }
+
+        #endregion
+
+        #region Public Members
+
+        /// <summary>
+        /// Geometry that was last written, input of next step.
+        /// </summary>
+        public Geometry Source
+        {
+            get { return source; }
+        }
+
+        /// <summary>
+        /// Geometry that is written by next step.
+        /// </summary>
+        public Geometry Target
+        {
+            get { return target; }
+        }
+
+        /// <summary>
+        /// Whether source was written by stream output, so DrawAuto can be used. Before first
+        /// step source holds initial data and must be drawn with explicit count.
+        /// </summary>
+        public bool SourceWritten
+        {
+            get { return written; }
+        }
+
+        /// <summary>
+        /// Binds source as input of vertex shader and target as stream output of geometry
+        /// shader, together with samplers, textures and constant buffers of both stages.
+        /// </summary>
+        public void Bind([NotNull] GraphicsDevice device,
+            Shaders.VShader vshader, SamplerState[] vertexSamplers, TextureView[] vertexTextures,
+            ConstantBufferView[] vertexConstantBuffers,
+            [NotNull] Shaders.GShader gshader, SamplerState[] geometrySamplers, TextureView[] geometryTextures,
+            ConstantBufferView[] geometryConstantBuffers)
+        {
+            // Unbind output first, source may have been the target of previous step.
+            device.SetGeometryShader(gshader, null, geometrySamplers, geometryTextures, geometryConstantBuffers);
+            device.SetVertexShader(vshader, source, vertexSamplers, vertexTextures, vertexConstantBuffers);
+            device.SetGeometryShader(gshader, target, geometrySamplers, geometryTextures, geometryConstantBuffers);
+        }
+
+        /// <summary>
+        /// Swaps source and target, call after step was drawn.
+        /// </summary>
+        public void Swap()
+        {
+            Geometry tmp = source;
+            source = target;
+            target = tmp;
+            written = true;
+        }
+
+        #endregion
+
+        #region IDisposable Members
+
+        public void Dispose()
+        {
+            source.Dispose();
+            target.Dispose();
+        }
+
+        #endregion
+    }
+}
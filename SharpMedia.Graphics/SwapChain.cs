@@ -32,6 +32,16 @@ namespace SharpMedia.Graphics
         Driver.ISwapChain chain;
         PixelFormat format;
         bool fullscreen;
+        uint syncInterval = 0;
+        uint maxFramesInFlight = 2;
+        float targetFrameTime = 0.0f;
+        float backgroundFrameTime = 1.0f / 30.0f;
+        float minimizedFrameTime = 0.1f;
+        bool background = false;
+        bool minimized = false;
+        DepthStencilTargetView depthStencil;
+        PixelFormat depthStencilFormat;
+        uint depthStencilGeneration;
         #endregion
 
         #region Internal Methods
@@ -52,6 +62,41 @@ namespace SharpMedia.Graphics
             chain.Resize(width, height);
         }
 
+        internal void WindowStateChanged(bool focused, bool minimized)
+        {
+            lock (syncRoot)
+            {
+                this.background = !focused;
+                this.minimized = minimized;
+                UpdatePacing();
+            }
+        }
+
+        /// <summary>
+        /// Replaces depth stencil of this chain created before last resize with one sized to
+        /// buffers; other views are returned as they are.
+        /// </summary>
+        internal DepthStencilTargetView CurrentDepthStencil(DepthStencilTargetView view)
+        {
+            lock (syncRoot)
+            {
+                if (view == null || view != depthStencil) return view;
+                if (depthStencilGeneration == chain.ResizeGeneration) return view;
+
+                return GetDepthStencil(depthStencilFormat);
+            }
+        }
+
+        void UpdatePacing()
+        {
+            // Window that is not seen is not rendered faster than its throttled rate.
+            float frameTime = targetFrameTime;
+            if (minimized) frameTime = System.Math.Max(frameTime, minimizedFrameTime);
+            else if (background) frameTime = System.Math.Max(frameTime, backgroundFrameTime);
+
+            chain.SetFramePacing(syncInterval, maxFramesInFlight, frameTime);
+        }
+
         #endregion
 
         #region Public Members
@@ -66,7 +111,191 @@ namespace SharpMedia.Graphics
             {
                 AssertNotDisposed();
 
+                uint generation = chain.ResizeGeneration;
                 chain.Present();
+
+                // Resizing unbinds targets in driver, device sends its targets again.
+                if (chain.ResizeGeneration != generation) device.BuffersResized(this);
+            }
+        }
+
+        /// <summary>
+        /// Gets depth stencil sized to back buffers. It is created on first use and recreated
+        /// only when BufferGeneration changed since, so it can be obtained every frame. If it is
+        /// bound when buffers are resized, device binds the recreated one instead.
+        /// </summary>
+        /// <param name="format">The depth stencil format.</param>
+        public DepthStencilTargetView GetDepthStencil([NotNull] PixelFormat format)
+        {
+            lock (syncRoot)
+            {
+                AssertNotDisposed();
+
+                uint generation = chain.ResizeGeneration;
+                if (depthStencil != null && depthStencilGeneration == generation && 
+                    format.Equals(depthStencilFormat))
+                {
+                    return depthStencil;
+                }
+
+                if (depthStencil != null) depthStencil.Dispose();
+
+                uint width, height;
+                chain.GetBufferSize(out width, out height);
+
+                TypelessTexture2D texture = new TypelessTexture2D(device, Usage.Default, TextureUsage.DepthStencilTarget,
+                    CPUAccess.None, format, width, height, 1, 1, 0, GraphicsLocality.DeviceMemoryOnly, null);
+                texture.DisposeOnViewDispose = true;
+
+                depthStencil = new Implementation.TypelessTexture2DAsDepthStencil(texture, format, 0);
+                depthStencilFormat = format;
+                depthStencilGeneration = generation;
+                return depthStencil;
+            }
+        }
+
+        /// <summary>
+        /// Number of vertical blanks to wait for on present, 0 disables vsync. Default is 0, presents
+        /// do not wait for vertical blank unless asked to.
+        /// </summary>
+        public uint SyncInterval
+        {
+            get
+            {
+                return syncInterval;
+            }
+            set
+            {
+                lock (syncRoot)
+                {
+                    if (value > 4) throw new ArgumentException("Sync interval must be at most 4.");
+                    syncInterval = value;
+                    UpdatePacing();
+                }
+            }
+        }
+
+        /// <summary>
+        /// Frames that can be queued or built at once. Present blocks when the device is
+        /// further behind. Lower values reduce input latency, default is 2.
+        /// </summary>
+        public uint MaxFramesInFlight
+        {
+            get
+            {
+                return maxFramesInFlight;
+            }
+            set
+            {
+                lock (syncRoot)
+                {
+                    if (value == 0) throw new ArgumentException("At least one frame must be in flight.");
+                    maxFramesInFlight = value;
+                    UpdatePacing();
+                }
+            }
+        }
+
+        /// <summary>
+        /// Target frame time in seconds; present sleeps when frame is faster. 0 means no limit.
+        /// </summary>
+        public float TargetFrameTime
+        {
+            get
+            {
+                return targetFrameTime;
+            }
+            set
+            {
+                lock (syncRoot)
+                {
+                    if (value < 0.0f) throw new ArgumentException("Frame time must not be negative.");
+                    targetFrameTime = value;
+                    UpdatePacing();
+                }
+            }
+        }
+
+        /// <summary>
+        /// Minimal frame time in seconds while window does not have focus, 0 means no
+        /// limit. Default is 1/30.
+        /// </summary>
+        public float BackgroundFrameTime
+        {
+            get
+            {
+                return backgroundFrameTime;
+            }
+            set
+            {
+                lock (syncRoot)
+                {
+                    if (value < 0.0f) throw new ArgumentException("Frame time must not be negative.");
+                    backgroundFrameTime = value;
+                    UpdatePacing();
+                }
+            }
+        }
+
+        /// <summary>
+        /// Minimal frame time in seconds while window is minimized, 0 means no limit.
+        /// Default is 0.1.
+        /// </summary>
+        public float MinimizedFrameTime
+        {
+            get
+            {
+                return minimizedFrameTime;
+            }
+            set
+            {
+                lock (syncRoot)
+                {
+                    if (value < 0.0f) throw new ArgumentException("Frame time must not be negative.");
+                    minimizedFrameTime = value;
+                    UpdatePacing();
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets measured frame times in seconds. CPU time excludes waiting for device and
+        /// sleeping, frame time is smoothed.
+        /// </summary>
+        public void GetFrameTimes(out float cpuTime, out float gpuTime, out float frameTime)
+        {
+            lock (syncRoot)
+            {
+                AssertNotDisposed();
+
+                chain.GetFrameTimes(out cpuTime, out gpuTime, out frameTime);
+            }
+        }
+
+        /// <summary>
+        /// Changes every time back buffers are resized. Resizes of window are applied at next
+        /// present, so render targets sized to swap chain should compare this on use and be
+        /// recreated only when it differs, not on every resize event.
+        /// </summary>
+        public uint BufferGeneration
+        {
+            get
+            {
+                return chain.ResizeGeneration;
+            }
+        }
+
+        /// <summary>
+        /// Gets resize requests received, resizes applied (several requests in a frame are
+        /// applied once) and seconds taken by last resize.
+        /// </summary>
+        public void GetResizeStatistics(out uint requests, out uint applied, out float lastCost)
+        {
+            lock (syncRoot)
+            {
+                AssertNotDisposed();
+
+                chain.GetResizeStatistics(out requests, out applied, out lastCost);
             }
         }
 
@@ -37,6 +37,7 @@ namespace SharpMedia.Graphics
         uint width;
         uint height = 1;
         uint mipmapCount = 1;
+        uint arraySize = 1;
         byte[][] swData;
 
         List<LockState> locks = new List<LockState>();
@@ -265,6 +266,7 @@ namespace SharpMedia.Graphics
             this.height = height;
             this.format = fmt;
             this.mipmapCount = mipmaps == 0 ? Images.MipmapHelper.MipmapCount(width, height) : mipmaps;
+            this.arraySize = (textureUsage & TextureUsage.CubeMap) != 0 ? 6u : 1u;
 
             // We create driver part.
             if (locality != GraphicsLocality.SystemMemoryOnly)
@@ -301,6 +303,7 @@ namespace SharpMedia.Graphics
             // Mipmaps first.
             Validate(mipmaps, width, height);
             this.mipmapCount = mipmaps == 0 ? Images.MipmapHelper.MipmapCount(width, height) : mipmaps;
+            this.arraySize = (textureUsage & TextureUsage.CubeMap) != 0 ? 6u : 1u;
 
             // We copy data if it exists, otherwise we dont do it.
             if (data != null)
@@ -341,6 +344,40 @@ namespace SharpMedia.Graphics
             this.format = fmt;
         }
 
+        /// <summary>
+        /// Creates a texture array of slices that live in device memory only, for rendering
+        /// to all slices (cascades, cube faces) in one pass.
+        /// </summary>
+        /// <param name="device">The device.</param>
+        /// <param name="usage">The usage.</param>
+        /// <param name="textureUsage">The texture usage; cube maps must have 6 slices.</param>
+        /// <param name="fmt">The format.</param>
+        /// <param name="width">The width.</param>
+        /// <param name="height">The height.</param>
+        /// <param name="arraySize">The number of slices.</param>
+        /// <param name="mipmaps">The number of mipmaps, 0 for full chain.</param>
+        /// <param name="sampleCount">The sample count.</param>
+        /// <param name="sampleQuality">The sample quality.</param>
+        public TypelessTexture2D([NotNull] GraphicsDevice device, Usage usage, TextureUsage textureUsage,
+                            [NotNull] PixelFormat fmt, uint width, uint height, uint arraySize, uint mipmaps,
+                            uint sampleCount, uint sampleQuality)
+            : base(usage, textureUsage, CPUAccess.None, GraphicsLocality.DeviceMemoryOnly)
+        {
+            Validate(mipmaps, width, height);
+            if (arraySize == 0) throw new ArgumentException("Texture array must have at least one slice.");
+
+            this.width = width;
+            this.height = height;
+            this.format = fmt;
+            this.arraySize = arraySize;
+            this.mipmapCount = mipmaps == 0 ? Images.MipmapHelper.MipmapCount(width, height) : mipmaps;
+
+            this.device = device;
+            this.driverPart = device.DriverDevice.CreateTexture2DArray(usage, fmt.CommonFormatLayout,
+                            CPUAccess.None, width, height, arraySize, mipmapCount, textureUsage, 
+                            sampleCount, sampleQuality);
+        }
+
         #endregion
 
         #region Public Methods
@@ -355,7 +392,13 @@ namespace SharpMedia.Graphics
                 this.device = device;
                 if (driverPart == null)
                 {
-                    if (sharingContext.IsOwned)
+                    if (sharingContext.IsOwned && arraySize > 1 && swData == null)
+                    {
+                        // Device memory only slices are recreated empty.
+                        driverPart = device.DriverDevice.CreateTexture2DArray(usage, Format.CommonFormatLayout,
+                            this.CPUAccess, width, height, arraySize, mipmapCount, textureUsage, 1, 0);
+                    }
+                    else if (sharingContext.IsOwned)
                     {
                         driverPart = device.DriverDevice.CreateTexture2D(usage, Format.CommonFormatLayout,
                             this.CPUAccess, width, height, mipmapCount, textureUsage, 1, 0, swData);
@@ -396,6 +439,14 @@ namespace SharpMedia.Graphics
             get { return mipmapCount; }
         }
 
+        /// <summary>
+        /// Gets the number of slices; 6 for cube maps, 1 for plain textures.
+        /// </summary>
+        public uint ArraySize
+        {
+            get { return arraySize; }
+        }
+
         public override void GenerateMipmaps(BuildImageFilter filter)
         {
             lock (syncRoot)
@@ -573,6 +624,11 @@ namespace SharpMedia.Graphics
                     // Early exit.
                     if (locality == value) return;
 
+                    if (arraySize > 1 && swData == null)
+                    {
+                        throw new InvalidOperationException("Texture array slices live in device memory only.");
+                    }
+
                     if (driverPart == null 
                         && value == GraphicsLocality.DeviceMemoryOnly)
                     {
@@ -693,7 +749,12 @@ namespace SharpMedia.Graphics
                 throw new IndexOutOfRangeException("Trying to access mipmap(s) out of range.");
             }
 
-            return new Implementation.TypelessTexture2DAsTexture2D(format, mostDetailed, count, this);
+            // Cube maps are sampled as cubes, other arrays as arrays of all slices.
+            Driver.UsageDimensionType dimension = Driver.UsageDimensionType.Texture2D;
+            if ((textureUsage & TextureUsage.CubeMap) != 0) dimension = Driver.UsageDimensionType.TextureCube;
+            else if (arraySize > 1) dimension = Driver.UsageDimensionType.Texture2DArray;
+
+            return new Implementation.TypelessTexture2DAsTexture2D(format, mostDetailed, count, dimension, this);
         }
 
         /// <summary>
@@ -736,6 +797,47 @@ namespace SharpMedia.Graphics
             return new Implementation.TypelessTexture2DAsRenderTarget(this, format, mipmap);
         }
 
+        /// <summary>
+        /// Creates a render target view of a range of slices, rendered in one pass by routing
+        /// primitives with RenderTargetArrayIndex.
+        /// </summary>
+        /// <param name="format">The format.</param>
+        /// <param name="mipmap">The mipmap.</param>
+        /// <param name="firstSlice">The first slice.</param>
+        /// <param name="sliceCount">The slice count, 0 for all remaining slices.</param>
+        /// <returns></returns>
+        public RenderTargetView CreateRenderTargetArray([NotNull] PixelFormat format, uint mipmap,
+                                                        uint firstSlice, uint sliceCount)
+        {
+            if (sliceCount == 0) sliceCount = arraySize > firstSlice ? arraySize - firstSlice : 0;
+            if (sliceCount == 0 || firstSlice + sliceCount > arraySize)
+            {
+                throw new IndexOutOfRangeException("Trying to access slice(s) out of range.");
+            }
+
+            return new Implementation.TypelessTexture2DAsRenderTarget(this, format, mipmap, firstSlice, sliceCount);
+        }
+
+        /// <summary>
+        /// Creates a depth stencil view of a range of slices.
+        /// </summary>
+        /// <param name="format">The format.</param>
+        /// <param name="mipmap">The mipmap.</param>
+        /// <param name="firstSlice">The first slice.</param>
+        /// <param name="sliceCount">The slice count, 0 for all remaining slices.</param>
+        /// <returns></returns>
+        public DepthStencilTargetView CreateDepthStencilArray([NotNull] PixelFormat format, uint mipmap,
+                                                              uint firstSlice, uint sliceCount)
+        {
+            if (sliceCount == 0) sliceCount = arraySize > firstSlice ? arraySize - firstSlice : 0;
+            if (sliceCount == 0 || firstSlice + sliceCount > arraySize)
+            {
+                throw new IndexOutOfRangeException("Trying to access slice(s) out of range.");
+            }
+
+            return new Implementation.TypelessTexture2DAsDepthStencil(this, format, mipmap, firstSlice, sliceCount);
+        }
+
         /// <summary>
         /// Crates a render target view with multisapling.
         /// </summary>
@@ -54,6 +54,15 @@ namespace SharpMedia.Graphics
                 }
             }
 
+            public void Moved(int x, int y)
+            {
+                Action<Window> m = window.moved;
+                if (m != null)
+                {
+                    m(window);
+                }
+            }
+
             public void Closed()
             {
                 Action<Window> c = window.closed;
@@ -65,24 +74,39 @@ namespace SharpMedia.Graphics
 
             public void Minimized(bool minimize)
             {
+                window.isMinimized = minimize;
+                window.Device.SwapChain.WindowStateChanged(window.hasFocus, minimize);
+
                 Action<Window> m = window.minimized;
                 if (m != null)
                 {
-                    window.isMinimized = minimize;
                     m(window);
                 }
             }
 
             public void Focused(bool focus)
             {
+                window.hasFocus = focus;
+                window.Device.SwapChain.WindowStateChanged(focus, window.isMinimized);
+
                 Action<Window> f = window.focus;
                 if (f != null)
                 {
-                    window.hasFocus = focus;
                     f(window);
                 }
             }
 
+            public void DpiChanged(uint dpi)
+            {
+                window.dpi = dpi;
+
+                Action<Window> d = window.dpiChanged;
+                if (d != null)
+                {
+                    d(window);
+                }
+            }
+
             #endregion
         }
 
@@ -98,10 +122,13 @@ namespace SharpMedia.Graphics
         uint height;
         bool hasFocus = true;
         bool isMinimized = false;
+        uint dpi = 96;
         Action<Window> closed;
         Action<Window> resized;
+        Action<Window> moved;
         Action<Window> focus;
         Action<Window> minimized;
+        Action<Window> dpiChanged;
         #endregion
 
         #region Internal Methods
@@ -184,7 +211,41 @@ namespace SharpMedia.Graphics
         }
 
         /// <summary>
-        /// Does the events. Must be called at least once per frame.
+        /// Window has keyboard focus.
+        /// </summary>
+        public bool HasFocus
+        {
+            get
+            {
+                return hasFocus;
+            }
+        }
+
+        /// <summary>
+        /// Window is minimized.
+        /// </summary>
+        public bool IsMinimized
+        {
+            get
+            {
+                return isMinimized;
+            }
+        }
+
+        /// <summary>
+        /// Dots per inch of monitor window is on.
+        /// </summary>
+        public uint Dpi
+        {
+            get
+            {
+                return dpi;
+            }
+        }
+
+        /// <summary>
+        /// Does the events. Must be called at least once per frame. Events are delivered
+        /// within a time budget, those left are delivered on next call.
         /// </summary>
         public void DoEvents()
         {
@@ -240,6 +301,27 @@ namespace SharpMedia.Graphics
             }
         }
 
+        /// <summary>
+        /// Triggered when window is moved on screen.
+        /// </summary>
+        public event Action<Window> Moved
+        {
+            add
+            {
+                lock (syncRoot)
+                {
+                    moved += value;
+                }
+            }
+            remove
+            {
+                lock (syncRoot)
+                {
+                    moved -= value;
+                }
+            }
+        }
+
         /// <summary>
         /// Triggered when window gains or looses focus.
         /// </summary>
@@ -282,6 +364,27 @@ namespace SharpMedia.Graphics
             }
         }
 
+        /// <summary>
+        /// Triggered when window moves to monitor with different DPI; resize follows.
+        /// </summary>
+        public event Action<Window> DpiChanged
+        {
+            add
+            {
+                lock (syncRoot)
+                {
+                    dpiChanged += value;
+                }
+            }
+            remove
+            {
+                lock (syncRoot)
+                {
+                    dpiChanged -= value;
+                }
+            }
+        }
+
         #endregion
 
     }
@@ -0,0 +1,173 @@
+#include "diactionmap.h"
+
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	DIActionMap::DIActionMap()
+	{
+		map = new ActionMap();
+		devices = gcnew array<IInputDevice^>(ActionMaxDevices);
+		buttons = gcnew array<bool>(InputMaxButtons);
+		axes = gcnew array<Int64>(InputMaxAxes);
+		keyBits = gcnew array<UInt32>(8);
+		buffered = gcnew array<BufferedInputEvent>(ActionReadChunk);
+		eventsRead = 0;
+	}
+
+	int DIActionMap::AddBinding(Driver::ActionBinding binding)
+	{
+		DirectInput::ActionBinding b = ActionMap::DefaultBinding();
+		b.action = binding.Action;
+		b.kind = (unsigned int)binding.Trigger;
+		b.threshold = binding.Threshold;
+		b.scale = binding.Scale;
+		b.absolute = binding.Absolute;
+
+		unsigned int limit = b.kind == ActionAxis ? InputMaxAxes : InputMaxButtons;
+		if(binding.Device >= ActionMaxDevices || binding.Input >= limit)
+		{
+			throw gcnew ArgumentException("Device slot or input out of range.");
+		}
+		b.input = b.kind == ActionAxis ? ActionAxisInput(binding.Device, binding.Input) :
+			ActionButton(binding.Device, binding.Input);
+
+		if(binding.Modifiers != nullptr)
+		{
+			if(binding.Modifiers->Length > (int)ActionMaxModifiers) throw gcnew ArgumentException("At most 4 modifiers.");
+			for(int i = 0; i < binding.Modifiers->Length; i++) b.modifiers[i] = binding.Modifiers[i];
+			b.modifierCount = binding.Modifiers->Length;
+		}
+
+		int index = map->AddBinding(b);
+		if(index < 0) throw gcnew ArgumentException("Invalid binding or too many modifier buttons.");
+		return index;
+	}
+
+	void DIActionMap::ClearBindings()
+	{
+		map->Clear();
+		eventsRead = 0;
+	}
+
+	void DIActionMap::Attach(UInt32 slot, IInputDevice^ device)
+	{
+		if(slot >= ActionMaxDevices) throw gcnew ArgumentException("Device slot out of range.");
+
+		// Buttons held by previous device are released.
+		map->ResetDevice(slot);
+		devices[slot] = device;
+	}
+
+	void DIActionMap::Detach(UInt32 slot)
+	{
+		if(slot >= ActionMaxDevices) throw gcnew ArgumentException("Device slot out of range.");
+
+		map->ResetDevice(slot);
+		devices[slot] = nullptr;
+	}
+
+	void DIActionMap::ReadRecords(unsigned int slot, double time)
+	{
+		IInputDevice^ device = devices[slot];
+		InputRecord records[ActionReadChunk];
+
+		for(;;)
+		{
+			int count = device->ReadEvents(buffered);
+			for(int i = 0; i < count; i++)
+			{
+				records[i].time = buffered[i].Time;
+				records[i].sequence = buffered[i].Sequence;
+				records[i].type = (unsigned short)buffered[i].Type;
+				records[i].id = (unsigned short)buffered[i].Id;
+				records[i].value = buffered[i].Value;
+			}
+			map->ApplyRecords(slot, records, (unsigned int)count, time);
+
+			if(count < buffered->Length) break;
+		}
+	}
+
+	void DIActionMap::ReadDevice(unsigned int slot, double time)
+	{
+		IInputDevice^ device = devices[slot];
+		KeyBitset bits;
+
+		// Records first, state is as new as they are or newer.
+		ReadRecords(slot, time);
+		long long values[InputMaxAxes] = { 0 };
+
+		// Keyboard has its keys as bits already.
+		IKeyboardDevice^ keyboard = dynamic_cast<IKeyboardDevice^>(device);
+		if(keyboard != nullptr)
+		{
+			keyboard->GetKeyBits(keyBits);
+			for(int i = 0; i < 8; i++) bits.words[i] = keyBits[i];
+			map->UpdateDevice(slot, bits, values, 0, time);
+			return;
+		}
+
+		device->GetState(buttons, axes);
+		bits.Clear();
+		for(unsigned int i = 0; i < InputMaxButtons; i++)
+		{
+			if(buttons[i]) bits.Set(i);
+		}
+		for(unsigned int i = 0; i < InputMaxAxes; i++) values[i] = axes[i];
+		map->UpdateDevice(slot, bits, values, InputMaxAxes, time);
+	}
+
+	void DIActionMap::Update(double time)
+	{
+		map->BeginFrame(time);
+		eventsRead = 0;
+
+		for(unsigned int i = 0; i < ActionMaxDevices; i++)
+		{
+			if(devices[i] != nullptr) ReadDevice(i, time);
+		}
+	}
+
+	bool DIActionMap::IsActive(UInt32 action)
+	{
+		return action < map->GetActionCount() && map->GetAction(action).held != 0;
+	}
+
+	float DIActionMap::GetValue(UInt32 action)
+	{
+		return action < map->GetActionCount() ? map->GetAction(action).value : 0.0f;
+	}
+
+	UInt32 DIActionMap::GetTriggerCount(UInt32 action)
+	{
+		return action < map->GetActionCount() ? map->GetAction(action).triggers : 0;
+	}
+
+	int DIActionMap::ReadEvents(array<Driver::ActionEvent>^ events)
+	{
+		const std::vector<DirectInput::ActionEvent>& fired = map->GetEvents();
+
+		int count = 0;
+		for(; count < events->Length && eventsRead < fired.size(); count++, eventsRead++)
+		{
+			const DirectInput::ActionEvent& e = fired[eventsRead];
+			events[count].Action = e.action;
+			events[count].Trigger = (ActionTrigger)e.kind;
+			events[count].Value = e.value;
+		}
+		return count;
+	}
+
+	DIActionMap::~DIActionMap()
+	{
+		delete map;
+		map = 0;
+	}
+
+}
+}
+}
+}
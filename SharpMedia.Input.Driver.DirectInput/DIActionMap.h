@@ -0,0 +1,49 @@
+#pragma once
+#include "../SharpMedia.Input.Driver.Portable/ActionMap.h"
+
+using namespace System;
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	// Native binding and event, not those of Driver.
+	using namespace Portable;
+	using Portable::ActionBinding;
+	using Portable::ActionEvent;
+
+	// Records of device read by map at once.
+	static const unsigned int ActionReadChunk = 64;
+
+	// Action map over devices of any input service. Buffered events of device are applied
+	// first, then keyboards are read as key bits and other devices through their state.
+	public ref class DIActionMap : public IActionMap
+	{
+		ActionMap* map;
+		array<IInputDevice^>^ devices;
+		array<bool>^ buttons;
+		array<Int64>^ axes;
+		array<UInt32>^ keyBits;
+		array<BufferedInputEvent>^ buffered;
+		unsigned int eventsRead;
+
+		void ReadRecords(unsigned int slot, double time);
+		void ReadDevice(unsigned int slot, double time);
+	public:
+		DIActionMap();
+		virtual int AddBinding(Driver::ActionBinding binding);
+		virtual void ClearBindings();
+		virtual void Attach(UInt32 slot, IInputDevice^ device);
+		virtual void Detach(UInt32 slot);
+		virtual void Update(double time);
+		virtual bool IsActive(UInt32 action);
+		virtual float GetValue(UInt32 action);
+		virtual UInt32 GetTriggerCount(UInt32 action);
+		virtual int ReadEvents(array<Driver::ActionEvent>^ events);
+		virtual ~DIActionMap();
+	};
+}
+}
+}
+}
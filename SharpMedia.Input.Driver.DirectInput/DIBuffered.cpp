@@ -0,0 +1,75 @@
+#include "dibuffered.h"
+
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	void DICopyRecords(const InputRecord* records, unsigned int count, array<BufferedInputEvent>^ events, int offset)
+	{
+		for(unsigned int i = 0; i < count; i++)
+		{
+			events[offset + i].Time = records[i].time;
+			events[offset + i].Sequence = records[i].sequence;
+			events[offset + i].Type = (InputEventType)records[i].type;
+			events[offset + i].Id = records[i].id;
+			events[offset + i].Value = records[i].value;
+		}
+	}
+
+	void DICopyRecords(array<BufferedInputEvent>^ events, int offset, InputRecord* records, unsigned int count)
+	{
+		for(unsigned int i = 0; i < count; i++)
+		{
+			records[i].time = events[offset + i].Time;
+			records[i].sequence = events[offset + i].Sequence;
+			records[i].type = (unsigned short)events[offset + i].Type;
+			records[i].id = (unsigned short)events[offset + i].Id;
+			records[i].value = events[offset + i].Value;
+		}
+	}
+
+	int DICopyEvents(InputEventRing* ring, array<BufferedInputEvent>^ events)
+	{
+		if(events == nullptr || events->Length == 0) return 0;
+
+		InputRecord records[DIReadChunk];
+		int total = 0;
+		while(total < events->Length)
+		{
+			unsigned int max = (unsigned int)(events->Length - total);
+			unsigned int count = ring->Pop(records, max < DIReadChunk ? max : DIReadChunk);
+			if(count == 0) break;
+
+			DICopyRecords(records, count, events, total);
+			total += (int)count;
+		}
+
+		return total;
+	}
+
+	void DICopyState(InputPoller* poller, int slot, array<bool>^ button, array<Int64>^ axis)
+	{
+		if(!poller->IsRunning()) poller->SampleSource(slot);
+
+		const InputDeviceState* state = poller->Read(slot);
+		if(!state) return;
+
+		int buttons = __min(button->Length, (int)InputMaxButtons);
+		for(int i = 0; i < buttons; i++)
+		{
+			button[i] = state->buttons[i] ? true : false;
+		}
+
+		int axes = __min(axis->Length, (int)InputMaxAxes);
+		for(int i = 0; i < axes; i++)
+		{
+			axis[i] = state->axes[i];
+		}
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <windows.h>
+#include <dinput.h>
+#include "DISources.h"
+
+using namespace System;
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	// Copies records to managed events from offset on, and back.
+	void DICopyRecords(const InputRecord* records, unsigned int count, array<BufferedInputEvent>^ events, int offset);
+	void DICopyRecords(array<BufferedInputEvent>^ events, int offset, InputRecord* records, unsigned int count);
+
+	// Copies records of ring to managed events.
+	int DICopyEvents(InputEventRing* ring, array<BufferedInputEvent>^ events);
+
+	// Copies latest state of source to managed arrays; source is sampled first when poller
+	// has no thread.
+	void DICopyState(InputPoller* poller, int slot, array<bool>^ button, array<Int64>^ axis);
+
+}
+}
+}
+}
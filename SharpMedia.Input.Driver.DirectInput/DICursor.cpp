@@ -1,4 +1,3 @@
-
 #include "dicursor.h"
 
 
@@ -7,32 +6,51 @@ namespace Input {
 namespace Driver {
 namespace DirectInput {
 
-	DICursor::DICursor(HWND hwnd)
+	DICursor::DICursor(DICursorSource* source, InputPoller* poller, Graphics::Window^ window)
 	{
-		this->hWnd = hwnd;
+		this->source = source;
+		this->poller = poller;
+		poller->AddRef();
+
+		// Sampled on poller thread when it runs, otherwise on GetState.
+		slot = poller->AddSource(source);
+		if(slot < 0)
+		{
+			poller->Release();
+			delete source;
+			throw gcnew Exception("Too many input devices.");
+		}
+
+		// Window rectangle is cached until window moves or is resized.
+		this->window = window;
+		changed = gcnew Action<Graphics::Window^>(this, &DICursor::WindowChanged);
+		window->Resized += changed;
+		window->Moved += changed;
 	}
 
-	void DICursor::GetState(array<bool>^ button, array<Int64>^ axis)
+	void DICursor::WindowChanged(Graphics::Window^ window)
 	{
-		POINT point;
-		if(!GetCursorPos(&point)) return;
-
-		// We now clamp it to relative window.
-		RECT windowRect;
-		if(!GetWindowRect(hWnd, &windowRect)) return;
+		source->Invalidate();
+	}
 
-		// We now clamp.
-		if(point.x < windowRect.left) point.x = windowRect.left;
-		if(point.y < windowRect.top) point.y =  windowRect.top;
-		if(point.x > windowRect.right) point.x = windowRect.right;
-		if(point.y > windowRect.bottom) point.y = windowRect.bottom;
+	void DICursor::GetState(array<bool>^ button, array<Int64>^ axis)
+	{
+		DICopyState(poller, slot, button, axis);
+	}
 
-		axis[0] = point.x - windowRect.left;
-		axis[1] = windowRect.bottom  - point.y;
+	int DICursor::ReadEvents(array<BufferedInputEvent>^ events)
+	{
+		// Cursor position is not buffered by system.
+		return 0;
 	}
 	
 	DICursor::~DICursor()
 	{
+		window->Resized -= changed;
+		window->Moved -= changed;
+		poller->RemoveSource(slot);
+		delete source;
+		poller->Release();
 	}
 
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <windows.h>
 #include <dinput.h>
+#include "DIBuffered.h"
 
 using namespace System;
 using namespace SharpMedia::Math;
@@ -13,10 +14,17 @@ namespace DirectInput {
 	// A direct mouse keyboard
 	public ref class DICursor : public IInputDevice
 	{
-		HWND hWnd;
+		DICursorSource* source;
+		InputPoller* poller;
+		int slot;
+		Graphics::Window^ window;
+		Action<Graphics::Window^>^ changed;
+
+		void WindowChanged(Graphics::Window^ window);
 	public:
-		DICursor(HWND hWnd);
+		DICursor(DICursorSource* source, InputPoller* poller, Graphics::Window^ window);
         virtual void GetState(array<bool>^ button, array<Int64>^ axis);
+		virtual int ReadEvents(array<BufferedInputEvent>^ events);
 		virtual ~DICursor();
 	};
 }
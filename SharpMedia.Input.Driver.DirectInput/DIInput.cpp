@@ -2,6 +2,9 @@
 #include "dimouse.h"
 #include "diinput.h"
 #include "dicursor.h"
+#include "dijoystick.h"
+#include "dibuffered.h"
+#include "diactionmap.h"
 
 namespace SharpMedia {
 namespace Input {
@@ -11,6 +14,8 @@ namespace DirectInput {
 
 	DIInput::DIInput()
 	{
+		poller = 0;
+		joysticks = 0;
 	}
 
 	void DIInput::Initialize(Graphics::Window^ window)
@@ -25,15 +30,34 @@ namespace DirectInput {
 			throw gcnew Exception("Input device creation failed.");
 		}
 		input = inp;
+		this->window = window;
 		hWnd = (HWND)window->WindowHandle.ToPointer();
 
+		// Devices are sampled on GetState until polling rate is set.
+		poller = new InputPoller(DIGetPollerClock());
+		poller->SetBackgroundRates(DIBackgroundPollingRate, DIMinimizedPollingRate);
+
+		// Focus throttles polling and lets lost devices be acquired again at once.
+		focusChanged = gcnew Action<Graphics::Window^>(this, &DIInput::FocusChanged);
+		window->Focused += focusChanged;
+		window->Minimized += focusChanged;
+		FocusChanged(window);
+
+		// Game controllers attached now; failed enumeration only leaves them out.
+		joysticks = new std::vector<DIJoystickInfo>();
+		DIEnumJoysticks(input, *joysticks);
+
 		// We also initialize descriptor.
-		desc = gcnew array<InputDeviceDescriptor^>(3);
+		desc = gcnew array<InputDeviceDescriptor^>(3 + (int)joysticks->size());
 		desc[0] = gcnew InputDeviceDescriptor(InputDeviceType::Mouse, "System Mouse", 0, 8, 3);
 		desc[1] = gcnew InputDeviceDescriptor(InputDeviceType::Keyboard, "System Keyboard", 0, 256, 0);
 		desc[2] = gcnew InputDeviceDescriptor(InputDeviceType::Cursor, "OS Cursor (for matching)", 0, 0, 2);
-
-		// TODO: add other devices
+		for(size_t i = 0; i < joysticks->size(); i++)
+		{
+			const DIJoystickInfo& info = (*joysticks)[i];
+			desc[3 + (int)i] = gcnew InputDeviceDescriptor((InputDeviceType)info.type, gcnew String(info.name), 
+				info.id, JoystickButtonCount, JoystickAxes);
+		}
 	}
 
 	String^ DIInput::Name::get()
@@ -71,11 +95,18 @@ namespace DirectInput {
 				m->Release();
 				throw gcnew Exception("Could not set cooperative level of keyboard");
 			}
+
+			// Buffered data keeps all events between polls.
+			if(!DISetBufferSize(m))
+			{
+				m->Release();
+				throw gcnew Exception("Could not set buffer size of mouse.");
+			}
 			
 			// We aquire device.
 			m->Acquire();
 
-			return gcnew DIMouse(m);
+			return gcnew DIMouse(new DIMouseSource(m, &poller->GetFocus()), poller);
 		} else if(desc->DeviceId == 0 && desc->DeviceType == InputDeviceType::Keyboard)
 		{
 			// Now we register keyboard.
@@ -98,21 +129,137 @@ namespace DirectInput {
 				key->Release();
 				throw gcnew Exception("Could not set cooperative level of keyboard");
 			}
+
+			// Buffered data keeps all events between polls.
+			if(!DISetBufferSize(key))
+			{
+				key->Release();
+				throw gcnew Exception("Could not set buffer size of keyboard.");
+			}
 			
 			// We aquire device.
 			key->Acquire();
 
-			return gcnew DIKeyboard(key);
+			return gcnew DIKeyboard(new DIKeyboardSource(key, &poller->GetFocus()), poller);
 		} else if(desc->DeviceId == 0 && desc->DeviceType == InputDeviceType::Cursor)
 		{
-			return gcnew DICursor(hWnd);
+			return gcnew DICursor(new DICursorSource(hWnd), poller, window);
+		} else if(desc->DeviceType == InputDeviceType::Joystick || desc->DeviceType == InputDeviceType::Wheel ||
+				  desc->DeviceType == InputDeviceType::Flightstick)
+		{
+			return CreateJoystick(desc);
 		}
 
 		throw gcnew NotSupportedException();
 	}
 
+	IInputDevice^ DIInput::CreateJoystick(InputDeviceDescriptor^ desc)
+	{
+		for(size_t i = 0; i < joysticks->size(); i++)
+		{
+			const DIJoystickInfo& info = (*joysticks)[i];
+			if(info.type != (unsigned int)desc->DeviceType || info.id != desc->DeviceId) continue;
+
+			IDirectInputDevice8* j;
+			if(FAILED(input->CreateDevice(info.guid, &j, NULL)))
+			{
+				throw gcnew Exception("Joystick device could not be created.");
+			}
+
+			// We set data.
+			JoystickLayout layout;
+			if(!DISetJoystickFormat(j, layout))
+			{
+				j->Release();
+				throw gcnew Exception("Could not set data format.");
+			}
+
+			// We set cooperative level; force feedback would need exclusive access.
+			if(FAILED(j->SetCooperativeLevel(hWnd, DISCL_BACKGROUND | DISCL_NONEXCLUSIVE)))
+			{
+				j->Release();
+				throw gcnew Exception("Could not set cooperative level of joystick");
+			}
+
+			// We aquire device.
+			j->Acquire();
+
+			return gcnew DIJoystick(new DIJoystickSource(j, layout, &poller->GetFocus()), poller);
+		}
+
+		throw gcnew NotSupportedException();
+	}
+
+	void DIInput::FocusChanged(Graphics::Window^ window)
+	{
+		if(window->IsMinimized) poller->GetFocus().Set(InputFocusMinimized);
+		else if(!window->HasFocus) poller->GetFocus().Set(InputFocusBackground);
+		else poller->GetFocus().Set(InputFocusForeground);
+	}
+
+	UInt32 DIInput::PollingRate::get()
+	{
+		return poller ? poller->GetRate() : 0;
+	}
+
+	void DIInput::PollingRate::set(UInt32 rate)
+	{
+		if(!poller) throw gcnew InvalidOperationException("Input service not initialized.");
+		if(rate > 8000) throw gcnew ArgumentException("Polling rate must be at most 8000 Hz.");
+
+		// Millisecond timer period is needed to sleep between samples; set while thread runs.
+		bool running = poller->IsRunning();
+		poller->Stop();
+		if(running) timeEndPeriod(1);
+		if(rate == 0) return;
+
+		timeBeginPeriod(1);
+		if(!poller->Start(rate))
+		{
+			timeEndPeriod(1);
+			throw gcnew Exception("Input polling thread could not be created.");
+		}
+	}
+
+	void DIInput::GetPollingLatency(float% median, float% p99, float% max)
+	{
+		median = p99 = max = 0.0f;
+		if(!poller) return;
+
+		const LatencyHistogram& latency = poller->GetLatency();
+		median = (float)latency.Percentile(0.5);
+		p99 = (float)latency.Percentile(0.99);
+		max = (float)latency.GetMax();
+	}
+
+	void DIInput::SetBackgroundPollingRates(UInt32 background, UInt32 minimized)
+	{
+		if(!poller) throw gcnew InvalidOperationException("Input service not initialized.");
+		poller->SetBackgroundRates(background, minimized);
+	}
+
+	IActionMap^ DIInput::CreateActionMap()
+	{
+		return gcnew DIActionMap();
+	}
+
 	DIInput::~DIInput()
 	{
+		if(focusChanged != nullptr)
+		{
+			window->Focused -= focusChanged;
+			window->Minimized -= focusChanged;
+			focusChanged = nullptr;
+		}
+		if(poller)
+		{
+			// Devices may still use poller, they release it when disposed.
+			PollingRate = 0;
+			poller->Release();
+			poller = 0;
+		}
+		delete joysticks;
+		joysticks = 0;
 		input->Release();
 	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <windows.h>
 #include <dinput.h>
+#include "DISources.h"
 
 using namespace System;
 using namespace SharpMedia::Math;
@@ -14,8 +15,15 @@ namespace DirectInput {
 	public ref class DIInput : public IInputService
 	{
 		HWND hWnd;
+		Graphics::Window^ window;
 		IDirectInput8* input;
 		array<InputDeviceDescriptor^>^ desc;
+		InputPoller* poller;
+		std::vector<DIJoystickInfo>* joysticks;
+		Action<Graphics::Window^>^ focusChanged;
+
+		IInputDevice^ CreateJoystick(InputDeviceDescriptor^ desc);
+		void FocusChanged(Graphics::Window^ window);
 	public:
 		DIInput();
 		virtual void Initialize(Graphics::Window^ window);
@@ -25,6 +33,14 @@ namespace DirectInput {
 			array<InputDeviceDescriptor^>^ get(); 
 		}
         virtual IInputDevice^ Create(InputDeviceDescriptor^ desc);
+		virtual property UInt32 PollingRate
+		{
+			UInt32 get();
+			void set(UInt32 rate);
+		}
+		virtual void GetPollingLatency(float% median, float% p99, float% max);
+		virtual void SetBackgroundPollingRates(UInt32 background, UInt32 minimized);
+		virtual IActionMap^ CreateActionMap();
 		virtual ~DIInput();
 
 	};
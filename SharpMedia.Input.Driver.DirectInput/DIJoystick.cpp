@@ -0,0 +1,93 @@
+#include "dijoystick.h"
+
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	DIJoystick::DIJoystick(DIJoystickSource* source, InputPoller* poller)
+	{
+		this->source = source;
+		this->poller = poller;
+		poller->AddRef();
+
+		// Sampled on poller thread when it runs, otherwise on GetState.
+		slot = poller->AddSource(source);
+		if(slot < 0)
+		{
+			poller->Release();
+			delete source;
+			throw gcnew Exception("Too many input devices.");
+		}
+
+		delivered = new KeyBitset();
+		delivered->Clear();
+	}
+
+	void DIJoystick::GetState(array<bool>^ button, array<Int64>^ axis)
+	{
+		if(!poller->IsRunning()) poller->SampleSource(slot);
+
+		const InputDeviceState* state = poller->Read(slot);
+		if(!state) return;
+
+		if(!Object::ReferenceEquals(button, target))
+		{
+			// Array was not written before, it gets all buttons.
+			Array::Clear(button, 0, button->Length);
+			target = button;
+			delivered->Clear();
+		}
+
+		// Only changed buttons are written.
+		unsigned char changed[JoystickButtonCount];
+		unsigned int count = KeyBitsetDiff(*delivered, state->keys, changed, JoystickButtonCount);
+		for(unsigned int i = 0; i < count; i++)
+		{
+			if(changed[i] < (unsigned int)button->Length) button[changed[i]] = state->keys.Get(changed[i]);
+		}
+		*delivered = state->keys;
+
+		int axes = __min(axis->Length, (int)JoystickAxes);
+		for(int i = 0; i < axes; i++)
+		{
+			axis[i] = state->axes[i];
+		}
+	}
+
+	int DIJoystick::ReadEvents(array<BufferedInputEvent>^ events)
+	{
+		return DICopyEvents(&source->GetRing(), events);
+	}
+
+	Driver::JoystickSettings DIJoystick::Settings::get()
+	{
+		DirectInput::JoystickSettings s = source->GetSettings();
+
+		Driver::JoystickSettings settings;
+		settings.Deadzone = (float)s.deadzone;
+		settings.Saturation = (float)s.saturation;
+		return settings;
+	}
+
+	void DIJoystick::Settings::set(Driver::JoystickSettings settings)
+	{
+		DirectInput::JoystickSettings s;
+		s.deadzone = settings.Deadzone;
+		s.saturation = settings.Saturation;
+		source->SetSettings(s);
+	}
+	
+	DIJoystick::~DIJoystick()
+	{
+		poller->RemoveSource(slot);
+		delete source;
+		delete delivered;
+		poller->Release();
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <windows.h>
+#include <dinput.h>
+#include "DIBuffered.h"
+
+using namespace System;
+using namespace SharpMedia::Math;
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	// A direct input joystick or gamepad
+	public ref class DIJoystick : public IJoystickDevice
+	{
+		DIJoystickSource* source;
+		InputPoller* poller;
+		int slot;
+
+		// Buttons last written to state array.
+		KeyBitset* delivered;
+		array<bool>^ target;
+	public:
+		DIJoystick(DIJoystickSource* source, InputPoller* poller);
+        virtual void GetState(array<bool>^ button, array<Int64>^ axis);
+		virtual int ReadEvents(array<BufferedInputEvent>^ events);
+		virtual property Driver::JoystickSettings Settings
+		{
+			Driver::JoystickSettings get();
+			void set(Driver::JoystickSettings settings);
+		}
+		virtual ~DIJoystick();
+	};
+}
+}
+}
+}
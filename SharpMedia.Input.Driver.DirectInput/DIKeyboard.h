@@ -1,6 +1,7 @@
 #pragma once
 #include <windows.h>
 #include <dinput.h>
+#include "DIBuffered.h"
 
 using namespace System;
 using namespace SharpMedia::Math;
@@ -11,17 +12,27 @@ namespace Driver {
 namespace DirectInput {
 
 	// A direct input keyboard
-	public ref class DIKeyboard : public IInputDevice
+	public ref class DIKeyboard : public IKeyboardDevice
 	{
-		IDirectInputDevice8* keyboard;
-		char* keys;
+		DIKeyboardSource* source;
+		InputPoller* poller;
+		int slot;
+
+		// Keys last written to state array and last reported as transitions, by scan code.
+		KeyBitset* delivered;
+		KeyBitset* reported;
+		array<bool>^ target;
+
+		const KeyBitset* Latest();
 	public:
-		DIKeyboard(IDirectInputDevice8* key);
-		virtual void GetState(array<bool>^ button, array<Int64>^ axis);
+		DIKeyboard(DIKeyboardSource* source, InputPoller* poller);
+        virtual void GetState(array<bool>^ button, array<Int64>^ axis);
+		virtual int ReadEvents(array<BufferedInputEvent>^ events);
+		virtual int ReadTransitions(array<KeyTransition>^ transitions);
+		virtual void GetKeyBits(array<UInt32>^ bits);
 		virtual ~DIKeyboard();
-
 	};
 }
 }
 }
-}
\ No newline at end of file
+}
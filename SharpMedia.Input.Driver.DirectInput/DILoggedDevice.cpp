@@ -0,0 +1,64 @@
+#include "diloggeddevice.h"
+
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	DILoggedDevice::DILoggedDevice(unsigned int buttonCount, unsigned int axisCount)
+	{
+		buttons = gcnew array<bool>(buttonCount);
+		axes = gcnew array<Int64>(axisCount);
+		reported = gcnew array<bool>(buttonCount);
+		settings.Sensitivity = 1.0f;
+		settings.MaxAcceleration = 1.0f;
+	}
+
+	int DILoggedDevice::ReadTransitions(array<KeyTransition>^ transitions)
+	{
+		if(transitions == nullptr) return 0;
+		GetState(buttons, axes);
+
+		// Buttons that do not fit stay unreported until next read.
+		int written = 0;
+		for(int i = 0; i < buttons->Length && written < transitions->Length; i++)
+		{
+			if(buttons[i] == reported[i]) continue;
+
+			reported[i] = buttons[i];
+			transitions[written].Key = (UInt32)i;
+			transitions[written].Pressed = buttons[i];
+			written++;
+		}
+		return written;
+	}
+
+	void DILoggedDevice::GetKeyBits(array<UInt32>^ bits)
+	{
+		if(bits == nullptr || bits->Length < 8) throw gcnew ArgumentException("Key bits need 8 words.");
+
+		Array::Clear(bits, 0, 8);
+		GetState(buttons, axes);
+
+		int count = __min(buttons->Length, 256);
+		for(int i = 0; i < count; i++)
+		{
+			if(buttons[i]) bits[i >> 5] |= 1u << (i & 31);
+		}
+	}
+
+	Driver::MouseSettings DILoggedDevice::Settings::get()
+	{
+		return settings;
+	}
+
+	void DILoggedDevice::Settings::set(Driver::MouseSettings value)
+	{
+		settings = value;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <windows.h>
+#include "DIBuffered.h"
+
+using namespace System;
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	// Device of recorder or replay. Whatever is read goes through GetState, so key transitions
+	// and key bits are taken from states and replay the same way they were recorded. Buttons
+	// of keyboards are indexed by key code, of other devices transitions report button index.
+	public ref class DILoggedDevice abstract : public IKeyboardDevice, public IMouseDevice
+	{
+		array<bool>^ buttons;
+		array<Int64>^ axes;
+		array<bool>^ reported;
+	protected:
+		Driver::MouseSettings settings;
+
+		DILoggedDevice(unsigned int buttonCount, unsigned int axisCount);
+	public:
+		virtual void GetState(array<bool>^ button, array<Int64>^ axis) abstract;
+		virtual int ReadEvents(array<BufferedInputEvent>^ events) abstract;
+		virtual int ReadTransitions(array<KeyTransition>^ transitions);
+		virtual void GetKeyBits(array<UInt32>^ bits);
+		virtual property Driver::MouseSettings Settings
+		{
+			Driver::MouseSettings get();
+			void set(Driver::MouseSettings settings);
+		}
+	};
+
+}
+}
+}
+}
@@ -1,4 +1,3 @@
-
 #include "dimouse.h"
 
 
@@ -7,49 +6,61 @@ namespace Input {
 namespace Driver {
 namespace DirectInput {
 
-	DIMouse::DIMouse(IDirectInputDevice8* m)
+	DIMouse::DIMouse(DIMouseSource* source, InputPoller* poller)
 	{
-		mouse = m;
+		this->source = source;
+		this->poller = poller;
+		poller->AddRef();
+
+		// Sampled on poller thread when it runs, otherwise on GetState.
+		slot = poller->AddSource(source);
+		if(slot < 0)
+		{
+			poller->Release();
+			delete source;
+			throw gcnew Exception("Too many input devices.");
+		}
 	}
 
 	void DIMouse::GetState(array<bool>^ button, array<Int64>^ axis)
 	{
-		DIMOUSESTATE2 state2;
-
-		// We get state.
-		if(FAILED(mouse->GetDeviceState(sizeof(state2), &state2)))
-		{
-			// We must acquire it.
-			if(FAILED(mouse->Acquire()))
-			{
-				return;
-			}
-
-			if(FAILED(mouse->GetDeviceState(sizeof(state2), &state2)))
-			{
-				throw gcnew Exception("Input could not be aquired.");
-			}
-		}
+		DICopyState(poller, slot, button, axis);
+	}
 
-		// We have valid date, we copy it to our array (arrays match).
-		for(int i = 0; i < 8; i++)
-		{
-			button[i] = (state2.rgbButtons[i] & 0x80) ? true : false;
-		}
+	int DIMouse::ReadEvents(array<BufferedInputEvent>^ events)
+	{
+		return DICopyEvents(&source->GetRing(), events);
+	}
+	
+	Driver::MouseSettings DIMouse::Settings::get()
+	{
+		DirectInput::MouseSettings s = source->GetSettings();
 
-		axis[0] = axis1 + state2.lX;
-		axis[1] = axis2 + state2.lY;
-		axis[2] = axis3 + state2.lZ;
+		Driver::MouseSettings settings;
+		settings.Sensitivity = (float)s.sensitivity;
+		settings.AccelerationThreshold = (float)s.accelThreshold;
+		settings.AccelerationExponent = (float)s.accelExponent;
+		settings.MaxAcceleration = (float)s.accelMaxGain;
+		settings.Smoothing = (float)s.smoothing;
+		return settings;
+	}
 
-		axis1 += state2.lX;
-		axis2 += state2.lY;
-		axis3 += state2.lZ;
+	void DIMouse::Settings::set(Driver::MouseSettings settings)
+	{
+		DirectInput::MouseSettings s;
+		s.sensitivity = settings.Sensitivity;
+		s.accelThreshold = settings.AccelerationThreshold;
+		s.accelExponent = settings.AccelerationExponent;
+		s.accelMaxGain = settings.MaxAcceleration;
+		s.smoothing = settings.Smoothing;
+		source->SetSettings(s);
 	}
 	
 	DIMouse::~DIMouse()
 	{
-		mouse->Unacquire();
-		mouse->Release();
+		poller->RemoveSource(slot);
+		delete source;
+		poller->Release();
 	}
 
 }
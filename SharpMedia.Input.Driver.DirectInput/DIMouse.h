@@ -1,6 +1,7 @@
 #pragma once
 #include <windows.h>
 #include <dinput.h>
+#include "DIBuffered.h"
 
 using namespace System;
 using namespace SharpMedia::Math;
@@ -11,13 +12,20 @@ namespace Driver {
 namespace DirectInput {
 
 	// A direct mouse keyboard
-	public ref class DIMouse : public IInputDevice
+	public ref class DIMouse : public IMouseDevice
 	{
-		IDirectInputDevice8* mouse;
-		UInt64 axis1, axis2, axis3;
+		DIMouseSource* source;
+		InputPoller* poller;
+		int slot;
 	public:
-		DIMouse(IDirectInputDevice8* key);
+		DIMouse(DIMouseSource* source, InputPoller* poller);
         virtual void GetState(array<bool>^ button, array<Int64>^ axis);
+		virtual int ReadEvents(array<BufferedInputEvent>^ events);
+		virtual property Driver::MouseSettings Settings
+		{
+			Driver::MouseSettings get();
+			void set(Driver::MouseSettings settings);
+		}
 		virtual ~DIMouse();
 	};
 }
@@ -0,0 +1,218 @@
+#include "direcorder.h"
+#include "diactionmap.h"
+#include <cstring>
+#include <vector>
+
+using namespace System::Threading;
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	DIRecordingDevice::DIRecordingDevice(DIRecorder^ recorder, IInputDevice^ device, int index,
+										 unsigned int buttonCount, unsigned int axisCount)
+		: DILoggedDevice(buttonCount, axisCount)
+	{
+		this->recorder = recorder;
+		this->device = device;
+		this->index = index;
+	}
+
+	void DIRecordingDevice::GetState(array<bool>^ button, array<Int64>^ axis)
+	{
+		device->GetState(button, axis);
+		recorder->WriteState(index, button, axis);
+	}
+
+	int DIRecordingDevice::ReadEvents(array<BufferedInputEvent>^ events)
+	{
+		int count = device->ReadEvents(events);
+		recorder->WriteEvents(index, events, count);
+		return count;
+	}
+
+	Driver::MouseSettings DIRecordingDevice::Settings::get()
+	{
+		// Motion is logged after settings are applied, replay needs none of them.
+		IMouseDevice^ mouse = dynamic_cast<IMouseDevice^>(device);
+		return mouse != nullptr ? mouse->Settings : settings;
+	}
+
+	void DIRecordingDevice::Settings::set(Driver::MouseSettings value)
+	{
+		IMouseDevice^ mouse = dynamic_cast<IMouseDevice^>(device);
+		if(mouse == nullptr) throw gcnew NotSupportedException("Device is not a mouse.");
+		mouse->Settings = value;
+	}
+
+	DIRecordingDevice::~DIRecordingDevice()
+	{
+		delete device;
+	}
+
+	DIRecorder::DIRecorder(IInputService^ service)
+	{
+		if(service == nullptr) throw gcnew ArgumentNullException("service");
+
+		this->service = service;
+		writer = new InputLogWriter();
+	}
+
+	void DIRecorder::Initialize(Graphics::Window^ window)
+	{
+		service->Initialize(window);
+	}
+
+	String^ DIRecorder::Name::get()
+	{
+		return String::Concat("Recording ", service->Name);
+	}
+
+	array<InputDeviceDescriptor^>^ DIRecorder::SupportedDevices::get()
+	{
+		return service->SupportedDevices;
+	}
+
+	IInputDevice^ DIRecorder::Create(InputDeviceDescriptor^ desc)
+	{
+		IInputDevice^ device = service->Create(desc);
+
+		Monitor::Enter(this);
+		try
+		{
+			InputLogDeviceInfo info;
+			info.type = (unsigned int)desc->DeviceType;
+			info.id = desc->DeviceId;
+			info.buttons = desc->ButtonCount;
+			info.axes = desc->AxisCount;
+
+			int index = writer ? writer->AddDevice(info) : -1;
+			if(index < 0)
+			{
+				delete device;
+				throw gcnew NotSupportedException("Device can not be recorded.");
+			}
+
+			return gcnew DIRecordingDevice(this, device, index, desc->ButtonCount, desc->AxisCount);
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+	}
+
+	void DIRecorder::WriteState(int device, array<bool>^ button, array<Int64>^ axis)
+	{
+		Monitor::Enter(this);
+		try
+		{
+			if(!writer) return;
+			const InputLogDeviceInfo& info = writer->GetDeviceInfo(device);
+
+			// Arrays may be shorter than descriptor; missing buttons and axes are zero.
+			std::vector<unsigned char> buttons(info.buttons + 1, 0);
+			std::vector<long long> axes(info.axes + 1, 0);
+
+			int buttonCount = __min(button->Length, (int)info.buttons);
+			for(int i = 0; i < buttonCount; i++) buttons[i] = button[i] ? 1 : 0;
+
+			int axisCount = __min(axis->Length, (int)info.axes);
+			for(int i = 0; i < axisCount; i++) axes[i] = axis[i];
+
+			writer->WriteState(device, DIGetPollerClock()->Now(), &buttons[0], &axes[0]);
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+	}
+
+	void DIRecorder::WriteEvents(int device, array<BufferedInputEvent>^ events, int count)
+	{
+		if(count <= 0) return;
+
+		std::vector<InputRecord> records(count);
+		DICopyRecords(events, 0, &records[0], count);
+
+		Monitor::Enter(this);
+		try
+		{
+			if(writer) writer->WriteEvents(device, DIGetPollerClock()->Now(), &records[0], count);
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+	}
+
+	UInt32 DIRecorder::PollingRate::get()
+	{
+		return service->PollingRate;
+	}
+
+	void DIRecorder::PollingRate::set(UInt32 rate)
+	{
+		service->PollingRate = rate;
+	}
+
+	void DIRecorder::GetPollingLatency(float% median, float% p99, float% max)
+	{
+		service->GetPollingLatency(median, p99, max);
+	}
+
+	void DIRecorder::SetBackgroundPollingRates(UInt32 background, UInt32 minimized)
+	{
+		service->SetBackgroundPollingRates(background, minimized);
+	}
+
+	IActionMap^ DIRecorder::CreateActionMap()
+	{
+		// Map reads recording devices, so what it sees is logged.
+		return gcnew DIActionMap();
+	}
+
+	array<Byte>^ DIRecorder::GetLog()
+	{
+		Monitor::Enter(this);
+		try
+		{
+			if(!writer) throw gcnew ObjectDisposedException("DIRecorder");
+
+			array<Byte>^ log = gcnew array<Byte>((int)writer->GetSize());
+			pin_ptr<Byte> p = &log[0];
+			memcpy(p, writer->GetData(), writer->GetSize());
+			return log;
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+	}
+
+	void DIRecorder::Save(Stream^ stream)
+	{
+		array<Byte>^ log = GetLog();
+		stream->Write(log, 0, log->Length);
+	}
+
+	DIRecorder::~DIRecorder()
+	{
+		// Devices may still be alive, they stop logging.
+		Monitor::Enter(this);
+		try
+		{
+			delete writer;
+			writer = 0;
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+		delete service;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <windows.h>
+#include "DILoggedDevice.h"
+#include "../SharpMedia.Input.Driver.Portable/InputLog.h"
+
+using namespace System;
+using namespace System::IO;
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	ref class DIRecorder;
+
+	// Device of recorder; reads device of recorded service and logs what it returned.
+	public ref class DIRecordingDevice : public DILoggedDevice
+	{
+		DIRecorder^ recorder;
+		IInputDevice^ device;
+		int index;
+	public:
+		DIRecordingDevice(DIRecorder^ recorder, IInputDevice^ device, int index,
+						  unsigned int buttonCount, unsigned int axisCount);
+		virtual void GetState(array<bool>^ button, array<Int64>^ axis) override;
+		virtual int ReadEvents(array<BufferedInputEvent>^ events) override;
+		virtual property Driver::MouseSettings Settings
+		{
+			Driver::MouseSettings get() override;
+			void set(Driver::MouseSettings settings) override;
+		}
+		virtual ~DIRecordingDevice();
+	};
+
+	// Input service that records all input of another service to a log, which DIReplay plays
+	// back. States are logged as changes against previous state of device, so idle devices
+	// cost almost nothing.
+	public ref class DIRecorder : public IInputService
+	{
+		IInputService^ service;
+		InputLogWriter* writer;
+	internal:
+		void WriteState(int device, array<bool>^ button, array<Int64>^ axis);
+		void WriteEvents(int device, array<BufferedInputEvent>^ events, int count);
+	public:
+		DIRecorder(IInputService^ service);
+		virtual void Initialize(Graphics::Window^ window);
+		virtual property String^ Name { String^ get(); }
+        virtual property array<InputDeviceDescriptor^>^ SupportedDevices 
+		{ 
+			array<InputDeviceDescriptor^>^ get(); 
+		}
+        virtual IInputDevice^ Create(InputDeviceDescriptor^ desc);
+		virtual property UInt32 PollingRate
+		{
+			UInt32 get();
+			void set(UInt32 rate);
+		}
+		virtual void GetPollingLatency(float% median, float% p99, float% max);
+		virtual void SetBackgroundPollingRates(UInt32 background, UInt32 minimized);
+		virtual IActionMap^ CreateActionMap();
+
+		// Log recorded so far.
+		array<Byte>^ GetLog();
+		void Save(Stream^ stream);
+
+		virtual ~DIRecorder();
+	};
+}
+}
+}
+}
@@ -0,0 +1,233 @@
+#include "direplay.h"
+#include "diactionmap.h"
+
+using namespace System::Threading;
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	DIReplayDevice::DIReplayDevice(DIReplay^ replay, int index, unsigned int buttonCount, unsigned int axisCount)
+		: DILoggedDevice(buttonCount, axisCount)
+	{
+		this->replay = replay;
+		this->index = index;
+	}
+
+	void DIReplayDevice::GetState(array<bool>^ button, array<Int64>^ axis)
+	{
+		replay->GetState(index, button, axis);
+	}
+
+	int DIReplayDevice::ReadEvents(array<BufferedInputEvent>^ events)
+	{
+		return replay->ReadEvents(index, events);
+	}
+
+	DIReplay::DIReplay(array<Byte>^ log)
+	{
+		Load(log);
+	}
+
+	DIReplay::DIReplay(Stream^ stream)
+	{
+		if(stream == nullptr) throw gcnew ArgumentNullException("stream");
+
+		MemoryStream^ memory = gcnew MemoryStream();
+		array<Byte>^ buffer = gcnew array<Byte>(4096);
+		for(int read; (read = stream->Read(buffer, 0, buffer->Length)) > 0; )
+		{
+			memory->Write(buffer, 0, read);
+		}
+		Load(memory->ToArray());
+	}
+
+	void DIReplay::Load(array<Byte>^ log)
+	{
+		if(log == nullptr) throw gcnew ArgumentNullException("log");
+
+		if(log->Length == 0)
+		{
+			session = new InputReplaySession(DIGetPollerClock(), 0, 0);
+		} else {
+			pin_ptr<Byte> p = &log[0];
+			session = new InputReplaySession(DIGetPollerClock(), p, log->Length);
+		}
+
+		if(!session->IsValid())
+		{
+			delete session;
+			session = 0;
+			throw gcnew ArgumentException("Data is not an input log.");
+		}
+
+		desc = gcnew array<InputDeviceDescriptor^>(session->GetDeviceCount());
+		for(unsigned int i = 0; i < session->GetDeviceCount(); i++)
+		{
+			const InputLogDeviceInfo& info = session->GetDeviceInfo(i);
+			InputDeviceType type = (InputDeviceType)info.type;
+			desc[i] = gcnew InputDeviceDescriptor(type, String::Format("Replayed {0} {1}", type, info.id),
+				info.id, info.buttons, info.axes);
+		}
+	}
+
+	void DIReplay::Initialize(Graphics::Window^ window)
+	{
+		Rewind();
+	}
+
+	String^ DIReplay::Name::get()
+	{
+		return gcnew String("Input Replay");
+	}
+
+	array<InputDeviceDescriptor^>^ DIReplay::SupportedDevices::get()
+	{
+		return desc;
+	}
+
+	IInputDevice^ DIReplay::Create(InputDeviceDescriptor^ d)
+	{
+		int index = session->FindDevice((unsigned int)d->DeviceType, d->DeviceId);
+		if(index < 0) throw gcnew NotSupportedException();
+
+		const InputLogDeviceInfo& info = session->GetDeviceInfo(index);
+		return gcnew DIReplayDevice(this, index, info.buttons, info.axes);
+	}
+
+	void DIReplay::GetState(int device, array<bool>^ button, array<Int64>^ axis)
+	{
+		Monitor::Enter(this);
+		try
+		{
+			if(!session) throw gcnew ObjectDisposedException("DIReplay");
+
+			const InputLogDeviceState& state = session->ReadState(device);
+
+			int buttons = __min(button->Length, (int)state.buttons.size());
+			for(int i = 0; i < buttons; i++)
+			{
+				button[i] = state.buttons[i] != 0;
+			}
+
+			int axes = __min(axis->Length, (int)state.axes.size());
+			for(int i = 0; i < axes; i++)
+			{
+				axis[i] = state.axes[i];
+			}
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+	}
+
+	int DIReplay::ReadEvents(int device, array<BufferedInputEvent>^ events)
+	{
+		if(events == nullptr || events->Length == 0) return 0;
+
+		InputRecord records[DIReadChunk];
+		int total = 0;
+
+		Monitor::Enter(this);
+		try
+		{
+			if(!session) throw gcnew ObjectDisposedException("DIReplay");
+
+			while(total < events->Length)
+			{
+				unsigned int max = (unsigned int)(events->Length - total);
+				unsigned int count = session->ReadEvents(device, records, max < DIReadChunk ? max : DIReadChunk);
+				if(count == 0) break;
+
+				DICopyRecords(records, count, events, total);
+				total += (int)count;
+			}
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+		return total;
+	}
+
+	UInt32 DIReplay::PollingRate::get()
+	{
+		return 0;
+	}
+
+	void DIReplay::PollingRate::set(UInt32 rate)
+	{
+		// Replayed states do not depend on sampling.
+	}
+
+	void DIReplay::GetPollingLatency(float% median, float% p99, float% max)
+	{
+		median = p99 = max = 0.0f;
+	}
+
+	void DIReplay::SetBackgroundPollingRates(UInt32 background, UInt32 minimized)
+	{
+		// Replay does not poll.
+	}
+
+	IActionMap^ DIReplay::CreateActionMap()
+	{
+		return gcnew DIActionMap();
+	}
+
+	bool DIReplay::RealTime::get()
+	{
+		return session && session->IsRealTime();
+	}
+
+	void DIReplay::RealTime::set(bool value)
+	{
+		Monitor::Enter(this);
+		try
+		{
+			if(session) session->SetRealTime(value);
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+	}
+
+	bool DIReplay::IsFinished::get()
+	{
+		return !session || session->IsFinished();
+	}
+
+	void DIReplay::Rewind()
+	{
+		Monitor::Enter(this);
+		try
+		{
+			if(session) session->Rewind();
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+	}
+
+	DIReplay::~DIReplay()
+	{
+		Monitor::Enter(this);
+		try
+		{
+			delete session;
+			session = 0;
+		}
+		finally
+		{
+			Monitor::Exit(this);
+		}
+	}
+
+}
+}
+}
+}
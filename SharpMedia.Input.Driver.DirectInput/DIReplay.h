@@ -0,0 +1,74 @@
+#pragma once
+#include <windows.h>
+#include "DILoggedDevice.h"
+#include "../SharpMedia.Input.Driver.Portable/InputReplay.h"
+
+using namespace System;
+using namespace System::IO;
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	ref class DIReplay;
+
+	// Device of replay; returns states and events of log.
+	public ref class DIReplayDevice : public DILoggedDevice
+	{
+		DIReplay^ replay;
+		int index;
+	public:
+		DIReplayDevice(DIReplay^ replay, int index, unsigned int buttonCount, unsigned int axisCount);
+		virtual void GetState(array<bool>^ button, array<Int64>^ axis) override;
+		virtual int ReadEvents(array<BufferedInputEvent>^ events) override;
+	};
+
+	// Input service that plays back log of DIRecorder. It needs no window or devices, so
+	// recorded scenarios run the same way on every machine; see InputReplaySession.
+	public ref class DIReplay : public IInputService
+	{
+		InputReplaySession* session;
+		array<InputDeviceDescriptor^>^ desc;
+	internal:
+		void GetState(int device, array<bool>^ button, array<Int64>^ axis);
+		int ReadEvents(int device, array<BufferedInputEvent>^ events);
+	public:
+		DIReplay(array<Byte>^ log);
+		DIReplay(Stream^ stream);
+		virtual void Initialize(Graphics::Window^ window);
+		virtual property String^ Name { String^ get(); }
+        virtual property array<InputDeviceDescriptor^>^ SupportedDevices 
+		{ 
+			array<InputDeviceDescriptor^>^ get(); 
+		}
+        virtual IInputDevice^ Create(InputDeviceDescriptor^ desc);
+		virtual property UInt32 PollingRate
+		{
+			UInt32 get();
+			void set(UInt32 rate);
+		}
+		virtual void GetPollingLatency(float% median, float% p99, float% max);
+		virtual void SetBackgroundPollingRates(UInt32 background, UInt32 minimized);
+		virtual IActionMap^ CreateActionMap();
+
+		property bool RealTime
+		{
+			bool get();
+			void set(bool realTime);
+		}
+
+		// Whole log was played.
+		property bool IsFinished { bool get(); }
+
+		// Plays log again from beginning.
+		void Rewind();
+
+		virtual ~DIReplay();
+	private:
+		void Load(array<Byte>^ log);
+	};
+}
+}
+}
+}
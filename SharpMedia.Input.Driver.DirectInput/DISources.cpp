@@ -0,0 +1,662 @@
+#include "DISources.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	bool DISetBufferSize(IDirectInputDevice8* device)
+	{
+		DIPROPDWORD prop;
+		prop.diph.dwSize = sizeof(DIPROPDWORD);
+		prop.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+		prop.diph.dwObj = 0;
+		prop.diph.dwHow = DIPH_DEVICE;
+		prop.dwData = DIBufferSize;
+
+		return SUCCEEDED(device->SetProperty(DIPROP_BUFFERSIZE, &prop.diph));
+	}
+
+	class DIPollerClock : public PollerClock
+	{
+		double period;
+	public:
+		DIPollerClock()
+		{
+			LARGE_INTEGER frequency;
+			QueryPerformanceFrequency(&frequency);
+			period = 1.0 / (double)frequency.QuadPart;
+		}
+
+		virtual double Now()
+		{
+			LARGE_INTEGER counter;
+			QueryPerformanceCounter(&counter);
+			return (double)counter.QuadPart * period;
+		}
+
+		virtual void SleepUntil(double time)
+		{
+			// Sleep may take up to a timer period longer, last part is yielded.
+			for(double now = Now(); now < time; now = Now())
+			{
+				if(time - now > 0.002) Sleep(1);
+				else SwitchToThread();
+			}
+		}
+	};
+
+	PollerClock* DIGetPollerClock()
+	{
+		static DIPollerClock clock;
+		return &clock;
+	}
+
+	bool DIAcquire(IDirectInputDevice8* device, DeviceAcquisition& acquisition, InputFocusState* focus)
+	{
+		if(acquisition.IsAcquired()) return true;
+
+		double now = DIGetPollerClock()->Now();
+		if(!acquisition.ShouldAttempt(now, focus->GetGained())) return false;
+
+		if(FAILED(device->Acquire()))
+		{
+			acquisition.Failed(now);
+			return false;
+		}
+		acquisition.Acquired();
+		return true;
+	}
+
+	DIMouseSource::DIMouseSource(IDirectInputDevice8* mouse, InputFocusState* focus)
+		: ring(DIRingSize)
+	{
+		this->mouse = mouse;
+		this->focus = focus;
+		this->settings = MouseAccumulator::DefaultSettings();
+		this->settingsChanged = 0;
+	}
+
+	DIMouseSource::~DIMouseSource()
+	{
+		mouse->Unacquire();
+		mouse->Release();
+	}
+
+	void DIMouseSource::SetSettings(const MouseSettings& s)
+	{
+		settingsLock.Lock();
+		settings = s;
+		AtomicStore(&settingsChanged, 1);
+		settingsLock.Unlock();
+	}
+
+	MouseSettings DIMouseSource::GetSettings()
+	{
+		settingsLock.Lock();
+		MouseSettings s = settings;
+		settingsLock.Unlock();
+		return s;
+	}
+
+	void DIMouseSource::ReadBuffered()
+	{
+		DIDEVICEOBJECTDATA data[DIReadChunk];
+
+		// Axes of one report share sequence number; they are accumulated together.
+		int motion[MouseAxes] = { 0, 0, 0 };
+		DWORD motionSequence = 0, motionTime = 0;
+		bool hasMotion = false;
+
+		for(;;)
+		{
+			DWORD count = DIReadChunk;
+			if(FAILED(mouse->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), data, &count, 0))) break;
+
+			for(DWORD i = 0; i < count; i++)
+			{
+				InputRecord record;
+				record.time = data[i].dwTimeStamp;
+				record.sequence = data[i].dwSequence;
+
+				DWORD ofs = data[i].dwOfs;
+				if(ofs == DIMOFS_X || ofs == DIMOFS_Y || ofs == DIMOFS_Z)
+				{
+					record.type = InputRecordAxis;
+					record.id = ofs == DIMOFS_X ? 0 : (ofs == DIMOFS_Y ? 1 : 2);
+					record.value = (int)data[i].dwData;
+
+					if(hasMotion && record.sequence != motionSequence)
+					{
+						accumulator.AddMotion(motion, motionTime);
+						motion[0] = motion[1] = motion[2] = 0;
+					}
+					motion[record.id] += record.value;
+					motionSequence = record.sequence;
+					motionTime = record.time;
+					hasMotion = true;
+				} else if(ofs >= DIMOFS_BUTTON0 && ofs <= DIMOFS_BUTTON7) {
+					record.type = InputRecordButton;
+					record.id = (unsigned short)(ofs - DIMOFS_BUTTON0);
+					record.value = (data[i].dwData & 0x80) ? 1 : 0;
+				} else {
+					continue;
+				}
+				coalescer.Add(record);
+			}
+
+			if(count < DIReadChunk) break;
+		}
+
+		if(hasMotion) accumulator.AddMotion(motion, motionTime);
+		coalescer.Flush(ring);
+	}
+
+	bool DIMouseSource::Sample(InputDeviceState& state)
+	{
+		DIMOUSESTATE2 state2;
+
+		if(AtomicLoad(&settingsChanged))
+		{
+			settingsLock.Lock();
+			accumulator.SetSettings(settings);
+			AtomicStore(&settingsChanged, 0);
+			settingsLock.Unlock();
+		}
+
+		// Lost device is not touched until it may be acquired again.
+		if(!DIAcquire(mouse, acquisition, focus)) return false;
+
+		// Events since last sample, state below is only last one.
+		ReadBuffered();
+		accumulator.Step();
+
+		// We get state.
+		if(FAILED(mouse->GetDeviceState(sizeof(state2), &state2)))
+		{
+			// We must acquire it.
+			acquisition.Lost();
+			if(!DIAcquire(mouse, acquisition, focus) ||
+			   FAILED(mouse->GetDeviceState(sizeof(state2), &state2)))
+			{
+				return false;
+			}
+		}
+
+		memset(state.buttons, 0, sizeof(state.buttons));
+		memset(state.axes, 0, sizeof(state.axes));
+		for(int i = 0; i < 8; i++)
+		{
+			state.buttons[i] = (state2.rgbButtons[i] & 0x80) ? 1 : 0;
+		}
+
+		// Relative state only repeats buffered deltas, axes come from accumulator.
+		for(unsigned int i = 0; i < MouseAxes; i++)
+		{
+			state.axes[i] = accumulator.GetAxis(i);
+		}
+		return true;
+	}
+
+	static int KeyMapper[256] = 
+	{
+		0,
+		DIK_0,
+		DIK_1,
+		DIK_2,
+		DIK_3,
+		DIK_4,
+		DIK_5,
+		DIK_6,
+		DIK_7,
+		DIK_8,
+		DIK_9,
+		DIK_A,
+		DIK_ABNT_C1,
+		DIK_ABNT_C2,
+		DIK_ADD,
+        DIK_APOSTROPHE,
+        DIK_APPS,
+        DIK_AT,
+        DIK_AX,
+        DIK_B,
+        DIK_BACK,
+        DIK_BACKSLASH,
+        DIK_C,
+        DIK_CALCULATOR,
+        DIK_CAPITAL,
+        DIK_COLON,
+		DIK_COMMA,
+        DIK_CONVERT,
+        DIK_D,
+        DIK_DECIMAL,
+        DIK_DELETE,
+        DIK_DIVIDE,
+        DIK_DOWN,
+        DIK_E,
+        DIK_END,
+        DIK_EQUALS,
+        DIK_ESCAPE,
+        DIK_F,
+        DIK_F1,
+        DIK_F2,
+        DIK_F3,
+        DIK_F4,
+        DIK_F5,
+        DIK_F6,
+        DIK_F7,
+        DIK_F8,
+        DIK_F9,
+        DIK_F10,
+        DIK_F11,
+        DIK_F12,
+        DIK_F13,
+        DIK_F14,
+        DIK_F15,
+        DIK_G,
+        DIK_GRAVE,
+        DIK_H,
+        DIK_HOME,
+        DIK_I,
+        DIK_INSERT,
+        DIK_J,
+        DIK_K,
+        DIK_KANA,
+        DIK_KANJI,
+        DIK_L,
+        DIK_LBRACKET,
+        DIK_LCONTROL,
+        DIK_LEFT,
+        DIK_LMENU,
+        DIK_LSHIFT,
+        DIK_LWIN,
+        DIK_M,
+        DIK_MAIL,
+        DIK_MEDIASELECT,
+        DIK_MEDIASTOP,
+        DIK_MINUS,
+        DIK_MULTIPLY,
+        DIK_MUTE,
+        DIK_MYCOMPUTER,
+        DIK_N,
+        DIK_NEXT,
+        DIK_NEXTTRACK,
+        DIK_NOCONVERT,
+        DIK_NUMLOCK,
+        DIK_NUMPAD0,
+        DIK_NUMPAD1,
+        DIK_NUMPAD2,
+        DIK_NUMPAD3,
+        DIK_NUMPAD4,
+        DIK_NUMPAD5,
+        DIK_NUMPAD6,
+        DIK_NUMPAD7,
+        DIK_NUMPAD8,
+        DIK_NUMPAD9,
+        DIK_NUMPADCOMMA,
+        DIK_NUMPADENTER,
+        DIK_NUMPADEQUALS,
+        DIK_O,
+        DIK_OEM_102,
+        DIK_P,
+        DIK_PAUSE,
+        DIK_PERIOD,
+        DIK_PLAYPAUSE,
+        DIK_POWER,
+        DIK_PREVTRACK,
+        DIK_PRIOR,
+        DIK_Q,
+        DIK_R,
+        DIK_RBRACKET,
+        DIK_RCONTROL,
+        DIK_RETURN,
+        DIK_RIGHT,
+        DIK_RMENU,
+        DIK_RSHIFT,
+        DIK_RWIN,
+        DIK_S,
+        DIK_SCROLL,
+        DIK_SEMICOLON,
+        DIK_SLASH,
+        DIK_SLEEP,
+        DIK_SPACE,
+        DIK_STOP,
+        DIK_SUBTRACT,
+        DIK_SYSRQ,
+        DIK_T,
+        DIK_TAB,
+        DIK_U,
+        DIK_UNDERLINE,
+        DIK_UNLABELED,
+        DIK_UP,
+        DIK_V,
+        DIK_VOLUMEDOWN,
+        DIK_VOLUMEUP,
+        DIK_W,
+        DIK_WAKE,
+        DIK_WEBBACK,
+        DIK_WEBFAVORITES,
+        DIK_WEBFORWARD,
+        DIK_WEBHOME,
+        DIK_WEBREFRESH,
+        DIK_WEBSEARCH,
+        DIK_WEBSTOP,
+        DIK_X,
+        DIK_Y,
+        DIK_YEN,
+		DIK_Z
+	};
+
+	DIKeyboardSource::DIKeyboardSource(IDirectInputDevice8* keyboard, InputFocusState* focus)
+		: ring(DIRingSize)
+	{
+		this->keyboard = keyboard;
+		this->focus = focus;
+
+		// Buffered data reports DIK codes; 0 marks codes without key.
+		for(int i = 0; i < 256; i++) keyIndex[i] = 0;
+		for(int i = 1; i < 256; i++)
+		{
+			if(KeyMapper[i]) keyIndex[KeyMapper[i] & 0xFF] = (unsigned short)i;
+		}
+	}
+
+	DIKeyboardSource::~DIKeyboardSource()
+	{
+		keyboard->Unacquire();
+		keyboard->Release();
+	}
+
+	void DIKeyboardSource::ReadBuffered()
+	{
+		DIDEVICEOBJECTDATA data[DIReadChunk];
+		for(;;)
+		{
+			DWORD count = DIReadChunk;
+			if(FAILED(keyboard->GetDeviceData(sizeof(DIDEVICEOBJECTDATA), data, &count, 0))) break;
+
+			for(DWORD i = 0; i < count; i++)
+			{
+				unsigned short index = keyIndex[data[i].dwOfs & 0xFF];
+				if(!index) continue;
+
+				InputRecord record;
+				record.time = data[i].dwTimeStamp;
+				record.sequence = data[i].dwSequence;
+				record.type = InputRecordButton;
+				record.id = index;
+				record.value = (data[i].dwData & 0x80) ? 1 : 0;
+				coalescer.Add(record);
+			}
+
+			if(count < DIReadChunk) break;
+		}
+
+		coalescer.Flush(ring);
+	}
+
+	bool DIKeyboardSource::Sample(InputDeviceState& state)
+	{
+		unsigned char keys[256];
+
+		// Lost device is not touched until it may be acquired again.
+		if(!DIAcquire(keyboard, acquisition, focus)) return false;
+
+		// Events since last sample, state below is only last one.
+		ReadBuffered();
+
+		// We get state.
+		if(FAILED(keyboard->GetDeviceState(256, keys)))
+		{
+			// We must acquire it.
+			acquisition.Lost();
+			if(!DIAcquire(keyboard, acquisition, focus) ||
+			   FAILED(keyboard->GetDeviceState(256, keys)))
+			{
+				return false;
+			}
+		}
+
+		// Kept by scan code, only changed keys are mapped to key codes when read.
+		KeyBitsetFromBytes(keys, state.keys);
+		return true;
+	}
+
+	static BOOL CALLBACK DIEnumJoystick(LPCDIDEVICEINSTANCE instance, LPVOID param)
+	{
+		std::vector<DIJoystickInfo>& joysticks = *(std::vector<DIJoystickInfo>*)param;
+
+		// Input device types of SharpMedia.
+		unsigned int type;
+		switch(GET_DIDEVICE_TYPE(instance->dwDevType))
+		{
+		case DI8DEVTYPE_DRIVING:
+			type = 8;
+			break;
+		case DI8DEVTYPE_FLIGHT:
+			type = 16;
+			break;
+		default:
+			type = 4;
+			break;
+		}
+
+		DIJoystickInfo info;
+		info.guid = instance->guidInstance;
+		info.type = type;
+		info.id = 0;
+		for(size_t i = 0; i < joysticks.size(); i++)
+		{
+			if(joysticks[i].type == type) info.id++;
+		}
+		memcpy(info.name, instance->tszProductName, sizeof(info.name));
+		info.name[MAX_PATH - 1] = 0;
+
+		joysticks.push_back(info);
+		return DIENUM_CONTINUE;
+	}
+
+	bool DIEnumJoysticks(IDirectInput8* input, std::vector<DIJoystickInfo>& joysticks)
+	{
+		joysticks.clear();
+		return SUCCEEDED(input->EnumDevices(DI8DEVCLASS_GAMECTRL, DIEnumJoystick, &joysticks, DIEDFL_ATTACHEDONLY));
+	}
+
+	static BOOL CALLBACK DIEnumJoystickAxis(LPCDIDEVICEOBJECTINSTANCE object, LPVOID param)
+	{
+		unsigned short* usages = (unsigned short*)param;
+
+		// Axes of format are consecutive longs of DIJOYSTATE2 from lX.
+		unsigned int axis = object->dwOfs / sizeof(LONG);
+		if(object->dwOfs % sizeof(LONG) != 0 || axis >= JoystickAxes) return DIENUM_CONTINUE;
+
+		unsigned short usage = object->wUsagePage == JoystickUsagePage ? object->wUsage : 0;
+
+		// Devices that are not HID have no usage, only type of axis.
+		if(usage == 0)
+		{
+			if(object->guidType == GUID_XAxis) usage = JoystickUsageX;
+			else if(object->guidType == GUID_YAxis) usage = JoystickUsageY;
+			else if(object->guidType == GUID_ZAxis) usage = JoystickUsageZ;
+			else if(object->guidType == GUID_RxAxis) usage = JoystickUsageRx;
+			else if(object->guidType == GUID_RyAxis) usage = JoystickUsageRy;
+			else if(object->guidType == GUID_RzAxis) usage = JoystickUsageRz;
+			else usage = JoystickUsageSlider;
+		}
+
+		usages[axis] = usage;
+		return DIENUM_CONTINUE;
+	}
+
+	bool DISetJoystickFormat(IDirectInputDevice8* device, JoystickLayout& layout)
+	{
+		if(FAILED(device->SetDataFormat(&c_dfDIJoystick2))) return false;
+
+		// Sticks are paired by usages of device and of its axes.
+		DIDEVICEINSTANCE instance;
+		instance.dwSize = sizeof(DIDEVICEINSTANCE);
+		unsigned short deviceUsage = 0;
+		if(SUCCEEDED(device->GetDeviceInfo(&instance)))
+		{
+			if(instance.wUsagePage == JoystickUsagePage) deviceUsage = instance.wUsage;
+			if(deviceUsage == 0 && GET_DIDEVICE_TYPE(instance.dwDevType) == DI8DEVTYPE_GAMEPAD)
+			{
+				deviceUsage = JoystickUsageGamepad;
+			}
+		}
+
+		unsigned short usages[JoystickAxes] = { 0 };
+		if(FAILED(device->EnumObjects(DIEnumJoystickAxis, usages, DIDFT_AXIS)))
+		{
+			layout = JoystickFilter::DefaultLayout();
+		} else {
+			layout = JoystickFilter::Layout(deviceUsage, usages);
+		}
+
+		// Same range on every axis; devices without axes do not take it.
+		DIPROPRANGE range;
+		range.diph.dwSize = sizeof(DIPROPRANGE);
+		range.diph.dwHeaderSize = sizeof(DIPROPHEADER);
+		range.diph.dwObj = 0;
+		range.diph.dwHow = DIPH_DEVICE;
+		range.lMin = JoystickRangeMin;
+		range.lMax = JoystickRangeMax;
+		device->SetProperty(DIPROP_RANGE, &range.diph);
+		return true;
+	}
+
+	DIJoystickSource::DIJoystickSource(IDirectInputDevice8* joystick, const JoystickLayout& layout,
+									   InputFocusState* focus)
+		: ring(DIRingSize)
+	{
+		this->joystick = joystick;
+		this->focus = focus;
+		this->filter.SetLayout(layout);
+		this->sequence = 0;
+		this->settings = JoystickFilter::DefaultSettings();
+		this->settingsChanged = 0;
+	}
+
+	DIJoystickSource::~DIJoystickSource()
+	{
+		joystick->Unacquire();
+		joystick->Release();
+	}
+
+	void DIJoystickSource::SetSettings(const JoystickSettings& s)
+	{
+		settingsLock.Lock();
+		settings = s;
+		AtomicStore(&settingsChanged, 1);
+		settingsLock.Unlock();
+	}
+
+	JoystickSettings DIJoystickSource::GetSettings()
+	{
+		settingsLock.Lock();
+		JoystickSettings s = settings;
+		settingsLock.Unlock();
+		return s;
+	}
+
+	bool DIJoystickSource::Sample(InputDeviceState& state)
+	{
+		DIJOYSTATE2 js;
+
+		if(AtomicLoad(&settingsChanged))
+		{
+			settingsLock.Lock();
+			filter.SetSettings(settings);
+			AtomicStore(&settingsChanged, 0);
+			settingsLock.Unlock();
+		}
+
+		// Lost device is not touched until it may be acquired again.
+		if(!DIAcquire(joystick, acquisition, focus)) return false;
+
+		// Most controllers must be polled before state is read.
+		if(FAILED(joystick->Poll()))
+		{
+			// We must acquire it.
+			acquisition.Lost();
+			if(!DIAcquire(joystick, acquisition, focus)) return false;
+			joystick->Poll();
+		}
+		if(FAILED(joystick->GetDeviceState(sizeof(js), &js)))
+		{
+			acquisition.Lost();
+			return false;
+		}
+
+		JoystickRawState raw;
+		raw.axes[0] = js.lX;
+		raw.axes[1] = js.lY;
+		raw.axes[2] = js.lZ;
+		raw.axes[3] = js.lRx;
+		raw.axes[4] = js.lRy;
+		raw.axes[5] = js.lRz;
+		raw.axes[6] = js.rglSlider[0];
+		raw.axes[7] = js.rglSlider[1];
+		for(unsigned int i = 0; i < JoystickHats; i++) raw.hats[i] = js.rgdwPOV[i];
+		memcpy(raw.buttons, js.rgbButtons, JoystickButtons);
+
+		unsigned char changed[JoystickButtonCount];
+		unsigned int count = filter.Apply(raw, state, changed, JoystickButtonCount);
+		if(count == 0) return true;
+
+		// Controllers have no buffered data of their own; changes of one sample share sequence.
+		InputRecord record;
+		record.time = GetTickCount();
+		record.sequence = ++sequence;
+		record.type = InputRecordButton;
+		for(unsigned int i = 0; i < count; i++)
+		{
+			record.id = changed[i];
+			record.value = state.buttons[changed[i]];
+			ring.Push(record);
+		}
+		return true;
+	}
+
+	DICursorSource::DICursorSource(HWND hWnd)
+	{
+		this->hWnd = hWnd;
+		this->stale = 1;
+		memset(&windowRect, 0, sizeof(windowRect));
+	}
+
+	void DICursorSource::Invalidate()
+	{
+		AtomicStore(&stale, 1);
+	}
+
+	bool DICursorSource::Sample(InputDeviceState& state)
+	{
+		POINT point;
+		if(!GetCursorPos(&point)) return false;
+
+		// We now clamp it to relative window; rectangle is read when it may have changed.
+		if(AtomicExchange(&stale, 0) && !GetWindowRect(hWnd, &windowRect))
+		{
+			Invalidate();
+			return false;
+		}
+
+		// We now clamp.
+		if(point.x < windowRect.left) point.x = windowRect.left;
+		if(point.y < windowRect.top) point.y =  windowRect.top;
+		if(point.x > windowRect.right) point.x = windowRect.right;
+		if(point.y > windowRect.bottom) point.y = windowRect.bottom;
+
+		memset(state.buttons, 0, sizeof(state.buttons));
+		memset(state.axes, 0, sizeof(state.axes));
+		state.axes[0] = point.x - windowRect.left;
+		state.axes[1] = windowRect.bottom  - point.y;
+		return true;
+	}
+
+}
+}
+}
+}
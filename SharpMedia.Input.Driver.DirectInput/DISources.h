@@ -0,0 +1,171 @@
+#pragma once
+#include <windows.h>
+#include <dinput.h>
+#include <vector>
+#include "../SharpMedia.Input.Driver.Portable/InputAtomic.h"
+#include "../SharpMedia.Input.Driver.Portable/InputEventRing.h"
+#include "../SharpMedia.Input.Driver.Portable/InputPoller.h"
+#include "../SharpMedia.Input.Driver.Portable/MouseAccumulator.h"
+#include "../SharpMedia.Input.Driver.Portable/JoystickFilter.h"
+#include "../SharpMedia.Input.Driver.Portable/DeviceAcquisition.h"
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace DirectInput {
+
+	// Portable cores are shared with evdev driver. Names that managed types of Driver also
+	// have are declared here, so they mean the native ones.
+	using namespace Portable;
+	using Portable::MouseSettings;
+	using Portable::JoystickSettings;
+
+	// Records DirectInput keeps for a device between reads.
+	static const unsigned int DIBufferSize = 256;
+
+	// Records read from DirectInput at once.
+	static const unsigned int DIReadChunk = 64;
+
+	// Records of ring between polls and reads of game loop.
+	static const unsigned int DIRingSize = 1024;
+
+	// Default polling rates in Hz while window is in background or minimized.
+	static const unsigned int DIBackgroundPollingRate = 30;
+	static const unsigned int DIMinimizedPollingRate = 5;
+
+	// Enables buffered data of device, must be set before it is acquired.
+	bool DISetBufferSize(IDirectInputDevice8* device);
+
+	// Performance counter clock shared by pollers. Sleeping is precise to a millisecond only
+	// while timer period is raised (see DIInput).
+	PollerClock* DIGetPollerClock();
+
+	// Guards settings passed from game thread to poller thread; held only to copy them.
+	class DISpinLock
+	{
+		volatile unsigned int locked;
+	public:
+		DISpinLock() { locked = 0; }
+
+		void Lock() { while(AtomicExchange(&locked, 1)) SwitchToThread(); }
+		void Unlock() { AtomicStore(&locked, 0); }
+	};
+
+	// Game controller found by DIEnumJoysticks.
+	struct DIJoystickInfo
+	{
+		GUID guid;
+		unsigned int type;				//< InputDeviceType.
+		unsigned int id;				//< Index within type.
+		TCHAR name[MAX_PATH];
+	};
+
+	// Acquires device when acquisition allows an attempt now; true when device is acquired.
+	bool DIAcquire(IDirectInputDevice8* device, DeviceAcquisition& acquisition, InputFocusState* focus);
+
+	// Lists attached game controllers.
+	bool DIEnumJoysticks(IDirectInput8* input, std::vector<DIJoystickInfo>& joysticks);
+
+	// Sets format and axis range of joystick, before it is acquired, and returns layout of
+	// its axes.
+	bool DISetJoystickFormat(IDirectInputDevice8* device, JoystickLayout& layout);
+
+	// Sampling of DirectInput devices, on poller thread or on GetState. Sources own device;
+	// buffered records go to ring, read by ReadEvents of device.
+	//
+	// Mouse axes are accumulated from every buffered delta rather than from state of sample.
+	// Lost devices are acquired again as DeviceAcquisition allows, focus is that of poller.
+	class DIMouseSource : public InputSource
+	{
+		IDirectInputDevice8* mouse;
+		DeviceAcquisition acquisition;
+		InputFocusState* focus;
+		InputEventRing ring;
+		InputCoalescer coalescer;
+		MouseAccumulator accumulator;
+
+		// Settings are passed to poller thread under spin lock.
+		MouseSettings settings;
+		DISpinLock settingsLock;
+		volatile unsigned int settingsChanged;
+
+		void ReadBuffered();
+	public:
+		DIMouseSource(IDirectInputDevice8* mouse, InputFocusState* focus);
+		virtual ~DIMouseSource();
+
+		virtual bool Sample(InputDeviceState& state);
+		InputEventRing& GetRing() { return ring; }
+
+		// Applied from next sample.
+		void SetSettings(const MouseSettings& settings);
+		MouseSettings GetSettings();
+	};
+
+	class DIKeyboardSource : public InputSource
+	{
+		IDirectInputDevice8* keyboard;
+		DeviceAcquisition acquisition;
+		InputFocusState* focus;
+		unsigned short keyIndex[256];	//< Index of key for DIK code.
+		InputEventRing ring;
+		InputCoalescer coalescer;
+
+		void ReadBuffered();
+	public:
+		DIKeyboardSource(IDirectInputDevice8* keyboard, InputFocusState* focus);
+		virtual ~DIKeyboardSource();
+
+		virtual bool Sample(InputDeviceState& state);
+		InputEventRing& GetRing() { return ring; }
+
+		// Key code of DIK code, 0 if none.
+		unsigned short GetKeyIndex(unsigned int code) const { return keyIndex[code & 0xFF]; }
+	};
+
+	// Polled joystick or gamepad. Buttons changed between samples go to ring as events; axes
+	// are normalized (see JoystickFilter). Sampling does not allocate.
+	class DIJoystickSource : public InputSource
+	{
+		IDirectInputDevice8* joystick;
+		DeviceAcquisition acquisition;
+		InputFocusState* focus;
+		JoystickFilter filter;
+		InputEventRing ring;
+		unsigned int sequence;
+
+		JoystickSettings settings;
+		DISpinLock settingsLock;
+		volatile unsigned int settingsChanged;
+	public:
+		DIJoystickSource(IDirectInputDevice8* joystick, const JoystickLayout& layout, InputFocusState* focus);
+		virtual ~DIJoystickSource();
+
+		virtual bool Sample(InputDeviceState& state);
+		InputEventRing& GetRing() { return ring; }
+
+		// Applied from next sample.
+		void SetSettings(const JoystickSettings& settings);
+		JoystickSettings GetSettings();
+	};
+
+	// Window rectangle is cached; it is read again only after Invalidate, when window moved
+	// or was resized.
+	class DICursorSource : public InputSource
+	{
+		HWND hWnd;
+		RECT windowRect;
+		volatile unsigned int stale;
+	public:
+		DICursorSource(HWND hWnd);
+
+		virtual bool Sample(InputDeviceState& state);
+
+		// May be called from any thread.
+		void Invalidate();
+	};
+
+}
+}
+}
+}
@@ -0,0 +1,85 @@
+#include "EvdevActionMap.h"
+#include <cstring>
+
+using namespace SharpMedia::Input::Driver;
+
+SMEVDEV_API SmEvdevActionMap* SmEvdevActionMapCreate()
+{
+	return new SmEvdevActionMap();
+}
+
+SMEVDEV_API void SmEvdevActionMapDestroy(SmEvdevActionMap* map)
+{
+	delete map;
+}
+
+SMEVDEV_API int SmEvdevActionMapAddBinding(SmEvdevActionMap* map, unsigned int action, unsigned int kind,
+										   unsigned int device, unsigned int input, const unsigned int* modifiers,
+										   unsigned int modifierCount, float threshold, float scale, int absolute)
+{
+	Portable::ActionBinding b = Portable::ActionMap::DefaultBinding();
+	b.action = action;
+	b.kind = kind;
+	b.threshold = threshold;
+	b.scale = scale;
+	b.absolute = absolute != 0;
+
+	unsigned int limit = kind == Portable::ActionAxis ? Portable::InputMaxAxes : Portable::InputMaxButtons;
+	if(device >= Portable::ActionMaxDevices || input >= limit || modifierCount > Portable::ActionMaxModifiers) return -1;
+	b.input = kind == Portable::ActionAxis ? Portable::ActionAxisInput(device, input) : Portable::ActionButton(device, input);
+
+	for(unsigned int i = 0; i < modifierCount; i++) b.modifiers[i] = modifiers[i];
+	b.modifierCount = modifierCount;
+	return map->AddBinding(b);
+}
+
+SMEVDEV_API void SmEvdevActionMapClear(SmEvdevActionMap* map)
+{
+	map->Clear();
+}
+
+SMEVDEV_API void SmEvdevActionMapResetDevice(SmEvdevActionMap* map, unsigned int device)
+{
+	map->ResetDevice(device);
+}
+
+SMEVDEV_API void SmEvdevActionMapBeginFrame(SmEvdevActionMap* map, double time)
+{
+	map->BeginFrame(time);
+}
+
+SMEVDEV_API void SmEvdevActionMapApplyRecords(SmEvdevActionMap* map, unsigned int device,
+											  const SmEvdevRecord* records, unsigned int count, double time)
+{
+	map->ApplyRecords(device, records, count, time);
+}
+
+SMEVDEV_API void SmEvdevActionMapUpdateDevice(SmEvdevActionMap* map, unsigned int device, const unsigned int* buttons,
+											  const long long* axes, unsigned int axisCount, double time)
+{
+	Portable::KeyBitset bits;
+	memcpy(bits.words, buttons, sizeof(bits.words));
+	map->UpdateDevice(device, bits, axes, axisCount, time);
+}
+
+SMEVDEV_API int SmEvdevActionMapGetAction(SmEvdevActionMap* map, unsigned int action, float* value,
+										  unsigned int* held, unsigned int* triggers)
+{
+	if(action >= map->GetActionCount()) return 0;
+
+	const Portable::ActionState& state = map->GetAction(action);
+	*value = state.value;
+	*held = state.held;
+	*triggers = state.triggers;
+	return 1;
+}
+
+SMEVDEV_API int SmEvdevActionMapGetEvents(SmEvdevActionMap* map, unsigned int first, SmEvdevActionEvent* events,
+										  int max)
+{
+	const std::vector<Portable::ActionEvent>& fired = map->GetEvents();
+
+	int count = 0;
+	for(; count < max && first + count < fired.size(); count++) events[count] = fired[first + count];
+	return count;
+}
@@ -0,0 +1,284 @@
+// This file constitutes a part of the SharpMedia project, (c) 2007 by the SharpMedia team
+// and is licensed for your use under the conditions of the NDA or other legally binding contract
+// that you or a legal entity you represent has signed with the SharpMedia team.
+// In an event that you have received or obtained this file without such legally binding contract
+// in place, you MUST destroy all files and other content to which this lincese applies and
+// contact the SharpMedia team for further instructions at the internet mail address:
+//
+//    legal@sharpmedia.com
+//
+
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using System.Text;
+
+namespace SharpMedia.Input.Driver.Evdev
+{
+
+    /// <summary>
+    /// Action map over devices of any input service, same as DIActionMap but compiled by
+    /// native evdev library. Buffered events of device are applied first, then keyboards are
+    /// read as key bits and other devices through their state.
+    /// </summary>
+    public sealed class EvdevActionMap : IActionMap
+    {
+        #region Private Imports
+
+        const string Library = "SharpMedia.Input.Driver.Evdev";
+
+        // Limits of native map.
+        const uint MaxDevices = 16;
+        const uint MaxButtons = 256;
+        const uint MaxAxes = 8;
+        const int MaxModifiers = 4;
+
+        [StructLayout(LayoutKind.Sequential)]
+        struct NativeEvent
+        {
+            public uint Action;
+            public uint Kind;
+            public float Value;
+        }
+
+        [DllImport(Library)]
+        static extern IntPtr SmEvdevActionMapCreate();
+
+        [DllImport(Library)]
+        static extern void SmEvdevActionMapDestroy(IntPtr map);
+
+        [DllImport(Library)]
+        static extern int SmEvdevActionMapAddBinding(IntPtr map, uint action, uint kind, uint device, uint input,
+            uint[] modifiers, uint modifierCount, float threshold, float scale, int absolute);
+
+        [DllImport(Library)]
+        static extern void SmEvdevActionMapClear(IntPtr map);
+
+        [DllImport(Library)]
+        static extern void SmEvdevActionMapResetDevice(IntPtr map, uint device);
+
+        [DllImport(Library)]
+        static extern void SmEvdevActionMapBeginFrame(IntPtr map, double time);
+
+        [DllImport(Library)]
+        static extern void SmEvdevActionMapApplyRecords(IntPtr map, uint device, EvdevInput.Record[] records,
+            uint count, double time);
+
+        [DllImport(Library)]
+        static extern void SmEvdevActionMapUpdateDevice(IntPtr map, uint device, uint[] buttons, long[] axes,
+            uint axisCount, double time);
+
+        [DllImport(Library)]
+        static extern int SmEvdevActionMapGetAction(IntPtr map, uint action, out float value, out uint held,
+            out uint triggers);
+
+        [DllImport(Library)]
+        static extern int SmEvdevActionMapGetEvents(IntPtr map, uint first, [Out] NativeEvent[] events, int max);
+
+        #endregion
+
+        #region Private Members
+        IntPtr native;
+        IInputDevice[] devices = new IInputDevice[MaxDevices];
+        bool[] buttons = new bool[MaxButtons];
+        long[] axes = new long[MaxAxes];
+        uint[] keyBits = new uint[8];
+        BufferedInputEvent[] buffered = new BufferedInputEvent[64];
+        EvdevInput.Record[] records = new EvdevInput.Record[64];
+        NativeEvent[] fired = new NativeEvent[64];
+        uint eventsRead;
+
+        void AssertNotDisposed()
+        {
+            if (native == IntPtr.Zero) throw new ObjectDisposedException("EvdevActionMap");
+        }
+
+        void ReadRecords(uint slot, double time)
+        {
+            IInputDevice device = devices[slot];
+            for (; ; )
+            {
+                int count = device.ReadEvents(buffered);
+                for (int i = 0; i < count; i++)
+                {
+                    records[i].Time = buffered[i].Time;
+                    records[i].Sequence = buffered[i].Sequence;
+                    records[i].Type = (ushort)buffered[i].Type;
+                    records[i].Id = (ushort)buffered[i].Id;
+                    records[i].Value = buffered[i].Value;
+                }
+                SmEvdevActionMapApplyRecords(native, slot, records, (uint)count, time);
+
+                if (count < buffered.Length) break;
+            }
+        }
+
+        void ReadDevice(uint slot, double time)
+        {
+            IInputDevice device = devices[slot];
+
+            // Records first, state is as new as they are or newer.
+            ReadRecords(slot, time);
+
+            // Keyboard has its keys as bits already.
+            IKeyboardDevice keyboard = device as IKeyboardDevice;
+            if (keyboard != null)
+            {
+                keyboard.GetKeyBits(keyBits);
+                Array.Clear(axes, 0, axes.Length);
+                SmEvdevActionMapUpdateDevice(native, slot, keyBits, axes, 0, time);
+                return;
+            }
+
+            Array.Clear(buttons, 0, buttons.Length);
+            Array.Clear(axes, 0, axes.Length);
+            device.GetState(buttons, axes);
+
+            Array.Clear(keyBits, 0, keyBits.Length);
+            for (int i = 0; i < buttons.Length; i++)
+            {
+                if (buttons[i]) keyBits[i >> 5] |= 1u << (i & 31);
+            }
+            SmEvdevActionMapUpdateDevice(native, slot, keyBits, axes, MaxAxes, time);
+        }
+        #endregion
+
+        #region Constructors
+
+        public EvdevActionMap()
+        {
+            native = SmEvdevActionMapCreate();
+        }
+
+        #endregion
+
+        #region IActionMap Members
+
+        public int AddBinding(ActionBinding binding)
+        {
+            AssertNotDisposed();
+
+            uint limit = binding.Trigger == ActionTrigger.Axis ? MaxAxes : MaxButtons;
+            if (binding.Device >= MaxDevices || binding.Input >= limit)
+            {
+                throw new ArgumentException("Device slot or input out of range.");
+            }
+
+            uint count = 0;
+            if (binding.Modifiers != null)
+            {
+                if (binding.Modifiers.Length > MaxModifiers) throw new ArgumentException("At most 4 modifiers.");
+                count = (uint)binding.Modifiers.Length;
+            }
+
+            int index = SmEvdevActionMapAddBinding(native, binding.Action, (uint)binding.Trigger, binding.Device,
+                binding.Input, binding.Modifiers, count, binding.Threshold, binding.Scale, binding.Absolute ? 1 : 0);
+            if (index < 0) throw new ArgumentException("Invalid binding or too many modifier buttons.");
+            return index;
+        }
+
+        public void ClearBindings()
+        {
+            AssertNotDisposed();
+            SmEvdevActionMapClear(native);
+            eventsRead = 0;
+        }
+
+        public void Attach(uint slot, IInputDevice device)
+        {
+            AssertNotDisposed();
+            if (slot >= MaxDevices) throw new ArgumentException("Device slot out of range.");
+
+            // Buttons held by previous device are released.
+            SmEvdevActionMapResetDevice(native, slot);
+            devices[slot] = device;
+        }
+
+        public void Detach(uint slot)
+        {
+            AssertNotDisposed();
+            if (slot >= MaxDevices) throw new ArgumentException("Device slot out of range.");
+
+            SmEvdevActionMapResetDevice(native, slot);
+            devices[slot] = null;
+        }
+
+        public void Update(double time)
+        {
+            AssertNotDisposed();
+            SmEvdevActionMapBeginFrame(native, time);
+            eventsRead = 0;
+
+            for (uint i = 0; i < MaxDevices; i++)
+            {
+                if (devices[i] != null) ReadDevice(i, time);
+            }
+        }
+
+        public bool IsActive(uint action)
+        {
+            float value;
+            uint held, triggers;
+            return native != IntPtr.Zero && SmEvdevActionMapGetAction(native, action, out value, out held, out triggers) != 0 &&
+                held != 0;
+        }
+
+        public float GetValue(uint action)
+        {
+            float value;
+            uint held, triggers;
+            if (native == IntPtr.Zero || SmEvdevActionMapGetAction(native, action, out value, out held, out triggers) == 0)
+            {
+                return 0.0f;
+            }
+            return value;
+        }
+
+        public uint GetTriggerCount(uint action)
+        {
+            float value;
+            uint held, triggers;
+            if (native == IntPtr.Zero || SmEvdevActionMapGetAction(native, action, out value, out held, out triggers) == 0)
+            {
+                return 0;
+            }
+            return triggers;
+        }
+
+        public int ReadEvents(ActionEvent[] events)
+        {
+            if (events == null || native == IntPtr.Zero) return 0;
+
+            int total = 0;
+            while (total < events.Length)
+            {
+                int count = SmEvdevActionMapGetEvents(native, eventsRead, fired, Math.Min(events.Length - total, fired.Length));
+                if (count == 0) break;
+
+                for (int i = 0; i < count; i++)
+                {
+                    events[total + i].Action = fired[i].Action;
+                    events[total + i].Trigger = (ActionTrigger)fired[i].Kind;
+                    events[total + i].Value = fired[i].Value;
+                }
+                eventsRead += (uint)count;
+                total += count;
+            }
+            return total;
+        }
+
+        #endregion
+
+        #region IDisposable Members
+
+        public void Dispose()
+        {
+            if (native == IntPtr.Zero) return;
+
+            SmEvdevActionMapDestroy(native);
+            native = IntPtr.Zero;
+        }
+
+        #endregion
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "EvdevInput.h"
+#include "../SharpMedia.Input.Driver.Portable/ActionMap.h"
+
+// Flat interface of action map, for EvdevActionMap of SharpMedia.Input.Driver.Evdev
+// (P/Invoke); mirrors DIActionMap. Map reads no devices itself: managed side applies
+// buffered events and then state of every attached device, of whichever driver.
+
+typedef SharpMedia::Input::Driver::Portable::ActionMap SmEvdevActionMap;
+typedef SharpMedia::Input::Driver::Portable::ActionEvent SmEvdevActionEvent;
+
+SMEVDEV_API SmEvdevActionMap* SmEvdevActionMapCreate();
+SMEVDEV_API void SmEvdevActionMapDestroy(SmEvdevActionMap* map);
+
+// Kind is ActionTriggerKind, input is button or axis of device slot, modifiers are
+// device slot * 256 + button. Returns index of binding, -1 when it is invalid.
+SMEVDEV_API int SmEvdevActionMapAddBinding(SmEvdevActionMap* map, unsigned int action, unsigned int kind,
+										   unsigned int device, unsigned int input, const unsigned int* modifiers,
+										   unsigned int modifierCount, float threshold, float scale, int absolute);
+SMEVDEV_API void SmEvdevActionMapClear(SmEvdevActionMap* map);
+
+// Held buttons of device slot are released.
+SMEVDEV_API void SmEvdevActionMapResetDevice(SmEvdevActionMap* map, unsigned int device);
+
+// Frame is begun, then records and state of every device are applied, see ActionMap.
+SMEVDEV_API void SmEvdevActionMapBeginFrame(SmEvdevActionMap* map, double time);
+SMEVDEV_API void SmEvdevActionMapApplyRecords(SmEvdevActionMap* map, unsigned int device,
+											  const SmEvdevRecord* records, unsigned int count, double time);
+
+// Buttons are 256 bits (8 words), as key bits of keyboards.
+SMEVDEV_API void SmEvdevActionMapUpdateDevice(SmEvdevActionMap* map, unsigned int device, const unsigned int* buttons,
+											  const long long* axes, unsigned int axisCount, double time);
+
+// Returns 0 when action has no binding.
+SMEVDEV_API int SmEvdevActionMapGetAction(SmEvdevActionMap* map, unsigned int action, float* value,
+										  unsigned int* held, unsigned int* triggers);
+
+// Events of frame from first on; returns number written.
+SMEVDEV_API int SmEvdevActionMapGetEvents(SmEvdevActionMap* map, unsigned int first, SmEvdevActionEvent* events,
+										  int max);
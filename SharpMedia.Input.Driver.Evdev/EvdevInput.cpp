@@ -0,0 +1,439 @@
+#include "EvdevInput.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Evdev {
+
+	using Portable::InputPoller;
+	using Portable::InputMaxButtons;
+	using Portable::InputMaxAxes;
+	using Portable::JoystickAxes;
+	using Portable::JoystickButtonCount;
+
+	// Default polling rates in Hz while window is in background or minimized.
+	static const unsigned int EvdevBackgroundPollingRate = 30;
+	static const unsigned int EvdevMinimizedPollingRate = 5;
+
+	EvdevInput::EvdevInput(unsigned int width, unsigned int height)
+	{
+		this->width = width;
+		this->height = height;
+		this->described = 0;
+
+		// Devices are sampled on GetState until polling rate is set.
+		poller = new InputPoller(EvdevGetPollerClock());
+		poller->SetBackgroundRates(EvdevBackgroundPollingRate, EvdevMinimizedPollingRate);
+	}
+
+	EvdevInput::~EvdevInput()
+	{
+		poller->Stop();
+		for(size_t i = 0; i < devices.size(); i++) Destroy((int)i);
+		poller->Release();
+	}
+
+	static void AddDescriptor(std::vector<EvdevDescriptor>& descriptors, int type, int id, const char* name,
+							  int buttons, int axes)
+	{
+		EvdevDescriptor d;
+		memset(&d, 0, sizeof(d));
+		d.type = type;
+		d.id = id;
+		d.buttons = buttons;
+		d.axes = axes;
+		strncpy(d.name, name, sizeof(d.name) - 1);
+		descriptors.push_back(d);
+	}
+
+	void EvdevInput::Describe()
+	{
+		std::vector<EvdevDeviceInfo> infos;
+		described = reader.GetDevices(infos);
+
+		unsigned int kinds = 0;
+		for(size_t i = 0; i < infos.size(); i++) kinds |= infos[i].kinds;
+
+		// Same descriptors as DirectInput; system devices exist only when a device of kind does.
+		descriptors.clear();
+		if(kinds & EvdevMouse) AddDescriptor(descriptors, EvdevTypeMouse, 0, "System Mouse", 8, 3);
+		if(kinds & EvdevKeyboard) AddDescriptor(descriptors, EvdevTypeKeyboard, 0, "System Keyboard", 256, 0);
+		AddDescriptor(descriptors, EvdevTypeCursor, 0, "OS Cursor (for matching)", 0, 2);
+		for(size_t i = 0; i < infos.size(); i++)
+		{
+			if(!(infos[i].kinds & EvdevJoystick)) continue;
+
+			AddDescriptor(descriptors, (int)infos[i].type, (int)infos[i].id, infos[i].name,
+						  JoystickButtonCount, JoystickAxes);
+		}
+	}
+
+	bool EvdevInput::Update()
+	{
+		// Without polling thread nothing else reads devices, so plugging is found here.
+		if(!poller->IsRunning()) reader.Pump();
+		if(reader.GetChanges() == described) return false;
+
+		Describe();
+		return true;
+	}
+
+	int EvdevInput::Create(int type, int id)
+	{
+		// System devices and cursor have id 0 only.
+		bool joystick = type == EvdevTypeJoystick || type == EvdevTypeWheel || type == EvdevTypeFlightstick;
+		if(id < 0 || (!joystick && id != 0)) return -1;
+
+		Device device;
+		device.type = type;
+		switch(type)
+		{
+		case EvdevTypeJoystick:
+		case EvdevTypeWheel:
+		case EvdevTypeFlightstick:
+			{
+				EvdevJoystickSource* source = new EvdevJoystickSource(&reader, (unsigned int)type, (unsigned int)id);
+				device.source = source;
+				device.ring = &source->GetRing();
+			}
+			break;
+		case EvdevTypeMouse:
+			device.source = new EvdevMouseSource(&reader);
+			device.ring = &reader.GetMouseRing();
+			break;
+		case EvdevTypeKeyboard:
+			device.source = new EvdevKeyboardSource(&reader);
+			device.ring = &reader.GetKeyboardRing();
+			break;
+		case EvdevTypeCursor:
+			device.source = new EvdevCursorSource(&reader, width, height);
+			device.ring = 0;
+			break;
+		default:
+			return -1;
+		}
+
+		// Sampled on poller thread when it runs, otherwise on GetState.
+		device.slot = poller->AddSource(device.source);
+		if(device.slot < 0)
+		{
+			delete device.source;
+			return -1;
+		}
+
+		for(size_t i = 0; i < devices.size(); i++)
+		{
+			if(devices[i].source) continue;
+
+			devices[i] = device;
+			return (int)i;
+		}
+		devices.push_back(device);
+		return (int)devices.size() - 1;
+	}
+
+	void EvdevInput::Destroy(int index)
+	{
+		if(index < 0 || index >= (int)devices.size() || !devices[index].source) return;
+
+		poller->RemoveSource(devices[index].slot);
+		delete devices[index].source;
+		devices[index].source = 0;
+	}
+
+	bool EvdevInput::GetState(int index, unsigned char* buttons, int buttonCount, long long* axes, int axisCount)
+	{
+		if(index < 0 || index >= (int)devices.size() || !devices[index].source) return false;
+		Device& device = devices[index];
+
+		if(!poller->IsRunning()) poller->SampleSource(device.slot);
+		const Portable::InputDeviceState* state = poller->Read(device.slot);
+		if(!state) return false;
+
+		if(device.type == EvdevTypeKeyboard)
+		{
+			// Keys are kept by key code already.
+			for(int i = 0; i < buttonCount && i < (int)InputMaxButtons; i++)
+			{
+				buttons[i] = state->keys.Get(i) ? 1 : 0;
+			}
+		} else {
+			for(int i = 0; i < buttonCount && i < (int)InputMaxButtons; i++) buttons[i] = state->buttons[i];
+		}
+		for(int i = 0; i < axisCount && i < (int)InputMaxAxes; i++) axes[i] = state->axes[i];
+		return true;
+	}
+
+	int EvdevInput::ReadEvents(int index, InputRecord* records, int max)
+	{
+		if(index < 0 || index >= (int)devices.size() || !devices[index].ring || max <= 0) return 0;
+		return (int)devices[index].ring->Pop(records, (unsigned int)max);
+	}
+
+	void EvdevInput::SetBounds(unsigned int w, unsigned int h)
+	{
+		width = w;
+		height = h;
+		for(size_t i = 0; i < devices.size(); i++)
+		{
+			if(devices[i].source && devices[i].type == EvdevTypeCursor)
+			{
+				((EvdevCursorSource*)devices[i].source)->SetBounds(w, h);
+			}
+		}
+	}
+
+	EvdevMouseSource* EvdevInput::GetMouse(int index)
+	{
+		if(index < 0 || index >= (int)devices.size() || !devices[index].source) return 0;
+		if(devices[index].type != EvdevTypeMouse) return 0;
+		return (EvdevMouseSource*)devices[index].source;
+	}
+
+	EvdevJoystickSource* EvdevInput::GetJoystick(int index)
+	{
+		if(index < 0 || index >= (int)devices.size() || !devices[index].source) return 0;
+
+		int type = devices[index].type;
+		if(type != EvdevTypeJoystick && type != EvdevTypeWheel && type != EvdevTypeFlightstick) return 0;
+		return (EvdevJoystickSource*)devices[index].source;
+	}
+
+}
+}
+}
+}
+
+using namespace SharpMedia::Input::Driver;
+using namespace SharpMedia::Input::Driver::Evdev;
+
+SMEVDEV_API SmEvdevInput* SmEvdevCreate(const char* directory, unsigned int width, unsigned int height)
+{
+	EvdevInput* input = new EvdevInput(width, height);
+	if(!input->GetReader().IsValid())
+	{
+		delete input;
+		return 0;
+	}
+
+	// Devices that cannot be opened (no permission) are left out. Directory is watched
+	// first, so devices plugged meanwhile are not missed; they are not added twice.
+	const char* path = directory ? directory : "/dev/input";
+	input->GetReader().Watch(path);
+	input->GetReader().OpenAll(path);
+	input->Describe();
+	return input;
+}
+
+SMEVDEV_API void SmEvdevDestroy(SmEvdevInput* input)
+{
+	delete input;
+}
+
+SMEVDEV_API int SmEvdevAddDevice(SmEvdevInput* input, int fd, unsigned int kinds)
+{
+	if(!input->GetReader().AddDevice(fd, kinds, "")) return 0;
+	input->Describe();
+	return 1;
+}
+
+SMEVDEV_API int SmEvdevGetDescriptorCount(SmEvdevInput* input)
+{
+	return (int)input->GetDescriptors().size();
+}
+
+SMEVDEV_API int SmEvdevGetDescriptor(SmEvdevInput* input, int index, SmEvdevDescriptor* descriptor)
+{
+	if(index < 0 || index >= (int)input->GetDescriptors().size()) return 0;
+	*descriptor = input->GetDescriptors()[index];
+	return 1;
+}
+
+SMEVDEV_API int SmEvdevUpdateDescriptors(SmEvdevInput* input)
+{
+	return input->Update() ? 1 : 0;
+}
+
+SMEVDEV_API int SmEvdevCreateDevice(SmEvdevInput* input, int type, int id)
+{
+	return input->Create(type, id);
+}
+
+SMEVDEV_API void SmEvdevDestroyDevice(SmEvdevInput* input, int device)
+{
+	input->Destroy(device);
+}
+
+SMEVDEV_API int SmEvdevGetState(SmEvdevInput* input, int device, unsigned char* buttons, int buttonCount,
+								long long* axes, int axisCount)
+{
+	return input->GetState(device, buttons, buttonCount, axes, axisCount) ? 1 : 0;
+}
+
+SMEVDEV_API int SmEvdevReadEvents(SmEvdevInput* input, int device, SmEvdevRecord* records, int max)
+{
+	return input->ReadEvents(device, records, max);
+}
+
+SMEVDEV_API int SmEvdevGetMouseSettings(SmEvdevInput* input, int device, float* settings)
+{
+	EvdevMouseSource* mouse = input->GetMouse(device);
+	if(!mouse) return 0;
+
+	MouseSettings s = mouse->GetSettings();
+	settings[0] = (float)s.sensitivity;
+	settings[1] = (float)s.accelThreshold;
+	settings[2] = (float)s.accelExponent;
+	settings[3] = (float)s.accelMaxGain;
+	settings[4] = (float)s.smoothing;
+	return 1;
+}
+
+SMEVDEV_API int SmEvdevSetMouseSettings(SmEvdevInput* input, int device, const float* settings)
+{
+	EvdevMouseSource* mouse = input->GetMouse(device);
+	if(!mouse) return 0;
+
+	MouseSettings s;
+	s.sensitivity = settings[0];
+	s.accelThreshold = settings[1];
+	s.accelExponent = settings[2];
+	s.accelMaxGain = settings[3];
+	s.smoothing = settings[4];
+	mouse->SetSettings(s);
+	return 1;
+}
+
+SMEVDEV_API int SmEvdevGetJoystickSettings(SmEvdevInput* input, int device, float* settings)
+{
+	EvdevJoystickSource* joystick = input->GetJoystick(device);
+	if(!joystick) return 0;
+
+	JoystickSettings s = joystick->GetSettings();
+	settings[0] = (float)s.deadzone;
+	settings[1] = (float)s.saturation;
+	return 1;
+}
+
+SMEVDEV_API int SmEvdevSetJoystickSettings(SmEvdevInput* input, int device, const float* settings)
+{
+	EvdevJoystickSource* joystick = input->GetJoystick(device);
+	if(!joystick) return 0;
+
+	JoystickSettings s;
+	s.deadzone = settings[0];
+	s.saturation = settings[1];
+	joystick->SetSettings(s);
+	return 1;
+}
+
+SMEVDEV_API int SmEvdevSetPollingRate(SmEvdevInput* input, unsigned int rate)
+{
+	return input->GetPoller()->Start(rate) ? 1 : 0;
+}
+
+SMEVDEV_API unsigned int SmEvdevGetPollingRate(SmEvdevInput* input)
+{
+	return input->GetPoller()->GetRate();
+}
+
+SMEVDEV_API void SmEvdevGetPollingLatency(SmEvdevInput* input, float* median, float* p99, float* max)
+{
+	const Portable::LatencyHistogram& latency = input->GetPoller()->GetLatency();
+	*median = (float)latency.Percentile(0.5);
+	*p99 = (float)latency.Percentile(0.99);
+	*max = (float)latency.GetMax();
+}
+
+SMEVDEV_API void SmEvdevSetBackgroundPollingRates(SmEvdevInput* input, unsigned int background, unsigned int minimized)
+{
+	input->GetPoller()->SetBackgroundRates(background, minimized);
+}
+
+SMEVDEV_API void SmEvdevSetFocus(SmEvdevInput* input, int focus)
+{
+	if(focus < Portable::InputFocusForeground || focus > Portable::InputFocusMinimized) return;
+	input->GetPoller()->GetFocus().Set((Portable::InputFocus)focus);
+}
+
+SMEVDEV_API void SmEvdevSetBounds(SmEvdevInput* input, unsigned int width, unsigned int height)
+{
+	input->SetBounds(width, height);
+}
+
+SMEVDEV_API SmEvdevReplay* SmEvdevReplayCreate(const unsigned char* data, unsigned int size)
+{
+	SmEvdevReplay* replay = new SmEvdevReplay(EvdevGetPollerClock(), data, size);
+	if(!replay->IsValid())
+	{
+		delete replay;
+		return 0;
+	}
+	return replay;
+}
+
+SMEVDEV_API void SmEvdevReplayDestroy(SmEvdevReplay* replay)
+{
+	delete replay;
+}
+
+SMEVDEV_API int SmEvdevReplayGetDescriptorCount(SmEvdevReplay* replay)
+{
+	return (int)replay->GetDeviceCount();
+}
+
+SMEVDEV_API int SmEvdevReplayGetDescriptor(SmEvdevReplay* replay, int index, SmEvdevDescriptor* descriptor)
+{
+	if(index < 0 || index >= (int)replay->GetDeviceCount()) return 0;
+
+	const Portable::InputLogDeviceInfo& info = replay->GetDeviceInfo((unsigned int)index);
+	memset(descriptor, 0, sizeof(SmEvdevDescriptor));
+	descriptor->type = (int)info.type;
+	descriptor->id = (int)info.id;
+	descriptor->buttons = (int)info.buttons;
+	descriptor->axes = (int)info.axes;
+	return 1;
+}
+
+SMEVDEV_API int SmEvdevReplayFindDevice(SmEvdevReplay* replay, int type, int id)
+{
+	return replay->FindDevice((unsigned int)type, (unsigned int)id);
+}
+
+SMEVDEV_API int SmEvdevReplayGetState(SmEvdevReplay* replay, int device, unsigned char* buttons, int buttonCount,
+									  long long* axes, int axisCount)
+{
+	if(device < 0 || device >= (int)replay->GetDeviceCount()) return 0;
+
+	const Portable::InputLogDeviceState& state = replay->ReadState((unsigned int)device);
+	for(int i = 0; i < buttonCount && i < (int)state.buttons.size(); i++) buttons[i] = state.buttons[i];
+	for(int i = 0; i < axisCount && i < (int)state.axes.size(); i++) axes[i] = state.axes[i];
+	return 1;
+}
+
+SMEVDEV_API int SmEvdevReplayReadEvents(SmEvdevReplay* replay, int device, SmEvdevRecord* records, int max)
+{
+	if(device < 0 || device >= (int)replay->GetDeviceCount() || max <= 0) return 0;
+	return (int)replay->ReadEvents((unsigned int)device, records, (unsigned int)max);
+}
+
+SMEVDEV_API void SmEvdevReplaySetRealTime(SmEvdevReplay* replay, int realTime)
+{
+	replay->SetRealTime(realTime != 0);
+}
+
+SMEVDEV_API int SmEvdevReplayIsRealTime(SmEvdevReplay* replay)
+{
+	return replay->IsRealTime() ? 1 : 0;
+}
+
+SMEVDEV_API int SmEvdevReplayIsFinished(SmEvdevReplay* replay)
+{
+	return replay->IsFinished() ? 1 : 0;
+}
+
+SMEVDEV_API void SmEvdevReplayRewind(SmEvdevReplay* replay)
+{
+	replay->Rewind();
+}
@@ -0,0 +1,514 @@
+// This file constitutes a part of the SharpMedia project, (c) 2007 by the SharpMedia team
+// and is licensed for your use under the conditions of the NDA or other legally binding contract
+// that you or a legal entity you represent has signed with the SharpMedia team.
+// In an event that you have received or obtained this file without such legally binding contract
+// in place, you MUST destroy all files and other content to which this lincese applies and
+// contact the SharpMedia team for further instructions at the internet mail address:
+//
+//    legal@sharpmedia.com
+//
+
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using System.Text;
+
+namespace SharpMedia.Input.Driver.Evdev
+{
+
+    /// <summary>
+    /// Input driver of Linux evdev (/dev/input/event*), same devices as DirectInput driver:
+    /// system mouse, system keyboard, cursor and joysticks. Native part is
+    /// libSharpMedia.Input.Driver.Evdev.so; devices that cannot be opened (no permission) are
+    /// left out.
+    /// </summary>
+    /// <remarks>Devices plugged or unplugged later change SupportedDevices. Joystick keeps its
+    /// id while plugged; one plugged again takes lowest free id of its type.</remarks>
+    public sealed class EvdevInput : IInputService
+    {
+        #region Private Imports
+
+        const string Library = "SharpMedia.Input.Driver.Evdev";
+
+        [StructLayout(LayoutKind.Sequential)]
+        internal struct Record
+        {
+            public uint Time;
+            public uint Sequence;
+            public ushort Type;
+            public ushort Id;
+            public int Value;
+        }
+
+        [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
+        struct Descriptor
+        {
+            public int Type;
+            public int Id;
+            public int Buttons;
+            public int Axes;
+            [MarshalAs(UnmanagedType.ByValTStr, SizeConst = 64)]
+            public string Name;
+        }
+
+        [DllImport(Library)]
+        static extern IntPtr SmEvdevCreate(string directory, uint width, uint height);
+
+        [DllImport(Library)]
+        static extern void SmEvdevDestroy(IntPtr input);
+
+        [DllImport(Library)]
+        static extern int SmEvdevGetDescriptorCount(IntPtr input);
+
+        [DllImport(Library)]
+        static extern int SmEvdevGetDescriptor(IntPtr input, int index, out Descriptor descriptor);
+
+        [DllImport(Library)]
+        static extern int SmEvdevUpdateDescriptors(IntPtr input);
+
+        [DllImport(Library)]
+        static extern int SmEvdevCreateDevice(IntPtr input, int type, int id);
+
+        [DllImport(Library)]
+        internal static extern void SmEvdevDestroyDevice(IntPtr input, int device);
+
+        [DllImport(Library)]
+        internal static extern int SmEvdevGetState(IntPtr input, int device, [Out] byte[] buttons, int buttonCount,
+            [Out] long[] axes, int axisCount);
+
+        [DllImport(Library)]
+        internal static extern int SmEvdevReadEvents(IntPtr input, int device, [Out] Record[] records, int max);
+
+        [DllImport(Library)]
+        internal static extern int SmEvdevGetMouseSettings(IntPtr input, int device, [Out] float[] settings);
+
+        [DllImport(Library)]
+        internal static extern int SmEvdevSetMouseSettings(IntPtr input, int device, float[] settings);
+
+        [DllImport(Library)]
+        internal static extern int SmEvdevGetJoystickSettings(IntPtr input, int device, [Out] float[] settings);
+
+        [DllImport(Library)]
+        internal static extern int SmEvdevSetJoystickSettings(IntPtr input, int device, float[] settings);
+
+        [DllImport(Library)]
+        static extern int SmEvdevSetPollingRate(IntPtr input, uint rate);
+
+        [DllImport(Library)]
+        static extern uint SmEvdevGetPollingRate(IntPtr input);
+
+        [DllImport(Library)]
+        static extern void SmEvdevGetPollingLatency(IntPtr input, out float median, out float p99, out float max);
+
+        [DllImport(Library)]
+        static extern void SmEvdevSetBackgroundPollingRates(IntPtr input, uint background, uint minimized);
+
+        [DllImport(Library)]
+        static extern void SmEvdevSetFocus(IntPtr input, int focus);
+
+        [DllImport(Library)]
+        static extern void SmEvdevSetBounds(IntPtr input, uint width, uint height);
+
+        #endregion
+
+        #region Private Members
+        IntPtr native = IntPtr.Zero;
+        SharpMedia.Graphics.Window window;
+        InputDeviceDescriptor[] descriptors;
+        Action<SharpMedia.Graphics.Window> focusChanged;
+        Action<SharpMedia.Graphics.Window> resized;
+
+        void AssertInitialized()
+        {
+            if (native == IntPtr.Zero) throw new InvalidOperationException("Input service not initialized.");
+        }
+
+        void FocusChanged(SharpMedia.Graphics.Window window)
+        {
+            // Values of native InputFocus.
+            if (window.IsMinimized) SmEvdevSetFocus(native, 2);
+            else if (!window.HasFocus) SmEvdevSetFocus(native, 1);
+            else SmEvdevSetFocus(native, 0);
+        }
+
+        void Resized(SharpMedia.Graphics.Window window)
+        {
+            SmEvdevSetBounds(native, window.Width, window.Height);
+        }
+
+        void ReadDescriptors()
+        {
+            // Descriptors are those of DirectInput driver.
+            int count = SmEvdevGetDescriptorCount(native);
+            descriptors = new InputDeviceDescriptor[count];
+            for (int i = 0; i < count; i++)
+            {
+                Descriptor d;
+                SmEvdevGetDescriptor(native, i, out d);
+                descriptors[i] = new InputDeviceDescriptor((InputDeviceType)d.Type, d.Name,
+                    (uint)d.Id, (uint)d.Buttons, (uint)d.Axes);
+            }
+        }
+        #endregion
+
+        #region Internal Members
+
+        internal IntPtr Native
+        {
+            get { return native; }
+        }
+
+        internal static void CopyEvents(Record[] records, int count, BufferedInputEvent[] events, int offset)
+        {
+            for (int i = 0; i < count; i++)
+            {
+                events[offset + i].Time = records[i].Time;
+                events[offset + i].Sequence = records[i].Sequence;
+                events[offset + i].Type = (InputEventType)records[i].Type;
+                events[offset + i].Id = records[i].Id;
+                events[offset + i].Value = records[i].Value;
+            }
+        }
+
+        #endregion
+
+        #region IInputService Members
+
+        public void Initialize(SharpMedia.Graphics.Window window)
+        {
+            native = SmEvdevCreate(null, window.Width, window.Height);
+            if (native == IntPtr.Zero) throw new Exception("Input device creation failed.");
+            this.window = window;
+
+            // Focus throttles polling; cursor is clamped to window.
+            focusChanged = FocusChanged;
+            resized = Resized;
+            window.Focused += focusChanged;
+            window.Minimized += focusChanged;
+            window.Resized += resized;
+            FocusChanged(window);
+            ReadDescriptors();
+        }
+
+        public string Name
+        {
+            get { return "Evdev"; }
+        }
+
+        public InputDeviceDescriptor[] SupportedDevices
+        {
+            get
+            {
+                // Plugged and unplugged devices are found here.
+                if (native != IntPtr.Zero && SmEvdevUpdateDescriptors(native) != 0) ReadDescriptors();
+                return descriptors;
+            }
+        }
+
+        public IInputDevice Create(InputDeviceDescriptor desc)
+        {
+            AssertInitialized();
+
+            // Only devices that were found can be created; joystick unplugged later reads no
+            // state until one takes its id.
+            bool found = false;
+            InputDeviceDescriptor[] current = SupportedDevices;
+            for (int i = 0; i < current.Length; i++)
+            {
+                if (current[i].DeviceType == desc.DeviceType && current[i].DeviceId == desc.DeviceId) found = true;
+            }
+            if (!found) throw new NotSupportedException();
+
+            int device = SmEvdevCreateDevice(native, (int)desc.DeviceType, (int)desc.DeviceId);
+            if (device < 0) throw new Exception("Too many input devices.");
+
+            switch (desc.DeviceType)
+            {
+                case InputDeviceType.Keyboard:
+                    return new EvdevKeyboard(this, device);
+                case InputDeviceType.Mouse:
+                    return new EvdevMouse(this, device);
+                case InputDeviceType.Joystick:
+                case InputDeviceType.Wheel:
+                case InputDeviceType.Flightstick:
+                    return new EvdevJoystick(this, device);
+                default:
+                    return new EvdevDevice(this, device);
+            }
+        }
+
+        public uint PollingRate
+        {
+            get
+            {
+                return native != IntPtr.Zero ? SmEvdevGetPollingRate(native) : 0;
+            }
+            set
+            {
+                AssertInitialized();
+                if (value > 8000) throw new ArgumentException("Polling rate must be at most 8000 Hz.");
+
+                if (SmEvdevSetPollingRate(native, value) == 0)
+                {
+                    throw new Exception("Input polling thread could not be created.");
+                }
+            }
+        }
+
+        public void GetPollingLatency(out float median, out float p99, out float max)
+        {
+            median = p99 = max = 0.0f;
+            if (native == IntPtr.Zero) return;
+
+            SmEvdevGetPollingLatency(native, out median, out p99, out max);
+        }
+
+        public void SetBackgroundPollingRates(uint background, uint minimized)
+        {
+            AssertInitialized();
+            SmEvdevSetBackgroundPollingRates(native, background, minimized);
+        }
+
+        public IActionMap CreateActionMap()
+        {
+            return new EvdevActionMap();
+        }
+
+        #endregion
+
+        #region IDisposable Members
+
+        public void Dispose()
+        {
+            if (native == IntPtr.Zero) return;
+
+            window.Focused -= focusChanged;
+            window.Minimized -= focusChanged;
+            window.Resized -= resized;
+
+            // Devices are destroyed with service; those still alive are only detached.
+            SmEvdevDestroy(native);
+            native = IntPtr.Zero;
+        }
+
+        #endregion
+    }
+
+    /// <summary>
+    /// Device of evdev driver, used for cursor and as base of other devices.
+    /// </summary>
+    internal class EvdevDevice : IInputDevice
+    {
+        protected EvdevInput service;
+        protected int device;
+        byte[] buttons = new byte[256];
+        long[] axes = new long[8];
+        EvdevInput.Record[] records = new EvdevInput.Record[64];
+
+        public EvdevDevice(EvdevInput service, int device)
+        {
+            this.service = service;
+            this.device = device;
+        }
+
+        /// <summary>
+        /// Latest state as bytes; false when device has no state yet or service is disposed.
+        /// </summary>
+        protected bool ReadState()
+        {
+            if (device < 0 || service.Native == IntPtr.Zero) return false;
+            return EvdevInput.SmEvdevGetState(service.Native, device, buttons, buttons.Length,
+                axes, axes.Length) != 0;
+        }
+
+        protected byte[] Buttons
+        {
+            get { return buttons; }
+        }
+
+        #region IInputDevice Members
+
+        public virtual void GetState(bool[] button, long[] axis)
+        {
+            if (!ReadState()) return;
+
+            int count = Math.Min(button.Length, buttons.Length);
+            for (int i = 0; i < count; i++) button[i] = buttons[i] != 0;
+
+            count = Math.Min(axis.Length, axes.Length);
+            for (int i = 0; i < count; i++) axis[i] = axes[i];
+        }
+
+        public int ReadEvents(BufferedInputEvent[] events)
+        {
+            if (events == null || device < 0 || service.Native == IntPtr.Zero) return 0;
+
+            int total = 0;
+            while (total < events.Length)
+            {
+                int count = EvdevInput.SmEvdevReadEvents(service.Native, device, records,
+                    Math.Min(events.Length - total, records.Length));
+                if (count == 0) break;
+
+                EvdevInput.CopyEvents(records, count, events, total);
+                total += count;
+            }
+            return total;
+        }
+
+        #endregion
+
+        #region IDisposable Members
+
+        public void Dispose()
+        {
+            if (device < 0) return;
+
+            if (service.Native != IntPtr.Zero) EvdevInput.SmEvdevDestroyDevice(service.Native, device);
+            device = -1;
+        }
+
+        #endregion
+    }
+
+    /// <summary>
+    /// System keyboard of evdev driver, buttons are key codes.
+    /// </summary>
+    internal sealed class EvdevKeyboard : EvdevDevice, IKeyboardDevice
+    {
+        bool[] reported = new bool[256];
+
+        public EvdevKeyboard(EvdevInput service, int device)
+            : base(service, device)
+        {
+        }
+
+        #region IKeyboardDevice Members
+
+        public int ReadTransitions(KeyTransition[] transitions)
+        {
+            if (transitions == null || !ReadState()) return 0;
+
+            // Keys that do not fit stay unreported until next read.
+            byte[] keys = Buttons;
+            int written = 0;
+            for (int i = 1; i < keys.Length && written < transitions.Length; i++)
+            {
+                bool down = keys[i] != 0;
+                if (down == reported[i]) continue;
+
+                reported[i] = down;
+                transitions[written].Key = (uint)i;
+                transitions[written].Pressed = down;
+                written++;
+            }
+            return written;
+        }
+
+        public void GetKeyBits(uint[] bits)
+        {
+            if (bits == null || bits.Length < 8) throw new ArgumentException("Key bits need 8 words.");
+
+            Array.Clear(bits, 0, 8);
+            if (!ReadState()) return;
+
+            byte[] keys = Buttons;
+            for (int i = 1; i < keys.Length; i++)
+            {
+                if (keys[i] != 0) bits[i >> 5] |= 1u << (i & 31);
+            }
+        }
+
+        #endregion
+    }
+
+    /// <summary>
+    /// System mouse of evdev driver.
+    /// </summary>
+    internal sealed class EvdevMouse : EvdevDevice, IMouseDevice
+    {
+        public EvdevMouse(EvdevInput service, int device)
+            : base(service, device)
+        {
+        }
+
+        #region IMouseDevice Members
+
+        public MouseSettings Settings
+        {
+            get
+            {
+                float[] s = new float[5];
+                if (device < 0 || service.Native == IntPtr.Zero ||
+                    EvdevInput.SmEvdevGetMouseSettings(service.Native, device, s) == 0)
+                {
+                    throw new ObjectDisposedException("EvdevMouse");
+                }
+
+                MouseSettings settings;
+                settings.Sensitivity = s[0];
+                settings.AccelerationThreshold = s[1];
+                settings.AccelerationExponent = s[2];
+                settings.MaxAcceleration = s[3];
+                settings.Smoothing = s[4];
+                return settings;
+            }
+            set
+            {
+                float[] s = new float[] { value.Sensitivity, value.AccelerationThreshold,
+                    value.AccelerationExponent, value.MaxAcceleration, value.Smoothing };
+                if (device < 0 || service.Native == IntPtr.Zero ||
+                    EvdevInput.SmEvdevSetMouseSettings(service.Native, device, s) == 0)
+                {
+                    throw new ObjectDisposedException("EvdevMouse");
+                }
+            }
+        }
+
+        #endregion
+    }
+
+    /// <summary>
+    /// Joystick, gamepad, wheel or flight stick of evdev driver, in layout of DirectInput
+    /// joysticks.
+    /// </summary>
+    internal sealed class EvdevJoystick : EvdevDevice, IJoystickDevice
+    {
+        public EvdevJoystick(EvdevInput service, int device)
+            : base(service, device)
+        {
+        }
+
+        #region IJoystickDevice Members
+
+        public JoystickSettings Settings
+        {
+            get
+            {
+                float[] s = new float[2];
+                if (device < 0 || service.Native == IntPtr.Zero ||
+                    EvdevInput.SmEvdevGetJoystickSettings(service.Native, device, s) == 0)
+                {
+                    throw new ObjectDisposedException("EvdevJoystick");
+                }
+
+                JoystickSettings settings;
+                settings.Deadzone = s[0];
+                settings.Saturation = s[1];
+                return settings;
+            }
+            set
+            {
+                // Out of range values are clamped by filter.
+                float[] s = new float[] { value.Deadzone, value.Saturation };
+                if (device < 0 || service.Native == IntPtr.Zero ||
+                    EvdevInput.SmEvdevSetJoystickSettings(service.Native, device, s) == 0)
+                {
+                    throw new ObjectDisposedException("EvdevJoystick");
+                }
+            }
+        }
+
+        #endregion
+    }
+}
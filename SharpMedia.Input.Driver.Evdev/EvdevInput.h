@@ -0,0 +1,147 @@
+#pragma once
+#include "EvdevSources.h"
+#include "../SharpMedia.Input.Driver.Portable/InputReplay.h"
+
+// Flat interface of evdev input driver, for EvdevInput of SharpMedia.Input.Driver.Evdev
+// (P/Invoke). Devices are those of DIInput: system mouse, system keyboard, cursor and
+// joysticks; mirrors DIInput, DIMouse, DIKeyboard, DIJoystick and DICursor. Handles of
+// devices are small integers, -1 on failure.
+
+#if defined(__GNUC__)
+#define SMEVDEV_API extern "C" __attribute__((visibility("default")))
+#else
+#define SMEVDEV_API extern "C"
+#endif
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Evdev {
+
+	// Descriptor of supported device.
+	struct EvdevDescriptor
+	{
+		int type;
+		int id;
+		int buttons;
+		int axes;
+		char name[64];
+	};
+
+	class EvdevInput
+	{
+		struct Device
+		{
+			InputSource* source;
+			InputEventRing* ring;	//< Null for cursor.
+			int type;
+			int slot;
+		};
+
+		EvdevReader reader;
+		Portable::InputPoller* poller;
+		std::vector<Device> devices;
+		std::vector<EvdevDescriptor> descriptors;
+		unsigned int described;				//< Changes of reader descriptors reflect.
+		unsigned int width, height;
+	public:
+		EvdevInput(unsigned int width, unsigned int height);
+		~EvdevInput();
+
+		EvdevReader& GetReader() { return reader; }
+		Portable::InputPoller* GetPoller() { return poller; }
+
+		// Built from devices opened so far.
+		void Describe();
+		const std::vector<EvdevDescriptor>& GetDescriptors() const { return descriptors; }
+
+		// Describes devices again when any was plugged or unplugged; true when it did.
+		bool Update();
+
+		// Id is that of descriptor; joystick that is not plugged reads no state until it is.
+		int Create(int type, int id);
+		void Destroy(int device);
+
+		// Writes state of device; returns false when device is invalid or has no state yet.
+		bool GetState(int device, unsigned char* buttons, int buttonCount, long long* axes, int axisCount);
+		int ReadEvents(int device, InputRecord* records, int max);
+
+		void SetBounds(unsigned int width, unsigned int height);
+
+		// Null when device is not a mouse.
+		EvdevMouseSource* GetMouse(int device);
+
+		// Null when device is not a joystick.
+		EvdevJoystickSource* GetJoystick(int device);
+	};
+
+}
+}
+}
+}
+
+typedef SharpMedia::Input::Driver::Evdev::EvdevInput SmEvdevInput;
+typedef SharpMedia::Input::Driver::Evdev::EvdevDescriptor SmEvdevDescriptor;
+typedef SharpMedia::Input::Driver::Portable::InputRecord SmEvdevRecord;
+typedef SharpMedia::Input::Driver::Portable::InputReplaySession SmEvdevReplay;
+
+// Opens all keyboards, mice and joysticks of directory (/dev/input when null) and follows it
+// for devices plugged later; null when epoll fails.
+SMEVDEV_API SmEvdevInput* SmEvdevCreate(const char* directory, unsigned int width, unsigned int height);
+SMEVDEV_API void SmEvdevDestroy(SmEvdevInput* input);
+
+// Adds fd that delivers input_event records (pipe or file in tests) as standard device of
+// kinds, EvdevDeviceKind bits. Descriptors are rebuilt.
+SMEVDEV_API int SmEvdevAddDevice(SmEvdevInput* input, int fd, unsigned int kinds);
+
+SMEVDEV_API int SmEvdevGetDescriptorCount(SmEvdevInput* input);
+SMEVDEV_API int SmEvdevGetDescriptor(SmEvdevInput* input, int index, SmEvdevDescriptor* descriptor);
+
+// Rebuilds descriptors when devices were plugged or unplugged; returns 1 when it did.
+// Without polling thread it also reads devices, so it notices them.
+SMEVDEV_API int SmEvdevUpdateDescriptors(SmEvdevInput* input);
+
+SMEVDEV_API int SmEvdevCreateDevice(SmEvdevInput* input, int type, int id);
+SMEVDEV_API void SmEvdevDestroyDevice(SmEvdevInput* input, int device);
+SMEVDEV_API int SmEvdevGetState(SmEvdevInput* input, int device, unsigned char* buttons, int buttonCount,
+								long long* axes, int axisCount);
+SMEVDEV_API int SmEvdevReadEvents(SmEvdevInput* input, int device, SmEvdevRecord* records, int max);
+
+// Settings are sensitivity, acceleration threshold, exponent, maximum gain and smoothing;
+// returns 0 when device is not a mouse.
+SMEVDEV_API int SmEvdevGetMouseSettings(SmEvdevInput* input, int device, float* settings);
+SMEVDEV_API int SmEvdevSetMouseSettings(SmEvdevInput* input, int device, const float* settings);
+
+// Settings are deadzone and saturation; returns 0 when device is not a joystick.
+SMEVDEV_API int SmEvdevGetJoystickSettings(SmEvdevInput* input, int device, float* settings);
+SMEVDEV_API int SmEvdevSetJoystickSettings(SmEvdevInput* input, int device, const float* settings);
+
+// Rate in Hz of polling thread, 0 samples on GetState; returns 0 when thread fails.
+SMEVDEV_API int SmEvdevSetPollingRate(SmEvdevInput* input, unsigned int rate);
+SMEVDEV_API unsigned int SmEvdevGetPollingRate(SmEvdevInput* input);
+SMEVDEV_API void SmEvdevGetPollingLatency(SmEvdevInput* input, float* median, float* p99, float* max);
+SMEVDEV_API void SmEvdevSetBackgroundPollingRates(SmEvdevInput* input, unsigned int background, unsigned int minimized);
+
+// Focus is InputFocus (0 foreground, 1 background, 2 minimized).
+SMEVDEV_API void SmEvdevSetFocus(SmEvdevInput* input, int focus);
+SMEVDEV_API void SmEvdevSetBounds(SmEvdevInput* input, unsigned int width, unsigned int height);
+
+// Replay of input log recorded by either driver, see InputReplaySession. It opens no devices,
+// so recorded scenarios run headless. Null when data is not an input log. Devices are
+// indices of log; descriptors have type, id and counts of log, names are empty.
+SMEVDEV_API SmEvdevReplay* SmEvdevReplayCreate(const unsigned char* data, unsigned int size);
+SMEVDEV_API void SmEvdevReplayDestroy(SmEvdevReplay* replay);
+
+SMEVDEV_API int SmEvdevReplayGetDescriptorCount(SmEvdevReplay* replay);
+SMEVDEV_API int SmEvdevReplayGetDescriptor(SmEvdevReplay* replay, int index, SmEvdevDescriptor* descriptor);
+SMEVDEV_API int SmEvdevReplayFindDevice(SmEvdevReplay* replay, int type, int id);
+
+// Every state read steps device unless replay runs in real time; returns 0 for invalid device.
+SMEVDEV_API int SmEvdevReplayGetState(SmEvdevReplay* replay, int device, unsigned char* buttons, int buttonCount,
+									  long long* axes, int axisCount);
+SMEVDEV_API int SmEvdevReplayReadEvents(SmEvdevReplay* replay, int device, SmEvdevRecord* records, int max);
+
+SMEVDEV_API void SmEvdevReplaySetRealTime(SmEvdevReplay* replay, int realTime);
+SMEVDEV_API int SmEvdevReplayIsRealTime(SmEvdevReplay* replay);
+SMEVDEV_API int SmEvdevReplayIsFinished(SmEvdevReplay* replay);
+SMEVDEV_API void SmEvdevReplayRewind(SmEvdevReplay* replay);
@@ -0,0 +1,405 @@
+// This file constitutes a part of the SharpMedia project, (c) 2007 by the SharpMedia team
+// and is licensed for your use under the conditions of the NDA or other legally binding contract
+// that you or a legal entity you represent has signed with the SharpMedia team.
+// In an event that you have received or obtained this file without such legally binding contract
+// in place, you MUST destroy all files and other content to which this lincese applies and
+// contact the SharpMedia team for further instructions at the internet mail address:
+//
+//    legal@sharpmedia.com
+//
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Text;
+using SharpMedia.AspectOriented;
+
+namespace SharpMedia.Input.Driver.Evdev
+{
+
+    /// <summary>
+    /// Input service that plays back log recorded by DirectInput recorder, same as DIReplay
+    /// but through native evdev library. It opens no devices and needs no window, so recorded
+    /// scenarios run headless on Linux.
+    /// </summary>
+    /// <remarks>In real time (default) log plays at recorded timing from Initialize or Rewind.
+    /// Otherwise every state read of device steps to its next recorded state, so a recorded
+    /// frame is replayed per frame, as fast as frames run.</remarks>
+    public sealed class EvdevReplay : IInputService
+    {
+        #region Private Imports
+
+        const string Library = "SharpMedia.Input.Driver.Evdev";
+
+        [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
+        struct Descriptor
+        {
+            public int Type;
+            public int Id;
+            public int Buttons;
+            public int Axes;
+            [MarshalAs(UnmanagedType.ByValTStr, SizeConst = 64)]
+            public string Name;
+        }
+
+        [DllImport(Library)]
+        static extern IntPtr SmEvdevReplayCreate(byte[] data, uint size);
+
+        [DllImport(Library)]
+        static extern void SmEvdevReplayDestroy(IntPtr replay);
+
+        [DllImport(Library)]
+        static extern int SmEvdevReplayGetDescriptorCount(IntPtr replay);
+
+        [DllImport(Library)]
+        static extern int SmEvdevReplayGetDescriptor(IntPtr replay, int index, out Descriptor descriptor);
+
+        [DllImport(Library)]
+        static extern int SmEvdevReplayFindDevice(IntPtr replay, int type, int id);
+
+        [DllImport(Library)]
+        static extern int SmEvdevReplayGetState(IntPtr replay, int device, [Out] byte[] buttons, int buttonCount,
+            [Out] long[] axes, int axisCount);
+
+        [DllImport(Library)]
+        static extern int SmEvdevReplayReadEvents(IntPtr replay, int device, [Out] EvdevInput.Record[] records, int max);
+
+        [DllImport(Library)]
+        static extern void SmEvdevReplaySetRealTime(IntPtr replay, int realTime);
+
+        [DllImport(Library)]
+        static extern int SmEvdevReplayIsRealTime(IntPtr replay);
+
+        [DllImport(Library)]
+        static extern int SmEvdevReplayIsFinished(IntPtr replay);
+
+        [DllImport(Library)]
+        static extern void SmEvdevReplayRewind(IntPtr replay);
+
+        #endregion
+
+        #region Private Members
+        object syncRoot = new object();
+        IntPtr native = IntPtr.Zero;
+        InputDeviceDescriptor[] descriptors;
+
+        void AssertNotDisposed()
+        {
+            if (native == IntPtr.Zero) throw new ObjectDisposedException("EvdevReplay");
+        }
+
+        void Load(byte[] log)
+        {
+            if (log == null) throw new ArgumentNullException("log");
+
+            native = SmEvdevReplayCreate(log, (uint)log.Length);
+            if (native == IntPtr.Zero) throw new ArgumentException("Data is not an input log.");
+
+            int count = SmEvdevReplayGetDescriptorCount(native);
+            descriptors = new InputDeviceDescriptor[count];
+            for (int i = 0; i < count; i++)
+            {
+                Descriptor d;
+                SmEvdevReplayGetDescriptor(native, i, out d);
+                InputDeviceType type = (InputDeviceType)d.Type;
+                descriptors[i] = new InputDeviceDescriptor(type, string.Format("Replayed {0} {1}", type, d.Id),
+                    (uint)d.Id, (uint)d.Buttons, (uint)d.Axes);
+            }
+        }
+        #endregion
+
+        #region Internal Members
+
+        internal bool GetState(int device, byte[] buttons, long[] axes)
+        {
+            lock (syncRoot)
+            {
+                AssertNotDisposed();
+                return SmEvdevReplayGetState(native, device, buttons, buttons.Length, axes, axes.Length) != 0;
+            }
+        }
+
+        internal int ReadEvents(int device, EvdevInput.Record[] records, int max)
+        {
+            lock (syncRoot)
+            {
+                AssertNotDisposed();
+                return SmEvdevReplayReadEvents(native, device, records, max);
+            }
+        }
+
+        #endregion
+
+        #region Constructors
+
+        /// <summary>
+        /// Replays log in memory.
+        /// </summary>
+        public EvdevReplay([NotNull] byte[] log)
+        {
+            Load(log);
+        }
+
+        /// <summary>
+        /// Replays log read from stream.
+        /// </summary>
+        public EvdevReplay([NotNull] Stream stream)
+        {
+            if (stream == null) throw new ArgumentNullException("stream");
+
+            MemoryStream memory = new MemoryStream();
+            byte[] buffer = new byte[4096];
+            for (int read; (read = stream.Read(buffer, 0, buffer.Length)) > 0; )
+            {
+                memory.Write(buffer, 0, read);
+            }
+            Load(memory.ToArray());
+        }
+
+        #endregion
+
+        #region Public Members
+
+        /// <summary>
+        /// Plays at recorded timing, or steps every device per state read.
+        /// </summary>
+        public bool RealTime
+        {
+            get
+            {
+                lock (syncRoot)
+                {
+                    return native != IntPtr.Zero && SmEvdevReplayIsRealTime(native) != 0;
+                }
+            }
+            set
+            {
+                lock (syncRoot)
+                {
+                    // Time continues from position of log.
+                    AssertNotDisposed();
+                    SmEvdevReplaySetRealTime(native, value ? 1 : 0);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Whole log was played.
+        /// </summary>
+        public bool IsFinished
+        {
+            get
+            {
+                lock (syncRoot)
+                {
+                    return native == IntPtr.Zero || SmEvdevReplayIsFinished(native) != 0;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Plays log again from beginning.
+        /// </summary>
+        public void Rewind()
+        {
+            lock (syncRoot)
+            {
+                if (native != IntPtr.Zero) SmEvdevReplayRewind(native);
+            }
+        }
+
+        #endregion
+
+        #region IInputService Members
+
+        /// <summary>
+        /// Starts replay; window is not used and may be null.
+        /// </summary>
+        public void Initialize(SharpMedia.Graphics.Window window)
+        {
+            Rewind();
+        }
+
+        public string Name
+        {
+            get { return "Input Replay"; }
+        }
+
+        public InputDeviceDescriptor[] SupportedDevices
+        {
+            get { return descriptors; }
+        }
+
+        public IInputDevice Create(InputDeviceDescriptor desc)
+        {
+            lock (syncRoot)
+            {
+                AssertNotDisposed();
+
+                int device = SmEvdevReplayFindDevice(native, (int)desc.DeviceType, (int)desc.DeviceId);
+                if (device < 0) throw new NotSupportedException();
+
+                InputDeviceDescriptor d = descriptors[device];
+                return new EvdevReplayDevice(this, device, (int)d.ButtonCount, (int)d.AxisCount);
+            }
+        }
+
+        public uint PollingRate
+        {
+            get
+            {
+                return 0;
+            }
+            set
+            {
+                // Replayed states do not depend on sampling.
+            }
+        }
+
+        public void GetPollingLatency(out float median, out float p99, out float max)
+        {
+            median = p99 = max = 0.0f;
+        }
+
+        public void SetBackgroundPollingRates(uint background, uint minimized)
+        {
+            // Replay does not poll.
+        }
+
+        public IActionMap CreateActionMap()
+        {
+            // Map reads devices through their interfaces, replayed ones as well.
+            return new EvdevActionMap();
+        }
+
+        #endregion
+
+        #region IDisposable Members
+
+        public void Dispose()
+        {
+            lock (syncRoot)
+            {
+                if (native == IntPtr.Zero) return;
+
+                SmEvdevReplayDestroy(native);
+                native = IntPtr.Zero;
+            }
+        }
+
+        #endregion
+    }
+
+    /// <summary>
+    /// Device of evdev replay. Whatever is read goes through state, so key transitions and key
+    /// bits replay the same way they were recorded; keyboard buttons are key codes.
+    /// </summary>
+    internal sealed class EvdevReplayDevice : IKeyboardDevice, IMouseDevice
+    {
+        EvdevReplay replay;
+        int device;
+        byte[] buttons;
+        long[] axes;
+        bool[] reported;
+        EvdevInput.Record[] records = new EvdevInput.Record[64];
+        MouseSettings settings;
+
+        public EvdevReplayDevice(EvdevReplay replay, int device, int buttonCount, int axisCount)
+        {
+            this.replay = replay;
+            this.device = device;
+            this.buttons = new byte[buttonCount];
+            this.axes = new long[axisCount];
+            this.reported = new bool[buttonCount];
+            settings.Sensitivity = 1.0f;
+            settings.MaxAcceleration = 1.0f;
+        }
+
+        #region IInputDevice Members
+
+        public void GetState(bool[] button, long[] axis)
+        {
+            if (!replay.GetState(device, buttons, axes)) return;
+
+            int count = Math.Min(button.Length, buttons.Length);
+            for (int i = 0; i < count; i++) button[i] = buttons[i] != 0;
+
+            count = Math.Min(axis.Length, axes.Length);
+            for (int i = 0; i < count; i++) axis[i] = axes[i];
+        }
+
+        public int ReadEvents(BufferedInputEvent[] events)
+        {
+            if (events == null) return 0;
+
+            int total = 0;
+            while (total < events.Length)
+            {
+                int count = replay.ReadEvents(device, records, Math.Min(events.Length - total, records.Length));
+                if (count == 0) break;
+
+                EvdevInput.CopyEvents(records, count, events, total);
+                total += count;
+            }
+            return total;
+        }
+
+        #endregion
+
+        #region IKeyboardDevice Members
+
+        public int ReadTransitions(KeyTransition[] transitions)
+        {
+            if (transitions == null || !replay.GetState(device, buttons, axes)) return 0;
+
+            // Buttons that do not fit stay unreported until next read.
+            int written = 0;
+            for (int i = 0; i < buttons.Length && written < transitions.Length; i++)
+            {
+                bool down = buttons[i] != 0;
+                if (down == reported[i]) continue;
+
+                reported[i] = down;
+                transitions[written].Key = (uint)i;
+                transitions[written].Pressed = down;
+                written++;
+            }
+            return written;
+        }
+
+        public void GetKeyBits(uint[] bits)
+        {
+            if (bits == null || bits.Length < 8) throw new ArgumentException("Key bits need 8 words.");
+
+            Array.Clear(bits, 0, 8);
+            if (!replay.GetState(device, buttons, axes)) return;
+
+            int count = Math.Min(buttons.Length, 256);
+            for (int i = 0; i < count; i++)
+            {
+                if (buttons[i] != 0) bits[i >> 5] |= 1u << (i & 31);
+            }
+        }
+
+        #endregion
+
+        #region IMouseDevice Members
+
+        public MouseSettings Settings
+        {
+            get { return settings; }
+            set { settings = value; }
+        }
+
+        #endregion
+
+        #region IDisposable Members
+
+        public void Dispose()
+        {
+        }
+
+        #endregion
+    }
+}
@@ -0,0 +1,1127 @@
+#include "EvdevSources.h"
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Evdev {
+
+	using Portable::AtomicLoad;
+	using Portable::AtomicStore;
+	using Portable::InputRecordAxis;
+	using Portable::InputRecordButton;
+	using Portable::JoystickAxes;
+	using Portable::JoystickButtons;
+	using Portable::JoystickButtonCount;
+	using Portable::JoystickHats;
+
+	// Wheel delta of one notch, as reported by DirectInput.
+	static const int EvdevWheelDelta = 120;
+
+	class EvdevPollerClock : public PollerClock
+	{
+	public:
+		virtual double Now()
+		{
+			timespec t;
+			clock_gettime(CLOCK_MONOTONIC, &t);
+			return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+		}
+
+		virtual void SleepUntil(double time)
+		{
+			timespec t;
+			t.tv_sec = (time_t)time;
+			t.tv_nsec = (long)((time - (double)t.tv_sec) * 1e9);
+			if(t.tv_nsec >= 1000000000) t.tv_nsec = 999999999;
+			while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, 0) == EINTR) {}
+		}
+	};
+
+	PollerClock* EvdevGetPollerClock()
+	{
+		static EvdevPollerClock clock;
+		return &clock;
+	}
+
+	// Evdev code of every key code, in order of KeyMapper of DirectInput driver, so both
+	// drivers report same key codes.
+	static const unsigned short EvdevKeyMapper[] = 
+	{
+		0,
+		KEY_0,
+		KEY_1,
+		KEY_2,
+		KEY_3,
+		KEY_4,
+		KEY_5,
+		KEY_6,
+		KEY_7,
+		KEY_8,
+		KEY_9,
+		KEY_A,
+		KEY_RO,					// DIK_ABNT_C1
+		0,						// DIK_ABNT_C2
+		KEY_KPPLUS,
+		KEY_APOSTROPHE,
+		KEY_COMPOSE,			// DIK_APPS
+		0,						// DIK_AT
+		0,						// DIK_AX
+		KEY_B,
+		KEY_BACKSPACE,
+		KEY_BACKSLASH,
+		KEY_C,
+		KEY_CALC,
+		KEY_CAPSLOCK,
+		0,						// DIK_COLON
+		KEY_COMMA,
+		KEY_HENKAN,				// DIK_CONVERT
+		KEY_D,
+		KEY_KPDOT,
+		KEY_DELETE,
+		KEY_KPSLASH,
+		KEY_DOWN,
+		KEY_E,
+		KEY_END,
+		KEY_EQUAL,
+		KEY_ESC,
+		KEY_F,
+		KEY_F1,
+		KEY_F2,
+		KEY_F3,
+		KEY_F4,
+		KEY_F5,
+		KEY_F6,
+		KEY_F7,
+		KEY_F8,
+		KEY_F9,
+		KEY_F10,
+		KEY_F11,
+		KEY_F12,
+		KEY_F13,
+		KEY_F14,
+		KEY_F15,
+		KEY_G,
+		KEY_GRAVE,
+		KEY_H,
+		KEY_HOME,
+		KEY_I,
+		KEY_INSERT,
+		KEY_J,
+		KEY_K,
+		KEY_KATAKANAHIRAGANA,	// DIK_KANA
+		KEY_ZENKAKUHANKAKU,		// DIK_KANJI
+		KEY_L,
+		KEY_LEFTBRACE,
+		KEY_LEFTCTRL,
+		KEY_LEFT,
+		KEY_LEFTALT,
+		KEY_LEFTSHIFT,
+		KEY_LEFTMETA,
+		KEY_M,
+		KEY_MAIL,
+		KEY_MEDIA,
+		KEY_STOPCD,
+		KEY_MINUS,
+		KEY_KPASTERISK,
+		KEY_MUTE,
+		KEY_COMPUTER,
+		KEY_N,
+		KEY_PAGEDOWN,
+		KEY_NEXTSONG,
+		KEY_MUHENKAN,			// DIK_NOCONVERT
+		KEY_NUMLOCK,
+		KEY_KP0,
+		KEY_KP1,
+		KEY_KP2,
+		KEY_KP3,
+		KEY_KP4,
+		KEY_KP5,
+		KEY_KP6,
+		KEY_KP7,
+		KEY_KP8,
+		KEY_KP9,
+		KEY_KPCOMMA,
+		KEY_KPENTER,
+		KEY_KPEQUAL,
+		KEY_O,
+		KEY_102ND,				// DIK_OEM_102
+		KEY_P,
+		KEY_PAUSE,
+		KEY_DOT,
+		KEY_PLAYPAUSE,
+		KEY_POWER,
+		KEY_PREVIOUSSONG,
+		KEY_PAGEUP,
+		KEY_Q,
+		KEY_R,
+		KEY_RIGHTBRACE,
+		KEY_RIGHTCTRL,
+		KEY_ENTER,
+		KEY_RIGHT,
+		KEY_RIGHTALT,
+		KEY_RIGHTSHIFT,
+		KEY_RIGHTMETA,
+		KEY_S,
+		KEY_SCROLLLOCK,
+		KEY_SEMICOLON,
+		KEY_SLASH,
+		KEY_SLEEP,
+		KEY_SPACE,
+		0,						// DIK_STOP (NEC), KEY_STOP is web stop
+		KEY_KPMINUS,
+		KEY_SYSRQ,
+		KEY_T,
+		KEY_TAB,
+		KEY_U,
+		0,						// DIK_UNDERLINE
+		0,						// DIK_UNLABELED
+		KEY_UP,
+		KEY_V,
+		KEY_VOLUMEDOWN,
+		KEY_VOLUMEUP,
+		KEY_W,
+		KEY_WAKEUP,
+		KEY_BACK,
+		KEY_BOOKMARKS,
+		KEY_FORWARD,
+		KEY_HOMEPAGE,
+		KEY_REFRESH,
+		KEY_SEARCH,
+		KEY_STOP,
+		KEY_X,
+		KEY_Y,
+		KEY_YEN,
+		KEY_Z
+	};
+
+	// Mouse buttons in order of DirectInput buttons.
+	static const unsigned short EvdevMouseMapper[EvdevMouseButtons] =
+	{
+		BTN_LEFT, BTN_RIGHT, BTN_MIDDLE, BTN_SIDE, BTN_EXTRA, BTN_FORWARD, BTN_BACK, BTN_TASK
+	};
+
+	static bool TestBit(const unsigned long* bits, unsigned int bit)
+	{
+		const unsigned int word = sizeof(unsigned long) * 8;
+		return (bits[bit / word] >> (bit % word)) & 1;
+	}
+
+	static void SetBit(unsigned long* bits, unsigned int bit)
+	{
+		const unsigned int word = sizeof(unsigned long) * 8;
+		bits[bit / word] |= 1ul << (bit % word);
+	}
+
+	void EvdevCapabilities::Clear()
+	{
+		memset(keys, 0, sizeof(keys));
+		memset(rel, 0, sizeof(rel));
+		memset(abs, 0, sizeof(abs));
+		memset(ranges, 0, sizeof(ranges));
+	}
+
+	bool EvdevCapabilities::HasKey(unsigned int code) const { return code < EvdevKeyCodes && TestBit(keys, code); }
+	bool EvdevCapabilities::HasRel(unsigned int code) const { return code < EvdevRelCodes && TestBit(rel, code); }
+	bool EvdevCapabilities::HasAbs(unsigned int code) const { return code < EvdevAbsCodes && TestBit(abs, code); }
+	void EvdevCapabilities::SetKey(unsigned int code) { if(code < EvdevKeyCodes) SetBit(keys, code); }
+	void EvdevCapabilities::SetRel(unsigned int code) { if(code < EvdevRelCodes) SetBit(rel, code); }
+
+	void EvdevCapabilities::SetAbs(unsigned int code, int minimum, int maximum)
+	{
+		if(code >= EvdevAbsCodes) return;
+
+		SetBit(abs, code);
+		ranges[code].minimum = minimum;
+		ranges[code].maximum = maximum;
+		ranges[code].value = minimum < 0 ? 0 : minimum;
+	}
+
+	unsigned int EvdevCapabilities::GetKinds() const
+	{
+		// Power buttons and the like also report keys; keyboards have letters.
+		unsigned int kinds = 0;
+		if(HasKey(KEY_A) && HasKey(KEY_Z) && HasKey(KEY_SPACE)) kinds |= EvdevKeyboard;
+		if(HasRel(REL_X) && HasRel(REL_Y) && HasKey(BTN_LEFT)) kinds |= EvdevMouse;
+
+		// Touchpads and tablets have absolute axes too, but digitizer buttons instead.
+		if(HasAbs(ABS_X))
+		{
+			for(unsigned int code = BTN_JOYSTICK; code < BTN_DIGI; code++)
+			{
+				if(!HasKey(code)) continue;
+
+				kinds |= EvdevJoystick;
+				break;
+			}
+		}
+		return kinds;
+	}
+
+	EvdevCapabilities EvdevCapabilities::Standard(unsigned int kinds)
+	{
+		EvdevCapabilities caps;
+		caps.Clear();
+		if(kinds & EvdevKeyboard)
+		{
+			for(unsigned int i = 1; i < sizeof(EvdevKeyMapper) / sizeof(EvdevKeyMapper[0]); i++)
+			{
+				if(EvdevKeyMapper[i]) caps.SetKey(EvdevKeyMapper[i]);
+			}
+		}
+		if(kinds & EvdevMouse)
+		{
+			caps.SetRel(REL_X);
+			caps.SetRel(REL_Y);
+			caps.SetRel(REL_WHEEL);
+			for(unsigned int i = 0; i < EvdevMouseButtons; i++) caps.SetKey(EvdevMouseMapper[i]);
+		}
+		if(kinds & EvdevJoystick)
+		{
+			static const unsigned short Buttons[] =
+			{
+				BTN_SOUTH, BTN_EAST, BTN_NORTH, BTN_WEST, BTN_TL, BTN_TR,
+				BTN_SELECT, BTN_START, BTN_MODE, BTN_THUMBL, BTN_THUMBR
+			};
+			caps.SetAbs(ABS_X, -32768, 32767);
+			caps.SetAbs(ABS_Y, -32768, 32767);
+			caps.SetAbs(ABS_RX, -32768, 32767);
+			caps.SetAbs(ABS_RY, -32768, 32767);
+			caps.SetAbs(ABS_Z, 0, 255);
+			caps.SetAbs(ABS_RZ, 0, 255);
+			caps.SetAbs(ABS_HAT0X, -1, 1);
+			caps.SetAbs(ABS_HAT0Y, -1, 1);
+			for(unsigned int i = 0; i < sizeof(Buttons) / sizeof(Buttons[0]); i++) caps.SetKey(Buttons[i]);
+		}
+		return caps;
+	}
+
+	// Hat position in hundredths of degree clockwise from up, by Y and X of hat.
+	static const unsigned int EvdevHatAngles[3][3] =
+	{
+		{ 31500, 0, 4500 },
+		{ 27000, 0xFFFFFFFF, 9000 },
+		{ 22500, 18000, 13500 }
+	};
+
+	// Raw value of device to raw range of JoystickFilter.
+	static int EvdevScaleAxis(int value, const EvdevAxisRange& range)
+	{
+		if(range.maximum <= range.minimum) return 0;
+		if(value < range.minimum) value = range.minimum;
+		if(value > range.maximum) value = range.maximum;
+
+		long long span = (long long)Portable::JoystickRangeMax - Portable::JoystickRangeMin;
+		return (int)((long long)(value - range.minimum) * span / ((long long)range.maximum - range.minimum) +
+			Portable::JoystickRangeMin);
+	}
+
+	static void EvdevSetHat(EvdevJoystickState& joystick, unsigned int hat, unsigned int axis, int value)
+	{
+		joystick.hats[hat][axis] = value < 0 ? -1 : (value > 0 ? 1 : 0);
+		joystick.raw.hats[hat] = EvdevHatAngles[joystick.hats[hat][1] + 1][joystick.hats[hat][0] + 1];
+	}
+
+	static EvdevJoystickState* EvdevCreateJoystick(const EvdevCapabilities& caps)
+	{
+		EvdevJoystickState* joystick = new EvdevJoystickState;
+		memset(joystick, 0, sizeof(EvdevJoystickState));
+		memset(joystick->axes, -1, sizeof(joystick->axes));
+		for(unsigned int i = 0; i < JoystickHats; i++) joystick->raw.hats[i] = 0xFFFFFFFF;
+
+		// First six codes are axes of same place in DirectInput state; throttle, rudder,
+		// wheel and pedals fill sliders.
+		static const unsigned short Usages[6] =
+		{
+			Portable::JoystickUsageX, Portable::JoystickUsageY, Portable::JoystickUsageZ,
+			Portable::JoystickUsageRx, Portable::JoystickUsageRy, Portable::JoystickUsageRz
+		};
+		static const unsigned short Sliders[] = { ABS_THROTTLE, ABS_RUDDER, ABS_WHEEL, ABS_GAS, ABS_BRAKE };
+
+		unsigned short usages[JoystickAxes] = { 0 };
+		for(unsigned int code = ABS_X; code <= ABS_RZ; code++)
+		{
+			if(!caps.HasAbs(code)) continue;
+
+			joystick->axes[code] = (signed char)code;
+			joystick->ranges[code] = caps.ranges[code];
+			usages[code] = Usages[code];
+		}
+		unsigned int slider = 6;
+		for(unsigned int i = 0; i < sizeof(Sliders) / sizeof(Sliders[0]) && slider < JoystickAxes; i++)
+		{
+			if(!caps.HasAbs(Sliders[i])) continue;
+
+			joystick->axes[Sliders[i]] = (signed char)slider;
+			joystick->ranges[slider] = caps.ranges[Sliders[i]];
+			usages[slider++] = Portable::JoystickUsageSlider;
+		}
+		for(unsigned int i = 0; i < JoystickAxes; i++)
+		{
+			if(usages[i]) joystick->raw.axes[i] = EvdevScaleAxis(joystick->ranges[i].value, joystick->ranges[i]);
+		}
+		for(unsigned int code = ABS_HAT0X; code <= ABS_HAT3Y; code++)
+		{
+			if(caps.HasAbs(code)) EvdevSetHat(*joystick, (code - ABS_HAT0X) / 2, (code - ABS_HAT0X) % 2, caps.ranges[code].value);
+		}
+
+		// Gamepad drivers of kernel put right stick on Rx/Ry and triggers on Z and Rz, so
+		// there Rz is a trigger as well.
+		bool gamepad = caps.HasKey(BTN_GAMEPAD);
+		if(gamepad && usages[ABS_RX] && usages[ABS_RY] && usages[ABS_RZ]) usages[ABS_RZ] = Portable::JoystickUsageSlider;
+		joystick->layout = JoystickFilter::Layout(gamepad ? Portable::JoystickUsageGamepad : Portable::JoystickUsageJoystick, usages);
+
+		if(caps.HasAbs(ABS_WHEEL)) joystick->type = EvdevTypeWheel;
+		else if(!gamepad && (caps.HasAbs(ABS_THROTTLE) || caps.HasAbs(ABS_RUDDER))) joystick->type = EvdevTypeFlightstick;
+		else joystick->type = EvdevTypeJoystick;
+
+		// Buttons in order of codes, joystick and gamepad buttons first, as drivers of
+		// kernel number them.
+		unsigned int count = 0;
+		for(unsigned int code = BTN_JOYSTICK; code < EvdevKeyCodes && count < JoystickButtons; code++)
+		{
+			if(caps.HasKey(code)) joystick->buttons[code] = (unsigned char)++count;
+		}
+		for(unsigned int code = BTN_MISC; code < BTN_MOUSE && count < JoystickButtons; code++)
+		{
+			if(caps.HasKey(code)) joystick->buttons[code] = (unsigned char)++count;
+		}
+		return joystick;
+	}
+
+	// Applies event to joystick; false when it is not an input of joystick.
+	static bool EvdevApplyJoystick(EvdevJoystickState& joystick, const input_event& e)
+	{
+		switch(e.type)
+		{
+		case EV_KEY:
+			if(e.code >= EvdevKeyCodes || !joystick.buttons[e.code]) return false;
+
+			// Pressed buttons have high bit set, as in DirectInput state.
+			joystick.raw.buttons[joystick.buttons[e.code] - 1] = e.value ? 0x80 : 0;
+			return true;
+		case EV_ABS:
+			if(e.code >= ABS_HAT0X && e.code <= ABS_HAT3Y)
+			{
+				EvdevSetHat(joystick, (e.code - ABS_HAT0X) / 2, (e.code - ABS_HAT0X) % 2, e.value);
+				return true;
+			}
+			if(e.code >= EvdevAbsCodes || joystick.axes[e.code] < 0) return false;
+
+			joystick.raw.axes[joystick.axes[e.code]] = EvdevScaleAxis(e.value, joystick.ranges[joystick.axes[e.code]]);
+			return true;
+		}
+		return false;
+	}
+
+	EvdevReader::EvdevReader()
+		: keyboardRing(EvdevRingSize), mouseRing(EvdevRingSize)
+	{
+		epoll = epoll_create1(EPOLL_CLOEXEC);
+		watch = -1;
+		changes = 0;
+		handles = 0;
+		sequence = 0;
+		keys.Clear();
+		memset(buttons, 0, sizeof(buttons));
+		counts[0] = counts[1] = 0;
+		memset(motion, 0, sizeof(motion));
+		motionTime = 0;
+
+		memset(keyIndex, 0, sizeof(keyIndex));
+		for(unsigned int i = 1; i < sizeof(EvdevKeyMapper) / sizeof(EvdevKeyMapper[0]); i++)
+		{
+			if(EvdevKeyMapper[i]) keyIndex[EvdevKeyMapper[i]] = (unsigned short)i;
+		}
+	}
+
+	EvdevReader::~EvdevReader()
+	{
+		for(size_t i = 0; i < devices.size(); i++)
+		{
+			close(devices[i].fd);
+			delete devices[i].joystick;
+		}
+		if(watch >= 0) close(watch);
+		if(epoll >= 0) close(epoll);
+	}
+
+	int EvdevReader::FindPath(const std::string& path) const
+	{
+		for(size_t i = 0; i < devices.size(); i++)
+		{
+			if(!path.empty() && devices[i].path == path) return (int)i;
+		}
+		return -1;
+	}
+
+	bool EvdevReader::AddDevice(int fd, const EvdevCapabilities& caps, const char* name, const char* path)
+	{
+		if(epoll < 0 || fd < 0) return false;
+
+		int flags = fcntl(fd, F_GETFL);
+		unsigned int kinds = caps.GetKinds();
+		if(!kinds || flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		Device device;
+		device.fd = fd;
+		device.kinds = kinds;
+		strncpy(device.name, name ? name : "", sizeof(device.name) - 1);
+		device.name[sizeof(device.name) - 1] = 0;
+		device.path = path ? path : "";
+		device.joystick = kinds & EvdevJoystick ? EvdevCreateJoystick(caps) : 0;
+		device.dropped = false;
+
+		lock.Lock();
+		if(FindPath(device.path) >= 0)
+		{
+			lock.Unlock();
+			close(fd);
+			delete device.joystick;
+			return false;
+		}
+
+		// Event data is fd, so removing a device does not invalidate others.
+		epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.fd = fd;
+		if(epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+		{
+			lock.Unlock();
+			close(fd);
+			delete device.joystick;
+			return false;
+		}
+
+		// Joystick takes lowest id of its type that is free, so one plugged again gets its
+		// id back.
+		if(device.joystick)
+		{
+			for(bool taken = true; taken; )
+			{
+				taken = false;
+				for(size_t i = 0; i < devices.size(); i++)
+				{
+					const EvdevJoystickState* other = devices[i].joystick;
+					if(other && other->type == device.joystick->type && other->id == device.joystick->id)
+					{
+						device.joystick->id++;
+						taken = true;
+					}
+				}
+			}
+		}
+
+		device.handle = ++handles;
+		devices.push_back(device);
+		Portable::AtomicAdd(&changes, 1);
+		lock.Unlock();
+		return true;
+	}
+
+	bool EvdevReader::AddDevice(int fd, unsigned int kinds, const char* name)
+	{
+		return AddDevice(fd, EvdevCapabilities::Standard(kinds), name, 0);
+	}
+
+	bool EvdevReader::OpenDevice(const char* path)
+	{
+		int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+		if(fd < 0) return false;
+
+		EvdevCapabilities caps;
+		caps.Clear();
+		unsigned long types[(EV_CNT + EvdevCapabilities::LongBits - 1) / EvdevCapabilities::LongBits];
+		memset(types, 0, sizeof(types));
+		if(ioctl(fd, EVIOCGBIT(0, sizeof(types)), types) < 0)
+		{
+			close(fd);
+			return false;
+		}
+		if(TestBit(types, EV_KEY)) ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(caps.keys)), caps.keys);
+		if(TestBit(types, EV_REL)) ioctl(fd, EVIOCGBIT(EV_REL, sizeof(caps.rel)), caps.rel);
+		if(TestBit(types, EV_ABS))
+		{
+			ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(caps.abs)), caps.abs);
+			for(unsigned int code = 0; code < EvdevAbsCodes; code++)
+			{
+				input_absinfo info;
+				if(!caps.HasAbs(code) || ioctl(fd, EVIOCGABS(code), &info) < 0) continue;
+
+				caps.ranges[code].minimum = info.minimum;
+				caps.ranges[code].maximum = info.maximum;
+				caps.ranges[code].value = info.value;
+			}
+		}
+
+		char name[128] = "";
+		ioctl(fd, EVIOCGNAME(sizeof(name) - 1), name);
+		return AddDevice(fd, caps, name, path);
+	}
+
+	unsigned int EvdevReader::OpenAll(const char* directory)
+	{
+		DIR* dir = opendir(directory);
+		if(!dir) return 0;
+
+		unsigned int count = 0;
+		while(dirent* entry = readdir(dir))
+		{
+			if(strncmp(entry->d_name, "event", 5) != 0) continue;
+
+			char path[512];
+			snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+			if(OpenDevice(path)) count++;
+		}
+		closedir(dir);
+		return count;
+	}
+
+	bool EvdevReader::Watch(const char* dir)
+	{
+		if(epoll < 0 || watch >= 0) return false;
+
+		// Nodes are created by udev and made readable after, so attributes are watched too.
+		int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(fd < 0) return false;
+		if(inotify_add_watch(fd, dir, IN_CREATE | IN_ATTRIB | IN_DELETE) < 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		epoll_event ev;
+		ev.events = EPOLLIN;
+		ev.data.fd = fd;
+		if(epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		lock.Lock();
+		directory = dir;
+		watch = fd;
+		lock.Unlock();
+		return true;
+	}
+
+	unsigned int EvdevReader::GetDeviceCount()
+	{
+		lock.Lock();
+		unsigned int count = (unsigned int)devices.size();
+		lock.Unlock();
+		return count;
+	}
+
+	unsigned int EvdevReader::GetDevices(std::vector<EvdevDeviceInfo>& infos)
+	{
+		infos.clear();
+		lock.Lock();
+		for(size_t i = 0; i < devices.size(); i++)
+		{
+			EvdevDeviceInfo info;
+			memset(&info, 0, sizeof(info));
+			info.kinds = devices[i].kinds;
+			if(devices[i].joystick)
+			{
+				info.type = devices[i].joystick->type;
+				info.id = devices[i].joystick->id;
+			}
+			strncpy(info.name, devices[i].name, sizeof(info.name) - 1);
+			infos.push_back(info);
+		}
+		unsigned int count = changes;
+		lock.Unlock();
+		return count;
+	}
+
+	bool EvdevReader::GetJoystick(unsigned int type, unsigned int id, JoystickRawState& raw,
+								  JoystickLayout& layout, unsigned int& handle)
+	{
+		lock.Lock();
+		for(size_t i = 0; i < devices.size(); i++)
+		{
+			const EvdevJoystickState* joystick = devices[i].joystick;
+			if(!joystick || joystick->type != type || joystick->id != id) continue;
+
+			raw = joystick->raw;
+			layout = joystick->layout;
+			handle = devices[i].handle;
+			lock.Unlock();
+			return true;
+		}
+		lock.Unlock();
+		return false;
+	}
+
+	bool EvdevReader::ReadKeys(int fd, unsigned long* bits, unsigned int size)
+	{
+		return ioctl(fd, EVIOCGKEY(size), bits) >= 0;
+	}
+
+	bool EvdevReader::ReadAbs(int fd, unsigned int code, int& value)
+	{
+		input_absinfo info;
+		if(ioctl(fd, EVIOCGABS(code), &info) < 0) return false;
+		value = info.value;
+		return true;
+	}
+
+	void EvdevReader::Resync(Device& device, unsigned int time)
+	{
+		// Keys that cannot be read are taken as released, so none stays pressed.
+		unsigned long bits[(EvdevKeyCodes + EvdevCapabilities::LongBits - 1) / EvdevCapabilities::LongBits];
+		if(!ReadKeys(device.fd, bits, sizeof(bits))) memset(bits, 0, sizeof(bits));
+
+		if(device.joystick)
+		{
+			EvdevJoystickState& joystick = *device.joystick;
+			for(unsigned int code = 0; code < EvdevKeyCodes; code++)
+			{
+				if(joystick.buttons[code]) joystick.raw.buttons[joystick.buttons[code] - 1] = TestBit(bits, code) ? 0x80 : 0;
+			}
+
+			// Axes that cannot be read keep their last value.
+			for(unsigned int code = 0; code < EvdevAbsCodes; code++)
+			{
+				bool hat = code >= ABS_HAT0X && code <= ABS_HAT3Y;
+				input_event e;
+				if((!hat && joystick.axes[code] < 0) || !ReadAbs(device.fd, code, e.value)) continue;
+
+				e.type = EV_ABS;
+				e.code = (unsigned short)code;
+				EvdevApplyJoystick(joystick, e);
+			}
+		}
+
+		// Changes are recorded as part of the report that ends the dropped events.
+		InputRecord record;
+		record.time = time;
+		record.sequence = sequence;
+		record.type = InputRecordButton;
+
+		if(device.kinds & EvdevMouse)
+		{
+			for(unsigned int i = 0; i < EvdevMouseButtons; i++)
+			{
+				unsigned char pressed = TestBit(bits, EvdevMouseMapper[i]) ? 1 : 0;
+				if(buttons[i] == pressed) continue;
+
+				buttons[i] = pressed;
+				record.id = (unsigned short)i;
+				record.value = pressed;
+				mouseCoalescer.Add(record);
+			}
+		}
+
+		if(device.kinds & EvdevKeyboard)
+		{
+			for(unsigned int code = 0; code < EvdevKeyCodes; code++)
+			{
+				unsigned short index = keyIndex[code];
+				if(!index) continue;
+
+				bool pressed = TestBit(bits, code);
+				if(keys.Get(index) == pressed) continue;
+
+				if(pressed) keys.Set(index);
+				else keys.Reset(index);
+				record.id = index;
+				record.value = pressed ? 1 : 0;
+				keyboardCoalescer.Add(record);
+			}
+		}
+	}
+
+	void EvdevReader::Apply(Device& device, const void* data)
+	{
+		const input_event& e = *(const input_event*)data;
+		unsigned int time = (unsigned int)(e.time.tv_sec * 1000 + e.time.tv_usec / 1000);
+
+		// Kernel buffer overflowed: events up to next report are incomplete and discarded,
+		// then state is read from device.
+		if(e.type == EV_SYN && e.code == SYN_DROPPED)
+		{
+			device.dropped = true;
+			memset(motion, 0, sizeof(motion));
+			return;
+		}
+		if(device.dropped)
+		{
+			if(e.type != EV_SYN || e.code != SYN_REPORT) return;
+
+			device.dropped = false;
+			Resync(device, time);
+		}
+
+		if(device.joystick && EvdevApplyJoystick(*device.joystick, e)) return;
+		if(!(device.kinds & (EvdevKeyboard | EvdevMouse))) return;
+
+		InputRecord record;
+		record.time = time;
+		record.sequence = sequence;
+
+		switch(e.type)
+		{
+		case EV_KEY:
+			{
+				// Repeats (value 2) are not reported, as with DirectInput.
+				if(e.value == 2) return;
+				record.type = InputRecordButton;
+				record.value = e.value ? 1 : 0;
+
+				for(unsigned int i = 0; i < EvdevMouseButtons; i++)
+				{
+					if(EvdevMouseMapper[i] != e.code) continue;
+
+					buttons[i] = (unsigned char)record.value;
+					record.id = (unsigned short)i;
+					mouseCoalescer.Add(record);
+					return;
+				}
+
+				unsigned short index = GetKeyIndex(e.code);
+				if(!index) return;
+
+				if(record.value) keys.Set(index);
+				else keys.Reset(index);
+				record.id = index;
+				keyboardCoalescer.Add(record);
+			}
+			break;
+		case EV_REL:
+			{
+				// High resolution wheel repeats wheel in finer steps.
+				int axis;
+				int value = e.value;
+				if(e.code == REL_X) axis = 0;
+				else if(e.code == REL_Y) axis = 1;
+				else if(e.code == REL_WHEEL)
+				{
+					axis = 2;
+					value *= EvdevWheelDelta;
+				} else return;
+
+				if(axis < 2) counts[axis] += value;
+				motion[axis] += value;
+				motionTime = time;
+
+				record.type = InputRecordAxis;
+				record.id = (unsigned short)axis;
+				record.value = value;
+				mouseCoalescer.Add(record);
+			}
+			break;
+		case EV_SYN:
+			if(e.code == SYN_REPORT)
+			{
+				// Axes of one report are accumulated together.
+				if(motion[0] || motion[1] || motion[2])
+				{
+					accumulator.AddMotion(motion, motionTime);
+					memset(motion, 0, sizeof(motion));
+				}
+				sequence++;
+			}
+			break;
+		}
+	}
+
+	bool EvdevReader::ReadDevice(Device& device)
+	{
+		input_event events[EvdevReadChunk];
+		for(;;)
+		{
+			ssize_t size = read(device.fd, events, sizeof(events));
+			if(size < 0)
+			{
+				if(errno == EINTR) continue;
+				return errno == EAGAIN;
+			}
+
+			// End of file; unplugged devices report ENODEV instead.
+			if(size == 0) return false;
+
+			unsigned int count = (unsigned int)(size / sizeof(input_event));
+			for(unsigned int i = 0; i < count; i++) Apply(device, &events[i]);
+			if(count < EvdevReadChunk) return true;
+		}
+	}
+
+	void EvdevReader::RemoveDevice(unsigned int index)
+	{
+		epoll_ctl(epoll, EPOLL_CTL_DEL, devices[index].fd, 0);
+		close(devices[index].fd);
+		delete devices[index].joystick;
+		devices.erase(devices.begin() + index);
+		Portable::AtomicAdd(&changes, 1);
+	}
+
+	void EvdevReader::ReadWatch()
+	{
+		union
+		{
+			inotify_event event;
+			char bytes[4096];
+		} buffer;
+
+		for(;;)
+		{
+			ssize_t size = read(watch, buffer.bytes, sizeof(buffer.bytes));
+			if(size < 0 && errno == EINTR) continue;
+			if(size <= 0) return;
+
+			for(ssize_t offset = 0; offset < size; )
+			{
+				const inotify_event& e = *(const inotify_event*)(buffer.bytes + offset);
+				offset += sizeof(inotify_event) + e.len;
+				if(e.len == 0 || strncmp(e.name, "event", 5) != 0) continue;
+
+				// Unplugged device may still be read to its end; it is dropped now.
+				std::string path = directory + "/" + e.name;
+				int index = FindPath(path);
+				if(e.mask & IN_DELETE)
+				{
+					if(index >= 0) RemoveDevice((unsigned int)index);
+				} else if(index < 0) {
+					bool pending = false;
+					for(size_t i = 0; i < plugged.size(); i++) pending = pending || plugged[i] == path;
+					if(!pending) plugged.push_back(path);
+				}
+			}
+		}
+	}
+
+	void EvdevReader::Pump()
+	{
+		if(epoll < 0) return;
+
+		// Usual case of no input costs one syscall.
+		lock.Lock();
+		epoll_event ready[EvdevMaxReady];
+		int count = epoll_wait(epoll, ready, EvdevMaxReady, 0);
+		for(int i = 0; i < count; i++)
+		{
+			if(ready[i].data.fd == watch)
+			{
+				ReadWatch();
+				continue;
+			}
+
+			for(unsigned int j = 0; j < devices.size(); j++)
+			{
+				if(devices[j].fd != ready[i].data.fd) continue;
+
+				if(!ReadDevice(devices[j])) RemoveDevice(j);
+				break;
+			}
+		}
+
+		keyboardCoalescer.Flush(keyboardRing);
+		mouseCoalescer.Flush(mouseRing);
+
+		// Devices are opened without lock, adding takes it.
+		std::vector<std::string> opening;
+		opening.swap(plugged);
+		lock.Unlock();
+
+		for(size_t i = 0; i < opening.size(); i++) OpenDevice(opening[i].c_str());
+	}
+
+	EvdevJoystickSource::EvdevJoystickSource(EvdevReader* reader, unsigned int type, unsigned int id)
+		: ring(EvdevRingSize)
+	{
+		this->reader = reader;
+		this->type = type;
+		this->id = id;
+		this->handle = 0;
+		this->sequence = 0;
+		this->settings = JoystickFilter::DefaultSettings();
+		this->settingsChanged = 0;
+	}
+
+	void EvdevJoystickSource::SetSettings(const JoystickSettings& s)
+	{
+		settingsLock.Lock();
+		settings = s;
+		AtomicStore(&settingsChanged, 1);
+		settingsLock.Unlock();
+	}
+
+	JoystickSettings EvdevJoystickSource::GetSettings()
+	{
+		settingsLock.Lock();
+		JoystickSettings s = settings;
+		settingsLock.Unlock();
+		return s;
+	}
+
+	bool EvdevJoystickSource::Sample(InputDeviceState& state)
+	{
+		if(AtomicLoad(&settingsChanged))
+		{
+			settingsLock.Lock();
+			filter.SetSettings(settings);
+			AtomicStore(&settingsChanged, 0);
+			settingsLock.Unlock();
+		}
+
+		reader->Pump();
+
+		JoystickRawState raw;
+		JoystickLayout layout;
+		unsigned int current;
+		if(!reader->GetJoystick(type, id, raw, layout, current)) return false;
+
+		// Another controller took id, or same one was plugged again; its held buttons are
+		// reported as pressed.
+		if(current != handle)
+		{
+			filter.SetLayout(layout);
+			filter.Reset();
+			handle = current;
+		}
+
+		unsigned char changed[JoystickButtonCount];
+		unsigned int count = filter.Apply(raw, state, changed, JoystickButtonCount);
+		if(count == 0) return true;
+
+		// Changes of one sample share sequence, as with DirectInput joysticks.
+		InputRecord record;
+		record.time = (unsigned int)(EvdevGetPollerClock()->Now() * 1000.0);
+		record.sequence = ++sequence;
+		record.type = InputRecordButton;
+		for(unsigned int i = 0; i < count; i++)
+		{
+			record.id = changed[i];
+			record.value = state.buttons[changed[i]];
+			ring.Push(record);
+		}
+		return true;
+	}
+
+	bool EvdevKeyboardSource::Sample(InputDeviceState& state)
+	{
+		reader->Pump();
+
+		state.keys = reader->GetKeys();
+		return true;
+	}
+
+	EvdevMouseSource::EvdevMouseSource(EvdevReader* reader)
+	{
+		this->reader = reader;
+		this->settings = MouseAccumulator::DefaultSettings();
+		this->settingsChanged = 0;
+	}
+
+	void EvdevMouseSource::SetSettings(const MouseSettings& s)
+	{
+		settingsLock.Lock();
+		settings = s;
+		Portable::AtomicStore(&settingsChanged, 1);
+		settingsLock.Unlock();
+	}
+
+	MouseSettings EvdevMouseSource::GetSettings()
+	{
+		settingsLock.Lock();
+		MouseSettings s = settings;
+		settingsLock.Unlock();
+		return s;
+	}
+
+	bool EvdevMouseSource::Sample(InputDeviceState& state)
+	{
+		if(Portable::AtomicLoad(&settingsChanged))
+		{
+			settingsLock.Lock();
+			reader->GetAccumulator().SetSettings(settings);
+			Portable::AtomicStore(&settingsChanged, 0);
+			settingsLock.Unlock();
+		}
+
+		reader->Pump();
+		reader->GetAccumulator().Step();
+
+		memset(state.buttons, 0, sizeof(state.buttons));
+		memset(state.axes, 0, sizeof(state.axes));
+		for(unsigned int i = 0; i < EvdevMouseButtons; i++)
+		{
+			state.buttons[i] = reader->GetButton(i) ? 1 : 0;
+		}
+		for(unsigned int i = 0; i < Portable::MouseAxes; i++)
+		{
+			state.axes[i] = reader->GetAccumulator().GetAxis(i);
+		}
+		return true;
+	}
+
+	EvdevCursorSource::EvdevCursorSource(EvdevReader* reader, unsigned int width, unsigned int height)
+	{
+		this->reader = reader;
+		this->width = width;
+		this->height = height;
+		x = width / 2;
+		y = height / 2;
+		lastCounts[0] = lastCounts[1] = 0;
+		started = false;
+	}
+
+	void EvdevCursorSource::SetBounds(unsigned int w, unsigned int h)
+	{
+		AtomicStore(&width, w);
+		AtomicStore(&height, h);
+	}
+
+	bool EvdevCursorSource::Sample(InputDeviceState& state)
+	{
+		reader->Pump();
+
+		// Motion before first sample does not move cursor from center.
+		long long cx = reader->GetCount(0), cy = reader->GetCount(1);
+		if(!started)
+		{
+			lastCounts[0] = cx;
+			lastCounts[1] = cy;
+			started = true;
+		}
+
+		// Clamped as it moves, so cursor leaves edge as soon as motion turns back. Screen Y
+		// grows down, cursor Y grows up.
+		long long w = AtomicLoad(&width), h = AtomicLoad(&height);
+		x += cx - lastCounts[0];
+		y -= cy - lastCounts[1];
+		lastCounts[0] = cx;
+		lastCounts[1] = cy;
+		if(x < 0) x = 0;
+		if(y < 0) y = 0;
+		if(x > w) x = w;
+		if(y > h) y = h;
+
+		memset(state.buttons, 0, sizeof(state.buttons));
+		memset(state.axes, 0, sizeof(state.axes));
+		state.axes[0] = x;
+		state.axes[1] = y;
+		return true;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,322 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <sched.h>
+#include "../SharpMedia.Input.Driver.Portable/InputEventRing.h"
+#include "../SharpMedia.Input.Driver.Portable/InputPoller.h"
+#include "../SharpMedia.Input.Driver.Portable/MouseAccumulator.h"
+#include "../SharpMedia.Input.Driver.Portable/JoystickFilter.h"
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Evdev {
+
+	using Portable::InputSource;
+	using Portable::InputDeviceState;
+	using Portable::InputEventRing;
+	using Portable::InputCoalescer;
+	using Portable::InputRecord;
+	using Portable::JoystickFilter;
+	using Portable::JoystickLayout;
+	using Portable::JoystickRawState;
+	using Portable::JoystickSettings;
+	using Portable::KeyBitset;
+	using Portable::MouseAccumulator;
+	using Portable::MouseSettings;
+	using Portable::PollerClock;
+
+	// Events read from a device at once.
+	static const unsigned int EvdevReadChunk = 64;
+
+	// Devices ready at once per pump.
+	static const unsigned int EvdevMaxReady = 16;
+
+	// Records of ring between polls and reads of game loop.
+	static const unsigned int EvdevRingSize = 1024;
+
+	// Codes of evdev (KEY_CNT, REL_CNT and ABS_CNT).
+	static const unsigned int EvdevKeyCodes = 0x300;
+	static const unsigned int EvdevRelCodes = 0x10;
+	static const unsigned int EvdevAbsCodes = 0x40;
+
+	static const unsigned int EvdevMouseButtons = 8;
+
+	class EvdevSpinLock
+	{
+		volatile unsigned int locked;
+	public:
+		EvdevSpinLock() { locked = 0; }
+
+		void Lock() { while(Portable::AtomicExchange(&locked, 1)) sched_yield(); }
+		void Unlock() { Portable::AtomicStore(&locked, 0); }
+	};
+
+	enum EvdevDeviceKind
+	{
+		EvdevKeyboard = 1,
+		EvdevMouse = 2,
+		EvdevJoystick = 4
+	};
+
+	// Device types, values of InputDeviceType.
+	static const int EvdevTypeMouse = 1;
+	static const int EvdevTypeKeyboard = 2;
+	static const int EvdevTypeJoystick = 4;
+	static const int EvdevTypeWheel = 8;
+	static const int EvdevTypeFlightstick = 16;
+	static const int EvdevTypeCursor = 32;
+
+	struct EvdevAxisRange
+	{
+		int minimum;
+		int maximum;
+		int value;		//< When device was opened.
+	};
+
+	// What event device reports, as its ioctls tell; filled by hand, it lets pipes stand in
+	// for devices.
+	struct EvdevCapabilities
+	{
+		static const unsigned int LongBits = sizeof(unsigned long) * 8;
+
+		unsigned long keys[(EvdevKeyCodes + LongBits - 1) / LongBits];
+		unsigned long rel[(EvdevRelCodes + LongBits - 1) / LongBits];
+		unsigned long abs[(EvdevAbsCodes + LongBits - 1) / LongBits];
+		EvdevAxisRange ranges[EvdevAbsCodes];
+
+		void Clear();
+
+		bool HasKey(unsigned int code) const;
+		bool HasRel(unsigned int code) const;
+		bool HasAbs(unsigned int code) const;
+		void SetKey(unsigned int code);
+		void SetRel(unsigned int code);
+		void SetAbs(unsigned int code, int minimum, int maximum);
+
+		// EvdevDeviceKind bits of device, 0 when it is none of them.
+		unsigned int GetKinds() const;
+
+		// Keyboard of all key codes, mouse of wheel and 8 buttons and gamepad of kernel
+		// gamepad drivers (two sticks, two triggers, a hat and 11 buttons), as kinds ask.
+		static EvdevCapabilities Standard(unsigned int kinds);
+	};
+
+	// Joystick of reader; state is kept in layout of DirectInput, sticks on X/Y, Z/Rz or
+	// Rx/Ry and throttle, rudder, wheel and pedals on sliders.
+	struct EvdevJoystickState
+	{
+		unsigned int type;						//< EvdevTypeJoystick, Wheel or Flightstick.
+		unsigned int id;						//< Index within type.
+		JoystickLayout layout;
+		JoystickRawState raw;
+		signed char axes[EvdevAbsCodes];		//< Axis of raw state of abs code, -1 if none.
+		EvdevAxisRange ranges[Portable::JoystickAxes];
+		int hats[Portable::JoystickHats][2];	//< X and Y of hat, -1 to 1.
+		unsigned char buttons[EvdevKeyCodes];	//< Button of key code plus one, 0 if none.
+	};
+
+	// Device of reader as service describes it.
+	struct EvdevDeviceInfo
+	{
+		unsigned int kinds;
+		unsigned int type;						//< Of joystick.
+		unsigned int id;						//< Of joystick.
+		char name[64];
+	};
+
+	// Monotonic clock, sleeps to absolute deadlines.
+	PollerClock* EvdevGetPollerClock();
+
+	// Reads keyboards, mice and joysticks of /dev/input through one epoll set. All keyboards
+	// act as system keyboard and all mice as system mouse, like DirectInput system devices;
+	// every joystick is a device of its own. Reads are non blocking and take up to
+	// EvdevReadChunk events per syscall. Watched directory is followed with inotify, so
+	// devices are opened when plugged and dropped when unplugged.
+	//
+	// Pump and state are used by one thread (poller thread, or game thread without it);
+	// rings are read by game thread. List of devices is guarded by lock, it may be read and
+	// added to from any thread.
+	class EvdevReader
+	{
+		struct Device
+		{
+			int fd;
+			unsigned int kinds;
+			unsigned int handle;				//< Unique for life of reader.
+			char name[128];
+			std::string path;					//< Empty for devices not of watched directory.
+			EvdevJoystickState* joystick;		//< Null when device is not a joystick.
+			bool dropped;						//< Events are discarded up to next report.
+		};
+
+		int epoll;
+		int watch;								//< Inotify of watched directory, -1 if none.
+		std::string directory;
+		std::vector<Device> devices;
+		std::vector<std::string> plugged;		//< Paths to open after pump.
+		EvdevSpinLock lock;
+		volatile unsigned int changes;			//< Devices added or removed.
+		unsigned int handles;
+		unsigned short keyIndex[EvdevKeyCodes];	//< Key code of evdev code, 0 if none.
+		unsigned int sequence;
+
+		// Aggregated state of all devices.
+		KeyBitset keys;							//< By key code.
+		unsigned char buttons[EvdevMouseButtons];
+		MouseAccumulator accumulator;
+		long long counts[2];					//< Raw motion of X and Y, for cursor.
+		int motion[Portable::MouseAxes];		//< Motion of current report.
+		unsigned int motionTime;
+
+		InputEventRing keyboardRing;
+		InputEventRing mouseRing;
+		InputCoalescer keyboardCoalescer;
+		InputCoalescer mouseCoalescer;
+
+		void Apply(Device& device, const void* event);
+		void Resync(Device& device, unsigned int time);
+		bool ReadDevice(Device& device);
+		void ReadWatch();
+		int FindPath(const std::string& path) const;
+		void RemoveDevice(unsigned int index);
+
+		EvdevReader(const EvdevReader&);
+		EvdevReader& operator = (const EvdevReader&);
+	public:
+		EvdevReader();
+		virtual ~EvdevReader();
+
+		// False when epoll could not be created.
+		bool IsValid() const { return epoll >= 0; }
+
+		// Takes ownership of fd, which is made non blocking; any readable fd works, so pipes
+		// and files stand in for devices in tests. Device of path already added is refused.
+		bool AddDevice(int fd, const EvdevCapabilities& caps, const char* name, const char* path);
+
+		// Same for standard device of kinds (see EvdevCapabilities::Standard).
+		bool AddDevice(int fd, unsigned int kinds, const char* name);
+
+		// Opens event device and adds it when it is a keyboard, mouse or joystick.
+		virtual bool OpenDevice(const char* path);
+
+		// Pressed keys of device as bits of evdev codes (EVIOCGKEY, size in bytes) and value
+		// of absolute axis (EVIOCGABS); state is read again with them after kernel dropped
+		// events. False when device cannot tell.
+		virtual bool ReadKeys(int fd, unsigned long* bits, unsigned int size);
+		virtual bool ReadAbs(int fd, unsigned int code, int& value);
+
+		// Opens all event devices in directory; returns number added.
+		unsigned int OpenAll(const char* directory);
+
+		// Follows directory from now on; devices plugged later are opened by pump, removed
+		// ones are dropped. False when inotify fails.
+		bool Watch(const char* directory);
+
+		// Reads all pending events of ready devices and changes of watched directory.
+		// Devices that were unplugged are removed.
+		void Pump();
+
+		unsigned int GetDeviceCount();
+
+		// Describes devices; returns number of changes they reflect, see GetChanges.
+		unsigned int GetDevices(std::vector<EvdevDeviceInfo>& devices);
+
+		// Grows every time a device is added or removed.
+		unsigned int GetChanges() { return Portable::AtomicLoad(&changes); }
+
+		// State and layout of joystick of type and id; handle tells devices apart when
+		// another one takes id. False when there is no such joystick.
+		bool GetJoystick(unsigned int type, unsigned int id, JoystickRawState& raw,
+						 JoystickLayout& layout, unsigned int& handle);
+
+		const KeyBitset& GetKeys() const { return keys; }
+		bool GetButton(unsigned int button) const { return buttons[button] != 0; }
+		MouseAccumulator& GetAccumulator() { return accumulator; }
+		long long GetCount(unsigned int axis) const { return counts[axis]; }
+
+		InputEventRing& GetKeyboardRing() { return keyboardRing; }
+		InputEventRing& GetMouseRing() { return mouseRing; }
+
+		// Key code of evdev code, 0 if none.
+		unsigned short GetKeyIndex(unsigned int code) const { return code < EvdevKeyCodes ? keyIndex[code] : 0; }
+	};
+
+	// Sources of poller; they pump reader, so a sample sees all events read before it.
+	class EvdevKeyboardSource : public InputSource
+	{
+		EvdevReader* reader;
+	public:
+		EvdevKeyboardSource(EvdevReader* reader) { this->reader = reader; }
+
+		// Keys are by key code (not scan code as with DirectInput).
+		virtual bool Sample(InputDeviceState& state);
+	};
+
+	// Joystick of type and id, whichever device has them now, so a controller plugged again
+	// is read again. Sampling does not allocate; buttons that changed are buffered.
+	class EvdevJoystickSource : public InputSource
+	{
+		EvdevReader* reader;
+		unsigned int type, id;
+		unsigned int handle;		//< Device whose layout filter has, 0 before first.
+		JoystickFilter filter;
+		InputEventRing ring;
+		unsigned int sequence;
+
+		// Settings are passed to poller thread under spin lock.
+		JoystickSettings settings;
+		EvdevSpinLock settingsLock;
+		volatile unsigned int settingsChanged;
+	public:
+		EvdevJoystickSource(EvdevReader* reader, unsigned int type, unsigned int id);
+
+		virtual bool Sample(InputDeviceState& state);
+
+		InputEventRing& GetRing() { return ring; }
+
+		// Applied from next sample.
+		void SetSettings(const JoystickSettings& settings);
+		JoystickSettings GetSettings();
+	};
+
+	class EvdevMouseSource : public InputSource
+	{
+		EvdevReader* reader;
+
+		// Settings are passed to poller thread under spin lock.
+		MouseSettings settings;
+		EvdevSpinLock settingsLock;
+		volatile unsigned int settingsChanged;
+	public:
+		EvdevMouseSource(EvdevReader* reader);
+
+		virtual bool Sample(InputDeviceState& state);
+
+		// Applied from next sample.
+		void SetSettings(const MouseSettings& settings);
+		MouseSettings GetSettings();
+	};
+
+	// There is no OS cursor without a window system; cursor follows raw mouse motion
+	// clamped to window, with Y up as with DirectInput cursor.
+	class EvdevCursorSource : public InputSource
+	{
+		EvdevReader* reader;
+		volatile unsigned int width, height;
+		long long x, y;
+		long long lastCounts[2];
+		bool started;
+	public:
+		EvdevCursorSource(EvdevReader* reader, unsigned int width, unsigned int height);
+
+		virtual bool Sample(InputDeviceState& state);
+
+		// May be called from any thread.
+		void SetBounds(unsigned int width, unsigned int height);
+	};
+
+}
+}
+}
+}
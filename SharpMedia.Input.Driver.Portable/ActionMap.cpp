@@ -0,0 +1,403 @@
+#include "ActionMap.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	static const unsigned int ActionButtonInputs = ActionMaxDevices * InputMaxButtons;
+	static const unsigned int ActionAxisInputs = ActionMaxDevices * InputMaxAxes;
+
+	ActionBinding ActionMap::DefaultBinding()
+	{
+		ActionBinding b;
+		memset(&b, 0, sizeof(b));
+		b.kind = ActionPress;
+		b.threshold = 0.25;
+		b.scale = 1.0f;
+		return b;
+	}
+
+	ActionMap::ActionMap()
+	{
+		modifierSlots.assign(ActionButtonInputs, 0);
+		modifierButtons = 0;
+		heldModifiers = 0;
+		frame = 1;
+		compiled = false;
+		for(unsigned int i = 0; i < ActionMaxDevices; i++) devices[i].known = false;
+	}
+
+	void ActionMap::Clear()
+	{
+		bindings.clear();
+		actions.clear();
+		events.clear();
+		touched.clear();
+		armed.clear();
+		modifierSlots.assign(ActionButtonInputs, 0);
+		modifierButtons = 0;
+		heldModifiers = 0;
+		compiled = false;
+	}
+
+	int ActionMap::AddBinding(const ActionBinding& desc)
+	{
+		unsigned int inputs = desc.kind == ActionAxis ? ActionAxisInputs : ActionButtonInputs;
+		if(desc.kind > ActionAxis || desc.input >= inputs || desc.modifierCount > ActionMaxModifiers) return -1;
+
+		// Modifier buttons get bits on first use; a rejected binding may leave bits used.
+		unsigned int required = 0;
+		for(unsigned int i = 0; i < desc.modifierCount; i++)
+		{
+			unsigned int modifier = desc.modifiers[i];
+			if(modifier >= ActionButtonInputs) return -1;
+			if(!modifierSlots[modifier])
+			{
+				if(modifierButtons == ActionMaxModifierButtons) return -1;
+				modifierSlots[modifier] = (unsigned char)(++modifierButtons);
+			}
+			required |= 1u << (modifierSlots[modifier] - 1);
+		}
+
+		Binding binding;
+		binding.desc = desc;
+		binding.required = required;
+		binding.weight = 0;
+		for(unsigned int bits = required; bits; bits &= bits - 1) binding.weight++;
+		binding.down = false;
+		binding.fired = false;
+		binding.pressTime = 0.0;
+		binding.lastTap = -1.0;
+		bindings.push_back(binding);
+
+		if(desc.action >= actions.size())
+		{
+			Action empty;
+			memset(&empty, 0, sizeof(empty));
+			actions.resize(desc.action + 1, empty);
+		}
+		if(desc.kind == ActionAxis && desc.absolute) actions[desc.action].absolute = true;
+
+		compiled = false;
+		return (int)bindings.size() - 1;
+	}
+
+	void ActionMap::Compile()
+	{
+		buttonOffsets.assign(ActionButtonInputs + 1, 0);
+		axisOffsets.assign(ActionAxisInputs + 1, 0);
+
+		// Counting sort of bindings by input.
+		for(size_t i = 0; i < bindings.size(); i++)
+		{
+			const ActionBinding& d = bindings[i].desc;
+			if(d.kind == ActionAxis) axisOffsets[d.input + 1]++;
+			else buttonOffsets[d.input + 1]++;
+		}
+		for(unsigned int i = 0; i < ActionButtonInputs; i++) buttonOffsets[i + 1] += buttonOffsets[i];
+		for(unsigned int i = 0; i < ActionAxisInputs; i++) axisOffsets[i + 1] += axisOffsets[i];
+
+		buttonEntries.assign(buttonOffsets[ActionButtonInputs], 0);
+		axisEntries.assign(axisOffsets[ActionAxisInputs], 0);
+
+		std::vector<unsigned int> buttonFill(buttonOffsets.begin(), buttonOffsets.end() - 1);
+		std::vector<unsigned int> axisFill(axisOffsets.begin(), axisOffsets.end() - 1);
+		for(size_t i = 0; i < bindings.size(); i++)
+		{
+			const ActionBinding& d = bindings[i].desc;
+			if(d.kind == ActionAxis) axisEntries[axisFill[d.input]++] = (unsigned int)i;
+			else buttonEntries[buttonFill[d.input]++] = (unsigned int)i;
+		}
+
+		// Bindings of input with more modifiers come first; inputs have few bindings.
+		for(unsigned int input = 0; input < ActionButtonInputs; input++)
+		{
+			for(unsigned int i = buttonOffsets[input] + 1; i < buttonOffsets[input + 1]; i++)
+			{
+				unsigned int entry = buttonEntries[i];
+				unsigned int j = i;
+				for(; j > buttonOffsets[input] && bindings[buttonEntries[j - 1]].weight < bindings[entry].weight; j--)
+				{
+					buttonEntries[j] = buttonEntries[j - 1];
+				}
+				buttonEntries[j] = entry;
+			}
+		}
+
+		compiled = true;
+	}
+
+	void ActionMap::Touch(unsigned int action)
+	{
+		if(actions[action].frame == frame) return;
+
+		actions[action].frame = frame;
+		touched.push_back(action);
+	}
+
+	void ActionMap::Fire(Binding& binding, float value)
+	{
+		Touch(binding.desc.action);
+		actions[binding.desc.action].state.triggers++;
+
+		ActionEvent ev;
+		ev.action = binding.desc.action;
+		ev.kind = binding.desc.kind;
+		ev.value = value;
+		events.push_back(ev);
+	}
+
+	void ActionMap::Hold(Binding& binding, bool hold)
+	{
+		ActionState& state = actions[binding.desc.action].state;
+		if(hold) state.held++;
+		else if(state.held) state.held--;
+
+		if(!actions[binding.desc.action].absolute) state.value = state.held ? 1.0f : 0.0f;
+		Touch(binding.desc.action);
+	}
+
+	void ActionMap::BeginFrame(double time)
+	{
+		if(!compiled) Compile();
+
+		// Only actions changed in previous frame are reset; changes of relative axes end.
+		for(size_t i = 0; i < touched.size(); i++)
+		{
+			Action& action = actions[touched[i]];
+			action.state.triggers = 0;
+			if(!action.absolute) action.state.value = action.state.held ? 1.0f : 0.0f;
+		}
+		touched.clear();
+		events.clear();
+		frame++;
+
+		// Only holds that are pressed are checked.
+		for(size_t i = 0; i < armed.size(); )
+		{
+			Binding& b = bindings[armed[i]];
+			if(b.down && time - b.pressTime < b.desc.threshold)
+			{
+				i++;
+				continue;
+			}
+
+			if(b.down)
+			{
+				b.fired = true;
+				Hold(b, true);
+				Fire(b, 1.0f);
+			}
+			armed[i] = armed.back();
+			armed.pop_back();
+		}
+	}
+
+	void ActionMap::Button(unsigned int input, bool pressed, double time)
+	{
+		unsigned int begin = buttonOffsets[input], end = buttonOffsets[input + 1];
+		if(begin == end) return;
+
+		if(pressed)
+		{
+			int best = -1;
+			for(unsigned int i = begin; i < end; i++)
+			{
+				Binding& b = bindings[buttonEntries[i]];
+				if(b.desc.kind == ActionRelease || (b.required & ~heldModifiers)) continue;
+				if(best >= 0 && (int)b.weight < best) break;
+				best = (int)b.weight;
+
+				switch(b.desc.kind)
+				{
+				case ActionPress:
+					b.down = true;
+					Hold(b, true);
+					Fire(b, 1.0f);
+					break;
+				case ActionHold:
+					b.down = true;
+					b.fired = false;
+					b.pressTime = time;
+					armed.push_back(buttonEntries[i]);
+					break;
+				case ActionDoubleTap:
+					if(b.lastTap >= 0.0 && time - b.lastTap <= b.desc.threshold)
+					{
+						Fire(b, 1.0f);
+						b.lastTap = -1.0;
+					} else {
+						b.lastTap = time;
+					}
+					break;
+				}
+			}
+			return;
+		}
+
+		// Held bindings are released whatever modifiers are held now.
+		int best = -1;
+		for(unsigned int i = begin; i < end; i++)
+		{
+			Binding& b = bindings[buttonEntries[i]];
+			if(b.down)
+			{
+				b.down = false;
+				if(b.desc.kind == ActionPress || b.fired) Hold(b, false);
+				b.fired = false;
+			}
+
+			if(b.desc.kind != ActionRelease || (b.required & ~heldModifiers)) continue;
+			if(best >= 0 && (int)b.weight < best) continue;
+			best = (int)b.weight;
+			Fire(b, 1.0f);
+		}
+	}
+
+	void ActionMap::Change(unsigned int device, unsigned int button, bool pressed, double time)
+	{
+		Device& d = devices[device];
+		if(pressed) d.buttons.Set(button);
+		else d.buttons.Reset(button);
+
+		unsigned int slot = modifierSlots[ActionButton(device, button)];
+		if(slot)
+		{
+			if(pressed) heldModifiers |= 1u << (slot - 1);
+			else heldModifiers &= ~(1u << (slot - 1));
+		}
+		Button(ActionButton(device, button), pressed, time);
+	}
+
+	void ActionMap::ApplyRecords(unsigned int device, const InputRecord* records, unsigned int count,
+								 double time)
+	{
+		if(device >= ActionMaxDevices || !devices[device].known) return;
+		if(!compiled) Compile();
+
+		Device& d = devices[device];
+		for(unsigned int i = 0; i < count; i++)
+		{
+			const InputRecord& r = records[i];
+			if(r.type != InputRecordButton || r.id >= InputMaxButtons) continue;
+
+			// Spacing of records is kept, clamped to time since previous update; clock of
+			// device wraps, so only differences of ticks are used.
+			double at = d.hasRecord ? d.recordTime + (double)(int)(r.time - d.recordTick) * 0.001 : time;
+			if(at < d.time) at = d.time;
+			if(at > time) at = time;
+			d.hasRecord = true;
+			d.recordTick = r.time;
+			d.recordTime = at;
+
+			bool pressed = r.value != 0;
+			if(d.buttons.Get(r.id) != pressed) Change(device, r.id, pressed, at);
+		}
+	}
+
+	void ActionMap::Axis(unsigned int input, long long value, long long previous)
+	{
+		for(unsigned int i = axisOffsets[input]; i < axisOffsets[input + 1]; i++)
+		{
+			Binding& b = bindings[axisEntries[i]];
+			if(b.required & ~heldModifiers) continue;
+
+			ActionState& state = actions[b.desc.action].state;
+			if(b.desc.absolute)
+			{
+				state.value = (float)value * b.desc.scale;
+				Fire(b, state.value);
+			} else {
+				// Changes of frame add up, next frame starts again.
+				float delta = (float)(value - previous) * b.desc.scale;
+				state.value += delta;
+				Fire(b, delta);
+			}
+		}
+	}
+
+	void ActionMap::UpdateDevice(unsigned int device, const KeyBitset& buttons, const long long* axes,
+								 unsigned int axisCount, double time)
+	{
+		if(device >= ActionMaxDevices) return;
+		if(!compiled) Compile();
+
+		Device& d = devices[device];
+		if(axisCount > InputMaxAxes) axisCount = InputMaxAxes;
+		if(!d.known)
+		{
+			// Buttons already held are not pressed now, but they count as modifiers.
+			d.buttons.Clear();
+			memset(d.axes, 0, sizeof(d.axes));
+			for(unsigned int i = 0; i < axisCount; i++) d.axes[i] = axes[i];
+			d.known = true;
+			d.time = time;
+			d.hasRecord = false;
+
+			unsigned char held[InputMaxButtons];
+			unsigned int count = KeyBitsetList(buttons, held, InputMaxButtons);
+			for(unsigned int i = 0; i < count; i++)
+			{
+				unsigned int slot = modifierSlots[ActionButton(device, held[i])];
+				if(slot) heldModifiers |= 1u << (slot - 1);
+			}
+			d.buttons = buttons;
+			return;
+		}
+
+		unsigned char changed[InputMaxButtons];
+		unsigned int count = KeyBitsetDiff(d.buttons, buttons, changed, InputMaxButtons);
+
+		// Modifiers first, so modifier and button pressed in same sample form a chord.
+		for(unsigned int i = 0; i < count; i++)
+		{
+			unsigned int slot = modifierSlots[ActionButton(device, changed[i])];
+			if(!slot) continue;
+
+			if(buttons.Get(changed[i])) heldModifiers |= 1u << (slot - 1);
+			else heldModifiers &= ~(1u << (slot - 1));
+		}
+		for(unsigned int i = 0; i < count; i++)
+		{
+			Button(ActionButton(device, changed[i]), buttons.Get(changed[i]), time);
+		}
+		d.buttons = buttons;
+		d.time = time;
+
+		for(unsigned int i = 0; i < axisCount; i++)
+		{
+			if(axes[i] == d.axes[i]) continue;
+
+			Axis(ActionAxisInput(device, i), axes[i], d.axes[i]);
+			d.axes[i] = axes[i];
+		}
+	}
+
+	void ActionMap::ResetDevice(unsigned int device)
+	{
+		if(device >= ActionMaxDevices || !devices[device].known) return;
+		if(!compiled) Compile();
+
+		// Held buttons are released, so actions do not stay held.
+		Device& d = devices[device];
+		unsigned char held[InputMaxButtons];
+		unsigned int count = KeyBitsetList(d.buttons, held, InputMaxButtons);
+		for(unsigned int i = 0; i < count; i++)
+		{
+			unsigned int slot = modifierSlots[ActionButton(device, held[i])];
+			if(slot) heldModifiers &= ~(1u << (slot - 1));
+		}
+		for(unsigned int i = 0; i < count; i++)
+		{
+			Button(ActionButton(device, held[i]), false, 0.0);
+		}
+
+		d.known = false;
+	}
+
+}
+}
+}
+}
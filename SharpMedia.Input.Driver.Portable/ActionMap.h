@@ -0,0 +1,156 @@
+#pragma once
+#include <vector>
+#include "InputPoller.h"
+#include "InputEventRing.h"
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	enum ActionTriggerKind
+	{
+		ActionPress = 0,			//< Fires on press, action is held while pressed.
+		ActionRelease = 1,			//< Fires on release.
+		ActionHold = 2,				//< Fires after held for threshold, action is held until release.
+		ActionDoubleTap = 3,		//< Fires on second press within threshold.
+		ActionAxis = 4				//< Value follows axis.
+	};
+
+	static const unsigned int ActionMaxDevices = 16;
+	static const unsigned int ActionMaxModifiers = 4;
+
+	// Modifier buttons of all bindings are kept as bits of one word.
+	static const unsigned int ActionMaxModifierButtons = 32;
+
+	// Inputs of map are numbered over all devices.
+	inline unsigned int ActionButton(unsigned int device, unsigned int button) { return device * InputMaxButtons + button; }
+	inline unsigned int ActionAxisInput(unsigned int device, unsigned int axis) { return device * InputMaxAxes + axis; }
+
+	struct ActionBinding
+	{
+		unsigned int action;
+		unsigned int kind;							//< ActionTriggerKind.
+		unsigned int input;							//< ActionButton, or ActionAxisInput for axes.
+		unsigned int modifiers[ActionMaxModifiers];	//< Buttons held with input (modifiers, chords).
+		unsigned int modifierCount;
+		double threshold;							//< Seconds of hold or between taps.
+		float scale;								//< Axis value per unit.
+		bool absolute;								//< Axis position instead of its change per frame.
+	};
+
+	struct ActionState
+	{
+		float value;				//< Axis value, or 1 while held.
+		unsigned int held;			//< Bindings holding action.
+		unsigned int triggers;		//< Times fired in this frame.
+	};
+
+	struct ActionEvent
+	{
+		unsigned int action;
+		unsigned int kind;
+		float value;
+	};
+
+	// Maps device inputs to actions. Bindings are compiled to tables indexed by input, so a
+	// frame costs work for inputs that changed (found by diffing bitsets) and held hold
+	// bindings only, not for all bindings. When several bindings of an input match, only those
+	// with most modifiers fire, so Ctrl+S does not also fire S.
+	class ActionMap
+	{
+		struct Binding
+		{
+			ActionBinding desc;
+			unsigned int required;		//< Bits of modifier buttons.
+			unsigned int weight;		//< Number of modifiers.
+			bool down;
+			bool fired;					//< Hold that fired and holds action.
+			double pressTime;
+			double lastTap;
+		};
+
+		struct Action
+		{
+			ActionState state;
+			unsigned int frame;			//< Last frame action changed in.
+			bool absolute;				//< Has absolute axis, value is kept between frames.
+		};
+
+		struct Device
+		{
+			KeyBitset buttons;
+			long long axes[InputMaxAxes];
+			bool known;
+			double time;				//< Of last update.
+			bool hasRecord;
+			unsigned int recordTick;	//< Time of last record, clock of device.
+			double recordTime;			//< Same in time of map.
+		};
+
+		std::vector<Binding> bindings;
+		std::vector<Action> actions;
+		std::vector<ActionEvent> events;
+		std::vector<unsigned int> touched;	//< Actions changed in this frame.
+		std::vector<unsigned int> armed;	//< Hold bindings waiting for threshold.
+		Device devices[ActionMaxDevices];
+
+		// Compiled tables; entries of input are in entries[offsets[input], offsets[input + 1]).
+		std::vector<unsigned int> buttonOffsets;
+		std::vector<unsigned int> axisOffsets;
+		std::vector<unsigned int> buttonEntries;
+		std::vector<unsigned int> axisEntries;
+		std::vector<unsigned char> modifierSlots;	//< Bit of button plus one, 0 when not modifier.
+		unsigned int modifierButtons;
+		unsigned int heldModifiers;
+		unsigned int frame;
+		bool compiled;
+
+		void Touch(unsigned int action);
+		void Fire(Binding& binding, float value);
+		void Hold(Binding& binding, bool hold);
+		void Button(unsigned int input, bool pressed, double time);
+		void Change(unsigned int device, unsigned int button, bool pressed, double time);
+		void Axis(unsigned int input, long long value, long long previous);
+	public:
+		ActionMap();
+
+		// Returns index of binding, or -1 when it is invalid or there are too many modifiers.
+		int AddBinding(const ActionBinding& binding);
+		void Clear();
+		unsigned int GetBindingCount() const { return (unsigned int)bindings.size(); }
+
+		// Builds tables; done by first update after bindings changed.
+		void Compile();
+
+		// Resets events of previous frame and fires holds that reached threshold.
+		void BeginFrame(double time);
+
+		// Applies buffered button records of device in order, before its state, so a press
+		// and release within one frame and taps between updates are not lost. Records are
+		// timed by their timestamps, between previous update and this one. Records that agree
+		// with buttons already applied do nothing, so state of same sample may follow.
+		void ApplyRecords(unsigned int device, const InputRecord* records, unsigned int count,
+						  double time);
+
+		// Applies state of device; first state of device is only remembered. Buttons that
+		// records missed (lost, or device has none) are found by diffing it.
+		void UpdateDevice(unsigned int device, const KeyBitset& buttons, const long long* axes,
+						  unsigned int axisCount, double time);
+
+		// Forgets state of device, for example when it is removed.
+		void ResetDevice(unsigned int device);
+
+		unsigned int GetActionCount() const { return (unsigned int)actions.size(); }
+		const ActionState& GetAction(unsigned int action) const { return actions[action].state; }
+
+		// Actions fired in this frame, in order.
+		const std::vector<ActionEvent>& GetEvents() const { return events; }
+
+		static ActionBinding DefaultBinding();
+	};
+
+}
+}
+}
+}
@@ -0,0 +1,62 @@
+#include "DeviceAcquisition.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	const double DeviceAcquisition::MinBackoff = 0.05;
+	const double DeviceAcquisition::MaxBackoff = 2.0;
+
+	DeviceAcquisition::DeviceAcquisition()
+	{
+		acquired = true;
+		backoff = 0.0;
+		nextAttempt = 0.0;
+		gained = 0;
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	bool DeviceAcquisition::ShouldAttempt(double now, unsigned int focusGained)
+	{
+		if(acquired) return false;
+
+		// Device usually can be acquired again after focus is gained.
+		if(focusGained != gained)
+		{
+			gained = focusGained;
+			backoff = 0.0;
+			return true;
+		}
+		return backoff == 0.0 || now >= nextAttempt;
+	}
+
+	void DeviceAcquisition::Acquired()
+	{
+		stats.attempts++;
+		acquired = true;
+		backoff = 0.0;
+	}
+
+	void DeviceAcquisition::Failed(double now)
+	{
+		stats.attempts++;
+		stats.failures++;
+		acquired = false;
+
+		backoff = backoff == 0.0 ? MinBackoff : backoff * 2.0;
+		if(backoff > MaxBackoff) backoff = MaxBackoff;
+		nextAttempt = now + backoff;
+	}
+
+	void DeviceAcquisition::Lost()
+	{
+		stats.losses++;
+		acquired = false;
+	}
+
+}
+}
+}
+}
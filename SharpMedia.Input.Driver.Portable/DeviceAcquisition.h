@@ -0,0 +1,50 @@
+#pragma once
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	struct AcquisitionStats
+	{
+		unsigned int attempts;		//< Acquires tried.
+		unsigned int failures;		//< Acquires that failed.
+		unsigned int losses;		//< Times acquired device could not be read.
+	};
+
+	// Acquisition of a device that can be lost (window in background, device taken by other
+	// application). Lost device is acquired again at once; when that fails, attempts back off
+	// exponentially, so an unfocused window does not cost an acquire every sample. Focus
+	// gain (see InputFocusState) makes next attempt immediate again.
+	class DeviceAcquisition
+	{
+		bool acquired;
+		double backoff;				//< Seconds to wait after next failure, 0 before first.
+		double nextAttempt;
+		unsigned int gained;		//< Focus gains seen.
+		AcquisitionStats stats;
+	public:
+		DeviceAcquisition();
+
+		// Device is acquired when created.
+		bool IsAcquired() const { return acquired; }
+
+		// True when acquire should be tried now; focusGained is InputFocusState::GetGained.
+		bool ShouldAttempt(double now, unsigned int focusGained);
+
+		void Acquired();
+		void Failed(double now);
+
+		// Device could not be read.
+		void Lost();
+
+		const AcquisitionStats& GetStats() const { return stats; }
+
+		static const double MinBackoff;		//< Seconds after first failure.
+		static const double MaxBackoff;
+	};
+
+}
+}
+}
+}
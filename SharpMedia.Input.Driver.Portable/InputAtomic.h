@@ -0,0 +1,63 @@
+#pragma once
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	// Values shared by input threads. Data written before a store is visible to thread that
+	// loads stored value, and all operations are in one order seen by every thread (poller
+	// relies on it when removing sources). Only for native code; volatile on x86 MSVC already
+	// orders accesses, barrier only stops compiler.
+#ifdef _MSC_VER
+	inline unsigned int AtomicLoad(volatile unsigned int* p)
+	{
+		unsigned int value = *p;
+		_ReadWriteBarrier();
+		return value;
+	}
+
+	inline void AtomicStore(volatile unsigned int* p, unsigned int value)
+	{
+		_ReadWriteBarrier();
+		*p = value;
+	}
+
+	inline unsigned int AtomicExchange(volatile unsigned int* p, unsigned int value)
+	{
+		return (unsigned int)_InterlockedExchange((volatile long*)p, (long)value);
+	}
+
+	inline unsigned int AtomicAdd(volatile unsigned int* p, int value)
+	{
+		return (unsigned int)_InterlockedExchangeAdd((volatile long*)p, (long)value) + value;
+	}
+#else
+	inline unsigned int AtomicLoad(volatile unsigned int* p)
+	{
+		return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+	}
+
+	inline void AtomicStore(volatile unsigned int* p, unsigned int value)
+	{
+		__atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+	}
+
+	inline unsigned int AtomicExchange(volatile unsigned int* p, unsigned int value)
+	{
+		return __atomic_exchange_n(p, value, __ATOMIC_SEQ_CST);
+	}
+
+	inline unsigned int AtomicAdd(volatile unsigned int* p, int value)
+	{
+		return __atomic_add_fetch(p, (unsigned int)value, __ATOMIC_SEQ_CST);
+	}
+#endif
+
+}
+}
+}
+}
@@ -0,0 +1,102 @@
+#include "InputEventRing.h"
+#include "InputAtomic.h"
+#include <cstddef>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	InputEventRing::InputEventRing(unsigned int capacity)
+	{
+		unsigned int size = 2;
+		while(size < capacity) size <<= 1;
+
+		records = new InputRecord[size];
+		mask = size - 1;
+		head = tail = 0;
+		overflows = 0;
+	}
+
+	InputEventRing::~InputEventRing()
+	{
+		delete [] records;
+	}
+
+	bool InputEventRing::Push(const InputRecord& record)
+	{
+		// Indices run freely and wrap, difference is count.
+		unsigned int h = head;
+		if(h - AtomicLoad(&tail) > mask)
+		{
+			overflows = overflows + 1;
+			return false;
+		}
+
+		records[h & mask] = record;
+		AtomicStore(&head, h + 1);
+		return true;
+	}
+
+	unsigned int InputEventRing::Pop(InputRecord* out, unsigned int max)
+	{
+		unsigned int t = tail;
+		unsigned int count = AtomicLoad(&head) - t;
+		if(count > max) count = max;
+
+		for(unsigned int i = 0; i < count; i++)
+		{
+			out[i] = records[(t + i) & mask];
+		}
+
+		AtomicStore(&tail, t + count);
+		return count;
+	}
+
+	unsigned int InputEventRing::GetCount() const
+	{
+		return head - tail;
+	}
+
+	InputCoalescer::InputCoalescer(bool enabled)
+	{
+		this->enabled = enabled;
+	}
+
+	void InputCoalescer::Add(const InputRecord& record)
+	{
+		if(enabled && record.type == InputRecordAxis)
+		{
+			for(size_t i = pending.size(); i > 0; i--)
+			{
+				InputRecord& previous = pending[i - 1];
+				if(previous.type == InputRecordButton) break;
+				if(previous.id != record.id) continue;
+
+				// Merged record takes time of latest motion.
+				previous.value += record.value;
+				previous.time = record.time;
+				previous.sequence = record.sequence;
+				return;
+			}
+		}
+
+		pending.push_back(record);
+	}
+
+	unsigned int InputCoalescer::Flush(InputEventRing& ring)
+	{
+		unsigned int dropped = 0;
+		for(size_t i = 0; i < pending.size(); i++)
+		{
+			if(!ring.Push(pending[i])) dropped++;
+		}
+
+		pending.clear();
+		return dropped;
+	}
+
+}
+}
+}
+}
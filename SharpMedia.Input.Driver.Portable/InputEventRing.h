@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	enum InputRecordType
+	{
+		InputRecordButton = 0,
+		InputRecordAxis = 1
+	};
+
+	struct InputRecord
+	{
+		unsigned int time;			//< Milliseconds, clock of device.
+		unsigned int sequence;		//< Records with same sequence happened at once.
+		unsigned short type;		//< InputRecordType.
+		unsigned short id;			//< Button or axis index of device.
+		int value;					//< Button state (0 or 1) or axis delta.
+	};
+
+	// Lock free ring with one producer (thread reading device) and one consumer (game loop).
+	class InputEventRing
+	{
+		InputRecord* records;
+		unsigned int mask;
+		volatile unsigned int head;		//< Next write, changed only by producer.
+		volatile unsigned int tail;		//< Next read, changed only by consumer.
+		volatile unsigned int overflows;
+
+		InputEventRing(const InputEventRing&);
+		InputEventRing& operator = (const InputEventRing&);
+	public:
+		// Capacity is rounded up to power of two.
+		InputEventRing(unsigned int capacity);
+		~InputEventRing();
+
+		// Producer; returns false and counts overflow when ring is full.
+		bool Push(const InputRecord& record);
+
+		// Consumer; returns number of records read, oldest first.
+		unsigned int Pop(InputRecord* records, unsigned int max);
+
+		unsigned int GetCapacity() const { return mask + 1; }
+		unsigned int GetCount() const;
+
+		// Records lost because consumer did not keep up.
+		unsigned int GetOverflows() const { return overflows; }
+	};
+
+	// Collects records of one device read and merges axis deltas before they are pushed,
+	// so mouse moves do not fill the ring. Axis records are merged only with records of same
+	// axis that are not followed by a button record, so order of buttons and motion holds.
+	class InputCoalescer
+	{
+		std::vector<InputRecord> pending;
+		bool enabled;
+	public:
+		InputCoalescer(bool enabled = true);
+
+		void SetEnabled(bool enabled) { this->enabled = enabled; }
+		bool IsEnabled() const { return enabled; }
+
+		void Add(const InputRecord& record);
+
+		// Pushes collected records to ring; returns number that did not fit.
+		unsigned int Flush(InputEventRing& ring);
+
+		unsigned int GetPendingCount() const { return (unsigned int)pending.size(); }
+	};
+
+}
+}
+}
+}
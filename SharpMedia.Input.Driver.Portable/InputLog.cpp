@@ -0,0 +1,411 @@
+#include "InputLog.h"
+#include <cstring>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	static const unsigned char InputLogMagic[4] = { 'S', 'M', 'I', 'L' };
+	static const size_t InputLogHeaderSize = 5;
+
+	// Events applied but not read by replay are dropped beyond this, oldest first.
+	static const size_t InputLogMaxPending = 4096;
+
+	static unsigned long long ZigZag(long long value)
+	{
+		return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+	}
+
+	static long long UnZigZag(unsigned long long value)
+	{
+		return (long long)(value >> 1) ^ -(long long)(value & 1);
+	}
+
+	static long long ToMicroseconds(double seconds)
+	{
+		double us = seconds * 1000000.0;
+		return (long long)(us < 0.0 ? us - 0.5 : us + 0.5);
+	}
+
+	InputLogWriter::InputLogWriter()
+	{
+		for(unsigned int i = 0; i < 4; i++) data.push_back(InputLogMagic[i]);
+		data.push_back((unsigned char)InputLogVersion);
+		lastTime = -1;
+	}
+
+	void InputLogWriter::WriteVarint(unsigned long long value)
+	{
+		while(value >= 0x80)
+		{
+			data.push_back((unsigned char)(value | 0x80));
+			value >>= 7;
+		}
+		data.push_back((unsigned char)value);
+	}
+
+	void InputLogWriter::WriteSigned(long long value)
+	{
+		WriteVarint(ZigZag(value));
+	}
+
+	void InputLogWriter::WriteHeader(InputLogEntryKind kind, unsigned int device, double time)
+	{
+		// First entry is origin of log; time that goes back counts as no time.
+		long long us = ToMicroseconds(time);
+		long long delta = lastTime < 0 || us < lastTime ? 0 : us - lastTime;
+		if(lastTime < 0 || us > lastTime) lastTime = us;
+
+		WriteVarint(((unsigned long long)device << 2) | (unsigned long long)kind);
+		WriteVarint((unsigned long long)delta);
+	}
+
+	int InputLogWriter::AddDevice(const InputLogDeviceInfo& info)
+	{
+		if(info.buttons > InputLogMaxButtons || info.axes > InputLogMaxAxes) return -1;
+
+		Device device;
+		device.info = info;
+		device.state.buttons.assign(info.buttons, 0);
+		device.state.axes.assign(info.axes, 0);
+		device.hasState = false;
+		device.eventTime = 0;
+		device.eventSequence = 0;
+		devices.push_back(device);
+
+		unsigned int index = (unsigned int)devices.size() - 1;
+		WriteHeader(InputLogDevice, index, lastTime < 0 ? 0.0 : lastTime * 0.000001);
+		WriteVarint(info.type);
+		WriteVarint(info.id);
+		WriteVarint(info.buttons);
+		WriteVarint(info.axes);
+		return (int)index;
+	}
+
+	void InputLogWriter::WriteState(unsigned int index, double time, const unsigned char* buttons,
+									const long long* axes)
+	{
+		if(index >= devices.size()) return;
+		Device& device = devices[index];
+
+		// Changed buttons are written as gaps between their indices; they toggle.
+		unsigned int changed = 0;
+		for(unsigned int i = 0; i < device.info.buttons; i++)
+		{
+			if((buttons[i] != 0) != (device.state.buttons[i] != 0)) changed++;
+		}
+
+		unsigned int axisMask = 0;
+		for(unsigned int i = 0; i < device.info.axes; i++)
+		{
+			if(axes[i] != device.state.axes[i]) axisMask |= 1u << i;
+		}
+
+		// Unchanged state is not written, except first one which marks start of device.
+		if(changed == 0 && axisMask == 0 && device.hasState) return;
+		device.hasState = true;
+
+		WriteHeader(InputLogState, index, time);
+		WriteVarint(changed);
+		unsigned int previous = 0;
+		for(unsigned int i = 0; i < device.info.buttons; i++)
+		{
+			unsigned char pressed = buttons[i] ? 1 : 0;
+			if(pressed == device.state.buttons[i]) continue;
+
+			WriteVarint(i - previous);
+			previous = i;
+			device.state.buttons[i] = pressed;
+		}
+
+		WriteVarint(axisMask);
+		for(unsigned int i = 0; i < device.info.axes; i++)
+		{
+			if(!(axisMask & (1u << i))) continue;
+
+			WriteSigned((long long)((unsigned long long)axes[i] - (unsigned long long)device.state.axes[i]));
+			device.state.axes[i] = axes[i];
+		}
+	}
+
+	void InputLogWriter::WriteEvents(unsigned int index, double time, const InputRecord* records,
+									 unsigned int count)
+	{
+		if(index >= devices.size() || count == 0) return;
+		Device& device = devices[index];
+
+		WriteHeader(InputLogEvents, index, time);
+		WriteVarint(count);
+		for(unsigned int i = 0; i < count; i++)
+		{
+			const InputRecord& r = records[i];
+			WriteVarint(r.type);
+			WriteVarint(r.id);
+			WriteSigned(r.value);
+			WriteSigned((int)(r.time - device.eventTime));
+			WriteSigned((int)(r.sequence - device.eventSequence));
+			device.eventTime = r.time;
+			device.eventSequence = r.sequence;
+		}
+	}
+
+	InputReplayer::InputReplayer(const unsigned char* d, size_t size)
+	{
+		if(d && size) data.assign(d, d + size);
+
+		valid = data.size() >= InputLogHeaderSize && memcmp(&data[0], InputLogMagic, 4) == 0 &&
+			data[4] == InputLogVersion;
+		position = InputLogHeaderSize;
+		time = 0;
+
+		// Whole log is checked once, which also finds all devices. Log cut short (recording
+		// that did not finish) plays up to its last whole entry.
+		unsigned int kind, device;
+		while(valid && Apply(kind, device)) {}
+		if(data.size() >= InputLogHeaderSize && memcmp(&data[0], InputLogMagic, 4) == 0 &&
+		   data[4] == InputLogVersion)
+		{
+			data.resize(position);
+			valid = true;
+		}
+		Rewind();
+	}
+
+	bool InputReplayer::ReadVarint(size_t& p, unsigned long long& value) const
+	{
+		value = 0;
+		for(unsigned int shift = 0; shift < 64; shift += 7)
+		{
+			if(p >= data.size()) return false;
+
+			unsigned char b = data[p++];
+			value |= (unsigned long long)(b & 0x7F) << shift;
+			if(!(b & 0x80)) return true;
+		}
+		return false;
+	}
+
+	bool InputReplayer::ReadSigned(size_t& p, long long& value) const
+	{
+		unsigned long long v;
+		if(!ReadVarint(p, v)) return false;
+		value = UnZigZag(v);
+		return true;
+	}
+
+	bool InputReplayer::PeekTime(long long& t) const
+	{
+		size_t p = position;
+		unsigned long long tag, delta;
+		if(!ReadVarint(p, tag) || !ReadVarint(p, delta)) return false;
+		t = time + (long long)delta;
+		return true;
+	}
+
+	bool InputReplayer::Apply(unsigned int& kind, unsigned int& index)
+	{
+		if(!valid || position >= data.size()) return false;
+
+		size_t p = position;
+		unsigned long long tag, delta;
+		if(!ReadVarint(p, tag) || !ReadVarint(p, delta) || (tag & 3) == 3 || (tag >> 2) > 0xFFFF)
+		{
+			valid = false;
+			return false;
+		}
+		kind = (unsigned int)(tag & 3);
+		index = (unsigned int)(tag >> 2);
+
+		if(kind == InputLogDevice)
+		{
+			unsigned long long type, id, buttons, axes;
+			if(!ReadVarint(p, type) || !ReadVarint(p, id) || !ReadVarint(p, buttons) ||
+			   !ReadVarint(p, axes) || buttons > InputLogMaxButtons || axes > InputLogMaxAxes ||
+			   index > devices.size())
+			{
+				valid = false;
+				return false;
+			}
+
+			// Devices stay known after rewind, then their declaration is only skipped.
+			if(index == devices.size())
+			{
+				Device device;
+				device.info.type = (unsigned int)type;
+				device.info.id = (unsigned int)id;
+				device.info.buttons = (unsigned int)buttons;
+				device.info.axes = (unsigned int)axes;
+				device.state.buttons.assign((size_t)buttons, 0);
+				device.state.axes.assign((size_t)axes, 0);
+				device.eventsRead = 0;
+				device.eventTime = 0;
+				device.eventSequence = 0;
+				devices.push_back(device);
+			}
+		} else {
+			if(index >= devices.size())
+			{
+				valid = false;
+				return false;
+			}
+			Device& device = devices[index];
+
+			if(kind == InputLogState)
+			{
+				unsigned long long changed, gap, mask;
+				if(!ReadVarint(p, changed) || changed > device.info.buttons)
+				{
+					valid = false;
+					return false;
+				}
+
+				unsigned long long button = 0;
+				for(unsigned long long i = 0; i < changed; i++)
+				{
+					if(!ReadVarint(p, gap) || (button += gap) >= device.info.buttons)
+					{
+						valid = false;
+						return false;
+					}
+					device.state.buttons[(size_t)button] ^= 1;
+				}
+
+				if(!ReadVarint(p, mask) || (device.info.axes < 64 && (mask >> device.info.axes) != 0))
+				{
+					valid = false;
+					return false;
+				}
+				for(unsigned int i = 0; i < device.info.axes; i++)
+				{
+					if(!(mask & (1ull << i))) continue;
+
+					long long axisDelta;
+					if(!ReadSigned(p, axisDelta))
+					{
+						valid = false;
+						return false;
+					}
+					device.state.axes[i] = (long long)((unsigned long long)device.state.axes[i] +
+						(unsigned long long)axisDelta);
+				}
+			} else {
+				unsigned long long count;
+				if(!ReadVarint(p, count) || count > data.size())
+				{
+					valid = false;
+					return false;
+				}
+
+				for(unsigned long long i = 0; i < count; i++)
+				{
+					unsigned long long type, id;
+					long long value, timeDelta, sequenceDelta;
+					if(!ReadVarint(p, type) || !ReadVarint(p, id) || !ReadSigned(p, value) ||
+					   !ReadSigned(p, timeDelta) || !ReadSigned(p, sequenceDelta))
+					{
+						valid = false;
+						return false;
+					}
+
+					device.eventTime += (unsigned int)timeDelta;
+					device.eventSequence += (unsigned int)sequenceDelta;
+
+					InputRecord record;
+					record.time = device.eventTime;
+					record.sequence = device.eventSequence;
+					record.type = (unsigned short)type;
+					record.id = (unsigned short)id;
+					record.value = (int)value;
+					device.events.push_back(record);
+				}
+
+				// Reader that does not read events does not make replay grow.
+				if(device.events.size() - device.eventsRead > InputLogMaxPending)
+				{
+					device.eventsRead = device.events.size() - InputLogMaxPending;
+				}
+				if(device.eventsRead > InputLogMaxPending)
+				{
+					device.events.erase(device.events.begin(), device.events.begin() + device.eventsRead);
+					device.eventsRead = 0;
+				}
+			}
+		}
+
+		time += (long long)delta;
+		position = p;
+		return true;
+	}
+
+	int InputReplayer::FindDevice(unsigned int type, unsigned int id) const
+	{
+		for(size_t i = 0; i < devices.size(); i++)
+		{
+			if(devices[i].info.type == type && devices[i].info.id == id) return (int)i;
+		}
+		return -1;
+	}
+
+	void InputReplayer::Update(double seconds)
+	{
+		long long until = ToMicroseconds(seconds);
+
+		long long next;
+		unsigned int kind, device;
+		while(PeekTime(next) && next <= until)
+		{
+			if(!Apply(kind, device)) break;
+		}
+	}
+
+	bool InputReplayer::StepDevice(unsigned int index)
+	{
+		unsigned int kind, device;
+		while(Apply(kind, device))
+		{
+			if(kind == InputLogState && device == index) return true;
+		}
+		return false;
+	}
+
+	unsigned int InputReplayer::ReadEvents(unsigned int index, InputRecord* records, unsigned int max)
+	{
+		if(index >= devices.size()) return 0;
+		Device& device = devices[index];
+
+		unsigned int count = 0;
+		while(count < max && device.eventsRead < device.events.size())
+		{
+			records[count++] = device.events[device.eventsRead++];
+		}
+
+		if(device.eventsRead == device.events.size())
+		{
+			device.events.clear();
+			device.eventsRead = 0;
+		}
+		return count;
+	}
+
+	void InputReplayer::Rewind()
+	{
+		position = InputLogHeaderSize;
+		time = 0;
+
+		for(size_t i = 0; i < devices.size(); i++)
+		{
+			Device& device = devices[i];
+			device.state.buttons.assign(device.info.buttons, 0);
+			device.state.axes.assign(device.info.axes, 0);
+			device.events.clear();
+			device.eventsRead = 0;
+			device.eventTime = 0;
+			device.eventSequence = 0;
+		}
+	}
+
+}
+}
+}
+}
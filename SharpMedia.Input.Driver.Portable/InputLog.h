@@ -0,0 +1,143 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "InputEventRing.h"
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	// Binary log of input, so same input can be replayed in every run (benchmarks, tests).
+	//
+	// Log is magic "SMIL" and version byte followed by entries. Every entry starts with
+	// varint of kind and device index, and varint of microseconds since previous entry.
+	// States store only buttons that changed and deltas of axes that changed; events store
+	// differences of time and sequence to previous event of device. Signed values are
+	// zigzag encoded.
+	enum InputLogEntryKind
+	{
+		InputLogDevice = 0,
+		InputLogState = 1,
+		InputLogEvents = 2
+	};
+
+	static const unsigned int InputLogVersion = 1;
+	static const unsigned int InputLogMaxButtons = 4096;
+	static const unsigned int InputLogMaxAxes = 32;
+
+	struct InputLogDeviceInfo
+	{
+		unsigned int type;				//< InputDeviceType.
+		unsigned int id;				//< Device id within type.
+		unsigned int buttons;
+		unsigned int axes;
+	};
+
+	// State of device in log, buttons are 0 or 1.
+	struct InputLogDeviceState
+	{
+		std::vector<unsigned char> buttons;
+		std::vector<long long> axes;
+	};
+
+	// Appends entries to log in memory.
+	class InputLogWriter
+	{
+		struct Device
+		{
+			InputLogDeviceInfo info;
+			InputLogDeviceState state;
+			bool hasState;
+			unsigned int eventTime;
+			unsigned int eventSequence;
+		};
+
+		std::vector<unsigned char> data;
+		std::vector<Device> devices;
+		long long lastTime;				//< Microseconds.
+
+		void WriteVarint(unsigned long long value);
+		void WriteSigned(long long value);
+		void WriteHeader(InputLogEntryKind kind, unsigned int device, double time);
+	public:
+		InputLogWriter();
+
+		// Returns index of device, used by other writes; -1 for invalid counts.
+		int AddDevice(const InputLogDeviceInfo& info);
+
+		// Time in seconds from any origin, must not decrease. Counts are those of device.
+		void WriteState(unsigned int device, double time, const unsigned char* buttons,
+						const long long* axes);
+
+		void WriteEvents(unsigned int device, double time, const InputRecord* records,
+						 unsigned int count);
+
+		const unsigned char* GetData() const { return data.empty() ? 0 : &data[0]; }
+		size_t GetSize() const { return data.size(); }
+		unsigned int GetDeviceCount() const { return (unsigned int)devices.size(); }
+		const InputLogDeviceInfo& GetDeviceInfo(unsigned int device) const { return devices[device].info; }
+	};
+
+	// Plays log back. With real time entries are applied when their time is reached; otherwise
+	// every state read of device steps to its next state, as fast as reader runs.
+	class InputReplayer
+	{
+		struct Device
+		{
+			InputLogDeviceInfo info;
+			InputLogDeviceState state;
+			std::vector<InputRecord> events;	//< Applied but not read.
+			size_t eventsRead;
+			unsigned int eventTime;
+			unsigned int eventSequence;
+		};
+
+		std::vector<unsigned char> data;
+		std::vector<Device> devices;
+		size_t position;				//< Of next entry.
+		long long time;					//< Microseconds of last applied entry.
+		bool valid;
+
+		bool ReadVarint(size_t& p, unsigned long long& value) const;
+		bool ReadSigned(size_t& p, long long& value) const;
+
+		// Applies entry at position; returns false at end of log or when entry is malformed.
+		bool Apply(unsigned int& kind, unsigned int& device);
+		bool PeekTime(long long& time) const;
+	public:
+		InputReplayer(const unsigned char* data, size_t size);
+
+		// False when data is not an input log; malformed tail of log is dropped.
+		bool IsValid() const { return valid; }
+		bool IsFinished() const { return position >= data.size() || !valid; }
+
+		// All devices of log are known from construction.
+		unsigned int GetDeviceCount() const { return (unsigned int)devices.size(); }
+		const InputLogDeviceInfo& GetDeviceInfo(unsigned int device) const { return devices[device].info; }
+
+		// Returns index of device or -1.
+		int FindDevice(unsigned int type, unsigned int id) const;
+
+		// Applies entries up to seconds from beginning of log.
+		void Update(double seconds);
+
+		// Applies entries up to and including next state of device; false at end of log.
+		bool StepDevice(unsigned int device);
+
+		const InputLogDeviceState& GetState(unsigned int device) const { return devices[device].state; }
+
+		// Events of device applied so far, oldest first.
+		unsigned int ReadEvents(unsigned int device, InputRecord* records, unsigned int max);
+
+		// Seconds from beginning of log to last applied entry.
+		double GetTime() const { return time * 0.000001; }
+
+		// Starts again from beginning.
+		void Rewind();
+	};
+
+}
+}
+}
+}
@@ -0,0 +1,410 @@
+#include "InputPoller.h"
+#include "InputAtomic.h"
+#include <cmath>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	// Waits shorter than this are left to clock, event timeouts are not as precise.
+	static const double PollerClockWait = 0.002;
+
+#ifdef _WIN32
+	static void* CreateWake()
+	{
+		return CreateEvent(0, FALSE, FALSE, 0);
+	}
+
+	static void DestroyWake(void* wake)
+	{
+		CloseHandle((HANDLE)wake);
+	}
+
+	static void SignalWake(void* wake)
+	{
+		SetEvent((HANDLE)wake);
+	}
+
+	// Returns true when signalled before timeout.
+	static bool WaitWake(void* wake, double seconds)
+	{
+		return WaitForSingleObject((HANDLE)wake, (DWORD)(seconds * 1000.0)) == WAIT_OBJECT_0;
+	}
+#else
+	struct PollerWake
+	{
+		pthread_mutex_t mutex;
+		pthread_cond_t condition;
+		bool signalled;
+	};
+
+	static void* CreateWake()
+	{
+		PollerWake* wake = new PollerWake;
+		pthread_condattr_t attributes;
+		pthread_condattr_init(&attributes);
+		pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+		pthread_cond_init(&wake->condition, &attributes);
+		pthread_condattr_destroy(&attributes);
+		pthread_mutex_init(&wake->mutex, 0);
+		wake->signalled = false;
+		return wake;
+	}
+
+	static void DestroyWake(void* p)
+	{
+		PollerWake* wake = (PollerWake*)p;
+		pthread_cond_destroy(&wake->condition);
+		pthread_mutex_destroy(&wake->mutex);
+		delete wake;
+	}
+
+	static void SignalWake(void* p)
+	{
+		PollerWake* wake = (PollerWake*)p;
+		pthread_mutex_lock(&wake->mutex);
+		wake->signalled = true;
+		pthread_cond_signal(&wake->condition);
+		pthread_mutex_unlock(&wake->mutex);
+	}
+
+	static bool WaitWake(void* p, double seconds)
+	{
+		PollerWake* wake = (PollerWake*)p;
+		timespec deadline;
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		long long nanoseconds = (long long)deadline.tv_nsec + (long long)(seconds * 1e9);
+		deadline.tv_sec += (time_t)(nanoseconds / 1000000000);
+		deadline.tv_nsec = (long)(nanoseconds % 1000000000);
+
+		pthread_mutex_lock(&wake->mutex);
+		while(!wake->signalled)
+		{
+			if(pthread_cond_timedwait(&wake->condition, &wake->mutex, &deadline) == ETIMEDOUT) break;
+		}
+		bool signalled = wake->signalled;
+		wake->signalled = false;
+		pthread_mutex_unlock(&wake->mutex);
+		return signalled;
+	}
+#endif
+
+	void InputSnapshotBuffer::Reset()
+	{
+		memset(states, 0, sizeof(states));
+		back = 0;
+		middle = 1;
+		front = 2;
+		published = false;
+	}
+
+	void InputSnapshotBuffer::Publish()
+	{
+		back = AtomicExchange(&middle, back | Fresh) & 3;
+	}
+
+	const InputDeviceState* InputSnapshotBuffer::Read(bool& fresh)
+	{
+		fresh = (AtomicLoad(&middle) & Fresh) != 0;
+		if(fresh)
+		{
+			front = AtomicExchange(&middle, front) & 3;
+			published = true;
+		}
+		return published ? &states[front] : 0;
+	}
+
+	void LatencyHistogram::Reset()
+	{
+		memset(buckets, 0, sizeof(buckets));
+		count = 0;
+		total = max = 0.0;
+	}
+
+	void LatencyHistogram::Add(double seconds)
+	{
+		if(seconds < 0.0) seconds = 0.0;
+
+		// Bucket i starts at 2^(i/4) microseconds, first also holds everything below.
+		double us = seconds * 1000000.0;
+		int i = us > 1.0 ? (int)(std::log(us) * (4.0 / std::log(2.0))) : 0;
+		if(i >= (int)BucketCount) i = BucketCount - 1;
+
+		buckets[i]++;
+		count++;
+		total += seconds;
+		if(seconds > max) max = seconds;
+	}
+
+	double LatencyHistogram::BucketBound(unsigned int i)
+	{
+		return i == 0 ? 0.0 : std::pow(2.0, i / 4.0) * 0.000001;
+	}
+
+	double LatencyHistogram::Percentile(double fraction) const
+	{
+		if(count == 0) return 0.0;
+
+		double target = fraction * count;
+		unsigned int sum = 0;
+		for(unsigned int i = 0; i < BucketCount; i++)
+		{
+			sum += buckets[i];
+			if(sum >= target && sum > 0)
+			{
+				double bound = i + 1 < BucketCount ? BucketBound(i + 1) : max;
+				return bound < max ? bound : max;
+			}
+		}
+		return max;
+	}
+
+	InputPoller::InputPoller(PollerClock* clock)
+	{
+		this->clock = clock;
+		this->active = 0;
+		this->iteration = 0;
+		this->quit = 0;
+		this->references = 1;
+		this->rate = 0;
+		this->backgroundRate = 0;
+		this->minimizedRate = 0;
+		this->thread = 0;
+		this->wake = 0;
+		memset(&stats, 0, sizeof(stats));
+
+		for(unsigned int i = 0; i < InputMaxSources; i++) entries[i].source = 0;
+	}
+
+	InputPoller::~InputPoller()
+	{
+		Stop();
+	}
+
+	void InputPoller::AddRef()
+	{
+		AtomicAdd(&references, 1);
+	}
+
+	void InputPoller::Release()
+	{
+		if(AtomicAdd(&references, -1) == 0) delete this;
+	}
+
+	int InputPoller::AddSource(InputSource* source)
+	{
+		for(unsigned int i = 0; i < InputMaxSources; i++)
+		{
+			if(entries[i].source) continue;
+
+			// Entry is written before its bit is visible to thread; buffer must not hold
+			// state of previous source.
+			entries[i].buffer.Reset();
+			entries[i].source = source;
+			AtomicAdd(&active, 1 << i);
+			return (int)i;
+		}
+		return -1;
+	}
+
+	void InputPoller::RemoveSource(int slot)
+	{
+		if(slot < 0 || slot >= (int)InputMaxSources || !entries[slot].source) return;
+
+		AtomicAdd(&active, -(1 << slot));
+		if(thread)
+		{
+			// Samples in progress may have loaded mask before source was removed; samples
+			// started later do not see it. Between iterations nothing is waited for.
+			unsigned int start = AtomicLoad(&iteration);
+			while((start & 1) && AtomicLoad(&iteration) == start)
+			{
+#ifdef _WIN32
+				SwitchToThread();
+#else
+				sched_yield();
+#endif
+			}
+		}
+		entries[slot].source = 0;
+	}
+
+	void InputPoller::Sample(Entry& entry)
+	{
+		InputDeviceState& state = entry.buffer.GetBack();
+		if(!entry.source->Sample(state))
+		{
+			stats.failures++;
+			return;
+		}
+
+		state.time = clock->Now();
+		state.sample = stats.samples;
+		entry.buffer.Publish();
+	}
+
+	void InputPoller::Step()
+	{
+		AtomicAdd(&iteration, 1);
+		unsigned int mask = AtomicLoad(&active);
+		for(unsigned int i = 0; i < InputMaxSources; i++)
+		{
+			if(mask & (1 << i)) Sample(entries[i]);
+		}
+
+		stats.samples++;
+		AtomicAdd(&iteration, 1);
+	}
+
+	void InputPoller::SampleSource(int slot)
+	{
+		if(thread || slot < 0 || slot >= (int)InputMaxSources || !entries[slot].source) return;
+		Sample(entries[slot]);
+	}
+
+	void InputPoller::SetBackgroundRates(unsigned int background, unsigned int minimized)
+	{
+		AtomicStore(&backgroundRate, background);
+		AtomicStore(&minimizedRate, minimized);
+	}
+
+	void InputPoller::GetBackgroundRates(unsigned int& background, unsigned int& minimized)
+	{
+		background = AtomicLoad(&backgroundRate);
+		minimized = AtomicLoad(&minimizedRate);
+	}
+
+	unsigned int InputPoller::GetEffectiveRate()
+	{
+		unsigned int throttled = 0;
+		switch(focus.Get())
+		{
+		case InputFocusBackground:
+			throttled = AtomicLoad(&backgroundRate);
+			break;
+		case InputFocusMinimized:
+			throttled = AtomicLoad(&minimizedRate);
+			break;
+		default:
+			break;
+		}
+		return throttled != 0 && throttled < rate ? throttled : rate;
+	}
+
+	void InputPoller::Run()
+	{
+		double next = clock->Now();
+		while(!AtomicLoad(&quit))
+		{
+			Step();
+
+			// Deadlines stay on grid unless more than a period is missed.
+			double period = 1.0 / GetEffectiveRate();
+			next += period;
+			double now = clock->Now();
+			if(now - next > period)
+			{
+				stats.late++;
+				next = now;
+			}
+			Wait(next);
+		}
+	}
+
+	void InputPoller::Wait(double time)
+	{
+		// Long waits end early when woken by Stop; only last part is slept on clock.
+		double coarse = time - clock->Now() - PollerClockWait;
+		if(coarse > 0.0 && WaitWake(wake, coarse)) return;
+		clock->SleepUntil(time);
+	}
+
+#ifdef _WIN32
+	static DWORD WINAPI PollerThread(LPVOID param)
+	{
+		// Samples are short, running them ahead of game threads keeps period steady.
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+		((InputPoller*)param)->Run();
+		return 0;
+	}
+#else
+	static void* PollerThread(void* param)
+	{
+		((InputPoller*)param)->Run();
+		return 0;
+	}
+#endif
+
+	bool InputPoller::Start(unsigned int rate)
+	{
+		Stop();
+		if(rate == 0) return true;
+
+		this->rate = rate;
+		AtomicStore(&quit, 0);
+		wake = CreateWake();
+
+#ifdef _WIN32
+		thread = CreateThread(0, 0, PollerThread, this, 0, 0);
+#else
+		pthread_t* handle = new pthread_t;
+		if(pthread_create(handle, 0, PollerThread, this) != 0)
+		{
+			delete handle;
+			handle = 0;
+		}
+		thread = handle;
+#endif
+
+		if(!thread)
+		{
+			DestroyWake(wake);
+			wake = 0;
+			this->rate = 0;
+		}
+		return thread != 0;
+	}
+
+	void InputPoller::Stop()
+	{
+		if(!thread) return;
+
+		AtomicStore(&quit, 1);
+		SignalWake(wake);
+#ifdef _WIN32
+		WaitForSingleObject((HANDLE)thread, INFINITE);
+		CloseHandle((HANDLE)thread);
+#else
+		pthread_join(*(pthread_t*)thread, 0);
+		delete (pthread_t*)thread;
+#endif
+		thread = 0;
+		DestroyWake(wake);
+		wake = 0;
+		rate = 0;
+	}
+
+	const InputDeviceState* InputPoller::Read(int slot)
+	{
+		if(slot < 0 || slot >= (int)InputMaxSources) return 0;
+
+		bool fresh;
+		const InputDeviceState* state = entries[slot].buffer.Read(fresh);
+		if(state && fresh) latency.Add(clock->Now() - state->time);
+		return state;
+	}
+
+}
+}
+}
+}
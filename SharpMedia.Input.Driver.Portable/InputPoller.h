@@ -0,0 +1,220 @@
+#pragma once
+#include "KeyBitset.h"
+#include "InputAtomic.h"
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	static const unsigned int InputMaxButtons = 256;
+	static const unsigned int InputMaxAxes = 8;
+	static const unsigned int InputMaxSources = 16;
+
+	// State of device at one sample.
+	struct InputDeviceState
+	{
+		double time;						//< Seconds of poller clock when sampled.
+		unsigned int sample;				//< Number of sample.
+		unsigned char buttons[InputMaxButtons];
+		long long axes[InputMaxAxes];		//< Absolute, deltas are accumulated.
+		KeyBitset keys;						//< Keyboards only, by scan code instead of buttons.
+	};
+
+	// Device sampled by poller.
+	class InputSource
+	{
+	public:
+		virtual ~InputSource() {}
+
+		// Fills whole state except time and sample; returns false when device cannot be read.
+		virtual bool Sample(InputDeviceState& state) = 0;
+	};
+
+	enum InputFocus
+	{
+		InputFocusForeground = 0,
+		InputFocusBackground = 1,
+		InputFocusMinimized = 2
+	};
+
+	// Focus of window that devices belong to; set by game thread, read by poller thread.
+	class InputFocusState
+	{
+		volatile unsigned int focus;
+		volatile unsigned int gained;		//< Changes every time focus is gained.
+	public:
+		InputFocusState() { focus = InputFocusForeground; gained = 0; }
+
+		void Set(InputFocus f)
+		{
+			if(f == InputFocusForeground && AtomicLoad(&focus) != InputFocusForeground) AtomicAdd(&gained, 1);
+			AtomicStore(&focus, f);
+		}
+
+		InputFocus Get() { return (InputFocus)AtomicLoad(&focus); }
+		unsigned int GetGained() { return AtomicLoad(&gained); }
+	};
+
+	// Time source of poller; simulated clock is used to test polling without devices.
+	class PollerClock
+	{
+	public:
+		virtual ~PollerClock() {}
+
+		// Seconds from arbitrary origin.
+		virtual double Now() = 0;
+
+		// Returns at or shortly after time.
+		virtual void SleepUntil(double time) = 0;
+	};
+
+	// Triple buffer of one producer and one consumer. Producer always has a buffer to write
+	// and consumer always has a consistent one to read; neither waits for other.
+	class InputSnapshotBuffer
+	{
+		static const unsigned int Fresh = 4;
+
+		InputDeviceState states[3];
+		volatile unsigned int middle;		//< Index of buffer passed between threads, and Fresh.
+		unsigned int back;					//< Owned by producer.
+		unsigned int front;					//< Owned by consumer.
+		bool published;
+	public:
+		InputSnapshotBuffer() { Reset(); }
+
+		// Drops all states; neither side may use buffer meanwhile.
+		void Reset();
+
+		// Producer writes this and publishes it.
+		InputDeviceState& GetBack() { return states[back]; }
+		void Publish();
+
+		// Consumer; latest published state or null before first. Fresh is set when state
+		// was not read before. State stays valid until next Read.
+		const InputDeviceState* Read(bool& fresh);
+	};
+
+	// Latency histogram with four buckets per octave of microseconds.
+	class LatencyHistogram
+	{
+	public:
+		static const unsigned int BucketCount = 96;
+	private:
+		unsigned int buckets[BucketCount];
+		unsigned int count;
+		double total, max;
+	public:
+		LatencyHistogram() { Reset(); }
+
+		void Reset();
+		void Add(double seconds);
+
+		// Upper bound of bucket containing given fraction of samples, in seconds.
+		double Percentile(double fraction) const;
+
+		unsigned int GetCount() const { return count; }
+		double GetAverage() const { return count ? total / count : 0.0; }
+		double GetMax() const { return max; }
+		unsigned int GetBucket(unsigned int i) const { return buckets[i]; }
+
+		// Lower bound of bucket in seconds.
+		static double BucketBound(unsigned int i);
+	};
+
+	struct InputPollerStats
+	{
+		unsigned int samples;		//< Iterations of polling.
+		unsigned int late;			//< Iterations that started more than a period late.
+		unsigned int failures;		//< Samples of sources that could not be read.
+	};
+
+	// Samples input sources on own thread at fixed rate and publishes states through triple
+	// buffers, so reader gets latest state without locking and input latency does not depend
+	// on frame time. Without thread sources are sampled on read.
+	//
+	// Sources are added and removed from one thread; states are read from one thread.
+	class InputPoller
+	{
+		struct Entry
+		{
+			InputSource* source;
+			InputSnapshotBuffer buffer;
+		};
+
+		PollerClock* clock;
+		Entry entries[InputMaxSources];
+		volatile unsigned int active;		//< Bit of every entry with source.
+		volatile unsigned int iteration;	//< Odd while sources are sampled.
+		volatile unsigned int quit;
+		volatile unsigned int references;
+		unsigned int rate;
+		volatile unsigned int backgroundRate;
+		volatile unsigned int minimizedRate;
+		InputFocusState focus;
+		void* thread;
+		void* wake;							//< Signalled to end waiting for next period.
+		InputPollerStats stats;
+		LatencyHistogram latency;
+
+		InputPoller(const InputPoller&);
+		InputPoller& operator = (const InputPoller&);
+
+		~InputPoller();
+		void Sample(Entry& entry);
+		void Wait(double time);
+	public:
+		InputPoller(PollerClock* clock);
+
+		// Poller is shared by service and devices, last release deletes it.
+		void AddRef();
+		void Release();
+
+		// Returns slot of source or -1 when full.
+		int AddSource(InputSource* source);
+
+		// After return source is not used by poller thread anymore. Waits at most for samples
+		// being taken, not for next period.
+		void RemoveSource(int slot);
+
+		// Samples all sources once; called by thread, public for testing.
+		void Step();
+
+		// Polling loop of thread, returns when stopped.
+		void Run();
+
+		// Samples one source when thread does not run.
+		void SampleSource(int slot);
+
+		// Rate in Hz; returns false if thread could not be created.
+		bool Start(unsigned int rate);
+
+		// Wakes thread waiting for next period, so it returns at once at any rate.
+		void Stop();
+		bool IsRunning() const { return thread != 0; }
+		unsigned int GetRate() const { return rate; }
+
+		// Rates used instead of rate while window is in background or minimized, when they
+		// are lower; 0 keeps rate. Change of focus takes effect after current period.
+		void SetBackgroundRates(unsigned int background, unsigned int minimized);
+		void GetBackgroundRates(unsigned int& background, unsigned int& minimized);
+
+		// Rate in Hz thread samples at now.
+		unsigned int GetEffectiveRate();
+
+		// Sources read focus to decide when to acquire devices.
+		InputFocusState& GetFocus() { return focus; }
+
+		// Latest state of source, null if never sampled. Latency from sample to first read is
+		// recorded.
+		const InputDeviceState* Read(int slot);
+
+		const InputPollerStats& GetStats() const { return stats; }
+		const LatencyHistogram& GetLatency() const { return latency; }
+		void ResetLatency() { latency.Reset(); }
+	};
+
+}
+}
+}
+}
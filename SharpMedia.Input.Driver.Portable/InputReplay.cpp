@@ -0,0 +1,45 @@
+#include "InputReplay.h"
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	InputReplaySession::InputReplaySession(PollerClock* clock, const unsigned char* data, size_t size)
+		: replayer(data, size)
+	{
+		this->clock = clock;
+		this->realTime = true;
+		this->start = clock->Now();
+	}
+
+	void InputReplaySession::SetRealTime(bool value)
+	{
+		if(value && !realTime) start = clock->Now() - replayer.GetTime();
+		realTime = value;
+	}
+
+	const InputLogDeviceState& InputReplaySession::ReadState(unsigned int device)
+	{
+		if(realTime) replayer.Update(clock->Now() - start);
+		else replayer.StepDevice(device);
+
+		return replayer.GetState(device);
+	}
+
+	unsigned int InputReplaySession::ReadEvents(unsigned int device, InputRecord* records, unsigned int max)
+	{
+		if(realTime) replayer.Update(clock->Now() - start);
+		return replayer.ReadEvents(device, records, max);
+	}
+
+	void InputReplaySession::Rewind()
+	{
+		replayer.Rewind();
+		start = clock->Now();
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "InputLog.h"
+#include "InputPoller.h"
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	// Replay of input log as input service plays it, shared by DirectInput and evdev drivers
+	// so recorded scenarios replay the same way on every platform, with or without window.
+	//
+	// In real time (default) log plays at recorded timing from construction or Rewind.
+	// Otherwise every state read of device steps to its next recorded state, so a recorded
+	// frame is replayed per frame, as fast as frames run. Not thread safe, owner must lock.
+	class InputReplaySession
+	{
+		InputReplayer replayer;
+		PollerClock* clock;
+		bool realTime;
+		double start;				//< Clock time of beginning of log.
+
+		InputReplaySession(const InputReplaySession&);
+		InputReplaySession& operator = (const InputReplaySession&);
+	public:
+		InputReplaySession(PollerClock* clock, const unsigned char* data, size_t size);
+
+		bool IsValid() const { return replayer.IsValid(); }
+		bool IsFinished() const { return replayer.IsFinished(); }
+
+		unsigned int GetDeviceCount() const { return replayer.GetDeviceCount(); }
+		const InputLogDeviceInfo& GetDeviceInfo(unsigned int device) const { return replayer.GetDeviceInfo(device); }
+		int FindDevice(unsigned int type, unsigned int id) const { return replayer.FindDevice(type, id); }
+
+		// Time continues from position of log when real time is turned on.
+		void SetRealTime(bool realTime);
+		bool IsRealTime() const { return realTime; }
+
+		// Advances log for a state read of device and returns state.
+		const InputLogDeviceState& ReadState(unsigned int device);
+
+		// Events of device up to now (real time) or up to last state read.
+		unsigned int ReadEvents(unsigned int device, InputRecord* records, unsigned int max);
+
+		// Plays log again from beginning, from now.
+		void Rewind();
+	};
+
+}
+}
+}
+}
@@ -0,0 +1,215 @@
+#include "JoystickFilter.h"
+#include <cmath>
+#include <cstring>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	JoystickSettings JoystickFilter::DefaultSettings()
+	{
+		JoystickSettings s;
+		s.deadzone = 0.24;
+		s.saturation = 1.0;
+		return s;
+	}
+
+	static int JoystickFindUsage(const unsigned short* usages, unsigned short usage)
+	{
+		for(unsigned int i = 0; i < JoystickAxes; i++)
+		{
+			if(usages[i] == usage) return (int)i;
+		}
+		return -1;
+	}
+
+	static bool JoystickPair(JoystickLayout& layout, const unsigned short* usages,
+							 unsigned short first, unsigned short second)
+	{
+		int a = JoystickFindUsage(usages, first), b = JoystickFindUsage(usages, second);
+		if(a < 0 || b < 0 || layout.kinds[a] == JoystickAxisStick || layout.kinds[b] == JoystickAxisStick)
+		{
+			return false;
+		}
+
+		layout.kinds[a] = layout.kinds[b] = JoystickAxisStick;
+		layout.pairs[a] = (unsigned int)b;
+		layout.pairs[b] = (unsigned int)a;
+		return true;
+	}
+
+	JoystickLayout JoystickFilter::Layout(unsigned short deviceUsage, const unsigned short* usages)
+	{
+		JoystickLayout layout;
+		for(unsigned int i = 0; i < JoystickAxes; i++)
+		{
+			layout.pairs[i] = i;
+			switch(usages[i])
+			{
+			case 0:
+				layout.kinds[i] = JoystickAxisAbsent;
+				break;
+			case JoystickUsageX:
+			case JoystickUsageY:
+			case JoystickUsageRx:
+			case JoystickUsageRy:
+			case JoystickUsageRz:
+				layout.kinds[i] = JoystickAxisCentered;
+				break;
+			default:
+				layout.kinds[i] = JoystickAxisAbsolute;
+				break;
+			}
+		}
+
+		JoystickPair(layout, usages, JoystickUsageX, JoystickUsageY);
+
+		// Gamepads put right stick on Rx/Ry or, without them, on Z/Rz; with both Z is
+		// usually triggers.
+		bool right = JoystickPair(layout, usages, JoystickUsageRx, JoystickUsageRy);
+		if(!right && deviceUsage == JoystickUsageGamepad)
+		{
+			JoystickPair(layout, usages, JoystickUsageZ, JoystickUsageRz);
+		}
+		return layout;
+	}
+
+	JoystickLayout JoystickFilter::DefaultLayout()
+	{
+		static const unsigned short Usages[JoystickAxes] =
+		{
+			JoystickUsageX, JoystickUsageY, JoystickUsageZ, JoystickUsageRx,
+			JoystickUsageRy, JoystickUsageRz, JoystickUsageSlider, JoystickUsageSlider
+		};
+		return Layout(JoystickUsageGamepad, Usages);
+	}
+
+	JoystickFilter::JoystickFilter()
+	{
+		settings = DefaultSettings();
+		layout = DefaultLayout();
+		Reset();
+	}
+
+	void JoystickFilter::SetLayout(const JoystickLayout& l)
+	{
+		layout = l;
+	}
+
+	void JoystickFilter::Reset()
+	{
+		previous.Clear();
+	}
+
+	void JoystickFilter::SetSettings(const JoystickSettings& s)
+	{
+		settings = s;
+		if(!(settings.deadzone > 0.0)) settings.deadzone = 0.0;
+		if(settings.deadzone > 0.9) settings.deadzone = 0.9;
+		if(!(settings.saturation <= 1.0)) settings.saturation = 1.0;
+		if(settings.saturation < settings.deadzone + 0.05) settings.saturation = settings.deadzone + 0.05;
+	}
+
+	double JoystickFilter::Normalize(int raw)
+	{
+		const double center = ((double)JoystickRangeMin + (double)JoystickRangeMax) * 0.5;
+		const double half = ((double)JoystickRangeMax - (double)JoystickRangeMin) * 0.5;
+
+		double value = ((double)raw - center) / half;
+		if(value < -1.0) value = -1.0;
+		if(value > 1.0) value = 1.0;
+		return value;
+	}
+
+	void JoystickFilter::Deadzone(double& x, double& y, const JoystickSettings& s)
+	{
+		double length = std::sqrt(x * x + y * y);
+		if(length <= s.deadzone)
+		{
+			x = y = 0.0;
+			return;
+		}
+
+		double scaled = (length - s.deadzone) / (s.saturation - s.deadzone);
+		if(scaled > 1.0) scaled = 1.0;
+
+		x *= scaled / length;
+		y *= scaled / length;
+	}
+
+	unsigned int JoystickFilter::HatDirections(unsigned int hat)
+	{
+		if((hat & 0xFFFF) == 0xFFFF || hat >= 36000) return 0;
+
+		// Each direction covers 135 degrees, so 45 degree sectors between them set both.
+		unsigned int directions = 0;
+		if(hat >= 29250 || hat <= 6750) directions |= 1;
+		if(hat >= 2250 && hat <= 15750) directions |= 2;
+		if(hat >= 11250 && hat <= 24750) directions |= 4;
+		if(hat >= 20250 && hat <= 33750) directions |= 8;
+		return directions;
+	}
+
+	unsigned int JoystickFilter::Apply(const JoystickRawState& raw, InputDeviceState& state,
+									   unsigned char* changed, unsigned int max)
+	{
+		double axes[JoystickAxes];
+		for(unsigned int i = 0; i < JoystickAxes; i++) axes[i] = Normalize(raw.axes[i]);
+		for(unsigned int i = 0; i < JoystickAxes; i++)
+		{
+			switch(layout.kinds[i])
+			{
+			case JoystickAxisStick:
+				if(layout.pairs[i] > i) Deadzone(axes[i], axes[layout.pairs[i]], settings);
+				break;
+			case JoystickAxisCentered:
+			{
+				double zero = 0.0;
+				Deadzone(axes[i], zero, settings);
+				break;
+			}
+			case JoystickAxisAbsent:
+				axes[i] = 0.0;
+				break;
+			default:
+				break;
+			}
+		}
+
+		memset(state.axes, 0, sizeof(state.axes));
+		for(unsigned int i = 0; i < JoystickAxes; i++)
+		{
+			double value = axes[i] * (double)JoystickAxisScale;
+			state.axes[i] = (long long)(value < 0.0 ? value - 0.5 : value + 0.5);
+		}
+
+		state.keys.Clear();
+		for(unsigned int i = 0; i < JoystickButtons; i++)
+		{
+			if(raw.buttons[i] & 0x80) state.keys.Set(i);
+		}
+		for(unsigned int i = 0; i < JoystickHats; i++)
+		{
+			unsigned int directions = HatDirections(raw.hats[i]);
+			for(unsigned int d = 0; d < 4; d++)
+			{
+				if(directions & (1 << d)) state.keys.Set(JoystickButtons + i * 4 + d);
+			}
+		}
+
+		memset(state.buttons, 0, sizeof(state.buttons));
+		for(unsigned int i = 0; i < JoystickButtonCount; i++)
+		{
+			state.buttons[i] = state.keys.Get(i) ? 1 : 0;
+		}
+
+		unsigned int count = KeyBitsetDiff(previous, state.keys, changed, max);
+		previous = state.keys;
+		return count;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include "InputPoller.h"
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	// Layout of joystick state: X, Y, Z, Rx, Ry, Rz and two sliders; 128 buttons followed by
+	// up, right, down and left of each of 4 hats.
+	static const unsigned int JoystickAxes = 8;
+	static const unsigned int JoystickButtons = 128;
+	static const unsigned int JoystickHats = 4;
+	static const unsigned int JoystickButtonCount = JoystickButtons + JoystickHats * 4;
+
+	// Normalized axes are fixed point, this is 1.0.
+	static const long long JoystickAxisScale = 65536;
+
+	// Raw range of axes, set on device.
+	static const int JoystickRangeMin = -32768;
+	static const int JoystickRangeMax = 32767;
+
+	// State as read from device (layout of DIJOYSTATE2 without extended axes).
+	struct JoystickRawState
+	{
+		int axes[JoystickAxes];
+		unsigned int hats[JoystickHats];	//< Hundredths of degree clockwise from up, centered when low word is 0xFFFF.
+		unsigned char buttons[JoystickButtons];	//< Pressed when high bit is set.
+	};
+
+	// HID usages of generic desktop page (0x01) that decide how axes are filtered.
+	static const unsigned short JoystickUsagePage = 0x01;
+	static const unsigned short JoystickUsageJoystick = 0x04;
+	static const unsigned short JoystickUsageGamepad = 0x05;
+	static const unsigned short JoystickUsageX = 0x30;
+	static const unsigned short JoystickUsageY = 0x31;
+	static const unsigned short JoystickUsageZ = 0x32;
+	static const unsigned short JoystickUsageRx = 0x33;
+	static const unsigned short JoystickUsageRy = 0x34;
+	static const unsigned short JoystickUsageRz = 0x35;
+	static const unsigned short JoystickUsageSlider = 0x36;
+
+	enum JoystickAxisKind
+	{
+		JoystickAxisAbsent,
+		JoystickAxisStick,			//< Paired with another axis, radial deadzone.
+		JoystickAxisCentered,		//< Self centering single axis (twist, rudder), axial deadzone.
+		JoystickAxisAbsolute		//< Throttle, trigger or slider, only normalized.
+	};
+
+	// How axes of a device are filtered, built from its usages by JoystickFilter::Layout.
+	struct JoystickLayout
+	{
+		JoystickAxisKind kinds[JoystickAxes];
+		unsigned int pairs[JoystickAxes];	//< Other axis of stick, for stick axes.
+	};
+
+	struct JoystickSettings
+	{
+		double deadzone;			//< Part of stick range that reads as center.
+		double saturation;			//< Part of stick range that reads as full deflection.
+	};
+
+	// Turns raw joystick state into normalized axes and buttons. Sticks get radial deadzone,
+	// so diagonals are not cut; deflection past deadzone is rescaled so output starts at zero.
+	// Which axes form sticks comes from layout of device. Changed buttons are found by
+	// comparing bitsets of samples.
+	class JoystickFilter
+	{
+		JoystickSettings settings;
+		JoystickLayout layout;
+		KeyBitset previous;
+	public:
+		JoystickFilter();
+
+		void SetSettings(const JoystickSettings& settings);
+		const JoystickSettings& GetSettings() const { return settings; }
+
+		void SetLayout(const JoystickLayout& layout);
+		const JoystickLayout& GetLayout() const { return layout; }
+
+		// Fills axes, buttons and button bits of state and writes indices of buttons changed
+		// since last call; returns their count.
+		unsigned int Apply(const JoystickRawState& raw, InputDeviceState& state,
+						   unsigned char* changed, unsigned int max);
+
+		// Forgets buttons of previous sample, all pressed buttons are reported as changed.
+		void Reset();
+
+		static JoystickSettings DefaultSettings();
+
+		// Layout of device of usage (gamepad, joystick or other) whose axes have generic
+		// desktop usages, 0 for axes device does not have. X/Y and Rx/Ry are sticks; Z/Rz is
+		// a stick of gamepads only, flight sticks report throttle and twist there.
+		static JoystickLayout Layout(unsigned short deviceUsage, const unsigned short* axisUsages);
+
+		// Layout of gamepad with all axes of state, used until one is set.
+		static JoystickLayout DefaultLayout();
+
+		// Raw value to -1..1.
+		static double Normalize(int raw);
+
+		// Applies deadzone and saturation to stick, in place.
+		static void Deadzone(double& x, double& y, const JoystickSettings& settings);
+
+		// Directions of hat as bits (up 1, right 2, down 4, left 8), diagonals set two.
+		static unsigned int HatDirections(unsigned int hat);
+	};
+
+}
+}
+}
+}
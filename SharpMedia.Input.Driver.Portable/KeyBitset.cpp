@@ -0,0 +1,110 @@
+#include "KeyBitset.h"
+#include <cstring>
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define KEYBITSET_SSE2
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	static inline unsigned int LowestBit(unsigned int word)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, word);
+		return index;
+#else
+		return (unsigned int)__builtin_ctz(word);
+#endif
+	}
+
+	// Appends indices of set bits of words, starting at key base.
+	static inline unsigned int ListWord(unsigned int word, unsigned int base, unsigned char* keys,
+		unsigned int count, unsigned int max)
+	{
+		for(; word && count < max; word &= word - 1)
+		{
+			keys[count++] = (unsigned char)(base + LowestBit(word));
+		}
+		return count;
+	}
+
+	void KeyBitset::Clear()
+	{
+		memset(words, 0, sizeof(words));
+	}
+
+	void KeyBitsetFromBytes(const unsigned char* keys, KeyBitset& bits)
+	{
+#ifdef KEYBITSET_SSE2
+		// Movemask takes high bits of 16 bytes at once.
+		for(unsigned int i = 0; i < 8; i++)
+		{
+			__m128i lo = _mm_loadu_si128((const __m128i*)(keys + i * 32));
+			__m128i hi = _mm_loadu_si128((const __m128i*)(keys + i * 32 + 16));
+			bits.words[i] = (unsigned int)_mm_movemask_epi8(lo) |
+				((unsigned int)_mm_movemask_epi8(hi) << 16);
+		}
+#else
+		bits.Clear();
+		for(unsigned int i = 0; i < 256; i++)
+		{
+			if(keys[i] & 0x80) bits.Set(i);
+		}
+#endif
+	}
+
+	unsigned int KeyBitsetDiff(const KeyBitset& previous, const KeyBitset& current,
+		unsigned char* changed, unsigned int max)
+	{
+		unsigned int words[8];
+#ifdef KEYBITSET_SSE2
+		__m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i*)previous.words),
+			_mm_loadu_si128((const __m128i*)current.words));
+		__m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(previous.words + 4)),
+			_mm_loadu_si128((const __m128i*)(current.words + 4)));
+
+		// All bytes equal to zero means no key changed.
+		__m128i zero = _mm_setzero_si128();
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_or_si128(a, b), zero)) == 0xFFFF) return 0;
+
+		_mm_storeu_si128((__m128i*)words, a);
+		_mm_storeu_si128((__m128i*)(words + 4), b);
+#else
+		unsigned int any = 0;
+		for(unsigned int i = 0; i < 8; i++)
+		{
+			words[i] = previous.words[i] ^ current.words[i];
+			any |= words[i];
+		}
+		if(!any) return 0;
+#endif
+
+		unsigned int count = 0;
+		for(unsigned int i = 0; i < 8; i++)
+		{
+			count = ListWord(words[i], i * 32, changed, count, max);
+		}
+		return count;
+	}
+
+	unsigned int KeyBitsetList(const KeyBitset& bits, unsigned char* keys, unsigned int max)
+	{
+		unsigned int count = 0;
+		for(unsigned int i = 0; i < 8; i++)
+		{
+			count = ListWord(bits.words[i], i * 32, keys, count, max);
+		}
+		return count;
+	}
+
+}
+}
+}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	// State of 256 keys, bit per key.
+	struct KeyBitset
+	{
+		unsigned int words[8];
+
+		bool Get(unsigned int key) const { return (words[key >> 5] >> (key & 31)) & 1; }
+		void Set(unsigned int key) { words[key >> 5] |= 1u << (key & 31); }
+		void Reset(unsigned int key) { words[key >> 5] &= ~(1u << (key & 31)); }
+		void Clear();
+	};
+
+	// Bit i is set when high bit of keys[i] is set (DirectInput key state).
+	void KeyBitsetFromBytes(const unsigned char* keys, KeyBitset& bits);
+
+	// Writes indices of keys that differ, ascending; returns their count (at most max). Usual
+	// case of no change costs a few SSE instructions.
+	unsigned int KeyBitsetDiff(const KeyBitset& previous, const KeyBitset& current,
+		unsigned char* changed, unsigned int max);
+
+	// Writes indices of set keys, ascending; returns their count.
+	unsigned int KeyBitsetList(const KeyBitset& bits, unsigned char* keys, unsigned int max);
+
+}
+}
+}
+}
@@ -0,0 +1,140 @@
+#include "MouseAccumulator.h"
+#include <cmath>
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	static const long long MouseAxisMax = 0x7FFFFFFFFFFFFFFFLL;
+	static const long long MouseAxisMin = -MouseAxisMax - 1;
+
+	// Units held by smoothing below this are released at once.
+	static const double MouseHeldEpsilon = 0.001;
+
+	// Reports further apart than this do not lower speed further, mouse was at rest.
+	static const unsigned int MouseMaxInterval = 100;
+
+	MouseSettings MouseAccumulator::DefaultSettings()
+	{
+		MouseSettings s;
+		s.sensitivity = 1.0;
+		s.accelThreshold = 0.0;
+		s.accelExponent = 0.0;
+		s.accelMaxGain = 1.0;
+		s.smoothing = 0.0;
+		return s;
+	}
+
+	MouseAccumulator::MouseAccumulator()
+	{
+		settings = DefaultSettings();
+		for(unsigned int i = 0; i < MouseAxes; i++) axes[i] = 0;
+		Reset();
+	}
+
+	void MouseAccumulator::Reset()
+	{
+		for(unsigned int i = 0; i < MouseAxes; i++) remainder[i] = held[i] = 0.0;
+		lastTime = 0;
+		hasTime = false;
+	}
+
+	void MouseAccumulator::SetSettings(const MouseSettings& s)
+	{
+		settings = s;
+		if(!(settings.sensitivity > 0.0)) settings.sensitivity = 1.0;
+		if(!(settings.accelThreshold > 0.0)) settings.accelThreshold = 0.0;
+		if(!(settings.accelExponent > 0.0)) settings.accelExponent = 0.0;
+		if(!(settings.accelMaxGain >= 1.0)) settings.accelMaxGain = 1.0;
+		if(!(settings.smoothing > 0.0)) settings.smoothing = 0.0;
+		if(settings.smoothing > 0.95) settings.smoothing = 0.95;
+
+		// Motion held by previous smoothing is not lost.
+		if(settings.smoothing == 0.0)
+		{
+			for(unsigned int i = 0; i < MouseAxes; i++)
+			{
+				Apply(i, held[i]);
+				held[i] = 0.0;
+			}
+		}
+	}
+
+	long long MouseAccumulator::SaturatingAdd(long long a, long long b)
+	{
+		if(b > 0 && a > MouseAxisMax - b) return MouseAxisMax;
+		if(b < 0 && a < MouseAxisMin - b) return MouseAxisMin;
+		return a + b;
+	}
+
+	double MouseAccumulator::Gain(const MouseSettings& s, double speed)
+	{
+		if(s.accelThreshold == 0.0 || s.accelExponent == 0.0 || speed <= s.accelThreshold) return 1.0;
+
+		double gain = std::pow(speed / s.accelThreshold, s.accelExponent);
+		return gain < s.accelMaxGain ? gain : s.accelMaxGain;
+	}
+
+	void MouseAccumulator::Apply(unsigned int axis, double units)
+	{
+		// Whole units are truncated toward zero, so small motions in either direction are
+		// treated alike; fraction stays for next delta.
+		double total = remainder[axis] + units;
+		if(total > 9.0e18) total = 9.0e18;
+		if(total < -9.0e18) total = -9.0e18;
+
+		long long whole = (long long)total;
+		remainder[axis] = total - (double)whole;
+		axes[axis] = SaturatingAdd(axes[axis], whole);
+	}
+
+	void MouseAccumulator::AddMotion(const int counts[MouseAxes], unsigned int time)
+	{
+		double units[MouseAxes];
+		units[2] = (double)counts[2];
+
+		if(counts[0] != 0 || counts[1] != 0)
+		{
+			// Timestamps have millisecond resolution; reports of same millisecond count as one.
+			unsigned int interval = hasTime ? time - lastTime : MouseMaxInterval;
+			if(interval < 1) interval = 1;
+			if(interval > MouseMaxInterval) interval = MouseMaxInterval;
+			lastTime = time;
+			hasTime = true;
+
+			double x = (double)counts[0], y = (double)counts[1];
+			double speed = std::sqrt(x * x + y * y) * 1000.0 / (double)interval;
+			double scale = settings.sensitivity * Gain(settings, speed);
+			units[0] = x * scale;
+			units[1] = y * scale;
+		} else {
+			units[0] = units[1] = 0.0;
+		}
+
+		for(unsigned int i = 0; i < MouseAxes; i++)
+		{
+			if(units[i] == 0.0) continue;
+			if(settings.smoothing > 0.0 && i != 2) held[i] += units[i];
+			else Apply(i, units[i]);
+		}
+	}
+
+	void MouseAccumulator::Step()
+	{
+		if(settings.smoothing == 0.0) return;
+
+		for(unsigned int i = 0; i < MouseAxes; i++)
+		{
+			double release = held[i] * (1.0 - settings.smoothing);
+			if(std::fabs(held[i] - release) < MouseHeldEpsilon) release = held[i];
+
+			held[i] -= release;
+			Apply(i, release);
+		}
+	}
+
+}
+}
+}
+}
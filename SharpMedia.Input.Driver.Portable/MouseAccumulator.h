@@ -0,0 +1,63 @@
+#pragma once
+
+namespace SharpMedia {
+namespace Input {
+namespace Driver {
+namespace Portable {
+
+	static const unsigned int MouseAxes = 3;
+
+	struct MouseSettings
+	{
+		double sensitivity;			//< Axis units per count of motion.
+		double accelThreshold;		//< Counts per second above which motion is accelerated, 0 disables.
+		double accelExponent;		//< Gain is (speed / threshold) ^ exponent above threshold.
+		double accelMaxGain;		//< Upper bound of gain.
+		double smoothing;			//< Part of motion held back per step, 0 disables, below 1.
+	};
+
+	// Accumulates every hardware delta of a mouse into whole axis units. Sensitivity and
+	// acceleration are applied per delta, so high resolution mice keep their precision;
+	// fractions of units are carried to next delta instead of being truncated. Axes saturate
+	// instead of overflowing. Wheel (axis 2) is neither scaled, accelerated nor smoothed.
+	class MouseAccumulator
+	{
+		MouseSettings settings;
+		long long axes[MouseAxes];
+		double remainder[MouseAxes];	//< Fraction of unit not yet in axis.
+		double held[MouseAxes];			//< Motion held back by smoothing.
+		unsigned int lastTime;			//< Milliseconds of last motion.
+		bool hasTime;
+
+		void Apply(unsigned int axis, double units);
+	public:
+		MouseAccumulator();
+
+		void SetSettings(const MouseSettings& settings);
+		const MouseSettings& GetSettings() const { return settings; }
+
+		// Counts of one report at time in milliseconds (wraps); speed of acceleration is
+		// taken from X and Y together so diagonal motion keeps its direction.
+		void AddMotion(const int counts[MouseAxes], unsigned int time);
+
+		// Releases smoothed motion, called once per sample.
+		void Step();
+
+		long long GetAxis(unsigned int axis) const { return axes[axis]; }
+
+		// Drops held and fractional motion, axes stay.
+		void Reset();
+
+		static MouseSettings DefaultSettings();
+
+		// Gain of acceleration at speed in counts per second.
+		static double Gain(const MouseSettings& settings, double speed);
+
+		// Adds with saturation at limits of long long.
+		static long long SaturatingAdd(long long a, long long b);
+	};
+
+}
+}
+}
+}
@@ -42,5 +42,27 @@ namespace SharpMedia.Input.Driver
         /// <param name="desc"></param>
         /// <returns></returns>
         IInputDevice Create(InputDeviceDescriptor desc);
+
+        /// <summary>
+        /// Rate in Hz at which devices are sampled on a driver thread, 0 samples them when
+        /// state is obtained.
+        /// </summary>
+        uint PollingRate { get; set; }
+
+        /// <summary>
+        /// Latency from sample to state being obtained, in seconds.
+        /// </summary>
+        void GetPollingLatency(out float median, out float p99, out float max);
+
+        /// <summary>
+        /// Rates in Hz used instead of polling rate while window is in background or minimized,
+        /// when they are lower; 0 keeps polling rate.
+        /// </summary>
+        void SetBackgroundPollingRates(uint background, uint minimized);
+
+        /// <summary>
+        /// Creates action map for devices of this driver.
+        /// </summary>
+        IActionMap CreateActionMap();
     }
 }
@@ -13,6 +13,257 @@ using System.Text;
 
 namespace SharpMedia.Input.Driver
 {
+    /// <summary>
+    /// Buffered event of device.
+    /// </summary>
+    public struct BufferedInputEvent
+    {
+        /// <summary>
+        /// Milliseconds, clock of device.
+        /// </summary>
+        public uint Time;
+
+        /// <summary>
+        /// Events with same sequence happened at once.
+        /// </summary>
+        public uint Sequence;
+
+        /// <summary>
+        /// Button or axis event.
+        /// </summary>
+        public InputEventType Type;
+
+        /// <summary>
+        /// Button or axis index.
+        /// </summary>
+        public uint Id;
+
+        /// <summary>
+        /// Button state (0 or 1) or axis delta.
+        /// </summary>
+        public int Value;
+    }
+
+    /// <summary>
+    /// Press or release of key.
+    /// </summary>
+    public struct KeyTransition
+    {
+        /// <summary>
+        /// Key code (see KeyCodes).
+        /// </summary>
+        public uint Key;
+
+        /// <summary>
+        /// Key was pressed, otherwise released.
+        /// </summary>
+        public bool Pressed;
+    }
+
+    /// <summary>
+    /// Processing of mouse motion, applied by driver to every hardware delta.
+    /// </summary>
+    public struct MouseSettings
+    {
+        /// <summary>
+        /// Axis units per count of motion; fractions of units are kept, not lost.
+        /// </summary>
+        public float Sensitivity;
+
+        /// <summary>
+        /// Speed in counts per second above which motion is accelerated, 0 disables acceleration.
+        /// </summary>
+        public float AccelerationThreshold;
+
+        /// <summary>
+        /// Gain is (speed / threshold) ^ exponent above threshold.
+        /// </summary>
+        public float AccelerationExponent;
+
+        /// <summary>
+        /// Upper bound of gain.
+        /// </summary>
+        public float MaxAcceleration;
+
+        /// <summary>
+        /// Part of motion held back per sample (0 to 0.95), 0 disables smoothing.
+        /// </summary>
+        public float Smoothing;
+    }
+
+    /// <summary>
+    /// Filtering of joystick sticks, applied by driver.
+    /// </summary>
+    public struct JoystickSettings
+    {
+        /// <summary>
+        /// Part of stick range around center that reads as center (0 to 0.9).
+        /// </summary>
+        public float Deadzone;
+
+        /// <summary>
+        /// Part of stick range that reads as full deflection, 0 means whole range.
+        /// </summary>
+        public float Saturation;
+    }
+
+    /// <summary>
+    /// When binding of action fires.
+    /// </summary>
+    public enum ActionTrigger
+    {
+        /// <summary>
+        /// On press; action is held while pressed.
+        /// </summary>
+        Press,
+
+        /// <summary>
+        /// On release.
+        /// </summary>
+        Release,
+
+        /// <summary>
+        /// After held for threshold; action is held until release.
+        /// </summary>
+        Hold,
+
+        /// <summary>
+        /// On second press within threshold.
+        /// </summary>
+        DoubleTap,
+
+        /// <summary>
+        /// Value of action follows axis.
+        /// </summary>
+        Axis
+    }
+
+    /// <summary>
+    /// Binding of button or axis to action.
+    /// </summary>
+    public struct ActionBinding
+    {
+        /// <summary>
+        /// Action index, actions are numbered by application.
+        /// </summary>
+        public uint Action;
+
+        /// <summary>
+        /// When binding fires.
+        /// </summary>
+        public ActionTrigger Trigger;
+
+        /// <summary>
+        /// Slot of device in map (see IActionMap.Attach).
+        /// </summary>
+        public uint Device;
+
+        /// <summary>
+        /// Button, or axis for Axis trigger.
+        /// </summary>
+        public uint Input;
+
+        /// <summary>
+        /// Buttons that must be held with input, as device slot * 256 + button (modifiers,
+        /// chords); at most 4. Null for none.
+        /// </summary>
+        public uint[] Modifiers;
+
+        /// <summary>
+        /// Seconds of hold or between taps.
+        /// </summary>
+        public float Threshold;
+
+        /// <summary>
+        /// Action value per axis unit.
+        /// </summary>
+        public float Scale;
+
+        /// <summary>
+        /// Value is axis position, otherwise its change in frame.
+        /// </summary>
+        public bool Absolute;
+    }
+
+    /// <summary>
+    /// Binding that fired.
+    /// </summary>
+    public struct ActionEvent
+    {
+        /// <summary>
+        /// Action index.
+        /// </summary>
+        public uint Action;
+
+        /// <summary>
+        /// Trigger of binding.
+        /// </summary>
+        public ActionTrigger Trigger;
+
+        /// <summary>
+        /// 1 for buttons, axis value or change for axes.
+        /// </summary>
+        public float Value;
+    }
+
+    /// <summary>
+    /// Maps buttons and axes of devices to actions. Bindings are compiled to tables, so update
+    /// costs work only for inputs that changed, not for all bindings.
+    /// </summary>
+    [Linkable(LinkMask.Drivers)]
+    public interface IActionMap : IDisposable
+    {
+        /// <summary>
+        /// Adds binding, tables are rebuilt on next update.
+        /// </summary>
+        /// <returns>Index of binding.</returns>
+        int AddBinding(ActionBinding binding);
+
+        /// <summary>
+        /// Removes all bindings.
+        /// </summary>
+        void ClearBindings();
+
+        /// <summary>
+        /// Attaches device to slot (0 to 15); its buffered events and state are read on every
+        /// update, so presses shorter than a frame still fire. Buffered events of attached
+        /// device are consumed by map.
+        /// </summary>
+        void Attach(uint slot, IInputDevice device);
+
+        /// <summary>
+        /// Detaches device; its held buttons are released.
+        /// </summary>
+        void Detach(uint slot);
+
+        /// <summary>
+        /// Reads attached devices and evaluates bindings.
+        /// </summary>
+        /// <param name="time">Seconds, from any origin.</param>
+        void Update(double time);
+
+        /// <summary>
+        /// Action is held by any binding.
+        /// </summary>
+        bool IsActive(uint action);
+
+        /// <summary>
+        /// 1 while held, or value of axis.
+        /// </summary>
+        float GetValue(uint action);
+
+        /// <summary>
+        /// Times action fired in last update.
+        /// </summary>
+        uint GetTriggerCount(uint action);
+
+        /// <summary>
+        /// Reads events of last update not read yet, in order they fired.
+        /// </summary>
+        /// <returns>Number of events written.</returns>
+        int ReadEvents(ActionEvent[] events);
+    }
+
     /// <summary>
     /// Input device implementation.
     /// </summary>
@@ -24,6 +275,56 @@ namespace SharpMedia.Input.Driver
         /// </summary>
         void GetState(bool[] button, long[] axis);
 
+        /// <summary>
+        /// Reads events buffered since last read, oldest first. Events are collected when state
+        /// is obtained, so none between two polls are lost. Only one thread may read events.
+        /// </summary>
+        /// <returns>Number of events written.</returns>
+        int ReadEvents(BufferedInputEvent[] events);
+
+    }
+
+    /// <summary>
+    /// Keyboard that keeps keys as bits and reports only changes.
+    /// </summary>
+    [Linkable(LinkMask.Drivers)]
+    public interface IKeyboardDevice : IInputDevice
+    {
+        /// <summary>
+        /// Writes keys pressed or released since last call; keys that do not fit are
+        /// reported next time.
+        /// </summary>
+        /// <returns>Number of transitions written.</returns>
+        int ReadTransitions(KeyTransition[] transitions);
+
+        /// <summary>
+        /// Writes current keys as 256 bits (8 words), bit of key code is set when pressed.
+        /// </summary>
+        void GetKeyBits(uint[] bits);
+    }
+
+    /// <summary>
+    /// Mouse that accumulates every hardware delta with sub-unit precision.
+    /// </summary>
+    [Linkable(LinkMask.Drivers)]
+    public interface IMouseDevice : IInputDevice
+    {
+        /// <summary>
+        /// Settings, applied from next sample.
+        /// </summary>
+        MouseSettings Settings { get; set; }
+    }
 
+    /// <summary>
+    /// Joystick or gamepad. Axes are normalized, 65536 is full deflection; buttons after the
+    /// first 128 are directions of hats (up, right, down, left per hat).
+    /// </summary>
+    [Linkable(LinkMask.Drivers)]
+    public interface IJoystickDevice : IInputDevice
+    {
+        /// <summary>
+        /// Settings, applied from next sample.
+        /// </summary>
+        JoystickSettings Settings { get; set; }
     }
 }
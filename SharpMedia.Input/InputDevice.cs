@@ -185,6 +185,104 @@ namespace SharpMedia.Input
             }
         }
 
+        /// <summary>
+        /// Reads events buffered by device since last read, with device timestamps. Events
+        /// are collected on Sync, presses and releases between two syncs are all kept.
+        /// </summary>
+        /// <remarks>Devices of same descriptor share events, only one thread may read them.</remarks>
+        /// <returns>Number of events written.</returns>
+        public int ReadEvents(Driver.BufferedInputEvent[] events)
+        {
+            AssertNotDisposed();
+            return bucket.Device.ReadEvents(events);
+        }
+
+        /// <summary>
+        /// Reads keys pressed or released since last read, only for keyboards. Only changes
+        /// cross into managed code, so it is cheaper than comparing ButtonState.
+        /// </summary>
+        /// <returns>Number of transitions written.</returns>
+        public int ReadKeyTransitions(Driver.KeyTransition[] transitions)
+        {
+            AssertNotDisposed();
+            Driver.IKeyboardDevice keyboard = bucket.Device as Driver.IKeyboardDevice;
+            if (keyboard == null) throw new NotSupportedException("Device is not a keyboard.");
+
+            lock (bucket)
+            {
+                return keyboard.ReadTransitions(transitions);
+            }
+        }
+
+        /// <summary>
+        /// Gets pressed keys as 256 bits, bit of key code is set when pressed.
+        /// </summary>
+        public uint[] GetKeyBits()
+        {
+            AssertNotDisposed();
+            Driver.IKeyboardDevice keyboard = bucket.Device as Driver.IKeyboardDevice;
+            if (keyboard == null) throw new NotSupportedException("Device is not a keyboard.");
+
+            uint[] bits = new uint[8];
+            lock (bucket)
+            {
+                keyboard.GetKeyBits(bits);
+            }
+            return bits;
+        }
+
+        /// <summary>
+        /// Sensitivity, acceleration and smoothing of mouse motion, only for mice.
+        /// </summary>
+        public Driver.MouseSettings MouseSettings
+        {
+            get
+            {
+                AssertNotDisposed();
+                Driver.IMouseDevice mouse = bucket.Device as Driver.IMouseDevice;
+                if (mouse == null) throw new NotSupportedException("Device is not a mouse.");
+                return mouse.Settings;
+            }
+            set
+            {
+                AssertNotDisposed();
+                Driver.IMouseDevice mouse = bucket.Device as Driver.IMouseDevice;
+                if (mouse == null) throw new NotSupportedException("Device is not a mouse.");
+                mouse.Settings = value;
+            }
+        }
+
+        /// <summary>
+        /// Deadzone and saturation of joystick sticks, only for joysticks.
+        /// </summary>
+        public Driver.JoystickSettings JoystickSettings
+        {
+            get
+            {
+                AssertNotDisposed();
+                Driver.IJoystickDevice joystick = bucket.Device as Driver.IJoystickDevice;
+                if (joystick == null) throw new NotSupportedException("Device is not a joystick.");
+                return joystick.Settings;
+            }
+            set
+            {
+                AssertNotDisposed();
+                Driver.IJoystickDevice joystick = bucket.Device as Driver.IJoystickDevice;
+                if (joystick == null) throw new NotSupportedException("Device is not a joystick.");
+                joystick.Settings = value;
+            }
+        }
+
+        /// <summary>
+        /// Attaches device to slot of action map; map should be updated on thread that
+        /// syncs device. Map reads buffered events of device, ReadEvents gets none while attached.
+        /// </summary>
+        public void AttachTo(Driver.IActionMap map, uint slot)
+        {
+            AssertNotDisposed();
+            map.Attach(slot, bucket.Device);
+        }
+
         /// <summary>
         /// Tries to synhonize.
         /// </summary>
@@ -89,10 +89,64 @@ namespace SharpMedia.Input
             }
         }
 
+        /// <summary>
+        /// Rate in Hz at which devices are sampled on a driver thread. Sync then returns
+        /// latest sample immediately, so input latency does not depend on frame time.
+        /// Zero (default) samples devices on Sync.
+        /// </summary>
+        public uint PollingRate
+        {
+            get
+            {
+                AssertInitialized();
+                return inputService.PollingRate;
+            }
+            set
+            {
+                lock (syncRoot)
+                {
+                    AssertInitialized();
+                    inputService.PollingRate = value;
+                }
+            }
+        }
+
         #endregion
 
         #region Methods
 
+        /// <summary>
+        /// Gets latency from sample of device to Sync, in seconds.
+        /// </summary>
+        public void GetPollingLatency(out float median, out float p99, out float max)
+        {
+            AssertInitialized();
+            inputService.GetPollingLatency(out median, out p99, out max);
+        }
+
+        /// <summary>
+        /// Sets polling rates in Hz while window is in background or minimized, so unfocused
+        /// application does not sample at full rate; 0 keeps polling rate. Defaults are 30
+        /// and 5 Hz.
+        /// </summary>
+        public void SetBackgroundPollingRates(uint background, uint minimized)
+        {
+            lock (syncRoot)
+            {
+                AssertInitialized();
+                inputService.SetBackgroundPollingRates(background, minimized);
+            }
+        }
+
+        /// <summary>
+        /// Creates action map; devices are attached with InputDevice.AttachTo.
+        /// </summary>
+        public Driver.IActionMap CreateActionMap()
+        {
+            AssertInitialized();
+            return inputService.CreateActionMap();
+        }
+
         /// <summary>
         /// Creates a device baed on description.
         /// </summary>
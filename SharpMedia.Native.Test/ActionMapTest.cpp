@@ -0,0 +1,366 @@
+#include "Test.h"
+#include "ActionMap.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace SharpMedia::Input::Driver::Portable;
+
+namespace {
+
+	enum Actions { Fire, Save, Jump, Charge, Dash, LookX, Throttle, Chord };
+
+	const unsigned int Keyboard = 0, Mouse = 1;
+	const double Frame = 0.1;
+
+	// Map of every trigger kind over keyboard in slot 0 and mouse in slot 1.
+	struct Fixture
+	{
+		ActionMap map;
+		KeyBitset keys, buttons;
+		long long axes[InputMaxAxes];
+		std::vector<InputRecord> records;
+		double time;
+		unsigned int tick;
+
+		Fixture()
+		{
+			keys.Clear();
+			buttons.Clear();
+			memset(axes, 0, sizeof(axes));
+			time = 0.0;
+			tick = 1000;
+
+			ActionBinding b = ActionMap::DefaultBinding();
+			b.action = Fire;
+			b.input = ActionButton(Keyboard, 31);
+			map.AddBinding(b);
+
+			b.action = Save;
+			b.modifiers[0] = ActionButton(Keyboard, 29);
+			b.modifierCount = 1;
+			map.AddBinding(b);
+
+			b = ActionMap::DefaultBinding();
+			b.action = Jump;
+			b.kind = ActionRelease;
+			b.input = ActionButton(Keyboard, 57);
+			map.AddBinding(b);
+
+			b = ActionMap::DefaultBinding();
+			b.action = Charge;
+			b.kind = ActionHold;
+			b.threshold = 0.5;
+			b.input = ActionButton(Keyboard, 40);
+			map.AddBinding(b);
+
+			b = ActionMap::DefaultBinding();
+			b.action = Dash;
+			b.kind = ActionDoubleTap;
+			b.threshold = 0.3;
+			b.input = ActionButton(Keyboard, 41);
+			map.AddBinding(b);
+
+			b = ActionMap::DefaultBinding();
+			b.action = LookX;
+			b.kind = ActionAxis;
+			b.scale = 0.5f;
+			b.input = ActionAxisInput(Mouse, 0);
+			map.AddBinding(b);
+
+			b = ActionMap::DefaultBinding();
+			b.action = Throttle;
+			b.kind = ActionAxis;
+			b.absolute = true;
+			b.input = ActionAxisInput(Mouse, 1);
+			map.AddBinding(b);
+
+			b = ActionMap::DefaultBinding();
+			b.action = Chord;
+			b.input = ActionButton(Mouse, 0);
+			b.modifiers[0] = ActionButton(Mouse, 1);
+			b.modifierCount = 1;
+			map.AddBinding(b);
+
+			Update();
+		}
+
+		void Key(unsigned int key, bool pressed)
+		{
+			if(pressed) keys.Set(key);
+			else keys.Reset(key);
+		}
+
+		// Buffered record of key, milliseconds after previous one.
+		void Record(unsigned int key, bool pressed, unsigned int after)
+		{
+			tick += after;
+			InputRecord r = { tick, tick, InputRecordButton, (unsigned short)key, pressed ? 1 : 0 };
+			records.push_back(r);
+		}
+
+		void Update()
+		{
+			map.BeginFrame(time);
+			if(!records.empty()) map.ApplyRecords(Keyboard, &records[0], (unsigned int)records.size(), time);
+			records.clear();
+			map.UpdateDevice(Keyboard, keys, 0, 0, time);
+			map.UpdateDevice(Mouse, buttons, axes, InputMaxAxes, time);
+			time += Frame;
+		}
+
+		const ActionState& Get(unsigned int action) const { return map.GetAction(action); }
+	};
+
+	// Triggers, modifiers and axes from states.
+	void TestStates()
+	{
+		Fixture f;
+
+		f.Key(31, true);
+		f.Update();
+		TEST_CHECK(f.Get(Fire).triggers == 1 && f.Get(Fire).held == 1 && f.map.GetEvents().size() == 1);
+		f.Update();
+		TEST_CHECK(f.Get(Fire).triggers == 0 && f.Get(Fire).value == 1.0f);
+		f.Key(31, false);
+		f.Update();
+		TEST_CHECK(f.Get(Fire).held == 0 && f.Get(Fire).value == 0.0f);
+
+		// Ctrl+S does not also fire S.
+		f.Key(29, true);
+		f.Key(31, true);
+		f.Update();
+		TEST_CHECK(f.Get(Save).triggers == 1 && f.Get(Fire).triggers == 0);
+		f.Key(29, false);
+		f.Key(31, false);
+		f.Update();
+		TEST_CHECK(f.Get(Save).held == 0);
+
+		f.Key(57, true);
+		f.Update();
+		TEST_CHECK(f.Get(Jump).triggers == 0);
+		f.Key(57, false);
+		f.Update();
+		TEST_CHECK(f.Get(Jump).triggers == 1);
+
+		f.Key(40, true);
+		for(unsigned int i = 0; i < 5; i++) f.Update();
+		TEST_CHECK(f.Get(Charge).triggers == 0);
+		f.Update();
+		TEST_CHECK(f.Get(Charge).triggers == 1 && f.Get(Charge).held == 1);
+		f.Key(40, false);
+		f.Update();
+		TEST_CHECK(f.Get(Charge).held == 0);
+
+		f.axes[0] = 10;
+		f.axes[1] = 100;
+		f.Update();
+		TEST_CHECK(f.Get(LookX).value == 5.0f && f.Get(Throttle).value == 100.0f);
+		f.Update();
+		TEST_CHECK(f.Get(LookX).value == 0.0f && f.Get(Throttle).value == 100.0f);
+
+		f.buttons.Set(1);
+		f.Update();
+		f.buttons.Set(0);
+		f.Update();
+		TEST_CHECK(f.Get(Chord).triggers == 1);
+	}
+
+	// Presses shorter than a frame are seen only in records.
+	void TestShortPress()
+	{
+		Fixture f;
+
+		f.Record(31, true, 5);
+		f.Record(31, false, 30);
+		f.Record(57, true, 5);
+		f.Record(57, false, 20);
+		f.Update();
+		TEST_CHECK(f.Get(Fire).triggers == 1 && f.Get(Fire).held == 0 && f.Get(Fire).value == 0.0f);
+		TEST_CHECK(f.Get(Jump).triggers == 1);
+		TEST_CHECK(f.map.GetEvents().size() == 2);
+
+		// Without records, same frame sees nothing.
+		Fixture states;
+		states.Key(31, true);
+		states.Key(31, false);
+		states.Update();
+		TEST_CHECK(states.Get(Fire).triggers == 0);
+	}
+
+	// Two taps within one frame fire double tap; their spacing counts, not frame time.
+	void TestDoubleTap()
+	{
+		Fixture f;
+		f.Record(41, true, 0);
+		f.Record(41, false, 40);
+		f.Record(41, true, 40);
+		f.Record(41, false, 10);
+		f.Update();
+		TEST_CHECK(f.Get(Dash).triggers == 1);
+
+		// Taps over frames still within threshold.
+		f.Record(41, true, 500);
+		f.Record(41, false, 30);
+		f.Update();
+		f.Record(41, true, 100);
+		f.Update();
+		TEST_CHECK(f.Get(Dash).triggers == 1);
+		f.Record(41, false, 30);
+		f.Update();
+
+		// Taps further apart than threshold do not, even in consecutive frames.
+		f.Record(41, true, 2000);
+		f.Update();
+		f.Record(41, false, 10);
+		f.Update();
+		f.Update();
+		f.Update();
+		f.Record(41, true, 350);
+		f.Update();
+		TEST_CHECK(f.Get(Dash).triggers == 0);
+	}
+
+	// Records and state of same sample agree, so nothing fires twice; records that were lost
+	// are made up by state, records that come after state are ignored.
+	void TestRecordsAndState()
+	{
+		Fixture f;
+		f.Record(31, true, 10);
+		f.Key(31, true);
+		f.Update();
+		TEST_CHECK(f.Get(Fire).triggers == 1 && f.Get(Fire).held == 1);
+
+		f.Key(31, false);
+		f.Update();
+		TEST_CHECK(f.Get(Fire).held == 0);
+		f.Record(31, false, 10);
+		f.Update();
+		TEST_CHECK(f.Get(Fire).triggers == 0 && f.map.GetEvents().empty());
+
+		// Chord in records keeps order: modifier after key is not a chord.
+		f.Record(31, true, 10);
+		f.Record(29, true, 10);
+		f.Key(31, true);
+		f.Key(29, true);
+		f.Update();
+		TEST_CHECK(f.Get(Fire).triggers == 1 && f.Get(Save).triggers == 0);
+		f.Key(31, false);
+		f.Key(29, false);
+		f.Update();
+
+		// Hold pressed and released within frame does not fire.
+		f.Record(40, true, 10);
+		f.Record(40, false, 10);
+		f.Update();
+		for(unsigned int i = 0; i < 10; i++) f.Update();
+		TEST_CHECK(f.Get(Charge).triggers == 0 && f.Get(Charge).held == 0);
+
+		// Wrapping clock of device.
+		f.tick = 0xFFFFFFF0;
+		f.Record(41, true, 0);
+		f.Record(41, false, 10);
+		f.Record(41, true, 10);
+		f.Update();
+		TEST_CHECK(f.Get(Dash).triggers == 1);
+	}
+
+	// Per frame cost of map with 2000 bindings over 8 devices, idle and with one change, and
+	// cost of a frame that also applies a press and release from records.
+	void Benchmark()
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		const unsigned int Frames = 200000, Devices = 8;
+
+		ActionMap map;
+		for(unsigned int i = 0; i < 2000; i++)
+		{
+			ActionBinding b = ActionMap::DefaultBinding();
+			b.action = i;
+			b.input = ActionButton(i % Devices, (i * 7) % 256);
+			b.kind = i % 4;
+			if(i % 3 == 0)
+			{
+				b.modifiers[0] = ActionButton(i % Devices, (i * 13 + 1) % 256);
+				b.modifierCount = 1;
+			}
+			map.AddBinding(b);
+		}
+
+		KeyBitset states[Devices];
+		long long axes[InputMaxAxes] = { 0 };
+		for(unsigned int d = 0; d < Devices; d++)
+		{
+			states[d].Clear();
+			map.UpdateDevice(d, states[d], axes, InputMaxAxes, 0.0);
+		}
+
+		double time = 0.0;
+		Clock::time_point start = Clock::now();
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			time += 0.016;
+			map.BeginFrame(time);
+			for(unsigned int d = 0; d < Devices; d++) map.UpdateDevice(d, states[d], axes, InputMaxAxes, time);
+		}
+		Clock::time_point idle = Clock::now();
+
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			time += 0.016;
+			map.BeginFrame(time);
+			unsigned int key = (f * 37) % 256;
+			if(states[f % Devices].Get(key)) states[f % Devices].Reset(key);
+			else states[f % Devices].Set(key);
+			axes[0]++;
+			for(unsigned int d = 0; d < Devices; d++) map.UpdateDevice(d, states[d], axes, InputMaxAxes, time);
+		}
+		Clock::time_point changed = Clock::now();
+
+		unsigned int fired = 0;
+		InputRecord records[2] = { { 0, 0, InputRecordButton, 0, 1 }, { 0, 0, InputRecordButton, 0, 0 } };
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			time += 0.016;
+			map.BeginFrame(time);
+			records[0].id = records[1].id = (unsigned short)((f * 7) % 256);
+			records[0].time = f * 16;
+			records[1].time = f * 16 + 5;
+			if(!states[0].Get(records[0].id)) map.ApplyRecords(0, records, 2, time);
+			for(unsigned int d = 0; d < Devices; d++) map.UpdateDevice(d, states[d], axes, InputMaxAxes, time);
+			fired += (unsigned int)map.GetEvents().size();
+		}
+		Clock::time_point recorded = Clock::now();
+
+		unsigned int hits = 0;
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			for(unsigned int i = 0; i < 2000; i++)
+			{
+				if(states[i % Devices].Get((i * 7) % 256)) hits++;
+			}
+		}
+		Clock::time_point naive = Clock::now();
+
+		printf("%u frames, 2000 bindings on %u devices\n", Frames, Devices);
+		printf("  idle: %.1f ns per frame\n", std::chrono::duration<double, std::nano>(idle - start).count() / Frames);
+		printf("  one change: %.1f ns per frame\n", std::chrono::duration<double, std::nano>(changed - idle).count() / Frames);
+		printf("  press and release in records: %.1f ns per frame (%u events)\n",
+			std::chrono::duration<double, std::nano>(recorded - changed).count() / Frames, fired);
+		printf("  scan of all bindings: %.1f ns per frame (%u)\n",
+			std::chrono::duration<double, std::nano>(naive - recorded).count() / Frames, hits);
+		TEST_CHECK(fired > 0);
+	}
+
+}
+
+int main()
+{
+	TestStates();
+	TestShortPress();
+	TestDoubleTap();
+	TestRecordsAndState();
+	Benchmark();
+	return SharpMedia::Test::Result("ActionMapTest");
+}
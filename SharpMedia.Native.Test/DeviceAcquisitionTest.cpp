@@ -0,0 +1,200 @@
+#include "Test.h"
+#include "DeviceAcquisition.h"
+#include "InputPoller.h"
+#include <chrono>
+#include <thread>
+
+using namespace SharpMedia::Input::Driver::Portable;
+
+namespace {
+
+	class SteadyClock : public PollerClock
+	{
+	public:
+		virtual double Now()
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		virtual void SleepUntil(double time)
+		{
+			while(Now() < time) std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	};
+
+	class SimulatedClock : public PollerClock
+	{
+	public:
+		double time;
+
+		SimulatedClock() : time(0.0) {}
+
+		virtual double Now() { return time; }
+		virtual void SleepUntil(double t) { if(t > time) time = t; }
+	};
+
+	// Stand-in of DirectInput source: device that can be taken away, acquired the way
+	// DIAcquire does it.
+	class LostDevice : public InputSource
+	{
+		PollerClock* clock;
+		InputFocusState* focus;
+	public:
+		DeviceAcquisition acquisition;
+		volatile bool available;
+		volatile unsigned int acquires;
+		volatile unsigned int reads;
+
+		LostDevice(PollerClock* clock, InputFocusState* focus)
+			: clock(clock), focus(focus), available(true), acquires(0), reads(0) {}
+
+		virtual bool Sample(InputDeviceState& state)
+		{
+			if(!acquisition.IsAcquired())
+			{
+				double now = clock->Now();
+				if(!acquisition.ShouldAttempt(now, focus->GetGained())) return false;
+
+				acquires++;
+				if(!available)
+				{
+					acquisition.Failed(now);
+					return false;
+				}
+				acquisition.Acquired();
+			}
+
+			if(!available)
+			{
+				acquisition.Lost();
+				return false;
+			}
+			reads++;
+			state.axes[0] = reads;
+			return true;
+		}
+	};
+
+	// Lost device is tried again at once, then after 50 ms doubling up to 2 s.
+	void TestBackoff()
+	{
+		DeviceAcquisition acquisition;
+		TEST_CHECK(acquisition.IsAcquired() && !acquisition.ShouldAttempt(0.0, 0));
+
+		acquisition.Lost();
+		TEST_CHECK(acquisition.ShouldAttempt(1.0, 0));
+		acquisition.Failed(1.0);
+		TEST_CHECK(!acquisition.ShouldAttempt(1.04, 0) && acquisition.ShouldAttempt(1.05, 0));
+
+		// Gaps between attempts when polled every millisecond.
+		double time = 1.05, gaps[12];
+		for(unsigned int i = 0; i < 12; i++)
+		{
+			acquisition.Failed(time);
+			double next = time;
+			while(!acquisition.ShouldAttempt(next, 0)) next += 0.001;
+			gaps[i] = next - time;
+			time = next;
+		}
+		TEST_NEAR(gaps[0], 0.1, 0.0015);
+		TEST_NEAR(gaps[1], 0.2, 0.0015);
+		TEST_NEAR(gaps[3], 0.8, 0.0015);
+		TEST_NEAR(gaps[11], DeviceAcquisition::MaxBackoff, 0.0015);
+
+		const AcquisitionStats& stats = acquisition.GetStats();
+		TEST_CHECK(stats.attempts == 13 && stats.failures == 13 && stats.losses == 1);
+	}
+
+	// Focus gain makes next attempt immediate and starts back off again.
+	void TestFocusGain()
+	{
+		DeviceAcquisition acquisition;
+		InputFocusState focus;
+		acquisition.Lost();
+		for(unsigned int i = 0; i < 8; i++) acquisition.Failed(10.0);
+		TEST_CHECK(!acquisition.ShouldAttempt(10.5, focus.GetGained()));
+
+		focus.Set(InputFocusBackground);
+		TEST_CHECK(!acquisition.ShouldAttempt(10.5, focus.GetGained()));
+		focus.Set(InputFocusForeground);
+		TEST_CHECK(acquisition.ShouldAttempt(10.5, focus.GetGained()));
+
+		acquisition.Failed(10.5);
+		TEST_CHECK(!acquisition.ShouldAttempt(10.54, focus.GetGained()));
+		TEST_CHECK(acquisition.ShouldAttempt(10.55, focus.GetGained()));
+
+		acquisition.Acquired();
+		TEST_CHECK(acquisition.IsAcquired() && !acquisition.ShouldAttempt(11.0, focus.GetGained()));
+	}
+
+	// Sampled by poller at 1000 Hz for 30 seconds, lost device costs tens of acquires, not
+	// thousands; it is read again on first sample after it comes back and window is focused.
+	void TestPolledDevice()
+	{
+		SimulatedClock clock;
+		InputPoller* poller = new InputPoller(&clock);
+		LostDevice device(&clock, &poller->GetFocus());
+		int slot = poller->AddSource(&device);
+
+		poller->Step();
+		TEST_CHECK(device.reads == 1 && poller->Read(slot) != 0);
+
+		device.available = false;
+		poller->GetFocus().Set(InputFocusBackground);
+		for(unsigned int i = 0; i < 30000; i++)
+		{
+			clock.time += 0.001;
+			poller->Step();
+		}
+		TEST_CHECK(device.acquires >= 15 && device.acquires <= 25);
+		TEST_CHECK(poller->GetStats().failures == 30000);
+
+		device.available = true;
+		poller->GetFocus().Set(InputFocusForeground);
+		clock.time += 0.001;
+		poller->Step();
+		TEST_CHECK(device.reads == 2);
+
+		poller->RemoveSource(slot);
+		poller->Release();
+	}
+
+	// Same on poller thread: lost device in background is retried a few times a second.
+	void TestThreadedDevice()
+	{
+		SteadyClock clock;
+		InputPoller* poller = new InputPoller(&clock);
+		LostDevice device(&clock, &poller->GetFocus());
+		int slot = poller->AddSource(&device);
+		TEST_CHECK(poller->Start(1000));
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		device.available = false;
+		poller->GetFocus().Set(InputFocusBackground);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+		unsigned int acquires = device.acquires;
+
+		// 0, 0.05, 0.15, 0.35 and 0.75 seconds after loss.
+		TEST_CHECK(acquires >= 3 && acquires <= 7);
+
+		device.available = true;
+		poller->GetFocus().Set(InputFocusForeground);
+		unsigned int reads = device.reads;
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		TEST_CHECK(device.reads > reads);
+
+		poller->Stop();
+		poller->RemoveSource(slot);
+		poller->Release();
+	}
+
+}
+
+int main()
+{
+	TestBackoff();
+	TestFocusGain();
+	TestPolledDevice();
+	TestThreadedDevice();
+	return SharpMedia::Test::Result("DeviceAcquisitionTest");
+}
@@ -0,0 +1,216 @@
+#include "Test.h"
+#include "DrawBatcher.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	// Stand-in device that records what it is asked to do. Each call may spend a fixed amount
+	// of work, as driver calls do, so benchmarks weigh calls against batching.
+	class RecordingSink : public DrawSink
+	{
+		void Spend()
+		{
+			volatile unsigned int work = 0;
+			for(unsigned int i = 0; i < callCost; i++) work = work + i;
+		}
+	public:
+		struct Call
+		{
+			unsigned int pipeline, material, buffers;
+			unsigned int indexCount, instanceCount, startIndex, startInstance;
+		};
+
+		unsigned int pipeline, material, buffers;
+		unsigned int stateChanges;
+		unsigned int callCost;		//< Iterations of work per call.
+		bool failUpload;
+		std::vector<unsigned char> instances;
+		std::vector<Call> calls;
+
+		RecordingSink() : pipeline(0), material(0), buffers(0), stateChanges(0), callCost(0), failUpload(false) {}
+
+		virtual void SetPipeline(unsigned int pipeline) { this->pipeline = pipeline; stateChanges++; Spend(); }
+		virtual void SetMaterial(unsigned int material) { this->material = material; stateChanges++; Spend(); }
+		virtual void SetBuffers(unsigned int buffers) { this->buffers = buffers; stateChanges++; Spend(); }
+
+		virtual bool UploadInstances(const void* data, unsigned int count, unsigned int stride)
+		{
+			Spend();
+			if(failUpload) return false;
+			const unsigned char* bytes = (const unsigned char*)data;
+			instances.assign(bytes, bytes + count * stride);
+			return true;
+		}
+
+		virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount,
+			unsigned int startIndex, int, unsigned int startInstance)
+		{
+			Spend();
+			Call call = { pipeline, material, buffers, indexCount, instanceCount, startIndex, startInstance };
+			calls.push_back(call);
+		}
+	};
+
+	// Draws of same state and mesh are merged; each instance reads data of its own draw.
+	void TestMerge()
+	{
+		DrawBatcher batcher(sizeof(int), 3);
+		for(int i = 0; i < 10; i++)
+		{
+			batcher.Add(i % 2, 0, 1, 1.0f - i * 0.1f, 36, 0, 0, &i);
+		}
+
+		RecordingSink sink;
+		TEST_CHECK(batcher.Flush(sink));
+		TEST_CHECK(batcher.GetStats().draws == 10);
+		TEST_CHECK(batcher.GetStats().pipelineChanges == 2);
+
+		// Five draws per pipeline, at most three instances per call.
+		TEST_CHECK(sink.calls.size() == 4);
+		unsigned int instances = 0;
+		for(size_t i = 0; i < sink.calls.size(); i++)
+		{
+			const RecordingSink::Call& call = sink.calls[i];
+			TEST_CHECK(call.instanceCount <= 3);
+			for(unsigned int j = 0; j < call.instanceCount; j++)
+			{
+				int draw;
+				memcpy(&draw, &sink.instances[(call.startInstance + j) * sizeof(int)], sizeof(int));
+				TEST_CHECK((unsigned int)draw % 2 == call.pipeline);
+			}
+			instances += call.instanceCount;
+		}
+		TEST_CHECK(instances == 10);
+		TEST_CHECK(batcher.GetDrawCount() == 0);
+	}
+
+	// Ids that are equal in low 16 bits are different states.
+	void TestWideIds()
+	{
+		DrawBatcher batcher(0);
+		batcher.Add(1, 2, 3, 0.5f, 6, 0, 0, 0);
+		batcher.Add(1 + 65536, 2, 3, 0.5f, 6, 0, 0, 0);
+		batcher.Add(1, 2 + 65536, 3, 0.5f, 6, 0, 0, 0);
+		batcher.Add(1, 2, 3 + 65536, 0.5f, 6, 0, 0, 0);
+		batcher.Add(0x80000001u, 2, 3, 0.5f, 6, 0, 0, 0);
+
+		RecordingSink sink;
+		TEST_CHECK(batcher.Flush(sink));
+		TEST_CHECK(sink.calls.size() == 5);
+		TEST_CHECK(sink.calls.back().pipeline == 0x80000001u);
+		for(size_t i = 0; i < sink.calls.size(); i++) TEST_CHECK(sink.calls[i].instanceCount == 1);
+	}
+
+	// A flush whose data could not be uploaded draws nothing.
+	void TestUploadFailure()
+	{
+		DrawBatcher batcher(sizeof(int));
+		for(int i = 0; i < 4; i++) batcher.Add(0, 0, 0, 0.0f, 3, 0, 0, &i);
+
+		RecordingSink sink;
+		sink.failUpload = true;
+		TEST_CHECK(!batcher.Flush(sink));
+		TEST_CHECK(sink.calls.empty());
+		TEST_CHECK(batcher.GetDrawCount() == 0);
+
+		sink.failUpload = false;
+		int i = 0;
+		batcher.Add(0, 0, 0, 0.0f, 3, 0, 0, &i);
+		TEST_CHECK(batcher.Flush(sink));
+		TEST_CHECK(sink.calls.size() == 1);
+	}
+
+	struct SceneObject
+	{
+		unsigned int pipeline, material, buffers, mesh;
+		float depth;
+		float transform[16];
+	};
+
+	// Frame of objects in scene graph order, few pipelines, materials and meshes.
+	void MakeScene(std::vector<SceneObject>& objects, unsigned int count)
+	{
+		srand(1);
+		objects.resize(count);
+		for(unsigned int i = 0; i < count; i++)
+		{
+			SceneObject& o = objects[i];
+			o.pipeline = rand() % 8;
+			o.material = rand() % 32;
+			o.mesh = rand() % 16;
+			o.buffers = o.mesh / 4;
+			o.depth = (float)rand() / RAND_MAX;
+			for(unsigned int j = 0; j < 16; j++) o.transform[j] = (float)(i + j);
+		}
+	}
+
+	// Draw calls and CPU time per frame with and without batching; sink calls cost a few
+	// microseconds each, as driver calls do.
+	void Benchmark()
+	{
+		const unsigned int ObjectCount = 20000, Frames = 10, CallCost = 1000;
+		std::vector<SceneObject> objects;
+		MakeScene(objects, ObjectCount);
+
+		typedef std::chrono::high_resolution_clock Clock;
+		RecordingSink unbatched, batched;
+		unbatched.callCost = batched.callCost = CallCost;
+
+		// Unbatched: every object binds its state and draws with its data.
+		Clock::time_point start = Clock::now();
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			unbatched.calls.clear();
+			for(unsigned int i = 0; i < ObjectCount; i++)
+			{
+				const SceneObject& o = objects[i];
+				unbatched.SetPipeline(o.pipeline);
+				unbatched.SetMaterial(o.material);
+				unbatched.SetBuffers(o.buffers);
+				unbatched.UploadInstances(o.transform, 1, sizeof(o.transform));
+				unbatched.DrawIndexedInstanced(36, 1, (o.mesh % 4) * 36, 0, 0);
+			}
+		}
+		double unbatchedTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / Frames;
+
+		DrawBatcher batcher(sizeof(float) * 16);
+		start = Clock::now();
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			batched.calls.clear();
+			for(unsigned int i = 0; i < ObjectCount; i++)
+			{
+				const SceneObject& o = objects[i];
+				batcher.Add(o.pipeline, o.material, o.buffers, o.depth, 36, (o.mesh % 4) * 36, 0, o.transform);
+			}
+			TEST_CHECK(batcher.Flush(batched));
+		}
+		double batchedTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / Frames;
+
+		printf("%u objects per frame\n", ObjectCount);
+		printf("  unbatched: %6u draw calls, %6u state changes, %.3f ms\n",
+			(unsigned int)unbatched.calls.size(), unbatched.stateChanges / Frames, unbatchedTime);
+		printf("  batched:   %6u draw calls, %6u state changes, %.3f ms\n",
+			(unsigned int)batched.calls.size(), batched.stateChanges / Frames, batchedTime);
+
+		// 8 * 32 states of 16 meshes each at most.
+		TEST_CHECK(batched.calls.size() <= 8 * 32 * 16);
+		TEST_CHECK(batched.calls.size() < unbatched.calls.size());
+		TEST_CHECK(batchedTime < unbatchedTime);
+	}
+
+}
+
+int main()
+{
+	TestMerge();
+	TestWideIds();
+	TestUploadFailure();
+	Benchmark();
+	return SharpMedia::Test::Result("DrawBatcherTest");
+}
@@ -0,0 +1,368 @@
+#include "Test.h"
+#include "EvdevInput.h"
+#include "EvdevActionMap.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <linux/input.h>
+
+using namespace SharpMedia::Input::Driver;
+using namespace SharpMedia::Input::Driver::Evdev;
+
+namespace {
+
+	// Empty directory, so driver finds no real devices and tests control all of them.
+	class TempDirectory
+	{
+	public:
+		std::string path;
+
+		TempDirectory()
+		{
+			char name[] = "/tmp/SharpMediaEvdevXXXXXX";
+			if(mkdtemp(name)) path = name;
+		}
+
+		~TempDirectory()
+		{
+			if(!path.empty()) rmdir(path.c_str());
+		}
+	};
+
+	// Stand-in of evdev device: events written to pipe are read by driver as from a node.
+	class FakeDevice
+	{
+	public:
+		int read;
+		int write;
+
+		FakeDevice() : read(-1), write(-1)
+		{
+			int fds[2];
+			if(pipe(fds) == 0)
+			{
+				read = fds[0];
+				write = fds[1];
+			}
+		}
+
+		~FakeDevice()
+		{
+			Unplug();
+		}
+
+		void Send(unsigned short type, unsigned short code, int value)
+		{
+			input_event e;
+			memset(&e, 0, sizeof(e));
+			e.type = type;
+			e.code = code;
+			e.value = value;
+			if(::write(write, &e, sizeof(e)) != (ssize_t)sizeof(e)) TEST_CHECK(!"write");
+		}
+
+		void Report()
+		{
+			Send(EV_SYN, SYN_REPORT, 0);
+		}
+
+		// Reader sees end of file, as of unplugged device.
+		void Unplug()
+		{
+			if(write >= 0) close(write);
+			write = -1;
+		}
+	};
+
+	// Nodes of watched directory are FIFOs; they are opened as standard keyboards. Pressed
+	// keys read after dropped events are set by test.
+	class FakeReader : public EvdevReader
+	{
+	public:
+		unsigned int opened;
+		unsigned long pressed[(EvdevKeyCodes + EvdevCapabilities::LongBits - 1) / EvdevCapabilities::LongBits];
+
+		FakeReader() : opened(0)
+		{
+			memset(pressed, 0, sizeof(pressed));
+		}
+
+		void Press(unsigned int code)
+		{
+			pressed[code / EvdevCapabilities::LongBits] |= 1ul << (code % EvdevCapabilities::LongBits);
+		}
+
+		virtual bool ReadKeys(int, unsigned long* bits, unsigned int size)
+		{
+			memcpy(bits, pressed, size < sizeof(pressed) ? size : sizeof(pressed));
+			return true;
+		}
+
+		virtual bool OpenDevice(const char* path)
+		{
+			int fd = open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+			if(fd < 0) return false;
+
+			opened++;
+			return AddDevice(fd, EvdevCapabilities::Standard(EvdevKeyboard), "Fake Keyboard", path);
+		}
+	};
+
+	int FindDescriptor(SmEvdevInput* input, int type, int id)
+	{
+		SmEvdevDescriptor descriptor;
+		for(int i = 0; SmEvdevGetDescriptor(input, i, &descriptor); i++)
+		{
+			if(descriptor.type == type && descriptor.id == id) return i;
+		}
+		return -1;
+	}
+
+	// Keys are reported by key code of DirectInput (A is 11), mouse buttons and motion by
+	// index; both have state and records.
+	void TestKeyboardAndMouse()
+	{
+		TempDirectory directory;
+		SmEvdevInput* input = SmEvdevCreate(directory.path.c_str(), 800, 600);
+		TEST_CHECK(input && SmEvdevGetDescriptorCount(input) == 1);
+
+		FakeDevice keyboard, mouse;
+		TEST_CHECK(SmEvdevAddDevice(input, keyboard.read, EvdevKeyboard));
+		TEST_CHECK(SmEvdevAddDevice(input, mouse.read, EvdevMouse));
+		TEST_CHECK(FindDescriptor(input, EvdevTypeKeyboard, 0) >= 0 && FindDescriptor(input, EvdevTypeMouse, 0) >= 0);
+
+		int k = SmEvdevCreateDevice(input, EvdevTypeKeyboard, 0);
+		int m = SmEvdevCreateDevice(input, EvdevTypeMouse, 0);
+		TEST_CHECK(k >= 0 && m >= 0 && SmEvdevCreateDevice(input, EvdevTypeMouse, 1) < 0);
+
+		keyboard.Send(EV_KEY, KEY_A, 1);
+		keyboard.Report();
+		keyboard.Send(EV_KEY, KEY_A, 2);
+		keyboard.Report();
+		mouse.Send(EV_KEY, BTN_RIGHT, 1);
+		mouse.Send(EV_REL, REL_X, 5);
+		mouse.Report();
+
+		unsigned char buttons[256];
+		long long axes[8];
+		TEST_CHECK(SmEvdevGetState(input, k, buttons, 256, axes, 8) && buttons[11] == 1 && buttons[30] == 0);
+		TEST_CHECK(SmEvdevGetState(input, m, buttons, 8, axes, 3) && buttons[1] == 1 && buttons[0] == 0);
+
+		// Repeat is not a record.
+		SmEvdevRecord records[8];
+		TEST_CHECK(SmEvdevReadEvents(input, k, records, 8) == 1);
+		TEST_CHECK(records[0].type == Portable::InputRecordButton && records[0].id == 11 && records[0].value == 1);
+
+		int count = SmEvdevReadEvents(input, m, records, 8);
+		TEST_CHECK(count == 2 && records[0].sequence == records[1].sequence);
+		TEST_CHECK(records[1].type == Portable::InputRecordAxis && records[1].id == 0 && records[1].value == 5);
+
+		keyboard.Send(EV_KEY, KEY_A, 0);
+		keyboard.Report();
+		TEST_CHECK(SmEvdevGetState(input, k, buttons, 256, axes, 8) && buttons[11] == 0);
+
+		SmEvdevDestroy(input);
+	}
+
+	// Standard gamepad: sticks, hat and buttons in DirectInput layout, buttons have records;
+	// unplugged gamepad leaves descriptors.
+	void TestGamepad()
+	{
+		TempDirectory directory;
+		SmEvdevInput* input = SmEvdevCreate(directory.path.c_str(), 800, 600);
+
+		FakeDevice gamepad;
+		TEST_CHECK(SmEvdevAddDevice(input, gamepad.read, EvdevJoystick));
+		TEST_CHECK(FindDescriptor(input, EvdevTypeJoystick, 0) >= 0 && FindDescriptor(input, EvdevTypeJoystick, 1) < 0);
+
+		int j = SmEvdevCreateDevice(input, EvdevTypeJoystick, 0);
+		TEST_CHECK(j >= 0);
+
+		float settings[2];
+		TEST_CHECK(SmEvdevGetJoystickSettings(input, j, settings) && settings[0] > 0.0f);
+		TEST_CHECK(!SmEvdevGetMouseSettings(input, j, settings));
+
+		gamepad.Send(EV_ABS, ABS_X, 32767);
+		gamepad.Send(EV_ABS, ABS_HAT0Y, -1);
+		gamepad.Send(EV_KEY, BTN_SOUTH, 1);
+		gamepad.Send(EV_KEY, BTN_WEST, 1);
+		gamepad.Report();
+
+		unsigned char buttons[Portable::JoystickButtonCount];
+		long long axes[Portable::JoystickAxes];
+		TEST_CHECK(SmEvdevGetState(input, j, buttons, Portable::JoystickButtonCount, axes, Portable::JoystickAxes));
+		TEST_CHECK(axes[0] == Portable::JoystickAxisScale);
+		TEST_NEAR(axes[1], 0, 1);
+		TEST_CHECK(buttons[0] == 1 && buttons[1] == 0 && buttons[3] == 1);
+		TEST_CHECK(buttons[Portable::JoystickButtons] == 1 && buttons[Portable::JoystickButtons + 2] == 0);
+
+		SmEvdevRecord records[8];
+		TEST_CHECK(SmEvdevReadEvents(input, j, records, 8) == 3);
+
+		gamepad.Send(EV_KEY, BTN_SOUTH, 0);
+		gamepad.Report();
+		TEST_CHECK(SmEvdevGetState(input, j, buttons, Portable::JoystickButtonCount, axes, Portable::JoystickAxes));
+		TEST_CHECK(SmEvdevReadEvents(input, j, records, 8) == 1 && records[0].id == 0 && records[0].value == 0);
+
+		gamepad.Unplug();
+		TEST_CHECK(SmEvdevUpdateDescriptors(input) == 1);
+		TEST_CHECK(FindDescriptor(input, EvdevTypeJoystick, 0) < 0);
+		TEST_CHECK(SmEvdevUpdateDescriptors(input) == 0);
+
+		SmEvdevDestroy(input);
+	}
+
+	// Node created in watched directory is opened on next pump and read; removed node drops
+	// its device.
+	void TestHotplug()
+	{
+		TempDirectory directory;
+		FakeReader reader;
+		TEST_CHECK(reader.IsValid() && reader.Watch(directory.path.c_str()));
+
+		std::string path = directory.path + "/event0";
+		std::string other = directory.path + "/mouse0";
+		unsigned int changes = reader.GetChanges();
+		TEST_CHECK(mkfifo(path.c_str(), 0600) == 0 && mkfifo(other.c_str(), 0600) == 0);
+		reader.Pump();
+		TEST_CHECK(reader.opened == 1 && reader.GetDeviceCount() == 1 && reader.GetChanges() != changes);
+
+		// Permissions changed by udev after creation do not open it twice.
+		chmod(path.c_str(), 0660);
+		reader.Pump();
+		TEST_CHECK(reader.GetDeviceCount() == 1);
+
+		int fd = open(path.c_str(), O_WRONLY | O_NONBLOCK);
+		input_event e[2];
+		memset(e, 0, sizeof(e));
+		e[0].type = EV_KEY;
+		e[0].code = KEY_A;
+		e[0].value = 1;
+		e[1].type = EV_SYN;
+		e[1].code = SYN_REPORT;
+		TEST_CHECK(fd >= 0 && write(fd, e, sizeof(e)) == (ssize_t)sizeof(e));
+		reader.Pump();
+		TEST_CHECK(reader.GetKeys().Get(reader.GetKeyIndex(KEY_A)));
+
+		changes = reader.GetChanges();
+		unlink(path.c_str());
+		unlink(other.c_str());
+		reader.Pump();
+		TEST_CHECK(reader.GetDeviceCount() == 0 && reader.GetChanges() != changes);
+		if(fd >= 0) close(fd);
+	}
+
+	// Events after overflow of kernel buffer are discarded up to next report; then keys and
+	// buttons are read from device and those that changed get records of that report.
+	void TestDropped()
+	{
+		FakeReader reader;
+		FakeDevice device;
+		TEST_CHECK(reader.AddDevice(device.read, EvdevKeyboard | EvdevMouse, "Fake"));
+
+		device.Send(EV_KEY, KEY_A, 1);
+		device.Send(EV_KEY, KEY_S, 1);
+		device.Send(EV_KEY, BTN_LEFT, 1);
+		device.Report();
+		reader.Pump();
+
+		InputRecord records[8];
+		TEST_CHECK(reader.GetKeyboardRing().Pop(records, 8) == 2);
+		TEST_CHECK(reader.GetMouseRing().Pop(records, 8) == 1);
+
+		// While dropped, S and left button were released and W pressed.
+		reader.Press(KEY_A);
+		reader.Press(KEY_W);
+		device.Send(EV_SYN, SYN_DROPPED, 0);
+		device.Send(EV_KEY, KEY_D, 1);
+		device.Send(EV_REL, REL_X, 7);
+		device.Report();
+		device.Send(EV_KEY, KEY_E, 1);
+		device.Report();
+		reader.Pump();
+
+		const KeyBitset& keys = reader.GetKeys();
+		TEST_CHECK(keys.Get(reader.GetKeyIndex(KEY_A)) && keys.Get(reader.GetKeyIndex(KEY_W)));
+		TEST_CHECK(!keys.Get(reader.GetKeyIndex(KEY_S)) && !keys.Get(reader.GetKeyIndex(KEY_D)));
+		TEST_CHECK(keys.Get(reader.GetKeyIndex(KEY_E)));
+		TEST_CHECK(!reader.GetButton(0) && reader.GetCount(0) == 0);
+
+		unsigned int count = reader.GetKeyboardRing().Pop(records, 8);
+		TEST_CHECK(count == 3);
+		if(count == 3)
+		{
+			TEST_CHECK(records[0].id == reader.GetKeyIndex(KEY_W) && records[0].value == 1);
+			TEST_CHECK(records[1].id == reader.GetKeyIndex(KEY_S) && records[1].value == 0);
+			TEST_CHECK(records[0].sequence == records[1].sequence);
+			TEST_CHECK(records[2].id == reader.GetKeyIndex(KEY_E) && records[2].sequence != records[0].sequence);
+		}
+
+		count = reader.GetMouseRing().Pop(records, 8);
+		TEST_CHECK(count == 1 && records[0].id == 0 && records[0].value == 0);
+	}
+
+	// Action map of driver sees press and release of one frame from records of keyboard.
+	void TestActionMap()
+	{
+		TempDirectory directory;
+		SmEvdevInput* input = SmEvdevCreate(directory.path.c_str(), 800, 600);
+		FakeDevice keyboard;
+		SmEvdevAddDevice(input, keyboard.read, EvdevKeyboard);
+		int k = SmEvdevCreateDevice(input, EvdevTypeKeyboard, 0);
+
+		SmEvdevActionMap* map = SmEvdevActionMapCreate();
+		unsigned int ctrl = Portable::ActionButton(0, 29);
+		TEST_CHECK(SmEvdevActionMapAddBinding(map, 0, Portable::ActionPress, 0, 11, 0, 0, 0.0f, 1.0f, 0) == 0);
+		TEST_CHECK(SmEvdevActionMapAddBinding(map, 1, Portable::ActionPress, 0, 11, &ctrl, 1, 0.0f, 1.0f, 0) == 1);
+		TEST_CHECK(SmEvdevActionMapAddBinding(map, 2, Portable::ActionPress, 0, 256, 0, 0, 0.0f, 1.0f, 0) == -1);
+
+		// First frame only remembers state of device.
+		unsigned int bits[8] = { 0 };
+		long long axes[8] = { 0 };
+		SmEvdevActionMapBeginFrame(map, 0.0);
+		SmEvdevActionMapUpdateDevice(map, 0, bits, axes, 8, 0.0);
+
+		keyboard.Send(EV_KEY, KEY_A, 1);
+		keyboard.Report();
+		keyboard.Send(EV_KEY, KEY_A, 0);
+		keyboard.Report();
+
+		unsigned char buttons[256];
+		SmEvdevRecord records[8];
+		SmEvdevGetState(input, k, buttons, 256, axes, 8);
+		int count = SmEvdevReadEvents(input, k, records, 8);
+		TEST_CHECK(count == 2 && buttons[11] == 0);
+
+		SmEvdevActionMapBeginFrame(map, 0.016);
+		SmEvdevActionMapApplyRecords(map, 0, records, (unsigned int)count, 0.016);
+		SmEvdevActionMapUpdateDevice(map, 0, bits, axes, 8, 0.016);
+
+		float value;
+		unsigned int held, triggers;
+		TEST_CHECK(SmEvdevActionMapGetAction(map, 0, &value, &held, &triggers) && triggers == 1 && held == 0);
+		TEST_CHECK(SmEvdevActionMapGetAction(map, 1, &value, &held, &triggers) && triggers == 0);
+		TEST_CHECK(!SmEvdevActionMapGetAction(map, 2, &value, &held, &triggers));
+
+		SmEvdevActionEvent events[4];
+		TEST_CHECK(SmEvdevActionMapGetEvents(map, 0, events, 4) == 1 && events[0].action == 0);
+		TEST_CHECK(SmEvdevActionMapGetEvents(map, 1, events, 4) == 0);
+
+		SmEvdevActionMapDestroy(map);
+		SmEvdevDestroy(input);
+	}
+
+}
+
+int main()
+{
+	TestKeyboardAndMouse();
+	TestGamepad();
+	TestHotplug();
+	TestDropped();
+	TestActionMap();
+	return SharpMedia::Test::Result("EvdevInputTest");
+}
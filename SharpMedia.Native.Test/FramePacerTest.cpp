@@ -0,0 +1,173 @@
+#include "Test.h"
+#include "FramePacer.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	// Simulated clock; sleeps oversleep by a fixed amount, yields advance time slightly.
+	class SimulatedClock : public PacingClock
+	{
+	public:
+		double time;
+		double oversleep;
+		unsigned int sleeps;
+
+		SimulatedClock(double oversleep = 0.002) : time(0.0), oversleep(oversleep), sleeps(0) {}
+
+		virtual double Now() { return time; }
+
+		virtual void Sleep(double seconds)
+		{
+			time += seconds > 0.0 ? seconds + oversleep : 0.00001;
+			sleeps++;
+		}
+	};
+
+	// Simulated GPU that runs frames one after another, each taking a fixed time.
+	class SimulatedGpu : public PacingFence
+	{
+		SimulatedClock* clock;
+		std::vector<double> done;
+	public:
+		double frameTime;
+		double busyUntil;
+
+		SimulatedGpu(SimulatedClock* clock, double frameTime)
+			: clock(clock), done(8, 0.0), frameTime(frameTime), busyUntil(0.0) {}
+
+		virtual void Issue(unsigned int slot)
+		{
+			busyUntil = std::max(busyUntil, clock->time) + frameTime;
+			done[slot] = busyUntil;
+		}
+
+		virtual bool IsDone(unsigned int slot) { return clock->time >= done[slot]; }
+
+		// Seconds of GPU work queued ahead of CPU.
+		double Queued() const { return busyUntil - clock->time; }
+	};
+
+	FramePacerSettings Settings(unsigned int syncInterval, unsigned int maxFramesInFlight, double targetFrameTime)
+	{
+		FramePacerSettings settings = { syncInterval, maxFramesInFlight, targetFrameTime };
+		return settings;
+	}
+
+	// Runs frames of given CPU time.
+	void Run(FramePacer& pacer, SimulatedClock& clock, unsigned int frames, double cpuTime)
+	{
+		for(unsigned int i = 0; i < frames; i++)
+		{
+			clock.time += cpuTime;
+			pacer.EndFrame();
+			pacer.BeginFrame();
+		}
+	}
+
+	// GPU bound: frames run at GPU speed and CPU is never more than the limit ahead.
+	void TestGpuBound()
+	{
+		SimulatedClock clock;
+		SimulatedGpu gpu(&clock, 0.020);
+		FramePacer pacer(&clock, &gpu, Settings(0, 2, 0.0));
+
+		pacer.BeginFrame();
+		for(unsigned int i = 0; i < 50; i++)
+		{
+			Run(pacer, clock, 1, 0.005);
+			TEST_CHECK(gpu.Queued() <= 2 * 0.020 + 1e-9);
+		}
+
+		const FramePacerStats& stats = pacer.GetStats();
+		TEST_NEAR(stats.averageFrameTime, 0.020, 0.001);
+		TEST_NEAR(stats.gpuTime, 0.020, 0.001);
+		TEST_NEAR(stats.cpuTime, 0.005, 1e-9);
+		TEST_CHECK(stats.waitTime > 0.010);
+		TEST_CHECK(stats.frames == 50);
+	}
+
+	// CPU bound with a target: frames keep target rate despite the clock oversleeping.
+	void TestTargetFrameTime()
+	{
+		SimulatedClock clock;
+		SimulatedGpu gpu(&clock, 0.002);
+		FramePacer pacer(&clock, &gpu, Settings(0, 2, 1.0 / 60.0));
+
+		pacer.BeginFrame();
+		double start = clock.time;
+		Run(pacer, clock, 120, 0.005);
+
+		const FramePacerStats& stats = pacer.GetStats();
+		TEST_NEAR((clock.time - start) / 120.0, 1.0 / 60.0, 0.0005);
+		TEST_NEAR(stats.sleepOvershoot, 0.002, 0.0005);
+		TEST_CHECK(stats.waitTime == 0.0);
+	}
+
+	// A frame late by more than a whole frame does not make following frames catch up.
+	void TestHitch()
+	{
+		SimulatedClock clock;
+		SimulatedGpu gpu(&clock, 0.002);
+		FramePacer pacer(&clock, &gpu, Settings(0, 2, 1.0 / 60.0));
+
+		pacer.BeginFrame();
+		Run(pacer, clock, 30, 0.005);
+		Run(pacer, clock, 1, 0.1);
+
+		double begin = clock.time;
+		Run(pacer, clock, 1, 0.001);
+		TEST_CHECK(clock.time - begin > 1.0 / 60.0 - 0.0005);
+	}
+
+	// Without target or GPU limit, pacing adds no sleeps.
+	void TestUnlimited()
+	{
+		SimulatedClock clock;
+		SimulatedGpu gpu(&clock, 0.001);
+		FramePacer pacer(&clock, &gpu, Settings(0, 3, 0.0));
+
+		pacer.BeginFrame();
+		Run(pacer, clock, 100, 0.004);
+		TEST_CHECK(clock.sleeps == 0);
+		TEST_NEAR(pacer.GetStats().averageFrameTime, 0.004, 1e-6);
+		TEST_CHECK(pacer.GetStats().sleepTime == 0.0);
+	}
+
+	// Lowering frames in flight to one drains the queue, then CPU and GPU do not overlap.
+	void TestSettingsChange()
+	{
+		SimulatedClock clock;
+		SimulatedGpu gpu(&clock, 0.020);
+		FramePacer pacer(&clock, &gpu, Settings(0, 3, 0.0));
+
+		pacer.BeginFrame();
+		Run(pacer, clock, 10, 0.005);
+		TEST_CHECK(gpu.Queued() > 0.020);
+
+		pacer.SetSettings(Settings(9, 1, -1.0));
+		TEST_CHECK(pacer.GetSettings().syncInterval == 4);
+		TEST_CHECK(pacer.GetSettings().maxFramesInFlight == 1);
+		TEST_CHECK(pacer.GetSettings().targetFrameTime == 0.0);
+
+		for(unsigned int i = 0; i < 5; i++)
+		{
+			Run(pacer, clock, 1, 0.005);
+			TEST_CHECK(gpu.Queued() <= 1e-9);
+		}
+	}
+
+}
+
+int main()
+{
+	TestGpuBound();
+	TestTargetFrameTime();
+	TestHitch();
+	TestUnlimited();
+	TestSettingsChange();
+	return SharpMedia::Test::Result("FramePacerTest");
+}
@@ -0,0 +1,211 @@
+#include "Test.h"
+#include "GpuProfiler.h"
+#include <cstring>
+#include <map>
+#include <sstream>
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	// Stand-in queries: GPU clock advances 100 ticks per query end, results are ready a number
+	// of frames after the query ended.
+	class FakeQueries : public GpuQueryBackend
+	{
+		struct Query
+		{
+			GpuQueryType type;
+			unsigned long long value;
+			unsigned int readyFrame;
+		};
+
+		std::map<unsigned int, Query> queries;
+		unsigned int next;
+	public:
+		unsigned long long clock;
+		unsigned int frame;
+		unsigned int latency;
+		bool disjoint;
+		unsigned int reads;			//< GetData calls.
+
+		FakeQueries() : next(1), clock(1000), frame(0), latency(2), disjoint(false), reads(0) {}
+
+		unsigned int Count() const { return (unsigned int)queries.size(); }
+
+		virtual unsigned int Create(GpuQueryType type)
+		{
+			Query query = { type, 0, 0 };
+			queries[next] = query;
+			return next++;
+		}
+
+		virtual void Destroy(unsigned int query) { queries.erase(query); }
+
+		virtual void Begin(unsigned int query) { queries[query].value = clock; }
+
+		virtual void End(unsigned int query)
+		{
+			Query& q = queries[query];
+			clock += 100;
+			q.value = q.type == GpuQueryTimestamp ? clock : clock - q.value;
+			q.readyFrame = frame + latency;
+		}
+
+		virtual bool GetData(unsigned int query, void* data, unsigned int size)
+		{
+			reads++;
+			const Query& q = queries[query];
+			if(frame < q.readyFrame) return false;
+
+			if(q.type == GpuQueryDisjoint)
+			{
+				GpuDisjointData result = { 1000000, disjoint ? 1 : 0 };
+				memcpy(data, &result, size);
+			} else if(q.type == GpuQueryPipelineStatistics) {
+				GpuPipelineStatistics result;
+				memset(&result, 0, sizeof(result));
+				result.iaPrimitives = q.value;
+				memcpy(data, &result, size);
+			} else {
+				memcpy(data, &q.value, size);
+			}
+			return true;
+		}
+	};
+
+	void Frame(GpuProfiler& profiler, FakeQueries& queries, unsigned int frame)
+	{
+		queries.frame = frame;
+		profiler.BeginFrame();
+		{
+			GpuProfileScope shadows(profiler, "Shadows", GpuScopeStatistics);
+			GpuProfileScope cascade(profiler, "Cascade \"0\"", GpuScopeOcclusion);
+		}
+		profiler.BeginScope("Main");
+		profiler.EndScope();
+		profiler.EndFrame();
+	}
+
+	// Nested scopes keep depth and parent; times are relative to frame start.
+	void TestScopeTree()
+	{
+		FakeQueries queries;
+		GpuProfiler profiler(&queries, 3);
+		Frame(profiler, queries, 0);
+		queries.frame = 10;
+		profiler.Update();
+
+		const GpuFrameResult* frame = profiler.GetLastFrame();
+		TEST_CHECK(frame != 0);
+		if(!frame) return;
+
+		TEST_CHECK(frame->scopes.size() == 3);
+		TEST_CHECK(frame->scopes[0].name == "Shadows");
+		TEST_CHECK(frame->scopes[0].depth == 0 && frame->scopes[0].parent == -1);
+		TEST_CHECK(frame->scopes[1].depth == 1 && frame->scopes[1].parent == 0);
+		TEST_CHECK(frame->scopes[2].depth == 0 && frame->scopes[2].parent == -1);
+		TEST_CHECK(frame->scopes[0].hasStatistics && !frame->scopes[0].hasOcclusion);
+		TEST_CHECK(frame->scopes[1].hasOcclusion && !frame->scopes[1].hasStatistics);
+
+		// Child is within parent, scopes are within frame.
+		TEST_CHECK(frame->scopes[1].begin >= frame->scopes[0].begin);
+		TEST_CHECK(frame->scopes[1].end <= frame->scopes[0].end);
+		TEST_CHECK(frame->scopes[2].begin >= frame->scopes[0].end);
+		TEST_CHECK(frame->scopes[2].end <= frame->duration);
+		TEST_CHECK(frame->scopes[0].statistics.iaPrimitives > 0);
+	}
+
+	// Results come back only when ready, in frame order, and reading never waits.
+	void TestLatency()
+	{
+		FakeQueries queries;
+		GpuProfiler profiler(&queries, 3);
+
+		for(unsigned int f = 0; f < 2; f++) Frame(profiler, queries, f);
+		profiler.Update();
+		TEST_CHECK(profiler.GetHistory().empty());
+
+		// Frame 0 ready at frame 2.
+		Frame(profiler, queries, 2);
+		TEST_CHECK(profiler.GetHistory().size() == 1);
+		TEST_CHECK(profiler.GetHistory().back().frame == 0);
+
+		for(unsigned int f = 3; f < 10; f++) Frame(profiler, queries, f);
+		queries.frame = 100;
+		profiler.Update();
+		TEST_CHECK(profiler.GetHistory().size() == 10);
+		TEST_CHECK(profiler.GetDroppedFrames() == 0);
+		for(unsigned int i = 0; i < profiler.GetHistory().size(); i++)
+		{
+			TEST_CHECK(profiler.GetHistory()[i].frame == i);
+		}
+	}
+
+	// Queries are reused through the ring, not created every frame.
+	void TestQueryReuse()
+	{
+		FakeQueries queries;
+		GpuProfiler profiler(&queries, 3);
+		for(unsigned int f = 0; f < 3; f++) Frame(profiler, queries, f);
+		unsigned int created = queries.Count();
+		for(unsigned int f = 3; f < 30; f++) Frame(profiler, queries, f);
+		TEST_CHECK(queries.Count() == created);
+	}
+
+	// A slot needed again before its results arrived drops that frame; disjoint frames drop too.
+	void TestDropped()
+	{
+		FakeQueries queries;
+		queries.latency = 5;
+		GpuProfiler profiler(&queries, 3);
+		for(unsigned int f = 0; f < 4; f++) Frame(profiler, queries, f);
+		TEST_CHECK(profiler.GetDroppedFrames() == 1);
+
+		queries.frame = 100;
+		profiler.Update();
+		TEST_CHECK(profiler.GetHistory().size() == 3);
+		TEST_CHECK(profiler.GetHistory().front().frame == 1);
+
+		FakeQueries unreliable;
+		unreliable.disjoint = true;
+		GpuProfiler disjoint(&unreliable, 3);
+		Frame(disjoint, unreliable, 0);
+		unreliable.frame = 100;
+		disjoint.Update();
+		TEST_CHECK(disjoint.GetHistory().empty());
+		TEST_CHECK(disjoint.GetDroppedFrames() == 1);
+	}
+
+	// History is bounded and exports as Chrome trace with escaped names.
+	void TestChromeTrace()
+	{
+		FakeQueries queries;
+		GpuProfiler profiler(&queries, 3, 4);
+		for(unsigned int f = 0; f < 8; f++) Frame(profiler, queries, f);
+		queries.frame = 100;
+		profiler.Update();
+		TEST_CHECK(profiler.GetHistory().size() == 4);
+
+		std::ostringstream stream;
+		profiler.WriteChromeTrace(stream);
+		std::string trace = stream.str();
+		TEST_CHECK(trace.find("{\"traceEvents\":[") == 0);
+		TEST_CHECK(trace.find("\"name\":\"Frame 7\"") != std::string::npos);
+		TEST_CHECK(trace.find("\"name\":\"Frame 3\"") == std::string::npos);
+		TEST_CHECK(trace.find("Cascade \\\"0\\\"") != std::string::npos);
+		TEST_CHECK(trace.find("\"IAPrimitives\":") != std::string::npos);
+		TEST_CHECK(trace.find("\"Samples\":") != std::string::npos);
+		TEST_CHECK(trace.rfind("]}") != std::string::npos);
+	}
+
+}
+
+int main()
+{
+	TestScopeTree();
+	TestLatency();
+	TestQueryReuse();
+	TestDropped();
+	TestChromeTrace();
+	return SharpMedia::Test::Result("GpuProfilerTest");
+}
@@ -0,0 +1,173 @@
+#include "Test.h"
+#include "InputEventRing.h"
+#include <thread>
+#include <vector>
+
+using namespace SharpMedia::Input::Driver::Portable;
+
+namespace {
+
+	InputRecord Record(unsigned int time, InputRecordType type, unsigned short id, int value)
+	{
+		InputRecord record = { time, time, (unsigned short)type, id, value };
+		return record;
+	}
+
+	// Synthetic mouse: moves every millisecond and clicks button 0 every 7 ms, press and
+	// release one millisecond apart, as buffered reads return them.
+	class SyntheticMouse
+	{
+		unsigned int time;
+	public:
+		int totalX, totalY;
+		unsigned int clicks;
+
+		SyntheticMouse() : time(0), totalX(0), totalY(0), clicks(0) {}
+
+		// Records of one device read covering given milliseconds.
+		void Read(InputCoalescer& coalescer, unsigned int milliseconds)
+		{
+			for(unsigned int i = 0; i < milliseconds; i++, time++)
+			{
+				int dx = (int)(time % 5) - 2, dy = 1;
+				coalescer.Add(Record(time, InputRecordAxis, 0, dx));
+				coalescer.Add(Record(time, InputRecordAxis, 1, dy));
+				totalX += dx;
+				totalY += dy;
+
+				if(time % 7 == 0) coalescer.Add(Record(time, InputRecordButton, 0, 1));
+				if(time % 7 == 1)
+				{
+					coalescer.Add(Record(time, InputRecordButton, 0, 0));
+					clicks++;
+				}
+			}
+		}
+	};
+
+	// Records come out oldest first; full ring counts overflows instead of overwriting.
+	void TestOrderAndOverflow()
+	{
+		InputEventRing ring(5);
+		TEST_CHECK(ring.GetCapacity() == 8);
+
+		for(unsigned int i = 0; i < 10; i++) ring.Push(Record(i, InputRecordButton, 0, (int)i));
+		TEST_CHECK(ring.GetCount() == 8);
+		TEST_CHECK(ring.GetOverflows() == 2);
+
+		InputRecord records[8];
+		TEST_CHECK(ring.Pop(records, 3) == 3);
+		TEST_CHECK(records[0].value == 0 && records[2].value == 2);
+
+		// Wraps around end of storage.
+		for(unsigned int i = 10; i < 13; i++) TEST_CHECK(ring.Push(Record(i, InputRecordButton, 0, (int)i)));
+		TEST_CHECK(ring.Pop(records, 8) == 8);
+		TEST_CHECK(records[0].value == 3 && records[4].value == 7 && records[5].value == 10);
+		TEST_CHECK(ring.Pop(records, 8) == 0);
+	}
+
+	// Motion between buttons merges per axis; button records split merging, so press and
+	// release within one read keep their order and the motion around them.
+	void TestCoalescing()
+	{
+		InputEventRing ring(16);
+		InputCoalescer coalescer;
+		coalescer.Add(Record(1, InputRecordAxis, 0, 5));
+		coalescer.Add(Record(1, InputRecordAxis, 1, 2));
+		coalescer.Add(Record(2, InputRecordAxis, 0, 3));
+		coalescer.Add(Record(3, InputRecordButton, 0, 1));
+		coalescer.Add(Record(3, InputRecordButton, 0, 0));
+		coalescer.Add(Record(4, InputRecordAxis, 0, 7));
+		TEST_CHECK(coalescer.GetPendingCount() == 5);
+		TEST_CHECK(coalescer.Flush(ring) == 0);
+		TEST_CHECK(coalescer.GetPendingCount() == 0);
+
+		InputRecord records[16];
+		TEST_CHECK(ring.Pop(records, 16) == 5);
+		TEST_CHECK(records[0].id == 0 && records[0].value == 8 && records[0].time == 2);
+		TEST_CHECK(records[1].id == 1 && records[1].value == 2);
+		TEST_CHECK(records[2].type == InputRecordButton && records[2].value == 1);
+		TEST_CHECK(records[3].type == InputRecordButton && records[3].value == 0);
+		TEST_CHECK(records[4].value == 7 && records[4].time == 4);
+
+		// Disabled coalescer keeps every record.
+		InputCoalescer raw(false);
+		raw.Add(Record(1, InputRecordAxis, 0, 1));
+		raw.Add(Record(2, InputRecordAxis, 0, 1));
+		TEST_CHECK(raw.GetPendingCount() == 2);
+
+		// Records that do not fit are reported.
+		InputEventRing small(2);
+		for(unsigned int i = 0; i < 5; i++) raw.Add(Record(i, InputRecordButton, 0, 1));
+		TEST_CHECK(raw.Flush(small) == 5);
+		TEST_CHECK(small.GetOverflows() == 5);
+	}
+
+	// Device thread reads synthetic mouse while game loop drains ring at frame rate: no click
+	// is lost, motion sums up and timestamps never go back.
+	void TestProducerConsumer()
+	{
+		const unsigned int Reads = 2000;
+		InputEventRing ring(256);
+		SyntheticMouse mouse;
+		volatile bool done = false;
+
+		std::thread producer([&]()
+		{
+			InputCoalescer coalescer;
+			for(unsigned int i = 0; i < Reads; i++)
+			{
+				mouse.Read(coalescer, 3);
+				while(coalescer.GetPendingCount() > 256 - ring.GetCount()) std::this_thread::yield();
+				coalescer.Flush(ring);
+			}
+			done = true;
+		});
+
+		int x = 0, y = 0;
+		unsigned int presses = 0, releases = 0, lastTime = 0;
+		bool ordered = true, pressed = false, alternating = true;
+		InputRecord records[64];
+		for(;;)
+		{
+			bool finished = done;
+			unsigned int count;
+			while((count = ring.Pop(records, 64)) > 0)
+			{
+				for(unsigned int i = 0; i < count; i++)
+				{
+					if(records[i].time < lastTime) ordered = false;
+					lastTime = records[i].time;
+
+					if(records[i].type == InputRecordAxis)
+					{
+						(records[i].id == 0 ? x : y) += records[i].value;
+					} else {
+						if((records[i].value != 0) == pressed) alternating = false;
+						pressed = records[i].value != 0;
+						(pressed ? presses : releases)++;
+					}
+				}
+			}
+			if(finished) break;
+			std::this_thread::yield();
+		}
+		producer.join();
+
+		TEST_CHECK(ordered);
+		TEST_CHECK(alternating);
+		TEST_CHECK(ring.GetOverflows() == 0);
+		TEST_CHECK(releases == mouse.clicks);
+		TEST_CHECK(presses == releases || presses == releases + 1);
+		TEST_CHECK(x == mouse.totalX && y == mouse.totalY);
+	}
+
+}
+
+int main()
+{
+	TestOrderAndOverflow();
+	TestCoalescing();
+	TestProducerConsumer();
+	return SharpMedia::Test::Result("InputEventRingTest");
+}
@@ -0,0 +1,286 @@
+#include "Test.h"
+#include "InputPoller.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+using namespace SharpMedia::Input::Driver::Portable;
+
+namespace {
+
+	class SteadyClock : public PollerClock
+	{
+	public:
+		virtual double Now()
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		virtual void SleepUntil(double time)
+		{
+			while(Now() < time) std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+	};
+
+	class SimulatedClock : public PollerClock
+	{
+	public:
+		double time;
+
+		SimulatedClock() : time(0.0) {}
+
+		virtual double Now() { return time; }
+		virtual void SleepUntil(double t) { if(t > time) time = t; }
+	};
+
+	// Simulated device whose state is consistent only when copied whole: every axis is a
+	// multiple of first one and every button is its low byte.
+	class SimulatedMouse : public InputSource
+	{
+	public:
+		volatile long long samples;
+		volatile bool removed;			//< Set by test after source was removed.
+		volatile bool usedAfterRemove;
+		bool fail;
+
+		SimulatedMouse() : samples(0), removed(false), usedAfterRemove(false), fail(false) {}
+
+		virtual bool Sample(InputDeviceState& state)
+		{
+			if(removed) usedAfterRemove = true;
+			if(fail) return false;
+
+			long long n = samples + 1;
+			for(unsigned int i = 0; i < InputMaxAxes; i++) state.axes[i] = n * (i + 1);
+			memset(state.buttons, (int)(n & 0xff), sizeof(state.buttons));
+			samples = n;
+			return true;
+		}
+	};
+
+	bool Consistent(const InputDeviceState* state)
+	{
+		for(unsigned int i = 0; i < InputMaxAxes; i++)
+		{
+			if(state->axes[i] != state->axes[0] * (long long)(i + 1)) return false;
+		}
+		for(unsigned int i = 0; i < InputMaxButtons; i++)
+		{
+			if(state->buttons[i] != (unsigned char)(state->axes[0] & 0xff)) return false;
+		}
+		return true;
+	}
+
+	// Without thread, steps publish states and reads record latency of fresh states only.
+	void TestSteps()
+	{
+		SimulatedClock clock;
+		InputPoller* poller = new InputPoller(&clock);
+		SimulatedMouse mouse;
+		int slot = poller->AddSource(&mouse);
+		TEST_CHECK(slot == 0);
+		TEST_CHECK(poller->Read(slot) == 0);
+
+		poller->Step();
+		clock.time = 0.002;
+		const InputDeviceState* state = poller->Read(slot);
+		TEST_CHECK(state && state->axes[0] == 1);
+
+		poller->Step();
+		poller->Step();
+		clock.time = 0.0025;
+		state = poller->Read(slot);
+		TEST_CHECK(state && state->axes[0] == 3);
+		state = poller->Read(slot);
+		TEST_CHECK(state && state->axes[0] == 3);
+		TEST_CHECK(poller->GetLatency().GetCount() == 2);
+		TEST_NEAR(poller->GetLatency().GetMax(), 0.002, 1e-9);
+
+		mouse.fail = true;
+		poller->Step();
+		TEST_CHECK(poller->GetStats().failures == 1);
+		mouse.fail = false;
+
+		poller->RemoveSource(slot);
+		poller->Step();
+		TEST_CHECK(mouse.samples == 3);
+		poller->Release();
+	}
+
+	// Histogram buckets are a quarter octave wide; percentiles are upper bounds of buckets.
+	void TestLatencyHistogram()
+	{
+		LatencyHistogram histogram;
+		for(unsigned int i = 0; i < 99; i++) histogram.Add(0.0001);
+		histogram.Add(0.01);
+
+		TEST_CHECK(histogram.GetCount() == 100);
+		TEST_CHECK(histogram.Percentile(0.5) >= 0.0001 && histogram.Percentile(0.5) <= 0.0001 * 1.2);
+		TEST_NEAR(histogram.Percentile(1.0), 0.01, 1e-12);
+		TEST_NEAR(histogram.GetAverage(), (99 * 0.0001 + 0.01) / 100.0, 1e-12);
+	}
+
+	// Reader on other thread always gets whole states, never older than last read.
+	void TestThreadedSnapshots()
+	{
+		SteadyClock clock;
+		InputPoller* poller = new InputPoller(&clock);
+		SimulatedMouse mouse;
+		int slot = poller->AddSource(&mouse);
+		TEST_CHECK(poller->Start(2000));
+
+		bool consistent = true, monotonic = true;
+		long long last = 0;
+		unsigned int reads = 0;
+		double end = clock.Now() + 0.3;
+		while(clock.Now() < end)
+		{
+			const InputDeviceState* state = poller->Read(slot);
+			if(!state) continue;
+			if(!Consistent(state)) consistent = false;
+			if(state->axes[0] < last) monotonic = false;
+			last = state->axes[0];
+			reads++;
+		}
+
+		TEST_CHECK(consistent && monotonic);
+		TEST_CHECK(reads > 0 && mouse.samples > 100);
+		TEST_CHECK(poller->GetLatency().GetCount() > 0);
+		poller->Stop();
+		poller->Release();
+	}
+
+	// At slow rate, removing a source and stopping return at once instead of after a period,
+	// and removed source is never sampled again.
+	void TestSlowRateRemoveAndStop()
+	{
+		SteadyClock clock;
+		InputPoller* poller = new InputPoller(&clock);
+		SimulatedMouse first, second;
+		int a = poller->AddSource(&first);
+		int b = poller->AddSource(&second);
+		TEST_CHECK(poller->Start(2));
+
+		while(first.samples == 0) std::this_thread::yield();
+
+		double begin = clock.Now();
+		poller->RemoveSource(a);
+		first.removed = true;
+		TEST_CHECK(clock.Now() - begin < 0.05);
+
+		// Slot is reused by new source while thread waits.
+		SimulatedMouse third;
+		TEST_CHECK(poller->AddSource(&third) == a);
+
+		begin = clock.Now();
+		poller->Stop();
+		TEST_CHECK(clock.Now() - begin < 0.05);
+		TEST_CHECK(!poller->IsRunning());
+		TEST_CHECK(!first.usedAfterRemove);
+
+		poller->RemoveSource(b);
+		poller->Release();
+	}
+
+	// Sources removed and added while thread samples fast are never used after removal.
+	void TestRemoveWhileSampling()
+	{
+		SteadyClock clock;
+		InputPoller* poller = new InputPoller(&clock);
+		TEST_CHECK(poller->Start(5000));
+
+		bool used = false;
+		for(unsigned int i = 0; i < 200; i++)
+		{
+			SimulatedMouse mouse;
+			int slot = poller->AddSource(&mouse);
+			while(mouse.samples == 0) std::this_thread::yield();
+			poller->RemoveSource(slot);
+			mouse.removed = true;
+			std::this_thread::yield();
+			if(mouse.usedAfterRemove) used = true;
+		}
+
+		TEST_CHECK(!used);
+		poller->Stop();
+		poller->Release();
+	}
+
+	// Throttled rates apply only when lower than rate.
+	void TestBackgroundRates()
+	{
+		SteadyClock clock;
+		InputPoller* poller = new InputPoller(&clock);
+		TEST_CHECK(poller->Start(500));
+		poller->SetBackgroundRates(60, 1000);
+
+		TEST_CHECK(poller->GetEffectiveRate() == 500);
+		poller->GetFocus().Set(InputFocusBackground);
+		TEST_CHECK(poller->GetEffectiveRate() == 60);
+		poller->GetFocus().Set(InputFocusMinimized);
+		TEST_CHECK(poller->GetEffectiveRate() == 500);
+
+		unsigned int gained = poller->GetFocus().GetGained();
+		poller->GetFocus().Set(InputFocusForeground);
+		TEST_CHECK(poller->GetFocus().GetGained() == gained + 1);
+		poller->Release();
+	}
+
+	// Thread samples at throttled rate in background and when minimized, and at full rate as
+	// soon as current period ends after focus comes back.
+	void TestThrottledSampling()
+	{
+		SteadyClock clock;
+		InputPoller* poller = new InputPoller(&clock);
+		SimulatedMouse mouse;
+		int slot = poller->AddSource(&mouse);
+		poller->SetBackgroundRates(30, 5);
+		TEST_CHECK(poller->Start(1000));
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		long long foreground = mouse.samples;
+
+		poller->GetFocus().Set(InputFocusBackground);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		long long start = mouse.samples;
+		std::this_thread::sleep_for(std::chrono::milliseconds(500));
+		long long background = mouse.samples - start;
+
+		poller->GetFocus().Set(InputFocusMinimized);
+		std::this_thread::sleep_for(std::chrono::milliseconds(40));
+		start = mouse.samples;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+		long long minimized = mouse.samples - start;
+
+		poller->GetFocus().Set(InputFocusForeground);
+		std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		start = mouse.samples;
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		long long restored = mouse.samples - start;
+
+		printf("samples: %lld in 200 ms foreground, %lld in 500 ms background, %lld in 1 s minimized, "
+			"%lld in 100 ms restored\n", foreground, background, minimized, restored);
+		TEST_CHECK(foreground > 100);
+		TEST_CHECK(background >= 10 && background <= 20);
+		TEST_CHECK(minimized >= 3 && minimized <= 7);
+		TEST_CHECK(restored > 50);
+
+		poller->Stop();
+		poller->RemoveSource(slot);
+		poller->Release();
+	}
+
+}
+
+int main()
+{
+	TestSteps();
+	TestLatencyHistogram();
+	TestThreadedSnapshots();
+	TestSlowRateRemoveAndStop();
+	TestRemoveWhileSampling();
+	TestBackgroundRates();
+	TestThrottledSampling();
+	return SharpMedia::Test::Result("InputPollerTest");
+}
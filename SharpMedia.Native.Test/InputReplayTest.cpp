@@ -0,0 +1,169 @@
+#include "Test.h"
+#include "InputReplay.h"
+
+using namespace SharpMedia::Input::Driver::Portable;
+
+namespace {
+
+	class SimulatedClock : public PollerClock
+	{
+	public:
+		double time;
+
+		SimulatedClock() : time(100.0) {}
+
+		virtual double Now() { return time; }
+		virtual void SleepUntil(double t) { if(t > time) time = t; }
+	};
+
+	const unsigned int Frames = 100;
+	const double Frame = 0.016;
+
+	// Keyboard and mouse over 100 frames: key 30 held from frame 10 to 20, key 200 from
+	// frame 15, mouse moves by frame number, saturates its wheel at frame 50 and reports two
+	// events every 10 frames.
+	void Record(InputLogWriter& writer)
+	{
+		InputLogDeviceInfo keyboard = { 2, 0, 256, 0 }, mouse = { 1, 0, 8, 3 };
+		int k = writer.AddDevice(keyboard), m = writer.AddDevice(mouse);
+
+		unsigned char keys[256] = { 0 }, buttons[8] = { 0 };
+		long long axes[3] = { 0, 0, 0 };
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			double time = f * Frame;
+			if(f == 10) keys[30] = 1;
+			if(f == 20) keys[30] = 0;
+			if(f == 15) keys[200] = 1;
+			writer.WriteState(k, time, keys, 0);
+
+			axes[0] += f;
+			axes[1] -= 2 * f;
+			if(f == 50) axes[2] = 0x7FFFFFFFFFFFFFFFLL;
+			if(f == 40) buttons[1] = 1;
+			writer.WriteState(m, time + 0.001, buttons, axes);
+
+			if(f % 10 == 0)
+			{
+				InputRecord records[2] = { { 1000u + f, 5u + f, 1, 0, (int)f }, { 1001u + f, 6u + f, 0, 1, 1 } };
+				writer.WriteEvents(m, time + 0.002, records, 2);
+			}
+		}
+	}
+
+	// Stepped: every read is next recorded frame of that device, independent of clock.
+	void TestStepped()
+	{
+		InputLogWriter writer;
+		Record(writer);
+		SimulatedClock clock;
+		InputReplaySession session(&clock, writer.GetData(), writer.GetSize());
+		TEST_CHECK(session.IsValid() && session.GetDeviceCount() == 2);
+		TEST_CHECK(session.FindDevice(1, 0) == 1 && session.FindDevice(3, 0) < 0);
+
+		// Unchanged keyboard is not recorded, so its reads are frames 0, 10, 15 and 20; press
+		// of frame 10 and release of frame 20 each last a read however many frames apart.
+		session.SetRealTime(false);
+		TEST_CHECK(session.ReadState(0).buttons[30] == 0);
+		TEST_CHECK(session.ReadState(0).buttons[30] == 1);
+		TEST_CHECK(session.ReadState(0).buttons[200] == 1);
+		TEST_CHECK(session.ReadState(0).buttons[30] == 0 && session.GetDeviceInfo(0).buttons == 256);
+
+		unsigned int reads = 0;
+		while(!session.IsFinished() && reads < 1000)
+		{
+			session.ReadState(1);
+			reads++;
+		}
+		const InputLogDeviceState& mouse = session.ReadState(1);
+		TEST_CHECK(reads <= Frames);
+		TEST_CHECK(mouse.axes[0] == (long long)(Frames * (Frames - 1) / 2));
+		TEST_CHECK(mouse.axes[2] == 0x7FFFFFFFFFFFFFFFLL && mouse.buttons[1] == 1);
+
+		InputRecord records[64];
+		unsigned int count = session.ReadEvents(1, records, 64);
+		TEST_CHECK(count == 20);
+		TEST_CHECK(records[2].time == 1010 && records[3].sequence == 16 && records[2].value == 10);
+		TEST_CHECK(session.ReadEvents(1, records, 64) == 0);
+	}
+
+	// Real time: log plays at recorded timing from construction, whatever the read rate.
+	void TestRealTime()
+	{
+		InputLogWriter writer;
+		Record(writer);
+		SimulatedClock clock;
+		InputReplaySession session(&clock, writer.GetData(), writer.GetSize());
+		TEST_CHECK(session.IsRealTime());
+
+		clock.time += 10 * Frame + 0.0005;
+		TEST_CHECK(session.ReadState(0).buttons[30] == 1);
+		TEST_CHECK(session.ReadState(1).axes[0] == 45);
+		TEST_CHECK(session.ReadState(1).axes[0] == 45);
+
+		clock.time += 0.001;
+		TEST_CHECK(session.ReadState(1).axes[0] == 55);
+
+		// Events up to now only.
+		InputRecord records[64];
+		TEST_CHECK(session.ReadEvents(1, records, 64) == 2);
+		clock.time += 0.001;
+		TEST_CHECK(session.ReadEvents(1, records, 64) == 2 && records[0].value == 10);
+
+		clock.time += 100.0;
+		session.ReadState(0);
+		TEST_CHECK(session.IsFinished());
+	}
+
+	// Switching modes continues from position of log, rewind starts over from now.
+	void TestModesAndRewind()
+	{
+		InputLogWriter writer;
+		Record(writer);
+		SimulatedClock clock;
+		InputReplaySession session(&clock, writer.GetData(), writer.GetSize());
+
+		session.SetRealTime(false);
+		for(unsigned int f = 0; f < 30; f++) session.ReadState(1);
+		long long stepped = session.ReadState(1).axes[0];
+		TEST_CHECK(stepped > 0);
+
+		clock.time += 1000.0;
+		session.SetRealTime(true);
+		TEST_CHECK(session.ReadState(1).axes[0] == stepped);
+		TEST_CHECK(!session.IsFinished());
+
+		session.Rewind();
+		TEST_CHECK(session.ReadState(1).axes[0] == 0 && session.ReadState(0).buttons[30] == 0);
+		clock.time += Frames * Frame;
+		session.ReadState(1);
+		TEST_CHECK(session.IsFinished());
+	}
+
+	// Truncated log plays what is complete; data that is not log is invalid and finished.
+	void TestDamaged()
+	{
+		InputLogWriter writer;
+		Record(writer);
+		SimulatedClock clock;
+
+		InputReplaySession truncated(&clock, writer.GetData(), writer.GetSize() - 3);
+		TEST_CHECK(truncated.IsValid());
+		truncated.SetRealTime(false);
+		for(unsigned int f = 0; f < 2 * Frames && !truncated.IsFinished(); f++) truncated.ReadState(1);
+		TEST_CHECK(truncated.IsFinished());
+
+		InputReplaySession invalid(&clock, (const unsigned char*)"XXXX", 4);
+		TEST_CHECK(!invalid.IsValid() && invalid.IsFinished() && invalid.GetDeviceCount() == 0);
+	}
+
+}
+
+int main()
+{
+	TestStepped();
+	TestRealTime();
+	TestModesAndRewind();
+	TestDamaged();
+	return SharpMedia::Test::Result("InputReplayTest");
+}
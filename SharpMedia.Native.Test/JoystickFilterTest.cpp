@@ -0,0 +1,177 @@
+#include "Test.h"
+#include "JoystickFilter.h"
+#include <cstring>
+
+using namespace SharpMedia::Input::Driver::Portable;
+
+namespace {
+
+	void Centered(JoystickRawState& raw)
+	{
+		memset(&raw, 0, sizeof(raw));
+		for(unsigned int i = 0; i < JoystickHats; i++) raw.hats[i] = 0xFFFFFFFF;
+	}
+
+	// Usages of axes in order of state; 0 for axes device does not have.
+	void Usages(unsigned short* usages, unsigned short x, unsigned short y, unsigned short z,
+				unsigned short rx, unsigned short ry, unsigned short rz)
+	{
+		usages[0] = x;
+		usages[1] = y;
+		usages[2] = z;
+		usages[3] = rx;
+		usages[4] = ry;
+		usages[5] = rz;
+		usages[6] = usages[7] = 0;
+	}
+
+	bool Paired(const JoystickLayout& layout, unsigned int a, unsigned int b)
+	{
+		return layout.kinds[a] == JoystickAxisStick && layout.kinds[b] == JoystickAxisStick &&
+			layout.pairs[a] == b && layout.pairs[b] == a;
+	}
+
+	// Normalization, radial deadzone of default layout and hats.
+	void TestFilter()
+	{
+		JoystickFilter filter;
+		JoystickRawState raw;
+		Centered(raw);
+		InputDeviceState state;
+		unsigned char changed[JoystickButtonCount];
+
+		TEST_CHECK(filter.Apply(raw, state, changed, JoystickButtonCount) == 0);
+		for(unsigned int i = 0; i < JoystickAxes; i++) TEST_CHECK(state.axes[i] >= -1 && state.axes[i] <= 1);
+
+		raw.axes[0] = 5000;
+		raw.axes[1] = -5000;
+		filter.Apply(raw, state, changed, JoystickButtonCount);
+		TEST_CHECK(state.axes[0] == 0 && state.axes[1] == 0);
+
+		raw.axes[0] = JoystickRangeMax;
+		raw.axes[1] = 0;
+		filter.Apply(raw, state, changed, JoystickButtonCount);
+		TEST_CHECK(state.axes[0] == JoystickAxisScale);
+		raw.axes[0] = JoystickRangeMin;
+		filter.Apply(raw, state, changed, JoystickButtonCount);
+		TEST_CHECK(state.axes[0] == -JoystickAxisScale);
+
+		// Diagonal keeps direction.
+		raw.axes[0] = raw.axes[1] = 20000;
+		filter.Apply(raw, state, changed, JoystickButtonCount);
+		TEST_CHECK(state.axes[0] == state.axes[1] && state.axes[0] > 0);
+
+		// Sliders have no deadzone.
+		raw.axes[6] = 1000;
+		filter.Apply(raw, state, changed, JoystickButtonCount);
+		TEST_CHECK(state.axes[6] > 0);
+
+		double x = 0.5, y = 0.0;
+		JoystickFilter::Deadzone(x, y, JoystickFilter::DefaultSettings());
+		TEST_NEAR(x, 0.26 / 0.76, 1e-9);
+
+		TEST_CHECK(JoystickFilter::HatDirections(0) == 1 && JoystickFilter::HatDirections(9000) == 2);
+		TEST_CHECK(JoystickFilter::HatDirections(31500) == 9 && JoystickFilter::HatDirections(0xFFFF) == 0);
+	}
+
+	// Buttons and hat directions are diffed between samples.
+	void TestButtons()
+	{
+		JoystickFilter filter;
+		JoystickRawState raw;
+		Centered(raw);
+		InputDeviceState state;
+		unsigned char changed[JoystickButtonCount];
+		filter.Apply(raw, state, changed, JoystickButtonCount);
+
+		raw.buttons[3] = 0x80;
+		raw.hats[0] = 4500;
+		unsigned int count = filter.Apply(raw, state, changed, JoystickButtonCount);
+		TEST_CHECK(count == 3 && changed[0] == 3 && changed[1] == JoystickButtons && changed[2] == JoystickButtons + 1);
+		TEST_CHECK(state.buttons[3] == 1 && state.buttons[JoystickButtons] == 1);
+		TEST_CHECK(filter.Apply(raw, state, changed, JoystickButtonCount) == 0);
+
+		raw.buttons[3] = 0;
+		count = filter.Apply(raw, state, changed, JoystickButtonCount);
+		TEST_CHECK(count == 1 && changed[0] == 3 && state.buttons[3] == 0);
+	}
+
+	// Sticks are paired by usages: Rx/Ry when present, Z/Rz on gamepads without them, never
+	// Z/Rz of flight sticks, where they are throttle and twist.
+	void TestLayout()
+	{
+		unsigned short usages[JoystickAxes];
+
+		// Gamepad of XInput: right stick on Rx/Ry, triggers on Z.
+		Usages(usages, JoystickUsageX, JoystickUsageY, JoystickUsageZ, JoystickUsageRx, JoystickUsageRy, 0);
+		JoystickLayout layout = JoystickFilter::Layout(JoystickUsageGamepad, usages);
+		TEST_CHECK(Paired(layout, 0, 1) && Paired(layout, 3, 4));
+		TEST_CHECK(layout.kinds[2] == JoystickAxisAbsolute && layout.kinds[5] == JoystickAxisAbsent);
+
+		// Generic gamepad with right stick on Z/Rz.
+		Usages(usages, JoystickUsageX, JoystickUsageY, JoystickUsageZ, 0, 0, JoystickUsageRz);
+		layout = JoystickFilter::Layout(JoystickUsageGamepad, usages);
+		TEST_CHECK(Paired(layout, 0, 1) && Paired(layout, 2, 5));
+
+		// Flight stick: throttle on Z, twist on Rz.
+		layout = JoystickFilter::Layout(JoystickUsageJoystick, usages);
+		TEST_CHECK(Paired(layout, 0, 1));
+		TEST_CHECK(layout.kinds[2] == JoystickAxisAbsolute && layout.kinds[5] == JoystickAxisCentered);
+
+		// Axes reported out of order still pair by usage.
+		Usages(usages, JoystickUsageY, JoystickUsageX, JoystickUsageRy, 0, JoystickUsageRx, 0);
+		layout = JoystickFilter::Layout(JoystickUsageGamepad, usages);
+		TEST_CHECK(Paired(layout, 0, 1) && Paired(layout, 2, 4));
+
+		// Lone X is a centered axis, like a wheel.
+		Usages(usages, JoystickUsageX, 0, 0, 0, 0, 0);
+		layout = JoystickFilter::Layout(0, usages);
+		TEST_CHECK(layout.kinds[0] == JoystickAxisCentered && layout.kinds[1] == JoystickAxisAbsent);
+	}
+
+	// Throttle of flight stick is not cut by deadzone and twist is not pulled toward it; on
+	// gamepad of Z/Rz the two form one stick.
+	void TestLayoutFilter()
+	{
+		unsigned short usages[JoystickAxes];
+		Usages(usages, JoystickUsageX, JoystickUsageY, JoystickUsageZ, 0, 0, JoystickUsageRz);
+
+		JoystickRawState raw;
+		Centered(raw);
+		raw.axes[2] = 3000;
+		raw.axes[5] = 20000;
+		InputDeviceState state;
+		unsigned char changed[JoystickButtonCount];
+
+		JoystickFilter flight;
+		flight.SetLayout(JoystickFilter::Layout(JoystickUsageJoystick, usages));
+		flight.Apply(raw, state, changed, JoystickButtonCount);
+		TEST_CHECK(state.axes[2] > 0);
+		double twist = JoystickFilter::Normalize(20000), zero = 0.0;
+		JoystickFilter::Deadzone(twist, zero, JoystickFilter::DefaultSettings());
+		TEST_NEAR((double)state.axes[5], twist * JoystickAxisScale, 1.0);
+
+		// Absent axes read as centered whatever device reports.
+		raw.axes[3] = 30000;
+		flight.Apply(raw, state, changed, JoystickButtonCount);
+		TEST_CHECK(state.axes[3] == 0);
+
+		JoystickFilter gamepad;
+		gamepad.SetLayout(JoystickFilter::Layout(JoystickUsageGamepad, usages));
+		gamepad.Apply(raw, state, changed, JoystickButtonCount);
+		double z = JoystickFilter::Normalize(3000), rz = JoystickFilter::Normalize(20000);
+		JoystickFilter::Deadzone(z, rz, JoystickFilter::DefaultSettings());
+		TEST_NEAR((double)state.axes[2], z * JoystickAxisScale, 1.0);
+		TEST_NEAR((double)state.axes[5], rz * JoystickAxisScale, 1.0);
+	}
+
+}
+
+int main()
+{
+	TestFilter();
+	TestButtons();
+	TestLayout();
+	TestLayoutFilter();
+	return SharpMedia::Test::Result("JoystickFilterTest");
+}
@@ -0,0 +1,140 @@
+#include "Test.h"
+#include "KeyBitset.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace SharpMedia::Input::Driver::Portable;
+
+namespace {
+
+	// Random DirectInput key states with up to four keys changed between two polls.
+	void RandomKeys(unsigned char* previous, unsigned char* current)
+	{
+		for(unsigned int i = 0; i < 256; i++)
+		{
+			previous[i] = current[i] = rand() % 4 == 0 ? 0x80 : (unsigned char)(rand() % 0x80);
+		}
+		int flips = rand() % 5;
+		for(int i = 0; i < flips; i++) current[rand() % 256] ^= 0x80;
+	}
+
+	// Bitset, diff and list agree with plain loops over key bytes.
+	void TestAgainstBytes()
+	{
+		srand(1);
+		unsigned int mismatches = 0;
+		for(unsigned int iteration = 0; iteration < 10000; iteration++)
+		{
+			unsigned char a[256], b[256];
+			RandomKeys(a, b);
+
+			KeyBitset previous, current;
+			KeyBitsetFromBytes(a, previous);
+			KeyBitsetFromBytes(b, current);
+			for(unsigned int i = 0; i < 256; i++)
+			{
+				if(previous.Get(i) != ((a[i] & 0x80) != 0)) mismatches++;
+			}
+
+			unsigned char changed[256];
+			unsigned int count = KeyBitsetDiff(previous, current, changed, 256), expected = 0;
+			for(unsigned int i = 0; i < 256; i++)
+			{
+				if(((a[i] ^ b[i]) & 0x80) == 0) continue;
+				if(expected >= count || changed[expected] != i) mismatches++;
+				expected++;
+			}
+			if(count != expected) mismatches++;
+
+			unsigned char keys[256];
+			count = KeyBitsetList(current, keys, 256);
+			expected = 0;
+			for(unsigned int i = 0; i < 256; i++)
+			{
+				if((b[i] & 0x80) == 0) continue;
+				if(expected >= count || keys[expected] != i) mismatches++;
+				expected++;
+			}
+			if(count != expected) mismatches++;
+		}
+		TEST_CHECK(mismatches == 0);
+	}
+
+	// Set and reset, last and first key, and truncation at max.
+	void TestEdges()
+	{
+		KeyBitset previous, current;
+		previous.Clear();
+		current.Clear();
+		current.Set(0);
+		current.Set(31);
+		current.Set(32);
+		current.Set(255);
+
+		unsigned char changed[4];
+		TEST_CHECK(KeyBitsetDiff(previous, current, changed, 4) == 4);
+		TEST_CHECK(changed[0] == 0 && changed[1] == 31 && changed[2] == 32 && changed[3] == 255);
+		TEST_CHECK(KeyBitsetDiff(previous, current, changed, 2) == 2);
+		TEST_CHECK(changed[1] == 31);
+
+		current.Reset(31);
+		TEST_CHECK(!current.Get(31) && current.Get(32));
+		TEST_CHECK(KeyBitsetDiff(current, current, changed, 4) == 0);
+	}
+
+	// Per poll cost of change-only delivery against mapping all 256 keys, as driver did
+	// before; typical poll changes no key, some change one.
+	void Benchmark()
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		const unsigned int Polls = 2000000;
+
+		unsigned char bytes[256] = { 0 };
+		bytes[30] = 0x80;
+		KeyBitset previous, current;
+		KeyBitsetFromBytes(bytes, previous);
+
+		unsigned char changed[256];
+		unsigned int transitions = 0;
+		Clock::time_point start = Clock::now();
+		for(unsigned int i = 0; i < Polls; i++)
+		{
+			if((i & 1023) == 0) bytes[i & 255] ^= 0x80;
+			KeyBitsetFromBytes(bytes, current);
+			transitions += KeyBitsetDiff(previous, current, changed, 256);
+			previous = current;
+		}
+		Clock::time_point diffed = Clock::now();
+
+		static const unsigned char Mapper[256] = { 0 };
+		bool state[256];
+		unsigned int pressed = 0;
+		for(unsigned int i = 0; i < Polls; i++)
+		{
+			if((i & 1023) == 0) bytes[i & 255] ^= 0x80;
+			for(unsigned int key = 0; key < 256; key++)
+			{
+				state[(key + Mapper[key]) & 255] = (bytes[key] & 0x80) != 0;
+			}
+			pressed += state[i & 255] ? 1 : 0;
+		}
+		Clock::time_point mapped = Clock::now();
+
+		double diffTime = std::chrono::duration<double, std::nano>(diffed - start).count() / Polls;
+		double mapTime = std::chrono::duration<double, std::nano>(mapped - diffed).count() / Polls;
+		printf("%u keyboard polls\n", Polls);
+		printf("  bitset diff: %.2f ns per poll (%u transitions)\n", diffTime, transitions);
+		printf("  map 256 keys: %.2f ns per poll (%u)\n", mapTime, pressed);
+		TEST_CHECK(transitions == Polls / 1024 + 1);
+	}
+
+}
+
+int main()
+{
+	TestAgainstBytes();
+	TestEdges();
+	Benchmark();
+	return SharpMedia::Test::Result("KeyBitsetTest");
+}
@@ -0,0 +1,141 @@
+#include "Test.h"
+#include "MouseAccumulator.h"
+
+using namespace SharpMedia::Input::Driver::Portable;
+
+namespace {
+
+	void Counts(int* counts, int x, int y, int wheel)
+	{
+		counts[0] = x;
+		counts[1] = y;
+		counts[2] = wheel;
+	}
+
+	// Without settings, counts are added as they are.
+	void TestDefault()
+	{
+		MouseAccumulator accumulator;
+		int counts[MouseAxes];
+		Counts(counts, 3, -2, 1);
+		accumulator.AddMotion(counts, 10);
+		TEST_CHECK(accumulator.GetAxis(0) == 3 && accumulator.GetAxis(1) == -2 && accumulator.GetAxis(2) == 1);
+	}
+
+	// High resolution mouse at low sensitivity: fractions are carried, not truncated, so
+	// one count deltas of a 16000 DPI mouse still move, and truncation is toward zero.
+	void TestSubUnit()
+	{
+		MouseAccumulator accumulator;
+		MouseSettings settings = MouseAccumulator::DefaultSettings();
+		settings.sensitivity = 1.0 / 16.0;
+		accumulator.SetSettings(settings);
+
+		int counts[MouseAxes];
+		Counts(counts, 1, -1, 0);
+		for(unsigned int i = 0; i < 15; i++) accumulator.AddMotion(counts, i);
+		TEST_CHECK(accumulator.GetAxis(0) == 0 && accumulator.GetAxis(1) == 0);
+
+		accumulator.AddMotion(counts, 15);
+		TEST_CHECK(accumulator.GetAxis(0) == 1 && accumulator.GetAxis(1) == -1);
+
+		// 16000 reports of 1 to 3 counts sum up exactly.
+		long long total = 0;
+		for(unsigned int i = 0; i < 16000; i++)
+		{
+			Counts(counts, 1 + (int)(i % 3), 0, 0);
+			total += counts[0];
+			accumulator.AddMotion(counts, 100 + i);
+		}
+		TEST_CHECK(accumulator.GetAxis(0) == 1 + total / 16);
+
+		// Reset drops fraction only.
+		accumulator.Reset();
+		TEST_CHECK(accumulator.GetAxis(0) == 1 + total / 16);
+	}
+
+	// Axes saturate instead of wrapping.
+	void TestSaturation()
+	{
+		const long long Max = 0x7FFFFFFFFFFFFFFFLL, Min = -Max - 1;
+		TEST_CHECK(MouseAccumulator::SaturatingAdd(Max - 15, 100) == Max);
+		TEST_CHECK(MouseAccumulator::SaturatingAdd(Min + 10, -100) == Min);
+		TEST_CHECK(MouseAccumulator::SaturatingAdd(5, -7) == -2);
+
+		MouseAccumulator accumulator;
+		MouseSettings settings = MouseAccumulator::DefaultSettings();
+		settings.sensitivity = 1.0e15;
+		accumulator.SetSettings(settings);
+
+		int counts[MouseAxes];
+		Counts(counts, 1000, -1000, 0);
+		for(unsigned int i = 0; i < 100; i++) accumulator.AddMotion(counts, i * 10);
+		TEST_CHECK(accumulator.GetAxis(0) == Max);
+		TEST_CHECK(accumulator.GetAxis(1) == Min);
+	}
+
+	// Gain rises with speed over threshold up to its bound; speed is of X and Y together.
+	void TestAcceleration()
+	{
+		MouseSettings settings = MouseAccumulator::DefaultSettings();
+		settings.accelThreshold = 1000.0;
+		settings.accelExponent = 1.0;
+		settings.accelMaxGain = 3.0;
+		TEST_CHECK(MouseAccumulator::Gain(settings, 500.0) == 1.0);
+		TEST_NEAR(MouseAccumulator::Gain(settings, 2000.0), 2.0, 1e-9);
+		TEST_CHECK(MouseAccumulator::Gain(settings, 9000.0) == 3.0);
+
+		MouseAccumulator accumulator;
+		accumulator.SetSettings(settings);
+		int counts[MouseAxes];
+		Counts(counts, 2, 0, 0);
+		accumulator.AddMotion(counts, 100);
+		accumulator.AddMotion(counts, 101);
+		TEST_CHECK(accumulator.GetAxis(0) == 2 + 4);
+
+		// Diagonal keeps direction.
+		MouseAccumulator diagonal;
+		diagonal.SetSettings(settings);
+		Counts(counts, 3, 3, 0);
+		diagonal.AddMotion(counts, 0);
+		diagonal.AddMotion(counts, 2);
+		TEST_CHECK(diagonal.GetAxis(0) == diagonal.GetAxis(1));
+		TEST_CHECK(diagonal.GetAxis(0) > 6);
+	}
+
+	// Smoothing spreads motion over steps without losing any; wheel is not smoothed, and
+	// turning smoothing off releases what was held.
+	void TestSmoothing()
+	{
+		MouseAccumulator accumulator;
+		MouseSettings settings = MouseAccumulator::DefaultSettings();
+		settings.smoothing = 0.5;
+		accumulator.SetSettings(settings);
+
+		int counts[MouseAxes];
+		Counts(counts, 100, -30, 5);
+		accumulator.AddMotion(counts, 0);
+		TEST_CHECK(accumulator.GetAxis(0) == 0 && accumulator.GetAxis(2) == 5);
+
+		accumulator.Step();
+		TEST_CHECK(accumulator.GetAxis(0) == 50 && accumulator.GetAxis(1) == -15);
+		for(unsigned int i = 0; i < 40; i++) accumulator.Step();
+		TEST_CHECK(accumulator.GetAxis(0) == 100 && accumulator.GetAxis(1) == -30);
+
+		accumulator.AddMotion(counts, 10);
+		settings.smoothing = 0.0;
+		accumulator.SetSettings(settings);
+		TEST_CHECK(accumulator.GetAxis(0) == 200 && accumulator.GetAxis(1) == -60);
+	}
+
+}
+
+int main()
+{
+	TestDefault();
+	TestSubUnit();
+	TestSaturation();
+	TestAcceleration();
+	TestSmoothing();
+	return SharpMedia::Test::Result("MouseAccumulatorTest");
+}
@@ -0,0 +1,188 @@
+#include "Test.h"
+#include "OcclusionCuller.h"
+#include <map>
+#include <vector>
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	// Stand-in device: results of predicates are ready a number of frames after End, proxies
+	// pass when their object is in the visible set.
+	class FakeDevice : public OcclusionDevice
+	{
+		struct Predicate
+		{
+			int result;
+			unsigned int readyFrame;
+		};
+
+		std::map<unsigned int, Predicate> predicates;
+		unsigned int next;
+		unsigned int current;		//< Predicate between Begin and End.
+		unsigned int drawn;			//< Object of last proxy.
+	public:
+		unsigned int frame;
+		unsigned int latency;
+		std::vector<bool> visible;
+		std::vector<bool> proxied;	//< Objects with a proxy, all if empty.
+		unsigned int predication;	//< Predicate set for draws, 0 if none.
+		unsigned int proxies;
+
+		FakeDevice() : next(1), current(0), drawn(0), frame(0), latency(2), predication(0), proxies(0) {}
+
+		virtual unsigned int CreatePredicate()
+		{
+			Predicate predicate = { -1, 0 };
+			predicates[next] = predicate;
+			return next++;
+		}
+
+		virtual void DestroyPredicate(unsigned int predicate) { predicates.erase(predicate); }
+		virtual void Begin(unsigned int predicate) { current = predicate; }
+
+		virtual void End(unsigned int predicate)
+		{
+			Predicate& p = predicates[predicate];
+			p.result = visible[drawn] ? 1 : 0;
+			p.readyFrame = frame + latency;
+			current = 0;
+		}
+
+		virtual int GetResult(unsigned int predicate)
+		{
+			const Predicate& p = predicates[predicate];
+			return frame < p.readyFrame ? -1 : p.result;
+		}
+
+		virtual bool HasProxy(unsigned int object) const { return proxied.empty() || proxied[object]; }
+
+		virtual void DrawProxy(unsigned int object)
+		{
+			TEST_CHECK(current != 0);
+			drawn = object;
+			proxies++;
+		}
+
+		virtual void SetPredication(unsigned int predicate) { predication = predicate; }
+	};
+
+	// Draws all objects of a frame; returns how many were predicated.
+	unsigned int Frame(OcclusionCuller& culler, FakeDevice& device, unsigned int count, bool issue = true)
+	{
+		culler.BeginFrame();
+		if(issue) culler.IssueTests();
+
+		unsigned int predicated = 0;
+		for(unsigned int id = 0; id < count; id++)
+		{
+			TEST_CHECK(culler.BeginDraw(id));
+			if(device.predication) predicated++;
+			culler.EndDraw();
+			TEST_CHECK(device.predication == 0);
+		}
+		culler.EndFrame();
+		device.frame++;
+		return predicated;
+	}
+
+	// Hidden object stays predicated, never culled, while its test is in flight over several frames.
+	void TestPendingHidden()
+	{
+		FakeDevice device;
+		device.latency = 3;
+		device.visible.assign(2, false);
+		device.visible[0] = true;
+
+		OcclusionCuller culler(&device, 1);
+		culler.Add();
+		culler.Add();
+
+		// Objects start visible until first results arrive.
+		for(unsigned int f = 0; f < 3; f++) TEST_CHECK(Frame(culler, device, 2) == 0);
+
+		// Retested on resolve, then drawn predicated in every frame the new test is pending.
+		for(unsigned int f = 0; f < 6; f++)
+		{
+			TEST_CHECK(Frame(culler, device, 2) == 1);
+			TEST_CHECK(culler.IsVisible(0) && !culler.IsVisible(1));
+			TEST_CHECK(culler.GetStats().predicated == 1);
+			TEST_CHECK(culler.GetStats().conservative == 0);
+		}
+
+		// Becomes visible again once a test shows it.
+		device.visible[1] = true;
+		for(unsigned int f = 0; f < 4; f++) Frame(culler, device, 2);
+		TEST_CHECK(culler.IsVisible(1));
+	}
+
+	// Without tests, hidden objects are drawn unconditionally.
+	void TestConservative()
+	{
+		FakeDevice device;
+		device.latency = 1;
+		device.visible.assign(1, false);
+
+		OcclusionCuller culler(&device, 1);
+		culler.Add();
+		Frame(culler, device, 1);
+		Frame(culler, device, 1, false);
+		TEST_CHECK(!culler.IsVisible(0));
+
+		TEST_CHECK(Frame(culler, device, 1, false) == 0);
+		TEST_CHECK(culler.GetStats().conservative == 1);
+		TEST_CHECK(!culler.BeginDraw(5));
+	}
+
+	// Objects without proxy are never tested nor predicated, even when hidden ones are.
+	void TestNoProxy()
+	{
+		FakeDevice device;
+		device.latency = 1;
+		device.visible.assign(2, false);
+		device.proxied.assign(2, true);
+		device.proxied[1] = false;
+
+		OcclusionCuller culler(&device, 1);
+		culler.Add();
+		culler.Add();
+
+		for(unsigned int f = 0; f < 6; f++) Frame(culler, device, 2);
+		TEST_CHECK(!culler.IsVisible(0));
+		TEST_CHECK(culler.IsVisible(1));
+		TEST_CHECK(device.proxies == 6);
+		TEST_CHECK(culler.GetStats().predicated == 1);
+		TEST_CHECK(culler.GetStats().visible == 1);
+	}
+
+	// Visible objects are retested every interval frames, staggered by id.
+	void TestStagger()
+	{
+		const unsigned int Count = 64, Interval = 4;
+		FakeDevice device;
+		device.latency = 1;
+		device.visible.assign(Count, true);
+
+		OcclusionCuller culler(&device, Interval);
+		for(unsigned int i = 0; i < Count; i++) culler.Add();
+
+		Frame(culler, device, Count);
+		unsigned int before = device.proxies;
+		for(unsigned int f = 0; f < 8 * Interval; f++)
+		{
+			Frame(culler, device, Count);
+			TEST_CHECK(culler.GetStats().tested <= Count / Interval);
+		}
+		TEST_CHECK(device.proxies - before == 8 * Count);
+	}
+
+}
+
+int main()
+{
+	TestPendingHidden();
+	TestConservative();
+	TestNoProxy();
+	TestStagger();
+	return SharpMedia::Test::Result("OcclusionCullerTest");
+}
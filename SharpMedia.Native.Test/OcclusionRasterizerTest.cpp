@@ -0,0 +1,227 @@
+#include "Test.h"
+#include "OcclusionRasterizer.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	const float Identity[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 };
+
+	// Quad of two triangles covering clip rectangle at depth z.
+	void AddQuad(OcclusionRasterizer& rasterizer, float x0, float y0, float x1, float y1, float z,
+		const float* matrix = Identity)
+	{
+		float vertices[12] = { x0, y0, z,  x1, y0, z,  x1, y1, z,  x0, y1, z };
+		unsigned int indices[6] = { 0, 1, 2,  0, 2, 3 };
+		rasterizer.AddOccluder(vertices, 4, indices, 6, matrix);
+	}
+
+	unsigned int Uncovered(const OcclusionRasterizer& rasterizer)
+	{
+		unsigned int count = 0;
+		const float* depth = rasterizer.GetDepth();
+		for(unsigned int i = 0; i < rasterizer.GetWidth() * rasterizer.GetHeight(); i++)
+		{
+			if(depth[i] == 1.0f) count++;
+		}
+		return count;
+	}
+
+	// Pixel centres on the shared diagonal belong to one of the triangles, so a full screen
+	// quad leaves no holes and hides what is behind it.
+	void TestFullScreenQuad()
+	{
+		OcclusionRasterizer rasterizer(256, 256);
+		AddQuad(rasterizer, -1.0f, -1.0f, 1.0f, 1.0f, 0.5f);
+		rasterizer.Rasterize();
+
+		TEST_CHECK(Uncovered(rasterizer) == 0);
+
+		float min[3] = { -0.5f, -0.5f, 0.7f }, max[3] = { 0.5f, 0.5f, 0.8f };
+		TEST_CHECK(!rasterizer.TestBox(min, max, Identity));
+
+		float front[3] = { -0.5f, -0.5f, 0.2f };
+		TEST_CHECK(rasterizer.TestBox(front, max, Identity));
+	}
+
+	// Adjacent quads neither leave gaps nor cover a pixel twice at shared edges.
+	void TestSharedEdges()
+	{
+		OcclusionRasterizer rasterizer(64, 64);
+		for(unsigned int i = 0; i < 4; i++)
+		{
+			for(unsigned int j = 0; j < 4; j++)
+			{
+				float x = -1.0f + i * 0.5f, y = -1.0f + j * 0.5f;
+				AddQuad(rasterizer, x, y, x + 0.5f, y + 0.5f, 0.25f + 0.125f * ((i + j) % 2));
+			}
+		}
+		rasterizer.Rasterize();
+		TEST_CHECK(Uncovered(rasterizer) == 0);
+
+		// Quad over left half only: pixel columns 0..31 covered, 32.. not.
+		OcclusionRasterizer half(64, 64);
+		AddQuad(half, -1.0f, -1.0f, 0.0f, 1.0f, 0.5f);
+		half.Rasterize();
+		TEST_CHECK(Uncovered(half) == 32 * 64);
+		TEST_CHECK(half.GetDepth()[31] == 0.5f);
+		TEST_CHECK(half.GetDepth()[32] == 1.0f);
+	}
+
+	// Occluders crossing near plane, with vertices nearly on the eye plane after clipping, and
+	// boxes projecting far off screen, rasterize and test without overflowing to integers.
+	void TestHugeCoordinates()
+	{
+		// Perspective: w = view z, clip z = view z - 0.001 (near plane at 0.001).
+		const float Perspective[16] = { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 1,  0, 0, -0.001f, 0 };
+
+		OcclusionRasterizer rasterizer(128, 128);
+		float vertices[9] = { -1e6f, -1e6f, 0.0f,  1e6f, -1e6f, 0.0011f,  0.0f, 1e6f, 5.0f };
+		unsigned int indices[3] = { 0, 1, 2 };
+		rasterizer.AddOccluder(vertices, 3, indices, 3, Perspective);
+		AddQuad(rasterizer, -1e6f, -1e6f, 1e6f, 1e6f, 0.5f);
+		rasterizer.Rasterize();
+
+		float min[3] = { -1e9f, -1e9f, 0.002f }, max[3] = { 1e9f, 1e9f, 0.003f };
+		TEST_CHECK(rasterizer.TestBox(min, max, Perspective));
+
+		float behind[3] = { -1e20f, -1e20f, 0.9f }, far[3] = { 1e20f, 1e20f, 0.95f };
+		TEST_CHECK(!rasterizer.TestBox(behind, far, Identity));
+	}
+
+	// Scene of many small occluders at random depths, most of them partly overlapping.
+	void AddScene(OcclusionRasterizer& rasterizer, unsigned int triangles)
+	{
+		unsigned int seed = 12345;
+		std::vector<float> vertices(triangles * 9);
+		std::vector<unsigned int> indices(triangles * 3);
+		for(unsigned int i = 0; i < triangles; i++)
+		{
+			float centre[3];
+			for(unsigned int j = 0; j < 3; j++)
+			{
+				seed = seed * 1664525 + 1013904223;
+				centre[j] = (float)(seed >> 8) / 16777216.0f;
+			}
+			for(unsigned int v = 0; v < 3; v++)
+			{
+				for(unsigned int j = 0; j < 2; j++)
+				{
+					seed = seed * 1664525 + 1013904223;
+					float offset = ((float)(seed >> 8) / 16777216.0f - 0.5f) * 0.2f;
+					vertices[i * 9 + v * 3 + j] = centre[j] * 2.2f - 1.1f + offset;
+				}
+				vertices[i * 9 + v * 3 + 2] = 0.1f + centre[2] * 0.8f + 0.01f * v;
+				indices[i * 3 + v] = i * 3 + v;
+			}
+		}
+		rasterizer.AddOccluder(&vertices[0], triangles * 3, &indices[0], triangles * 3, Identity);
+	}
+
+	bool SameDepth(const OcclusionRasterizer& a, const OcclusionRasterizer& b)
+	{
+		return memcmp(a.GetDepth(), b.GetDepth(), sizeof(float) * a.GetWidth() * a.GetHeight()) == 0;
+	}
+
+	// Workers are kept between frames and give the same depth as the calling thread alone.
+	void TestThreads()
+	{
+		OcclusionRasterizer serial(256, 128), threaded(256, 128, 4);
+		TEST_CHECK(serial.GetThreadCount() == 1);
+		TEST_CHECK(threaded.GetThreadCount() == 4);
+
+		AddScene(serial, 2000);
+		serial.Rasterize();
+		for(unsigned int frame = 0; frame < 3; frame++)
+		{
+			threaded.Clear();
+			AddScene(threaded, 2000);
+			threaded.Rasterize();
+			TEST_CHECK(SameDepth(serial, threaded));
+		}
+	}
+
+	// AVX2 writes the same depth as SSE, where processor has it.
+	void TestAvx2()
+	{
+		OcclusionRasterizer sse(256, 128), avx2(256, 128);
+		sse.SetAvx2(false);
+		if(!avx2.SetAvx2(true))
+		{
+			printf("AVX2 not supported, skipped\n");
+			return;
+		}
+
+		AddScene(sse, 2000);
+		AddScene(avx2, 2000);
+		AddQuad(sse, -0.3f, -0.7f, 0.45f, 0.2f, 0.05f);
+		AddQuad(avx2, -0.3f, -0.7f, 0.45f, 0.2f, 0.05f);
+		sse.Rasterize();
+		avx2.Rasterize();
+		TEST_CHECK(SameDepth(sse, avx2));
+	}
+
+	// Minimum time of rasterizing a scene, binning included.
+	double TimeScene(unsigned int threads, bool avx2, unsigned int triangles, unsigned int& binned)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		const unsigned int Frames = 10;
+
+		OcclusionRasterizer rasterizer(512, 256, threads);
+		rasterizer.SetAvx2(avx2);
+
+		double best = 1e30;
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			rasterizer.Clear();
+			Clock::time_point start = Clock::now();
+			AddScene(rasterizer, triangles);
+			rasterizer.Rasterize();
+			double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			if(time < best) best = time;
+		}
+		binned = rasterizer.GetStats().binnedTriangles;
+		return best;
+	}
+
+	// Throughput in binned triangles per millisecond, with SSE and AVX2 on one thread and on
+	// all processors.
+	void Benchmark()
+	{
+		const unsigned int Triangles = 50000;
+		unsigned int processors = std::thread::hardware_concurrency();
+		if(processors == 0) processors = 1;
+
+		OcclusionRasterizer probe(32, 32);
+		bool avx2 = probe.SetAvx2(true);
+
+		printf("%u occluder triangles, 512x256, %u processors\n", Triangles, processors);
+		for(unsigned int simd = 0; simd < (avx2 ? 2u : 1u); simd++)
+		{
+			unsigned int counts[2] = { 1, processors };
+			for(unsigned int i = 0; i < (processors > 1 ? 2u : 1u); i++)
+			{
+				unsigned int binned;
+				double time = TimeScene(counts[i], simd == 1, Triangles, binned);
+				printf("  %s, %u threads: %.3f ms, %.0f triangles per ms\n", simd ? "AVX2" : "SSE ", counts[i],
+					time, binned / time);
+			}
+		}
+	}
+
+}
+
+int main()
+{
+	TestFullScreenQuad();
+	TestSharedEdges();
+	TestHugeCoordinates();
+	TestThreads();
+	TestAvx2();
+	Benchmark();
+	return SharpMedia::Test::Result("OcclusionRasterizerTest");
+}
@@ -0,0 +1,262 @@
+#include "Test.h"
+#include "RenderQueue.h"
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	// Stand-in device that records draws and counts state changes.
+	class RecordingSink : public DrawSink
+	{
+	public:
+		struct Call
+		{
+			unsigned int pipeline, material, buffers, startIndex;
+		};
+
+		unsigned int pipeline, material, buffers;
+		unsigned int stateChanges;
+		std::vector<Call> calls;
+
+		RecordingSink() : pipeline(0), material(0), buffers(0), stateChanges(0) {}
+
+		virtual void SetPipeline(unsigned int pipeline) { this->pipeline = pipeline; stateChanges++; }
+		virtual void SetMaterial(unsigned int material) { this->material = material; stateChanges++; }
+		virtual void SetBuffers(unsigned int buffers) { this->buffers = buffers; stateChanges++; }
+		virtual bool UploadInstances(const void*, unsigned int, unsigned int) { return true; }
+
+		virtual void DrawIndexedInstanced(unsigned int, unsigned int, unsigned int startIndex, int, unsigned int)
+		{
+			Call call = { pipeline, material, buffers, startIndex };
+			calls.push_back(call);
+		}
+	};
+
+	bool ItemLess(const RenderItem& a, const RenderItem& b)
+	{
+		if(a.key != b.key) return a.key < b.key;
+		return a.subkey < b.subkey;
+	}
+
+	RenderCommand Command(unsigned int pipeline, unsigned int material, unsigned int startIndex)
+	{
+		RenderCommand command = { pipeline, material, 0, 3, startIndex, 0 };
+		return command;
+	}
+
+	// Layers first, opaque before translucent, opaque by state then front to back, translucent
+	// back to front.
+	void TestOrder()
+	{
+		RenderQueue queue(1);
+		queue.Add(1, false, 0.5f, Command(0, 0, 0));
+		queue.Add(0, true, 0.2f, Command(0, 0, 1));
+		queue.Add(0, true, 0.8f, Command(1, 0, 2));
+		queue.Add(0, false, 0.9f, Command(0, 1, 3));
+		queue.Add(0, false, 0.1f, Command(0, 1, 4));
+		queue.Add(0, false, 0.5f, Command(2, 0, 5));
+
+		RecordingSink sink;
+		queue.Submit(sink);
+		TEST_CHECK(sink.calls.size() == 6);
+		unsigned int expected[6] = { 4, 3, 5, 2, 1, 0 };
+		for(unsigned int i = 0; i < 6 && i < sink.calls.size(); i++) TEST_CHECK(sink.calls[i].startIndex == expected[i]);
+	}
+
+	// Ids that are equal in low 16 bits are different states, and order by whole id.
+	void TestWideIds()
+	{
+		RenderQueue queue(1);
+		queue.Add(0, false, 0.5f, Command(65537, 0, 0));
+		queue.Add(0, false, 0.5f, Command(1, 0, 1));
+		queue.Add(0, false, 0.5f, Command(1, 65536, 2));
+		queue.Add(0, false, 0.5f, Command(0xFFFFFFFFu, 0, 3));
+		queue.Add(0, true, 0.5f, Command(1, 0x80000000u, 4));
+		queue.Add(0, true, 0.5f, Command(1, 0, 5));
+
+		RecordingSink sink;
+		queue.Submit(sink);
+		TEST_CHECK(sink.calls.size() == 6);
+		unsigned int expected[6] = { 1, 2, 0, 3, 5, 4 };
+		for(unsigned int i = 0; i < 6 && i < sink.calls.size(); i++) TEST_CHECK(sink.calls[i].startIndex == expected[i]);
+		TEST_CHECK(sink.calls[2].pipeline == 65537);
+		TEST_CHECK(sink.calls[5].material == 0x80000000u);
+	}
+
+	void Fill(RenderQueue& queue, unsigned int count, unsigned int seed)
+	{
+		srand(seed);
+		queue.Clear();
+		for(unsigned int i = 0; i < count; i++)
+		{
+			queue.Add(rand() % 4, rand() % 5 == 0, (float)rand() / RAND_MAX,
+				Command(rand() % 50, rand() % 500, i));
+		}
+	}
+
+	// Parallel and single threaded sort give same order, sorted by key, with every item once.
+	void TestParallel()
+	{
+		const unsigned int Count = 100000;
+		RenderQueue single(1), parallel(4);
+		Fill(single, Count, 7);
+		Fill(parallel, Count, 7);
+		single.Sort();
+		parallel.Sort();
+
+		const RenderItem* a = single.GetSorted();
+		const RenderItem* b = parallel.GetSorted();
+		std::vector<bool> seen(Count, false);
+		unsigned int mismatches = 0, unordered = 0, repeated = 0;
+		for(unsigned int i = 0; i < Count; i++)
+		{
+			if(a[i].command != b[i].command) mismatches++;
+			if(i > 0 && ItemLess(a[i], a[i - 1])) unordered++;
+			if(seen[a[i].command]) repeated++;
+			seen[a[i].command] = true;
+		}
+		TEST_CHECK(mismatches == 0);
+		TEST_CHECK(unordered == 0);
+		TEST_CHECK(repeated == 0);
+	}
+
+	// Sorting that makes no pass still waits for workers, so next sort does not race them.
+	void TestEqualKeys()
+	{
+		const unsigned int Count = 65536;
+		RenderQueue queue(4);
+		unsigned int unordered = 0;
+		for(unsigned int f = 0; f < 50; f++)
+		{
+			queue.Clear();
+			for(unsigned int i = 0; i < Count; i++) queue.Add(0, false, 0.5f, Command(f % 2 ? i % 7 : 1, 0, i));
+			queue.Sort();
+
+			// Radix sort is stable, equal keys keep order they were added in.
+			const RenderItem* items = queue.GetSorted();
+			for(unsigned int i = 1; i < Count; i++)
+			{
+				if(ItemLess(items[i], items[i - 1]) || (items[i].key == items[i - 1].key && items[i].command < items[i - 1].command))
+				{
+					unordered++;
+				}
+			}
+		}
+		TEST_CHECK(unordered == 0);
+	}
+
+	// Device that reads contents of a buffer per material when it draws.
+	class ContentsSink : public DrawSink
+	{
+		const int* buffers;
+		unsigned int material;
+	public:
+		std::vector<int> drawn;
+
+		ContentsSink(const int* buffers) : buffers(buffers), material(0) {}
+
+		virtual void SetPipeline(unsigned int) {}
+		virtual void SetMaterial(unsigned int material) { this->material = material; }
+		virtual void SetBuffers(unsigned int) {}
+		virtual bool UploadInstances(const void*, unsigned int, unsigned int) { return true; }
+		virtual void DrawIndexedInstanced(unsigned int, unsigned int, unsigned int, int, unsigned int)
+		{
+			drawn.push_back(buffers[material]);
+		}
+	};
+
+	// Owner flushes queued draws before it updates a buffer they read, and only then; draws see
+	// contents of when they were queued.
+	void TestResourceUpdates()
+	{
+		int buffers[2] = { 1, 2 };
+		ContentsSink sink(buffers);
+		RenderQueue queue(1);
+		DeferredResources resources;
+
+		struct Owner
+		{
+			static void Draw(RenderQueue& queue, DeferredResources& resources, int* buffers, unsigned int material)
+			{
+				resources.Add(&buffers[material]);
+				queue.Add(0, false, 0.5f, Command(0, material, 0));
+			}
+
+			static void Update(RenderQueue& queue, DeferredResources& resources, ContentsSink& sink,
+				int* buffers, unsigned int buffer, int value)
+			{
+				if(queue.GetCount() > 0 && resources.Contains(&buffers[buffer]))
+				{
+					queue.Submit(sink);
+					queue.Clear();
+					resources.Clear();
+				}
+				buffers[buffer] = value;
+			}
+		};
+
+		Owner::Draw(queue, resources, buffers, 0);
+		Owner::Update(queue, resources, sink, buffers, 1, 20);
+		TEST_CHECK(sink.drawn.empty());
+
+		Owner::Update(queue, resources, sink, buffers, 0, 10);
+		TEST_CHECK(sink.drawn.size() == 1 && sink.drawn[0] == 1);
+
+		Owner::Draw(queue, resources, buffers, 1);
+		Owner::Draw(queue, resources, buffers, 0);
+		Owner::Update(queue, resources, sink, buffers, 1, 30);
+		TEST_CHECK(sink.drawn.size() == 3 && sink.drawn[1] == 10 && sink.drawn[2] == 20);
+		TEST_CHECK(!resources.Contains(&buffers[0]));
+	}
+
+	// Sort and submit time of 100k items per frame, against a target of a millisecond for both.
+	void Benchmark()
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		const unsigned int Count = 100000, Frames = 20;
+		const double Target = 1.0;
+
+		RenderQueue queue;
+		double sortTime = 0.0, submitTime = 0.0;
+		unsigned int draws = 0, stateChanges = 0;
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			Fill(queue, Count, f);
+
+			Clock::time_point start = Clock::now();
+			queue.Sort();
+			Clock::time_point sorted = Clock::now();
+			RecordingSink sink;
+			sink.calls.reserve(Count);
+			queue.Submit(sink);
+			Clock::time_point submitted = Clock::now();
+
+			sortTime += std::chrono::duration<double, std::milli>(sorted - start).count();
+			submitTime += std::chrono::duration<double, std::milli>(submitted - sorted).count();
+			draws = (unsigned int)sink.calls.size();
+			stateChanges = sink.stateChanges;
+		}
+
+		printf("%u items per frame\n", Count);
+		printf("  sort:   %.3f ms\n", sortTime / Frames);
+		printf("  submit: %.3f ms (%u draws, %u state changes)\n", submitTime / Frames, draws, stateChanges);
+		printf("  target: %.3f ms, %s (%u threads)\n", Target,
+			(sortTime + submitTime) / Frames <= Target ? "met" : "missed", queue.GetThreadCount());
+		TEST_CHECK(draws == Count);
+	}
+
+}
+
+int main()
+{
+	TestOrder();
+	TestWideIds();
+	TestParallel();
+	TestEqualKeys();
+	TestResourceUpdates();
+	Benchmark();
+	return SharpMedia::Test::Result("RenderQueueTest");
+}
@@ -0,0 +1,111 @@
+#include "Test.h"
+#include "ResizeCoalescer.h"
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	// Applies pending resize as swap chain does at present; returns true if one was applied.
+	bool Present(ResizeCoalescer& resizer, double cost = 0.001)
+	{
+		unsigned int width, height;
+		if(!resizer.Take(width, height)) return false;
+		resizer.Applied(width, height, cost);
+		return true;
+	}
+
+	// Many requests of a frame (window drag) are applied once, at last size.
+	void TestCoalescing()
+	{
+		ResizeCoalescer resizer(640, 480);
+		for(unsigned int i = 1; i <= 20; i++) resizer.Request(640 + i, 480 + i);
+
+		TEST_CHECK(Present(resizer));
+		TEST_CHECK(resizer.GetWidth() == 660 && resizer.GetHeight() == 500);
+		TEST_CHECK(!Present(resizer));
+		TEST_CHECK(resizer.GetStats().requests == 20);
+		TEST_CHECK(resizer.GetStats().applied == 1);
+	}
+
+	// Minimized window and returning to current size do not resize.
+	void TestNoResize()
+	{
+		ResizeCoalescer resizer(640, 480);
+		resizer.Request(0, 0);
+		resizer.Request(800, 0);
+		TEST_CHECK(!resizer.IsPending());
+
+		resizer.Request(800, 600);
+		resizer.Request(640, 480);
+		TEST_CHECK(!Present(resizer));
+		TEST_CHECK(resizer.GetGeneration() == 0);
+	}
+
+	// Request arriving while resize runs is applied at next present.
+	void TestRequestDuringResize()
+	{
+		ResizeCoalescer resizer(640, 480);
+		resizer.Request(800, 600);
+
+		unsigned int width, height;
+		TEST_CHECK(resizer.Take(width, height));
+		resizer.Request(1024, 768);
+		resizer.Applied(width, height, 0.002);
+
+		TEST_CHECK(resizer.IsPending());
+		TEST_CHECK(Present(resizer));
+		TEST_CHECK(resizer.GetWidth() == 1024 && resizer.GetHeight() == 768);
+	}
+
+	// Failed resize is dropped, not retried every frame, and does not change generation.
+	void TestCancel()
+	{
+		ResizeCoalescer resizer(640, 480);
+		resizer.Request(800, 600);
+
+		unsigned int width, height;
+		TEST_CHECK(resizer.Take(width, height));
+		resizer.Cancel();
+		TEST_CHECK(!Present(resizer));
+		TEST_CHECK(resizer.GetWidth() == 640 && resizer.GetGeneration() == 0);
+	}
+
+	// Target sized to buffers compares generation on use and is rebuilt once per applied resize.
+	void TestLazyRebuild()
+	{
+		ResizeCoalescer resizer(640, 480);
+		unsigned int generation = resizer.GetGeneration(), rebuilds = 0;
+
+		for(unsigned int frame = 0; frame < 30; frame++)
+		{
+			// Window dragged over frames 10 to 19.
+			if(frame >= 10 && frame < 20)
+			{
+				for(unsigned int i = 0; i < 5; i++) resizer.Request(640 + frame * 5 + i, 480);
+			}
+
+			if(resizer.GetGeneration() != generation)
+			{
+				generation = resizer.GetGeneration();
+				rebuilds++;
+			}
+			Present(resizer, 0.001 * (frame + 1));
+		}
+
+		TEST_CHECK(rebuilds == 10);
+		TEST_CHECK(resizer.GetStats().applied == 10);
+		TEST_NEAR(resizer.GetStats().maxCost, 0.020, 1e-9);
+		TEST_NEAR(resizer.GetStats().lastCost, 0.020, 1e-9);
+	}
+
+}
+
+int main()
+{
+	TestCoalescing();
+	TestNoResize();
+	TestRequestDuringResize();
+	TestCancel();
+	TestLazyRebuild();
+	return SharpMedia::Test::Result("ResizeCoalescerTest");
+}
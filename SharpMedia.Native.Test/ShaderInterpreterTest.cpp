@@ -0,0 +1,751 @@
+#include "Test.h"
+#include "ShaderInterpreter.h"
+#include <cstring>
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	// Register names of test programs.
+	enum
+	{
+		InputX = 1,
+		InputY,
+		Counter,
+		Total,
+		Flag,
+		Zero,
+		One,
+		Two,
+		Three,
+		Ten,
+		Twenty,
+		Half
+	};
+
+	// Register names of single-operation programs.
+	enum
+	{
+		RegA = 100,
+		RegB,
+		RegC,
+		RegD,
+		RegE,
+		RegF,
+		Position,
+		Sampler,
+		Texture,
+		Result
+	};
+
+	const ShaderType Float = { ShaderScalarFloat, 1, 1, 0 };
+	const ShaderType Bool = { ShaderScalarBool, 1, 1, 0 };
+	const ShaderType Int = { ShaderScalarInt, 1, 1, 0 };
+	const ShaderType UInt = { ShaderScalarUInt, 1, 1, 0 };
+	const ShaderType Float2 = { ShaderScalarFloat, 1, 2, 0 };
+	const ShaderType Float3 = { ShaderScalarFloat, 1, 3, 0 };
+	const ShaderType Float4 = { ShaderScalarFloat, 1, 4, 0 };
+	const ShaderType Float2x2 = { ShaderScalarFloat, 2, 2, 0 };
+	const ShaderType Bool2 = { ShaderScalarBool, 1, 2, 0 };
+	const ShaderType Int2 = { ShaderScalarInt, 1, 2, 0 };
+	const ShaderType Int4 = { ShaderScalarInt, 1, 4, 0 };
+	const ShaderType FloatArray4 = { ShaderScalarFloat, 1, 1, 4 };
+	const ShaderType FloatArray2 = { ShaderScalarFloat, 1, 1, 2 };
+
+	void Fixed(ShaderProgram& p, int name, float value)
+	{
+		int r = p.Declare(name, ShaderRegisterFixed, Float);
+		p.registers[r].data.push_back(value);
+	}
+
+	void Fixed(ShaderProgram& p, int name, const ShaderType& type, const float* values)
+	{
+		int r = p.Declare(name, ShaderRegisterFixed, type);
+		p.registers[r].data.assign(values, values + type.Elements() * type.Components());
+	}
+
+	// Output of register, in output order.
+	void Output(ShaderProgram& p, int reg, const ShaderType& type)
+	{
+		ShaderOutput o;
+		o.component = 0;
+		o.type = type;
+		o.reg = -1;
+		p.Emit(ShaderOpOutput, -1, reg).param = (unsigned int)p.outputs.size();
+		p.outputs.push_back(o);
+	}
+
+	// Inputs x and y, temporaries counter, total and flag; output is written by End.
+	void Begin(ShaderProgram& p)
+	{
+		p.inputs.push_back(p.Declare(InputX, ShaderRegisterInput, Float));
+		p.inputs.push_back(p.Declare(InputY, ShaderRegisterInput, Float));
+		p.Declare(Counter, ShaderRegisterTemp, Float);
+		p.Declare(Total, ShaderRegisterTemp, Float);
+		p.Declare(Flag, ShaderRegisterTemp, Bool);
+		Fixed(p, Zero, 0.0f);
+		Fixed(p, One, 1.0f);
+		Fixed(p, Two, 2.0f);
+		Fixed(p, Three, 3.0f);
+		Fixed(p, Ten, 10.0f);
+		Fixed(p, Twenty, 20.0f);
+		Fixed(p, Half, 0.5f);
+
+		ShaderOutput o;
+		o.component = 0;
+		o.type = Float;
+		o.reg = -1;
+		p.outputs.push_back(o);
+	}
+
+	void End(ShaderProgram& p, int output = Counter)
+	{
+		p.Emit(ShaderOpOutput, -1, output).param = 0;
+	}
+
+	// Runs lanes with inputs (x, y).
+	bool Run(const ShaderProgram& p, const float* inputs, unsigned int count, float* outputs)
+	{
+		ShaderInterpreter interpreter(p);
+		return interpreter.Run(count, inputs, outputs);
+	}
+
+	// t = 0; while(t < x) t++; then t = t * t if x > 1, else t = -t.
+	void TestLoopAndIf()
+	{
+		ShaderProgram p;
+		Begin(p);
+		p.Emit(ShaderOpMov, Counter, Zero);
+		p.Emit(ShaderOpWhile, -1);
+		p.Emit(ShaderOpCompare, Flag, Counter, InputX, -1, -1, ShaderCompareLess);
+		p.Emit(ShaderOpBreak, -1, Flag);
+		p.Emit(ShaderOpAdd, Counter, Counter, One);
+		p.Emit(ShaderOpEndWhile, -1);
+		p.Emit(ShaderOpCompare, Flag, InputX, One, -1, -1, ShaderCompareGreater);
+		p.Emit(ShaderOpIf, -1, Flag);
+		p.Emit(ShaderOpMul, Counter, Counter, Counter);
+		p.Emit(ShaderOpElse, -1);
+		p.Emit(ShaderOpSub, Counter, Zero, Counter);
+		p.Emit(ShaderOpEndIf, -1);
+		End(p);
+		TEST_CHECK(p.Link());
+
+		float inputs[22], outputs[11];
+		for(int i = 0; i < 11; i++)
+		{
+			inputs[i * 2] = (float)i;
+			inputs[i * 2 + 1] = 0.0f;
+		}
+		TEST_CHECK(Run(p, inputs, 11, outputs));
+		TEST_CHECK(outputs[0] == 0.0f);
+		TEST_CHECK(outputs[1] == -1.0f);
+		for(int i = 2; i < 11; i++) TEST_CHECK(outputs[i] == (float)(i * i));
+	}
+
+	// Loop where lanes with x > 0.5 break at second iteration inside an if, and all lanes break
+	// at third; total counts iterations that passed the if. Lanes masked by the if must run the
+	// rest of the body when the others break.
+	void TestBreakInDivergentIf()
+	{
+		ShaderProgram p;
+		Begin(p);
+		p.Emit(ShaderOpMov, Counter, Zero);
+		p.Emit(ShaderOpMov, Total, Zero);
+		p.Emit(ShaderOpWhile, -1);
+		p.Emit(ShaderOpAdd, Counter, Counter, One);
+		p.Emit(ShaderOpCompare, Flag, InputX, Half, -1, -1, ShaderCompareGreater);
+		p.Emit(ShaderOpIf, -1, Flag);
+		p.Emit(ShaderOpCompare, Flag, Counter, Two, -1, -1, ShaderCompareLess);
+		p.Emit(ShaderOpBreak, -1, Flag);
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpAdd, Total, Total, One);
+		p.Emit(ShaderOpCompare, Flag, Counter, Three, -1, -1, ShaderCompareLess);
+		p.Emit(ShaderOpBreak, -1, Flag);
+		p.Emit(ShaderOpEndWhile, -1);
+		End(p, Total);
+		TEST_CHECK(p.Link());
+
+		// Uniform lanes.
+		float inputs[16], outputs[8];
+		for(int i = 0; i < 8; i++)
+		{
+			inputs[i * 2] = 0.0f;
+			inputs[i * 2 + 1] = 0.0f;
+		}
+		TEST_CHECK(Run(p, inputs, 8, outputs));
+		for(int i = 0; i < 8; i++) TEST_CHECK(outputs[i] == 3.0f);
+
+		for(int i = 0; i < 8; i++) inputs[i * 2] = 1.0f;
+		TEST_CHECK(Run(p, inputs, 8, outputs));
+		for(int i = 0; i < 8; i++) TEST_CHECK(outputs[i] == 1.0f);
+
+		// Mixed lanes get same results as uniform ones.
+		for(int i = 0; i < 8; i++) inputs[i * 2] = (float)(i & 1);
+		TEST_CHECK(Run(p, inputs, 8, outputs));
+		for(int i = 0; i < 8; i++) TEST_CHECK(outputs[i] == ((i & 1) ? 1.0f : 3.0f));
+	}
+
+	// switch(x) { case 0: if(y > 0.5) { t = 10; break; } t = 1; case 1: t = 20; }; lanes of case 0
+	// masked by the if must still reach t = 1.
+	void TestBreakInCase()
+	{
+		ShaderProgram p;
+		Begin(p);
+		p.Emit(ShaderOpMov, Counter, Zero);
+		p.Emit(ShaderOpSwitch, -1, InputX);
+		p.Emit(ShaderOpCase, -1, Zero);
+		p.Emit(ShaderOpCompare, Flag, InputY, Half, -1, -1, ShaderCompareGreater);
+		p.Emit(ShaderOpIf, -1, Flag);
+		p.Emit(ShaderOpMov, Counter, Ten);
+		p.Emit(ShaderOpBreak, -1, Zero);
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpMov, Counter, One);
+		p.Emit(ShaderOpEndCase, -1);
+		p.Emit(ShaderOpCase, -1, One);
+		p.Emit(ShaderOpMov, Counter, Twenty);
+		p.Emit(ShaderOpEndCase, -1);
+		p.Emit(ShaderOpEndSwitch, -1);
+		End(p);
+		TEST_CHECK(p.Link());
+
+		// Lanes: (x, y) = (0, 1), (0, 0), (1, 0), (0, 1).
+		float inputs[8] = { 0, 1, 0, 0, 1, 0, 0, 1 };
+		float outputs[4];
+		TEST_CHECK(Run(p, inputs, 4, outputs));
+		TEST_CHECK(outputs[0] == 10.0f);
+		TEST_CHECK(outputs[1] == 1.0f);
+		TEST_CHECK(outputs[2] == 20.0f);
+		TEST_CHECK(outputs[3] == 10.0f);
+	}
+
+	void TestNonTerminatingLoop()
+	{
+		ShaderProgram p;
+		Begin(p);
+		p.Emit(ShaderOpWhile, -1);
+		p.Emit(ShaderOpAdd, Counter, Counter, One);
+		p.Emit(ShaderOpEndWhile, -1);
+		End(p);
+		TEST_CHECK(p.Link());
+
+		ShaderInterpreter interpreter(p);
+		interpreter.SetMaxIterations(100);
+		float inputs[2] = { 0, 0 }, outputs[1];
+		TEST_CHECK(!interpreter.Run(1, inputs, outputs));
+	}
+
+	// One lane of each operation over fixed operands.
+	void TestArithmetic()
+	{
+		ShaderProgram p;
+		Fixed(p, RegA, 7.0f);
+		Fixed(p, RegB, -2.0f);
+		Fixed(p, Zero, 0.0f);
+		p.Declare(RegC, ShaderRegisterTemp, Float);
+		p.Declare(RegD, ShaderRegisterTemp, Int);
+		p.Declare(RegE, ShaderRegisterTemp, UInt);
+
+		ShaderOpcode ops[] = { ShaderOpAdd, ShaderOpSub, ShaderOpMul, ShaderOpDiv, ShaderOpMin, ShaderOpMax };
+		for(int i = 0; i < 6; i++)
+		{
+			p.Emit(ops[i], RegC, RegA, RegB);
+			Output(p, RegC, Float);
+		}
+
+		// Integer division truncates, by zero it gives all bits set.
+		p.Emit(ShaderOpConvert, RegD, RegA);
+		p.Emit(ShaderOpDiv, RegD, RegD, RegB);
+		Output(p, RegD, Int);
+		p.Emit(ShaderOpConvert, RegD, RegA);
+		p.Emit(ShaderOpDiv, RegD, RegD, Zero);
+		Output(p, RegD, Int);
+		p.Emit(ShaderOpConvert, RegE, RegA);
+		p.Emit(ShaderOpDiv, RegE, RegE, Zero);
+		Output(p, RegE, UInt);
+		TEST_CHECK(p.Link());
+
+		ShaderInterpreter interpreter(p);
+		TEST_CHECK(interpreter.Execute(1));
+
+		float expected[] = { 5.0f, 9.0f, -14.0f, -3.5f, -2.0f, 7.0f, -3.0f, -1.0f, 4294967295.0f };
+		for(unsigned int o = 0; o < 9; o++)
+		{
+			float value;
+			interpreter.GetOutput(o, 0, &value);
+			TEST_CHECK(value == expected[o]);
+		}
+	}
+
+	void TestSwizzleExpandConvert()
+	{
+		ShaderProgram p;
+		float v4[] = { 1, 2, 3, 4 }, v2[] = { 5, 6 };
+		Fixed(p, RegA, Float4, v4);
+		Fixed(p, RegB, Float2, v2);
+		Fixed(p, RegF, -2.75f);
+		p.Declare(RegC, ShaderRegisterTemp, Float4);
+		p.Declare(RegD, ShaderRegisterTemp, Int2);
+		p.Declare(RegE, ShaderRegisterTemp, Bool2);
+		p.Declare(Result, ShaderRegisterTemp, UInt);
+
+		// .wzyx and .yy (short swizzles repeat the last selector).
+		ShaderInstruction& wzyx = p.Emit(ShaderOpSwizzle, RegC, RegA, -1, -1, -1, 4);
+		wzyx.swizzle[0] = 3; wzyx.swizzle[1] = 2; wzyx.swizzle[2] = 1; wzyx.swizzle[3] = 0;
+		Output(p, RegC, Float4);
+		p.Emit(ShaderOpSwizzle, RegC, RegA, -1, -1, -1, 1).swizzle[0] = 1;
+		Output(p, RegC, Float4);
+
+		ShaderExpandCode codes[] = { ShaderExpandZeros, ShaderExpandOnes, ShaderExpandOnesAtW };
+		for(int i = 0; i < 3; i++)
+		{
+			p.Emit(ShaderOpExpand, RegC, RegB, -1, -1, -1, codes[i]);
+			Output(p, RegC, Float4);
+		}
+
+		p.Emit(ShaderOpConvert, RegD, RegF);
+		Output(p, RegD, Int2);
+		p.Emit(ShaderOpConvert, Result, RegF);
+		Output(p, Result, UInt);
+		p.Emit(ShaderOpConvert, RegE, RegF);
+		Output(p, RegE, Bool2);
+		TEST_CHECK(p.Link());
+
+		ShaderInterpreter interpreter(p);
+		TEST_CHECK(interpreter.Execute(1));
+
+		float expected[5][4] = { { 4, 3, 2, 1 }, { 2, 2, 2, 2 }, { 5, 6, 0, 0 }, { 5, 6, 1, 1 }, { 5, 6, 0, 1 } };
+		for(unsigned int o = 0; o < 5; o++)
+		{
+			float value[4];
+			interpreter.GetOutput(o, 0, value);
+			TEST_CHECK(memcmp(value, expected[o], sizeof(value)) == 0);
+		}
+
+		float value[2];
+		interpreter.GetOutput(5, 0, value);
+		TEST_CHECK(value[0] == -2.0f && value[1] == -2.0f);
+		interpreter.GetOutput(6, 0, value);
+		TEST_CHECK(value[0] == 0.0f);
+		interpreter.GetOutput(7, 0, value);
+		TEST_CHECK(value[0] == 1.0f && value[1] == 1.0f);
+	}
+
+	void TestCall()
+	{
+		ShaderProgram p;
+		float v2[] = { 3, -4 }, b2[] = { 1, 0 };
+		Fixed(p, RegA, Float2, v2);
+		Fixed(p, RegB, Bool2, b2);
+		Fixed(p, RegF, -2.5f);
+		p.Declare(RegC, ShaderRegisterTemp, Float2);
+		p.Declare(RegD, ShaderRegisterTemp, Float);
+		p.Declare(RegE, ShaderRegisterTemp, Bool);
+
+		p.Emit(ShaderOpCall, RegC, RegA, -1, -1, -1, ShaderFunctionAbs);
+		Output(p, RegC, Float2);
+		p.Emit(ShaderOpCall, RegD, RegF, -1, -1, -1, ShaderFunctionFloor);
+		Output(p, RegD, Float);
+		p.Emit(ShaderOpCall, RegD, RegF, -1, -1, -1, ShaderFunctionCeil);
+		Output(p, RegD, Float);
+		p.Emit(ShaderOpCall, RegD, RegA, -1, -1, -1, ShaderFunctionLength);
+		Output(p, RegD, Float);
+
+		ShaderFunctionCode tests[] = { ShaderFunctionAll, ShaderFunctionAny, ShaderFunctionNone };
+		for(int i = 0; i < 3; i++)
+		{
+			p.Emit(ShaderOpCall, RegE, RegB, -1, -1, -1, tests[i]);
+			Output(p, RegE, Bool);
+		}
+		TEST_CHECK(p.Link());
+
+		ShaderInterpreter interpreter(p);
+		TEST_CHECK(interpreter.Execute(1));
+
+		float value[2];
+		interpreter.GetOutput(0, 0, value);
+		TEST_CHECK(value[0] == 3.0f && value[1] == 4.0f);
+
+		float expected[] = { -3.0f, -2.0f, 5.0f, 0.0f, 1.0f, 1.0f };
+		for(unsigned int o = 1; o < 7; o++)
+		{
+			interpreter.GetOutput(o, 0, value);
+			TEST_CHECK(value[0] == expected[o - 1]);
+		}
+	}
+
+	void TestMulExAndDot()
+	{
+		ShaderProgram p;
+		float v[] = { 1, 2 }, w[] = { 3, 4 }, m[] = { 1, 2, 3, 4 };
+		Fixed(p, RegA, Float2, v);
+		Fixed(p, RegB, Float2, w);
+		Fixed(p, RegC, Float2x2, m);
+		p.Declare(RegD, ShaderRegisterTemp, Float2);
+		p.Declare(RegE, ShaderRegisterTemp, Float2x2);
+		p.Declare(RegF, ShaderRegisterTemp, Float);
+
+		// v.w, v * m, m * v, m * m and dot(v, w).
+		p.Emit(ShaderOpMulEx, RegF, RegA, RegB);
+		Output(p, RegF, Float);
+		p.Emit(ShaderOpMulEx, RegD, RegA, RegC);
+		Output(p, RegD, Float2);
+		p.Emit(ShaderOpMulEx, RegD, RegC, RegA);
+		Output(p, RegD, Float2);
+		p.Emit(ShaderOpMulEx, RegE, RegC, RegC);
+		Output(p, RegE, Float2x2);
+		p.Emit(ShaderOpDot, RegF, RegA, RegB);
+		Output(p, RegF, Float);
+		TEST_CHECK(p.Link());
+
+		ShaderInterpreter interpreter(p);
+		TEST_CHECK(interpreter.Execute(1));
+
+		float value[4];
+		interpreter.GetOutput(0, 0, value);
+		TEST_CHECK(value[0] == 11.0f);
+		interpreter.GetOutput(1, 0, value);
+		TEST_CHECK(value[0] == 7.0f && value[1] == 10.0f);
+		interpreter.GetOutput(2, 0, value);
+		TEST_CHECK(value[0] == 5.0f && value[1] == 11.0f);
+		interpreter.GetOutput(3, 0, value);
+		TEST_CHECK(value[0] == 7.0f && value[1] == 10.0f && value[2] == 15.0f && value[3] == 22.0f);
+		interpreter.GetOutput(4, 0, value);
+		TEST_CHECK(value[0] == 11.0f);
+	}
+
+	// Indexing fixed array by lane input, out of range indices are clamped.
+	void TestIndex()
+	{
+		ShaderProgram p;
+		float array[] = { 10, 20, 30, 40 };
+		p.inputs.push_back(p.Declare(InputX, ShaderRegisterInput, Float));
+		Fixed(p, RegA, FloatArray4, array);
+		p.Declare(Result, ShaderRegisterTemp, Float);
+		p.Emit(ShaderOpIndex, Result, RegA, InputX);
+		Output(p, Result, Float);
+		TEST_CHECK(p.Link());
+
+		float inputs[] = { 0, 1, 2, 3, -1, 7 }, outputs[6];
+		TEST_CHECK(Run(p, inputs, 6, outputs));
+		float expected[] = { 10, 20, 30, 40, 10, 40 };
+		for(int i = 0; i < 6; i++) TEST_CHECK(outputs[i] == expected[i]);
+	}
+
+	// Scalars pack into a register, vectors, matrix rows and array elements start at registers.
+	void TestConstantBuffer()
+	{
+		ShaderProgram p;
+		struct { int r; ShaderType type; unsigned int offset; } constants[] =
+		{
+			{ RegA, Int, 0 }, { RegB, UInt, 4 }, { RegC, Bool, 8 }, { RegD, Float3, 16 },
+			{ RegE, Float2x2, 32 }, { RegF, FloatArray2, 64 }
+		};
+		for(int i = 0; i < 6; i++)
+		{
+			int r = p.Declare(constants[i].r, ShaderRegisterConstant, constants[i].type);
+			p.registers[r].slot = 1;
+			p.registers[r].offset = constants[i].offset;
+		}
+		Fixed(p, One, 1.0f);
+		p.Declare(Result, ShaderRegisterTemp, Float);
+
+		for(int i = 0; i < 5; i++) Output(p, constants[i].r, constants[i].type);
+		p.Emit(ShaderOpIndex, Result, RegF, One);
+		Output(p, Result, Float);
+		TEST_CHECK(p.Link());
+
+		unsigned char buffer[96];
+		memset(buffer, 0, sizeof(buffer));
+		int i = -7;
+		unsigned int u = 9, b = 5;
+		float f3[] = { 1, 2, 3 }, row0[] = { 1, 2 }, row1[] = { 3, 4 }, e0 = 5, e1 = 6;
+		memcpy(buffer, &i, 4);
+		memcpy(buffer + 4, &u, 4);
+		memcpy(buffer + 8, &b, 4);
+		memcpy(buffer + 16, f3, 12);
+		memcpy(buffer + 32, row0, 8);
+		memcpy(buffer + 48, row1, 8);
+		memcpy(buffer + 64, &e0, 4);
+		memcpy(buffer + 80, &e1, 4);
+
+		ShaderInterpreter interpreter(p);
+		interpreter.BindConstantBuffer(1, buffer, sizeof(buffer));
+		TEST_CHECK(interpreter.Execute(1));
+
+		float value[4];
+		interpreter.GetOutput(0, 0, value);
+		TEST_CHECK(value[0] == -7.0f);
+		interpreter.GetOutput(1, 0, value);
+		TEST_CHECK(value[0] == 9.0f);
+		interpreter.GetOutput(2, 0, value);
+		TEST_CHECK(value[0] == 1.0f);
+		interpreter.GetOutput(3, 0, value);
+		TEST_CHECK(value[0] == 1.0f && value[1] == 2.0f && value[2] == 3.0f);
+		interpreter.GetOutput(4, 0, value);
+		TEST_CHECK(value[0] == 1.0f && value[1] == 2.0f && value[2] == 3.0f && value[3] == 4.0f);
+		interpreter.GetOutput(5, 0, value);
+		TEST_CHECK(value[0] == 6.0f);
+
+		// Reads past end of a short buffer keep zero.
+		interpreter.BindConstantBuffer(1, buffer, 64);
+		TEST_CHECK(interpreter.Execute(1));
+		interpreter.GetOutput(5, 0, value);
+		TEST_CHECK(value[0] == 0.0f);
+	}
+
+	// Program sampling (or loading) texture register 0 of dimension at per-lane position; the
+	// optional offset is a fixed (1, 1, 1, 1).
+	void TextureProgram(ShaderProgram& p, ShaderOpcode op, ShaderTextureDimension dimension,
+		const ShaderType& position, bool offset = false)
+	{
+		p.inputs.push_back(p.Declare(Position, ShaderRegisterInput, position));
+		p.registers[p.Declare(Sampler, ShaderRegisterSampler, Float)].slot = 0;
+		int t = p.Declare(Texture, ShaderRegisterTexture, Float);
+		p.registers[t].slot = 0;
+		p.registers[t].dimension = dimension;
+		p.Declare(Result, ShaderRegisterTemp, Float4);
+
+		float ones[] = { 1, 1, 1, 1 };
+		if(offset) Fixed(p, RegA, Int4, ones);
+		if(op == ShaderOpSample) p.Emit(ShaderOpSample, Result, Sampler, Texture, Position, offset ? RegA : -1);
+		else p.Emit(ShaderOpLoad, Result, Texture, Position, offset ? RegA : -1);
+		Output(p, Result, Float4);
+	}
+
+	// Texels of all components equal to their value.
+	std::vector<float> Texels(const float* values, unsigned int count)
+	{
+		std::vector<float> texels;
+		for(unsigned int i = 0; i < count; i++) texels.insert(texels.end(), 4, values[i]);
+		return texels;
+	}
+
+	bool Sample(const ShaderProgram& p, const ShaderTexture* texture, const ShaderSampler& sampler,
+		const float* positions, unsigned int count, float* results)
+	{
+		ShaderInterpreter interpreter(p);
+		interpreter.BindTexture(0, texture);
+		interpreter.BindSampler(0, sampler);
+
+		std::vector<float> outputs(count * 4);
+		if(!interpreter.Run(count, positions, &outputs[0])) return false;
+		for(unsigned int i = 0; i < count; i++) results[i] = outputs[i * 4];
+		return true;
+	}
+
+	void TestSampleAndLoad()
+	{
+		// Texels 0 1 / 2 3, and a 1x1 mipmap of 7.
+		float values[] = { 0, 1, 2, 3 }, mip[] = { 7 };
+		ShaderTexture2D texture;
+		texture.AddLevel(2, 2, &Texels(values, 4)[0]);
+		texture.AddLevel(1, 1, &Texels(mip, 1)[0]);
+
+		ShaderProgram p;
+		TextureProgram(p, ShaderOpSample, ShaderDimension2D, Float2);
+		TEST_CHECK(p.Link());
+
+		ShaderSampler point;
+		point.linear = false;
+		float positions[] = { 0.75f, 0.25f, 0.25f, 0.75f, 1.25f, 0.25f }, results[3];
+		TEST_CHECK(Sample(p, &texture, point, positions, 3, results));
+		TEST_CHECK(results[0] == 1.0f && results[1] == 2.0f && results[2] == 0.0f);
+
+		// Centre is the average, clamped corner is the corner texel.
+		ShaderSampler linear;
+		linear.address[0] = linear.address[1] = ShaderAddressClamp;
+		float centre[] = { 0.5f, 0.5f, 0.0f, 0.0f };
+		TEST_CHECK(Sample(p, &texture, linear, centre, 2, results));
+		TEST_CHECK(results[0] == 1.5f && results[1] == 0.0f);
+
+		ShaderSampler border = point;
+		border.address[0] = border.address[1] = ShaderAddressBorder;
+		border.border[0] = 9.0f;
+		TEST_CHECK(Sample(p, &texture, border, positions, 3, results));
+		TEST_CHECK(results[0] == 1.0f && results[2] == 9.0f);
+
+		ShaderSampler mirror = point;
+		mirror.address[0] = ShaderAddressMirror;
+		TEST_CHECK(Sample(p, &texture, mirror, positions, 3, results));
+		TEST_CHECK(results[2] == 1.0f);
+
+		ShaderProgram offset;
+		TextureProgram(offset, ShaderOpSample, ShaderDimension2D, Float2, true);
+		TEST_CHECK(offset.Link());
+		TEST_CHECK(Sample(offset, &texture, point, positions, 1, results));
+		TEST_CHECK(results[0] == 2.0f);
+
+		// Loads are unfiltered, out of range ones give zero.
+		ShaderProgram load;
+		TextureProgram(load, ShaderOpLoad, ShaderDimension2D, Int4);
+		TEST_CHECK(load.Link());
+		float texels[] = { 1, 1, 0, 0, 0, 0, 1, 0, 2, 0, 0, 0, 0, 0, 2, 0 };
+		TEST_CHECK(Sample(load, &texture, point, texels, 4, results));
+		TEST_CHECK(results[0] == 3.0f && results[1] == 7.0f && results[2] == 0.0f && results[3] == 0.0f);
+
+		// Unbound textures read zero.
+		TEST_CHECK(Sample(p, 0, point, positions, 1, results));
+		TEST_CHECK(results[0] == 0.0f);
+	}
+
+	void TestTextureDimensions()
+	{
+		ShaderSampler linear;
+		float results[3];
+
+		// 1D reads its row, arrays select rounded and clamped layers.
+		float row[] = { 1, 3 };
+		ShaderTexture2D texture1D;
+		texture1D.AddLevel(2, 1, &Texels(row, 2)[0]);
+		ShaderProgram p1D;
+		TextureProgram(p1D, ShaderOpSample, ShaderDimension1D, Float);
+		TEST_CHECK(p1D.Link());
+		float u[] = { 0.5f };
+		TEST_CHECK(Sample(p1D, &texture1D, linear, u, 1, results));
+		TEST_CHECK(results[0] == 2.0f);
+
+		float layers[] = { 10, 20, 30 };
+		ShaderTexture2D array;
+		array.AddLevel(1, 1, 3, &Texels(layers, 3)[0]);
+		ShaderProgram pArray;
+		TextureProgram(pArray, ShaderOpSample, ShaderDimension2DArray, Float3);
+		TEST_CHECK(pArray.Link());
+		float uvl[] = { 0.5f, 0.5f, 1.4f, 0.5f, 0.5f, 5.0f, 0.5f, 0.5f, -1.0f };
+		TEST_CHECK(Sample(pArray, &array, linear, uvl, 3, results));
+		TEST_CHECK(results[0] == 20.0f && results[1] == 30.0f && results[2] == 10.0f);
+
+		// 3D is filtered between slices.
+		float volume[8];
+		for(int i = 0; i < 8; i++) volume[i] = (float)i;
+		ShaderTexture3D texture3D;
+		texture3D.AddLevel(2, 2, 2, &Texels(volume, 8)[0]);
+		ShaderProgram p3D;
+		TextureProgram(p3D, ShaderOpSample, ShaderDimension3D, Float3);
+		TEST_CHECK(p3D.Link());
+		float uvw[] = { 0.5f, 0.5f, 0.5f, 0.75f, 0.75f, 0.75f };
+		ShaderSampler clamp;
+		clamp.address[0] = clamp.address[1] = clamp.address[2] = ShaderAddressClamp;
+		TEST_CHECK(Sample(p3D, &texture3D, clamp, uvw, 2, results));
+		TEST_CHECK(results[0] == 3.5f && results[1] == 7.0f);
+
+		ShaderProgram load3D;
+		TextureProgram(load3D, ShaderOpLoad, ShaderDimension3D, Int4);
+		TEST_CHECK(load3D.Link());
+		float xyz[] = { 1, 0, 1, 0 };
+		TEST_CHECK(Sample(load3D, &texture3D, clamp, xyz, 1, results));
+		TEST_CHECK(results[0] == 5.0f);
+
+		// Cube faces are selected by major axis.
+		float faces[] = { 0, 1, 2, 3, 4, 5 };
+		ShaderTextureCube cube;
+		cube.AddLevel(1, &Texels(faces, 6)[0]);
+		ShaderProgram pCube;
+		TextureProgram(pCube, ShaderOpSample, ShaderDimensionCube, Float3);
+		TEST_CHECK(pCube.Link());
+		float directions[] = { -1.0f, 0.2f, 0.3f, 0.1f, -2.0f, 0.5f, 0.0f, 0.0f, 5.0f };
+		TEST_CHECK(Sample(pCube, &cube, linear, directions, 3, results));
+		TEST_CHECK(results[0] == 1.0f && results[1] == 3.0f && results[2] == 4.0f);
+
+		// Textures that cannot be read as register's dimension (and buffers) fail execution.
+		TEST_CHECK(!Sample(pCube, &array, linear, directions, 1, results));
+		TEST_CHECK(!Sample(p1D, &cube, linear, u, 1, results));
+		TEST_CHECK(!Sample(pArray, &texture3D, linear, uvl, 1, results));
+
+		ShaderProgram buffer;
+		TextureProgram(buffer, ShaderOpLoad, ShaderDimensionBuffer, Int);
+		TEST_CHECK(buffer.Link());
+		TEST_CHECK(!Sample(buffer, &texture1D, linear, u, 1, results));
+	}
+
+	// Quads spread over 1, 2, 1.5 and 16 texels select mipmaps of values 1, 2 and 4.
+	void TestMipSelection()
+	{
+		float one[16], two[4], four[1];
+		for(int i = 0; i < 16; i++) one[i] = 1.0f;
+		for(int i = 0; i < 4; i++) two[i] = 2.0f;
+		four[0] = 4.0f;
+
+		ShaderTexture2D texture;
+		texture.AddLevel(4, 4, &Texels(one, 16)[0]);
+		texture.AddLevel(2, 2, &Texels(two, 4)[0]);
+		texture.AddLevel(1, 1, &Texels(four, 1)[0]);
+
+		ShaderProgram p;
+		TextureProgram(p, ShaderOpSample, ShaderDimension2D, Float2);
+		TEST_CHECK(p.Link());
+
+		ShaderInterpreter interpreter(p);
+		interpreter.BindTexture(0, &texture);
+		ShaderSampler linear;
+		linear.address[0] = linear.address[1] = ShaderAddressClamp;
+		interpreter.BindSampler(0, linear);
+
+		const float spread[4] = { 0.25f, 0.5f, 0.375f, 4.0f };
+		for(unsigned int q = 0; q < 2; q++)
+		{
+			for(unsigned int l = 0; l < 4; l++)
+			{
+				float uv[] = { 0.25f + (l & 1) * spread[q], 0.25f + (l >> 1) * spread[q] };
+				interpreter.SetInput(0, q * 4 + l, uv);
+			}
+		}
+
+		float value[4];
+		TEST_CHECK(interpreter.Execute(8));
+		interpreter.GetOutput(0, 0, value);
+		TEST_CHECK(value[0] == 1.0f);
+		interpreter.GetOutput(0, 4, value);
+		TEST_CHECK(value[0] == 1.0f);
+
+		interpreter.SetQuads(true);
+		TEST_CHECK(interpreter.Execute(8));
+		for(unsigned int l = 0; l < 4; l++)
+		{
+			interpreter.GetOutput(0, l, value);
+			TEST_CHECK(value[0] == 1.0f);
+			interpreter.GetOutput(0, 4 + l, value);
+			TEST_CHECK(value[0] == 2.0f);
+		}
+
+		// Between mipmaps linear samplers blend, point ones take the nearest.
+		for(unsigned int q = 0; q < 2; q++)
+		{
+			for(unsigned int l = 0; l < 4; l++)
+			{
+				float uv[] = { 0.25f + (l & 1) * spread[2 + q], 0.25f + (l >> 1) * spread[2 + q] };
+				interpreter.SetInput(0, q * 4 + l, uv);
+			}
+		}
+		TEST_CHECK(interpreter.Execute(8));
+		interpreter.GetOutput(0, 0, value);
+		TEST_NEAR(value[0], 1.0f + log2f(1.5f), 1e-5);
+		interpreter.GetOutput(0, 4, value);
+		TEST_CHECK(value[0] == 4.0f);
+
+		ShaderSampler point;
+		point.linear = false;
+		interpreter.BindSampler(0, point);
+		TEST_CHECK(interpreter.Execute(8));
+		interpreter.GetOutput(0, 0, value);
+		TEST_CHECK(value[0] == 2.0f);
+	}
+
+}
+
+int main()
+{
+	TestLoopAndIf();
+	TestBreakInDivergentIf();
+	TestBreakInCase();
+	TestNonTerminatingLoop();
+	TestArithmetic();
+	TestSwizzleExpandConvert();
+	TestCall();
+	TestMulExAndDot();
+	TestIndex();
+	TestConstantBuffer();
+	TestSampleAndLoad();
+	TestTextureDimensions();
+	TestMipSelection();
+	return SharpMedia::Test::Result("ShaderInterpreterTest");
+}
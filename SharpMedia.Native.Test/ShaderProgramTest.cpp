@@ -0,0 +1,390 @@
+#include "Test.h"
+#include "ShaderProgram.h"
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	// Register names of test programs.
+	enum
+	{
+		InputX = 1,
+		Counter,
+		Value,
+		Flag,
+		Exit,
+		Index,
+		Done,
+		Texel,
+		Sampler,
+		Texture,
+		Zero,
+		One,
+		Two,
+		Four,
+		Five,
+		Limit,
+		Half,
+		Yes
+	};
+
+	const ShaderType Float = { ShaderScalarFloat, 1, 1, 0 };
+	const ShaderType Float4 = { ShaderScalarFloat, 1, 4, 0 };
+	const ShaderType Bool = { ShaderScalarBool, 1, 1, 0 };
+
+	void Fixed(ShaderProgram& p, int name, float value)
+	{
+		int r = p.Declare(name, ShaderRegisterFixed, Float);
+		p.registers[r].data.push_back(value);
+	}
+
+	// Input x, temporaries, a texture with its sampler and fixed values.
+	void Begin(ShaderProgram& p)
+	{
+		p.inputs.push_back(p.Declare(InputX, ShaderRegisterInput, Float));
+		p.Declare(Counter, ShaderRegisterTemp, Float);
+		p.Declare(Value, ShaderRegisterTemp, Float);
+		p.Declare(Flag, ShaderRegisterTemp, Bool);
+		p.Declare(Exit, ShaderRegisterTemp, Bool);
+		p.Declare(Index, ShaderRegisterTemp, Float);
+		p.Declare(Done, ShaderRegisterTemp, Bool);
+		p.Declare(Texel, ShaderRegisterTemp, Float4);
+		p.Declare(Sampler, ShaderRegisterSampler, Float);
+		p.Declare(Texture, ShaderRegisterTexture, Float);
+		Fixed(p, Zero, 0.0f);
+		Fixed(p, One, 1.0f);
+		Fixed(p, Two, 2.0f);
+		Fixed(p, Four, 4.0f);
+		Fixed(p, Five, 5.0f);
+		Fixed(p, Limit, 1000.0f);
+		Fixed(p, Half, 0.5f);
+		int r = p.Declare(Yes, ShaderRegisterFixed, Bool);
+		p.registers[r].data.push_back(1.0f);
+	}
+
+	// Appends 'count' operations without gradients.
+	void Body(ShaderProgram& p, unsigned int count)
+	{
+		for(unsigned int i = 0; i < count; i++) p.Emit(ShaderOpAdd, Value, Value, One);
+	}
+
+	void Gradient(ShaderProgram& p)
+	{
+		p.Emit(ShaderOpSample, Texel, Sampler, Texture, Value);
+	}
+
+	// Index of n-th instruction of opcode.
+	int Nth(const ShaderProgram& p, ShaderOpcode op, int n = 0)
+	{
+		for(int i = 0; i < (int)p.instructions.size(); i++)
+		{
+			if(p.instructions[i].op == op && n-- == 0) return i;
+		}
+		return -1;
+	}
+
+	// Values computed from inputs, or written under divergent flow control, vary; conditions
+	// on varying values diverge.
+	void TestAnalyze()
+	{
+		ShaderProgram p;
+		Begin(p);
+		p.Emit(ShaderOpIf, -1, Yes);
+		p.Emit(ShaderOpMov, Counter, One);
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpCompare, Flag, InputX, Half, -1, -1, ShaderCompareGreater);
+		p.Emit(ShaderOpIf, -1, Flag);
+		p.Emit(ShaderOpMov, Value, Two);
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpCompare, Flag, Value, One, -1, -1, ShaderCompareGreater);
+		p.Emit(ShaderOpIf, -1, Flag);
+		p.Emit(ShaderOpEndIf, -1);
+		TEST_CHECK(p.Link());
+
+		std::vector<unsigned char> varying, divergent;
+		p.Analyze(varying, divergent);
+		TEST_CHECK(varying[p.Find(InputX)]);
+		TEST_CHECK(!varying[p.Find(Counter)]);
+		TEST_CHECK(varying[p.Find(Value)]);
+		TEST_CHECK(!varying[p.Find(One)]);
+		TEST_CHECK(!divergent[Nth(p, ShaderOpIf, 0)]);
+		TEST_CHECK(divergent[Nth(p, ShaderOpIf, 1)]);
+		TEST_CHECK(divergent[Nth(p, ShaderOpIf, 2)]);
+	}
+
+	// Loop with uniform trip diverges when a break depends on the input; a value carried by
+	// the loop then varies even if set from fixed values.
+	void TestAnalyzeLoop()
+	{
+		ShaderProgram p;
+		Begin(p);
+		p.Emit(ShaderOpMov, Counter, Zero);
+		p.Emit(ShaderOpWhile, -1);
+		p.Emit(ShaderOpCompare, Exit, Counter, Four, -1, -1, ShaderCompareLess);
+		p.Emit(ShaderOpBreak, -1, Exit);
+		p.Emit(ShaderOpAdd, Counter, Counter, One);
+		p.Emit(ShaderOpEndWhile, -1);
+		p.Emit(ShaderOpWhile, -1);
+		p.Emit(ShaderOpAdd, Value, Value, One);
+		p.Emit(ShaderOpCompare, Flag, Value, InputX, -1, -1, ShaderCompareLess);
+		p.Emit(ShaderOpBreak, -1, Flag);
+		p.Emit(ShaderOpEndWhile, -1);
+		TEST_CHECK(p.Link());
+
+		std::vector<unsigned char> varying, divergent;
+		p.Analyze(varying, divergent);
+		TEST_CHECK(!divergent[Nth(p, ShaderOpWhile, 0)]);
+		TEST_CHECK(!varying[p.Find(Counter)]);
+		TEST_CHECK(divergent[Nth(p, ShaderOpWhile, 1)]);
+		TEST_CHECK(varying[p.Find(Value)]);
+	}
+
+	void TestIfAttributes()
+	{
+		ShaderProgram p;
+		Begin(p);
+		p.Emit(ShaderOpCompare, Flag, InputX, Half, -1, -1, ShaderCompareGreater);
+
+		// Uniform, small divergent, large divergent, large divergent with gradient.
+		p.Emit(ShaderOpIf, -1, Yes);
+		Body(p, 1);
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpIf, -1, Flag);
+		Body(p, ShaderBranchThreshold - 1);
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpIf, -1, Flag);
+		Body(p, ShaderBranchThreshold / 2);
+		p.Emit(ShaderOpElse, -1);
+		Body(p, ShaderBranchThreshold / 2);
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpIf, -1, Flag);
+		Body(p, ShaderBranchThreshold);
+		Gradient(p);
+		p.Emit(ShaderOpEndIf, -1);
+
+		// Author's flatten is kept, loop does not apply to ifs.
+		p.Emit(ShaderOpIf, -1, Yes).hint = ShaderFlowFlatten;
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpIf, -1, Flag).hint = ShaderFlowLoop;
+		p.Emit(ShaderOpEndIf, -1);
+		TEST_CHECK(p.Link());
+
+		std::vector<ShaderFlowAttribute> attributes;
+		std::vector<unsigned int> unrollCounts;
+		p.ChooseFlowAttributes(attributes, unrollCounts);
+		TEST_CHECK(attributes[Nth(p, ShaderOpIf, 0)] == ShaderFlowBranch);
+		TEST_CHECK(attributes[Nth(p, ShaderOpIf, 1)] == ShaderFlowFlatten);
+		TEST_CHECK(attributes[Nth(p, ShaderOpIf, 2)] == ShaderFlowBranch);
+		TEST_CHECK(attributes[Nth(p, ShaderOpIf, 3)] == ShaderFlowFlatten);
+		TEST_CHECK(attributes[Nth(p, ShaderOpIf, 4)] == ShaderFlowFlatten);
+		TEST_CHECK(attributes[Nth(p, ShaderOpIf, 5)] == ShaderFlowFlatten);
+		TEST_CHECK(attributes[Nth(p, ShaderOpCompare)] == ShaderFlowAuto);
+	}
+
+	// counter = 0; while(1) { if(!(counter < limit)) break; sample; counter += step; }, the
+	// test is after the step unless 'testFirst'.
+	void CountedLoop(ShaderProgram& p, int counter, int exit, int limit, int step, bool testFirst = true)
+	{
+		p.Emit(ShaderOpMov, counter, Zero);
+		p.Emit(ShaderOpWhile, -1);
+		if(!testFirst) p.Emit(ShaderOpAdd, counter, counter, step);
+		p.Emit(ShaderOpCompare, exit, counter, limit, -1, -1, ShaderCompareLess);
+		p.Emit(ShaderOpBreak, -1, exit);
+		Gradient(p);
+		if(testFirst) p.Emit(ShaderOpAdd, counter, counter, step);
+		p.Emit(ShaderOpEndWhile, -1);
+	}
+
+	void TestTripCount()
+	{
+		ShaderProgram p;
+		Begin(p);
+		CountedLoop(p, Counter, Exit, Four, One);
+		CountedLoop(p, Counter, Exit, Five, Two, false);
+		CountedLoop(p, Counter, Exit, Limit, One);
+
+		// Counter stepped under flow control is not counted.
+		p.Emit(ShaderOpMov, Counter, Zero);
+		p.Emit(ShaderOpWhile, -1);
+		p.Emit(ShaderOpCompare, Flag, Counter, Four, -1, -1, ShaderCompareLess);
+		p.Emit(ShaderOpBreak, -1, Flag);
+		p.Emit(ShaderOpIf, -1, Yes);
+		p.Emit(ShaderOpAdd, Counter, Counter, One);
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpEndWhile, -1);
+
+		// Second break makes trip unknown.
+		p.Emit(ShaderOpMov, Counter, Zero);
+		p.Emit(ShaderOpWhile, -1);
+		p.Emit(ShaderOpCompare, Flag, Counter, Four, -1, -1, ShaderCompareLess);
+		p.Emit(ShaderOpBreak, -1, Flag);
+		p.Emit(ShaderOpAdd, Counter, Counter, One);
+		p.Emit(ShaderOpBreak, -1, Yes);
+		p.Emit(ShaderOpEndWhile, -1);
+		TEST_CHECK(p.Link());
+
+		TEST_CHECK(p.TripCount(Nth(p, ShaderOpWhile, 0)) == 4);
+		TEST_CHECK(p.TripCount(Nth(p, ShaderOpWhile, 1)) == 3);
+		TEST_CHECK(p.TripCount(Nth(p, ShaderOpWhile, 2)) == 0);
+		TEST_CHECK(p.TripCount(Nth(p, ShaderOpWhile, 3)) == 0);
+		TEST_CHECK(p.TripCount(Nth(p, ShaderOpWhile, 4)) == 0);
+	}
+
+	// Gradients in a divergent loop unroll it when counted; uniform loops loop.
+	void TestLoopAttributes()
+	{
+		ShaderProgram p;
+		Begin(p);
+		CountedLoop(p, Index, Done, Four, One);
+		p.Emit(ShaderOpCompare, Flag, InputX, Half, -1, -1, ShaderCompareGreater);
+		p.Emit(ShaderOpIf, -1, Flag);
+		CountedLoop(p, Counter, Exit, Four, One);
+		p.Emit(ShaderOpMov, Value, InputX);
+		p.Emit(ShaderOpWhile, -1);
+		Gradient(p);
+		p.Emit(ShaderOpAdd, Value, Value, One);
+		p.Emit(ShaderOpCompare, Flag, Value, Four, -1, -1, ShaderCompareLess);
+		p.Emit(ShaderOpBreak, -1, Flag);
+		p.Emit(ShaderOpEndWhile, -1);
+		p.Emit(ShaderOpEndIf, -1);
+
+		// Author's unroll keeps its count.
+		p.Emit(ShaderOpWhile, -1, -1, -1, -1, -1, 3).hint = ShaderFlowUnroll;
+		p.Emit(ShaderOpBreak, -1, Zero);
+		p.Emit(ShaderOpEndWhile, -1);
+		TEST_CHECK(p.Link());
+
+		std::vector<ShaderFlowAttribute> attributes;
+		std::vector<unsigned int> unrollCounts;
+		p.ChooseFlowAttributes(attributes, unrollCounts);
+
+		int uniform = Nth(p, ShaderOpWhile, 0), counted = Nth(p, ShaderOpWhile, 1);
+		int unknown = Nth(p, ShaderOpWhile, 2), hinted = Nth(p, ShaderOpWhile, 3);
+		TEST_CHECK(attributes[uniform] == ShaderFlowLoop);
+		TEST_CHECK(attributes[counted] == ShaderFlowUnroll && unrollCounts[counted] == 4);
+		TEST_CHECK(attributes[unknown] == ShaderFlowAuto && unrollCounts[unknown] == 0);
+		TEST_CHECK(attributes[hinted] == ShaderFlowUnroll && unrollCounts[hinted] == 3);
+	}
+
+	void TestSwitchAttributes()
+	{
+		ShaderProgram p;
+		Begin(p);
+		p.Emit(ShaderOpSwitch, -1, One);
+		p.Emit(ShaderOpCase, -1, One);
+		Body(p, 1);
+		p.Emit(ShaderOpEndCase, -1);
+		p.Emit(ShaderOpEndSwitch, -1);
+		p.Emit(ShaderOpSwitch, -1, InputX);
+		p.Emit(ShaderOpCase, -1, One);
+		Body(p, 1);
+		p.Emit(ShaderOpEndCase, -1);
+		p.Emit(ShaderOpDefault, -1);
+		Body(p, ShaderBranchThreshold);
+		p.Emit(ShaderOpEndCase, -1);
+		p.Emit(ShaderOpEndSwitch, -1);
+		TEST_CHECK(p.Link());
+
+		std::vector<ShaderFlowAttribute> attributes;
+		std::vector<unsigned int> unrollCounts;
+		p.ChooseFlowAttributes(attributes, unrollCounts);
+		TEST_CHECK(attributes[Nth(p, ShaderOpSwitch, 0)] == ShaderFlowForceCase);
+		TEST_CHECK(attributes[Nth(p, ShaderOpSwitch, 1)] == ShaderFlowBranch);
+		TEST_CHECK(attributes[Nth(p, ShaderOpCase, 0)] == ShaderFlowAuto);
+	}
+
+	// Attributes land at offsets where the compiler opened blocks.
+	void TestInsertFlowAttributes()
+	{
+		ShaderProgram p;
+		Begin(p);
+		p.Emit(ShaderOpIf, -1, Yes);
+		p.Emit(ShaderOpEndIf, -1);
+		p.Emit(ShaderOpCompare, Flag, InputX, Half, -1, -1, ShaderCompareGreater);
+		p.Emit(ShaderOpIf, -1, Flag);
+		CountedLoop(p, Counter, Exit, Four, One);
+		p.Emit(ShaderOpEndIf, -1);
+		TEST_CHECK(p.Link());
+
+		std::string code = "if(_15) {}_4=_1>_14;if(_4) {_2=_8;while(1) {}}";
+		std::vector<size_t> offsets;
+		offsets.push_back(0);
+		offsets.push_back(code.find("if(_4)"));
+		offsets.push_back(code.find("while"));
+		std::vector<int> flow;
+		flow.push_back(Nth(p, ShaderOpIf, 0));
+		flow.push_back(Nth(p, ShaderOpIf, 1));
+		flow.push_back(Nth(p, ShaderOpWhile, 0));
+
+		TEST_CHECK(p.InsertFlowAttributes(code, offsets, flow) ==
+			"[branch]if(_15) {}_4=_1>_14;[flatten]if(_4) {_2=_8;[unroll(4)]while(1) {}}");
+	}
+
+	void AddOutput(ShaderProgram& p, unsigned long long component)
+	{
+		ShaderOutput o;
+		o.component = component;
+		o.type = Float4;
+		o.reg = -1;
+		p.outputs.push_back(o);
+	}
+
+	// Components of producer and consumer signatures.
+	enum
+	{
+		Position = 1,
+		Normal,
+		Colour,
+		TexCoord,
+		VertexID,
+		ArrayIndex
+	};
+
+	// Producer's outputs follow consumer's inputs; unread ones are dropped unless kept.
+	void TestLinkOutputs()
+	{
+		ShaderProgram producer, consumer;
+		AddOutput(producer, Position);
+		AddOutput(producer, Normal);
+		AddOutput(producer, Colour);
+		AddOutput(producer, TexCoord);
+		AddOutput(producer, ArrayIndex);
+		consumer.inputComponents.push_back(TexCoord);
+		consumer.inputComponents.push_back(VertexID);
+		consumer.inputComponents.push_back(Colour);
+
+		std::vector<unsigned long long> generated, kept;
+		generated.push_back(VertexID);
+		kept.push_back(Position);
+		kept.push_back(ArrayIndex);
+
+		std::vector<int> order;
+		unsigned long long missing = 0;
+		TEST_CHECK(producer.LinkOutputs(consumer, generated, kept, order, missing));
+		TEST_CHECK(order.size() == 4 && order[0] == 3 && order[1] == 2 && order[2] == 0 && order[3] == 4);
+
+		// Reading a value that is not written fails, generated ones are not looked for.
+		consumer.inputComponents.push_back(Normal + 100);
+		TEST_CHECK(!producer.LinkOutputs(consumer, generated, kept, order, missing));
+		TEST_CHECK(missing == Normal + 100);
+
+		consumer.inputComponents.clear();
+		consumer.inputComponents.push_back(VertexID);
+		TEST_CHECK(!producer.LinkOutputs(consumer, std::vector<unsigned long long>(), kept, order, missing));
+		TEST_CHECK(missing == VertexID);
+	}
+
+}
+
+int main()
+{
+	TestAnalyze();
+	TestAnalyzeLoop();
+	TestIfAttributes();
+	TestTripCount();
+	TestLoopAttributes();
+	TestSwitchAttributes();
+	TestInsertFlowAttributes();
+	TestLinkOutputs();
+	return SharpMedia::Test::Result("ShaderProgramTest");
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdio>
+#include <cmath>
+
+// Minimal checks of native tests. A failed check reports its location and marks the test
+// failed; the test goes on, so all failures are reported.
+
+namespace SharpMedia {
+namespace Test {
+
+	inline int& Failures()
+	{
+		static int failures = 0;
+		return failures;
+	}
+
+	inline void Fail(const char* file, int line, const char* expression)
+	{
+		printf("%s(%d): check failed: %s\n", file, line, expression);
+		Failures()++;
+	}
+
+	// Returns process exit code of test.
+	inline int Result(const char* name)
+	{
+		if(Failures()) printf("%s: %d checks failed\n", name, Failures());
+		else printf("%s: passed\n", name);
+		return Failures() ? 1 : 0;
+	}
+
+}
+}
+
+#define TEST_CHECK(expression) \
+	do { if(!(expression)) SharpMedia::Test::Fail(__FILE__, __LINE__, #expression); } while(0)
+
+#define TEST_NEAR(a, b, epsilon) \
+	do { if(!(std::fabs((double)(a) - (double)(b)) <= (epsilon))) SharpMedia::Test::Fail(__FILE__, __LINE__, #a " ~ " #b); } while(0)
@@ -0,0 +1,128 @@
+#define SHARPMEDIA_D3D10_TRACE
+#include "Test.h"
+#include "Trace.h"
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	unsigned int Occurrences(const std::string& text, const std::string& part)
+	{
+		unsigned int count = 0;
+		for(size_t i = text.find(part); i != std::string::npos; i = text.find(part, i + 1)) count++;
+		return count;
+	}
+
+	std::string Export()
+	{
+		std::ostringstream stream;
+		TraceWriteChrome(stream);
+		return stream.str();
+	}
+
+	void Traced(unsigned int count)
+	{
+		for(unsigned int i = 0; i < count; i++)
+		{
+			D3D10_TRACE_SCOPE("Traced");
+			D3D10_TRACE_COUNT("Traced calls");
+		}
+	}
+
+	// Spans are written per thread with thread names, counters with their calls; clear discards
+	// both.
+	void TestExport()
+	{
+		TraceClear();
+		Traced(3);
+		std::thread other(Traced, 2);
+		other.join();
+
+		std::string trace = Export();
+		TEST_CHECK(trace.find("{\"traceEvents\":[") == 0);
+		TEST_CHECK(Occurrences(trace, "\"name\":\"Traced\",\"ph\":\"X\"") == 5);
+		TEST_CHECK(Occurrences(trace, "\"name\":\"thread_name\"") >= 2);
+		TEST_CHECK(trace.find("\"name\":\"Traced calls\",\"ph\":\"C\"") != std::string::npos);
+		TEST_CHECK(trace.find("\"calls\":5") != std::string::npos);
+		TEST_CHECK(trace.find("\"Dropped\"") == std::string::npos);
+
+		TraceClear();
+		trace = Export();
+		TEST_CHECK(Occurrences(trace, "\"ph\":\"X\"") == 0);
+		TEST_CHECK(trace.find("\"calls\":0") != std::string::npos);
+	}
+
+	// Spans past capacity of a thread are counted as dropped, not written.
+	void TestDropped()
+	{
+		TraceClear();
+		Traced(40000);
+
+		std::string trace = Export();
+		TEST_CHECK(Occurrences(trace, "\"name\":\"Traced\",\"ph\":\"X\"") == 32768);
+		TEST_CHECK(trace.find("\"name\":\"Dropped\"") != std::string::npos);
+		TEST_CHECK(trace.find("\"events\":7232") != std::string::npos);
+		TEST_CHECK(trace.find("\"calls\":40000") != std::string::npos);
+		TraceClear();
+	}
+
+	// Stand-in for a stage bind of the driver, several device calls of a few microseconds together.
+	void Bind()
+	{
+		volatile unsigned int work = 0;
+		for(unsigned int i = 0; i < 10000; i++) work = work + i;
+	}
+
+	double TimeBinds(void (*bind)(), unsigned int count)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+		Clock::time_point start = Clock::now();
+		for(unsigned int i = 0; i < count; i++) bind();
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	void TracedBind()
+	{
+		D3D10_TRACE_SCOPE("Bind");
+		D3D10_TRACE_COUNT("Bind calls");
+		Bind();
+	}
+
+	// Binds with and without tracing, against a target of 2% overhead. Fastest frames are
+	// compared, as others were interrupted; trace is cleared after each frame, as a capture
+	// would.
+	void Benchmark()
+	{
+		const unsigned int Binds = 2000, Frames = 20;
+		const double Target = 2.0;
+
+		double plain = 1e30, traced = 1e30;
+		for(unsigned int f = 0; f < Frames; f++)
+		{
+			double time = TimeBinds(Bind, Binds);
+			if(time < plain) plain = time;
+			time = TimeBinds(TracedBind, Binds);
+			if(time < traced) traced = time;
+			TraceClear();
+		}
+
+		double overhead = (traced - plain) / plain * 100.0;
+		printf("%u binds per frame\n", Binds);
+		printf("  untraced: %.3f ms (%.2f us per bind)\n", plain, plain * 1000.0 / Binds);
+		printf("  traced:   %.3f ms\n", traced);
+		printf("  overhead: %.2f%%, target %.2f%%, %s\n", overhead, Target, overhead <= Target ? "met" : "missed");
+	}
+
+}
+
+int main()
+{
+	TestExport();
+	TestDropped();
+	Benchmark();
+	return SharpMedia::Test::Result("TraceTest");
+}
@@ -0,0 +1,106 @@
+#include "Test.h"
+#include "WindowEventQueue.h"
+#include "WindowDpi.h"
+
+using namespace SharpMedia::Graphics::Driver::Direct3D10;
+
+namespace {
+
+	// Resize drag posts hundreds of sizes, frame sees last; events keep order of first push.
+	void TestCoalescing()
+	{
+		WindowEventQueue queue;
+		WindowEvent ev;
+		TEST_CHECK(!queue.Pop(ev));
+
+		for(int i = 1; i <= 500; i++) queue.Push(WindowEventResize, i, i * 2);
+		queue.Push(WindowEventFocus, 1);
+		queue.Push(WindowEventResize, 7, 8);
+		queue.Push(WindowEventFocus, 0);
+		TEST_CHECK(queue.GetCount() == 2);
+
+		TEST_CHECK(queue.Pop(ev) && ev.type == WindowEventResize && ev.a == 7 && ev.b == 8);
+		queue.Push(WindowEventResize, 9, 9);
+		TEST_CHECK(queue.Pop(ev) && ev.type == WindowEventFocus && ev.a == 0);
+		TEST_CHECK(queue.Pop(ev) && ev.type == WindowEventResize && ev.a == 9);
+		TEST_CHECK(!queue.Pop(ev));
+		TEST_CHECK(queue.GetStats().coalesced == 501 && queue.GetStats().delivered == 3);
+	}
+
+	// Queue is full with one event of every type and wraps around.
+	void TestWrapAround()
+	{
+		WindowEventQueue queue;
+		WindowEvent ev;
+		unsigned int mismatches = 0;
+		for(int round = 0; round < 20; round++)
+		{
+			for(unsigned int t = 0; t < WindowEventTypes; t++) queue.Push((t + round) % WindowEventTypes, round);
+			for(unsigned int t = 0; t < WindowEventTypes; t++)
+			{
+				if(!queue.Pop(ev) || ev.type != (t + round) % WindowEventTypes || ev.a != round) mismatches++;
+			}
+		}
+		TEST_CHECK(mismatches == 0 && queue.GetCount() == 0);
+		queue.Push(WindowEventTypes, 1);
+		TEST_CHECK(queue.GetCount() == 0);
+	}
+
+	// Dragging window over monitors of 100%, 150% and back: each WM_DPICHANGED posts DPI and
+	// system resizes to suggested rectangle. Frame sees last DPI and last size, DPI first.
+	void TestDpiChange()
+	{
+		WindowEventQueue queue;
+		WindowEvent ev;
+
+		queue.Push(WindowEventMove, 100, 100);
+		queue.Push(WindowEventDpi, (int)DpiFromMessage(0x00900090));
+		queue.Push(WindowEventResize, 1200, 900);
+		queue.Push(WindowEventMove, 1900, 100);
+		queue.Push(WindowEventDpi, (int)DpiFromMessage(0x00600060));
+		queue.Push(WindowEventResize, 800, 600);
+		TEST_CHECK(queue.IsPending(WindowEventDpi) && queue.GetCount() == 3);
+
+		TEST_CHECK(queue.Pop(ev) && ev.type == WindowEventMove && ev.a == 1900);
+		TEST_CHECK(queue.Pop(ev) && ev.type == WindowEventDpi && ev.a == 96);
+		TEST_CHECK(queue.Pop(ev) && ev.type == WindowEventResize && ev.a == 800 && ev.b == 600);
+
+		// Message without DPI reads as default; high word is Y and is ignored.
+		TEST_CHECK(DpiFromMessage(0) == WindowDefaultDpi);
+		TEST_CHECK(DpiFromMessage(0x00C000F0) == 240);
+	}
+
+	// Per-monitor awareness is chosen whenever system has a way to ask for it; per thread
+	// before per process, V2 when valid.
+	void TestAwareness()
+	{
+		WindowDpiSupport support = { false, false, false };
+		TEST_CHECK(ChooseDpiAwareness(support) == WindowDpiUnaware);
+
+		support.processAwareness = true;
+		TEST_CHECK(ChooseDpiAwareness(support) == WindowDpiPerMonitor);
+
+		support.threadContext = true;
+		TEST_CHECK(ChooseDpiAwareness(support) == WindowDpiPerMonitorThread);
+
+		support.perMonitorV2 = true;
+		TEST_CHECK(ChooseDpiAwareness(support) == WindowDpiPerMonitorThreadV2);
+
+		support.processAwareness = false;
+		TEST_CHECK(ChooseDpiAwareness(support) == WindowDpiPerMonitorThreadV2);
+
+		// V2 without function to set it is not usable.
+		support.threadContext = false;
+		TEST_CHECK(ChooseDpiAwareness(support) == WindowDpiUnaware);
+	}
+
+}
+
+int main()
+{
+	TestCoalescing();
+	TestWrapAround();
+	TestDpiChange();
+	TestAwareness();
+	return SharpMedia::Test::Result("WindowEventQueueTest");
+}